@@ -38,11 +38,15 @@ typedef struct neu_adapter_app    neu_adapter_app_t;
 typedef int (*neu_adapter_update_metric_cb_t)(neu_adapter_t *adapter,
                                               const char *   metric_name,
                                               uint64_t n, const char *group);
+typedef neu_histogram_t *(*neu_adapter_metric_histogram_cb_t)(
+    neu_adapter_t *adapter, const char *metric_name);
 typedef int (*neu_adapter_register_metric_cb_t)(neu_adapter_t *   adapter,
                                                 const char *      name,
                                                 const char *      help,
                                                 neu_metric_type_e type,
                                                 uint64_t          init);
+typedef void (*neu_adapter_unregister_metric_cb_t)(neu_adapter_t *adapter,
+                                                   const char *   name);
 
 typedef struct {
     char    path[NEU_PATH_LEN];
@@ -57,8 +61,10 @@ typedef struct adapter_callbacks {
                     void *data);
     int (*responseto)(neu_adapter_t *adapter, neu_reqresp_head_t *head,
                       void *data, struct sockaddr_un dst);
-    neu_adapter_register_metric_cb_t register_metric;
-    neu_adapter_update_metric_cb_t   update_metric;
+    neu_adapter_register_metric_cb_t   register_metric;
+    neu_adapter_update_metric_cb_t     update_metric;
+    neu_adapter_metric_histogram_cb_t  metric_histogram;
+    neu_adapter_unregister_metric_cb_t unregister_metric;
 
     union {
         struct {
@@ -92,6 +98,10 @@ typedef struct adapter_callbacks {
                                       uint16_t n_bytes, bool more);
             void (*fdown_open_response)(neu_adapter_t *adapter, void *req,
                                         int error);
+            // commit the values of one group under a single cache lock,
+            // `updates` only needs to stay valid during the call
+            void (*update_batch)(neu_adapter_t *adapter, const char *group,
+                                 neu_tag_update_t *updates, int n_update);
         } driver;
     };
 } adapter_callbacks_t;
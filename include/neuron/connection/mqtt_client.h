@@ -28,6 +28,7 @@ extern "C" {
 #include <stdint.h>
 #include <stdlib.h>
 
+#include "utils/histogram.h"
 #include "utils/zlog.h"
 
 // number of messages cached
@@ -35,6 +36,16 @@ extern "C" {
 #define NEU_METRIC_CACHED_MSGS_NUM_TYPE NEU_METRIC_TYPE_GAUAGE
 #define NEU_METRIC_CACHED_MSGS_NUM_HELP "Number of messages cached"
 
+// number of messages published but not yet completed on one connection
+#define NEU_METRIC_MQTT_INFLIGHT_MSGS_NUM_TYPE NEU_METRIC_TYPE_GAUAGE
+#define NEU_METRIC_MQTT_INFLIGHT_MSGS_NUM_HELP \
+    "Number of in-flight messages on the connection"
+
+// smoothed publish completion latency of one connection
+#define NEU_METRIC_MQTT_ACK_LATENCY_TYPE NEU_METRIC_TYPE_GAUAGE
+#define NEU_METRIC_MQTT_ACK_LATENCY_HELP \
+    "Smoothed publish acknowledgement latency of the connection in ms"
+
 #define NEU_MQTT_CACHE_SYNC_INTERVAL_MIN 10
 #define NEU_MQTT_CACHE_SYNC_INTERVAL_MAX 12000
 #define NEU_MQTT_CACHE_SYNC_INTERVAL_DEFAULT 100
@@ -91,6 +102,16 @@ bool   neu_mqtt_client_is_open(neu_mqtt_client_t *client);
 bool   neu_mqtt_client_is_connected(neu_mqtt_client_t *client);
 size_t neu_mqtt_client_get_cached_msgs_num(neu_mqtt_client_t *client);
 
+// number of publishes waiting for completion
+size_t neu_mqtt_client_get_inflight_msgs_num(neu_mqtt_client_t *client);
+// smoothed time in milliseconds from publish to completion, for QoS1/2 this is
+// the time until the broker acknowledges the message
+uint64_t neu_mqtt_client_get_ack_latency(neu_mqtt_client_t *client);
+// also record every publish completion latency in milliseconds into `hist`,
+// which may be shared by several clients, NULL to stop recording
+void neu_mqtt_client_set_ack_histogram(neu_mqtt_client_t *client,
+                                       neu_histogram_t *  hist);
+
 int  neu_mqtt_client_set_addr(neu_mqtt_client_t *client, const char *host,
                               uint16_t port);
 int  neu_mqtt_client_set_id(neu_mqtt_client_t *client, const char *id);
@@ -124,9 +124,38 @@ typedef struct neu_conn_param {
 
 typedef struct neu_conn neu_conn_t;
 
+/**
+ * Link state of a tcp client connection.
+ *
+ * Connecting never blocks the caller for more than NEU_CONN_CONNECT_GRACE:
+ * the handshake is started by neu_conn_connect or neu_conn_send and completed
+ * by later calls. A failed attempt moves the link to NEU_CONN_LINK_BACKOFF,
+ * during which sends fail immediately until the next attempt is due. The
+ * delay doubles on every consecutive failure, from NEU_CONN_BACKOFF_MIN up to
+ * NEU_CONN_BACKOFF_MAX, and is randomized by up to half to keep nodes sharing
+ * a device apart. An established link that drops, on a send or receive error
+ * or through neu_conn_disconnect, also backs off. The delay only starts over
+ * once a link has stayed up for NEU_CONN_BACKOFF_RESET.
+ */
+typedef enum neu_conn_link {
+    NEU_CONN_LINK_DISCONNECTED,
+    NEU_CONN_LINK_CONNECTING,
+    NEU_CONN_LINK_CONNECTED,
+    NEU_CONN_LINK_BACKOFF,
+} neu_conn_link_e;
+
+#define NEU_CONN_BACKOFF_MIN 200      // millisecond
+#define NEU_CONN_BACKOFF_MAX 10000    // millisecond
+#define NEU_CONN_BACKOFF_RESET 10000  // millisecond, uptime to clear backoff
+#define NEU_CONN_CONNECT_TIMEOUT 3000 // millisecond, used if timeout is 0
+#define NEU_CONN_CONNECT_GRACE 10     // millisecond
+
 typedef struct neu_conn_state {
-    uint64_t send_bytes;
-    uint64_t recv_bytes;
+    uint64_t        send_bytes;
+    uint64_t        recv_bytes;
+    neu_conn_link_e link;
+    uint64_t        connect_failures;
+    uint16_t        bus_utilization; // percent, tty client only
 } neu_conn_state_t;
 
 /**
@@ -163,11 +192,22 @@ void neu_conn_destory(neu_conn_t *conn);
 /**
  * @brief Connect
  *
+ * For tcp clients this starts or advances a non-blocking connect and returns
+ * without waiting for the handshake, see neu_conn_link_e.
  *
  * @param[in] conn
  */
 void neu_conn_connect(neu_conn_t *conn);
 
+/**
+ * @brief Get the link state of the connection.
+ *
+ * @param[in] conn
+ * @return Link state, connection types other than tcp client only report
+ * NEU_CONN_LINK_CONNECTED or NEU_CONN_LINK_DISCONNECTED.
+ */
+neu_conn_link_e neu_conn_link(neu_conn_t *conn);
+
 /**
  * @brief Get connection fd
  *
@@ -300,6 +340,43 @@ int neu_conn_wait_msg(neu_conn_t *conn, void *context, uint16_t n_byte,
 int neu_conn_tcp_server_wait_msg(neu_conn_t *conn, int fd, void *context,
                                  uint16_t n_byte, neu_conn_process_msg fn);
 
+/**
+ * Serial bus arbitration.
+ *
+ * Tty client connections opened on the same device share one bus, so that
+ * several nodes can poll different slaves of one RS-485 line. Each
+ * transaction, a request and its response, is wrapped in
+ * neu_conn_bus_acquire and neu_conn_bus_release. Waiting transactions are
+ * granted by priority, then by earliest deadline, and never before the 3.5
+ * character inter-frame gap following the previous one. For other connection
+ * types both calls return immediately.
+ */
+typedef enum neu_conn_bus_prio {
+    NEU_CONN_BUS_PRIO_HIGH,
+    NEU_CONN_BUS_PRIO_NORMAL,
+} neu_conn_bus_prio_e;
+
+/**
+ * @brief Wait for the serial bus of the connection.
+ *
+ * Pending input is discarded once the bus is granted, so that a late
+ * response to another node is not taken for this transaction's.
+ *
+ * @param[in] conn
+ * @param[in] prio Priority of the transaction.
+ * @param[in] deadline neu_time_ms() timestamp to give up at, 0 for none.
+ * @return 0 once the bus is held, -1 if the deadline passed while waiting.
+ */
+int neu_conn_bus_acquire(neu_conn_t *conn, neu_conn_bus_prio_e prio,
+                         int64_t deadline);
+
+/**
+ * @brief Release the serial bus held by the connection.
+ *
+ * @param[in] conn
+ */
+void neu_conn_bus_release(neu_conn_t *conn);
+
 int is_ipv4(const char *ip);
 int is_ipv6(const char *ip);
 
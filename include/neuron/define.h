@@ -44,6 +44,8 @@
 #define NEU_PLUGIN_DESCRIPTION_LEN 512
 #define NEU_TEMPLATE_NAME_LEN 128
 #define NEU_DRIVER_TAG_CACHE_EXPIRE_TIME 60
+#define NEU_DRIVER_SNAPSHOT_INTERVAL 30
+#define NEU_DRIVER_REPORT_LAG_MS 20
 #define NEU_APP_SUBSCRIBE_MSG_SIZE 4
 #define NEU_TAG_FLOAG_PRECISION_MAX 17
 #define NEU_USER_PASSWORD_MIN_LEN 4
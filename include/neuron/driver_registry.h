@@ -0,0 +1,59 @@
+/**
+ * NEURON IIoT System for Industry 4.0
+ * Copyright (C) 2020-2022 EMQ Technologies Co., Ltd All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ **/
+
+
+#ifndef _NEU_DRIVER_REGISTRY_H_
+#define _NEU_DRIVER_REGISTRY_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "msg.h"
+
+/** Registry of the tag caches of all driver nodes.
+ *
+ * Lets the REST and app plugins read cached group values in their own thread
+ * instead of sending NEU_REQ_READ_GROUP through the manager and the driver
+ * loop. A read holds the registry shared, and a driver is removed from it
+ * exclusively before its groups are freed, so a read never sees a driver
+ * that is going away.
+ */
+
+// Fill `tags` with neu_resp_tag_value_meta_t for the read tags of
+// `cmd->group` that match the filters in `cmd`. Returns a neu_err_code_e.
+typedef int (*neu_driver_registry_read_fn)(void *                      ctx,
+                                           const neu_req_read_group_t *cmd,
+                                           UT_array *                  tags);
+
+int  neu_driver_registry_add(const char *node, void *ctx,
+                             neu_driver_registry_read_fn read);
+void neu_driver_registry_del(const char *node);
+int  neu_driver_registry_rename(const char *node, const char *new_name);
+
+// Read `cmd->group` of `cmd->driver` from its cache, sync reads are not
+// served here. On success `resp` has to be released by neu_resp_read_free.
+int neu_driver_registry_read(const neu_req_read_group_t *cmd,
+                             neu_resp_read_group_t *     resp);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
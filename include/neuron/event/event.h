@@ -62,6 +62,8 @@ typedef struct neu_event_timer_param {
     // Callback function that fires every time the timer fires
     neu_event_timer_callback cb;
     neu_event_timer_type_e   type;
+    // delay of the first trigger in milliseconds, one period if 0
+    int64_t delay;
 } neu_event_timer_param_t;
 
 /**
@@ -83,6 +85,19 @@ neu_event_timer_t *neu_event_add_timer(neu_events_t *          events,
  */
 int neu_event_del_timer(neu_events_t *events, neu_event_timer_t *timer);
 
+/**
+ * @brief Move the next trigger of a timer, later triggers keep the period.
+ *
+ * Only to be called from the callback of the timer itself.
+ *
+ * @param[in] events
+ * @param[in] timer
+ * @param[in] millisecond Delay from now, at least 1.
+ * @return 0 on success.
+ */
+int neu_event_delay_timer(neu_events_t *events, neu_event_timer_t *timer,
+                          int64_t millisecond);
+
 enum neu_event_io_type {
     NEU_EVENT_IO_READ   = 0x1,
     NEU_EVENT_IO_CLOSED = 0x2,
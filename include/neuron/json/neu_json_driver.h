@@ -60,9 +60,17 @@ typedef struct {
 
 int neu_json_encode_driver_directory_resp(void *json_object, void *param);
 
+// largest window of a windowed upload
+#define NEU_JSON_FUP_WINDOW_MAX 64
+
 typedef struct {
     char *driver;
     char *path;
+
+    // optional, windowed upload, 1 to NEU_JSON_FUP_WINDOW_MAX if present
+    int64_t window;
+    int64_t offset;
+    bool    binary;
 } neu_json_driver_fup_open_req_t;
 
 int neu_json_decode_driver_fup_open_req(
@@ -96,8 +104,9 @@ typedef struct {
 int neu_json_encode_driver_fdown_open_resp(void *json_object, void *param);
 
 typedef struct {
-    char *driver;
-    char *path;
+    char *  driver;
+    char *  path;
+    int64_t offset; // optional
 } neu_json_driver_fup_data_req_t;
 
 int neu_json_decode_driver_fup_data_req(
@@ -110,13 +119,16 @@ typedef struct {
     bool     more;
     uint8_t *data;
     uint16_t len;
+    uint32_t seq; // seq and offset are left out when seq is 0
+    int64_t  offset;
 } neu_json_driver_fup_data_resp_t;
 
 int neu_json_encode_driver_fup_data_resp(void *json_object, void *param);
 
 typedef struct {
-    char *driver;
-    char *src_path;
+    char *   driver;
+    char *   src_path;
+    uint32_t seq; // left out when 0
 } neu_json_driver_fdown_data_resp_t;
 
 int neu_json_encode_driver_fdown_data_resp(void *json_object, void *param);
@@ -127,6 +139,7 @@ typedef struct {
     bool     more;
     uint8_t *data;
     uint16_t len;
+    uint32_t seq; // optional
 } neu_json_driver_fdown_data_req_t;
 
 int neu_json_decode_driver_fdown_data_req(
@@ -54,6 +54,7 @@ typedef struct {
     int                  n_meta;
     neu_json_tag_meta_t *metas;
     neu_datatag_t        datatag;
+    int64_t              timestamp; // of the value in ms, 0 if not known
 } neu_json_read_resp_tag_t;
 
 typedef struct {
@@ -67,6 +68,12 @@ int neu_json_encode_read_resp2(void *json_object, void *param); // tags
 int neu_json_encode_read_resp_ecp(void *json_object, void *param);
 int neu_json_encode_read_paginate_resp(void *json_object, void *param);
 
+// Encode a single element of the `tags` / `items` array, or the `meta`
+// object, so that large replies can be written out one tag at a time.
+int neu_json_encode_read_resp_tag(void *json_object, void *param);
+int neu_json_encode_read_paginate_resp_tag(void *json_object, void *param);
+int neu_json_encode_read_meta_resp(void *json_object, void *param);
+
 typedef struct {
     int64_t              error;
     char *               name;
@@ -206,6 +213,42 @@ void neu_json_decode_test_read_tag_req_free(neu_json_test_read_tag_req_t *req);
 
 int neu_json_encode_test_read_tag_resp(void *json_object, void *param);
 
+typedef struct {
+    char *  node;
+    char *  group;
+    int64_t start;
+    int64_t end;
+    int64_t buckets;
+    int     n_tags;
+    char ** tags;
+} neu_json_read_history_req_t;
+
+int  neu_json_decode_read_history_req(char *                        buf,
+                                      neu_json_read_history_req_t **result);
+void neu_json_decode_read_history_req_free(neu_json_read_history_req_t *req);
+
+typedef struct {
+    int64_t timestamp;
+    double  value;
+    double  min;
+    double  max;
+} neu_json_history_point_t;
+
+typedef struct {
+    char *                    name;
+    int64_t                   error;
+    int                       n_point;
+    neu_json_history_point_t *points;
+} neu_json_history_tag_t;
+
+typedef struct {
+    bool                    downsampled;
+    int                     n_tag;
+    neu_json_history_tag_t *tags;
+} neu_json_read_history_resp_t;
+
+int neu_json_encode_read_history_resp(void *json_object, void *param);
+
 #ifdef __cplusplus
 }
 #endif
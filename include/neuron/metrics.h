@@ -30,6 +30,7 @@ extern "C" {
 
 #include "define.h"
 #include "type.h"
+#include "utils/histogram.h"
 #include "utils/rolling_counter.h"
 #include "utils/utextend.h"
 #include "utils/uthash.h"
@@ -41,6 +42,7 @@ typedef enum {
     NEU_METRIC_TYPE_GAUAGE,
     NEU_METRIC_TYPE_COUNTER_SET,
     NEU_METRIC_TYPE_ROLLING_COUNTER,
+    NEU_METRIC_TYPE_HISTOGRAM,
 
     NEU_METRIC_TYPE_FLAG_NO_RESET = 0x80,
 } neu_metric_type_e;
@@ -66,6 +68,27 @@ typedef enum {
     "Last request round trip time in milliseconds"
 #define NEU_METRIC_LAST_RTT_MS_MAX 9999
 
+// maintained by neuron core, fed by last round trip time updates
+// distribution of request round trip time in milliseconds
+#define NEU_METRIC_READ_RTT_MS "read_rtt_ms"
+#define NEU_METRIC_READ_RTT_MS_TYPE NEU_METRIC_TYPE_HISTOGRAM
+#define NEU_METRIC_READ_RTT_MS_HELP \
+    "Distribution of request round trip time in milliseconds"
+
+// maintained by neuron core
+// distribution of driver cache update time in microseconds
+#define NEU_METRIC_CACHE_UPDATE_US "cache_update_us"
+#define NEU_METRIC_CACHE_UPDATE_US_TYPE NEU_METRIC_TYPE_HISTOGRAM
+#define NEU_METRIC_CACHE_UPDATE_US_HELP \
+    "Distribution of tag cache update time in microseconds"
+
+// maintained by neuron core
+// distribution of group report build time in microseconds
+#define NEU_METRIC_REPORT_BUILD_US "report_build_us"
+#define NEU_METRIC_REPORT_BUILD_US_TYPE NEU_METRIC_TYPE_HISTOGRAM
+#define NEU_METRIC_REPORT_BUILD_US_HELP \
+    "Distribution of group report build time in microseconds"
+
 // number of bytes sent
 #define NEU_METRIC_SEND_BYTES "send_bytes"
 #define NEU_METRIC_SEND_BYTES_TYPE NEU_METRIC_TYPE_COUNTER_SET
@@ -116,6 +139,27 @@ typedef enum {
 #define NEU_METRIC_GROUP_LAST_TIMER_MS_HELP \
     "Time in milliseconds consumed on last group timer invocation"
 
+// maintained by neuron core
+// number of group reads that ended past the next read
+#define NEU_METRIC_GROUP_DEADLINE_MISSES "group_deadline_misses_total"
+#define NEU_METRIC_GROUP_DEADLINE_MISSES_TYPE NEU_METRIC_TYPE_COUNTER
+#define NEU_METRIC_GROUP_DEADLINE_MISSES_HELP \
+    "Total number of group reads that ended past their deadline"
+
+// maintained by neuron core
+// milliseconds group reads ran past their deadlines
+#define NEU_METRIC_GROUP_OVERRUN_MS "group_overrun_ms_total"
+#define NEU_METRIC_GROUP_OVERRUN_MS_TYPE NEU_METRIC_TYPE_COUNTER
+#define NEU_METRIC_GROUP_OVERRUN_MS_HELP \
+    "Total time in milliseconds group reads ran past their deadlines"
+
+// maintained by neuron core
+// number of group reads dropped after overruns
+#define NEU_METRIC_GROUP_SKIPPED_READS "group_skipped_reads_total"
+#define NEU_METRIC_GROUP_SKIPPED_READS_TYPE NEU_METRIC_TYPE_COUNTER
+#define NEU_METRIC_GROUP_SKIPPED_READS_HELP \
+    "Total number of group reads skipped after overruns"
+
 // maintained by neuron core
 // group last error code
 #define NEU_METRIC_GROUP_LAST_ERROR_CODE "group_last_error_code"
@@ -146,6 +190,44 @@ typedef enum {
 #define NEU_METRIC_RECV_MSGS_TOTAL_TYPE NEU_METRIC_TYPE_COUNTER
 #define NEU_METRIC_RECV_MSGS_TOTAL_HELP "Total number of messages received"
 
+// maintained by neuron core
+// distribution of trans data queueing time from driver to app in microseconds
+#define NEU_METRIC_QUEUE_WAIT_US "queue_wait_us"
+#define NEU_METRIC_QUEUE_WAIT_US_TYPE NEU_METRIC_TYPE_HISTOGRAM
+#define NEU_METRIC_QUEUE_WAIT_US_HELP \
+    "Distribution of driver to app queueing time in microseconds"
+
+// distribution of upload message encoding time in microseconds, sampled by
+// the app that encodes, apps reusing its payload add no sample
+#define NEU_METRIC_ENCODE_US "encode_us"
+#define NEU_METRIC_ENCODE_US_TYPE NEU_METRIC_TYPE_HISTOGRAM
+#define NEU_METRIC_ENCODE_US_HELP \
+    "Distribution of upload message encoding time in microseconds"
+
+// percent of time a shared serial bus is busy
+#define NEU_METRIC_BUS_UTILIZATION "bus_utilization"
+#define NEU_METRIC_BUS_UTILIZATION_TYPE NEU_METRIC_TYPE_GAUAGE
+#define NEU_METRIC_BUS_UTILIZATION_HELP \
+    "Percent of time the serial bus is busy, including inter-frame gaps"
+
+// distribution of read plan build time in microseconds
+#define NEU_METRIC_READ_PLAN_BUILD_US "read_plan_build_us"
+#define NEU_METRIC_READ_PLAN_BUILD_US_TYPE NEU_METRIC_TYPE_HISTOGRAM
+#define NEU_METRIC_READ_PLAN_BUILD_US_HELP \
+    "Distribution of read command plan build time in microseconds"
+
+// distribution of publish acknowledgement latency in milliseconds
+#define NEU_METRIC_PUBLISH_ACK_MS "publish_ack_ms"
+#define NEU_METRIC_PUBLISH_ACK_MS_TYPE NEU_METRIC_TYPE_HISTOGRAM
+#define NEU_METRIC_PUBLISH_ACK_MS_HELP \
+    "Distribution of publish acknowledgement latency in milliseconds"
+
+// distribution of file upload throughput in bytes per second
+#define NEU_METRIC_FUP_BYTES_PER_SEC "fup_bytes_per_second"
+#define NEU_METRIC_FUP_BYTES_PER_SEC_TYPE NEU_METRIC_TYPE_HISTOGRAM
+#define NEU_METRIC_FUP_BYTES_PER_SEC_HELP \
+    "Distribution of finished file upload throughput in bytes per second"
+
 // number of trans data message within the last 5 seconds
 #define NEU_METRIC_TRANS_DATA_5S "last_5s_trans_data_msgs"
 #define NEU_METRIC_TRANS_DATA_5S_TYPE NEU_METRIC_TYPE_ROLLING_COUNTER
@@ -251,6 +333,7 @@ typedef struct {
     uint64_t               init;  //
     uint64_t               value; //
     neu_rolling_counter_t *rcnt;  //
+    neu_histogram_t *      hist;  //
     UT_hash_handle         hh;    // ordered by name
 } neu_metric_entry_t;
 
@@ -320,6 +403,11 @@ static inline bool neu_metric_type_is_rolling_counter(neu_metric_type_e type)
     return NEU_METRIC_TYPE_ROLLING_COUNTER == (type & NEU_METRIC_TYPE_MASK);
 }
 
+static inline bool neu_metric_type_is_histogram(neu_metric_type_e type)
+{
+    return NEU_METRIC_TYPE_HISTOGRAM == (type & NEU_METRIC_TYPE_MASK);
+}
+
 static inline bool neu_metric_type_no_reset(neu_metric_type_e type)
 {
     return NEU_METRIC_TYPE_FLAG_NO_RESET & type;
@@ -329,6 +417,8 @@ static inline const char *neu_metric_type_str(neu_metric_type_e type)
 {
     if (neu_metric_type_is_counter(type)) {
         return "counter";
+    } else if (neu_metric_type_is_histogram(type)) {
+        return "summary";
     } else {
         return "gauge";
     }
@@ -342,6 +432,8 @@ static inline void neu_metric_entry_free(neu_metric_entry_t *entry)
 {
     if (neu_metric_type_is_rolling_counter(entry->type)) {
         neu_rolling_counter_free(entry->rcnt);
+    } else if (neu_metric_type_is_histogram(entry->type)) {
+        neu_histogram_free(entry->hist);
     }
     free(entry);
 }
@@ -447,9 +539,14 @@ static inline int neu_node_metrics_add(neu_node_metrics_t *node_metrics,
     return rv;
 }
 
-static inline int neu_node_metrics_update(neu_node_metrics_t *node_metrics,
-                                          const char *        group,
-                                          const char *metric_name, uint64_t n)
+/** Update a metric entry and return it, or NULL if there is no such entry.
+ *
+ * The entry is only meant for identity checks by the caller.
+ */
+static inline const neu_metric_entry_t *
+neu_node_metrics_update_entry(neu_node_metrics_t *node_metrics,
+                              const char *group, const char *metric_name,
+                              uint64_t n)
 {
     neu_metric_entry_t *entry = NULL;
 
@@ -466,7 +563,7 @@ static inline int neu_node_metrics_update(neu_node_metrics_t *node_metrics,
 
     if (NULL == entry) {
         pthread_mutex_unlock(&node_metrics->lock);
-        return -1;
+        return NULL;
     }
 
     if (neu_metric_type_is_counter(entry->type)) {
@@ -474,12 +571,70 @@ static inline int neu_node_metrics_update(neu_node_metrics_t *node_metrics,
     } else if (neu_metric_type_is_rolling_counter(entry->type)) {
         entry->value =
             neu_rolling_counter_inc(entry->rcnt, global_timestamp, n);
+    } else if (neu_metric_type_is_histogram(entry->type)) {
+        neu_histogram_record(entry->hist, n);
     } else {
         entry->value = n;
     }
     pthread_mutex_unlock(&node_metrics->lock);
 
-    return 0;
+    return entry;
+}
+
+static inline int neu_node_metrics_update(neu_node_metrics_t *node_metrics,
+                                          const char *        group,
+                                          const char *metric_name, uint64_t n)
+{
+    return NULL == neu_node_metrics_update_entry(node_metrics, group,
+                                                 metric_name, n)
+        ? -1
+        : 0;
+}
+
+/** Return a node level metric entry, or NULL.
+ *
+ * Resolved once so that updates can be told apart by entry address.
+ */
+static inline const neu_metric_entry_t *
+neu_node_metrics_entry(neu_node_metrics_t *node_metrics,
+                       const char *        metric_name)
+{
+    neu_metric_entry_t *entry = NULL;
+
+    if (NULL == node_metrics) {
+        return NULL;
+    }
+
+    pthread_mutex_lock(&node_metrics->lock);
+    HASH_FIND_STR(node_metrics->entries, metric_name, entry);
+    pthread_mutex_unlock(&node_metrics->lock);
+
+    return entry;
+}
+
+/** Return the histogram of a node level histogram entry, or NULL.
+ *
+ * Lets hot paths record without taking the node metrics lock. The histogram
+ * lives as long as the node metrics.
+ */
+static inline neu_histogram_t *
+neu_node_metrics_histogram(neu_node_metrics_t *node_metrics,
+                           const char *        metric_name)
+{
+    neu_metric_entry_t *entry = NULL;
+
+    if (NULL == node_metrics) {
+        return NULL;
+    }
+
+    pthread_mutex_lock(&node_metrics->lock);
+    HASH_FIND_STR(node_metrics->entries, metric_name, entry);
+    pthread_mutex_unlock(&node_metrics->lock);
+
+    if (NULL == entry || !neu_metric_type_is_histogram(entry->type)) {
+        return NULL;
+    }
+    return entry->hist;
 }
 
 static inline void neu_node_metrics_reset(neu_node_metrics_t *node_metrics)
@@ -493,6 +648,8 @@ static inline void neu_node_metrics_reset(neu_node_metrics_t *node_metrics)
             entry->value = entry->init;
             if (neu_metric_type_is_rolling_counter(entry->type)) {
                 neu_rolling_counter_reset(entry->rcnt);
+            } else if (neu_metric_type_is_histogram(entry->type)) {
+                neu_histogram_reset(entry->hist);
             }
         }
     }
@@ -506,6 +663,8 @@ static inline void neu_node_metrics_reset(neu_node_metrics_t *node_metrics)
                 entry->value = entry->init;
                 if (neu_metric_type_is_rolling_counter(entry->type)) {
                     neu_rolling_counter_reset(entry->rcnt);
+                } else if (neu_metric_type_is_histogram(entry->type)) {
+                    neu_histogram_reset(entry->hist);
                 }
             }
         }
@@ -551,6 +710,20 @@ static inline void neu_node_metrics_del_group(neu_node_metrics_t *node_metrics,
     pthread_mutex_unlock(&node_metrics->lock);
 }
 
+static inline void neu_node_metrics_del(neu_node_metrics_t *node_metrics,
+                                        const char *        name)
+{
+    neu_metric_entry_t *e = NULL;
+    pthread_mutex_lock(&node_metrics->lock);
+    HASH_FIND_STR(node_metrics->entries, name, e);
+    if (NULL != e) {
+        HASH_DEL(node_metrics->entries, e);
+        neu_metrics_unregister_entry(e->name);
+        neu_metric_entry_free(e);
+    }
+    pthread_mutex_unlock(&node_metrics->lock);
+}
+
 neu_metrics_t *neu_get_global_metrics();
 
 #ifdef __cplusplus
@@ -50,6 +50,8 @@ typedef enum neu_reqresp_type {
     NEU_RESP_READ_GROUP_PAGINATE,
     NEU_REQ_TEST_READ_TAG,
     NEU_RESP_TEST_READ_TAG,
+    NEU_REQ_READ_HISTORY,
+    NEU_RESP_READ_HISTORY,
     NEU_REQ_WRITE_TAG,
     NEU_REQ_WRITE_TAGS,
     NEU_REQ_WRITE_GTAGS,
@@ -154,6 +156,8 @@ static const char *neu_reqresp_type_string_t[] = {
     [NEU_RESP_READ_GROUP_PAGINATE] = "NEU_RESP_READ_GROUP_PAGINATE",
     [NEU_REQ_TEST_READ_TAG]        = "NEU_REQ_TEST_READ_TAG",
     [NEU_RESP_TEST_READ_TAG]       = "NEU_RESP_TEST_READ_TAG",
+    [NEU_REQ_READ_HISTORY]         = "NEU_REQ_READ_HISTORY",
+    [NEU_RESP_READ_HISTORY]        = "NEU_RESP_READ_HISTORY",
     [NEU_REQ_WRITE_TAG]            = "NEU_REQ_WRITE_TAG",
     [NEU_REQ_WRITE_TAGS]           = "NEU_REQ_WRITE_TAGS",
     [NEU_REQ_WRITE_GTAGS]          = "NEU_REQ_WRITE_GTAGS",
@@ -311,8 +315,10 @@ typedef struct neu_resp_fup_open {
 } neu_resp_fup_open_t;
 
 typedef struct neu_req_fup_data {
-    char driver[NEU_NODE_NAME_LEN];
-    char path[NEU_PATH_LEN];
+    char     driver[NEU_NODE_NAME_LEN];
+    char     path[NEU_PATH_LEN];
+    uint32_t seq;    // 0 for stop-and-wait, echoed in the response
+    int64_t  offset; // > 0 to seek before reading, 0 follows the last chunk
 } neu_req_fup_data_t;
 
 typedef struct neu_resp_fup_data {
@@ -320,6 +326,7 @@ typedef struct neu_resp_fup_data {
     bool     more;
     uint8_t *data;
     uint16_t len;
+    uint32_t seq;
 } neu_resp_fup_data_t;
 
 typedef struct neu_req_fdown_open {
@@ -334,15 +341,17 @@ typedef struct neu_resp_fdown_open {
 } neu_resp_fdown_open_t;
 
 typedef struct neu_req_fdown_data {
-    char driver[NEU_NODE_NAME_LEN];
-    char src_path[NEU_PATH_LEN];
+    char     driver[NEU_NODE_NAME_LEN];
+    char     src_path[NEU_PATH_LEN];
+    uint32_t seq; // of the chunk asked for, 0 for the next one
 } neu_req_fdown_data_t;
 
 typedef struct neu_resp_down_data {
     char driver[NEU_NODE_NAME_LEN];
     char src_path[NEU_PATH_LEN];
 
-    bool more;
+    bool     more;
+    uint32_t seq;
 
     uint8_t *data;
     uint32_t len;
@@ -489,6 +498,20 @@ typedef struct {
     neu_gdatatag_t *groups;
 } neu_req_add_gtag_t;
 
+static inline void neu_req_add_gtag_fini(neu_req_add_gtag_t *req)
+{
+    for (int i = 0; i < req->n_group; i++) {
+        for (int j = 0; j < req->groups[i].n_tag; j++) {
+            neu_tag_fini(&req->groups[i].tags[j]);
+        }
+        free(req->groups[i].tags);
+        free(req->groups[i].context);
+    }
+    free(req->groups);
+    req->groups  = NULL;
+    req->n_group = 0;
+}
+
 typedef struct {
     char     driver[NEU_NODE_NAME_LEN];
     char     group[NEU_GROUP_NAME_LEN];
@@ -795,6 +818,68 @@ neu_req_read_group_paginate_fini(neu_req_read_group_paginate_t *req)
     free(req->desc);
 }
 
+typedef struct neu_req_read_history {
+    char *   driver;
+    char *   group;
+    int64_t  start;   // ms, inclusive
+    int64_t  end;     // ms, inclusive
+    uint32_t buckets; // 0 for raw points
+    uint16_t n_tag;   // 0 for all tags of the group
+    char **  tags;
+} neu_req_read_history_t;
+
+static inline void neu_req_read_history_fini(neu_req_read_history_t *req)
+{
+    free(req->driver);
+    free(req->group);
+    if (req->n_tag > 0) {
+        for (uint16_t i = 0; i < req->n_tag; i++) {
+            free(req->tags[i]);
+        }
+        free(req->tags);
+    }
+}
+
+typedef struct {
+    int64_t  timestamp;
+    double   value; // average of the bucket when downsampled
+    double   min;
+    double   max;
+    uint32_t count;
+} neu_history_point_t;
+
+static inline UT_icd *neu_history_point_icd()
+{
+    static UT_icd icd = { sizeof(neu_history_point_t), NULL, NULL, NULL };
+    return &icd;
+}
+
+typedef struct {
+    char      tag[NEU_TAG_NAME_LEN];
+    int       error;
+    UT_array *points; // neu_history_point_t
+} neu_resp_history_tag_t;
+
+typedef struct {
+    char *                  driver;
+    char *                  group;
+    uint32_t                buckets;
+    uint32_t                n_tag;
+    neu_resp_history_tag_t *tags;
+} neu_resp_read_history_t;
+
+static inline void neu_resp_read_history_free(neu_resp_read_history_t *resp)
+{
+    for (uint32_t i = 0; i < resp->n_tag; i++) {
+        if (resp->tags[i].points != NULL) {
+            utarray_free(resp->tags[i].points);
+        }
+    }
+    free(resp->tags);
+    free(resp->driver);
+    free(resp->group);
+}
+
 typedef struct neu_req_write_tag {
     char *       driver;
     char *       group;
@@ -821,6 +906,7 @@ typedef struct neu_resp_tag_value_meta {
     neu_dvalue_t   value;
     neu_tag_meta_t metas[NEU_TAG_META_SIZE];
     neu_datatag_t  datatag;
+    int64_t        timestamp; // of the value, the device time if there is one
 } neu_resp_tag_value_meta_t;
 
 static inline UT_icd *neu_resp_tag_value_meta_icd()
@@ -932,15 +1018,27 @@ neu_resp_read_paginate_free(neu_resp_read_group_paginate_t *resp)
     utarray_free(resp->tags);
 }
 
+// one encoding of the trans data, shared by the apps using the same key
+typedef struct neu_trans_data_encoded {
+    char *                         key;
+    bool                           done; // rv and bytes are set
+    pthread_cond_t                 cond; // signaled once done
+    int                            rv;
+    char *                         bytes;
+    struct neu_trans_data_encoded *next;
+} neu_trans_data_encoded_t;
+
 typedef struct {
-    uint16_t        index;
-    pthread_mutex_t mtx;
+    uint16_t                  index;
+    pthread_mutex_t           mtx;
+    neu_trans_data_encoded_t *encoded;
 } neu_reqresp_trans_data_ctx_t;
 
 typedef struct {
-    char *driver;
-    char *group;
-    void *trace_ctx;
+    char *  driver;
+    char *  group;
+    void *  trace_ctx;
+    int64_t send_us; // neu_time_us() when sent to the app
 
     neu_reqresp_trans_data_ctx_t *ctx;
     UT_array *                    tags; // neu_resp_tag_value_meta_t
@@ -1003,6 +1101,15 @@ static inline void neu_trans_data_free(neu_reqresp_trans_data_t *data)
         utarray_free(data->tags);
         free(data->group);
         free(data->driver);
+        while (data->ctx->encoded != NULL) {
+            neu_trans_data_encoded_t *encoded = data->ctx->encoded;
+
+            data->ctx->encoded = encoded->next;
+            pthread_cond_destroy(&encoded->cond);
+            free(encoded->key);
+            free(encoded->bytes);
+            free(encoded);
+        }
         pthread_mutex_unlock(&data->ctx->mtx);
         pthread_mutex_destroy(&data->ctx->mtx);
         free(data->ctx);
@@ -1011,11 +1118,88 @@ static inline void neu_trans_data_free(neu_reqresp_trans_data_t *data)
     }
 }
 
+typedef int (*neu_trans_data_encode_fn)(neu_reqresp_trans_data_t *data,
+                                        void *arg, char **bytes);
+
+static inline neu_trans_data_encoded_t *
+neu_trans_data_encoded_find(neu_reqresp_trans_data_t *data, const char *key)
+{
+    neu_trans_data_encoded_t *encoded = data->ctx->encoded;
+
+    while (encoded != NULL && strcmp(encoded->key, key) != 0) {
+        encoded = encoded->next;
+    }
+    return encoded;
+}
+
+/**
+ * Encode trans data once for all the apps it is sent to.
+ *
+ * `key` names the format and every option the output depends on. The first
+ * caller with a key runs `encode`, later callers with the same key get its
+ * return value and bytes. `*bytes` belongs to `data` and stays valid until
+ * neu_trans_data_free.
+ *
+ * `encode` runs without the data lock held, so apps with other keys are
+ * never held up. Apps arriving on a key that is still being encoded wait for
+ * that encoding instead of repeating it.
+ */
+static inline int neu_trans_data_encode(neu_reqresp_trans_data_t *data,
+                                        const char *key,
+                                        neu_trans_data_encode_fn encode,
+                                        void *arg, const char **bytes)
+{
+    neu_trans_data_encoded_t *encoded = NULL;
+    char *                    out     = NULL;
+    int                       rv      = 0;
+
+    pthread_mutex_lock(&data->ctx->mtx);
+    encoded = neu_trans_data_encoded_find(data, key);
+    if (encoded != NULL) {
+        while (!encoded->done) {
+            pthread_cond_wait(&encoded->cond, &data->ctx->mtx);
+        }
+        pthread_mutex_unlock(&data->ctx->mtx);
+
+        *bytes = encoded->bytes;
+        return encoded->rv;
+    }
+
+    // placeholder, so that callers with the same key wait for this encoding
+    encoded =
+        (neu_trans_data_encoded_t *) calloc(1, sizeof(neu_trans_data_encoded_t));
+    if (encoded != NULL && (encoded->key = strdup(key)) == NULL) {
+        free(encoded);
+        encoded = NULL;
+    }
+    if (encoded == NULL) {
+        pthread_mutex_unlock(&data->ctx->mtx);
+        return NEU_ERR_EINTERNAL;
+    }
+    pthread_cond_init(&encoded->cond, NULL);
+    encoded->next      = data->ctx->encoded;
+    data->ctx->encoded = encoded;
+    pthread_mutex_unlock(&data->ctx->mtx);
+
+    rv = encode(data, arg, &out);
+
+    pthread_mutex_lock(&data->ctx->mtx);
+    encoded->rv    = rv;
+    encoded->bytes = out;
+    encoded->done  = true;
+    pthread_cond_broadcast(&encoded->cond);
+    pthread_mutex_unlock(&data->ctx->mtx);
+
+    *bytes = out;
+    return rv;
+}
+
 static inline void neu_tag_value_to_json(neu_resp_tag_value_meta_t *tag_value,
                                          neu_json_read_resp_tag_t * tag_json)
 {
-    tag_json->name  = tag_value->tag;
-    tag_json->error = 0;
+    tag_json->name      = tag_value->tag;
+    tag_json->error     = 0;
+    tag_json->timestamp = tag_value->timestamp;
 
     for (int k = 0; k < NEU_TAG_META_SIZE; k++) {
         if (strlen(tag_value->metas[k].name) > 0) {
@@ -1423,6 +1607,7 @@ typedef struct neu_req_update_log_level {
     char node[NEU_NODE_NAME_LEN];
     int  log_level;
     bool core;
+    int  capture; // start (1) or stop (0) protocol capture, -1 to keep as is
 } neu_req_update_log_level_t;
 
 void neu_msg_gen(neu_reqresp_head_t *header, void *data);
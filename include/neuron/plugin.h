@@ -44,6 +44,17 @@ extern "C" {
     plugin->common.adapter_callbacks->update_metric(plugin->common.adapter, \
                                                     name, val, grp)
 
+#define NEU_PLUGIN_UNREGISTER_METRIC(plugin, name)        \
+    plugin->common.adapter_callbacks->unregister_metric( \
+        plugin->common.adapter, name)
+
+// histogram of a registered histogram metric for lock free recording, or NULL
+#define NEU_PLUGIN_METRIC_HISTOGRAM(plugin, name)         \
+    plugin->common.adapter_callbacks->metric_histogram( \
+        plugin->common.adapter, name)
+
+// wall clock ms refreshed by the manager every 10 ms, good enough for
+// metrics and rate limits, values are stamped with neu_time_pair()
 extern int64_t global_timestamp;
 
 typedef struct neu_plugin_common {
@@ -57,20 +68,25 @@ typedef struct neu_plugin_common {
     char                  log_level[NEU_LOG_LEVEL_LEN];
 
     zlog_category_t *log;
+    bool             protocol_capture; // atomic, see utils/capture.h
 } neu_plugin_common_t;
 
 typedef struct neu_plugin neu_plugin_t;
 
 typedef struct neu_plugin_group neu_plugin_group_t;
 typedef void (*neu_plugin_group_free)(neu_plugin_group_t *pgp);
+// called with the new tags when the group changes, user_data is kept if it
+// returns 0, otherwise group_free is called as usual
+typedef int (*neu_plugin_group_change)(neu_plugin_group_t *pgp, UT_array *tags);
 struct neu_plugin_group {
     char *    group_name;
     UT_array *tags;
 
-    void *                context;
-    void *                user_data;
-    neu_plugin_group_free group_free;
-    uint32_t              interval;
+    void *                  context;
+    void *                  user_data;
+    neu_plugin_group_free   group_free;
+    uint32_t                interval;
+    neu_plugin_group_change group_change;
 };
 
 typedef int (*neu_plugin_tag_validator_t)(const neu_datatag_t *tag);
@@ -124,6 +140,11 @@ typedef struct neu_plugin_intf_funs {
                               int64_t size);
             int (*fdown_data)(neu_plugin_t *plugin, void *req, uint8_t *bytes,
                               uint16_t n_bytes, bool more);
+            // optional, like fup_data but reading from `offset` of the file,
+            // used to resume an upload. Without it the adapter reads with
+            // fup_data from the start of the file and drops up to `offset`
+            int (*fup_data_at)(neu_plugin_t *plugin, void *req,
+                               const char *path, int64_t offset);
         } driver;
     };
 
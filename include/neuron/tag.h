@@ -99,6 +99,17 @@ typedef struct neu_tag_meta {
     neu_dvalue_t value;
 } neu_tag_meta_t;
 
+/** One tag value of a batched driver update, see
+ * adapter_callbacks_t.driver.update_batch.
+ */
+typedef struct neu_tag_update {
+    const char *    tag;
+    neu_dvalue_t    value;
+    neu_tag_meta_t *metas;
+    int             n_meta;
+    int64_t         timestamp; // device time in ms, 0 for the batch time
+} neu_tag_update_t;
+
 UT_icd *neu_tag_get_icd();
 
 void neu_tag_format_str(const neu_datatag_t *tag, char *buf, int len);
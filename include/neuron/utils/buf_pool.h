@@ -0,0 +1,112 @@
+/**
+ * NEURON IIoT System for Industry 4.0
+ * Copyright (C) 2020-2022 EMQ Technologies Co., Ltd All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ **/
+#ifndef NEURON_UTILS_BUF_POOL_H
+#define NEURON_UTILS_BUF_POOL_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stdlib.h>
+
+/** Fixed size buffer pool.
+ *
+ * Hands out up to 32 preallocated buffers of the same size from one block,
+ * without locking. Requests that are larger than the buffer size or arrive
+ * while every buffer is in use fall back to the heap, so callers never see a
+ * failure and must always return buffers with neu_buf_pool_put.
+ */
+#define NEU_BUF_POOL_MAX 32
+
+typedef struct {
+    uint32_t free_mask; // bit i set: buffer i is available
+    uint16_t n_buf;
+    uint16_t buf_size;
+    uint8_t  base[];
+} neu_buf_pool_t;
+
+static inline neu_buf_pool_t *neu_buf_pool_new(uint16_t n_buf,
+                                               uint16_t buf_size)
+{
+    neu_buf_pool_t *pool = NULL;
+
+    if (n_buf > NEU_BUF_POOL_MAX) {
+        n_buf = NEU_BUF_POOL_MAX;
+    }
+
+    pool = (neu_buf_pool_t *) calloc(
+        1, sizeof(neu_buf_pool_t) + (size_t) n_buf * buf_size);
+    if (pool != NULL) {
+        pool->n_buf     = n_buf;
+        pool->buf_size  = buf_size;
+        pool->free_mask = n_buf == 32 ? UINT32_MAX : (1U << n_buf) - 1;
+    }
+
+    return pool;
+}
+
+static inline void neu_buf_pool_free(neu_buf_pool_t *pool)
+{
+    free(pool);
+}
+
+/** Get a buffer of at least `size` bytes, the content is not cleared.
+ */
+static inline uint8_t *neu_buf_pool_get(neu_buf_pool_t *pool, uint16_t size)
+{
+    uint32_t mask = 0;
+    unsigned i    = 0;
+
+    if (size > pool->buf_size) {
+        return (uint8_t *) malloc(size);
+    }
+
+    mask = __atomic_load_n(&pool->free_mask, __ATOMIC_RELAXED);
+    do {
+        if (mask == 0) {
+            return (uint8_t *) malloc(size);
+        }
+        i = __builtin_ctz(mask);
+    } while (!__atomic_compare_exchange_n(&pool->free_mask, &mask,
+                                          mask & ~(1U << i), true,
+                                          __ATOMIC_ACQUIRE, __ATOMIC_RELAXED));
+
+    return pool->base + (size_t) i * pool->buf_size;
+}
+
+static inline void neu_buf_pool_put(neu_buf_pool_t *pool, uint8_t *buf)
+{
+    size_t offset = 0;
+
+    if (buf < pool->base ||
+        buf >= pool->base + (size_t) pool->n_buf * pool->buf_size) {
+        free(buf);
+        return;
+    }
+
+    offset = (size_t)(buf - pool->base) / pool->buf_size;
+    __atomic_or_fetch(&pool->free_mask, 1U << offset, __ATOMIC_RELEASE);
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
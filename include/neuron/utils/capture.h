@@ -0,0 +1,65 @@
+/**
+ * NEURON IIoT System for Industry 4.0
+ * Copyright (C) 2020-2022 EMQ Technologies Co., Ltd All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ **/
+
+#ifndef _NEU_CAPTURE_H_
+#define _NEU_CAPTURE_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/** Binary protocol frame capture.
+ *
+ * Frames are copied with a timestamp and the node name into a ring owned by
+ * the calling thread, without taking any lock, and written out by a
+ * background thread to logs/<node>.pcapng every NEU_CAPTURE_FLUSH_MS. Frames
+ * are dropped, and counted, when a ring is full.
+ *
+ * Each file is a pcapng section with one LINKTYPE_USER0 interface. Every
+ * frame is an enhanced packet block with the node name as comment and the
+ * direction in epb_flags.
+ */
+
+#define NEU_CAPTURE_RING_SIZE (256 * 1024) // bytes, per producing thread
+#define NEU_CAPTURE_FLUSH_MS 200
+#define NEU_CAPTURE_DIR "./logs"
+
+typedef enum neu_capture_dir {
+    NEU_CAPTURE_SEND,
+    NEU_CAPTURE_RECV,
+} neu_capture_dir_e;
+
+void neu_capture_frame(const char *node, neu_capture_dir_e dir,
+                       const uint8_t *bytes, uint16_t n_byte);
+// close the capture file of `node` once its queued frames are written
+void neu_capture_close(const char *node);
+
+// write out everything captured so far, called by the background thread
+void neu_capture_flush(void);
+// number of frames dropped because a ring was full
+uint64_t neu_capture_dropped(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -338,6 +338,8 @@ typedef struct {
 
     cid_tm_da_type_t *datypes;
     int               n_datypes;
+
+    struct cid_tm_index *index; // types by id, built once all are parsed
 } cid_template_t;
 
 typedef struct {
@@ -361,6 +363,22 @@ void neu_cid_free(cid_t *cid);
 
 void neu_cid_to_msg(char *driver, cid_t *cid, neu_req_add_gtag_t *cmd);
 
+/** Streaming conversion of a CID file into tag groups.
+ *
+ * The file is read twice with a pull parser, never as a whole document: once
+ * for the DataTypeTemplates, then for the IED, one LDevice at a time. Only
+ * the templates and the groups of the current LDevice are held in memory.
+ */
+typedef struct neu_cid_reader neu_cid_reader_t;
+
+neu_cid_reader_t *neu_cid_reader_open(const char *path);
+// fill `cmd` with at most `max_tags` tags, a group that does not fit is split
+// and continued in the next call, returns the number of groups, 0 at the end
+// of the file or -1 on error
+int  neu_cid_reader_next(neu_cid_reader_t *reader, const char *driver,
+                         int max_tags, neu_req_add_gtag_t *cmd);
+void neu_cid_reader_close(neu_cid_reader_t *reader);
+
 char *              neu_cid_info_to_string(cid_dataset_info_t *info);
 cid_dataset_info_t *neu_cid_info_from_string(const char *str);
 
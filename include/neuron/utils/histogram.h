@@ -0,0 +1,164 @@
+/**
+ * NEURON IIoT System for Industry 4.0
+ * Copyright (C) 2020-2022 EMQ Technologies Co., Ltd All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ **/
+#ifndef NEURON_UTILS_HISTOGRAM_H
+#define NEURON_UTILS_HISTOGRAM_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+/** Log-linear histogram.
+ *
+ * HDR style bucketing: values below 2 * NEU_HISTOGRAM_SUB_COUNT are exact,
+ * every larger power of two range is split into NEU_HISTOGRAM_SUB_COUNT linear
+ * buckets, bounding the relative error to about 6%. Recording is lock free and
+ * may run concurrently with readers, which then see a slightly skewed but
+ * never torn snapshot.
+ */
+#define NEU_HISTOGRAM_SUB_BITS 4
+#define NEU_HISTOGRAM_SUB_COUNT (1 << NEU_HISTOGRAM_SUB_BITS)
+#define NEU_HISTOGRAM_MAX_BITS 40
+#define NEU_HISTOGRAM_BUCKETS                                \
+    (2 * NEU_HISTOGRAM_SUB_COUNT +                           \
+     (NEU_HISTOGRAM_MAX_BITS - NEU_HISTOGRAM_SUB_BITS - 1) * \
+         NEU_HISTOGRAM_SUB_COUNT)
+
+typedef struct {
+    uint64_t count;
+    uint64_t sum;
+    uint64_t max;
+    uint64_t buckets[NEU_HISTOGRAM_BUCKETS];
+} neu_histogram_t;
+
+static inline neu_histogram_t *neu_histogram_new()
+{
+    return (neu_histogram_t *) calloc(1, sizeof(neu_histogram_t));
+}
+
+static inline void neu_histogram_free(neu_histogram_t *hist)
+{
+    free(hist);
+}
+
+static inline unsigned neu_histogram_index(uint64_t v)
+{
+    if (v < 2 * NEU_HISTOGRAM_SUB_COUNT) {
+        return (unsigned) v;
+    }
+
+    unsigned e = 63 - __builtin_clzll(v);
+    if (e >= NEU_HISTOGRAM_MAX_BITS) {
+        return NEU_HISTOGRAM_BUCKETS - 1;
+    }
+
+    unsigned m =
+        (v >> (e - NEU_HISTOGRAM_SUB_BITS)) & (NEU_HISTOGRAM_SUB_COUNT - 1);
+    return 2 * NEU_HISTOGRAM_SUB_COUNT +
+        (e - NEU_HISTOGRAM_SUB_BITS - 1) * NEU_HISTOGRAM_SUB_COUNT + m;
+}
+
+/** Return the largest value falling into bucket `i`.
+ */
+static inline uint64_t neu_histogram_bucket_upper(unsigned i)
+{
+    if (i < 2 * NEU_HISTOGRAM_SUB_COUNT) {
+        return i;
+    }
+
+    unsigned k = i - 2 * NEU_HISTOGRAM_SUB_COUNT;
+    unsigned e = k / NEU_HISTOGRAM_SUB_COUNT + NEU_HISTOGRAM_SUB_BITS + 1;
+    uint64_t m = k % NEU_HISTOGRAM_SUB_COUNT + NEU_HISTOGRAM_SUB_COUNT;
+    uint64_t w = 1ULL << (e - NEU_HISTOGRAM_SUB_BITS);
+
+    return m * w + w - 1;
+}
+
+static inline void neu_histogram_record(neu_histogram_t *hist, uint64_t v)
+{
+    uint64_t max = __atomic_load_n(&hist->max, __ATOMIC_RELAXED);
+
+    __atomic_add_fetch(&hist->buckets[neu_histogram_index(v)], 1,
+                       __ATOMIC_RELAXED);
+    __atomic_add_fetch(&hist->sum, v, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&hist->count, 1, __ATOMIC_RELAXED);
+    while (v > max &&
+           !__atomic_compare_exchange_n(&hist->max, &max, v, true,
+                                        __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+    }
+}
+
+static inline void neu_histogram_reset(neu_histogram_t *hist)
+{
+    memset(hist, 0, sizeof(*hist));
+}
+
+static inline uint64_t neu_histogram_count(const neu_histogram_t *hist)
+{
+    return __atomic_load_n(&hist->count, __ATOMIC_RELAXED);
+}
+
+static inline uint64_t neu_histogram_sum(const neu_histogram_t *hist)
+{
+    return __atomic_load_n(&hist->sum, __ATOMIC_RELAXED);
+}
+
+/** Return the value at quantile `q` (0 ~ 1), or 0 if nothing was recorded.
+ *
+ * The result is the upper bound of the bucket holding the quantile, clamped
+ * to the maximum recorded value.
+ */
+static inline uint64_t neu_histogram_quantile(const neu_histogram_t *hist,
+                                              double                 q)
+{
+    uint64_t total = 0, seen = 0, rank = 0;
+    uint64_t max   = __atomic_load_n(&hist->max, __ATOMIC_RELAXED);
+
+    for (unsigned i = 0; i < NEU_HISTOGRAM_BUCKETS; ++i) {
+        total += __atomic_load_n(&hist->buckets[i], __ATOMIC_RELAXED);
+    }
+    if (0 == total) {
+        return 0;
+    }
+
+    rank = (uint64_t)(q * total);
+    if (rank >= total) {
+        rank = total - 1;
+    }
+
+    for (unsigned i = 0; i < NEU_HISTOGRAM_BUCKETS; ++i) {
+        seen += __atomic_load_n(&hist->buckets[i], __ATOMIC_RELAXED);
+        if (seen > rank) {
+            uint64_t upper = neu_histogram_bucket_upper(i);
+            return upper < max ? upper : max;
+        }
+    }
+
+    return max;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
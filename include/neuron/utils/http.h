@@ -20,6 +20,8 @@
 #ifndef _NEU_HTTP_H_
 #define _NEU_HTTP_H_
 
+#include <stdio.h>
+
 #include <nng/nng.h>
 
 #include "adapter.h"
@@ -85,6 +87,33 @@ int neu_http_response_file(nng_aio *aio, void *data, size_t len,
 
 int neu_http_post_otel_trace(uint8_t *data, int len);
 
+// Chunked transfer encoding response.
+//
+// The connection is taken over from the http server, a `200 OK` header with
+// `Transfer-Encoding: chunked` is written immediately, and body data is
+// buffered in fixed size chunks. Full chunks are queued and written one after
+// another from the aio callback. Only a small window of chunks is buffered,
+// writes wait for the peer to take one before queueing more, so a slow
+// client holds back the writer instead of growing the queue.
+//
+// Once any write fails or times out, the stream is broken, subsequent writes
+// return -1 without doing anything, and the connection is dropped once the
+// queue is released.
+typedef struct neu_http_stream neu_http_stream_t;
+
+// Returns NULL on failure, in which case `aio` is untouched and the caller
+// should reply as usual.
+neu_http_stream_t *neu_http_stream_open(nng_aio *aio, const char *content_type);
+int neu_http_stream_write(neu_http_stream_t *stream, const char *data,
+                          size_t len);
+int neu_http_stream_puts(neu_http_stream_t *stream, const char *str);
+// Wraps the stream in a stdio stream, which must be fclose()d before calling
+// `neu_http_stream_close`.
+FILE *neu_http_stream_fopen(neu_http_stream_t *stream);
+// Terminate the chunked body. The connection is closed and the stream
+// released after the last queued chunk has been written.
+void neu_http_stream_close(neu_http_stream_t *stream);
+
 #ifdef __cplusplus
 }
 #endif
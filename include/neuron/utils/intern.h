@@ -0,0 +1,82 @@
+/**
+ * NEURON IIoT System for Industry 4.0
+ * Copyright (C) 2020-2024 EMQ Technologies Co., Ltd All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ **/
+
+#ifndef _NEU_INTERN_H_
+#define _NEU_INTERN_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * Process wide table of interned names.
+ *
+ * An interned string is a shared, read only copy that lives as long as it
+ * is referenced. Equal strings interned at the same time are the same
+ * pointer, so tables keyed on names can hash and compare the pointers, and
+ * the hash of the characters is computed once.
+ *
+ * The table is sharded by hash, every shard with its own lock, and can be
+ * used from any thread.
+ */
+
+/**
+ * @brief Intern a string.
+ *
+ * @param[in] str the string.
+ * @return the interned string with one more reference, NULL if out of memory.
+ */
+const char *neu_intern(const char *str);
+
+/**
+ * @brief Find an interned string, without taking a reference.
+ *
+ * The result is only good for comparison with pointers that hold a
+ * reference, under the same lock that protects them.
+ *
+ * @param[in] str the string.
+ * @return the interned string, NULL if it is not interned.
+ */
+const char *neu_intern_find(const char *str);
+
+/**
+ * @brief Take one more reference of an interned string.
+ */
+const char *neu_intern_ref(const char *istr);
+
+/**
+ * @brief Drop one reference of an interned string, NULL is ignored.
+ */
+void neu_intern_release(const char *istr);
+
+// hash and length of an interned string, without touching the characters
+uint32_t neu_intern_hash(const char *istr);
+size_t   neu_intern_len(const char *istr);
+
+// number of distinct strings interned
+size_t neu_intern_count();
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -23,6 +23,7 @@ config_ **/
 #include <inttypes.h>
 #include <memory.h>
 
+#include "utils/capture.h"
 #include "utils/zlog.h"
 
 #include "define.h"
@@ -101,7 +102,11 @@ inline static void zlog_protocol(zlog_category_t *log, uint8_t *bytes,
     static __thread char buf[2048] = { 0 };
     int                  offset    = 0;
 
-    memset(buf, 0, sizeof(buf));
+    // formatting is far more expensive than the level check
+    if (!zlog_debug_enabled(log)) {
+        return;
+    }
+
     if (type == NEU_PROTOCOL_SEND) {
         offset = snprintf(buf, sizeof(buf) - 1, ">>(%d)", n_byte);
     } else {
@@ -131,11 +136,25 @@ inline static void zlog_protocol(zlog_category_t *log, uint8_t *bytes,
 #define zlog_recv_protocol(log, bytes, n_byte) \
     zlog_protocol(log, (uint8_t *) bytes, n_byte, NEU_PROTOCOL_RECV)
 
+#define plog_protocol(plugin, bytes, n_byte, type)                        \
+    do {                                                                  \
+        if (__atomic_load_n(&(plugin)->common.protocol_capture,           \
+                            __ATOMIC_RELAXED)) {                          \
+            neu_capture_frame((plugin)->common.name,                      \
+                              (type) == NEU_PROTOCOL_SEND                 \
+                                  ? NEU_CAPTURE_SEND                      \
+                                  : NEU_CAPTURE_RECV,                     \
+                              (const uint8_t *) (bytes), n_byte);         \
+        }                                                                 \
+        zlog_protocol((plugin)->common.log, (uint8_t *) (bytes), n_byte,  \
+                      type);                                              \
+    } while (0)
+
 #define plog_recv_protocol(plugin, bytes, n_byte) \
-    zlog_recv_protocol((plugin)->common.log, bytes, n_byte)
+    plog_protocol(plugin, bytes, n_byte, NEU_PROTOCOL_RECV)
 
 #define plog_send_protocol(plugin, bytes, n_byte) \
-    zlog_send_protocol((plugin)->common.log, bytes, n_byte)
+    plog_protocol(plugin, bytes, n_byte, NEU_PROTOCOL_SEND)
 
 void remove_logs(const char *node);
 
@@ -42,6 +42,33 @@ static inline int64_t neu_time_ns()
     return (int64_t) ts.tv_sec * 1000000000 + (int64_t) ts.tv_nsec;
 }
 
+// monotonic clock in microseconds, for measuring durations
+static inline int64_t neu_time_us()
+{
+    struct timespec ts = { 0 };
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t) ts.tv_sec * 1000000 + (int64_t) ts.tv_nsec / 1000;
+}
+
+/*
+ * Both clocks read back to back, the wall clock to stamp values and the
+ * monotonic one for durations and deadlines, which must not follow clock
+ * steps. One pair taken per read cycle or batch is shared by all its values.
+ */
+typedef struct {
+    int64_t real_ms;
+    int64_t mono_us;
+} neu_time_pair_t;
+
+static inline neu_time_pair_t neu_time_pair()
+{
+    neu_time_pair_t pair = { 0 };
+
+    pair.real_ms = neu_time_ms();
+    pair.mono_us = neu_time_us();
+    return pair;
+}
+
 static inline void neu_msleep(unsigned msec)
 {
     struct timespec tv = {
@@ -83,15 +83,22 @@ static void binary_to_hex(const unsigned char *binary, size_t length, char *hex)
     }
 }
 
+static int encode_trans_data(neu_reqresp_trans_data_t *trans_data, void *arg,
+                             char **bytes)
+{
+    json_read_resp_t resp = {
+        .plugin     = (neu_plugin_t *) arg,
+        .trans_data = trans_data,
+    };
+
+    return neu_json_encode_by_fn(&resp, json_encode_read_resp, bytes);
+}
+
 void send_data(neu_plugin_t *plugin, neu_reqresp_trans_data_t *trans_data)
 {
     int rv = 0;
 
-    char *           json_str = NULL;
-    json_read_resp_t resp     = {
-        .plugin     = plugin,
-        .trans_data = trans_data,
-    };
+    const char *json_str = NULL;
 
     neu_otel_trace_ctx trans_trace     = NULL;
     neu_otel_scope_ctx trans_scope     = NULL;
@@ -111,7 +118,9 @@ void send_data(neu_plugin_t *plugin, neu_reqresp_trans_data_t *trans_data)
 
     do {
 
-        rv = neu_json_encode_by_fn(&resp, json_encode_read_resp, &json_str);
+        // the same for every ekuiper app the data is sent to
+        rv = neu_trans_data_encode(trans_data, "ekuiper", encode_trans_data,
+                                   plugin, &json_str);
         if (0 != rv || json_str == NULL) {
             plog_error(plugin, "fail encode trans data to json");
             break;
@@ -127,7 +136,6 @@ void send_data(neu_plugin_t *plugin, neu_reqresp_trans_data_t *trans_data)
         rv = nng_msg_alloc(&msg, json_len + trace_header_len);
         if (0 != rv) {
             plog_error(plugin, "nng cannot allocate msg");
-            free(json_str);
             break;
         }
 
@@ -144,7 +152,6 @@ void send_data(neu_plugin_t *plugin, neu_reqresp_trans_data_t *trans_data)
         memcpy(nng_msg_body(msg) + trace_header_len, json_str,
                json_len); // no null byte
         plog_debug(plugin, ">> %s", json_str);
-        free(json_str);
         rv = nng_sendmsg(plugin->sock, msg,
                          NNG_FLAG_NONBLOCK); // TODO: use aio to send message
         if (0 == rv) {
@@ -0,0 +1,304 @@
+/**
+ * NEURON IIoT System for Industry 4.0
+ * Copyright (C) 2020-2022 EMQ Technologies Co., Ltd All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ **/
+#include <memory.h>
+
+#include <neuron.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <tmmintrin.h>
+#define MODBUS_DECODE_SSSE3
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#define MODBUS_DECODE_NEON
+#endif
+
+#include "modbus_decode.h"
+
+// largest pdu data plus room for a full vector load at its last byte
+#define MODBUS_DECODE_BLOCK (256 + 16)
+
+static bool plan_op(const modbus_point_t *point, uint16_t start_address,
+                    modbus_endianess endianess, modbus_decode_op_t *op)
+{
+    uint8_t     pattern[8] = { 0 };
+    neu_value_u value      = { 0 };
+    uint8_t     n          = point->n_register * 2;
+
+    switch (point->area) {
+    case MODBUS_AREA_HOLD_REGISTER:
+    case MODBUS_AREA_INPUT_REGISTER:
+        break;
+    default:
+        return false;
+    }
+
+    switch (point->type) {
+    case NEU_TYPE_UINT16:
+    case NEU_TYPE_INT16:
+    case NEU_TYPE_FLOAT:
+    case NEU_TYPE_INT32:
+    case NEU_TYPE_UINT32:
+    case NEU_TYPE_DOUBLE:
+    case NEU_TYPE_INT64:
+    case NEU_TYPE_UINT64:
+        break;
+    default:
+        return false;
+    }
+
+    if (n == 0 || n > sizeof(pattern) || point->start_address < start_address) {
+        return false;
+    }
+
+    // every conversion is a byte permutation, decoding the byte indexes
+    // tells where each byte of the result comes from
+    for (uint8_t i = 0; i < n; i++) {
+        pattern[i] = i + 1;
+    }
+    modbus_decode_point(point, point->start_address, endianess, pattern, n,
+                        &value);
+
+    memset(op->mask, MODBUS_DECODE_ZERO, sizeof(op->mask));
+    for (uint8_t i = 0; i < sizeof(pattern); i++) {
+        uint8_t b = value.bytes.bytes[i];
+
+        if (b > n) {
+            return false;
+        }
+        if (b > 0) {
+            op->mask[i] = b - 1;
+        }
+    }
+
+    op->offset  = (point->start_address - start_address) * 2;
+    op->n_byte  = n;
+    op->shuffle = true;
+    return true;
+}
+
+modbus_decode_plan_t *modbus_decode_plan_new(const modbus_read_cmd_t *cmd,
+                                             modbus_endianess endianess)
+{
+    modbus_decode_plan_t *plan = calloc(1, sizeof(modbus_decode_plan_t));
+
+    plan->n_op   = utarray_len(cmd->tags);
+    plan->ops    = calloc(plan->n_op + 1, sizeof(modbus_decode_op_t));
+    plan->values = calloc(plan->n_op + 1, sizeof(uint64_t));
+
+    utarray_foreach(cmd->tags, modbus_point_t **, p_tag)
+    {
+        modbus_decode_op_t *op = &plan->ops[utarray_eltidx(cmd->tags, p_tag)];
+
+        plan_op(*p_tag, cmd->start_address, endianess, op);
+    }
+
+    return plan;
+}
+
+void modbus_decode_plan_free(modbus_decode_plan_t *plan)
+{
+    if (plan != NULL) {
+        free(plan->ops);
+        free(plan->values);
+        free(plan);
+    }
+}
+
+void modbus_decode_block_scalar(modbus_decode_plan_t *plan,
+                                const uint8_t *bytes, uint16_t n_byte)
+{
+    for (uint16_t i = 0; i < plan->n_op; i++) {
+        const modbus_decode_op_t *op     = &plan->ops[i];
+        uint8_t                   out[8] = { 0 };
+
+        if (!op->shuffle) {
+            continue;
+        }
+
+        if (op->offset + op->n_byte <= n_byte) {
+            for (int j = 0; j < 8; j++) {
+                if (!(op->mask[j] & MODBUS_DECODE_ZERO)) {
+                    out[j] = bytes[op->offset + op->mask[j]];
+                }
+            }
+        }
+        memcpy(&plan->values[i], out, sizeof(out));
+    }
+}
+
+#ifdef MODBUS_DECODE_SSSE3
+__attribute__((target("ssse3"))) static void
+decode_block_ssse3(modbus_decode_plan_t *plan, const uint8_t *block,
+                   uint16_t n_byte)
+{
+    for (uint16_t i = 0; i < plan->n_op; i++) {
+        const modbus_decode_op_t *op = &plan->ops[i];
+
+        if (!op->shuffle) {
+            continue;
+        }
+
+        if (op->offset + op->n_byte > n_byte) {
+            plan->values[i] = 0;
+            continue;
+        }
+
+        __m128i src  = _mm_loadu_si128((const __m128i *) (block + op->offset));
+        __m128i mask = _mm_loadu_si128((const __m128i *) op->mask);
+        _mm_storel_epi64((__m128i *) &plan->values[i],
+                         _mm_shuffle_epi8(src, mask));
+    }
+}
+#endif
+
+#ifdef MODBUS_DECODE_NEON
+static void decode_block_neon(modbus_decode_plan_t *plan,
+                              const uint8_t *block, uint16_t n_byte)
+{
+    for (uint16_t i = 0; i < plan->n_op; i++) {
+        const modbus_decode_op_t *op = &plan->ops[i];
+
+        if (!op->shuffle) {
+            continue;
+        }
+
+        if (op->offset + op->n_byte > n_byte) {
+            plan->values[i] = 0;
+            continue;
+        }
+
+        // out of range indexes, like MODBUS_DECODE_ZERO, yield 0
+        uint8x16_t v =
+            vqtbl1q_u8(vld1q_u8(block + op->offset), vld1q_u8(op->mask));
+        vst1_u8((uint8_t *) &plan->values[i], vget_low_u8(v));
+    }
+}
+#endif
+
+void modbus_decode_block(modbus_decode_plan_t *plan, const uint8_t *bytes,
+                         uint16_t n_byte)
+{
+#if defined(MODBUS_DECODE_SSSE3) || defined(MODBUS_DECODE_NEON)
+    uint8_t block[MODBUS_DECODE_BLOCK];
+
+    if (n_byte > MODBUS_DECODE_BLOCK - 16) {
+        n_byte = MODBUS_DECODE_BLOCK - 16;
+    }
+    // vector loads may run up to 15 bytes past the response
+    memcpy(block, bytes, n_byte);
+    memset(block + n_byte, 0, 16);
+#endif
+
+#if defined(MODBUS_DECODE_SSSE3)
+    if (__builtin_cpu_supports("ssse3")) {
+        decode_block_ssse3(plan, block, n_byte);
+        return;
+    }
+#elif defined(MODBUS_DECODE_NEON)
+    decode_block_neon(plan, block, n_byte);
+    return;
+#endif
+
+    modbus_decode_block_scalar(plan, bytes, n_byte);
+}
+
+void modbus_decode_point(const modbus_point_t *point, uint16_t start_address,
+                         modbus_endianess endianess, const uint8_t *bytes,
+                         uint16_t n_byte, neu_value_u *value)
+{
+    switch (point->area) {
+    case MODBUS_AREA_HOLD_REGISTER:
+    case MODBUS_AREA_INPUT_REGISTER:
+        if (n_byte >= (point->start_address - start_address) * 2 +
+                point->n_register * 2) {
+            memcpy(value->bytes.bytes,
+                   bytes + (point->start_address - start_address) * 2,
+                   point->n_register * 2);
+            value->bytes.length = point->n_register * 2;
+        }
+        break;
+    case MODBUS_AREA_COIL:
+    case MODBUS_AREA_INPUT: {
+        uint16_t offset = point->start_address - start_address;
+        if (n_byte > offset / 8) {
+            neu_value8_u u8 = { .value = bytes[offset / 8] };
+
+            value->u8 = neu_value8_get_bit(u8, offset % 8);
+        }
+        break;
+    }
+    }
+
+    switch (point->type) {
+    case NEU_TYPE_UINT16:
+    case NEU_TYPE_INT16:
+        value->u16 = ntohs(value->u16);
+        break;
+    case NEU_TYPE_FLOAT:
+    case NEU_TYPE_INT32:
+    case NEU_TYPE_UINT32:
+        if (point->option.value32.is_default) {
+            modbus_convert_endianess(value, endianess);
+        }
+        value->u32 = ntohl(value->u32);
+        break;
+    case NEU_TYPE_DOUBLE:
+    case NEU_TYPE_INT64:
+    case NEU_TYPE_UINT64:
+        value->u64 = neu_ntohll(value->u64);
+        break;
+    case NEU_TYPE_BIT: {
+        switch (point->area) {
+        case MODBUS_AREA_HOLD_REGISTER:
+        case MODBUS_AREA_INPUT_REGISTER: {
+            neu_value16_u v16 = { 0 };
+            v16.value         = htons(*(uint16_t *) value->bytes.bytes);
+            memset(value, 0, sizeof(*value));
+            value->u8 = neu_value16_get_bit(v16, point->option.bit.bit);
+            break;
+        }
+        case MODBUS_AREA_COIL:
+        case MODBUS_AREA_INPUT:
+            break;
+        }
+        break;
+    }
+    case NEU_TYPE_STRING: {
+        switch (point->option.string.type) {
+        case NEU_DATATAG_STRING_TYPE_H:
+            break;
+        case NEU_DATATAG_STRING_TYPE_L:
+            neu_datatag_string_ltoh(value->str, strlen(value->str));
+            break;
+        case NEU_DATATAG_STRING_TYPE_D:
+            break;
+        case NEU_DATATAG_STRING_TYPE_E:
+            break;
+        }
+
+        if (!neu_datatag_string_is_utf8(value->str, strlen(value->str))) {
+            value->str[0] = '?';
+            value->str[1] = 0;
+        }
+        break;
+    }
+    default:
+        break;
+    }
+}
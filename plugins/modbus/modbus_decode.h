@@ -0,0 +1,81 @@
+/**
+ * NEURON IIoT System for Industry 4.0
+ * Copyright (C) 2020-2022 EMQ Technologies Co., Ltd All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ **/
+#ifndef _NEU_PLUGIN_MODBUS_DECODE_H_
+#define _NEU_PLUGIN_MODBUS_DECODE_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "modbus.h"
+#include "modbus_point.h"
+
+// lane of a shuffle mask that produces a zero byte
+#define MODBUS_DECODE_ZERO 0x80
+
+/** Decode step of one tag of a read command.
+ *
+ * Numeric register tags are decoded by gathering up to 8 bytes of the
+ * response starting at `offset` into a 64 bit value, byte i of the result
+ * taking source byte mask[i]. The mask folds the network byte order and the
+ * configured endianess into a single shuffle, lanes 8 ~ 15 are always zero so
+ * the mask can be used as is with 16 byte shuffle instructions.
+ */
+typedef struct modbus_decode_op {
+    uint8_t  mask[16];
+    uint16_t offset;
+    uint8_t  n_byte;
+    bool     shuffle; // false: the tag goes through modbus_decode_point
+} modbus_decode_op_t;
+
+typedef struct modbus_decode_plan {
+    uint16_t            n_op;
+    modbus_decode_op_t *ops;    // one per tag of the command, in tag order
+    uint64_t *          values; // filled by modbus_decode_block
+} modbus_decode_plan_t;
+
+modbus_decode_plan_t *modbus_decode_plan_new(const modbus_read_cmd_t *cmd,
+                                             modbus_endianess endianess);
+void                  modbus_decode_plan_free(modbus_decode_plan_t *plan);
+
+/** Run the shuffle steps of `plan` over the `n_byte` bytes of a response,
+ * using SSSE3 or NEON when available. Steps reaching past `n_byte` yield 0.
+ */
+void modbus_decode_block(modbus_decode_plan_t *plan, const uint8_t *bytes,
+                         uint16_t n_byte);
+// portable version of modbus_decode_block
+void modbus_decode_block_scalar(modbus_decode_plan_t *plan,
+                                const uint8_t *bytes, uint16_t n_byte);
+
+/** Decode a single tag of a response of the command starting at
+ * `start_address` into the zeroed `value`. This is the reference every
+ * shuffle step is derived from.
+ */
+void modbus_decode_point(const modbus_point_t *point, uint16_t start_address,
+                         modbus_endianess endianess, const uint8_t *bytes,
+                         uint16_t n_byte, neu_value_u *value);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
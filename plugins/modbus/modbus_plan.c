@@ -0,0 +1,484 @@
+/**
+ * NEURON IIoT System for Industry 4.0
+ * Copyright (C) 2020-2022 EMQ Technologies Co., Ltd All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ **/
+#include <memory.h>
+#include <stdlib.h>
+
+#include <neuron.h>
+
+#include "modbus_decode.h"
+#include "modbus_plan.h"
+
+struct plan_point {
+    modbus_point_t     point;
+    char *             address;
+    neu_attribute_e    attribute;
+    bool               seen;
+    struct plan_point *next; // removed points, freed once the update is done
+    UT_hash_handle     hh;
+};
+
+// addresses a change may affect, the end is inclusive so that a command
+// ending right before a changed point is rebuilt as well
+struct plan_range {
+    uint32_t start;
+    uint32_t end;
+};
+
+struct plan_bucket {
+    uint16_t key; // slave_id << 8 | area
+
+    struct plan_point **points; // sorted by point_cmp
+    uint32_t            n_point;
+    uint32_t            size;
+
+    modbus_read_cmd_t *cmds; // in address order
+    uint16_t           n_cmd;
+
+    struct plan_range *dirty;
+    uint32_t           n_dirty;
+    uint32_t           dirty_size;
+
+    UT_hash_handle hh;
+};
+
+struct modbus_plan {
+    uint16_t            max_byte;
+    modbus_endianess    endianess;
+    modbus_address_base address_base;
+
+    struct plan_point * points; // by name
+    struct plan_bucket *buckets;
+
+    modbus_read_cmd_sort_t cmd_sort;
+};
+
+static int point_cmp(const modbus_point_t *p1, const modbus_point_t *p2)
+{
+    if (p1->start_address != p2->start_address) {
+        return p1->start_address < p2->start_address ? -1 : 1;
+    }
+
+    if (p1->n_register != p2->n_register) {
+        return p1->n_register < p2->n_register ? -1 : 1;
+    }
+
+    return strcmp(p1->name, p2->name);
+}
+
+static uint32_t bucket_lower_bound(struct plan_bucket *  b,
+                                   const modbus_point_t *point)
+{
+    uint32_t low = 0, high = b->n_point;
+
+    while (low < high) {
+        uint32_t mid = low + (high - low) / 2;
+
+        if (point_cmp(&b->points[mid]->point, point) < 0) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+
+    return low;
+}
+
+static struct plan_bucket *bucket_get(modbus_plan_t *       plan,
+                                      const modbus_point_t *point, bool create)
+{
+    struct plan_bucket *b   = NULL;
+    uint16_t            key = point->slave_id << 8 | point->area;
+
+    HASH_FIND(hh, plan->buckets, &key, sizeof(key), b);
+    if (b == NULL && create) {
+        b      = calloc(1, sizeof(struct plan_bucket));
+        b->key = key;
+        HASH_ADD(hh, plan->buckets, key, sizeof(b->key), b);
+    }
+
+    return b;
+}
+
+static void bucket_mark(struct plan_bucket *b, const modbus_point_t *point)
+{
+    if (b->n_dirty == b->dirty_size) {
+        b->dirty_size = b->dirty_size == 0 ? 8 : b->dirty_size * 2;
+        b->dirty = realloc(b->dirty, b->dirty_size * sizeof(struct plan_range));
+    }
+
+    b->dirty[b->n_dirty].start = point->start_address;
+    b->dirty[b->n_dirty].end   = point->start_address + point->n_register;
+    b->n_dirty += 1;
+}
+
+static void point_insert(modbus_plan_t *plan, struct plan_point *pp)
+{
+    struct plan_bucket *b   = bucket_get(plan, &pp->point, true);
+    uint32_t            pos = bucket_lower_bound(b, &pp->point);
+
+    if (b->n_point == b->size) {
+        b->size   = b->size == 0 ? 16 : b->size * 2;
+        b->points = realloc(b->points, b->size * sizeof(struct plan_point *));
+    }
+
+    memmove(&b->points[pos + 1], &b->points[pos],
+            (b->n_point - pos) * sizeof(struct plan_point *));
+    b->points[pos] = pp;
+    b->n_point += 1;
+
+    bucket_mark(b, &pp->point);
+}
+
+static void point_remove(modbus_plan_t *plan, struct plan_point *pp)
+{
+    struct plan_bucket *b   = bucket_get(plan, &pp->point, false);
+    uint32_t            pos = bucket_lower_bound(b, &pp->point);
+
+    assert(pos < b->n_point && b->points[pos] == pp);
+    memmove(&b->points[pos], &b->points[pos + 1],
+            (b->n_point - pos - 1) * sizeof(struct plan_point *));
+    b->n_point -= 1;
+
+    bucket_mark(b, &pp->point);
+    HASH_DEL(plan->points, pp);
+}
+
+static void cmd_free(modbus_read_cmd_t *cmd)
+{
+    if (cmd->tags != NULL) {
+        utarray_free(cmd->tags);
+        modbus_decode_plan_free(cmd->plan);
+    }
+}
+
+static bool cmd_accept(modbus_plan_t *plan, modbus_read_cmd_t *cmd,
+                       uint32_t end, const modbus_point_t *point)
+{
+    if (point->start_address > end) {
+        return false;
+    }
+
+    switch (cmd->area) {
+    case MODBUS_AREA_COIL:
+    case MODBUS_AREA_INPUT:
+        return (end - cmd->start_address + 7) / 8 < plan->max_byte;
+    case MODBUS_AREA_INPUT_REGISTER:
+    case MODBUS_AREA_HOLD_REGISTER:
+        return (end - cmd->start_address) * 2 + point->n_register * 2 <
+            plan->max_byte;
+    }
+
+    return false;
+}
+
+// whether `cmd` holds exactly the points from `points` on
+static bool cmd_match(modbus_read_cmd_t *cmd, struct plan_point **points,
+                      uint32_t n_point)
+{
+    uint32_t len = utarray_len(cmd->tags);
+
+    if (len > n_point) {
+        return false;
+    }
+
+    for (uint32_t i = 0; i < len; i++) {
+        if (*(modbus_point_t **) utarray_eltptr(cmd->tags, i) !=
+            &points[i]->point) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static int range_cmp(const void *a, const void *b)
+{
+    const struct plan_range *r1 = (const struct plan_range *) a;
+    const struct plan_range *r2 = (const struct plan_range *) b;
+
+    if (r1->start != r2->start) {
+        return r1->start < r2->start ? -1 : 1;
+    }
+    return 0;
+}
+
+static void bucket_merge_dirty(struct plan_bucket *b)
+{
+    uint32_t n = 0;
+
+    qsort(b->dirty, b->n_dirty, sizeof(struct plan_range), range_cmp);
+    for (uint32_t i = 0; i < b->n_dirty; i++) {
+        if (n > 0 && b->dirty[i].start <= b->dirty[n - 1].end) {
+            if (b->dirty[i].end > b->dirty[n - 1].end) {
+                b->dirty[n - 1].end = b->dirty[i].end;
+            }
+        } else {
+            b->dirty[n++] = b->dirty[i];
+        }
+    }
+    b->n_dirty = n;
+}
+
+static void bucket_replan(modbus_plan_t *plan, struct plan_bucket *b)
+{
+    modbus_read_cmd_t *cmds  = NULL;
+    uint32_t           n_cmd = 0;
+    uint32_t           size  = 0;
+    uint32_t           oc    = 0;
+    uint32_t           r     = 0;
+    uint32_t           i     = 0;
+
+    bucket_merge_dirty(b);
+
+    while (i < b->n_point) {
+        modbus_point_t *   first = &b->points[i]->point;
+        modbus_read_cmd_t *reuse = NULL;
+
+        if (n_cmd == size) {
+            size = size == 0 ? 8 : size * 2;
+            cmds = realloc(cmds, size * sizeof(modbus_read_cmd_t));
+        }
+
+        // a command starting at the same point and clear of every change
+        // is exactly what would be built again
+        while (oc < b->n_cmd &&
+               b->cmds[oc].start_address < first->start_address) {
+            oc++;
+        }
+        for (uint32_t k = oc; k < b->n_cmd &&
+             b->cmds[k].start_address == first->start_address;
+             k++) {
+            modbus_read_cmd_t *old = &b->cmds[k];
+            uint32_t           end = old->start_address + old->n_register;
+
+            while (r < b->n_dirty && b->dirty[r].end < old->start_address) {
+                r++;
+            }
+            if (old->tags != NULL &&
+                (r == b->n_dirty || b->dirty[r].start > end) &&
+                cmd_match(old, &b->points[i], b->n_point - i)) {
+                reuse = old;
+                break;
+            }
+        }
+
+        if (reuse != NULL) {
+            cmds[n_cmd++] = *reuse;
+            i += utarray_len(reuse->tags);
+            reuse->tags = NULL;
+            continue;
+        }
+
+        modbus_read_cmd_t *cmd = &cmds[n_cmd++];
+        uint32_t           end = first->start_address + first->n_register;
+
+        memset(cmd, 0, sizeof(*cmd));
+        cmd->slave_id      = first->slave_id;
+        cmd->area          = first->area;
+        cmd->start_address = first->start_address;
+        utarray_new(cmd->tags, &ut_ptr_icd);
+        utarray_push_back(cmd->tags, &first);
+
+        for (i += 1; i < b->n_point; i++) {
+            modbus_point_t *p = &b->points[i]->point;
+
+            if (!cmd_accept(plan, cmd, end, p)) {
+                break;
+            }
+
+            utarray_push_back(cmd->tags, &p);
+            if (p->start_address + p->n_register > end) {
+                end = p->start_address + p->n_register;
+            }
+        }
+
+        cmd->n_register = end - cmd->start_address;
+        cmd->plan       = modbus_decode_plan_new(cmd, plan->endianess);
+    }
+
+    for (uint16_t k = 0; k < b->n_cmd; k++) {
+        cmd_free(&b->cmds[k]);
+    }
+    free(b->cmds);
+
+    b->cmds    = cmds;
+    b->n_cmd   = n_cmd;
+    b->n_dirty = 0;
+}
+
+static int bucket_cmp(struct plan_bucket *b1, struct plan_bucket *b2)
+{
+    return (int) b1->key - (int) b2->key;
+}
+
+static void plan_collect(modbus_plan_t *plan)
+{
+    struct plan_bucket *b     = NULL;
+    struct plan_bucket *tmp   = NULL;
+    uint32_t            n_cmd = 0;
+
+    HASH_SRT(hh, plan->buckets, bucket_cmp);
+    HASH_ITER(hh, plan->buckets, b, tmp)
+    {
+        n_cmd += b->n_cmd;
+    }
+
+    plan->cmd_sort.cmd =
+        realloc(plan->cmd_sort.cmd, (n_cmd + 1) * sizeof(modbus_read_cmd_t));
+    plan->cmd_sort.n_cmd = 0;
+    HASH_ITER(hh, plan->buckets, b, tmp)
+    {
+        memcpy(&plan->cmd_sort.cmd[plan->cmd_sort.n_cmd], b->cmds,
+               b->n_cmd * sizeof(modbus_read_cmd_t));
+        plan->cmd_sort.n_cmd += b->n_cmd;
+    }
+}
+
+modbus_plan_t *modbus_plan_new(uint16_t max_byte, modbus_endianess endianess,
+                               modbus_address_base address_base)
+{
+    modbus_plan_t *plan = calloc(1, sizeof(modbus_plan_t));
+
+    plan->max_byte     = max_byte;
+    plan->endianess    = endianess;
+    plan->address_base = address_base;
+
+    return plan;
+}
+
+void modbus_plan_free(modbus_plan_t *plan)
+{
+    struct plan_bucket *b   = NULL, *btmp = NULL;
+    struct plan_point * pp  = NULL, *ptmp = NULL;
+
+    HASH_ITER(hh, plan->buckets, b, btmp)
+    {
+        HASH_DEL(plan->buckets, b);
+        for (uint16_t i = 0; i < b->n_cmd; i++) {
+            cmd_free(&b->cmds[i]);
+        }
+        free(b->cmds);
+        free(b->points);
+        free(b->dirty);
+        free(b);
+    }
+
+    HASH_ITER(hh, plan->points, pp, ptmp)
+    {
+        HASH_DEL(plan->points, pp);
+        free(pp->address);
+        free(pp);
+    }
+
+    free(plan->cmd_sort.cmd);
+    free(plan);
+}
+
+int modbus_plan_update(modbus_plan_t *plan, UT_array *tags)
+{
+    struct plan_point * pp      = NULL, *tmp = NULL;
+    struct plan_point * removed = NULL;
+    struct plan_bucket *b       = NULL, *btmp = NULL;
+    bool                changed = false;
+    int                 invalid = 0;
+
+    HASH_ITER(hh, plan->points, pp, tmp)
+    {
+        pp->seen = false;
+    }
+
+    utarray_foreach(tags, neu_datatag_t *, tag)
+    {
+        modbus_point_t point = { 0 };
+
+        HASH_FIND_STR(plan->points, tag->name, pp);
+        if (pp != NULL && pp->point.type == tag->type &&
+            pp->attribute == tag->attribute &&
+            strcmp(pp->address, tag->address) == 0) {
+            pp->seen = true;
+            continue;
+        }
+
+        if (pp != NULL) {
+            point_remove(plan, pp);
+            pp->next = removed;
+            removed  = pp;
+            changed  = true;
+        }
+
+        if (modbus_tag_to_point(tag, &point, plan->address_base) !=
+            NEU_ERR_SUCCESS) {
+            invalid += 1;
+            continue;
+        }
+
+        pp          = calloc(1, sizeof(struct plan_point));
+        pp->point   = point;
+        pp->address   = strdup(tag->address);
+        pp->attribute = tag->attribute;
+        pp->seen      = true;
+        HASH_ADD_KEYPTR(hh, plan->points, pp->point.name,
+                        strlen(pp->point.name), pp);
+        point_insert(plan, pp);
+        changed = true;
+    }
+
+    HASH_ITER(hh, plan->points, pp, tmp)
+    {
+        if (!pp->seen) {
+            point_remove(plan, pp);
+            pp->next = removed;
+            removed  = pp;
+            changed  = true;
+        }
+    }
+
+    HASH_ITER(hh, plan->buckets, b, btmp)
+    {
+        if (b->n_dirty > 0) {
+            bucket_replan(plan, b);
+        }
+        if (b->n_point == 0) {
+            HASH_DEL(plan->buckets, b);
+            free(b->cmds);
+            free(b->points);
+            free(b->dirty);
+            free(b);
+        }
+    }
+
+    if (changed || plan->cmd_sort.cmd == NULL) {
+        plan_collect(plan);
+    }
+
+    // old commands may point at removed points until they are replanned
+    while (removed != NULL) {
+        pp      = removed;
+        removed = pp->next;
+        free(pp->address);
+        free(pp);
+    }
+
+    return invalid;
+}
+
+modbus_read_cmd_sort_t *modbus_plan_cmds(modbus_plan_t *plan)
+{
+    return &plan->cmd_sort;
+}
@@ -0,0 +1,60 @@
+/**
+ * NEURON IIoT System for Industry 4.0
+ * Copyright (C) 2020-2022 EMQ Technologies Co., Ltd All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ **/
+#ifndef _NEU_PLUGIN_MODBUS_PLAN_H_
+#define _NEU_PLUGIN_MODBUS_PLAN_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+
+#include <neuron.h>
+
+#include "modbus.h"
+#include "modbus_point.h"
+
+/** Read commands of a group, maintained incrementally.
+ *
+ * Points are kept sorted per (slave, area). A command takes points in address
+ * order for as long as the next one starts within the command and the
+ * response stays below max_byte. When tags change, only commands touching the
+ * changed address ranges are rebuilt, the rest are kept together with their
+ * decode plans.
+ */
+typedef struct modbus_plan modbus_plan_t;
+
+modbus_plan_t *modbus_plan_new(uint16_t max_byte, modbus_endianess endianess,
+                               modbus_address_base address_base);
+void           modbus_plan_free(modbus_plan_t *plan);
+
+/** Sync the plan with `tags` (neu_datatag_t), matched by name.
+ *
+ * Return the number of tags left out because of an invalid address.
+ */
+int modbus_plan_update(modbus_plan_t *plan, UT_array *tags);
+
+// commands of all (slave, area) ranges in order, valid until the next update
+modbus_read_cmd_sort_t *modbus_plan_cmds(modbus_plan_t *plan);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
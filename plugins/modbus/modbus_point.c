@@ -29,8 +29,6 @@ struct modbus_sort_ctx {
 
 static __thread uint16_t modbus_read_max_byte = 250;
 
-static int  tag_cmp(neu_tag_sort_elem_t *tag1, neu_tag_sort_elem_t *tag2);
-static bool tag_sort(neu_tag_sort_t *sort, void *tag, void *tag_to_be_sorted);
 static int  tag_cmp_write(neu_tag_sort_elem_t *tag1, neu_tag_sort_elem_t *tag2);
 static bool tag_sort_write(neu_tag_sort_t *sort, void *tag,
                            void *tag_to_be_sorted);
@@ -209,34 +207,6 @@ int modbus_write_tag_to_point(const neu_plugin_tag_value_t *tag,
     return ret;
 }
 
-modbus_read_cmd_sort_t *modbus_tag_sort(UT_array *tags, uint16_t max_byte)
-{
-    modbus_read_max_byte          = max_byte;
-    neu_tag_sort_result_t *result = neu_tag_sort(tags, tag_sort, tag_cmp);
-
-    modbus_read_cmd_sort_t *sort_result =
-        calloc(1, sizeof(modbus_read_cmd_sort_t));
-    sort_result->n_cmd = result->n_sort;
-    sort_result->cmd   = calloc(result->n_sort, sizeof(modbus_read_cmd_t));
-
-    for (uint16_t i = 0; i < result->n_sort; i++) {
-        modbus_point_t *tag =
-            *(modbus_point_t **) utarray_front(result->sorts[i].tags);
-        struct modbus_sort_ctx *ctx = result->sorts[i].info.context;
-
-        sort_result->cmd[i].tags     = utarray_clone(result->sorts[i].tags);
-        sort_result->cmd[i].slave_id = tag->slave_id;
-        sort_result->cmd[i].area     = tag->area;
-        sort_result->cmd[i].start_address = tag->start_address;
-        sort_result->cmd[i].n_register    = ctx->end - ctx->start;
-
-        free(result->sorts[i].info.context);
-    }
-
-    neu_tag_sort_free(result);
-    return sort_result;
-}
-
 int cal_n_byte(int type, neu_value_u *value, neu_datatag_addr_option_u option,
                modbus_endianess endianess, bool default_tag_endian)
 {
@@ -355,102 +325,6 @@ modbus_write_cmd_sort_t *modbus_write_tags_sort(UT_array *       tags,
     return sort_result;
 }
 
-void modbus_tag_sort_free(modbus_read_cmd_sort_t *cs)
-{
-    for (uint16_t i = 0; i < cs->n_cmd; i++) {
-        utarray_free(cs->cmd[i].tags);
-    }
-
-    free(cs->cmd);
-    free(cs);
-}
-
-static int tag_cmp(neu_tag_sort_elem_t *tag1, neu_tag_sort_elem_t *tag2)
-{
-    modbus_point_t *p_t1 = (modbus_point_t *) tag1->tag;
-    modbus_point_t *p_t2 = (modbus_point_t *) tag2->tag;
-
-    if (p_t1->slave_id > p_t2->slave_id) {
-        return 1;
-    } else if (p_t1->slave_id < p_t2->slave_id) {
-        return -1;
-    }
-
-    if (p_t1->area > p_t2->area) {
-        return 1;
-    } else if (p_t1->area < p_t2->area) {
-        return -1;
-    }
-
-    if (p_t1->start_address > p_t2->start_address) {
-        return 1;
-    } else if (p_t1->start_address < p_t2->start_address) {
-        return -1;
-    }
-
-    if (p_t1->n_register > p_t2->n_register) {
-        return 1;
-    } else if (p_t1->n_register < p_t2->n_register) {
-        return -1;
-    }
-
-    return 0;
-}
-
-static bool tag_sort(neu_tag_sort_t *sort, void *tag, void *tag_to_be_sorted)
-{
-    modbus_point_t *        t1  = (modbus_point_t *) tag;
-    modbus_point_t *        t2  = (modbus_point_t *) tag_to_be_sorted;
-    struct modbus_sort_ctx *ctx = NULL;
-
-    if (sort->info.context == NULL) {
-        sort->info.context = calloc(1, sizeof(struct modbus_sort_ctx));
-        ctx                = (struct modbus_sort_ctx *) sort->info.context;
-        ctx->start         = t1->start_address;
-        ctx->end           = t1->start_address + t1->n_register;
-        return true;
-    }
-
-    ctx = (struct modbus_sort_ctx *) sort->info.context;
-
-    if (t1->slave_id != t2->slave_id) {
-        return false;
-    }
-
-    if (t1->area != t2->area) {
-        return false;
-    }
-
-    if (t2->start_address > ctx->end) {
-        return false;
-    }
-
-    switch (t1->area) {
-    case MODBUS_AREA_COIL:
-    case MODBUS_AREA_INPUT:
-        if ((ctx->end - ctx->start + 7) / 8 >= modbus_read_max_byte) {
-            return false;
-        }
-        break;
-    case MODBUS_AREA_INPUT_REGISTER:
-    case MODBUS_AREA_HOLD_REGISTER: {
-        uint16_t now_bytes = (ctx->end - ctx->start) * 2;
-        uint16_t add_now   = now_bytes + t2->n_register * 2;
-        if (add_now >= modbus_read_max_byte) {
-            return false;
-        }
-
-        break;
-    }
-    }
-
-    if (t2->start_address + t2->n_register > ctx->end) {
-        ctx->end = t2->start_address + t2->n_register;
-    }
-
-    return true;
-}
-
 static int tag_cmp_write(neu_tag_sort_elem_t *tag1, neu_tag_sort_elem_t *tag2)
 {
     modbus_point_write_t *p_t1 = (modbus_point_write_t *) tag1->tag;
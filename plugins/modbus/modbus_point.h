@@ -57,7 +57,8 @@ typedef struct modbus_read_cmd {
     uint16_t      start_address;
     uint16_t      n_register;
 
-    UT_array *tags; // modbus_point_t ptr;
+    UT_array *                 tags; // modbus_point_t ptr;
+    struct modbus_decode_plan *plan;
 } modbus_read_cmd_t;
 
 typedef struct modbus_read_cmd_sort {
@@ -81,10 +82,8 @@ typedef struct modbus_write_cmd_sort {
     modbus_write_cmd_t *cmd;
 } modbus_write_cmd_sort_t;
 
-modbus_read_cmd_sort_t * modbus_tag_sort(UT_array *tags, uint16_t max_byte);
 modbus_write_cmd_sort_t *modbus_write_tags_sort(UT_array *       tags,
                                                 modbus_endianess endianess);
-void                     modbus_tag_sort_free(modbus_read_cmd_sort_t *cs);
 
 void modbus_convert_endianess(neu_value_u *value, modbus_endianess endianess);
 
@@ -0,0 +1,266 @@
+/**
+ * NEURON IIoT System for Industry 4.0
+ * Copyright (C) 2020-2024 EMQ Technologies Co., Ltd All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ **/
+#include <poll.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "modbus_pool.h"
+
+typedef struct {
+    modbus_pool_t *         pool;
+    const modbus_pool_io_t *io;
+    uint16_t                n_cmd;
+    uint16_t                max_retries;
+    uint16_t *              queue;
+    uint16_t *              tries;
+    uint16_t                head;
+    uint16_t                n_queue;
+    uint16_t                n_busy;
+} pool_read_t;
+
+void modbus_pool_init(modbus_pool_t *pool, uint8_t n_conn)
+{
+    memset(pool, 0, sizeof(*pool));
+
+    pool->n_conn = n_conn < 1 ? 1 : n_conn;
+    if (pool->n_conn > MODBUS_POOL_MAX) {
+        pool->n_conn = MODBUS_POOL_MAX;
+    }
+    for (int i = 0; i < MODBUS_POOL_MAX; i++) {
+        pool->conns[i].cmd = -1;
+    }
+}
+
+bool modbus_pool_usable(const modbus_pool_t *pool, int i, int64_t now)
+{
+    const modbus_pool_conn_t *pc = &pool->conns[i];
+
+    return i == 0 || pc->failures < MODBUS_POOL_FAILURES ||
+        now >= pc->retry_tms;
+}
+
+int modbus_pool_n_usable(const modbus_pool_t *pool, int64_t now)
+{
+    int n = 0;
+
+    for (int i = 0; i < pool->n_conn; i++) {
+        n += modbus_pool_usable(pool, i, now);
+    }
+    return n;
+}
+
+bool modbus_pool_ok(modbus_pool_t *pool, int i)
+{
+    modbus_pool_conn_t *pc   = &pool->conns[i];
+    bool                back = pc->failures >= MODBUS_POOL_FAILURES;
+
+    pc->failures = 0;
+    pc->backoff  = 0;
+    return i != 0 && back;
+}
+
+bool modbus_pool_fail(modbus_pool_t *pool, int i, int64_t now)
+{
+    modbus_pool_conn_t *pc = &pool->conns[i];
+
+    if (pc->failures < UINT16_MAX) {
+        pc->failures += 1;
+    }
+    if (i == 0 || pc->failures < MODBUS_POOL_FAILURES) {
+        return false;
+    }
+
+    // a trial exchange after the backoff failed again, or just failed enough
+    pc->backoff = pc->backoff == 0 ? MODBUS_POOL_BACKOFF_MIN_MS
+                                   : pc->backoff * 2;
+    if (pc->backoff > MODBUS_POOL_BACKOFF_MAX_MS) {
+        pc->backoff = MODBUS_POOL_BACKOFF_MAX_MS;
+    }
+    pc->retry_tms = now + pc->backoff;
+    return true;
+}
+
+static inline void read_requeue(pool_read_t *rd, uint16_t cmd)
+{
+    rd->queue[(rd->head + rd->n_queue) % rd->n_cmd] = cmd;
+    rd->n_queue += 1;
+}
+
+// next queued command still wanted, -1 if none
+static int read_next(pool_read_t *rd)
+{
+    while (rd->n_queue > 0) {
+        uint16_t cmd = rd->queue[rd->head];
+
+        rd->head = (rd->head + 1) % rd->n_cmd;
+        rd->n_queue -= 1;
+        if (rd->io->wanted(rd->io->ctx, cmd)) {
+            return cmd;
+        }
+    }
+    return -1;
+}
+
+// hand the next queued command to slot `s` if it is free
+static void read_fill(pool_read_t *rd, int s, int64_t now)
+{
+    modbus_pool_conn_t *    pc  = &rd->pool->conns[s];
+    const modbus_pool_io_t *io  = rd->io;
+    int                     cmd = 0;
+    int                     ret = 0;
+
+    if (pc->cmd >= 0 || !modbus_pool_usable(rd->pool, s, now) ||
+        !io->ready(io->ctx, s)) {
+        return;
+    }
+
+    cmd = read_next(rd);
+    if (cmd < 0) {
+        return;
+    }
+
+    ret = io->send(io->ctx, s, cmd);
+    rd->tries[cmd] += 1;
+    if (ret > 0) {
+        pc->cmd      = cmd;
+        pc->send_tms = now;
+        rd->n_busy += 1;
+        return;
+    }
+
+    io->health(io->ctx, s, false, now);
+    if (rd->tries[cmd] <= rd->max_retries) {
+        read_requeue(rd, cmd);
+    } else {
+        io->done(io->ctx, s, cmd, ret, 0, now);
+    }
+}
+
+// the command in flight on slot `s` got `ret_buf`, true if the exchange
+// went well
+static bool read_finish(pool_read_t *rd, int s, int ret_buf, int64_t now)
+{
+    modbus_pool_conn_t *    pc  = &rd->pool->conns[s];
+    const modbus_pool_io_t *io  = rd->io;
+    uint16_t                cmd = pc->cmd;
+    bool                    ok  = ret_buf != 0 && ret_buf != -1;
+
+    pc->cmd = -1;
+    rd->n_busy -= 1;
+    io->health(io->ctx, s, ok, now);
+
+    if (ret_buf == 0 && rd->tries[cmd] <= rd->max_retries) {
+        read_requeue(rd, cmd);
+    } else {
+        io->done(io->ctx, s, cmd, 1, ret_buf, pc->send_tms);
+    }
+    return ok;
+}
+
+// wait for the first responses or timeouts of the slots in flight
+static void read_wait(pool_read_t *rd, int64_t timeout)
+{
+    struct pollfd fds[MODBUS_POOL_MAX]   = { 0 };
+    int           slots[MODBUS_POOL_MAX] = { 0 };
+    int           n                      = 0;
+    int64_t       now                    = neu_time_ms();
+    int64_t       wait                   = timeout;
+
+    for (int s = 0; s < rd->pool->n_conn; s++) {
+        modbus_pool_conn_t *pc = &rd->pool->conns[s];
+
+        if (pc->cmd < 0) {
+            continue;
+        }
+
+        fds[n].fd     = rd->io->fd(rd->io->ctx, s);
+        fds[n].events = POLLIN;
+        slots[n]      = s;
+        n += 1;
+
+        if (pc->send_tms + timeout - now < wait) {
+            wait = pc->send_tms + timeout - now;
+        }
+    }
+
+    if (poll(fds, n, wait > 0 ? wait : 0) < 0) {
+        return;
+    }
+
+    for (int k = 0; k < n; k++) {
+        modbus_pool_conn_t *pc = &rd->pool->conns[slots[k]];
+        int                 s  = slots[k];
+
+        now = neu_time_ms();
+        if (fds[k].fd < 0) {
+            read_finish(rd, s, -1, now);
+        } else if (fds[k].revents != 0) {
+            // a good slot is kept busy right away, a failed one waits for the
+            // next round so that a retry can go to another slot first
+            if (read_finish(rd, s, rd->io->recv(rd->io->ctx, s, pc->cmd),
+                            now)) {
+                read_fill(rd, s, neu_time_ms());
+            }
+        } else if (now >= pc->send_tms + timeout) {
+            read_finish(rd, s, 0, now);
+        }
+    }
+}
+
+int modbus_pool_read(modbus_pool_t *pool, uint16_t n_cmd, uint16_t max_retries,
+                     int64_t timeout, const modbus_pool_io_t *io)
+{
+    pool_read_t rd = {
+        .pool        = pool,
+        .io          = io,
+        .n_cmd       = n_cmd,
+        .max_retries = max_retries,
+        .n_queue     = n_cmd,
+    };
+
+    if (n_cmd == 0) {
+        return 0;
+    }
+
+    rd.queue = calloc(n_cmd, sizeof(uint16_t));
+    rd.tries = calloc(n_cmd, sizeof(uint16_t));
+    if (rd.queue == NULL || rd.tries == NULL) {
+        free(rd.queue);
+        free(rd.tries);
+        return -1;
+    }
+    for (uint16_t i = 0; i < n_cmd; i++) {
+        rd.queue[i] = i;
+    }
+
+    while (rd.n_queue > 0 || rd.n_busy > 0) {
+        int64_t now = neu_time_ms();
+
+        for (int s = 0; s < pool->n_conn && rd.n_queue > 0; s++) {
+            read_fill(&rd, s, now);
+        }
+        if (rd.n_busy > 0) {
+            read_wait(&rd, timeout);
+        }
+    }
+
+    free(rd.queue);
+    free(rd.tries);
+    return 0;
+}
@@ -0,0 +1,118 @@
+/**
+ * NEURON IIoT System for Industry 4.0
+ * Copyright (C) 2020-2024 EMQ Technologies Co., Ltd All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ **/
+#ifndef _NEU_PLUGIN_MODBUS_POOL_H_
+#define _NEU_PLUGIN_MODBUS_POOL_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <neuron.h>
+
+#include "modbus_stack.h"
+
+#define MODBUS_POOL_MAX 8
+// consecutive failed exchanges that take a connection out of rotation
+#define MODBUS_POOL_FAILURES 3
+#define MODBUS_POOL_BACKOFF_MIN_MS 1000
+#define MODBUS_POOL_BACKOFF_MAX_MS 60000
+
+/*
+ * Connections of a modbus tcp client node. Group reads spread their commands
+ * over all connections in rotation, each with one command in flight. Slot 0
+ * is the node connection, also used for writes and test reads, and never
+ * leaves rotation. The other slots leave it after MODBUS_POOL_FAILURES
+ * failed exchanges in a row and come back after a backoff that doubles on
+ * every new failure.
+ */
+typedef struct {
+    neu_conn_t *    conn;
+    modbus_stack_t *stack;
+
+    int      cmd; // read command in flight, -1 if none
+    uint16_t response_size;
+    int64_t  send_tms;
+
+    uint16_t failures;  // in a row
+    int64_t  backoff;   // ms, 0 while healthy
+    int64_t  retry_tms; // out of rotation until then
+} modbus_pool_conn_t;
+
+typedef struct {
+    modbus_pool_conn_t conns[MODBUS_POOL_MAX];
+    uint8_t            n_conn;
+    bool               backup; // address of the other slots
+} modbus_pool_t;
+
+void modbus_pool_init(modbus_pool_t *pool, uint8_t n_conn);
+
+bool modbus_pool_usable(const modbus_pool_t *pool, int i, int64_t now);
+int  modbus_pool_n_usable(const modbus_pool_t *pool, int64_t now);
+
+// a good exchange on slot `i`, true if it comes back into rotation
+bool modbus_pool_ok(modbus_pool_t *pool, int i);
+// a failed exchange on slot `i`, true if it leaves rotation
+bool modbus_pool_fail(modbus_pool_t *pool, int i, int64_t now);
+
+/*
+ * What a group read does with the slots of the pool, `ctx` is handed back
+ * to every callback.
+ */
+typedef struct {
+    void *ctx;
+    // whether slot `s` can carry a command now, false while connecting
+    bool (*ready)(void *ctx, int s);
+    // whether command `cmd` is still to be read, false once its slave failed
+    bool (*wanted)(void *ctx, uint16_t cmd);
+    // send command `cmd` on slot `s`, > 0 once sent
+    int (*send)(void *ctx, int s, uint16_t cmd);
+    // socket of slot `s` to wait on for the response
+    int (*fd)(void *ctx, int s);
+    // receive and process the response of command `cmd` on slot `s`, > 0 on
+    // success, 0 without a response, -1 if the connection broke, other
+    // negative values for an error response
+    int (*recv)(void *ctx, int s, uint16_t cmd);
+    // an exchange on slot `s` succeeded or failed
+    void (*health)(void *ctx, int s, bool ok, int64_t now);
+    // command `cmd` is finished with `ret` of its last send and `ret_buf` of
+    // its last receive, 0 if it was not sent
+    void (*done)(void *ctx, int s, uint16_t cmd, int ret, int ret_buf,
+                 int64_t send_tms);
+} modbus_pool_io_t;
+
+/*
+ * Read commands 0 to `n_cmd` - 1 over the pool. Every usable slot carries one
+ * command at a time and is handed the next queued one as soon as its own
+ * response is processed, the slots in flight are polled together. A command
+ * without a response within `timeout` ms, or that could not be sent, goes
+ * back to the queue for another slot up to `max_retries` times.
+ *
+ * @return 0 on success, -1 if the queue could not be allocated.
+ */
+int modbus_pool_read(modbus_pool_t *pool, uint16_t n_cmd, uint16_t max_retries,
+                     int64_t timeout, const modbus_pool_io_t *io);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
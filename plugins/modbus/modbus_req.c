@@ -18,6 +18,8 @@
  **/
 #include <time.h>
 
+#include "modbus_decode.h"
+#include "modbus_plan.h"
 #include "modbus_point.h"
 #include "modbus_stack.h"
 
@@ -25,14 +27,21 @@
 
 #define MAX_SLAVES 256
 
+// tags committed to the driver cache per update_batch call, each entry holds
+// a full neu_dvalue_t so the chunk stays small enough for the stack
+#define MODBUS_UPDATE_BATCH 16
+
 uint8_t failed_cycles[MAX_SLAVES];
 bool    skip[MAX_SLAVES];
 
 struct modbus_group_data {
-    UT_array *              tags;
+    neu_plugin_t *          plugin;
     char *                  group;
-    modbus_read_cmd_sort_t *cmd_sort;
+    modbus_plan_t *         plan;
+    modbus_read_cmd_sort_t *cmd_sort; // owned by plan
     modbus_address_base     address_base;
+    modbus_endianess        endianess; // folded into the decode plans
+    int64_t                 deadline;  // neu_time_ms() the cycle is due by
 };
 
 struct modbus_write_tags_data {
@@ -41,8 +50,11 @@ struct modbus_write_tags_data {
 };
 
 static void plugin_group_free(neu_plugin_group_t *pgp);
+static int  plugin_group_change(neu_plugin_group_t *pgp, UT_array *tags);
 static int  process_protocol_buf(neu_plugin_t *plugin, uint8_t slave_id,
                                  uint16_t response_size);
+static int  process_pool_buf(neu_plugin_t *plugin, modbus_pool_conn_t *pc,
+                             uint8_t slave_id);
 static int  process_protocol_buf_test(neu_plugin_t *plugin, void *req,
                                       modbus_point_t *point,
                                       uint16_t        response_size);
@@ -121,7 +133,9 @@ int modbus_send_msg(void *ctx, uint16_t n_byte, uint8_t *bytes)
         ret = neu_conn_tcp_server_send(plugin->conn, plugin->client_fd, bytes,
                                        n_byte);
     } else {
-        if (plugin->backup && neu_conn_is_connected(plugin->conn) == false) {
+        // let a pending connect finish before switching to the other address
+        if (plugin->backup && neu_conn_is_connected(plugin->conn) == false &&
+            neu_conn_link(plugin->conn) != NEU_CONN_LINK_CONNECTING) {
             if (plugin->current_backup == false && plugin->first_attempt_done) {
                 plog_notice(plugin, "switch to backup ip:port %s:%hu",
                             plugin->param_backup.params.tcp_client.ip,
@@ -144,21 +158,160 @@ int modbus_send_msg(void *ctx, uint16_t n_byte, uint8_t *bytes)
     return ret;
 }
 
+// send_fn of the stacks of the other pool slots, they only carry group reads
+static int modbus_pool_send_msg(void *ctx, uint16_t n_byte, uint8_t *bytes)
+{
+    neu_plugin_t *plugin = (neu_plugin_t *) ctx;
+    neu_conn_t *  conn   = plugin->pool_cur->conn;
+
+    neu_conn_clear_recv_buffer(conn);
+    plog_send_protocol(plugin, bytes, n_byte);
+    return neu_conn_send(conn, bytes, n_byte);
+}
+
+// the node link state follows the primary connection only
+static void modbus_pool_conn_event(void *data, int fd)
+{
+    (void) data;
+    (void) fd;
+}
+
+int modbus_pool_config(neu_plugin_t *plugin, uint8_t n_conn)
+{
+    modbus_pool_t *pool = &plugin->pool;
+
+    if (pool->n_conn == 0) {
+        modbus_pool_init(pool, 1);
+    }
+    if (plugin->is_server || n_conn < 1) {
+        n_conn = 1;
+    } else if (n_conn > MODBUS_POOL_MAX) {
+        n_conn = MODBUS_POOL_MAX;
+    }
+
+    for (int i = 1; i < MODBUS_POOL_MAX; i++) {
+        modbus_pool_conn_t *pc = &pool->conns[i];
+
+        if (i >= n_conn) {
+            // kept until uninit, a running group read may still hold it
+            if (pc->conn != NULL) {
+                neu_conn_disconnect(pc->conn);
+            }
+            continue;
+        }
+
+        if (pc->conn == NULL) {
+            pc->stack = modbus_stack_create(
+                (void *) plugin, MODBUS_PROTOCOL_TCP, modbus_pool_send_msg,
+                modbus_value_handle, modbus_write_resp);
+            pc->conn = neu_conn_new(&plugin->param, (void *) plugin,
+                                    modbus_pool_conn_event,
+                                    modbus_pool_conn_event);
+        } else {
+            pc->conn = neu_conn_reconfig(pc->conn, &plugin->param);
+        }
+        pc->failures = 0;
+        pc->backoff  = 0;
+    }
+
+    pool->backup = false;
+    pool->n_conn = n_conn;
+    return 0;
+}
+
+void modbus_pool_start(neu_plugin_t *plugin)
+{
+    for (int i = 1; i < MODBUS_POOL_MAX; i++) {
+        if (plugin->pool.conns[i].conn != NULL) {
+            neu_conn_start(plugin->pool.conns[i].conn);
+        }
+    }
+}
+
+void modbus_pool_stop(neu_plugin_t *plugin)
+{
+    for (int i = 1; i < MODBUS_POOL_MAX; i++) {
+        if (plugin->pool.conns[i].conn != NULL) {
+            neu_conn_stop(plugin->pool.conns[i].conn);
+        }
+    }
+}
+
+void modbus_pool_free(neu_plugin_t *plugin)
+{
+    for (int i = 1; i < MODBUS_POOL_MAX; i++) {
+        modbus_pool_conn_t *pc = &plugin->pool.conns[i];
+
+        if (pc->conn != NULL) {
+            neu_conn_destory(pc->conn);
+            pc->conn = NULL;
+        }
+        if (pc->stack != NULL) {
+            modbus_stack_destroy(pc->stack);
+            pc->stack = NULL;
+        }
+    }
+}
+
+// slot 0 is whatever the node connection is now, the others follow it to the
+// backup address and back
+static void pool_sync(neu_plugin_t *plugin)
+{
+    modbus_pool_t *   pool  = &plugin->pool;
+    neu_conn_param_t *param = NULL;
+
+    pool->conns[0].conn  = plugin->conn;
+    pool->conns[0].stack = plugin->stack;
+
+    if (pool->backup != plugin->current_backup) {
+        param = plugin->current_backup ? &plugin->param_backup : &plugin->param;
+        for (int i = 1; i < pool->n_conn; i++) {
+            pool->conns[i].conn =
+                neu_conn_reconfig(pool->conns[i].conn, param);
+        }
+        pool->backup = plugin->current_backup;
+    }
+}
+
+// send a read command and process its response, the serial bus is held
+static int modbus_read_cmd(neu_plugin_t *plugin, struct modbus_group_data *gd,
+                           uint16_t i, int *ret_buf)
+{
+    modbus_read_cmd_t *cmd           = &gd->cmd_sort->cmd[i];
+    uint16_t           response_size = 0;
+    int                ret           = 0;
+
+    *ret_buf = 0;
+    ret      = modbus_stack_read(plugin->stack, cmd->slave_id, cmd->area,
+                            cmd->start_address, cmd->n_register,
+                            &response_size, false);
+    if (ret > 0) {
+        *ret_buf = process_protocol_buf(plugin, cmd->slave_id, response_size);
+    }
+
+    return ret;
+}
+
 int modbus_stack_read_retry(neu_plugin_t *plugin, struct modbus_group_data *gd,
-                            uint16_t i, uint16_t j, uint16_t *response_size,
+                            uint16_t i, uint16_t j, int *ret_buf,
                             uint64_t *read_tms)
 {
     struct timespec t3 = { .tv_sec = plugin->retry_interval / 1000,
                            .tv_nsec =
                                1000 * 1000 * (plugin->retry_interval % 1000) };
     struct timespec t4 = { 0 };
+    int             ret = 0;
+
     nanosleep(&t3, &t4);
     plog_notice(plugin, "Resend read req. Times:%hu", j + 1);
+
+    // a retry finishes a command already started, the deadline does not apply
+    neu_conn_bus_acquire(plugin->conn, NEU_CONN_BUS_PRIO_NORMAL, 0);
     *read_tms = neu_time_ms();
-    return modbus_stack_read(
-        plugin->stack, gd->cmd_sort->cmd[i].slave_id, gd->cmd_sort->cmd[i].area,
-        gd->cmd_sort->cmd[i].start_address, gd->cmd_sort->cmd[i].n_register,
-        response_size, false);
+    ret       = modbus_read_cmd(plugin, gd, i, ret_buf);
+    neu_conn_bus_release(plugin->conn);
+
+    return ret;
 }
 
 void handle_modbus_error(neu_plugin_t *plugin, struct modbus_group_data *gd,
@@ -175,7 +328,7 @@ void handle_modbus_error(neu_plugin_t *plugin, struct modbus_group_data *gd,
 }
 
 void finalize_modbus_read_result(neu_plugin_t *            plugin,
-                                 struct modbus_group_data *gd,
+                                 struct modbus_group_data *gd, neu_conn_t *conn,
                                  uint16_t cmd_index, int ret_r, int ret_buf,
                                  uint64_t read_tms, int64_t *rtt,
                                  bool *slave_err)
@@ -184,7 +337,7 @@ void finalize_modbus_read_result(neu_plugin_t *            plugin,
         handle_modbus_error(plugin, gd, cmd_index, NEU_ERR_PLUGIN_DISCONNECTED,
                             "send message failed");
         *rtt = NEU_METRIC_LAST_RTT_MS_MAX;
-        neu_conn_disconnect(plugin->conn);
+        neu_conn_disconnect(conn);
     } else if (ret_buf <= 0) {
         switch (ret_buf) {
         case 0:
@@ -199,7 +352,7 @@ void finalize_modbus_read_result(neu_plugin_t *            plugin,
                                 NEU_ERR_PLUGIN_PROTOCOL_DECODE_FAILURE,
                                 "modbus message error");
             *rtt = NEU_METRIC_LAST_RTT_MS_MAX;
-            neu_conn_disconnect(plugin->conn);
+            neu_conn_disconnect(conn);
             break;
         case -2:
             handle_modbus_error(plugin, gd, cmd_index,
@@ -220,39 +373,33 @@ void check_modbus_read_result(neu_plugin_t *            plugin,
                               struct modbus_group_data *gd, uint16_t cmd_index,
                               int64_t *rtt, bool *slave_err)
 {
-    uint16_t response_size = 0;
-    uint64_t read_tms      = neu_time_ms();
-
-    int ret_r = modbus_stack_read(
-        plugin->stack, gd->cmd_sort->cmd[cmd_index].slave_id,
-        gd->cmd_sort->cmd[cmd_index].area,
-        gd->cmd_sort->cmd[cmd_index].start_address,
-        gd->cmd_sort->cmd[cmd_index].n_register, &response_size, false);
-
-    int ret_buf = 0;
-    if (ret_r > 0) {
-        ret_buf = process_protocol_buf(
-            plugin, gd->cmd_sort->cmd[cmd_index].slave_id, response_size);
+    uint64_t read_tms = 0;
+    int      ret_buf  = 0;
+    int      ret_r    = 0;
+
+    if (neu_conn_bus_acquire(plugin->conn, NEU_CONN_BUS_PRIO_NORMAL,
+                             gd->deadline) != 0) {
+        handle_modbus_error(plugin, gd, cmd_index, NEU_ERR_PLUGIN_READ_FAILURE,
+                            "serial bus busy past group interval");
+        return;
     }
+    read_tms = neu_time_ms();
+    ret_r    = modbus_read_cmd(plugin, gd, cmd_index, &ret_buf);
+    neu_conn_bus_release(plugin->conn);
 
     if (ret_r <= 0 || ret_buf == 0) {
         for (uint16_t j = 0; j < plugin->max_retries; ++j) {
-            ret_r = modbus_stack_read_retry(plugin, gd, cmd_index, j,
-                                            &response_size, &read_tms);
-            if (ret_r > 0) {
-                ret_buf = process_protocol_buf(
-                    plugin, gd->cmd_sort->cmd[cmd_index].slave_id,
-                    response_size);
-                if (ret_buf == 0) {
-                    continue;
-                }
+            ret_r = modbus_stack_read_retry(plugin, gd, cmd_index, j, &ret_buf,
+                                            &read_tms);
+            if (ret_r > 0 && ret_buf == 0) {
+                continue;
             }
             break;
         }
     }
 
-    finalize_modbus_read_result(plugin, gd, cmd_index, ret_r, ret_buf, read_tms,
-                                rtt, slave_err);
+    finalize_modbus_read_result(plugin, gd, plugin->conn, cmd_index, ret_r,
+                                ret_buf, read_tms, rtt, slave_err);
 }
 
 void update_metrics_after_read(neu_plugin_t *plugin, int64_t rtt,
@@ -260,6 +407,12 @@ void update_metrics_after_read(neu_plugin_t *plugin, int64_t rtt,
                                neu_conn_state_t *  state)
 {
     *state = neu_conn_state(plugin->conn);
+    for (int i = 1; i < plugin->pool.n_conn; i++) {
+        neu_conn_state_t s = neu_conn_state(plugin->pool.conns[i].conn);
+
+        state->send_bytes += s.send_bytes;
+        state->recv_bytes += s.recv_bytes;
+    }
     neu_adapter_update_metric_cb_t update_metric =
         plugin->common.adapter_callbacks->update_metric;
     struct modbus_group_data *gd =
@@ -272,6 +425,10 @@ void update_metrics_after_read(neu_plugin_t *plugin, int64_t rtt,
     update_metric(plugin->common.adapter, NEU_METRIC_LAST_RTT_MS, rtt, NULL);
     update_metric(plugin->common.adapter, NEU_METRIC_GROUP_LAST_SEND_MSGS,
                   gd->cmd_sort->n_cmd, group->group_name);
+    if (plugin->is_serial) {
+        update_metric(plugin->common.adapter, NEU_METRIC_BUS_UTILIZATION,
+                      state->bus_utilization, NULL);
+    }
 }
 
 typedef struct {
@@ -308,6 +465,170 @@ void set_skip_timer(uint8_t slave_id, uint32_t degrade_time)
     pthread_detach(timer_thread);
 }
 
+static void degrade_check(neu_plugin_t *plugin, uint8_t slave_id, bool err,
+                          bool *slave_err_record)
+{
+    if (plugin->degradation) {
+        if (err) {
+            failed_cycles[slave_id]++;
+            slave_err_record[slave_id] = true;
+        }
+
+        if (failed_cycles[slave_id] >= plugin->degrade_cycle) {
+            skip[slave_id] = true;
+            plog_warn(plugin, "Skip slave %hhu", slave_id);
+            set_skip_timer(slave_id, plugin->degrade_time);
+        }
+    }
+}
+
+static void plan_update(neu_plugin_t *plugin, struct modbus_group_data *gd,
+                        UT_array *tags)
+{
+    int64_t start   = neu_time_us();
+    int     invalid = modbus_plan_update(gd->plan, tags);
+    int64_t spend   = neu_time_us() - start;
+
+    if (plugin->plan_build != NULL) {
+        neu_histogram_record(plugin->plan_build, spend);
+    }
+    if (invalid > 0) {
+        plog_error(plugin, "group: %s, skip %d tags with invalid address",
+                   gd->group, invalid);
+    }
+    plog_debug(plugin, "group: %s, %" PRIu16 " read commands, %" PRId64 " us",
+               gd->group, gd->cmd_sort->n_cmd, spend);
+}
+
+static void pool_conn_fail(neu_plugin_t *plugin, int i, int64_t now)
+{
+    modbus_pool_conn_t *pc = &plugin->pool.conns[i];
+
+    neu_conn_disconnect(pc->conn);
+    if (modbus_pool_fail(&plugin->pool, i, now)) {
+        plog_warn(plugin, "connection %d out of rotation for %" PRId64 " ms", i,
+                  pc->backoff);
+    }
+}
+
+static void pool_conn_ok(neu_plugin_t *plugin, int i)
+{
+    if (modbus_pool_ok(&plugin->pool, i)) {
+        plog_notice(plugin, "connection %d back in rotation", i);
+    }
+}
+
+typedef struct {
+    neu_plugin_t *            plugin;
+    struct modbus_group_data *gd;
+    int64_t *                 rtt;
+    bool                      slave_err_record[MAX_SLAVES];
+} pool_read_ctx_t;
+
+static bool pool_ready(void *ctx, int s)
+{
+    pool_read_ctx_t *   rc = (pool_read_ctx_t *) ctx;
+    modbus_pool_conn_t *pc = &rc->plugin->pool.conns[s];
+
+    if (s > 0 && !neu_conn_is_connected(pc->conn)) {
+        neu_conn_connect(pc->conn);
+        return false;
+    }
+    return true;
+}
+
+// a slave that failed this cycle is not read any further
+static bool pool_wanted(void *ctx, uint16_t cmd)
+{
+    pool_read_ctx_t *rc       = (pool_read_ctx_t *) ctx;
+    uint8_t          slave_id = rc->gd->cmd_sort->cmd[cmd].slave_id;
+
+    return rc->slave_err_record[slave_id] == false &&
+        (rc->plugin->degradation == false || skip[slave_id] == false);
+}
+
+static int pool_send(void *ctx, int s, uint16_t i)
+{
+    pool_read_ctx_t *   rc     = (pool_read_ctx_t *) ctx;
+    neu_plugin_t *      plugin = rc->plugin;
+    modbus_pool_conn_t *pc     = &plugin->pool.conns[s];
+    modbus_read_cmd_t * cmd    = &rc->gd->cmd_sort->cmd[i];
+    int                 ret    = 0;
+
+    plugin->pool_cur = pc;
+    ret = modbus_stack_read(pc->stack, cmd->slave_id, cmd->area,
+                            cmd->start_address, cmd->n_register,
+                            &pc->response_size, false);
+    plugin->pool_cur = NULL;
+    return ret;
+}
+
+static int pool_fd(void *ctx, int s)
+{
+    pool_read_ctx_t *rc = (pool_read_ctx_t *) ctx;
+
+    return neu_conn_fd(rc->plugin->pool.conns[s].conn);
+}
+
+static int pool_recv(void *ctx, int s, uint16_t i)
+{
+    pool_read_ctx_t *rc = (pool_read_ctx_t *) ctx;
+
+    rc->plugin->cmd_idx = i;
+    return process_pool_buf(rc->plugin, &rc->plugin->pool.conns[s],
+                            rc->gd->cmd_sort->cmd[i].slave_id);
+}
+
+static void pool_health(void *ctx, int s, bool ok, int64_t now)
+{
+    pool_read_ctx_t *rc = (pool_read_ctx_t *) ctx;
+
+    if (ok) {
+        pool_conn_ok(rc->plugin, s);
+    } else {
+        pool_conn_fail(rc->plugin, s, now);
+    }
+}
+
+static void pool_done(void *ctx, int s, uint16_t i, int ret, int ret_buf,
+                      int64_t send_tms)
+{
+    pool_read_ctx_t *rc                    = (pool_read_ctx_t *) ctx;
+    neu_plugin_t *   plugin                = rc->plugin;
+    uint8_t          slave_id              = rc->gd->cmd_sort->cmd[i].slave_id;
+    bool             slave_err[MAX_SLAVES] = { false };
+
+    plugin->cmd_idx = i;
+    finalize_modbus_read_result(plugin, rc->gd, plugin->pool.conns[s].conn, i,
+                                ret, ret_buf, send_tms, rc->rtt, slave_err);
+    degrade_check(plugin, slave_id, ret > 0 && slave_err[slave_id],
+                  rc->slave_err_record);
+}
+
+// spread the commands of a group over the pool, see modbus_pool_read
+static void pool_read(neu_plugin_t *plugin, struct modbus_group_data *gd,
+                      int64_t *rtt)
+{
+    pool_read_ctx_t  rc = { .plugin = plugin, .gd = gd, .rtt = rtt };
+    modbus_pool_io_t io = {
+        .ctx    = &rc,
+        .ready  = pool_ready,
+        .wanted = pool_wanted,
+        .send   = pool_send,
+        .fd     = pool_fd,
+        .recv   = pool_recv,
+        .health = pool_health,
+        .done   = pool_done,
+    };
+    // the backup address is given the same timeout
+    int64_t timeout = plugin->param.params.tcp_client.timeout;
+
+    if (modbus_pool_read(&plugin->pool, gd->cmd_sort->n_cmd,
+                         plugin->max_retries, timeout, &io) != 0) {
+        plog_error(plugin, "group: %s, pool read out of memory", gd->group);
+    }
+}
+
 int modbus_group_timer(neu_plugin_t *plugin, neu_plugin_group_t *group,
                        uint16_t max_byte)
 {
@@ -317,36 +638,41 @@ int modbus_group_timer(neu_plugin_t *plugin, neu_plugin_group_t *group,
     struct modbus_group_data *gdt =
         (struct modbus_group_data *) group->user_data;
 
-    if (group->user_data == NULL || gdt->address_base != plugin->address_base) {
+    if (group->user_data == NULL || gdt->address_base != plugin->address_base ||
+        gdt->endianess != plugin->endianess) {
         if (group->user_data != NULL) {
             plugin_group_free(group);
         }
         gd = calloc(1, sizeof(struct modbus_group_data));
 
-        group->user_data  = gd;
-        group->group_free = plugin_group_free;
-        utarray_new(gd->tags, &ut_ptr_icd);
+        group->user_data    = gd;
+        group->group_free   = plugin_group_free;
+        group->group_change = plugin_group_change;
 
-        utarray_foreach(group->tags, neu_datatag_t *, tag)
-        {
-            modbus_point_t *p = calloc(1, sizeof(modbus_point_t));
-            int ret = modbus_tag_to_point(tag, p, plugin->address_base);
-            if (ret != NEU_ERR_SUCCESS) {
-                plog_error(plugin, "invalid tag: %s, address: %s", tag->name,
-                           tag->address);
-            }
-
-            utarray_push_back(gd->tags, &p);
-        }
-
-        gd->group        = strdup(group->group_name);
-        gd->cmd_sort     = modbus_tag_sort(gd->tags, max_byte);
+        gd->plugin = plugin;
+        gd->group  = strdup(group->group_name);
+        gd->plan =
+            modbus_plan_new(max_byte, plugin->endianess, plugin->address_base);
+        gd->cmd_sort     = modbus_plan_cmds(gd->plan);
         gd->address_base = plugin->address_base;
+        gd->endianess    = plugin->endianess;
+        plan_update(plugin, gd, group->tags);
     }
 
     gd                        = (struct modbus_group_data *) group->user_data;
     plugin->plugin_group_data = gd;
 
+    gd->deadline = group->interval > 0 ? neu_time_ms() + group->interval : 0;
+
+    // the pool spreads a cycle over its connections, a command interval
+    // paces a single one
+    if (plugin->pool.n_conn > 1 && plugin->interval == 0) {
+        pool_sync(plugin);
+        pool_read(plugin, gd, &rtt);
+        update_metrics_after_read(plugin, rtt, group, &state);
+        return 0;
+    }
+
     bool slave_err_record[MAX_SLAVES] = { false };
 
     for (uint16_t i = 0; i < gd->cmd_sort->n_cmd; i++) {
@@ -364,18 +690,7 @@ int modbus_group_timer(neu_plugin_t *plugin, neu_plugin_group_t *group,
             continue;
         }
 
-        if (plugin->degradation) {
-            if (slave_err[slave_id]) {
-                failed_cycles[slave_id]++;
-                slave_err_record[slave_id] = true;
-            }
-
-            if (failed_cycles[slave_id] >= plugin->degrade_cycle) {
-                skip[slave_id] = true;
-                plog_warn(plugin, "Skip slave %hhu", slave_id);
-                set_skip_timer(slave_id, plugin->degrade_time);
-            }
-        }
+        degrade_check(plugin, slave_id, slave_err[slave_id], slave_err_record);
 
         if (plugin->interval > 0) {
             struct timespec t1 = { .tv_sec  = plugin->interval / 1000,
@@ -390,6 +705,16 @@ int modbus_group_timer(neu_plugin_t *plugin, neu_plugin_group_t *group,
     return 0;
 }
 
+static void modbus_update_batch(neu_plugin_t *             plugin,
+                                struct modbus_group_data *gd,
+                                neu_tag_update_t *updates, int n_update)
+{
+    if (n_update > 0) {
+        plugin->common.adapter_callbacks->driver.update_batch(
+            plugin->common.adapter, gd->group, updates, n_update);
+    }
+}
+
 int modbus_value_handle(void *ctx, uint8_t slave_id, uint16_t n_byte,
                         uint8_t *bytes, int error, void *trace)
 {
@@ -398,10 +723,18 @@ int modbus_value_handle(void *ctx, uint8_t slave_id, uint16_t n_byte,
         (struct modbus_group_data *) plugin->plugin_group_data;
     uint16_t start_address = gd->cmd_sort->cmd[plugin->cmd_idx].start_address;
     uint16_t n_register    = gd->cmd_sort->cmd[plugin->cmd_idx].n_register;
+    modbus_decode_plan_t *plan = gd->cmd_sort->cmd[plugin->cmd_idx].plan;
+    neu_tag_update_t      updates[MODBUS_UPDATE_BATCH];
+    int                   n_update = 0;
 
     if (error == NEU_ERR_PLUGIN_DISCONNECTED) {
         neu_dvalue_t dvalue = { 0 };
 
+        // a pooled read retries on another connection, see pool_read
+        if (plugin->pool_cur != NULL) {
+            return 0;
+        }
+
         dvalue.type      = NEU_TYPE_ERROR;
         dvalue.value.i32 = error;
         plugin->common.adapter_callbacks->driver.update(
@@ -411,121 +744,65 @@ int modbus_value_handle(void *ctx, uint8_t slave_id, uint16_t n_byte,
         utarray_foreach(gd->cmd_sort->cmd[plugin->cmd_idx].tags,
                         modbus_point_t **, p_tag)
         {
-            neu_dvalue_t dvalue = { 0 };
-            dvalue.type         = NEU_TYPE_ERROR;
-            dvalue.value.i32    = error;
-            plugin->common.adapter_callbacks->driver.update(
-                plugin->common.adapter, gd->group, (*p_tag)->name, dvalue);
+            neu_tag_update_t *update = &updates[n_update];
+
+            memset(&update->value, 0, sizeof(update->value));
+            update->tag             = (*p_tag)->name;
+            update->value.type      = NEU_TYPE_ERROR;
+            update->value.value.i32 = error;
+            update->metas           = NULL;
+            update->n_meta          = 0;
+            update->timestamp       = 0;
+            if (++n_update == MODBUS_UPDATE_BATCH) {
+                modbus_update_batch(plugin, gd, updates, n_update);
+                n_update = 0;
+            }
         }
+        modbus_update_batch(plugin, gd, updates, n_update);
         return 0;
     }
 
+    modbus_decode_block(plan, bytes, n_byte);
+
     utarray_foreach(gd->cmd_sort->cmd[plugin->cmd_idx].tags, modbus_point_t **,
                     p_tag)
     {
         neu_dvalue_t dvalue = { 0 };
+        uint16_t     index =
+            utarray_eltidx(gd->cmd_sort->cmd[plugin->cmd_idx].tags, p_tag);
 
         if ((*p_tag)->start_address + (*p_tag)->n_register >
                 start_address + n_register ||
             slave_id != (*p_tag)->slave_id) {
             dvalue.type      = NEU_TYPE_ERROR;
             dvalue.value.i32 = NEU_ERR_PLUGIN_READ_FAILURE;
+        } else if (plan->ops[index].shuffle) {
+            dvalue.type      = (*p_tag)->type;
+            dvalue.value.u64 = plan->values[index];
         } else {
-            switch ((*p_tag)->area) {
-            case MODBUS_AREA_HOLD_REGISTER:
-            case MODBUS_AREA_INPUT_REGISTER:
-                if (n_byte >= ((*p_tag)->start_address - start_address) * 2 +
-                        (*p_tag)->n_register * 2) {
-                    memcpy(dvalue.value.bytes.bytes,
-                           bytes +
-                               ((*p_tag)->start_address - start_address) * 2,
-                           (*p_tag)->n_register * 2);
-                    dvalue.value.bytes.length = (*p_tag)->n_register * 2;
-                }
-                break;
-            case MODBUS_AREA_COIL:
-            case MODBUS_AREA_INPUT: {
-                uint16_t offset = (*p_tag)->start_address - start_address;
-                if (n_byte > offset / 8) {
-                    neu_value8_u u8 = { .value = bytes[offset / 8] };
-
-                    dvalue.value.u8 = neu_value8_get_bit(u8, offset % 8);
-                }
-                break;
-            }
-            }
-
             dvalue.type = (*p_tag)->type;
-            switch ((*p_tag)->type) {
-            case NEU_TYPE_UINT16:
-            case NEU_TYPE_INT16:
-                dvalue.value.u16 = ntohs(dvalue.value.u16);
-                break;
-            case NEU_TYPE_FLOAT:
-            case NEU_TYPE_INT32:
-            case NEU_TYPE_UINT32:
-                if ((*p_tag)->option.value32.is_default) {
-                    modbus_convert_endianess(&dvalue.value, plugin->endianess);
-                }
-                dvalue.value.u32 = ntohl(dvalue.value.u32);
-                break;
-            case NEU_TYPE_DOUBLE:
-            case NEU_TYPE_INT64:
-            case NEU_TYPE_UINT64:
-                dvalue.value.u64 = neu_ntohll(dvalue.value.u64);
-                break;
-            case NEU_TYPE_BIT: {
-                switch ((*p_tag)->area) {
-                case MODBUS_AREA_HOLD_REGISTER:
-                case MODBUS_AREA_INPUT_REGISTER: {
-                    neu_value16_u v16 = { 0 };
-                    v16.value = htons(*(uint16_t *) dvalue.value.bytes.bytes);
-                    memset(&dvalue.value, 0, sizeof(dvalue.value));
-                    dvalue.value.u8 =
-                        neu_value16_get_bit(v16, (*p_tag)->option.bit.bit);
-                    break;
-                }
-                case MODBUS_AREA_COIL:
-                case MODBUS_AREA_INPUT:
-                    break;
-                }
-                break;
-            }
-            case NEU_TYPE_STRING: {
-                switch ((*p_tag)->option.string.type) {
-                case NEU_DATATAG_STRING_TYPE_H:
-                    break;
-                case NEU_DATATAG_STRING_TYPE_L:
-                    neu_datatag_string_ltoh(dvalue.value.str,
-                                            strlen(dvalue.value.str));
-                    break;
-                case NEU_DATATAG_STRING_TYPE_D:
-                    break;
-                case NEU_DATATAG_STRING_TYPE_E:
-                    break;
-                }
-
-                if (!neu_datatag_string_is_utf8(dvalue.value.str,
-                                                strlen(dvalue.value.str))) {
-                    dvalue.value.str[0] = '?';
-                    dvalue.value.str[1] = 0;
-                }
-                break;
-            }
-            default:
-                break;
-            }
+            modbus_decode_point(*p_tag, start_address, plugin->endianess, bytes,
+                                n_byte, &dvalue.value);
         }
 
         if (trace) {
             plugin->common.adapter_callbacks->driver.update_with_trace(
                 plugin->common.adapter, gd->group, (*p_tag)->name, dvalue, NULL,
                 0, trace);
-        } else {
-            plugin->common.adapter_callbacks->driver.update(
-                plugin->common.adapter, gd->group, (*p_tag)->name, dvalue);
+            continue;
+        }
+
+        updates[n_update].tag       = (*p_tag)->name;
+        updates[n_update].value     = dvalue;
+        updates[n_update].metas     = NULL;
+        updates[n_update].n_meta    = 0;
+        updates[n_update].timestamp = 0;
+        if (++n_update == MODBUS_UPDATE_BATCH) {
+            modbus_update_batch(plugin, gd, updates, n_update);
+            n_update = 0;
         }
     }
+    modbus_update_batch(plugin, gd, updates, n_update);
     return 0;
 }
 
@@ -676,10 +953,12 @@ int modbus_test_read_tag(neu_plugin_t *plugin, void *req, neu_datatag_t tag)
     }
 
     uint16_t response_size = 0;
-    int      ret = modbus_stack_read(plugin->stack, point.slave_id, point.area,
+    neu_conn_bus_acquire(plugin->conn, NEU_CONN_BUS_PRIO_HIGH, 0);
+    int ret = modbus_stack_read(plugin->stack, point.slave_id, point.area,
                                 point.start_address, point.n_register,
                                 &response_size, true);
     if (ret <= 0) {
+        neu_conn_bus_release(plugin->conn);
         plugin->common.adapter_callbacks->driver.test_read_tag_response(
             plugin->common.adapter, req, NEU_JSON_INT, NEU_TYPE_ERROR,
             error_value, NEU_ERR_PLUGIN_READ_FAILURE);
@@ -687,6 +966,7 @@ int modbus_test_read_tag(neu_plugin_t *plugin, void *req, neu_datatag_t tag)
     }
 
     ret = process_protocol_buf_test(plugin, req, &point, response_size);
+    neu_conn_bus_release(plugin->conn);
     if (ret == 0) {
         plugin->common.adapter_callbacks->driver.test_read_tag_response(
             plugin->common.adapter, req, NEU_JSON_INT, NEU_TYPE_ERROR,
@@ -765,13 +1045,16 @@ static int write_modbus_point(neu_plugin_t *plugin, void *req,
                               uint8_t n_byte)
 {
     uint16_t response_size = 0;
-    int      ret           = modbus_stack_write(
-        plugin->stack, req, point->slave_id, point->area, point->start_address,
-        point->n_register, value.bytes.bytes, n_byte, &response_size, true);
+    int      ret           = 0;
 
+    neu_conn_bus_acquire(plugin->conn, NEU_CONN_BUS_PRIO_HIGH, 0);
+    ret = modbus_stack_write(plugin->stack, req, point->slave_id, point->area,
+                             point->start_address, point->n_register,
+                             value.bytes.bytes, n_byte, &response_size, true);
     if (ret > 0) {
         process_protocol_buf(plugin, point->slave_id, response_size);
     }
+    neu_conn_bus_release(plugin->conn);
 
     return ret;
 }
@@ -780,15 +1063,17 @@ static int write_modbus_points(neu_plugin_t *      plugin,
                                modbus_write_cmd_t *write_cmd, void *req)
 {
     uint16_t response_size = 0;
+    int      ret           = 0;
 
-    int ret = modbus_stack_write(plugin->stack, req, write_cmd->slave_id,
-                                 write_cmd->area, write_cmd->start_address,
-                                 write_cmd->n_register, write_cmd->bytes,
-                                 write_cmd->n_byte, &response_size, false);
-
+    neu_conn_bus_acquire(plugin->conn, NEU_CONN_BUS_PRIO_HIGH, 0);
+    ret = modbus_stack_write(plugin->stack, req, write_cmd->slave_id,
+                             write_cmd->area, write_cmd->start_address,
+                             write_cmd->n_register, write_cmd->bytes,
+                             write_cmd->n_byte, &response_size, false);
     if (ret > 0) {
         process_protocol_buf(plugin, write_cmd->slave_id, response_size);
     }
+    neu_conn_bus_release(plugin->conn);
 
     return ret;
 }
@@ -869,27 +1154,37 @@ static void plugin_group_free(neu_plugin_group_t *pgp)
 {
     struct modbus_group_data *gd = (struct modbus_group_data *) pgp->user_data;
 
-    modbus_tag_sort_free(gd->cmd_sort);
-
-    utarray_foreach(gd->tags, modbus_point_t **, tag) { free(*tag); }
-
-    utarray_free(gd->tags);
+    modbus_plan_free(gd->plan);
     free(gd->group);
 
     free(gd);
 }
 
-static ssize_t recv_data(neu_plugin_t *plugin, uint8_t *buffer, size_t size)
+static int plugin_group_change(neu_plugin_group_t *pgp, UT_array *tags)
+{
+    struct modbus_group_data *gd = (struct modbus_group_data *) pgp->user_data;
+
+    if (strcmp(gd->group, pgp->group_name) != 0) {
+        free(gd->group);
+        gd->group = strdup(pgp->group_name);
+    }
+
+    plan_update(gd->plugin, gd, tags);
+    return 0;
+}
+
+static ssize_t recv_data(neu_plugin_t *plugin, neu_conn_t *conn,
+                         uint8_t *buffer, size_t size)
 {
     if (plugin->is_server) {
-        return neu_conn_tcp_server_recv(plugin->conn, plugin->client_fd, buffer,
-                                        size);
+        return neu_conn_tcp_server_recv(conn, plugin->client_fd, buffer, size);
     } else {
-        return neu_conn_recv(plugin->conn, buffer, size);
+        return neu_conn_recv(conn, buffer, size);
     }
 }
 
-static int process_received_data(neu_plugin_t *plugin, uint8_t *recv_buf,
+static int process_received_data(neu_plugin_t *  plugin,
+                                 modbus_stack_t *stack, uint8_t *recv_buf,
                                  ssize_t recv_size, uint16_t expected_size,
                                  uint8_t slave_id)
 {
@@ -898,7 +1193,7 @@ static int process_received_data(neu_plugin_t *plugin, uint8_t *recv_buf,
     }
     neu_protocol_unpack_buf_t pbuf = { 0 };
     neu_protocol_unpack_buf_init(&pbuf, recv_buf, recv_size);
-    int ret = modbus_stack_recv(plugin->stack, slave_id, &pbuf);
+    int ret = modbus_stack_recv(stack, slave_id, &pbuf);
     if (ret == MODBUS_DEVICE_ERR) {
         return -2;
     }
@@ -921,10 +1216,11 @@ static int process_received_data_test(neu_plugin_t *plugin, uint8_t *recv_buf,
     return recv_size == expected_size ? ret : -1;
 }
 
-static int valid_modbus_tcp_response(neu_plugin_t *plugin, uint8_t *recv_buf,
-                                     uint16_t response_size)
+static int valid_modbus_tcp_response(neu_plugin_t *plugin, neu_conn_t *conn,
+                                     uint8_t *recv_buf, uint16_t response_size)
 {
-    ssize_t ret = recv_data(plugin, recv_buf, sizeof(struct modbus_header));
+    ssize_t ret =
+        recv_data(plugin, conn, recv_buf, sizeof(struct modbus_header));
     if (ret <= 0) {
         return 0;
     }
@@ -939,7 +1235,7 @@ static int valid_modbus_tcp_response(neu_plugin_t *plugin, uint8_t *recv_buf,
         return -1;
     }
 
-    ret = recv_data(plugin, recv_buf + sizeof(struct modbus_header),
+    ret = recv_data(plugin, conn, recv_buf + sizeof(struct modbus_header),
                     htons(header->len));
 
     return ret == htons(header->len)
@@ -947,12 +1243,14 @@ static int valid_modbus_tcp_response(neu_plugin_t *plugin, uint8_t *recv_buf,
         : (ssize_t) -1;
 }
 
-static int process_modbus_tcp(neu_plugin_t *plugin, uint8_t *recv_buf,
+static int process_modbus_tcp(neu_plugin_t *plugin, neu_conn_t *conn,
+                              modbus_stack_t *stack, uint8_t *recv_buf,
                               uint16_t response_size, uint8_t slave_id)
 {
-    int total_recv = valid_modbus_tcp_response(plugin, recv_buf, response_size);
+    int total_recv =
+        valid_modbus_tcp_response(plugin, conn, recv_buf, response_size);
     if (total_recv > 0) {
-        return process_received_data(plugin, recv_buf, total_recv,
+        return process_received_data(plugin, stack, recv_buf, total_recv,
                                      response_size, slave_id);
     }
     return total_recv;
@@ -962,7 +1260,8 @@ static int process_modbus_tcp_test(neu_plugin_t *plugin, uint8_t *recv_buf,
                                    uint16_t response_size, void *req,
                                    modbus_point_t *point)
 {
-    int total_recv = valid_modbus_tcp_response(plugin, recv_buf, response_size);
+    int total_recv = valid_modbus_tcp_response(plugin, plugin->conn, recv_buf,
+                                               response_size);
     if (total_recv > 0) {
         return process_received_data_test(plugin, recv_buf, total_recv,
                                           response_size, req, point);
@@ -973,30 +1272,46 @@ static int process_modbus_tcp_test(neu_plugin_t *plugin, uint8_t *recv_buf,
 static int process_modbus_rtu(neu_plugin_t *plugin, uint8_t *recv_buf,
                               uint16_t response_size, uint8_t slave_id)
 {
-    ssize_t ret = recv_data(plugin, recv_buf, response_size);
+    ssize_t ret = recv_data(plugin, plugin->conn, recv_buf, response_size);
     if (ret == 0 || ret == -1) {
         return 0;
     }
-    return process_received_data(plugin, recv_buf, ret, response_size,
-                                 slave_id);
+    return process_received_data(plugin, plugin->stack, recv_buf, ret,
+                                 response_size, slave_id);
 }
 
 static int process_protocol_buf(neu_plugin_t *plugin, uint8_t slave_id,
                                 uint16_t response_size)
 {
-    uint8_t *recv_buf = (uint8_t *) calloc(response_size, 1);
+    uint8_t *recv_buf = modbus_stack_recv_buf_get(plugin->stack, response_size);
     if (!recv_buf) {
         return -1;
     }
 
     int ret = 0;
     if (plugin->protocol == MODBUS_PROTOCOL_TCP) {
-        ret = process_modbus_tcp(plugin, recv_buf, response_size, slave_id);
+        ret = process_modbus_tcp(plugin, plugin->conn, plugin->stack, recv_buf,
+                                 response_size, slave_id);
     } else if (plugin->protocol == MODBUS_PROTOCOL_RTU) {
         ret = process_modbus_rtu(plugin, recv_buf, response_size, slave_id);
     }
 
-    free(recv_buf);
+    modbus_stack_recv_buf_put(plugin->stack, recv_buf);
+    return ret;
+}
+
+static int process_pool_buf(neu_plugin_t *plugin, modbus_pool_conn_t *pc,
+                            uint8_t slave_id)
+{
+    uint8_t *recv_buf = modbus_stack_recv_buf_get(pc->stack, pc->response_size);
+    if (!recv_buf) {
+        return -1;
+    }
+
+    int ret = process_modbus_tcp(plugin, pc->conn, pc->stack, recv_buf,
+                                 pc->response_size, slave_id);
+
+    modbus_stack_recv_buf_put(pc->stack, recv_buf);
     return ret;
 }
 
@@ -1004,7 +1319,7 @@ static int process_protocol_buf_test(neu_plugin_t *plugin, void *req,
                                      modbus_point_t *point,
                                      uint16_t        response_size)
 {
-    uint8_t *recv_buf = (uint8_t *) calloc(response_size, 1);
+    uint8_t *recv_buf = modbus_stack_recv_buf_get(plugin->stack, response_size);
     if (!recv_buf) {
         return -1;
     }
@@ -1015,6 +1330,6 @@ static int process_protocol_buf_test(neu_plugin_t *plugin, void *req,
                                       point);
     }
 
-    free(recv_buf);
+    modbus_stack_recv_buf_put(plugin->stack, recv_buf);
     return ret;
 }
\ No newline at end of file
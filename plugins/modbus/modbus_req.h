@@ -21,6 +21,7 @@
 
 #include <neuron.h>
 
+#include "modbus_pool.h"
 #include "modbus_stack.h"
 
 struct neu_plugin {
@@ -55,6 +56,12 @@ struct neu_plugin {
     bool             first_attempt_done;
     neu_conn_param_t param;
     neu_conn_param_t param_backup;
+
+    // tcp client only, slot 0 mirrors conn and stack
+    modbus_pool_t       pool;
+    modbus_pool_conn_t *pool_cur; // sending a pooled group read
+
+    neu_histogram_t *plan_build;
 };
 
 void modbus_conn_connected(void *data, int fd);
@@ -64,6 +71,11 @@ void modbus_tcp_server_stop(void *data, int fd);
 int  modbus_tcp_server_io_callback(enum neu_event_io_type type, int fd,
                                    void *usr_data);
 
+int  modbus_pool_config(neu_plugin_t *plugin, uint8_t n_conn);
+void modbus_pool_start(neu_plugin_t *plugin);
+void modbus_pool_stop(neu_plugin_t *plugin);
+void modbus_pool_free(neu_plugin_t *plugin);
+
 int modbus_group_timer(neu_plugin_t *plugin, neu_plugin_group_t *group,
                        uint16_t max_byte);
 int modbus_send_msg(void *ctx, uint16_t n_byte, uint8_t *bytes);
@@ -112,6 +112,11 @@ static int driver_init(neu_plugin_t *plugin, bool load)
                                         modbus_send_msg, modbus_value_handle,
                                         modbus_write_resp);
 
+    NEU_PLUGIN_REGISTER_METRIC(plugin, NEU_METRIC_READ_PLAN_BUILD_US, 0);
+    NEU_PLUGIN_REGISTER_METRIC(plugin, NEU_METRIC_BUS_UTILIZATION, 0);
+    plugin->plan_build =
+        NEU_PLUGIN_METRIC_HISTOGRAM(plugin, NEU_METRIC_READ_PLAN_BUILD_US);
+
     plog_notice(plugin, "%s init success", plugin->common.name);
     return 0;
 }
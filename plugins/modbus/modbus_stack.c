@@ -38,6 +38,8 @@ struct modbus_stack {
     uint8_t *buf;
     uint16_t buf_size;
 
+    neu_buf_pool_t *recv_pool;
+
     int64_t sample_mod;
 };
 
@@ -57,15 +59,28 @@ modbus_stack_t *modbus_stack_create(void *ctx, modbus_protocol_e protocol,
     stack->buf_size = 256;
     stack->buf      = calloc(stack->buf_size, 1);
 
+    stack->recv_pool = neu_buf_pool_new(MODBUS_RECV_BUF_N, MODBUS_MAX_ADU);
+
     return stack;
 }
 
 void modbus_stack_destroy(modbus_stack_t *stack)
 {
+    neu_buf_pool_free(stack->recv_pool);
     free(stack->buf);
     free(stack);
 }
 
+uint8_t *modbus_stack_recv_buf_get(modbus_stack_t *stack, uint16_t size)
+{
+    return neu_buf_pool_get(stack->recv_pool, size);
+}
+
+void modbus_stack_recv_buf_put(modbus_stack_t *stack, uint8_t *buf)
+{
+    neu_buf_pool_put(stack->recv_pool, buf);
+}
+
 int modbus_stack_recv(modbus_stack_t *stack, uint8_t slave_id,
                       neu_protocol_unpack_buf_t *buf)
 {
@@ -23,9 +23,16 @@
 
 #include <neuron.h>
 
+#include "utils/buf_pool.h"
+
 #include "modbus.h"
 #include "modbus_point.h"
 
+// mbap header plus the largest pdu
+#define MODBUS_MAX_ADU 260
+// receive buffers kept by each stack, covers concurrent read, write and test
+#define MODBUS_RECV_BUF_N 4
+
 typedef struct modbus_stack modbus_stack_t;
 
 typedef int (*modbus_stack_send)(void *ctx, uint16_t n_byte, uint8_t *bytes);
@@ -59,4 +66,11 @@ int  modbus_stack_write(modbus_stack_t *stack, void *req, uint8_t slave_id,
                         uint16_t *response_size, bool response);
 bool modbus_stack_is_rtu(modbus_stack_t *stack);
 
+/*
+ * Receive buffers are reused across requests, only responses larger than
+ * MODBUS_MAX_ADU or more than MODBUS_RECV_BUF_N concurrent receives allocate.
+ */
+uint8_t *modbus_stack_recv_buf_get(modbus_stack_t *stack, uint16_t size);
+void     modbus_stack_recv_buf_put(modbus_stack_t *stack, uint8_t *buf);
+
 #endif
\ No newline at end of file
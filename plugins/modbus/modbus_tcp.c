@@ -115,6 +115,10 @@ static int driver_init(neu_plugin_t *plugin, bool load)
                                         modbus_send_msg, modbus_value_handle,
                                         modbus_write_resp);
 
+    NEU_PLUGIN_REGISTER_METRIC(plugin, NEU_METRIC_READ_PLAN_BUILD_US, 0);
+    plugin->plan_build =
+        NEU_PLUGIN_METRIC_HISTOGRAM(plugin, NEU_METRIC_READ_PLAN_BUILD_US);
+
     plog_notice(plugin, "%s init success", plugin->common.name);
     return 0;
 }
@@ -122,6 +126,7 @@ static int driver_init(neu_plugin_t *plugin, bool load)
 static int driver_uninit(neu_plugin_t *plugin)
 {
     plog_notice(plugin, "%s uninit start", plugin->common.name);
+    modbus_pool_free(plugin);
     if (plugin->conn != NULL) {
         neu_conn_destory(plugin->conn);
     }
@@ -151,6 +156,7 @@ static int driver_uninit(neu_plugin_t *plugin)
 static int driver_start(neu_plugin_t *plugin)
 {
     neu_conn_start(plugin->conn);
+    modbus_pool_start(plugin);
     plog_notice(plugin, "%s start success", plugin->common.name);
     return 0;
 }
@@ -158,6 +164,7 @@ static int driver_start(neu_plugin_t *plugin)
 static int driver_stop(neu_plugin_t *plugin)
 {
     neu_conn_stop(plugin->conn);
+    modbus_pool_stop(plugin);
     plog_notice(plugin, "%s stop success", plugin->common.name);
     return 0;
 }
@@ -197,6 +204,8 @@ static int driver_config(neu_plugin_t *plugin, const char *config)
     neu_json_elem_t  backup_port = { .name = "backup_port", .t = NEU_JSON_INT };
     neu_conn_param_t param_backup = { 0 };
     bool             backup       = false;
+    neu_json_elem_t  connections  = { .name = "connections",
+                                    .t    = NEU_JSON_INT };
 
     ret = neu_parse_param((char *) config, &err_param, 5, &port, &host, &mode,
                           &timeout, &interval);
@@ -260,6 +269,12 @@ static int driver_config(neu_plugin_t *plugin, const char *config)
         backup = true;
     }
 
+    ret = neu_parse_param((char *) config, &err_param, 1, &connections);
+    if (ret != 0) {
+        free(err_param);
+        connections.v.val_int = 1;
+    }
+
     param.log              = plugin->common.log;
     param_backup.log       = plugin->common.log;
     plugin->interval       = interval.v.val_int;
@@ -333,6 +348,7 @@ static int driver_config(neu_plugin_t *plugin, const char *config)
             neu_conn_new(&param, (void *) plugin, modbus_conn_connected,
                          modbus_conn_disconnected);
     }
+    modbus_pool_config(plugin, connections.v.val_int);
 
     if (host.v.val_str != NULL) {
         free(host.v.val_str);
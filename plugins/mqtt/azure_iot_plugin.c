@@ -169,6 +169,7 @@ static int azure_parse_config(neu_plugin_t *plugin, const char *setting,
     config->client_id           = client_id.v.val_str;
     config->qos                 = qos.v.val_int;
     config->format              = format.v.val_int;
+    config->connections         = 1;
     config->write_req_topic     = write_req_topic;
     config->write_resp_topic    = write_resp_topic;
     config->cache               = false;
@@ -284,10 +285,24 @@ static neu_plugin_t *azure_plugin_open(void)
     return plugin;
 }
 
+static int azure_upload_encode(neu_reqresp_trans_data_t *data, void *arg,
+                               char **bytes)
+{
+    neu_plugin_t *plugin = (neu_plugin_t *) arg;
+    int64_t       start  = neu_time_us();
+
+    *bytes = generate_upload_json(plugin, data, plugin->config.format, NULL, 0,
+                                  NULL, 0, NULL);
+    NEU_PLUGIN_UPDATE_METRIC(plugin, NEU_METRIC_ENCODE_US,
+                             neu_time_us() - start, NULL);
+    return NULL == *bytes ? NEU_ERR_EINTERNAL : 0;
+}
+
 static int azure_handle_trans_data(neu_plugin_t *            plugin,
                                    neu_reqresp_trans_data_t *trans_data)
 {
-    int rv = 0;
+    int  rv      = 0;
+    char key[32] = { 0 };
 
     if (NULL == plugin->client) {
         return NEU_ERR_MQTT_IS_NULL;
@@ -299,10 +314,20 @@ static int azure_handle_trans_data(neu_plugin_t *            plugin,
         return NEU_ERR_MQTT_FAILURE;
     }
 
-    char *json_str = generate_upload_json(
-        plugin, trans_data, plugin->config.format, NULL, 0, NULL, 0, NULL);
-    if (NULL == json_str) {
+    // shared with the other azure apps using the same format
+    snprintf(key, sizeof(key), "azure/%d", plugin->config.format);
+
+    const char *payload = NULL;
+    rv = neu_trans_data_encode(trans_data, key, azure_upload_encode, plugin,
+                               &payload);
+    if (0 != rv) {
         plog_error(plugin, "generate upload json fail");
+        return rv;
+    }
+
+    // publish takes the payload over
+    char *json_str = strdup(payload);
+    if (NULL == json_str) {
         return NEU_ERR_EINTERNAL;
     }
 
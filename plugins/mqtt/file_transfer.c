@@ -0,0 +1,185 @@
+/**
+ * NEURON IIoT System for Industry 4.0
+ * Copyright (C) 2020-2022 EMQ Technologies Co., Ltd All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ **/
+
+
+#include <arpa/inet.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "file_transfer.h"
+
+mqtt_fup_t *mqtt_fup_add(mqtt_fup_t **tbl, const char *uuid,
+                         const char *driver, const char *path,
+                         uint16_t window, int64_t resume, bool binary)
+{
+    mqtt_fup_t *fup = mqtt_fup_find(tbl, uuid);
+
+    if (NULL != fup) {
+        return NULL;
+    }
+
+    fup = calloc(1, sizeof(mqtt_fup_t));
+    if (NULL == fup) {
+        return NULL;
+    }
+
+    fup->uuid   = strdup(uuid);
+    fup->window = window > MQTT_FUP_WINDOW_MAX ? MQTT_FUP_WINDOW_MAX : window;
+    fup->binary = binary;
+    fup->resume = resume > 0 ? resume : 0;
+    fup->offset = fup->resume;
+    strncpy(fup->driver, driver, sizeof(fup->driver) - 1);
+    strncpy(fup->path, path, sizeof(fup->path) - 1);
+
+    HASH_ADD_KEYPTR(hh, *tbl, fup->uuid, strlen(fup->uuid), fup);
+    return fup;
+}
+
+mqtt_fup_t *mqtt_fup_find(mqtt_fup_t **tbl, const char *uuid)
+{
+    mqtt_fup_t *fup = NULL;
+
+    HASH_FIND_STR(*tbl, uuid, fup);
+    return fup;
+}
+
+void mqtt_fup_del(mqtt_fup_t **tbl, mqtt_fup_t *fup)
+{
+    HASH_DEL(*tbl, fup);
+    free(fup->uuid);
+    free(fup);
+}
+
+void mqtt_fup_free(mqtt_fup_t **tbl)
+{
+    mqtt_fup_t *fup = NULL, *tmp = NULL;
+
+    HASH_ITER(hh, *tbl, fup, tmp)
+    {
+        mqtt_fup_del(tbl, fup);
+    }
+}
+
+void mqtt_fup_open(mqtt_fup_t *fup, int64_t now_ms)
+{
+    fup->opened   = true;
+    fup->start_ms = now_ms;
+}
+
+int mqtt_fup_next(mqtt_fup_t *fup, neu_req_fup_data_t *cmd)
+{
+    if (!fup->opened || fup->last_seq > 0 || fup->inflight >= fup->window) {
+        return -1;
+    }
+
+    memset(cmd, 0, sizeof(*cmd));
+    strcpy(cmd->driver, fup->driver);
+    strcpy(cmd->path, fup->path);
+    cmd->seq = ++fup->next_seq;
+    // only the first chunk seeks, the others follow on
+    if (1 == cmd->seq) {
+        cmd->offset = fup->resume;
+    }
+
+    fup->inflight += 1;
+    return 0;
+}
+
+int mqtt_fup_recv(mqtt_fup_t *fup, neu_resp_fup_data_t *data, int64_t *offset)
+{
+    if (fup->inflight > 0) {
+        fup->inflight -= 1;
+    }
+
+    // requests sent ahead of the end of the file, or of a failed chunk
+    if (fup->last_seq > 0) {
+        return -1;
+    }
+
+    // the offsets only add up in order, give up on the transfer
+    if (data->seq != fup->recv_seq + 1) {
+        data->seq   = fup->recv_seq + 1;
+        data->error = NEU_ERR_PLUGIN_PACKET_OUT_OF_ORDER;
+        data->more  = false;
+        data->len   = 0;
+    }
+
+    *offset       = fup->offset;
+    fup->recv_seq = data->seq;
+    if (0 == data->error) {
+        fup->offset += data->len;
+        fup->n_byte += data->len;
+    }
+    if (0 != data->error || !data->more) {
+        fup->last_seq = data->seq;
+    }
+
+    return 0;
+}
+
+bool mqtt_fup_done(const mqtt_fup_t *fup)
+{
+    return fup->last_seq > 0 && 0 == fup->inflight;
+}
+
+uint64_t mqtt_fup_rate(const mqtt_fup_t *fup, int64_t now_ms)
+{
+    int64_t elapsed = now_ms - fup->start_ms;
+
+    if (elapsed <= 0) {
+        elapsed = 1;
+    }
+
+    return fup->n_byte * 1000 / elapsed;
+}
+
+static void put_u32(uint8_t *buf, uint32_t v)
+{
+    v = htonl(v);
+    memcpy(buf, &v, sizeof(v));
+}
+
+uint8_t *mqtt_fup_frame(const mqtt_fup_t *fup, const neu_resp_fup_data_t *data,
+                        int64_t offset, size_t *len)
+{
+    uint16_t uuid_len = strlen(fup->uuid);
+    uint8_t *buf      = NULL;
+
+    *len = MQTT_FUP_FRAME_HEADER_LEN + uuid_len + data->len;
+    buf  = calloc(1, *len);
+    if (NULL == buf) {
+        return NULL;
+    }
+
+    memcpy(buf, MQTT_FUP_FRAME_MAGIC, 4);
+    buf[4] = MQTT_FUP_FRAME_VERSION;
+    buf[5] = data->more ? MQTT_FUP_FRAME_MORE : 0;
+    buf[6] = uuid_len >> 8;
+    buf[7] = uuid_len & 0xFF;
+    put_u32(&buf[8], data->seq);
+    put_u32(&buf[12], (uint64_t) offset >> 32);
+    put_u32(&buf[16], (uint64_t) offset & 0xFFFFFFFF);
+    memcpy(&buf[MQTT_FUP_FRAME_HEADER_LEN], fup->uuid, uuid_len);
+    if (data->len > 0) {
+        memcpy(&buf[MQTT_FUP_FRAME_HEADER_LEN + uuid_len], data->data,
+               data->len);
+    }
+
+    return buf;
+}
@@ -0,0 +1,104 @@
+/**
+ * NEURON IIoT System for Industry 4.0
+ * Copyright (C) 2020-2022 EMQ Technologies Co., Ltd All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ **/
+
+#ifndef NEURON_PLUGIN_MQTT_FILE_TRANSFER_H
+#define NEURON_PLUGIN_MQTT_FILE_TRANSFER_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "json/neu_json_driver.h"
+#include "msg.h"
+#include "utils/uthash.h"
+
+#define MQTT_FUP_WINDOW_MAX NEU_JSON_FUP_WINDOW_MAX
+
+// binary chunk: header in network byte order, then the uuid, then the data
+#define MQTT_FUP_FRAME_MAGIC "NFUP"
+#define MQTT_FUP_FRAME_VERSION 1
+#define MQTT_FUP_FRAME_MORE 0x01
+#define MQTT_FUP_FRAME_HEADER_LEN 20
+
+/** Windowed file upload.
+ *
+ * Opened with a window, the plugin keeps up to `window` chunk requests
+ * outstanding at the driver and publishes every chunk as it arrives, instead
+ * of waiting for the client to ask for the next one. Chunks are numbered from
+ * 1 and answered in request order, so the offset of each chunk is the sum of
+ * the lengths before it. In binary mode chunks are published as frames,
+ * failed chunks are still published as json.
+ *
+ * Not thread safe, the caller serializes access to the table.
+ */
+typedef struct mqtt_fup {
+    char *   uuid; // of the open request, identifies the transfer
+    char     driver[NEU_NODE_NAME_LEN];
+    char     path[NEU_PATH_LEN];
+    uint16_t window;
+    bool     binary; // publish raw chunks instead of json
+    int64_t  resume; // offset of the first chunk
+
+    bool     opened;
+    uint16_t inflight;
+    uint32_t next_seq; // of the next chunk request
+    uint32_t recv_seq; // of the last chunk received
+    uint32_t last_seq; // of the final chunk, 0 until known
+    int64_t  offset;   // of the next chunk received
+
+    uint64_t n_byte;
+    int64_t  start_ms;
+
+    UT_hash_handle hh;
+} mqtt_fup_t;
+
+mqtt_fup_t *mqtt_fup_add(mqtt_fup_t **tbl, const char *uuid,
+                         const char *driver, const char *path,
+                         uint16_t window, int64_t resume, bool binary);
+mqtt_fup_t *mqtt_fup_find(mqtt_fup_t **tbl, const char *uuid);
+void        mqtt_fup_del(mqtt_fup_t **tbl, mqtt_fup_t *fup);
+void        mqtt_fup_free(mqtt_fup_t **tbl);
+
+// the driver opened the file, start counting
+void mqtt_fup_open(mqtt_fup_t *fup, int64_t now_ms);
+// fill in the next chunk request, -1 when the window is full or the last
+// chunk is already known
+int mqtt_fup_next(mqtt_fup_t *fup, neu_req_fup_data_t *cmd);
+// account one chunk response, returns -1 for responses past the final chunk
+// which are dropped, otherwise the offset of the chunk is set. A chunk out of
+// sequence is turned into a NEU_ERR_PLUGIN_PACKET_OUT_OF_ORDER error of the
+// expected one, which ends the transfer
+int mqtt_fup_recv(mqtt_fup_t *fup, neu_resp_fup_data_t *data, int64_t *offset);
+// the final chunk is received and no request is outstanding
+bool mqtt_fup_done(const mqtt_fup_t *fup);
+// bytes per second since the open
+uint64_t mqtt_fup_rate(const mqtt_fup_t *fup, int64_t now_ms);
+
+// binary chunk frame, the caller frees the returned buffer
+uint8_t *mqtt_fup_frame(const mqtt_fup_t *fup, const neu_resp_fup_data_t *data,
+                        int64_t offset, size_t *len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
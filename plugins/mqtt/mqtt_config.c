@@ -262,6 +262,12 @@ int mqtt_config_parse(neu_plugin_t *plugin, const char *setting,
         .v.val_int = NEU_MQTT_QOS0,               // default to QoS0
         .attribute = NEU_JSON_ATTRIBUTE_OPTIONAL, // for backward compatibility
     };
+    neu_json_elem_t connections = {
+        .name      = "connections",
+        .t         = NEU_JSON_INT,
+        .v.val_int = 1,
+        .attribute = NEU_JSON_ATTRIBUTE_OPTIONAL,
+    };
     neu_json_elem_t format          = { .name = "format", .t = NEU_JSON_INT };
     neu_json_elem_t write_req_topic = {
         .name      = "write-req-topic",
@@ -346,6 +352,15 @@ int mqtt_config_parse(neu_plugin_t *plugin, const char *setting,
         goto error;
     }
 
+    // connections, optional, default to 1
+    ret = neu_parse_param(setting, NULL, 1, &connections);
+    if (0 != ret || connections.v.val_int < 1 ||
+        MQTT_CONNECTIONS_MAX < connections.v.val_int) {
+        plog_error(plugin, "setting invalid connections: %" PRIi64,
+                   connections.v.val_int);
+        goto error;
+    }
+
     // format, required
     if (MQTT_UPLOAD_FORMAT_VALUES != format.v.val_int &&
         MQTT_UPLOAD_FORMAT_TAGS != format.v.val_int &&
@@ -455,6 +470,7 @@ int mqtt_config_parse(neu_plugin_t *plugin, const char *setting,
     config->client_id           = client_id.v.val_str;
     config->qos                 = qos.v.val_int;
     config->format              = format.v.val_int;
+    config->connections         = connections.v.val_int;
     config->write_req_topic     = write_req_topic.v.val_str;
     config->write_resp_topic    = write_resp_topic.v.val_str;
     config->cache               = offline_cache.v.val_bool;
@@ -482,6 +498,8 @@ int mqtt_config_parse(neu_plugin_t *plugin, const char *setting,
     plog_notice(plugin, "config qos             : %d", config->qos);
     plog_notice(plugin, "config format          : %s",
                 mqtt_upload_format_str(config->format));
+    plog_notice(plugin, "config connections     : %" PRIu8,
+                config->connections);
     plog_notice(plugin, "config write-req-topic : %s", config->write_req_topic);
     plog_notice(plugin, "config write-resp-topic: %s",
                 config->write_resp_topic);
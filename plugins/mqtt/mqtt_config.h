@@ -70,6 +70,9 @@ static inline const char *mqtt_upload_format_str(mqtt_upload_format_e f)
 #define FILE_DOWN_DATA_REQ_TOPIC "fdowndata/req"
 #define FILE_DOWN_DATA_RESP_TOPIC "fdowndata/resp"
 
+// maximum number of parallel broker connections used for publishing
+#define MQTT_CONNECTIONS_MAX 8
+
 typedef struct {
     char action_req[256];
     char action_resp[256];
@@ -95,6 +98,7 @@ typedef struct {
     char *               client_id;        // client id
     neu_mqtt_qos_e       qos;              // message QoS
     mqtt_upload_format_e format;           // upload format
+    uint8_t              connections;      // number of broker connections
     char *               write_req_topic;  // write request topic
     char *               write_resp_topic; // write response topic
 
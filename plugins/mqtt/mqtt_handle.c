@@ -18,6 +18,7 @@
  **/
 
 #include "connection/mqtt_client.h"
+#include "driver_registry.h"
 #include "errcodes.h"
 #include "otel/otel_manager.h"
 #include "utils/asprintf.h"
@@ -75,25 +76,22 @@ static int tag_values_to_json(UT_array *tags, mqtt_static_vt_t *s_tags,
     return 0;
 }
 
-void filter_error_tags(neu_reqresp_trans_data_t *data)
+// the tags are shared by all the apps the data is sent to, so the values
+// without errors are copied, not filtered in place
+static UT_array *filter_error_tags(UT_array *tags)
 {
-    if (!data || !data->tags) {
-        return;
-    }
-
     UT_array *filtered_tags;
     utarray_new(filtered_tags, neu_resp_tag_value_meta_icd());
 
     neu_resp_tag_value_meta_t *tag_ptr = NULL;
-    while ((tag_ptr = (neu_resp_tag_value_meta_t *) utarray_next(data->tags,
+    while ((tag_ptr = (neu_resp_tag_value_meta_t *) utarray_next(tags,
                                                                  tag_ptr))) {
         if (tag_ptr->value.type != NEU_TYPE_ERROR) {
             utarray_push_back(filtered_tags, tag_ptr);
         }
     }
 
-    utarray_free(data->tags);
-    data->tags = filtered_tags;
+    return filtered_tags;
 }
 
 char *generate_upload_json(neu_plugin_t *plugin, neu_reqresp_trans_data_t *data,
@@ -106,26 +104,30 @@ char *generate_upload_json(neu_plugin_t *plugin, neu_reqresp_trans_data_t *data,
                                         .node      = (char *) data->driver,
                                         .timestamp = global_timestamp };
     neu_json_read_resp_t     json     = { 0 };
+    UT_array *               tags     = data->tags;
+    int                      rv       = 0;
 
     if (!plugin->config.upload_err && skip != NULL) {
-        filter_error_tags(data);
+        tags = filter_error_tags(data->tags);
 
-        if (utarray_len(data->tags) == 0) {
+        if (utarray_len(tags) == 0) {
+            utarray_free(tags);
             *skip = true;
             return NULL;
         }
     }
 
     if (format == MQTT_UPLOAD_FORMAT_CUSTOM) {
-        if (0 != tag_values_to_json(data->tags, NULL, 0, &json)) {
-            plog_error(plugin, "tag_values_to_json fail");
-            return NULL;
-        }
+        rv = tag_values_to_json(tags, NULL, 0, &json);
     } else {
-        if (0 != tag_values_to_json(data->tags, s_tags, n_s_tags, &json)) {
-            plog_error(plugin, "tag_values_to_json fail");
-            return NULL;
-        }
+        rv = tag_values_to_json(tags, s_tags, n_s_tags, &json);
+    }
+    if (tags != data->tags) {
+        utarray_free(tags);
+    }
+    if (0 != rv) {
+        plog_error(plugin, "tag_values_to_json fail");
+        return NULL;
     }
 
     int ret;
@@ -314,6 +316,18 @@ static inline int send_read_req(neu_plugin_t *plugin, neu_json_mqtt_t *mqtt,
     req->n_tags = 0;
     req->tags   = NULL;
 
+    // cached values need no round trip through the manager
+    if (!cmd.sync && !neu_otel_control_is_started()) {
+        neu_resp_read_group_t resp = { 0 };
+
+        if (0 == neu_driver_registry_read(&cmd, &resp)) {
+            handle_read_response(plugin, mqtt, &resp);
+            neu_resp_read_free(&resp);
+            neu_req_read_group_fini(&cmd);
+            return 0;
+        }
+    }
+
     if (0 != neu_plugin_op(plugin, header, &cmd)) {
         neu_req_read_group_fini(&cmd);
         plog_error(plugin, "neu_plugin_op(NEU_REQ_READ_GROUP) fail");
@@ -502,9 +516,10 @@ int publish(neu_plugin_t *plugin, neu_mqtt_qos_e qos, char *topic,
             char *payload, size_t payload_len)
 {
 
-    int rv =
-        neu_mqtt_client_publish(plugin->client, qos, topic, (uint8_t *) payload,
-                                (uint32_t) payload_len, plugin, publish_cb);
+    int rv = neu_mqtt_client_publish(mqtt_plugin_client_of(plugin, topic), qos,
+                                     topic, (uint8_t *) payload,
+                                     (uint32_t) payload_len, plugin,
+                                     publish_cb);
     if (0 != rv) {
         plog_error(plugin, "pub [%s, QoS%d] fail", topic, qos);
         NEU_PLUGIN_UPDATE_METRIC(plugin, NEU_METRIC_SEND_MSG_ERRORS_TOTAL, 1,
@@ -521,8 +536,8 @@ int publish_with_trace(neu_plugin_t *plugin, neu_mqtt_qos_e qos, char *topic,
                        const char *traceparent)
 {
     int rv = neu_mqtt_client_publish_with_trace(
-        plugin->client, qos, topic, (uint8_t *) payload, (uint32_t) payload_len,
-        plugin, publish_cb, traceparent);
+        mqtt_plugin_client_of(plugin, topic), qos, topic, (uint8_t *) payload,
+        (uint32_t) payload_len, plugin, publish_cb, traceparent);
     if (0 != rv) {
         plog_error(plugin, "pub [%s, QoS%d] fail", topic, qos);
         NEU_PLUGIN_UPDATE_METRIC(plugin, NEU_METRIC_SEND_MSG_ERRORS_TOTAL, 1,
@@ -831,6 +846,66 @@ end:
     return rv;
 }
 
+#define UPLOAD_ENCODE_SKIP 1 // nothing to upload
+
+typedef struct {
+    neu_plugin_t *       plugin;
+    const route_entry_t *route;
+} upload_encode_arg_t;
+
+static int upload_encode(neu_reqresp_trans_data_t *data, void *arg,
+                         char **bytes)
+{
+    upload_encode_arg_t *encode_arg  = (upload_encode_arg_t *) arg;
+    neu_plugin_t *       plugin      = encode_arg->plugin;
+    const char *         s_tags_str  = encode_arg->route->static_tags;
+    bool                 skip_none   = false;
+    size_t               n_satic_tag = 0;
+    mqtt_static_vt_t *   static_tags = NULL;
+    int64_t              start       = neu_time_us();
+
+    if (s_tags_str != NULL && strlen(s_tags_str) > 0) {
+        mqtt_static_validate(s_tags_str, &static_tags, &n_satic_tag);
+    }
+
+    *bytes = generate_upload_json(
+        plugin, data, plugin->config.format, plugin->config.schema_vts,
+        plugin->config.n_schema_vt, static_tags, n_satic_tag, &skip_none);
+    // only the app that encodes records a sample, waiting on another app
+    // encoding the same payload is not counted
+    NEU_PLUGIN_UPDATE_METRIC(plugin, NEU_METRIC_ENCODE_US,
+                             neu_time_us() - start, NULL);
+    if (n_satic_tag > 0) {
+        mqtt_static_free(static_tags, n_satic_tag);
+    }
+
+    if (skip_none) {
+        free(*bytes);
+        *bytes = NULL;
+        return UPLOAD_ENCODE_SKIP;
+    }
+    return NULL == *bytes ? NEU_ERR_EINTERNAL : 0;
+}
+
+// everything generate_upload_json output depends on besides the data
+static char *upload_encode_key(neu_plugin_t *plugin, const route_entry_t *route)
+{
+    char *key = NULL;
+
+    if (MQTT_UPLOAD_FORMAT_CUSTOM == plugin->config.format) {
+        // the schema belongs to the app
+        neu_asprintf(&key, "mqtt/%d/%d/%p/%s", plugin->config.format,
+                     plugin->config.upload_err, (void *) plugin,
+                     route->static_tags ? route->static_tags : "");
+    } else {
+        neu_asprintf(&key, "mqtt/%d/%d/%s", plugin->config.format,
+                     plugin->config.upload_err,
+                     route->static_tags ? route->static_tags : "");
+    }
+
+    return key;
+}
+
 int handle_trans_data(neu_plugin_t *            plugin,
                       neu_reqresp_trans_data_t *trans_data)
 {
@@ -880,27 +955,32 @@ int handle_trans_data(neu_plugin_t *            plugin,
             break;
         }
 
-        bool              skip_none   = false;
-        size_t            n_satic_tag = 0;
-        mqtt_static_vt_t *static_tags = NULL;
-        if (route->static_tags != NULL && strlen(route->static_tags) > 0) {
-            mqtt_static_validate(route->static_tags, &static_tags,
-                                 &n_satic_tag);
+        // apps with the same format and options publish the same payload,
+        // only the first of them encodes it
+        char *key = upload_encode_key(plugin, route);
+        if (NULL == key) {
+            rv = NEU_ERR_EINTERNAL;
+            break;
         }
 
-        char *json_str = generate_upload_json(
-            plugin, trans_data, plugin->config.format,
-            plugin->config.schema_vts, plugin->config.n_schema_vt, static_tags,
-            n_satic_tag, &skip_none);
-        if (n_satic_tag > 0) {
-            mqtt_static_free(static_tags, n_satic_tag);
-        }
+        upload_encode_arg_t arg     = { plugin, route };
+        const char *        payload = NULL;
+        int encode_rv = neu_trans_data_encode(trans_data, key, upload_encode,
+                                              &arg, &payload);
+        free(key);
 
-        if (skip_none) {
+        if (UPLOAD_ENCODE_SKIP == encode_rv) {
             break;
         }
-        if (NULL == json_str) {
+        if (0 != encode_rv) {
             plog_error(plugin, "generate upload json fail");
+            rv = encode_rv;
+            break;
+        }
+
+        // publish takes the payload over
+        char *json_str = strdup(payload);
+        if (NULL == json_str) {
             rv = NEU_ERR_EINTERNAL;
             break;
         }
@@ -1200,6 +1280,149 @@ end:
     return rv;
 }
 
+static int fup_publish(neu_plugin_t *plugin, mqtt_fup_t *fup,
+                       neu_json_mqtt_t *mqtt_json, neu_resp_fup_data_t *data)
+{
+    int                             rv      = 0;
+    int64_t                         offset  = 0;
+    char *                          payload = NULL;
+    size_t                          len     = 0;
+    neu_json_driver_fup_data_resp_t resp    = { 0 };
+    char *         topic = plugin->config.driver_topic.file_up_data_resp;
+    neu_mqtt_qos_e qos   = plugin->config.qos;
+
+    if (0 != mqtt_fup_recv(fup, data, &offset)) {
+        return 0;
+    }
+
+    if (NULL == plugin->client) {
+        return NEU_ERR_MQTT_IS_NULL;
+    }
+
+    if (0 == plugin->config.cache &&
+        !neu_mqtt_client_is_connected(plugin->client)) {
+        // cache disable and we are disconnected
+        return NEU_ERR_MQTT_FAILURE;
+    }
+
+    // errors always go as json, so that clients can tell them apart
+    if (fup->binary && 0 == data->error) {
+        payload = (char *) mqtt_fup_frame(fup, data, offset, &len);
+    } else {
+        resp.error  = data->error;
+        resp.more   = data->more;
+        resp.len    = data->len;
+        resp.data   = data->data;
+        resp.seq    = data->seq;
+        resp.offset = offset;
+
+        neu_json_encode_with_mqtt(&resp, neu_json_encode_driver_fup_data_resp,
+                                  mqtt_json, neu_json_encode_mqtt_resp,
+                                  &payload);
+        len = NULL == payload ? 0 : strlen(payload);
+    }
+
+    if (NULL == payload) {
+        plog_error(plugin, "generate fup %s chunk %" PRIu32 " fail",
+                   fup->uuid, data->seq);
+        return NEU_ERR_EINTERNAL;
+    }
+
+    rv = publish(plugin, qos, topic, payload, len);
+    return rv;
+}
+
+static void fup_finish(neu_plugin_t *plugin, mqtt_fup_t *fup)
+{
+    int64_t  now  = neu_time_ms();
+    uint64_t rate = mqtt_fup_rate(fup, now);
+
+    plog_notice(plugin,
+                "fup %s %s:%s done, %" PRIu64 " bytes in %" PRId64
+                " ms, %" PRIu64 " B/s",
+                fup->uuid, fup->driver, fup->path, fup->n_byte,
+                now - fup->start_ms, rate);
+    NEU_PLUGIN_UPDATE_METRIC(plugin, NEU_METRIC_FUP_BYTES_PER_SEC, rate,
+                             NULL);
+    mqtt_fup_del(&plugin->fups, fup);
+}
+
+// keep the window of a transfer full, with fup_mtx held
+static void fup_fill(neu_plugin_t *plugin, mqtt_fup_t *fup)
+{
+    neu_req_fup_data_t cmd = { 0 };
+
+    while (0 == mqtt_fup_next(fup, &cmd)) {
+        neu_reqresp_head_t header = { 0 };
+        neu_json_mqtt_t *  ctx    = calloc(1, sizeof(neu_json_mqtt_t));
+
+        if (NULL != ctx && NULL == (ctx->uuid = strdup(fup->uuid))) {
+            free(ctx);
+            ctx = NULL;
+        }
+        header.ctx  = ctx;
+        header.type = NEU_REQ_FUP_DATA;
+
+        if (NULL == ctx || 0 != neu_plugin_op(plugin, header, &cmd)) {
+            neu_json_mqtt_t     mqtt = { .uuid = fup->uuid };
+            neu_resp_fup_data_t resp = { 0 };
+
+            plog_error(plugin, "fup %s request of chunk %" PRIu32 " fail",
+                       fup->uuid, cmd.seq);
+            // ends the transfer as if the driver failed the chunk
+            resp.error = NEU_ERR_EINTERNAL;
+            resp.seq   = cmd.seq;
+            fup_publish(plugin, fup, &mqtt, &resp);
+            if (NULL != ctx) {
+                neu_json_decode_mqtt_req_free(ctx);
+            }
+        }
+    }
+}
+
+// the driver answered the open request of a windowed transfer
+static void fup_start(neu_plugin_t *plugin, const char *uuid, int error)
+{
+    mqtt_fup_t *fup = NULL;
+
+    pthread_mutex_lock(&plugin->fup_mtx);
+    fup = mqtt_fup_find(&plugin->fups, uuid);
+    if (NULL != fup && !fup->opened) {
+        if (0 == error) {
+            mqtt_fup_open(fup, neu_time_ms());
+            fup_fill(plugin, fup);
+            // every request of the first window may have failed already
+            if (mqtt_fup_done(fup)) {
+                fup_finish(plugin, fup);
+            }
+        } else {
+            mqtt_fup_del(&plugin->fups, fup);
+        }
+    }
+    pthread_mutex_unlock(&plugin->fup_mtx);
+}
+
+static int fup_window_response(neu_plugin_t *       plugin,
+                               neu_json_mqtt_t *    mqtt_json,
+                               neu_resp_fup_data_t *data)
+{
+    int         rv  = 0;
+    mqtt_fup_t *fup = NULL;
+
+    pthread_mutex_lock(&plugin->fup_mtx);
+    fup = mqtt_fup_find(&plugin->fups, mqtt_json->uuid);
+    if (NULL != fup) {
+        rv = fup_publish(plugin, fup, mqtt_json, data);
+        fup_fill(plugin, fup);
+        if (mqtt_fup_done(fup)) {
+            fup_finish(plugin, fup);
+        }
+    }
+    pthread_mutex_unlock(&plugin->fup_mtx);
+
+    return rv;
+}
+
 void handle_driver_fup_open_req(neu_mqtt_qos_e qos, const char *topic,
                                 const uint8_t *payload, uint32_t len,
                                 void *data, trace_w3c_t *trace_w3c)
@@ -1224,12 +1447,14 @@ void handle_driver_fup_open_req(neu_mqtt_qos_e qos, const char *topic,
     rv = neu_json_decode_driver_fup_open_req(json_str, &req);
     if (rv != 0) {
         plog_error(plugin, "neu_json_decode_driver_fup_open_req failed");
+        neu_json_decode_mqtt_req_free(mqtt);
         free(json_str);
         return;
     }
 
     neu_reqresp_head_t header = { 0 };
     neu_req_fup_open_t cmd    = { 0 };
+    mqtt_fup_t *       fup    = NULL;
 
     header.ctx  = mqtt;
     header.type = NEU_REQ_FUP_OPEN;
@@ -1237,9 +1462,25 @@ void handle_driver_fup_open_req(neu_mqtt_qos_e qos, const char *topic,
     strcpy(cmd.driver, req->driver);
     strcpy(cmd.path, req->path);
 
+    if (req->window > 0 && NULL != mqtt->uuid) {
+        pthread_mutex_lock(&plugin->fup_mtx);
+        fup = mqtt_fup_add(&plugin->fups, mqtt->uuid, req->driver, req->path,
+                           req->window, req->offset, req->binary);
+        if (NULL == fup) {
+            plog_warn(plugin, "fup %s already in progress, window ignored",
+                      mqtt->uuid);
+        }
+        pthread_mutex_unlock(&plugin->fup_mtx);
+    }
+
     if (0 != neu_plugin_op(plugin, header, &cmd)) {
         plog_error(plugin, "neu_plugin_op(NEU_REQ_DRIVER_FUP_OPEN) fail");
-        return;
+        if (NULL != fup) {
+            pthread_mutex_lock(&plugin->fup_mtx);
+            mqtt_fup_del(&plugin->fups, fup);
+            pthread_mutex_unlock(&plugin->fup_mtx);
+        }
+        neu_json_decode_mqtt_req_free(mqtt);
     }
 
     neu_json_decode_driver_fup_open_req_free(req);
@@ -1286,6 +1527,9 @@ int handle_driver_fup_open_response(neu_plugin_t *       plugin,
     json_str = NULL;
 
 end:
+    if (NULL != mqtt_json->uuid) {
+        fup_start(plugin, mqtt_json->uuid, 0 == rv ? data->error : rv);
+    }
     neu_json_decode_mqtt_req_free(mqtt_json);
     return rv;
 }
@@ -1326,6 +1570,7 @@ void handle_driver_fup_data_req(neu_mqtt_qos_e qos, const char *topic,
 
     strcpy(cmd.driver, req->driver);
     strcpy(cmd.path, req->path);
+    cmd.offset = req->offset;
 
     if (0 != neu_plugin_op(plugin, header, &cmd)) {
         plog_error(plugin, "neu_plugin_op(NEU_REQ_DRIVER_FUP_DATA) fail");
@@ -1346,6 +1591,11 @@ int handle_driver_fup_data_response(neu_plugin_t *       plugin,
     char *                          json_str = NULL;
     neu_json_driver_fup_data_resp_t resp     = { 0 };
 
+    if (data->seq > 0 && NULL != mqtt_json->uuid) {
+        rv = fup_window_response(plugin, mqtt_json, data);
+        goto end;
+    }
+
     if (NULL == plugin->client) {
         rv = NEU_ERR_MQTT_IS_NULL;
         goto end;
@@ -1510,6 +1760,7 @@ void handle_driver_fdown_data_req(neu_mqtt_qos_e qos, const char *topic,
     strcpy(cmd.driver, req->driver);
     strcpy(cmd.src_path, req->src_path);
     cmd.more = req->more;
+    cmd.seq  = req->seq;
     cmd.len  = req->len;
     cmd.data = calloc(req->len, sizeof(uint8_t));
     memcpy(cmd.data, req->data, req->len);
@@ -1546,6 +1797,7 @@ int handle_driver_fdown_data_response(neu_plugin_t *        plugin,
 
     resp.driver   = data->driver;
     resp.src_path = data->src_path;
+    resp.seq      = data->seq;
 
     neu_json_encode_with_mqtt(&resp, neu_json_encode_driver_fdown_data_resp,
                               NULL, NULL, &json_str);
@@ -24,14 +24,19 @@
 extern "C" {
 #endif
 
+#include <pthread.h>
+
 #include "connection/mqtt_client.h"
 #include "neuron.h"
+#include "utils/intern.h"
 
+#include "file_transfer.h"
 #include "mqtt_config.h"
 
+// interned names, referenced by the entry
 typedef struct {
-    char driver[NEU_NODE_NAME_LEN];
-    char group[NEU_GROUP_NAME_LEN];
+    const char *driver;
+    const char *group;
 } route_key_t;
 
 typedef struct {
@@ -49,11 +54,17 @@ struct neu_plugin {
     neu_event_timer_t * heartbeat_timer;
     mqtt_config_t       config;
     neu_mqtt_client_t * client;
+    // extra broker connections, only used for publishing
+    neu_mqtt_client_t * pub_clients[MQTT_CONNECTIONS_MAX - 1];
+    size_t              n_pub_client;
     int64_t             cache_metric_update_ts;
+    neu_histogram_t *   publish_ack; // shared by all connections
     char *              read_req_topic;
     char *              read_resp_topic;
     char *              upload_topic;
     route_entry_t *     route_tbl;
+    pthread_mutex_t     fup_mtx; // mqtt callbacks and responses
+    mqtt_fup_t *        fups;
 
     int (*parse_config)(neu_plugin_t *plugin, const char *setting,
                         mqtt_config_t *config);
@@ -61,8 +72,37 @@ struct neu_plugin {
     int (*unsubscribe)(neu_plugin_t *plugin, const mqtt_config_t *config);
 };
 
+// Connection `i` of the plugin, 0 being the primary connection.
+static inline neu_mqtt_client_t *mqtt_plugin_client_at(neu_plugin_t *plugin,
+                                                       size_t        i)
+{
+    return 0 == i ? plugin->client : plugin->pub_clients[i - 1];
+}
+
+// Pick the connection a topic is published on. The same topic always maps to
+// the same connection, so per-topic ordering is preserved.
+static inline neu_mqtt_client_t *mqtt_plugin_client_of(neu_plugin_t *plugin,
+                                                       const char *  topic)
+{
+    unsigned hv = 0;
+
+    if (0 == plugin->n_pub_client) {
+        return plugin->client;
+    }
+
+    HASH_VALUE(topic, strlen(topic), hv);
+    return mqtt_plugin_client_at(plugin, hv % (plugin->n_pub_client + 1));
+}
+
+static inline unsigned route_key_hash(const route_key_t *key)
+{
+    return neu_intern_hash(key->driver) * 31 + neu_intern_hash(key->group);
+}
+
 static inline void route_entry_free(route_entry_t *e)
 {
+    neu_intern_release(e->key.driver);
+    neu_intern_release(e->key.group);
     free(e->topic);
     if (e->static_tags) {
         free(e->static_tags);
@@ -70,6 +110,12 @@ static inline void route_entry_free(route_entry_t *e)
     free(e);
 }
 
+static inline void route_tbl_add_entry(route_entry_t **tbl, route_entry_t *e)
+{
+    HASH_ADD_BYHASHVALUE(hh, *tbl, key, sizeof(e->key),
+                         route_key_hash(&e->key), e);
+}
+
 static inline void route_tbl_free(route_entry_t *tbl)
 {
     route_entry_t *e = NULL, *tmp = NULL;
@@ -86,10 +132,12 @@ route_tbl_get(route_entry_t **tbl, const char *driver, const char *group)
     route_entry_t *find = NULL;
     route_key_t    key  = { 0 };
 
-    strncpy(key.driver, driver, sizeof(key.driver));
-    strncpy(key.group, group, sizeof(key.group));
-
-    HASH_FIND(hh, *tbl, &key, sizeof(key), find);
+    key.driver = neu_intern_find(driver);
+    key.group  = neu_intern_find(group);
+    if (key.driver != NULL && key.group != NULL) {
+        HASH_FIND_BYHASHVALUE(hh, *tbl, &key, sizeof(key),
+                              route_key_hash(&key), find);
+    }
     return find;
 }
 
@@ -106,17 +154,21 @@ static inline int route_tbl_add_new(route_entry_t **tbl, const char *driver,
         return NEU_ERR_GROUP_ALREADY_SUBSCRIBED;
     }
 
-    find = calloc(1, sizeof(*find));
+    find = (route_entry_t *) calloc(1, sizeof(*find));
     if (NULL == find) {
         free(topic);
         return NEU_ERR_EINTERNAL;
     }
 
-    strncpy(find->key.driver, driver, sizeof(find->key.driver));
-    strncpy(find->key.group, group, sizeof(find->key.group));
+    find->key.driver  = neu_intern(driver);
+    find->key.group   = neu_intern(group);
     find->topic       = topic;
     find->static_tags = static_tags;
-    HASH_ADD(hh, *tbl, key, sizeof(find->key), find);
+    if (NULL == find->key.driver || NULL == find->key.group) {
+        route_entry_free(find);
+        return NEU_ERR_EINTERNAL;
+    }
+    route_tbl_add_entry(tbl, find);
 
     return 0;
 }
@@ -149,25 +201,35 @@ static inline void route_tbl_update_driver(route_entry_t **tbl,
                                            const char *    new_name)
 {
     route_entry_t *e = NULL, *tmp = NULL;
+    const char *   name = neu_intern(new_name);
+
+    if (NULL == name) {
+        return;
+    }
+
     HASH_ITER(hh, *tbl, e, tmp)
     {
         if (0 == strcmp(e->key.driver, driver)) {
             HASH_DEL(*tbl, e);
-            strncpy(e->key.driver, new_name, sizeof(e->key.driver));
-            HASH_ADD(hh, *tbl, key, sizeof(e->key), e);
+            neu_intern_release(e->key.driver);
+            e->key.driver = neu_intern_ref(name);
+            route_tbl_add_entry(tbl, e);
         }
     }
+    neu_intern_release(name);
 }
 
 static inline void route_tbl_update_group(route_entry_t **tbl,
                                           const char *driver, const char *group,
                                           const char *new_name)
 {
-    route_entry_t *e = route_tbl_get(tbl, driver, group);
-    if (e) {
+    route_entry_t *e    = route_tbl_get(tbl, driver, group);
+    const char *   name = NULL;
+    if (e && (name = neu_intern(new_name)) != NULL) {
         HASH_DEL(*tbl, e);
-        strncpy(e->key.group, new_name, sizeof(e->key.group));
-        HASH_ADD(hh, *tbl, key, sizeof(e->key), e);
+        neu_intern_release(e->key.group);
+        e->key.group = name;
+        route_tbl_add_entry(tbl, e);
     }
 }
 
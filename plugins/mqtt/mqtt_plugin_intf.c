@@ -30,6 +30,18 @@ extern const neu_plugin_module_t neu_plugin_module;
 static int subscribe(neu_plugin_t *plugin, const mqtt_config_t *config);
 static int unsubscribe(neu_plugin_t *plugin, const mqtt_config_t *config);
 
+#define CONN_METRIC_NAMES(name)                                          \
+    {                                                                    \
+        "conn0_" name, "conn1_" name, "conn2_" name, "conn3_" name,      \
+            "conn4_" name, "conn5_" name, "conn6_" name, "conn7_" name, \
+    }
+
+// metric entries keep the name pointer, so per connection names are static
+static const char *const inflight_metric_names[MQTT_CONNECTIONS_MAX] =
+    CONN_METRIC_NAMES("inflight_msgs");
+static const char *const ack_latency_metric_names[MQTT_CONNECTIONS_MAX] =
+    CONN_METRIC_NAMES("ack_latency_ms");
+
 static int heartbeat_timer_cb(void *data)
 {
     neu_plugin_t *plugin = data;
@@ -150,12 +162,47 @@ int mqtt_plugin_init(neu_plugin_t *plugin, bool load)
     NEU_PLUGIN_REGISTER_METRIC(plugin, NEU_METRIC_DISCONNECTION_60S, 60000);
     NEU_PLUGIN_REGISTER_METRIC(plugin, NEU_METRIC_DISCONNECTION_600S, 600000);
     NEU_PLUGIN_REGISTER_METRIC(plugin, NEU_METRIC_DISCONNECTION_1800S, 1800000);
+    NEU_PLUGIN_REGISTER_METRIC(plugin, NEU_METRIC_ENCODE_US, 0);
+    NEU_PLUGIN_REGISTER_METRIC(plugin, NEU_METRIC_PUBLISH_ACK_MS, 0);
+    NEU_PLUGIN_REGISTER_METRIC(plugin, NEU_METRIC_FUP_BYTES_PER_SEC, 0);
+
+    plugin->publish_ack =
+        NEU_PLUGIN_METRIC_HISTOGRAM(plugin, NEU_METRIC_PUBLISH_ACK_MS);
+    pthread_mutex_init(&plugin->fup_mtx, NULL);
 
     plog_notice(plugin, "initialize plugin `%s` success",
                 neu_plugin_module.module_name);
     return NEU_ERR_SUCCESS;
 }
 
+static void pub_clients_free(neu_plugin_t *plugin)
+{
+    for (size_t i = 0; i < plugin->n_pub_client; ++i) {
+        neu_mqtt_client_close(plugin->pub_clients[i]);
+        neu_mqtt_client_free(plugin->pub_clients[i]);
+        plugin->pub_clients[i] = NULL;
+    }
+    plugin->n_pub_client = 0;
+}
+
+static int pub_clients_open(neu_plugin_t *plugin)
+{
+    for (size_t i = 0; i < plugin->n_pub_client; ++i) {
+        if (0 != neu_mqtt_client_open(plugin->pub_clients[i])) {
+            plog_error(plugin, "open connection %zu fail", i + 1);
+            return -1;
+        }
+    }
+    return 0;
+}
+
+static void pub_clients_close(neu_plugin_t *plugin)
+{
+    for (size_t i = 0; i < plugin->n_pub_client; ++i) {
+        neu_mqtt_client_close(plugin->pub_clients[i]);
+    }
+}
+
 int mqtt_plugin_uninit(neu_plugin_t *plugin)
 {
     stop_heartbeart_timer(plugin);
@@ -166,6 +213,7 @@ int mqtt_plugin_uninit(neu_plugin_t *plugin)
     }
 
     mqtt_config_fini(&plugin->config);
+    pub_clients_free(plugin);
     if (plugin->client) {
         neu_mqtt_client_close(plugin->client);
         neu_mqtt_client_free(plugin->client);
@@ -180,16 +228,21 @@ int mqtt_plugin_uninit(neu_plugin_t *plugin)
     plugin->upload_topic = NULL;
 
     route_tbl_free(plugin->route_tbl);
+    mqtt_fup_free(&plugin->fups);
+    pthread_mutex_destroy(&plugin->fup_mtx);
 
     plog_notice(plugin, "uninitialize plugin `%s` success",
                 neu_plugin_module.module_name);
     return NEU_ERR_SUCCESS;
 }
 
+// Connection `index` other than 0 uses a suffixed client id, and the offline
+// cache budget is shared evenly among all connections.
 static int config_mqtt_client(neu_plugin_t *plugin, neu_mqtt_client_t *client,
-                              const mqtt_config_t *config)
+                              const mqtt_config_t *config, size_t index)
 {
-    int rv = 0;
+    int   rv        = 0;
+    char *client_id = config->client_id;
 
     if (NULL == client) {
         return 0;
@@ -202,32 +255,47 @@ static int config_mqtt_client(neu_plugin_t *plugin, neu_mqtt_client_t *client,
         return -1;
     }
 
+    neu_mqtt_client_set_ack_histogram(client, plugin->publish_ack);
+
     rv = neu_mqtt_client_set_addr(client, config->host, config->port);
     if (0 != rv) {
         plog_error(plugin, "neu_mqtt_client_set_host fail");
         return -1;
     }
 
-    rv = neu_mqtt_client_set_id(client, config->client_id);
-    if (0 != rv) {
-        plog_error(plugin, "neu_mqtt_client_set_id fail");
+    if (index > 0 &&
+        0 > neu_asprintf(&client_id, "%s-%zu", config->client_id, index)) {
+        plog_error(plugin, "neu_asprintf client id fail");
         return -1;
     }
 
-    rv = neu_mqtt_client_set_connect_cb(client, connect_cb, plugin);
+    rv = neu_mqtt_client_set_id(client, client_id);
+    if (client_id != config->client_id) {
+        free(client_id);
+    }
     if (0 != rv) {
-        plog_error(plugin, "neu_mqtt_client_set_connect_cb fail");
+        plog_error(plugin, "neu_mqtt_client_set_id fail");
         return -1;
     }
 
-    rv = neu_mqtt_client_set_disconnect_cb(client, disconnect_cb, plugin);
-    if (0 != rv) {
-        plog_error(plugin, "neu_mqtt_client_set_disconnect_cb fail");
-        return -1;
+    // link state follows the primary connection only
+    if (0 == index) {
+        rv = neu_mqtt_client_set_connect_cb(client, connect_cb, plugin);
+        if (0 != rv) {
+            plog_error(plugin, "neu_mqtt_client_set_connect_cb fail");
+            return -1;
+        }
+
+        rv = neu_mqtt_client_set_disconnect_cb(client, disconnect_cb, plugin);
+        if (0 != rv) {
+            plog_error(plugin, "neu_mqtt_client_set_disconnect_cb fail");
+            return -1;
+        }
     }
 
-    rv = neu_mqtt_client_set_cache_size(client, config->cache_mem_size,
-                                        config->cache_disk_size);
+    rv = neu_mqtt_client_set_cache_size(
+        client, config->cache_mem_size / config->connections,
+        config->cache_disk_size / config->connections);
     if (0 != rv) {
         plog_error(plugin, "neu_mqtt_client_set_msg_cache_limit fail");
         return -1;
@@ -258,6 +326,35 @@ static int config_mqtt_client(neu_plugin_t *plugin, neu_mqtt_client_t *client,
     return rv;
 }
 
+static int pub_clients_new(neu_plugin_t *plugin, const mqtt_config_t *config)
+{
+    for (size_t i = 1; i < config->connections; ++i) {
+        neu_mqtt_client_t *client = neu_mqtt_client_new(config->version);
+        if (NULL == client) {
+            plog_error(plugin, "neu_mqtt_client_new fail");
+            return -1;
+        }
+
+        plugin->pub_clients[plugin->n_pub_client++] = client;
+        if (0 != config_mqtt_client(plugin, client, config, i)) {
+            return -1;
+        }
+    }
+
+    for (size_t i = 0; i < config->connections; ++i) {
+        plugin->common.adapter_callbacks->register_metric(
+            plugin->common.adapter, inflight_metric_names[i],
+            NEU_METRIC_MQTT_INFLIGHT_MSGS_NUM_HELP,
+            NEU_METRIC_MQTT_INFLIGHT_MSGS_NUM_TYPE, 0);
+        plugin->common.adapter_callbacks->register_metric(
+            plugin->common.adapter, ack_latency_metric_names[i],
+            NEU_METRIC_MQTT_ACK_LATENCY_HELP, NEU_METRIC_MQTT_ACK_LATENCY_TYPE,
+            0);
+    }
+
+    return 0;
+}
+
 static int create_topic(neu_plugin_t *plugin)
 {
     if (plugin->read_req_topic) {
@@ -388,6 +485,7 @@ int mqtt_plugin_config(neu_plugin_t *plugin, const char *setting)
     const char *  plugin_name = neu_plugin_module.module_name;
     mqtt_config_t config      = { 0 };
     bool          started     = false;
+    size_t        n_conn      = 0;
 
     rv = plugin->parse_config(plugin, setting, &config);
     if (0 != rv) {
@@ -405,6 +503,7 @@ int mqtt_plugin_config(neu_plugin_t *plugin, const char *setting)
     } else if (neu_mqtt_client_is_open(plugin->client)) {
         started = true;
         plugin->unsubscribe(plugin, &plugin->config);
+        pub_clients_close(plugin);
         rv = neu_mqtt_client_close(plugin->client);
         if (0 != rv) {
             plog_error(plugin, "neu_mqtt_client_close fail");
@@ -423,14 +522,28 @@ int mqtt_plugin_config(neu_plugin_t *plugin, const char *setting)
         plugin->client = neu_mqtt_client_new(config.version);
     }
 
-    rv = config_mqtt_client(plugin, plugin->client, &config);
+    rv = config_mqtt_client(plugin, plugin->client, &config, 0);
     if (0 != rv) {
         rv = NEU_ERR_MQTT_INIT_FAILURE;
         goto error;
     }
 
+    n_conn = plugin->n_pub_client + 1;
+    pub_clients_free(plugin);
+    if (0 != pub_clients_new(plugin, &config)) {
+        pub_clients_free(plugin);
+        rv = NEU_ERR_MQTT_INIT_FAILURE;
+        goto error;
+    }
+    // metrics of connections dropped by the new setting would go stale
+    for (size_t i = config.connections; i < n_conn; ++i) {
+        NEU_PLUGIN_UNREGISTER_METRIC(plugin, inflight_metric_names[i]);
+        NEU_PLUGIN_UNREGISTER_METRIC(plugin, ack_latency_metric_names[i]);
+    }
+
     if (started) {
-        if (0 != neu_mqtt_client_open(plugin->client)) {
+        if (0 != neu_mqtt_client_open(plugin->client) ||
+            0 != pub_clients_open(plugin)) {
             plog_error(plugin, "neu_mqtt_client_open fail");
             rv = NEU_ERR_MQTT_CONNECT_FAILURE;
             goto error;
@@ -471,7 +584,8 @@ int mqtt_plugin_start(neu_plugin_t *plugin)
         goto end;
     }
 
-    if (0 != neu_mqtt_client_open(plugin->client)) {
+    if (0 != neu_mqtt_client_open(plugin->client) ||
+        0 != pub_clients_open(plugin)) {
         plog_error(plugin, "neu_mqtt_client_open fail");
         rv = NEU_ERR_MQTT_CONNECT_FAILURE;
         goto end;
@@ -491,6 +605,7 @@ end:
     } else {
         plog_error(plugin, "start plugin `%s` failed, error %d", plugin_name,
                    rv);
+        pub_clients_close(plugin);
         neu_mqtt_client_close(plugin->client);
     }
     return rv;
@@ -500,6 +615,7 @@ int mqtt_plugin_stop(neu_plugin_t *plugin)
 {
     if (plugin->client) {
         plugin->unsubscribe(plugin, &plugin->config);
+        pub_clients_close(plugin);
         neu_mqtt_client_close(plugin->client);
         plog_notice(plugin, "mqtt client closed");
     }
@@ -511,6 +627,24 @@ int mqtt_plugin_stop(neu_plugin_t *plugin)
     return NEU_ERR_SUCCESS;
 }
 
+static void update_client_metrics(neu_plugin_t *plugin)
+{
+    size_t cached = 0;
+
+    for (size_t i = 0; i <= plugin->n_pub_client; ++i) {
+        neu_mqtt_client_t *client = mqtt_plugin_client_at(plugin, i);
+
+        cached += neu_mqtt_client_get_cached_msgs_num(client);
+        NEU_PLUGIN_UPDATE_METRIC(plugin, inflight_metric_names[i],
+                                 neu_mqtt_client_get_inflight_msgs_num(client),
+                                 NULL);
+        NEU_PLUGIN_UPDATE_METRIC(plugin, ack_latency_metric_names[i],
+                                 neu_mqtt_client_get_ack_latency(client), NULL);
+    }
+
+    NEU_PLUGIN_UPDATE_METRIC(plugin, NEU_METRIC_CACHED_MSGS_NUM, cached, NULL);
+}
+
 int mqtt_plugin_request(neu_plugin_t *plugin, neu_reqresp_head_t *head,
                         void *data)
 {
@@ -519,9 +653,7 @@ int mqtt_plugin_request(neu_plugin_t *plugin, neu_reqresp_head_t *head,
     // update cached messages number per seconds
     if (NULL != plugin->client &&
         (global_timestamp - plugin->cache_metric_update_ts) >= 1000) {
-        NEU_PLUGIN_UPDATE_METRIC(
-            plugin, NEU_METRIC_CACHED_MSGS_NUM,
-            neu_mqtt_client_get_cached_msgs_num(plugin->client), NULL);
+        update_client_metrics(plugin);
         plugin->cache_metric_update_ts = global_timestamp;
     }
 
@@ -612,6 +744,9 @@ int mqtt_plugin_request(neu_plugin_t *plugin, neu_reqresp_head_t *head,
             if (plugin->client) {
                 neu_mqtt_client_remove_cache_db(plugin->client);
             }
+            for (size_t i = 0; i < plugin->n_pub_client; ++i) {
+                neu_mqtt_client_remove_cache_db(plugin->pub_clients[i]);
+            }
         }
         break;
     }
@@ -1,46 +1,210 @@
+#include <inttypes.h>
+#include <pthread.h>
+
 #include <nng/nng.h>
 #include <nng/supplemental/http/http.h>
 
+#include "cid_handle.h"
+#include "datatag_handle.h"
 #include "define.h"
 #include "errcodes.h"
 #include "handle.h"
+#include "otel/otel_manager.h"
 #include "utils/cid.h"
 #include "utils/http.h"
 #include "utils/log.h"
+#include "utils/time.h"
+#include "utils/uthash.h"
 #include "json/neu_json_error.h"
 #include "json/neu_json_fn.h"
 
 #include "parser/neu_json_cid.h"
+#include "parser/neu_json_tag.h"
+
+// an import in progress, one add request outstanding at a time
+typedef struct cid_import {
+    nng_aio *         aio;
+    neu_cid_reader_t *reader;
+    char              driver[NEU_NODE_NAME_LEN];
+    uint32_t          index;   // tags added by the acknowledged batches
+    uint32_t          n_batch; // batches sent, the first one is traced
+
+    UT_hash_handle hh;
+} cid_import_t;
+
+static pthread_mutex_t imports_mtx = PTHREAD_MUTEX_INITIALIZER;
+static cid_import_t *  imports     = NULL;
+
+// the trace started by the first batch ends with the reply to the import
+static void import_trace_final(nng_aio *aio, int error)
+{
+    neu_otel_trace_ctx trace           = NULL;
+    neu_otel_scope_ctx scope           = NULL;
+    char               new_span_id[36] = { 0 };
+    uint8_t *          p_sp_id         = NULL;
+
+    if (!neu_otel_control_is_started() ||
+        NULL == (trace = neu_otel_find_trace(aio))) {
+        return;
+    }
+
+    scope = neu_otel_add_span(trace);
+    neu_otel_scope_set_span_name(scope, "rest response");
+    neu_otel_new_span_id(new_span_id);
+    neu_otel_scope_set_span_id(scope, new_span_id);
+    p_sp_id = neu_otel_scope_get_pre_span_id(scope);
+    if (p_sp_id) {
+        neu_otel_scope_set_parent_span_id2(scope, p_sp_id, 8);
+    }
+    neu_otel_scope_add_span_attr_int(scope, "thread id",
+                                     (int64_t)(pthread_self()));
+    neu_otel_scope_set_span_start_time(scope, neu_time_ns());
+    neu_otel_scope_set_status_code2(
+        scope, error == NEU_ERR_SUCCESS ? NEU_OTEL_STATUS_OK
+                                        : NEU_OTEL_STATUS_ERROR,
+        error);
+    neu_otel_scope_set_span_end_time(scope, neu_time_ns());
+    neu_otel_trace_set_final(trace);
+}
+
+static void import_finish(cid_import_t *import, int error)
+{
+    if (import->n_batch > 0) {
+        import_trace_final(import->aio, error);
+    }
+
+    pthread_mutex_lock(&imports_mtx);
+    HASH_DEL(imports, import);
+    pthread_mutex_unlock(&imports_mtx);
+
+    neu_cid_reader_close(import->reader);
+    free(import);
+}
+
+// the batch responses only count up to UINT16_MAX, the import reply carries
+// the full count
+static void import_reply(nng_aio *aio, uint32_t index, int error)
+{
+    neu_json_add_gtag_res_t res    = { .index = index, .error = error };
+    char *                  result = NULL;
+
+    neu_json_encode_by_fn(&res, neu_json_encode_au_gtags_resp, &result);
+    NEU_JSON_RESPONSE_ERROR(error, { neu_http_response(aio, error, result); });
+    free(result);
+}
+
+// send the next batch, or reply once the file is exhausted or on error
+static void import_next(neu_plugin_t *plugin, cid_import_t *import)
+{
+    neu_reqresp_head_t header = { 0 };
+    neu_req_add_gtag_t cmd    = { 0 };
+    nng_aio *          aio    = import->aio;
+    uint32_t           index  = import->index;
+    int                ret    = neu_cid_reader_next(
+        import->reader, import->driver, NEU_CID_BATCH_TAGS, &cmd);
+
+    if (ret > 0) {
+        header.ctx  = aio;
+        header.type = NEU_REQ_ADD_GTAG;
+        // one trace for the whole import, the batches share the aio
+        if (0 == import->n_batch) {
+            header.otel_trace_type = NEU_OTEL_TRACE_TYPE_REST_COMM;
+        }
+        if (neu_plugin_op(plugin, header, &cmd) == 0) {
+            import->n_batch += 1;
+            return;
+        }
+        neu_req_add_gtag_fini(&cmd);
+        ret = NEU_ERR_IS_BUSY;
+    } else if (ret < 0) {
+        ret = NEU_ERR_INVALID_CID;
+    }
+
+    import_finish(import, ret);
+    if (ret == 0) {
+        import_reply(aio, index, 0);
+    } else {
+        NEU_JSON_RESPONSE_ERROR(
+            ret, { neu_http_response(aio, ret, result_error); });
+    }
+}
 
 void handle_cid(nng_aio *aio)
 {
     neu_plugin_t *plugin = neu_rest_get_plugin();
-    (void) plugin;
 
     NEU_PROCESS_HTTP_REQUEST(
         aio, neu_json_upload_cid_t, neu_json_decode_upload_cid_req, {
-            cid_t cid      = { 0 };
-            int   parse_re = neu_cid_parse(req->path, &cid);
-            if (parse_re == 0) {
-                neu_reqresp_head_t header = { 0 };
-                neu_req_add_gtag_t cmd    = { 0 };
-                header.ctx                = aio;
-                header.type               = NEU_REQ_ADD_GTAG;
-                header.otel_trace_type    = NEU_OTEL_TRACE_TYPE_REST_COMM;
+            neu_cid_reader_t *reader = neu_cid_reader_open(req->path);
+            cid_import_t *    import = NULL;
+
+            if (reader != NULL &&
+                (import = calloc(1, sizeof(cid_import_t))) == NULL) {
+                neu_cid_reader_close(reader);
+                NEU_JSON_RESPONSE_ERROR(NEU_ERR_EINTERNAL, {
+                    neu_http_response(aio, NEU_ERR_EINTERNAL, result_error);
+                });
+            } else if (reader != NULL) {
+                import->aio    = aio;
+                import->reader = reader;
+                strncpy(import->driver, req->driver,
+                        sizeof(import->driver) - 1);
+
+                pthread_mutex_lock(&imports_mtx);
+                HASH_ADD_PTR(imports, aio, import);
+                pthread_mutex_unlock(&imports_mtx);
 
                 nlog_notice("cid parse success: %s", req->path);
-                neu_cid_to_msg(req->driver, &cid, &cmd);
-                int ret = neu_plugin_op(plugin, header, &cmd);
-                if (ret != 0) {
-                    NEU_JSON_RESPONSE_ERROR(NEU_ERR_IS_BUSY, {
-                        neu_http_response(aio, NEU_ERR_IS_BUSY, result_error);
-                    });
-                }
-                neu_cid_free(&cid);
+                import_next(plugin, import);
             } else {
                 NEU_JSON_RESPONSE_ERROR(NEU_ERR_INVALID_CID, {
                     neu_http_response(aio, NEU_ERR_INVALID_CID, result_error);
                 });
             }
         })
-}
\ No newline at end of file
+}
+
+bool handle_cid_resp(neu_reqresp_head_t *header, void *data)
+{
+    cid_import_t *import = NULL;
+
+    if (header->ctx == NULL ||
+        (header->type != NEU_RESP_ADD_GTAG && header->type != NEU_RESP_ERROR)) {
+        return false;
+    }
+
+    pthread_mutex_lock(&imports_mtx);
+    HASH_FIND_PTR(imports, &header->ctx, import);
+    pthread_mutex_unlock(&imports_mtx);
+    if (import == NULL) {
+        return false;
+    }
+
+    if (header->type == NEU_RESP_ERROR) {
+        neu_resp_error_t *error = (neu_resp_error_t *) data;
+        nng_aio *         aio   = import->aio;
+
+        import_finish(import, error->error);
+        NEU_JSON_RESPONSE_ERROR(error->error, {
+            neu_http_response(aio, error->error, result_error);
+        });
+    } else {
+        neu_resp_add_tag_t *resp = (neu_resp_add_tag_t *) data;
+
+        // batches before a failed one stay added, the index counts them
+        import->index += resp->index;
+        if (resp->error != NEU_ERR_SUCCESS) {
+            nng_aio *aio   = import->aio;
+            uint32_t index = import->index;
+
+            nlog_warn("cid import to %s stopped at tag %" PRIu32 ", error %d",
+                      import->driver, index, resp->error);
+            import_finish(import, resp->error);
+            import_reply(aio, index, resp->error);
+        } else {
+            import_next(neu_rest_get_plugin(), import);
+        }
+    }
+
+    return true;
+}
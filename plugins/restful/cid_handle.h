@@ -19,8 +19,18 @@
 #ifndef _NEU_PLUGIN_REST_CID_HANDLE_H_
 #define _NEU_PLUGIN_REST_CID_HANDLE_H_
 
+#include <stdbool.h>
+
 #include <nng/nng.h>
 
+#include "msg.h"
+
+// tags per add request of a CID import, groups are never split
+#define NEU_CID_BATCH_TAGS 5000
+
 void handle_cid(nng_aio *aio);
+// chain the next batch of a CID import on the response to the last one,
+// false when the response does not belong to an import
+bool handle_cid_resp(neu_reqresp_head_t *header, void *data);
 
 #endif
\ No newline at end of file
@@ -308,6 +308,12 @@ static struct neu_http_handler rest_handlers[] = {
         .url           = "/api/v2/read/test",
         .value.handler = handle_test_read_tag,
     },
+    {
+        .method        = NEU_HTTP_METHOD_POST,
+        .type          = NEU_HTTP_HANDLER_FUNCTION,
+        .url           = "/api/v2/read/history",
+        .value.handler = handle_read_history,
+    },
     {
         .method        = NEU_HTTP_METHOD_POST,
         .type          = NEU_HTTP_HANDLER_FUNCTION,
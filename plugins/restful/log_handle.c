@@ -88,6 +88,7 @@ void handle_log_level(nng_aio *aio)
                     header.otel_trace_type = NEU_OTEL_TRACE_TYPE_REST_COMM;
                     cmd.core               = req->core;
                     cmd.log_level          = log_level;
+                    cmd.capture            = req->capture;
                     if (req->node_name != NULL) {
                         strcpy(cmd.node, req->node_name);
                     }
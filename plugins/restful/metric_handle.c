@@ -167,6 +167,42 @@ static inline void gen_global_metrics(const neu_metrics_t *metrics,
             metrics->south_running_nodes, metrics->south_disconnected_nodes);
 }
 
+static const double summary_quantiles[] = { 0.5, 0.9, 0.99, 0.999 };
+
+// print the samples of one entry, must be called with the node metrics locked
+static void gen_entry_samples(neu_metric_entry_t *e, const char *node,
+                              const char *group, FILE *stream)
+{
+    char labels[NEU_NODE_NAME_LEN + NEU_GROUP_NAME_LEN + 32] = { 0 };
+
+    if (NULL == group) {
+        snprintf(labels, sizeof(labels), "node=\"%s\"", node);
+    } else {
+        snprintf(labels, sizeof(labels), "node=\"%s\",group=\"%s\"", node,
+                 group);
+    }
+
+    if (neu_metric_type_is_histogram(e->type)) {
+        for (size_t i = 0;
+             i < sizeof(summary_quantiles) / sizeof(summary_quantiles[0]);
+             ++i) {
+            fprintf(stream, "%s{%s,quantile=\"%g\"} %" PRIu64 "\n", e->name,
+                    labels, summary_quantiles[i],
+                    neu_histogram_quantile(e->hist, summary_quantiles[i]));
+        }
+        fprintf(stream, "%s_sum{%s} %" PRIu64 "\n%s_count{%s} %" PRIu64 "\n",
+                e->name, labels, neu_histogram_sum(e->hist), e->name, labels,
+                neu_histogram_count(e->hist));
+        return;
+    }
+
+    if (neu_metric_type_is_rolling_counter(e->type)) {
+        // force clean stale value
+        e->value = neu_rolling_counter_inc(e->rcnt, global_timestamp, 0);
+    }
+    fprintf(stream, "%s{%s} %" PRIu64 "\n", e->name, labels, e->value);
+}
+
 static inline void gen_single_node_metrics(neu_node_metrics_t *node_metrics,
                                            FILE *              stream)
 {
@@ -181,14 +217,9 @@ static inline void gen_single_node_metrics(neu_node_metrics_t *node_metrics,
     pthread_mutex_lock(&node_metrics->lock);
     HASH_LOOP(hh, node_metrics->entries, e)
     {
-        if (neu_metric_type_is_rolling_counter(e->type)) {
-            // force clean stale value
-            e->value = neu_rolling_counter_inc(e->rcnt, global_timestamp, 0);
-        }
-        fprintf(stream,
-                "# HELP %s %s\n# TYPE %s %s\n%s{node=\"%s\"} %" PRIu64 "\n",
-                e->name, e->help, e->name, neu_metric_type_str(e->type),
-                e->name, node_metrics->name, e->value);
+        fprintf(stream, "# HELP %s %s\n# TYPE %s %s\n", e->name, e->help,
+                e->name, neu_metric_type_str(e->type));
+        gen_entry_samples(e, node_metrics->name, NULL, stream);
     }
 
     neu_group_metrics_t *g = NULL;
@@ -196,16 +227,9 @@ static inline void gen_single_node_metrics(neu_node_metrics_t *node_metrics,
     {
         HASH_LOOP(hh, g->entries, e)
         {
-            if (neu_metric_type_is_rolling_counter(e->type)) {
-                // force clean stale value
-                e->value =
-                    neu_rolling_counter_inc(e->rcnt, global_timestamp, 0);
-            }
-            fprintf(stream,
-                    "# HELP %s %s\n# TYPE %s %s\n%s{node=\"%s\",group=\"%s\"} "
-                    "%" PRIu64 "\n",
-                    e->name, e->help, e->name, neu_metric_type_str(e->type),
-                    e->name, node_metrics->name, g->name, e->value);
+            fprintf(stream, "# HELP %s %s\n# TYPE %s %s\n", e->name, e->help,
+                    e->name, neu_metric_type_str(e->type));
+            gen_entry_samples(e, node_metrics->name, g->name, stream);
         }
     }
     pthread_mutex_unlock(&node_metrics->lock);
@@ -278,13 +302,7 @@ static void gen_all_node_metrics(neu_metrics_t *metrics, int type_filter,
             pthread_mutex_lock(&n->lock);
             HASH_FIND_STR(n->entries, r->name, e);
             if (e) {
-                if (neu_metric_type_is_rolling_counter(e->type)) {
-                    // force clean stale value
-                    e->value =
-                        neu_rolling_counter_inc(e->rcnt, global_timestamp, 0);
-                }
-                fprintf(stream, "%s{node=\"%s\"} %" PRIu64 "\n", e->name,
-                        n->name, e->value);
+                gen_entry_samples(e, n->name, NULL, stream);
 
                 pthread_mutex_unlock(&n->lock);
                 continue;
@@ -294,14 +312,7 @@ static void gen_all_node_metrics(neu_metrics_t *metrics, int type_filter,
             {
                 HASH_FIND_STR(g->entries, r->name, e);
                 if (e) {
-                    if (neu_metric_type_is_rolling_counter(e->type)) {
-                        // force clean stale value
-                        e->value = neu_rolling_counter_inc(e->rcnt,
-                                                           global_timestamp, 0);
-                    }
-                    fprintf(stream,
-                            "%s{node=\"%s\",group=\"%s\"} %" PRIu64 "\n",
-                            e->name, n->name, g->name, e->value);
+                    gen_entry_samples(e, n->name, g->name, stream);
                 }
             }
             pthread_mutex_unlock(&n->lock);
@@ -331,12 +342,24 @@ static void gen_node_metrics(neu_metrics_t *metrics, struct context *ctx)
     }
 }
 
+// Reject unknown nodes up front, the status line is already on the wire
+// once the metrics start streaming.
+static void check_node_metrics(neu_metrics_t *metrics, struct context *ctx)
+{
+    if (ctx->node[0]) {
+        neu_node_metrics_t *n = NULL;
+        HASH_FIND_STR(metrics->node_metrics, ctx->node, n);
+        if (NULL == n || 0 == (ctx->filter & n->type)) {
+            *ctx->status = NNG_HTTP_STATUS_NOT_FOUND;
+        }
+    }
+}
+
 void handle_get_metric(nng_aio *aio)
 {
-    int    status = NNG_HTTP_STATUS_OK;
-    char * result = NULL;
-    size_t len    = 0;
-    FILE * stream = NULL;
+    int                status = NNG_HTTP_STATUS_OK;
+    neu_http_stream_t *http   = NULL;
+    FILE *             stream = NULL;
 
     neu_metrics_category_e cat           = NEU_METRICS_CATEGORY_ALL;
     size_t                 cat_param_len = 0;
@@ -358,41 +381,63 @@ void handle_get_metric(nng_aio *aio)
         goto end;
     }
 
-    stream = open_memstream(&result, &len);
-    if (NULL == stream) {
-        status = NNG_HTTP_STATUS_INTERNAL_SERVER_ERROR;
-        goto end;
-    }
-
     struct context ctx = {
         .status = &status,
-        .stream = stream,
         .node   = node_name,
     };
 
     switch (cat) {
     case NEU_METRICS_CATEGORY_GLOBAL:
-        neu_metrics_visist((neu_metrics_cb_t) gen_global_metrics, stream);
         break;
     case NEU_METRICS_CATEGORY_DRIVER:
         ctx.filter = NEU_NA_TYPE_DRIVER;
-        neu_metrics_visist((neu_metrics_cb_t) gen_node_metrics, &ctx);
         break;
     case NEU_METRICS_CATEGORY_APP:
         ctx.filter = NEU_NA_TYPE_APP;
-        neu_metrics_visist((neu_metrics_cb_t) gen_node_metrics, &ctx);
         break;
     case NEU_METRICS_CATEGORY_ALL:
         ctx.filter = NEU_NA_TYPE_DRIVER | NEU_NA_TYPE_APP;
+        break;
+    }
+
+    if (NEU_METRICS_CATEGORY_GLOBAL != cat) {
+        neu_metrics_visist((neu_metrics_cb_t) check_node_metrics, &ctx);
+        if (NNG_HTTP_STATUS_OK != status) {
+            goto end;
+        }
+    }
+
+    http = neu_http_stream_open(aio, "text/plain");
+    if (NULL == http) {
+        status = NNG_HTTP_STATUS_INTERNAL_SERVER_ERROR;
+        goto end;
+    }
+
+    stream = neu_http_stream_fopen(http);
+    if (NULL == stream) {
+        neu_http_stream_close(http);
+        return;
+    }
+    ctx.stream = stream;
+
+    switch (cat) {
+    case NEU_METRICS_CATEGORY_GLOBAL:
+        neu_metrics_visist((neu_metrics_cb_t) gen_global_metrics, stream);
+        break;
+    case NEU_METRICS_CATEGORY_DRIVER:
+    case NEU_METRICS_CATEGORY_APP:
+        neu_metrics_visist((neu_metrics_cb_t) gen_node_metrics, &ctx);
+        break;
+    case NEU_METRICS_CATEGORY_ALL:
         neu_metrics_visist((neu_metrics_cb_t) gen_global_metrics, stream);
         neu_metrics_visist((neu_metrics_cb_t) gen_node_metrics, &ctx);
         break;
     }
 
+    fclose(stream);
+    neu_http_stream_close(http);
+    return;
+
 end:
-    if (NULL != stream) {
-        fclose(stream);
-    }
-    response(aio, NNG_HTTP_STATUS_OK == status ? result : NULL, status);
-    free(result);
+    response(aio, NULL, status);
 }
@@ -26,6 +26,7 @@
 
 #include "adapter_handle.h"
 #include "argparse.h"
+#include "cid_handle.h"
 #include "datatag_handle.h"
 #include "define.h"
 #include "global_config_handle.h"
@@ -169,6 +170,10 @@ static int dashb_plugin_request(neu_plugin_t *      plugin,
 {
     (void) plugin;
 
+    if (handle_cid_resp(header, data)) {
+        return 0;
+    }
+
     if (header->ctx && nng_aio_get_input(header->ctx, 3)) {
         // catch all response messages for global config request
         handle_global_config_resp(header->ctx, header->type, data);
@@ -313,6 +318,9 @@ static int dashb_plugin_request(neu_plugin_t *      plugin,
             neu_otel_scope_set_status_code2(scope, NEU_OTEL_STATUS_OK, 0);
         }
         break;
+    case NEU_RESP_READ_HISTORY:
+        handle_read_history_resp(header->ctx, (neu_resp_read_history_t *) data);
+        break;
     case NEU_RESP_TEST_READ_TAG:
         handle_test_read_tag_resp(header->ctx,
                                   (neu_resp_test_read_tag_t *) data);
@@ -18,6 +18,7 @@
  **/
 #include <stdlib.h>
 
+#include "driver_registry.h"
 #include "plugin.h"
 #include "utils/log.h"
 #include "json/neu_json_fn.h"
@@ -67,7 +68,21 @@ void handle_read(nng_aio *aio)
             cmd.sync   = req->sync;
             req->node  = NULL;
             req->group = NULL;
-            ret        = neu_plugin_op(plugin, header, &cmd);
+
+            // cached values are read right here, keep the manager path for
+            // sync reads, traced requests and the error responses
+            if (!cmd.sync && !neu_otel_control_is_started()) {
+                neu_resp_read_group_t resp = { 0 };
+
+                if (neu_driver_registry_read(&cmd, &resp) == 0) {
+                    handle_read_resp(aio, &resp);
+                    neu_resp_read_free(&resp);
+                    neu_req_read_group_fini(&cmd);
+                    goto success;
+                }
+            }
+
+            ret = neu_plugin_op(plugin, header, &cmd);
             if (ret != 0) {
                 neu_req_read_group_fini(&cmd);
                 NEU_JSON_RESPONSE_ERROR(NEU_ERR_IS_BUSY, {
@@ -140,6 +155,63 @@ void handle_read_paginate(nng_aio *aio)
         })
 }
 
+void handle_read_history(nng_aio *aio)
+{
+    neu_plugin_t *plugin = neu_rest_get_plugin();
+
+    NEU_PROCESS_HTTP_REQUEST_VALIDATE_JWT(
+        aio, neu_json_read_history_req_t, neu_json_decode_read_history_req, {
+            int                    ret    = 0;
+            neu_reqresp_head_t     header = { 0 };
+            neu_req_read_history_t cmd    = { 0 };
+            int                    err_type;
+            header.ctx  = aio;
+            header.type = NEU_REQ_READ_HISTORY;
+
+            if (strlen(req->node) >= NEU_NODE_NAME_LEN) {
+                err_type = NEU_ERR_NODE_NAME_TOO_LONG;
+                goto error;
+            }
+
+            if (strlen(req->group) >= NEU_GROUP_NAME_LEN) {
+                err_type = NEU_ERR_GROUP_NAME_TOO_LONG;
+                goto error;
+            }
+
+            if (req->start > req->end || req->buckets < 0 ||
+                req->n_tags > UINT16_MAX) {
+                err_type = NEU_ERR_PARAM_IS_WRONG;
+                goto error;
+            }
+
+            cmd.driver  = req->node;
+            cmd.group   = req->group;
+            cmd.start   = req->start;
+            cmd.end     = req->end;
+            cmd.buckets = req->buckets;
+            cmd.n_tag   = req->n_tags;
+            cmd.tags    = req->tags;
+            req->node   = NULL;
+            req->group  = NULL;
+            req->n_tags = 0;
+            req->tags   = NULL;
+            ret         = neu_plugin_op(plugin, header, &cmd);
+            if (ret != 0) {
+                neu_req_read_history_fini(&cmd);
+                NEU_JSON_RESPONSE_ERROR(NEU_ERR_IS_BUSY, {
+                    neu_http_response(aio, NEU_ERR_IS_BUSY, result_error);
+                });
+            }
+            goto success;
+
+        error:
+            NEU_JSON_RESPONSE_ERROR(
+                err_type, { neu_http_response(aio, err_type, result_error); });
+
+        success:;
+        })
+}
+
 void handle_test_read_tag(nng_aio *aio)
 {
     neu_plugin_t *plugin = neu_rest_get_plugin();
@@ -800,34 +872,132 @@ void handle_write_gtags(nng_aio *aio)
         })
 }
 
+static inline void free_json_read_resp_tag(neu_json_read_resp_tag_t *tag)
+{
+    if (tag->n_meta > 0) {
+        free(tag->metas);
+    }
+
+    if (tag->t == NEU_JSON_ARRAY_STR) {
+        for (int j = 0; j < tag->value.val_array_str.length; j++) {
+            free(tag->value.val_array_str.p_strs[j]);
+        }
+    }
+}
+
+static inline void
+free_json_read_paginate_resp_tag(neu_json_read_paginate_resp_tag_t *tag)
+{
+    free(tag->datatag.name);
+    free(tag->datatag.address);
+    free(tag->datatag.description);
+
+    if (tag->n_meta > 0) {
+        free(tag->metas);
+    }
+
+    if (tag->t == NEU_JSON_ARRAY_STR) {
+        for (int j = 0; j < tag->value.val_array_str.length; j++) {
+            free(tag->value.val_array_str.p_strs[j]);
+        }
+    }
+}
+
+// Write a json array element by element, so that only one encoded tag is
+// held in memory at any time.
+static int stream_json_elem(neu_http_stream_t *stream, bool first, void *param,
+                            neu_json_encode_fn fn)
+{
+    char *result = NULL;
+    int   ret    = 0;
+
+    if (0 != neu_json_encode_by_fn(param, fn, &result)) {
+        return -1;
+    }
+
+    if (!first) {
+        ret = neu_http_stream_puts(stream, ",");
+    }
+    if (0 == ret) {
+        ret = neu_http_stream_puts(stream, result);
+    }
+
+    free(result);
+    return ret;
+}
+
 void handle_read_resp(nng_aio *aio, neu_resp_read_group_t *resp)
 {
-    neu_json_read_resp_t api_res = { 0 };
-    char *               result  = NULL;
-    int                  index   = 0;
+    neu_http_stream_t *stream = neu_http_stream_open(aio, "application/json");
+    bool               first  = true;
+
+    if (NULL == stream) {
+        NEU_JSON_RESPONSE_ERROR(NEU_ERR_EINTERNAL, {
+            neu_http_response(aio, NEU_ERR_EINTERNAL, result_error);
+        });
+        return;
+    }
 
-    api_res.n_tag = utarray_len(resp->tags);
-    api_res.tags  = calloc(api_res.n_tag, sizeof(neu_json_read_resp_tag_t));
+    neu_http_stream_puts(stream, "{\"tags\":[");
 
     utarray_foreach(resp->tags, neu_resp_tag_value_meta_t *, tag_value)
     {
-        neu_tag_value_to_json(tag_value, &api_res.tags[index]);
-        index += 1;
+        neu_json_read_resp_tag_t json_tag = { 0 };
+
+        neu_tag_value_to_json(tag_value, &json_tag);
+        int ret = stream_json_elem(stream, first, &json_tag,
+                                   neu_json_encode_read_resp_tag);
+        free_json_read_resp_tag(&json_tag);
+        first = false;
+
+        if (0 != ret) {
+            break;
+        }
+    }
+
+    neu_http_stream_puts(stream, "]}");
+    neu_http_stream_close(stream);
+}
+
+void handle_read_history_resp(nng_aio *aio, neu_resp_read_history_t *resp)
+{
+    neu_json_read_history_resp_t api_res = { 0 };
+    char *                       result  = NULL;
+
+    api_res.downsampled = resp->buckets > 0;
+    api_res.n_tag       = resp->n_tag;
+    api_res.tags = calloc(api_res.n_tag, sizeof(neu_json_history_tag_t));
+    if (api_res.n_tag > 0 && api_res.tags == NULL) {
+        NEU_JSON_RESPONSE_ERROR(NEU_ERR_EINTERNAL, {
+            neu_http_response(aio, NEU_ERR_EINTERNAL, result_error);
+        });
+        return;
     }
 
-    neu_json_encode_by_fn(&api_res, neu_json_encode_read_resp, &result);
     for (int i = 0; i < api_res.n_tag; i++) {
-        if (api_res.tags[i].n_meta > 0) {
-            free(api_res.tags[i].metas);
-        }
+        neu_json_history_tag_t *tag = &api_res.tags[i];
 
-        if (api_res.tags[i].t == NEU_JSON_ARRAY_STR) {
-            for (int j = 0; j < api_res.tags[i].value.val_array_str.length;
-                 j++) {
-                free(api_res.tags[i].value.val_array_str.p_strs[j]);
-            }
+        tag->name    = resp->tags[i].tag;
+        tag->error   = resp->tags[i].error;
+        tag->n_point = utarray_len(resp->tags[i].points);
+        tag->points  = calloc(tag->n_point, sizeof(neu_json_history_point_t));
+
+        int index = 0;
+        utarray_foreach(resp->tags[i].points, neu_history_point_t *, p)
+        {
+            tag->points[index].timestamp = p->timestamp;
+            tag->points[index].value     = p->value;
+            tag->points[index].min       = p->min;
+            tag->points[index].max       = p->max;
+            index += 1;
         }
     }
+
+    neu_json_encode_by_fn(&api_res, neu_json_encode_read_history_resp,
+                          &result);
+    for (int i = 0; i < api_res.n_tag; i++) {
+        free(api_res.tags[i].points);
+    }
     neu_http_ok(aio, result);
     free(api_res.tags);
     free(result);
@@ -836,9 +1006,12 @@ void handle_read_resp(nng_aio *aio, neu_resp_read_group_t *resp)
 void handle_read_paginate_resp(nng_aio *                       aio,
                                neu_resp_read_group_paginate_t *resp)
 {
-    neu_json_read_paginate_resp_t api_res    = { 0 };
-    char *                        result     = NULL;
-    unsigned int                  total_tags = resp->total_count;
+    neu_json_read_meta_resp_t meta        = { 0 };
+    neu_http_stream_t *       stream      = NULL;
+    char *                    result      = NULL;
+    unsigned int              total_tags  = resp->total_count;
+    unsigned int              start_index = 0;
+    unsigned int              end_index   = utarray_len(resp->tags);
 
     if (resp->is_error) {
         UT_array *filtered_tags;
@@ -877,81 +1050,59 @@ void handle_read_paginate_resp(nng_aio *                       aio,
         utarray_free(resp->tags);
         resp->tags = filtered_tags;
         total_tags = utarray_len(resp->tags);
+        end_index  = total_tags;
 
         if (resp->current_page > 0 && resp->page_size > 0) {
-            unsigned int start_index =
-                (resp->current_page - 1) * resp->page_size;
-            unsigned int end_index = start_index + resp->page_size;
+            start_index = (resp->current_page - 1) * resp->page_size;
+            end_index   = start_index + resp->page_size;
 
             if (start_index >= total_tags) {
-                api_res.n_tag = 0;
-                api_res.tags =
-                    calloc(1, sizeof(neu_json_read_paginate_resp_tag_t));
-            } else {
-                if (end_index > total_tags) {
-                    end_index = total_tags;
-                }
+                start_index = 0;
+                end_index   = 0;
+            } else if (end_index > total_tags) {
+                end_index = total_tags;
+            }
+        }
+    }
 
-                api_res.n_tag = end_index - start_index;
-                api_res.tags  = calloc(
-                    api_res.n_tag, sizeof(neu_json_read_paginate_resp_tag_t));
+    meta.current_page = resp->current_page;
+    meta.page_size    = resp->page_size;
+    meta.total        = total_tags;
 
-                for (unsigned int i = start_index; i < end_index; i++) {
-                    neu_resp_tag_value_meta_paginate_t *tag_value =
-                        (neu_resp_tag_value_meta_paginate_t *) utarray_eltptr(
-                            resp->tags, i);
-                    neu_tag_value_to_json_paginate(
-                        tag_value, &api_res.tags[i - start_index]);
-                }
-            }
-        } else {
-            api_res.n_tag = total_tags;
-            api_res.tags  = calloc(api_res.n_tag,
-                                  sizeof(neu_json_read_paginate_resp_tag_t));
-            int index     = 0;
+    stream = neu_http_stream_open(aio, "application/json");
+    if (NULL == stream) {
+        NEU_JSON_RESPONSE_ERROR(NEU_ERR_EINTERNAL, {
+            neu_http_response(aio, NEU_ERR_EINTERNAL, result_error);
+        });
+        goto end;
+    }
 
-            utarray_foreach(resp->tags, neu_resp_tag_value_meta_paginate_t *,
-                            tag_value)
-            {
-                neu_tag_value_to_json_paginate(tag_value,
-                                               &api_res.tags[index++]);
-            }
-        }
-    } else {
+    neu_json_encode_by_fn(&meta, neu_json_encode_read_meta_resp, &result);
+    neu_http_stream_puts(stream, "{\"meta\":");
+    neu_http_stream_puts(stream, result != NULL ? result : "{}");
+    neu_http_stream_puts(stream, ",\"items\":[");
+    free(result);
 
-        if (resp->current_page > 0 && resp->page_size > 0) {
-            api_res.n_tag = utarray_len(resp->tags);
-            api_res.tags  = calloc(api_res.n_tag,
-                                  sizeof(neu_json_read_paginate_resp_tag_t));
-            int index     = 0;
-            utarray_foreach(resp->tags, neu_resp_tag_value_meta_paginate_t *,
-                            tag_value)
-            {
-                neu_tag_value_to_json_paginate(tag_value,
-                                               &api_res.tags[index++]);
-            }
-        } else {
-            api_res.n_tag = total_tags;
-            api_res.tags  = calloc(api_res.n_tag,
-                                  sizeof(neu_json_read_paginate_resp_tag_t));
-            int index     = 0;
-
-            utarray_foreach(resp->tags, neu_resp_tag_value_meta_paginate_t *,
-                            tag_value)
-            {
-                neu_tag_value_to_json_paginate(tag_value,
-                                               &api_res.tags[index++]);
-            }
+    for (unsigned int i = start_index; i < end_index; i++) {
+        neu_json_read_paginate_resp_tag_t   json_tag  = { 0 };
+        neu_resp_tag_value_meta_paginate_t *tag_value =
+            (neu_resp_tag_value_meta_paginate_t *) utarray_eltptr(resp->tags,
+                                                                  i);
+
+        neu_tag_value_to_json_paginate(tag_value, &json_tag);
+        int ret = stream_json_elem(stream, i == start_index, &json_tag,
+                                   neu_json_encode_read_paginate_resp_tag);
+        free_json_read_paginate_resp_tag(&json_tag);
+
+        if (0 != ret) {
+            break;
         }
     }
 
-    api_res.meta.current_page = resp->current_page;
-    api_res.meta.page_size    = resp->page_size;
-    api_res.meta.total        = total_tags;
-
-    neu_json_encode_by_fn(&api_res, neu_json_encode_read_paginate_resp,
-                          &result);
+    neu_http_stream_puts(stream, "]}");
+    neu_http_stream_close(stream);
 
+end:
     for (unsigned int i = 0; i < utarray_len(resp->tags); ++i) {
         neu_resp_tag_value_meta_paginate_t *final_tag_value;
         final_tag_value = (neu_resp_tag_value_meta_paginate_t *) utarray_eltptr(
@@ -962,22 +1113,6 @@ void handle_read_paginate_resp(nng_aio *                       aio,
             free(final_tag_value->datatag.description);
         }
     }
-
-    for (int i = 0; i < api_res.n_tag; i++) {
-        if (api_res.tags[i].n_meta > 0) {
-            free(api_res.tags[i].metas);
-        }
-
-        if (api_res.tags[i].t == NEU_JSON_ARRAY_STR) {
-            for (int j = 0; j < api_res.tags[i].value.val_array_str.length;
-                 j++) {
-                free(api_res.tags[i].value.val_array_str.p_strs[j]);
-            }
-        }
-    }
-    neu_http_ok(aio, result);
-    free(api_res.tags);
-    free(result);
 }
 
 void handle_test_read_tag_resp(nng_aio *aio, neu_resp_test_read_tag_t *resp)
@@ -29,6 +29,7 @@ void handle_rw_uninit();
 void handle_read(nng_aio *aio);
 void handle_read_paginate(nng_aio *aio);
 void handle_test_read_tag(nng_aio *aio);
+void handle_read_history(nng_aio *aio);
 void handle_write(nng_aio *aio);
 void handle_write_tags(nng_aio *aio);
 void handle_write_gtags(nng_aio *aio);
@@ -36,5 +37,6 @@ void handle_read_resp(nng_aio *aio, neu_resp_read_group_t *resp);
 void handle_read_paginate_resp(nng_aio *                       aio,
                                neu_resp_read_group_paginate_t *resp);
 void handle_test_read_tag_resp(nng_aio *aio, neu_resp_test_read_tag_t *resp);
+void handle_read_history_resp(nng_aio *aio, neu_resp_read_history_t *resp);
 
 #endif
\ No newline at end of file
@@ -0,0 +1,1025 @@
+/**
+ * NEURON IIoT System for Industry 4.0
+ * Copyright (C) 2020-2022 EMQ Technologies Co., Ltd All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ **/
+
+/*
+ * Modbus TCP load target.
+ *
+ * Listens on a range of ports, each port hosting a set of slave ids, and
+ * serves them from a pool of epoll workers. Input registers and discrete
+ * inputs follow a configurable waveform, holding registers and coils keep
+ * whatever was written. Every response can be delayed by a per device RTT
+ * plus jitter, dropped, or replaced by an exception, and each connection
+ * accepts at most `--inflight` pipelined MBAP requests before it stops
+ * reading from the socket.
+ */
+
+#if defined(__GNUC__) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE
+#endif
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <getopt.h>
+#include <inttypes.h>
+#include <math.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <neuron.h>
+
+#include "plugins/modbus/modbus.h"
+
+#define SIM_MAX_PORTS 8192
+#define SIM_MAX_SLAVES 247
+#define SIM_MAX_WORKERS 64
+#define SIM_EPOLL_EVENTS 256
+#define SIM_RECV_BUF 4096
+#define SIM_FRAME_MAX 260
+#define SIM_IDLE_WAIT 500
+
+#define SIM_EX_ILLEGAL_FUNCTION 0x01
+#define SIM_EX_ILLEGAL_ADDRESS 0x02
+#define SIM_EX_ILLEGAL_VALUE 0x03
+#define SIM_EX_DEVICE_FAILURE 0x04
+
+typedef enum {
+    SIM_WAVE_CONST = 0,
+    SIM_WAVE_RAMP,
+    SIM_WAVE_SINE,
+    SIM_WAVE_SQUARE,
+    SIM_WAVE_RANDOM,
+} sim_wave_e;
+
+typedef enum {
+    SIM_HANDLE_LISTENER = 0,
+    SIM_HANDLE_CONN,
+} sim_handle_e;
+
+struct sim_config {
+    uint16_t   port;
+    uint16_t   n_port;
+    uint16_t   n_slave;
+    uint32_t   n_reg;
+    int        n_worker;
+    bool       ipv6;
+    uint32_t   rtt;
+    uint32_t   rtt_spread;
+    uint32_t   jitter;
+    double     drop_rate;
+    double     exception_rate;
+    uint16_t   max_inflight;
+    sim_wave_e wave;
+    uint32_t   period;
+    unsigned   seed;
+    int        stats_interval;
+};
+
+struct sim_device {
+    pthread_mutex_t mutex;
+    uint32_t        rtt;
+    double          phase;
+    uint16_t *      hold;
+    uint8_t *       coil;
+};
+
+struct sim_worker {
+    pthread_t           thread;
+    int                 epfd;
+    unsigned            seed;
+    struct sim_pending *pending;
+};
+
+struct sim_handle {
+    sim_handle_e type;
+    int          fd;
+};
+
+struct sim_listener {
+    struct sim_handle handle;
+    uint16_t          index;
+};
+
+struct sim_conn {
+    struct sim_handle  handle;
+    uint16_t           index;
+    struct sim_worker *worker;
+    uint16_t           inflight;
+    bool               paused;
+    bool               closed;
+    uint16_t           len;
+    uint8_t            buf[SIM_RECV_BUF];
+};
+
+struct sim_pending {
+    struct sim_conn *   conn;
+    int64_t             due;
+    uint16_t            len;
+    uint8_t             buf[SIM_FRAME_MAX];
+    struct sim_pending *prev;
+    struct sim_pending *next;
+};
+
+struct sim_stats {
+    uint64_t conns;
+    uint64_t requests;
+    uint64_t responses;
+    uint64_t drops;
+    uint64_t exceptions;
+    uint64_t delayed;
+};
+
+zlog_category_t *neuron = NULL;
+
+static struct sim_config config = {
+    .port           = 5502,
+    .n_port         = 1,
+    .n_slave        = 1,
+    .n_reg          = 10000,
+    .n_worker       = 0,
+    .ipv6           = false,
+    .rtt            = 0,
+    .rtt_spread     = 0,
+    .jitter         = 0,
+    .drop_rate      = 0.0,
+    .exception_rate = 0.0,
+    .max_inflight   = 1,
+    .wave           = SIM_WAVE_SINE,
+    .period         = 60000,
+    .seed           = 1,
+    .stats_interval = 10,
+};
+
+static struct sim_device *  devices   = NULL;
+static struct sim_listener *listeners = NULL;
+static struct sim_worker    workers[SIM_MAX_WORKERS];
+static struct sim_stats     stats;
+static uint32_t             next_worker = 0;
+static volatile bool        exiting     = false;
+
+#define STAT_ADD(field, n) __atomic_add_fetch(&stats.field, n, __ATOMIC_RELAXED)
+#define STAT_GET(field) __atomic_load_n(&stats.field, __ATOMIC_RELAXED)
+
+static void sig_handler(int sig)
+{
+    (void) sig;
+    exiting = true;
+}
+
+static inline bool chance(struct sim_worker *w, double rate)
+{
+    return rate > 0.0 && (double) rand_r(&w->seed) / RAND_MAX < rate;
+}
+
+static uint16_t wave_value(const struct sim_device *dev, uint32_t address,
+                           int64_t now, unsigned *seed)
+{
+    double x = fmod((double) now / config.period + dev->phase +
+                        (double) (address % 64) / 64.0,
+                    1.0);
+
+    switch (config.wave) {
+    case SIM_WAVE_CONST:
+        return (uint16_t) address;
+    case SIM_WAVE_RAMP:
+        return (uint16_t)(x * 65535.0);
+    case SIM_WAVE_SINE:
+        return (uint16_t)(32767.5 + 32767.5 * sin(2.0 * M_PI * x));
+    case SIM_WAVE_SQUARE:
+        return x < 0.5 ? 0 : 0xffff;
+    case SIM_WAVE_RANDOM:
+        return (uint16_t)(rand_r(seed) & 0xffff);
+    }
+
+    return 0;
+}
+
+static int device_read_bits(struct sim_device *dev, uint8_t function,
+                            const uint8_t *data, uint16_t data_len,
+                            uint8_t *res, unsigned *seed)
+{
+    uint16_t start = 0, n = 0;
+    int64_t  now   = neu_time_ms();
+
+    if (data_len < 4) {
+        return -SIM_EX_ILLEGAL_VALUE;
+    }
+    start = (uint16_t)(data[0] << 8 | data[1]);
+    n     = (uint16_t)(data[2] << 8 | data[3]);
+    if (n == 0 || n > 2000) {
+        return -SIM_EX_ILLEGAL_VALUE;
+    }
+    if ((uint32_t) start + n > config.n_reg) {
+        return -SIM_EX_ILLEGAL_ADDRESS;
+    }
+
+    res[0] = (uint8_t)((n + 7) / 8);
+    memset(&res[1], 0, res[0]);
+
+    pthread_mutex_lock(&dev->mutex);
+    for (uint16_t i = 0; i < n; i++) {
+        bool bit = false;
+
+        if (function == MODBUS_READ_COIL) {
+            bit = dev->coil[start + i] != 0;
+        } else {
+            bit = wave_value(dev, start + i, now, seed) >= 0x8000;
+        }
+
+        if (bit) {
+            res[1 + i / 8] |= (uint8_t)(1 << (i % 8));
+        }
+    }
+    pthread_mutex_unlock(&dev->mutex);
+
+    return 1 + res[0];
+}
+
+static int device_read_regs(struct sim_device *dev, uint8_t function,
+                            const uint8_t *data, uint16_t data_len,
+                            uint8_t *res, unsigned *seed)
+{
+    uint16_t start = 0, n = 0;
+    int64_t  now   = neu_time_ms();
+
+    if (data_len < 4) {
+        return -SIM_EX_ILLEGAL_VALUE;
+    }
+    start = (uint16_t)(data[0] << 8 | data[1]);
+    n     = (uint16_t)(data[2] << 8 | data[3]);
+    if (n == 0 || n > 125) {
+        return -SIM_EX_ILLEGAL_VALUE;
+    }
+    if ((uint32_t) start + n > config.n_reg) {
+        return -SIM_EX_ILLEGAL_ADDRESS;
+    }
+
+    res[0] = (uint8_t)(n * 2);
+
+    pthread_mutex_lock(&dev->mutex);
+    for (uint16_t i = 0; i < n; i++) {
+        uint16_t value = 0;
+
+        if (function == MODBUS_READ_HOLD_REG) {
+            value = dev->hold[start + i];
+        } else {
+            value = wave_value(dev, start + i, now, seed);
+        }
+
+        res[1 + i * 2] = (uint8_t)(value >> 8);
+        res[2 + i * 2] = (uint8_t)(value & 0xff);
+    }
+    pthread_mutex_unlock(&dev->mutex);
+
+    return 1 + res[0];
+}
+
+static int device_write(struct sim_device *dev, uint8_t function,
+                        const uint8_t *data, uint16_t data_len, uint8_t *res)
+{
+    uint16_t start = 0, n = 0;
+
+    if (data_len < 4) {
+        return -SIM_EX_ILLEGAL_VALUE;
+    }
+    start = (uint16_t)(data[0] << 8 | data[1]);
+    n     = (uint16_t)(data[2] << 8 | data[3]);
+
+    switch (function) {
+    case MODBUS_WRITE_S_COIL:
+    case MODBUS_WRITE_S_HOLD_REG:
+        if (start >= config.n_reg) {
+            return -SIM_EX_ILLEGAL_ADDRESS;
+        }
+        if (function == MODBUS_WRITE_S_COIL && n != 0xff00 && n != 0x0000) {
+            return -SIM_EX_ILLEGAL_VALUE;
+        }
+
+        pthread_mutex_lock(&dev->mutex);
+        if (function == MODBUS_WRITE_S_COIL) {
+            dev->coil[start] = n == 0xff00;
+        } else {
+            dev->hold[start] = n;
+        }
+        pthread_mutex_unlock(&dev->mutex);
+        break;
+    case MODBUS_WRITE_M_COIL:
+    case MODBUS_WRITE_M_HOLD_REG: {
+        uint16_t max    = function == MODBUS_WRITE_M_COIL ? 1968 : 123;
+        uint8_t  n_byte = 0;
+
+        if (data_len < 5 || n == 0 || n > max) {
+            return -SIM_EX_ILLEGAL_VALUE;
+        }
+        n_byte = data[4];
+        if (n_byte != (function == MODBUS_WRITE_M_COIL ? (n + 7) / 8 : n * 2) ||
+            data_len < 5 + n_byte) {
+            return -SIM_EX_ILLEGAL_VALUE;
+        }
+        if ((uint32_t) start + n > config.n_reg) {
+            return -SIM_EX_ILLEGAL_ADDRESS;
+        }
+
+        pthread_mutex_lock(&dev->mutex);
+        for (uint16_t i = 0; i < n; i++) {
+            if (function == MODBUS_WRITE_M_COIL) {
+                dev->coil[start + i] = (data[5 + i / 8] >> (i % 8)) & 0x1;
+            } else {
+                dev->hold[start + i] =
+                    (uint16_t)(data[5 + i * 2] << 8 | data[6 + i * 2]);
+            }
+        }
+        pthread_mutex_unlock(&dev->mutex);
+        break;
+    }
+    default:
+        return -SIM_EX_ILLEGAL_FUNCTION;
+    }
+
+    memcpy(res, data, 4);
+    return 4;
+}
+
+// Executes one PDU against the device, returns the length of the response
+// data following the function code or a negated exception code.
+static int device_exec(struct sim_device *dev, uint8_t function,
+                       const uint8_t *data, uint16_t data_len, uint8_t *res,
+                       unsigned *seed)
+{
+    switch (function) {
+    case MODBUS_READ_COIL:
+    case MODBUS_READ_INPUT:
+        return device_read_bits(dev, function, data, data_len, res, seed);
+    case MODBUS_READ_HOLD_REG:
+    case MODBUS_READ_INPUT_REG:
+        return device_read_regs(dev, function, data, data_len, res, seed);
+    case MODBUS_WRITE_S_COIL:
+    case MODBUS_WRITE_S_HOLD_REG:
+    case MODBUS_WRITE_M_COIL:
+    case MODBUS_WRITE_M_HOLD_REG:
+        return device_write(dev, function, data, data_len, res);
+    default:
+        return -SIM_EX_ILLEGAL_FUNCTION;
+    }
+}
+
+static void conn_send(struct sim_conn *conn, const uint8_t *buf, uint16_t len)
+{
+    ssize_t ret = send(conn->handle.fd, buf, len, MSG_NOSIGNAL);
+
+    if (ret == len) {
+        STAT_ADD(responses, 1);
+    } else {
+        STAT_ADD(drops, 1);
+    }
+}
+
+static void conn_close(struct sim_conn *conn)
+{
+    if (conn->closed) {
+        return;
+    }
+
+    epoll_ctl(conn->worker->epfd, EPOLL_CTL_DEL, conn->handle.fd, NULL);
+    close(conn->handle.fd);
+    conn->closed = true;
+}
+
+// A closed connection is only released once no delayed response refers to it.
+static void conn_release(struct sim_conn *conn)
+{
+    if (conn->closed && conn->inflight == 0) {
+        free(conn);
+    }
+}
+
+static void conn_watch(struct sim_conn *conn, bool pause)
+{
+    struct epoll_event ev = {
+        .events   = pause ? EPOLLRDHUP : EPOLLIN | EPOLLRDHUP,
+        .data.ptr = conn,
+    };
+
+    if (conn->closed || conn->paused == pause) {
+        return;
+    }
+
+    conn->paused = pause;
+    epoll_ctl(conn->worker->epfd, EPOLL_CTL_MOD, conn->handle.fd, &ev);
+}
+
+static void worker_schedule(struct sim_worker *w, struct sim_pending *p)
+{
+    struct sim_pending *at = w->pending ? w->pending->prev : NULL;
+
+    // responses are mostly produced in due order, search from the tail
+    while (at != NULL && at->due > p->due) {
+        at = at == w->pending ? NULL : at->prev;
+    }
+
+    if (at == NULL) {
+        DL_PREPEND(w->pending, p);
+    } else if (at->next == NULL) {
+        DL_APPEND(w->pending, p);
+    } else {
+        p->next        = at->next;
+        p->prev        = at;
+        at->next->prev = p;
+        at->next       = p;
+    }
+}
+
+static void conn_handle_frame(struct sim_conn *conn, const uint8_t *req,
+                              uint16_t len)
+{
+    struct sim_worker *   w      = conn->worker;
+    struct modbus_header *header = (struct modbus_header *) req;
+    struct modbus_code *  code   = (struct modbus_code *) &header[1];
+    uint16_t              hlen   = sizeof(*header) + sizeof(*code);
+    struct sim_device *   dev    = NULL;
+    struct sim_pending *  p      = NULL;
+    int                   ret    = 0;
+    int32_t               delay  = 0;
+
+    STAT_ADD(requests, 1);
+
+    // an absent slave never answers, just like a dead device behind a gateway
+    if (code->slave_id == 0 || code->slave_id > config.n_slave ||
+        chance(w, config.drop_rate)) {
+        STAT_ADD(drops, 1);
+        return;
+    }
+
+    dev = &devices[(size_t) conn->index * config.n_slave + code->slave_id - 1];
+    p   = calloc(1, sizeof(struct sim_pending));
+    memcpy(p->buf, req, hlen);
+
+    if (chance(w, config.exception_rate)) {
+        ret = -SIM_EX_DEVICE_FAILURE;
+    } else {
+        ret = device_exec(dev, code->function, req + hlen, len - hlen,
+                          p->buf + hlen, &w->seed);
+    }
+
+    if (ret < 0) {
+        p->buf[hlen - 1] |= 0x80;
+        p->buf[hlen] = (uint8_t)(-ret);
+        ret          = 1;
+        STAT_ADD(exceptions, 1);
+    }
+
+    p->len = hlen + ret;
+    ((struct modbus_header *) p->buf)->len =
+        htons((uint16_t)(sizeof(*code) + ret));
+
+    delay = (int32_t) dev->rtt;
+    if (config.jitter > 0) {
+        delay += (int32_t)(rand_r(&w->seed) % (2 * config.jitter + 1)) -
+            (int32_t) config.jitter;
+    }
+
+    if (delay <= 0) {
+        conn_send(conn, p->buf, p->len);
+        free(p);
+        return;
+    }
+
+    p->conn = conn;
+    p->due  = neu_time_ms() + delay;
+    conn->inflight += 1;
+    STAT_ADD(delayed, 1);
+    worker_schedule(w, p);
+}
+
+static void conn_process(struct sim_conn *conn)
+{
+    uint16_t offset = 0;
+
+    while (!conn->closed && conn->inflight < config.max_inflight) {
+        struct modbus_header *header = NULL;
+        uint16_t              frame  = 0;
+
+        if ((size_t)(conn->len - offset) < sizeof(struct modbus_header)) {
+            break;
+        }
+
+        header = (struct modbus_header *) (conn->buf + offset);
+        frame  = sizeof(struct modbus_header) + ntohs(header->len);
+        if (header->protocol != 0 || ntohs(header->len) < 2 ||
+            frame > SIM_FRAME_MAX) {
+            nlog_warn("invalid mbap header, close client: %d",
+                      conn->handle.fd);
+            conn_close(conn);
+            return;
+        }
+        if (conn->len - offset < frame) {
+            break;
+        }
+
+        conn_handle_frame(conn, conn->buf + offset, frame);
+        offset += frame;
+    }
+
+    if (offset > 0) {
+        memmove(conn->buf, conn->buf + offset, conn->len - offset);
+        conn->len -= offset;
+    }
+
+    conn_watch(conn, conn->inflight >= config.max_inflight);
+}
+
+static void conn_readable(struct sim_conn *conn, uint32_t events)
+{
+    if (events & EPOLLIN) {
+        ssize_t ret = recv(conn->handle.fd, conn->buf + conn->len,
+                           sizeof(conn->buf) - conn->len, 0);
+
+        if (ret > 0) {
+            conn->len += (uint16_t) ret;
+            conn_process(conn);
+            return;
+        }
+        if (ret < 0 && (errno == EAGAIN || errno == EINTR)) {
+            return;
+        }
+    } else if (!(events & (EPOLLRDHUP | EPOLLHUP | EPOLLERR))) {
+        return;
+    }
+
+    conn_close(conn);
+}
+
+static void listener_accept(struct sim_listener *l)
+{
+    while (true) {
+        struct sim_worker *w  = NULL;
+        struct sim_conn *  c  = NULL;
+        int                fd = accept4(l->handle.fd, NULL, NULL,
+                         SOCK_NONBLOCK | SOCK_CLOEXEC);
+        int                on = 1;
+
+        if (fd < 0) {
+            if (errno != EAGAIN && errno != EINTR) {
+                nlog_warn("accept on port %d fail: %s", config.port + l->index,
+                          strerror(errno));
+            }
+            return;
+        }
+
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+
+        w = &workers[__atomic_fetch_add(&next_worker, 1, __ATOMIC_RELAXED) %
+                     config.n_worker];
+        c = calloc(1, sizeof(struct sim_conn));
+        c->handle.type = SIM_HANDLE_CONN;
+        c->handle.fd   = fd;
+        c->index       = l->index;
+        c->worker      = w;
+
+        struct epoll_event ev = {
+            .events   = EPOLLIN | EPOLLRDHUP,
+            .data.ptr = c,
+        };
+
+        if (epoll_ctl(w->epfd, EPOLL_CTL_ADD, fd, &ev) != 0) {
+            close(fd);
+            free(c);
+            continue;
+        }
+
+        STAT_ADD(conns, 1);
+    }
+}
+
+static void worker_flush(struct sim_worker *w, int64_t now)
+{
+    while (w->pending != NULL && w->pending->due <= now) {
+        struct sim_pending *p    = w->pending;
+        struct sim_conn *   conn = p->conn;
+
+        DL_DELETE(w->pending, p);
+        conn->inflight -= 1;
+
+        if (conn->closed) {
+            STAT_ADD(drops, 1);
+            conn_release(conn);
+        } else {
+            conn_send(conn, p->buf, p->len);
+            conn_process(conn);
+            conn_release(conn);
+        }
+
+        free(p);
+    }
+}
+
+static void *worker_run(void *arg)
+{
+    struct sim_worker *w = (struct sim_worker *) arg;
+    struct epoll_event events[SIM_EPOLL_EVENTS];
+
+    while (!exiting) {
+        int timeout = SIM_IDLE_WAIT;
+        int n       = 0;
+
+        if (w->pending != NULL) {
+            int64_t wait = w->pending->due - neu_time_ms();
+
+            timeout = wait < 0 ? 0 : wait < timeout ? (int) wait : timeout;
+        }
+
+        n = epoll_wait(w->epfd, events, SIM_EPOLL_EVENTS, timeout);
+        for (int i = 0; i < n; i++) {
+            struct sim_handle *h = (struct sim_handle *) events[i].data.ptr;
+
+            if (h->type == SIM_HANDLE_LISTENER) {
+                listener_accept((struct sim_listener *) h);
+            } else {
+                struct sim_conn *conn = (struct sim_conn *) h;
+
+                conn_readable(conn, events[i].events);
+                conn_release(conn);
+            }
+        }
+
+        worker_flush(w, neu_time_ms());
+    }
+
+    return NULL;
+}
+
+static int listener_open(struct sim_listener *l, uint16_t index)
+{
+    int                     on   = 1;
+    struct sockaddr_storage addr = { 0 };
+    socklen_t               len  = 0;
+    uint16_t                port = (uint16_t)(config.port + index);
+
+    if (config.ipv6) {
+        struct sockaddr_in6 *in6 = (struct sockaddr_in6 *) &addr;
+
+        in6->sin6_family = AF_INET6;
+        in6->sin6_port   = htons(port);
+        in6->sin6_addr   = in6addr_any;
+        len              = sizeof(struct sockaddr_in6);
+    } else {
+        struct sockaddr_in *in = (struct sockaddr_in *) &addr;
+
+        in->sin_family      = AF_INET;
+        in->sin_port        = htons(port);
+        in->sin_addr.s_addr = htonl(INADDR_ANY);
+        len                 = sizeof(struct sockaddr_in);
+    }
+
+    l->handle.type = SIM_HANDLE_LISTENER;
+    l->index       = index;
+    l->handle.fd   = socket(addr.ss_family,
+                          SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (l->handle.fd < 0) {
+        return -1;
+    }
+
+    setsockopt(l->handle.fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+    if (bind(l->handle.fd, (struct sockaddr *) &addr, len) != 0 ||
+        listen(l->handle.fd, 1024) != 0) {
+        nlog_error("listen on port %d fail: %s", port, strerror(errno));
+        close(l->handle.fd);
+        l->handle.fd = -1;
+        return -1;
+    }
+
+    return 0;
+}
+
+static int devices_init(void)
+{
+    size_t   n    = (size_t) config.n_port * config.n_slave;
+    unsigned seed = config.seed;
+
+    devices = calloc(n, sizeof(struct sim_device));
+    if (devices == NULL) {
+        return -1;
+    }
+
+    for (size_t i = 0; i < n; i++) {
+        struct sim_device *dev = &devices[i];
+
+        pthread_mutex_init(&dev->mutex, NULL);
+        dev->hold  = calloc(config.n_reg, sizeof(uint16_t));
+        dev->coil  = calloc(config.n_reg, sizeof(uint8_t));
+        dev->phase = (double) rand_r(&seed) / RAND_MAX;
+        dev->rtt   = config.rtt;
+        if (config.rtt_spread > 0) {
+            dev->rtt += rand_r(&seed) % (config.rtt_spread + 1);
+        }
+
+        if (dev->hold == NULL || dev->coil == NULL) {
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+static void devices_uninit(void)
+{
+    size_t n = (size_t) config.n_port * config.n_slave;
+
+    for (size_t i = 0; devices != NULL && i < n; i++) {
+        pthread_mutex_destroy(&devices[i].mutex);
+        free(devices[i].hold);
+        free(devices[i].coil);
+    }
+
+    free(devices);
+}
+
+static void raise_fd_limit(void)
+{
+    struct rlimit limit = { 0 };
+
+    if (getrlimit(RLIMIT_NOFILE, &limit) == 0 &&
+        limit.rlim_cur < limit.rlim_max) {
+        limit.rlim_cur = limit.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &limit);
+    }
+}
+
+static void print_stats(void)
+{
+    printf("conns: %" PRIu64 ", requests: %" PRIu64 ", responses: %" PRIu64
+           ", drops: %" PRIu64 ", exceptions: %" PRIu64 ", delayed: %" PRIu64
+           "\n",
+           STAT_GET(conns), STAT_GET(requests), STAT_GET(responses),
+           STAT_GET(drops), STAT_GET(exceptions), STAT_GET(delayed));
+    fflush(stdout);
+}
+
+static int parse_wave(const char *s, sim_wave_e *wave)
+{
+    static const char *names[] = { "const", "ramp", "sine", "square",
+                                   "random" };
+
+    for (size_t i = 0; i < sizeof(names) / sizeof(names[0]); i++) {
+        if (strcmp(s, names[i]) == 0) {
+            *wave = (sim_wave_e) i;
+            return 0;
+        }
+    }
+
+    return -1;
+}
+
+static inline void usage(const char *prog)
+{
+    // clang-format off
+    const char *text =
+    "USAGE:\n"
+    "    %s [OPTIONS]\n\n"
+    "OPTIONS:\n"
+    "    -p, --port           first listening port (default 5502)\n"
+    "    -n, --ports          number of consecutive ports (default 1)\n"
+    "    -s, --slaves         slave ids 1..N served on each port (default 1)\n"
+    "    -r, --registers      registers per area and slave (default 10000)\n"
+    "    -t, --threads        epoll worker threads (default online cpus)\n"
+    "    -6, --ipv6           listen on ipv6\n"
+    "        --rtt            response delay in ms (default 0)\n"
+    "        --rtt_spread     extra per device delay, 0..N ms (default 0)\n"
+    "        --jitter         per response jitter, +-N ms (default 0)\n"
+    "        --drop           ratio of requests left unanswered, 0..1\n"
+    "        --exception      ratio of requests answered with exception 4\n"
+    "    -i, --inflight       pipelined requests per connection (default 1)\n"
+    "    -w, --wave           input waveform: const, ramp, sine, square,\n"
+    "                         random (default sine)\n"
+    "        --period         waveform period in ms (default 60000)\n"
+    "        --seed           random seed (default 1)\n"
+    "        --stats          stats interval in seconds, 0 off (default 10)\n"
+    "    -h, --help           show this help message\n"
+    "\n"
+    "Input registers and discrete inputs follow the waveform, holding\n"
+    "registers and coils keep written values.\n"
+    "\n";
+    // clang-format on
+
+    fprintf(stderr, text, prog);
+}
+
+int main(int argc, char *argv[])
+{
+    enum {
+        OPT_RTT = 0x100,
+        OPT_RTT_SPREAD,
+        OPT_JITTER,
+        OPT_DROP,
+        OPT_EXCEPTION,
+        OPT_PERIOD,
+        OPT_SEED,
+        OPT_STATS,
+    };
+
+    struct option long_options[] = {
+        { "help", no_argument, NULL, 'h' },
+        { "port", required_argument, NULL, 'p' },
+        { "ports", required_argument, NULL, 'n' },
+        { "slaves", required_argument, NULL, 's' },
+        { "registers", required_argument, NULL, 'r' },
+        { "threads", required_argument, NULL, 't' },
+        { "ipv6", no_argument, NULL, '6' },
+        { "inflight", required_argument, NULL, 'i' },
+        { "wave", required_argument, NULL, 'w' },
+        { "rtt", required_argument, NULL, OPT_RTT },
+        { "rtt_spread", required_argument, NULL, OPT_RTT_SPREAD },
+        { "jitter", required_argument, NULL, OPT_JITTER },
+        { "drop", required_argument, NULL, OPT_DROP },
+        { "exception", required_argument, NULL, OPT_EXCEPTION },
+        { "period", required_argument, NULL, OPT_PERIOD },
+        { "seed", required_argument, NULL, OPT_SEED },
+        { "stats", required_argument, NULL, OPT_STATS },
+        { NULL, 0, NULL, 0 },
+    };
+
+    int c            = 0;
+    int option_index = 0;
+    int elapsed      = 0;
+
+    while ((c = getopt_long(argc, argv, "hp:n:s:r:t:6i:w:", long_options,
+                            &option_index)) != -1) {
+        switch (c) {
+        case 'h':
+            usage(argv[0]);
+            return 0;
+        case 'p':
+            config.port = (uint16_t) atoi(optarg);
+            break;
+        case 'n':
+            config.n_port = (uint16_t) atoi(optarg);
+            break;
+        case 's':
+            config.n_slave = (uint16_t) atoi(optarg);
+            break;
+        case 'r':
+            config.n_reg = (uint32_t) atoi(optarg);
+            break;
+        case 't':
+            config.n_worker = atoi(optarg);
+            break;
+        case '6':
+            config.ipv6 = true;
+            break;
+        case 'i':
+            config.max_inflight = (uint16_t) atoi(optarg);
+            break;
+        case 'w':
+            if (parse_wave(optarg, &config.wave) != 0) {
+                printf("wave no match!input:const ramp sine square random\n");
+                return -1;
+            }
+            break;
+        case OPT_RTT:
+            config.rtt = (uint32_t) atoi(optarg);
+            break;
+        case OPT_RTT_SPREAD:
+            config.rtt_spread = (uint32_t) atoi(optarg);
+            break;
+        case OPT_JITTER:
+            config.jitter = (uint32_t) atoi(optarg);
+            break;
+        case OPT_DROP:
+            config.drop_rate = atof(optarg);
+            break;
+        case OPT_EXCEPTION:
+            config.exception_rate = atof(optarg);
+            break;
+        case OPT_PERIOD:
+            config.period = (uint32_t) atoi(optarg);
+            break;
+        case OPT_SEED:
+            config.seed = (unsigned) atoi(optarg);
+            break;
+        case OPT_STATS:
+            config.stats_interval = atoi(optarg);
+            break;
+        default:
+            usage(argv[0]);
+            return -1;
+        }
+    }
+
+    if (config.n_worker <= 0) {
+        config.n_worker = (int) sysconf(_SC_NPROCESSORS_ONLN);
+    }
+    if (config.n_worker > SIM_MAX_WORKERS) {
+        config.n_worker = SIM_MAX_WORKERS;
+    }
+
+    if (config.port <= 1024 || config.n_port == 0 ||
+        config.n_port > SIM_MAX_PORTS ||
+        (uint32_t) config.port + config.n_port > 65536) {
+        printf("invalid port range: %d + %d\n", config.port, config.n_port);
+        return -1;
+    }
+    if (config.n_slave == 0 || config.n_slave > SIM_MAX_SLAVES) {
+        printf("slaves out of range: 1 ~ %d\n", SIM_MAX_SLAVES);
+        return -1;
+    }
+    if (config.n_reg == 0 || config.n_reg > 65536 || config.period == 0 ||
+        config.max_inflight == 0) {
+        printf("registers, period and inflight must be positive\n");
+        return -1;
+    }
+
+    zlog_init("./config/dev.conf");
+    neuron = zlog_get_category("neuron");
+
+    signal(SIGINT, sig_handler);
+    signal(SIGTERM, sig_handler);
+    signal(SIGPIPE, SIG_IGN);
+    raise_fd_limit();
+
+    if (devices_init() != 0) {
+        printf("out of memory for %d ports x %d slaves\n", config.n_port,
+               config.n_slave);
+        devices_uninit();
+        return -1;
+    }
+
+    for (int i = 0; i < config.n_worker; i++) {
+        workers[i].epfd = epoll_create1(EPOLL_CLOEXEC);
+        workers[i].seed = config.seed + (unsigned) i;
+    }
+
+    listeners = calloc(config.n_port, sizeof(struct sim_listener));
+    for (uint16_t i = 0; i < config.n_port; i++) {
+        struct sim_worker *w = &workers[i % config.n_worker];
+
+        if (listener_open(&listeners[i], i) != 0) {
+            printf("listen on port %d fail\n", config.port + i);
+            return -1;
+        }
+
+        struct epoll_event ev = {
+            .events   = EPOLLIN,
+            .data.ptr = &listeners[i],
+        };
+        epoll_ctl(w->epfd, EPOLL_CTL_ADD, listeners[i].handle.fd, &ev);
+    }
+
+    for (int i = 0; i < config.n_worker; i++) {
+        pthread_create(&workers[i].thread, NULL, worker_run, &workers[i]);
+    }
+
+    nlog_notice("modbus load simulator: ports %d-%d, slaves: %d, workers: %d, "
+                "rtt: %u(+%u)ms, jitter: %ums, drop: %.3f, exception: %.3f, "
+                "inflight: %d",
+                config.port, config.port + config.n_port - 1, config.n_slave,
+                config.n_worker, config.rtt, config.rtt_spread, config.jitter,
+                config.drop_rate, config.exception_rate, config.max_inflight);
+
+    while (!exiting) {
+        sleep(1);
+        elapsed += 1;
+        if (config.stats_interval > 0 && elapsed % config.stats_interval == 0) {
+            print_stats();
+        }
+    }
+
+    for (int i = 0; i < config.n_worker; i++) {
+        pthread_join(workers[i].thread, NULL);
+        close(workers[i].epfd);
+    }
+    for (uint16_t i = 0; i < config.n_port; i++) {
+        close(listeners[i].handle.fd);
+    }
+
+    print_stats();
+    free(listeners);
+    devices_uninit();
+    return 0;
+}
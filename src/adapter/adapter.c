@@ -39,6 +39,7 @@
 #include "adapter_internal.h"
 #include "base/msg_internal.h"
 #include "driver/driver_internal.h"
+#include "driver_registry.h"
 #include "errcodes.h"
 #include "persist/persist.h"
 #include "plugin.h"
@@ -61,15 +62,20 @@ static int adapter_register_metric(neu_adapter_t *adapter, const char *name,
 static int adapter_update_metric(neu_adapter_t *adapter,
                                  const char *metric_name, uint64_t n,
                                  const char *group);
+static neu_histogram_t *adapter_metric_histogram(neu_adapter_t *adapter,
+                                                 const char *   metric_name);
+static void adapter_unregister_metric(neu_adapter_t *adapter, const char *name);
 inline static void reply(neu_adapter_t *adapter, neu_reqresp_head_t *header,
                          void *data);
 
 static const adapter_callbacks_t callback_funs = {
-    .command         = adapter_command,
-    .response        = adapter_response,
-    .responseto      = adapter_responseto,
-    .register_metric = adapter_register_metric,
-    .update_metric   = adapter_update_metric,
+    .command           = adapter_command,
+    .response          = adapter_response,
+    .responseto        = adapter_responseto,
+    .register_metric   = adapter_register_metric,
+    .update_metric     = adapter_update_metric,
+    .metric_histogram  = adapter_metric_histogram,
+    .unregister_metric = adapter_unregister_metric,
 };
 
 static __thread int create_adapter_error = 0;
@@ -78,17 +84,20 @@ static __thread int create_adapter_error = 0;
     adapter_register_metric(adapter, name, name##_HELP, name##_TYPE, init);
 
 #define REGISTER_DRIVER_METRICS(adapter)                     \
-    REGISTER_METRIC(adapter, NEU_METRIC_LINK_STATE,          \
-                    NEU_NODE_LINK_STATE_DISCONNECTED);       \
-    REGISTER_METRIC(adapter, NEU_METRIC_RUNNING_STATE,       \
-                    NEU_NODE_RUNNING_STATE_INIT);            \
-    REGISTER_METRIC(adapter, NEU_METRIC_LAST_RTT_MS,         \
-                    NEU_METRIC_LAST_RTT_MS_MAX);             \
-    REGISTER_METRIC(adapter, NEU_METRIC_SEND_BYTES, 0);      \
-    REGISTER_METRIC(adapter, NEU_METRIC_RECV_BYTES, 0);      \
-    REGISTER_METRIC(adapter, NEU_METRIC_TAGS_TOTAL, 0);      \
-    REGISTER_METRIC(adapter, NEU_METRIC_TAG_READS_TOTAL, 0); \
-    REGISTER_METRIC(adapter, NEU_METRIC_TAG_READ_ERRORS_TOTAL, 0);
+    REGISTER_METRIC(adapter, NEU_METRIC_LINK_STATE,                \
+                    NEU_NODE_LINK_STATE_DISCONNECTED);             \
+    REGISTER_METRIC(adapter, NEU_METRIC_RUNNING_STATE,             \
+                    NEU_NODE_RUNNING_STATE_INIT);                  \
+    REGISTER_METRIC(adapter, NEU_METRIC_LAST_RTT_MS,               \
+                    NEU_METRIC_LAST_RTT_MS_MAX);                   \
+    REGISTER_METRIC(adapter, NEU_METRIC_READ_RTT_MS, 0);           \
+    REGISTER_METRIC(adapter, NEU_METRIC_SEND_BYTES, 0);            \
+    REGISTER_METRIC(adapter, NEU_METRIC_RECV_BYTES, 0);            \
+    REGISTER_METRIC(adapter, NEU_METRIC_TAGS_TOTAL, 0);            \
+    REGISTER_METRIC(adapter, NEU_METRIC_TAG_READS_TOTAL, 0);       \
+    REGISTER_METRIC(adapter, NEU_METRIC_TAG_READ_ERRORS_TOTAL, 0); \
+    REGISTER_METRIC(adapter, NEU_METRIC_CACHE_UPDATE_US, 0);       \
+    REGISTER_METRIC(adapter, NEU_METRIC_REPORT_BUILD_US, 0);
 
 #define REGISTER_APP_METRICS(adapter)                              \
     REGISTER_METRIC(adapter, NEU_METRIC_LINK_STATE,                \
@@ -97,7 +106,8 @@ static __thread int create_adapter_error = 0;
                     NEU_NODE_RUNNING_STATE_INIT);                  \
     REGISTER_METRIC(adapter, NEU_METRIC_SEND_MSGS_TOTAL, 0);       \
     REGISTER_METRIC(adapter, NEU_METRIC_SEND_MSG_ERRORS_TOTAL, 0); \
-    REGISTER_METRIC(adapter, NEU_METRIC_RECV_MSGS_TOTAL, 0);
+    REGISTER_METRIC(adapter, NEU_METRIC_RECV_MSGS_TOTAL, 0);       \
+    REGISTER_METRIC(adapter, NEU_METRIC_QUEUE_WAIT_US, 0);
 
 int neu_adapter_error()
 {
@@ -118,12 +128,20 @@ static void *adapter_consumer(void *arg)
         uint32_t            n      = adapter_msg_q_pop(adapter->msg_q, &msg);
         neu_reqresp_head_t *header = neu_msg_get_header(msg);
 
+        neu_reqresp_trans_data_t *data =
+            (neu_reqresp_trans_data_t *) &header[1];
+
+        if (NULL != adapter->queue_wait && data->send_us > 0) {
+            neu_histogram_record(adapter->queue_wait,
+                                 neu_time_us() - data->send_us);
+        }
+
         nlog_debug("adapter(%s) recv msg from: %s %p, type: %s, %u",
                    adapter->name, header->sender, header->ctx,
                    neu_reqresp_type_string(header->type), n);
         adapter->module->intf_funs->request(
-            adapter->plugin, (neu_reqresp_head_t *) header, &header[1]);
-        neu_trans_data_free((neu_reqresp_trans_data_t *) &header[1]);
+            adapter->plugin, (neu_reqresp_head_t *) header, data);
+        neu_trans_data_free(data);
         neu_msg_free(msg);
     }
 
@@ -188,19 +206,21 @@ neu_adapter_t *neu_adapter_create(neu_adapter_info_t *info, bool load)
         return NULL;
     }
 
-    adapter->name                    = strdup(info->name);
-    adapter->events                  = neu_event_new();
-    adapter->state                   = NEU_NODE_RUNNING_STATE_INIT;
-    adapter->handle                  = info->handle;
-    adapter->cb_funs.command         = callback_funs.command;
-    adapter->cb_funs.response        = callback_funs.response;
-    adapter->cb_funs.responseto      = callback_funs.responseto;
-    adapter->cb_funs.register_metric = callback_funs.register_metric;
-    adapter->cb_funs.update_metric   = callback_funs.update_metric;
-    adapter->module                  = info->module;
-    adapter->timestamp_lev           = 0;
-    adapter->trans_data_port         = 0;
-    adapter->log_level               = ZLOG_LEVEL_NOTICE;
+    adapter->name                      = strdup(info->name);
+    adapter->events                    = neu_event_new();
+    adapter->state                     = NEU_NODE_RUNNING_STATE_INIT;
+    adapter->handle                    = info->handle;
+    adapter->cb_funs.command           = callback_funs.command;
+    adapter->cb_funs.response          = callback_funs.response;
+    adapter->cb_funs.responseto        = callback_funs.responseto;
+    adapter->cb_funs.register_metric   = callback_funs.register_metric;
+    adapter->cb_funs.update_metric     = callback_funs.update_metric;
+    adapter->cb_funs.metric_histogram  = callback_funs.metric_histogram;
+    adapter->cb_funs.unregister_metric = callback_funs.unregister_metric;
+    adapter->module                    = info->module;
+    adapter->timestamp_lev             = 0;
+    adapter->trans_data_port           = 0;
+    adapter->log_level                 = ZLOG_LEVEL_NOTICE;
 
     // use port number to distinguish each Linux abstract domain socket
     uint16_t           port  = neu_manager_get_port();
@@ -226,10 +246,20 @@ neu_adapter_t *neu_adapter_create(neu_adapter_info_t *info, bool load)
     case NEU_NA_TYPE_DRIVER:
         if (adapter->module->display) {
             REGISTER_DRIVER_METRICS(adapter);
+            adapter->last_rtt = neu_node_metrics_entry(adapter->metrics,
+                                                       NEU_METRIC_LAST_RTT_MS);
+            adapter->read_rtt = neu_node_metrics_histogram(
+                adapter->metrics, NEU_METRIC_READ_RTT_MS);
         }
         neu_adapter_driver_init((neu_adapter_driver_t *) adapter);
         break;
     case NEU_NA_TYPE_APP: {
+        if (adapter->module->display) {
+            REGISTER_APP_METRICS(adapter);
+            adapter->queue_wait = neu_node_metrics_histogram(
+                adapter->metrics, NEU_METRIC_QUEUE_WAIT_US);
+        }
+
         adapter->msg_q = adapter_msg_q_new(adapter->name, 1024);
         pthread_create(&adapter->consumer_tid, NULL, adapter_consumer,
                        (void *) adapter);
@@ -250,11 +280,6 @@ neu_adapter_t *neu_adapter_create(neu_adapter_info_t *info, bool load)
         param.fd       = adapter->trans_data_fd;
 
         adapter->trans_data_io = neu_event_add_io(adapter->events, param);
-
-        if (adapter->module->display) {
-            REGISTER_APP_METRICS(adapter);
-        }
-
         break;
     }
     }
@@ -336,6 +361,8 @@ int neu_adapter_rename(neu_adapter_t *adapter, const char *new_name)
 
     if (NEU_NA_TYPE_DRIVER == adapter->module->type) {
         neu_adapter_driver_stop_group_timer((neu_adapter_driver_t *) adapter);
+        neu_driver_registry_rename(old_name, name);
+        neu_adapter_driver_rename_snapshot(old_name, name);
     }
 
     // fix metrics
@@ -419,6 +446,13 @@ static int adapter_register_metric(neu_adapter_t *adapter, const char *name,
     return 0;
 }
 
+static void adapter_unregister_metric(neu_adapter_t *adapter, const char *name)
+{
+    if (NULL != adapter->metrics) {
+        neu_node_metrics_del(adapter->metrics, name);
+    }
+}
+
 static int adapter_update_metric(neu_adapter_t *adapter,
                                  const char *metric_name, uint64_t n,
                                  const char *group)
@@ -427,7 +461,24 @@ static int adapter_update_metric(neu_adapter_t *adapter,
         return -1;
     }
 
-    return neu_node_metrics_update(adapter->metrics, group, metric_name, n);
+    const neu_metric_entry_t *entry = neu_node_metrics_update_entry(
+        adapter->metrics, group, metric_name, n);
+    if (NULL == entry) {
+        return -1;
+    }
+
+    if (entry == adapter->last_rtt && NULL != adapter->read_rtt &&
+        n < NEU_METRIC_LAST_RTT_MS_MAX) {
+        neu_histogram_record(adapter->read_rtt, n);
+    }
+
+    return 0;
+}
+
+static neu_histogram_t *adapter_metric_histogram(neu_adapter_t *adapter,
+                                                 const char *   metric_name)
+{
+    return neu_node_metrics_histogram(adapter->metrics, metric_name);
 }
 
 static int adapter_command(neu_adapter_t *adapter, neu_reqresp_head_t header,
@@ -493,6 +544,11 @@ static int adapter_command(neu_adapter_t *adapter, neu_reqresp_head_t header,
         strcpy(pheader->receiver, cmd->driver);
         break;
     }
+    case NEU_REQ_READ_HISTORY: {
+        neu_req_read_history_t *cmd = (neu_req_read_history_t *) data;
+        strcpy(pheader->receiver, cmd->driver);
+        break;
+    }
     case NEU_REQ_WRITE_TAG: {
         neu_req_write_tag_t *cmd = (neu_req_write_tag_t *) data;
         strcpy(pheader->receiver, cmd->driver);
@@ -627,6 +683,7 @@ static int adapter_responseto(neu_adapter_t *     adapter,
     }
     neu_reqresp_head_t *pheader = neu_msg_get_header(msg);
     strcpy(pheader->sender, adapter->name);
+    ((neu_reqresp_trans_data_t *) &pheader[1])->send_us = neu_time_us();
 
     int ret = neu_send_msg_to(adapter->control_fd, &dst, msg);
     if (0 != ret) {
@@ -796,6 +853,28 @@ static int adapter_loop(enum neu_event_io_type type, int fd, void *usr_data)
             (neu_resp_read_group_paginate_t *) &header[1]);
         neu_msg_free(msg);
         break;
+    case NEU_RESP_READ_HISTORY:
+        adapter->module->intf_funs->request(
+            adapter->plugin, (neu_reqresp_head_t *) header, &header[1]);
+        neu_resp_read_history_free((neu_resp_read_history_t *) &header[1]);
+        neu_msg_free(msg);
+        break;
+    case NEU_REQ_READ_HISTORY: {
+        neu_resp_error_t error = { 0 };
+
+        if (adapter->module->type == NEU_NA_TYPE_DRIVER) {
+            neu_adapter_driver_read_history((neu_adapter_driver_t *) adapter,
+                                            header);
+        } else {
+            neu_req_read_history_fini((neu_req_read_history_t *) &header[1]);
+            error.error  = NEU_ERR_GROUP_NOT_ALLOW;
+            header->type = NEU_RESP_ERROR;
+            neu_msg_exchange(header);
+            reply(adapter, header, &error);
+        }
+
+        break;
+    }
     case NEU_REQ_READ_GROUP_PAGINATE: {
         neu_resp_error_t error = { 0 };
 
@@ -1398,10 +1477,23 @@ static int adapter_loop(enum neu_event_io_type type, int fd, void *usr_data)
     case NEU_REQ_UPDATE_LOG_LEVEL: {
         neu_req_update_log_level_t *cmd =
             (neu_req_update_log_level_t *) &header[1];
-        neu_resp_error_t error = { 0 };
-        adapter->log_level     = cmd->log_level;
-        zlog_level_switch(neu_plugin_to_plugin_common(adapter->plugin)->log,
-                          cmd->log_level);
+        neu_resp_error_t     error = { 0 };
+        neu_plugin_common_t *common =
+            neu_plugin_to_plugin_common(adapter->plugin);
+
+        adapter->log_level = cmd->log_level;
+        zlog_level_switch(common->log, cmd->log_level);
+
+        // read by the plugin threads through plog_protocol
+        if (cmd->capture == 0 &&
+            __atomic_load_n(&common->protocol_capture, __ATOMIC_RELAXED)) {
+            __atomic_store_n(&common->protocol_capture, false,
+                             __ATOMIC_RELAXED);
+            neu_capture_close(common->name);
+        } else if (cmd->capture == 1) {
+            __atomic_store_n(&common->protocol_capture, true,
+                             __ATOMIC_RELAXED);
+        }
 
         struct timeval tv = { 0 };
         gettimeofday(&tv, NULL);
@@ -1463,8 +1555,16 @@ static int adapter_loop(enum neu_event_io_type type, int fd, void *usr_data)
     case NEU_REQ_FUP_OPEN: {
         neu_req_fup_open_t *cmd = (neu_req_fup_open_t *) &header[1];
 
-        neu_adapter_driver_fup_open((neu_adapter_driver_t *) adapter,
-                                    (neu_reqresp_head_t *) header, cmd->path);
+        neu_resp_fup_open_t resp = { 0 };
+
+        resp.error = neu_adapter_driver_fup_open(
+            (neu_adapter_driver_t *) adapter, (neu_reqresp_head_t *) header,
+            cmd->path);
+        if (0 != resp.error) {
+            header->type = NEU_RESP_FUP_OPEN;
+            neu_msg_exchange(header);
+            reply(adapter, header, &resp);
+        }
         break;
     }
     case NEU_REQ_FDOWN_OPEN: {
@@ -1487,8 +1587,18 @@ static int adapter_loop(enum neu_event_io_type type, int fd, void *usr_data)
     case NEU_REQ_FUP_DATA: {
         neu_req_fup_data_t *cmd = (neu_req_fup_data_t *) &header[1];
 
-        neu_adapter_driver_fup_data((neu_adapter_driver_t *) adapter,
-                                    (neu_reqresp_head_t *) header, cmd->path);
+        neu_resp_fup_data_t resp = { 0 };
+
+        resp.seq   = cmd->seq;
+        resp.error = neu_adapter_driver_fup_data(
+            (neu_adapter_driver_t *) adapter, (neu_reqresp_head_t *) header,
+            cmd->path, cmd->offset);
+        if (0 != resp.error) {
+            // the plugin never saw the request, answer it here
+            header->type = NEU_RESP_FUP_DATA;
+            neu_msg_exchange(header);
+            reply(adapter, header, &resp);
+        }
         break;
     }
     default:
@@ -1620,6 +1730,11 @@ void neu_adapter_destroy(neu_adapter_t *adapter)
     close(adapter->control_fd);
     close(adapter->trans_data_fd);
 
+    if (__atomic_load_n(
+            &neu_plugin_to_plugin_common(adapter->plugin)->protocol_capture,
+            __ATOMIC_RELAXED)) {
+        neu_capture_close(adapter->name);
+    }
     adapter->module->intf_funs->close(adapter->plugin);
 
     if (NULL != adapter->metrics) {
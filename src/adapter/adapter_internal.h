@@ -58,6 +58,10 @@ struct neu_adapter {
 
     // metrics
     neu_node_metrics_t *metrics;
+    neu_histogram_t *   queue_wait; // NULL if the node has no metrics
+    // driver round trip time, the last value entry feeds the histogram
+    const neu_metric_entry_t *last_rtt;
+    neu_histogram_t *         read_rtt;
     int                 log_level;
 };
 
@@ -18,34 +18,46 @@
  **/
 
 #include <assert.h>
-#include <math.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
 #include <pthread.h>
+#include <stdio.h>
 #include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
-#include <jansson.h>
-
+#include "utils/intern.h"
 #include "utils/uthash.h"
 
 #include "define.h"
 #include "tag.h"
+#include "utils/log.h"
 
 #include "cache.h"
+#include "value.h"
 
 extern bool sub_filter_err;
 
+// interned names, every elem and restore record holds a reference of each
 typedef struct {
-    char group[NEU_GROUP_NAME_LEN];
-    char tag[NEU_TAG_NAME_LEN];
+    const char *group;
+    const char *tag;
 } tkey_t;
 
 struct elem {
-    int64_t timestamp;
+    int64_t timestamp; // of the value, the device time if the driver has one
+    int64_t cached;    // when the entry was last written, for expiry
     bool    changed;
+    bool    restored; // value comes from a snapshot, not from the device
+    uint8_t precision;
+    uint8_t n_meta;
+    uint8_t cap_meta;
 
-    neu_dvalue_t value;
-    neu_dvalue_t value_old;
-
-    neu_tag_meta_t metas[NEU_TAG_META_SIZE];
+    neu_cvalue_t    value;
+    neu_cvalue_t    value_old; // last value that is not an error
+    neu_tag_meta_t *metas;     // of the last update, NULL until there are any
 
     tkey_t         key;
     UT_hash_handle hh;
@@ -57,23 +69,115 @@ typedef struct {
     UT_hash_handle hh;
 } group_trace_t;
 
+// snapshot records not yet claimed by a tag, pointing into the mapping
+struct restore {
+    tkey_t         key;
+    const uint8_t *rec;
+    UT_hash_handle hh;
+};
+
 struct neu_driver_cache {
-    pthread_mutex_t mtx;
-    group_trace_t * trace_table;
-    struct elem *   table;
+    pthread_mutex_t   mtx;
+    group_trace_t *   trace_table;
+    struct elem *     table;
+    neu_value_slab_t *slab; // strings and arrays of the values
+
+    struct restore *restore_table;
+    uint8_t *       snapshot;
+    size_t          snapshot_size;
+    uint64_t        version;
+    uint64_t        saved_version;
 };
 
+#define SNAPSHOT_MAGIC "NEUCACHE"
+#define SNAPSHOT_VERSION 1
+
+typedef struct {
+    char     magic[8];
+    uint32_t version;
+    uint32_t count;
+} snapshot_header_t;
+
+// followed by group name, tag name and value payload
+typedef struct {
+    int64_t  timestamp;
+    uint16_t value_len;
+    uint8_t  type;
+    uint8_t  group_len;
+    uint8_t  tag_len;
+    uint8_t  reserved[3];
+} snapshot_record_t;
+
 // static void update_tag_error(neu_driver_cache_t *cache, const char *group,
 // const char *tag, int64_t timestamp, int error);
 
-inline static tkey_t to_key(const char *group, const char *tag)
+inline static unsigned key_hash(const tkey_t *key)
+{
+    return neu_intern_hash(key->group) * 31 + neu_intern_hash(key->tag);
+}
+
+// key of names already in the cache, false if either is not interned at all
+inline static bool find_key(const char *group, const char *tag, tkey_t *key)
 {
-    tkey_t key = { 0 };
+    key->group = neu_intern_find(group);
+    key->tag   = neu_intern_find(tag);
+    return key->group != NULL && key->tag != NULL;
+}
 
-    strcpy(key.group, group);
-    strcpy(key.tag, tag);
+inline static void key_release(tkey_t *key)
+{
+    neu_intern_release(key->group);
+    neu_intern_release(key->tag);
+}
+
+// called with cache->mtx held
+static struct elem *elem_find(neu_driver_cache_t *cache, const tkey_t *key)
+{
+    struct elem *elem = NULL;
+
+    HASH_FIND_BYHASHVALUE(hh, cache->table, key, sizeof(tkey_t),
+                          key_hash(key), elem);
+    return elem;
+}
+
+static void release_snapshot(neu_driver_cache_t *cache)
+{
+    struct restore *r   = NULL;
+    struct restore *tmp = NULL;
+
+    HASH_ITER(hh, cache->restore_table, r, tmp)
+    {
+        HASH_DEL(cache->restore_table, r);
+        key_release(&r->key);
+        free(r);
+    }
+
+    if (cache->snapshot != NULL) {
+        munmap(cache->snapshot, cache->snapshot_size);
+        cache->snapshot      = NULL;
+        cache->snapshot_size = 0;
+    }
+}
+
+static void add_restored_meta(neu_tag_meta_t *metas)
+{
+    for (int i = 0; i < NEU_TAG_META_SIZE; i++) {
+        if (strlen(metas[i].name) == 0) {
+            strcpy(metas[i].name, NEU_DRIVER_CACHE_META_RESTORED);
+            metas[i].value.type          = NEU_TYPE_BOOL;
+            metas[i].value.value.boolean = true;
+            break;
+        }
+    }
+}
 
-    return key;
+static void elem_free(neu_driver_cache_t *cache, struct elem *elem)
+{
+    neu_cvalue_release(cache->slab, &elem->value);
+    neu_cvalue_release(cache->slab, &elem->value_old);
+    free(elem->metas);
+    key_release(&elem->key);
+    free(elem);
 }
 
 neu_driver_cache_t *neu_driver_cache_new()
@@ -81,6 +185,7 @@ neu_driver_cache_t *neu_driver_cache_new()
     neu_driver_cache_t *cache = calloc(1, sizeof(neu_driver_cache_t));
 
     pthread_mutex_init(&cache->mtx, NULL);
+    cache->slab = neu_value_slab_new();
 
     return cache;
 }
@@ -94,26 +199,12 @@ void neu_driver_cache_destroy(neu_driver_cache_t *cache)
     HASH_ITER(hh, cache->table, elem, tmp)
     {
         HASH_DEL(cache->table, elem);
-        if (elem->value.type == NEU_TYPE_PTR) {
-            if (elem->value.value.ptr.ptr != NULL) {
-                free(elem->value.value.ptr.ptr);
-                elem->value.value.ptr.ptr = NULL;
-            }
-        } else if (elem->value.type == NEU_TYPE_CUSTOM) {
-            if (elem->value.value.json != NULL) {
-                json_decref(elem->value.value.json);
-                elem->value.value.json = NULL;
-            }
-        } else if (elem->value.type == NEU_TYPE_ARRAY_STRING) {
-            for (int i = 0; i < elem->value.value.strs.length; i++) {
-                free(elem->value.value.strs.strs[i]);
-                elem->value.value.strs.strs[i] = NULL;
-            }
-        }
-
-        free(elem);
+        elem_free(cache, elem);
     }
 
+    release_snapshot(cache);
+    neu_value_slab_free(cache->slab);
+
     group_trace_t *elem1 = NULL;
     group_trace_t *tmp1  = NULL;
 
@@ -140,23 +231,34 @@ void neu_driver_cache_add(neu_driver_cache_t *cache, const char *group,
                           const char *tag, neu_dvalue_t value)
 {
     struct elem *elem = NULL;
-    tkey_t       key  = to_key(group, tag);
+    tkey_t       key  = { 0 };
+
+    key.group = neu_intern(group);
+    key.tag   = neu_intern(tag);
+    if (key.group == NULL || key.tag == NULL) {
+        key_release(&key);
+        return;
+    }
 
     pthread_mutex_lock(&cache->mtx);
-    HASH_FIND(hh, cache->table, &key, sizeof(tkey_t), elem);
+    elem = elem_find(cache, &key);
 
     if (elem == NULL) {
-        elem = calloc(1, sizeof(struct elem));
+        elem      = calloc(1, sizeof(struct elem));
+        elem->key = key;
 
-        strcpy(elem->key.group, group);
-        strcpy(elem->key.tag, tag);
-
-        HASH_ADD(hh, cache->table, key, sizeof(tkey_t), elem);
+        HASH_ADD_BYHASHVALUE(hh, cache->table, key, sizeof(tkey_t),
+                             key_hash(&key), elem);
+    } else {
+        key_release(&key);
     }
 
     elem->timestamp = 0;
+    elem->cached    = 0;
     elem->changed   = false;
-    elem->value     = value;
+    elem->restored  = false;
+    elem->precision = value.precision;
+    neu_cvalue_set(cache->slab, &elem->value, &value);
 
     pthread_mutex_unlock(&cache->mtx);
 }
@@ -207,6 +309,61 @@ void *neu_driver_cache_get_trace(neu_driver_cache_t *cache, const char *group)
     return trace;
 }
 
+// called with cache->mtx held
+static void elem_update(neu_driver_cache_t *cache, struct elem *elem,
+                        int64_t timestamp, int64_t cached, neu_dvalue_t value,
+                        neu_tag_meta_t *metas, int n_meta, bool change)
+{
+    elem->timestamp = timestamp;
+    elem->cached    = cached;
+
+    if (sub_filter_err && value.type == NEU_TYPE_ERROR) {
+        goto error_not_report;
+    }
+
+    if (elem->value.type != value.type) {
+        // errors are not reported with sub_filter_err, compare with the
+        // value before them
+        if (!sub_filter_err || elem->value.type != NEU_TYPE_ERROR ||
+            !neu_cvalue_equal(&elem->value_old, &value, elem->precision)) {
+            elem->changed = true;
+        }
+    } else if (!neu_cvalue_equal(&elem->value, &value, elem->precision)) {
+        elem->changed = true;
+    }
+
+error_not_report:
+
+    if (change) {
+        elem->changed = true;
+    }
+
+    // the first live value always goes out so that subscribers see
+    // the quality change, even if it equals the restored one
+    if (elem->restored) {
+        elem->restored = false;
+        if (value.type != NEU_TYPE_ERROR) {
+            elem->changed = true;
+        }
+    }
+    cache->version += 1;
+
+    neu_cvalue_set(cache->slab, &elem->value, &value);
+    if (sub_filter_err && value.type != NEU_TYPE_ERROR) {
+        neu_cvalue_release(cache->slab, &elem->value_old);
+        neu_cvalue_copy(cache->slab, &elem->value_old, &elem->value);
+    }
+
+    if (n_meta > elem->cap_meta) {
+        elem->metas    = realloc(elem->metas, n_meta * sizeof(neu_tag_meta_t));
+        elem->cap_meta = n_meta;
+    }
+    if (n_meta > 0) {
+        memcpy(elem->metas, metas, n_meta * sizeof(neu_tag_meta_t));
+    }
+    elem->n_meta = n_meta;
+}
+
 void neu_driver_cache_update_change(neu_driver_cache_t *cache,
                                     const char *group, const char *tag,
                                     int64_t timestamp, neu_dvalue_t value,
@@ -214,536 +371,40 @@ void neu_driver_cache_update_change(neu_driver_cache_t *cache,
                                     bool change)
 {
     struct elem *elem = NULL;
-    tkey_t       key  = to_key(group, tag);
+    tkey_t       key  = { 0 };
 
     pthread_mutex_lock(&cache->mtx);
-    HASH_FIND(hh, cache->table, &key, sizeof(tkey_t), elem);
+    if (find_key(group, tag, &key)) {
+        elem = elem_find(cache, &key);
+    }
     if (elem != NULL) {
-        elem->timestamp = timestamp;
-
-        if (sub_filter_err && value.type == NEU_TYPE_ERROR) {
-            goto error_not_report;
-        }
-
-        if ((!sub_filter_err && elem->value.type != value.type) ||
-            (sub_filter_err && elem->value.type != value.type &&
-             elem->value.type != NEU_TYPE_ERROR)) {
-            elem->changed = true;
-        } else if (sub_filter_err && elem->value.type != value.type &&
-                   elem->value.type == NEU_TYPE_ERROR) {
-            switch (value.type) {
-            case NEU_TYPE_INT8:
-            case NEU_TYPE_UINT8:
-            case NEU_TYPE_INT16:
-            case NEU_TYPE_UINT16:
-            case NEU_TYPE_INT32:
-            case NEU_TYPE_UINT32:
-            case NEU_TYPE_INT64:
-            case NEU_TYPE_UINT64:
-            case NEU_TYPE_BIT:
-            case NEU_TYPE_BOOL:
-            case NEU_TYPE_STRING:
-            case NEU_TYPE_TIME:
-            case NEU_TYPE_DATA_AND_TIME:
-            case NEU_TYPE_WORD:
-            case NEU_TYPE_DWORD:
-            case NEU_TYPE_LWORD:
-            case NEU_TYPE_ARRAY_CHAR:
-                if (memcmp(&elem->value_old.value, &value.value,
-                           sizeof(value.value)) != 0) {
-                    elem->changed = true;
-                }
-                break;
-            case NEU_TYPE_BYTES:
-                if (elem->value_old.value.bytes.length !=
-                    value.value.bytes.length) {
-                    elem->changed = true;
-                } else {
-                    if (memcpy(elem->value_old.value.bytes.bytes,
-                               value.value.bytes.bytes,
-                               value.value.bytes.length) != 0) {
-                        elem->changed = true;
-                    }
-                }
-                break;
-            case NEU_TYPE_ARRAY_BOOL:
-                if (elem->value_old.value.bools.length !=
-                    value.value.bools.length) {
-                    elem->changed = true;
-                } else {
-                    if (memcmp(elem->value_old.value.bools.bools,
-                               value.value.bools.bools,
-                               value.value.bools.length) != 0) {
-                        elem->changed = true;
-                    }
-                }
-                break;
-            case NEU_TYPE_ARRAY_INT8:
-                if (elem->value_old.value.i8s.length !=
-                    value.value.i8s.length) {
-                    elem->changed = true;
-                } else {
-                    if (memcmp(elem->value_old.value.i8s.i8s,
-                               value.value.i8s.i8s,
-                               value.value.i8s.length) != 0) {
-                        elem->changed = true;
-                    }
-                }
-                break;
-            case NEU_TYPE_ARRAY_UINT8:
-                if (elem->value_old.value.u8s.length !=
-                    value.value.u8s.length) {
-                    elem->changed = true;
-                } else {
-                    if (memcmp(elem->value_old.value.u8s.u8s,
-                               value.value.u8s.u8s,
-                               value.value.u8s.length) != 0) {
-                        elem->changed = true;
-                    }
-                }
-                break;
-            case NEU_TYPE_ARRAY_INT16:
-                if (elem->value_old.value.i16s.length !=
-                    value.value.i16s.length) {
-                    elem->changed = true;
-                } else {
-                    if (memcmp(elem->value_old.value.i16s.i16s,
-                               value.value.i16s.i16s,
-                               value.value.i16s.length * sizeof(int16_t)) !=
-                        0) {
-                        elem->changed = true;
-                    }
-                }
-                break;
-            case NEU_TYPE_ARRAY_UINT16:
-                if (elem->value_old.value.u16s.length !=
-                    value.value.u16s.length) {
-                    elem->changed = true;
-                } else {
-                    if (memcmp(elem->value_old.value.u16s.u16s,
-                               value.value.u16s.u16s,
-                               value.value.u16s.length * sizeof(uint16_t)) !=
-                        0) {
-                        elem->changed = true;
-                    }
-                }
-                break;
-            case NEU_TYPE_ARRAY_INT32:
-                if (elem->value_old.value.i32s.length !=
-                    value.value.i32s.length) {
-                    elem->changed = true;
-                } else {
-                    if (memcmp(elem->value_old.value.i32s.i32s,
-                               value.value.i32s.i32s,
-                               value.value.i32s.length * sizeof(int32_t)) !=
-                        0) {
-                        elem->changed = true;
-                    }
-                }
-                break;
-            case NEU_TYPE_ARRAY_UINT32:
-                if (elem->value_old.value.u32s.length !=
-                    value.value.u32s.length) {
-                    elem->changed = true;
-                } else {
-                    if (memcmp(elem->value_old.value.u32s.u32s,
-                               value.value.u32s.u32s,
-                               value.value.u32s.length * sizeof(uint32_t)) !=
-                        0) {
-                        elem->changed = true;
-                    }
-                }
-                break;
-            case NEU_TYPE_ARRAY_INT64:
-                if (elem->value_old.value.i64s.length !=
-                    value.value.i64s.length) {
-                    elem->changed = true;
-                } else {
-                    if (memcmp(elem->value_old.value.i64s.i64s,
-                               value.value.i64s.i64s,
-                               value.value.i64s.length * sizeof(int64_t)) !=
-                        0) {
-                        elem->changed = true;
-                    }
-                }
-                break;
-            case NEU_TYPE_ARRAY_UINT64:
-                if (elem->value_old.value.u64s.length !=
-                    value.value.u64s.length) {
-                    elem->changed = true;
-                } else {
-                    if (memcmp(elem->value_old.value.u64s.u64s,
-                               value.value.u64s.u64s,
-                               value.value.u64s.length * sizeof(uint64_t)) !=
-                        0) {
-                        elem->changed = true;
-                    }
-                }
-                break;
-            case NEU_TYPE_ARRAY_FLOAT:
-                if (elem->value_old.value.f32s.length !=
-                    value.value.f32s.length) {
-                    elem->changed = true;
-                } else {
-                    if (memcmp(elem->value_old.value.f32s.f32s,
-                               value.value.f32s.f32s,
-                               value.value.f32s.length * sizeof(float)) != 0) {
-                        elem->changed = true;
-                    }
-                }
-                break;
-            case NEU_TYPE_ARRAY_DOUBLE:
-                if (elem->value_old.value.f64s.length !=
-                    value.value.f64s.length) {
-                    elem->changed = true;
-                } else {
-                    if (memcmp(elem->value_old.value.f64s.f64s,
-                               value.value.f64s.f64s,
-                               value.value.f64s.length * sizeof(double)) != 0) {
-                        elem->changed = true;
-                    }
-                }
-                break;
-            case NEU_TYPE_ARRAY_STRING:
-                if (elem->value_old.value.strs.length !=
-                    value.value.strs.length) {
-                    elem->changed = true;
-                } else {
-                    if (memcmp(elem->value_old.value.strs.strs,
-                               value.value.strs.strs,
-                               value.value.strs.length * sizeof(char *)) != 0) {
-                        elem->changed = true;
-                    }
-                }
-                break;
-            case NEU_TYPE_CUSTOM: {
-                if (json_equal(elem->value_old.value.json, value.value.json) !=
-                    0) {
-                    elem->changed = true;
-                }
-                break;
-            }
-            case NEU_TYPE_PTR: {
-                if (elem->value_old.value.ptr.length !=
-                    value.value.ptr.length) {
-                    elem->changed = true;
-                } else {
-                    if (memcmp(elem->value_old.value.ptr.ptr,
-                               value.value.ptr.ptr,
-                               value.value.ptr.length) != 0) {
-                        elem->changed = true;
-                    }
-                }
-
-                break;
-            }
-            case NEU_TYPE_FLOAT:
-                if (elem->value_old.precision == 0) {
-                    elem->changed =
-                        elem->value_old.value.f32 != value.value.f32;
-                } else {
-                    if (fabs(elem->value_old.value.f32 - value.value.f32) >
-                        pow(0.1, elem->value_old.precision)) {
-                        elem->changed = true;
-                    }
-                }
-                break;
-            case NEU_TYPE_DOUBLE:
-                if (elem->value_old.precision == 0) {
-                    elem->changed =
-                        elem->value_old.value.d64 != value.value.d64;
-                } else {
-                    if (fabs(elem->value_old.value.d64 - value.value.d64) >
-                        pow(0.1, elem->value_old.precision)) {
-                        elem->changed = true;
-                    }
-                }
-
-                break;
-            case NEU_TYPE_ERROR:
-                break;
-            }
-        } else {
-            switch (value.type) {
-            case NEU_TYPE_INT8:
-            case NEU_TYPE_UINT8:
-            case NEU_TYPE_INT16:
-            case NEU_TYPE_UINT16:
-            case NEU_TYPE_INT32:
-            case NEU_TYPE_UINT32:
-            case NEU_TYPE_INT64:
-            case NEU_TYPE_UINT64:
-            case NEU_TYPE_BIT:
-            case NEU_TYPE_BOOL:
-            case NEU_TYPE_STRING:
-            case NEU_TYPE_TIME:
-            case NEU_TYPE_DATA_AND_TIME:
-            case NEU_TYPE_WORD:
-            case NEU_TYPE_DWORD:
-            case NEU_TYPE_LWORD:
-            case NEU_TYPE_ARRAY_CHAR:
-                if (memcmp(&elem->value.value, &value.value,
-                           sizeof(value.value)) != 0) {
-                    elem->changed = true;
-                }
-                break;
-            case NEU_TYPE_BYTES:
-                if (elem->value.value.bytes.length !=
-                    value.value.bytes.length) {
-                    elem->changed = true;
-                } else {
-                    if (memcpy(elem->value.value.bytes.bytes,
-                               value.value.bytes.bytes,
-                               value.value.bytes.length) != 0) {
-                        elem->changed = true;
-                    }
-                }
-                break;
-            case NEU_TYPE_ARRAY_BOOL:
-                if (elem->value.value.bools.length !=
-                    value.value.bools.length) {
-                    elem->changed = true;
-                } else {
-                    if (memcmp(elem->value.value.bools.bools,
-                               value.value.bools.bools,
-                               value.value.bools.length) != 0) {
-                        elem->changed = true;
-                    }
-                }
-                break;
-            case NEU_TYPE_ARRAY_INT8:
-                if (elem->value.value.i8s.length != value.value.i8s.length) {
-                    elem->changed = true;
-                } else {
-                    if (memcmp(elem->value.value.i8s.i8s, value.value.i8s.i8s,
-                               value.value.i8s.length) != 0) {
-                        elem->changed = true;
-                    }
-                }
-                break;
-            case NEU_TYPE_ARRAY_UINT8:
-                if (elem->value.value.u8s.length != value.value.u8s.length) {
-                    elem->changed = true;
-                } else {
-                    if (memcmp(elem->value.value.u8s.u8s, value.value.u8s.u8s,
-                               value.value.u8s.length) != 0) {
-                        elem->changed = true;
-                    }
-                }
-                break;
-            case NEU_TYPE_ARRAY_INT16:
-                if (elem->value.value.i16s.length != value.value.i16s.length) {
-                    elem->changed = true;
-                } else {
-                    if (memcmp(
-                            elem->value.value.i16s.i16s, value.value.i16s.i16s,
-                            value.value.i16s.length * sizeof(int16_t)) != 0) {
-                        elem->changed = true;
-                    }
-                }
-                break;
-            case NEU_TYPE_ARRAY_UINT16:
-                if (elem->value.value.u16s.length != value.value.u16s.length) {
-                    elem->changed = true;
-                } else {
-                    if (memcmp(
-                            elem->value.value.u16s.u16s, value.value.u16s.u16s,
-                            value.value.u16s.length * sizeof(uint16_t)) != 0) {
-                        elem->changed = true;
-                    }
-                }
-                break;
-            case NEU_TYPE_ARRAY_INT32:
-                if (elem->value.value.i32s.length != value.value.i32s.length) {
-                    elem->changed = true;
-                } else {
-                    if (memcmp(
-                            elem->value.value.i32s.i32s, value.value.i32s.i32s,
-                            value.value.i32s.length * sizeof(int32_t)) != 0) {
-                        elem->changed = true;
-                    }
-                }
-                break;
-            case NEU_TYPE_ARRAY_UINT32:
-                if (elem->value.value.u32s.length != value.value.u32s.length) {
-                    elem->changed = true;
-                } else {
-                    if (memcmp(
-                            elem->value.value.u32s.u32s, value.value.u32s.u32s,
-                            value.value.u32s.length * sizeof(uint32_t)) != 0) {
-                        elem->changed = true;
-                    }
-                }
-                break;
-            case NEU_TYPE_ARRAY_INT64:
-                if (elem->value.value.i64s.length != value.value.i64s.length) {
-                    elem->changed = true;
-                } else {
-                    if (memcmp(
-                            elem->value.value.i64s.i64s, value.value.i64s.i64s,
-                            value.value.i64s.length * sizeof(int64_t)) != 0) {
-                        elem->changed = true;
-                    }
-                }
-                break;
-            case NEU_TYPE_ARRAY_UINT64:
-                if (elem->value.value.u64s.length != value.value.u64s.length) {
-                    elem->changed = true;
-                } else {
-                    if (memcmp(
-                            elem->value.value.u64s.u64s, value.value.u64s.u64s,
-                            value.value.u64s.length * sizeof(uint64_t)) != 0) {
-                        elem->changed = true;
-                    }
-                }
-                break;
-            case NEU_TYPE_ARRAY_FLOAT:
-                if (elem->value.value.f32s.length != value.value.f32s.length) {
-                    elem->changed = true;
-                } else {
-                    if (memcmp(elem->value.value.f32s.f32s,
-                               value.value.f32s.f32s,
-                               value.value.f32s.length * sizeof(float)) != 0) {
-                        elem->changed = true;
-                    }
-                }
-                break;
-            case NEU_TYPE_ARRAY_DOUBLE:
-                if (elem->value.value.f64s.length != value.value.f64s.length) {
-                    elem->changed = true;
-                } else {
-                    if (memcmp(elem->value.value.f64s.f64s,
-                               value.value.f64s.f64s,
-                               value.value.f64s.length * sizeof(double)) != 0) {
-                        elem->changed = true;
-                    }
-                }
-                break;
-            case NEU_TYPE_ARRAY_STRING:
-                if (elem->value.value.strs.length != value.value.strs.length) {
-                    elem->changed = true;
-                } else {
-                    if (memcmp(elem->value.value.strs.strs,
-                               value.value.strs.strs,
-                               value.value.strs.length * sizeof(char *)) != 0) {
-                        elem->changed = true;
-                    }
-                }
-                break;
-            case NEU_TYPE_PTR: {
-                if (elem->value.value.ptr.length != value.value.ptr.length) {
-                    elem->changed = true;
-                } else {
-                    if (memcmp(elem->value.value.ptr.ptr, value.value.ptr.ptr,
-                               value.value.ptr.length) != 0) {
-                        elem->changed = true;
-                    }
-                }
-
-                break;
-            }
-            case NEU_TYPE_CUSTOM: {
-                if (json_equal(elem->value.value.json, value.value.json) != 0) {
-                    elem->changed = true;
-                }
-                break;
-            }
-            case NEU_TYPE_FLOAT:
-                if (elem->value.precision == 0) {
-                    elem->changed = elem->value.value.f32 != value.value.f32;
-                } else {
-                    if (fabs(elem->value.value.f32 - value.value.f32) >
-                        pow(0.1, elem->value.precision)) {
-                        elem->changed = true;
-                    }
-                }
-                break;
-            case NEU_TYPE_DOUBLE:
-                if (elem->value.precision == 0) {
-                    elem->changed = elem->value.value.d64 != value.value.d64;
-                } else {
-                    if (fabs(elem->value.value.d64 - value.value.d64) >
-                        pow(0.1, elem->value.precision)) {
-                        elem->changed = true;
-                    }
-                }
-
-                break;
-            case NEU_TYPE_ERROR:
-                elem->changed = true;
-                break;
-            }
-        }
-
-        if (sub_filter_err && value.type != NEU_TYPE_ERROR) {
-            elem->value_old.type      = value.type;
-            elem->value_old.value     = value.value;
-            elem->value_old.precision = value.precision;
-        }
-
-    error_not_report:
+        elem_update(cache, elem, timestamp, timestamp, value, metas, n_meta,
+                    change);
+    }
 
-        if (change) {
-            elem->changed = true;
-        }
+    pthread_mutex_unlock(&cache->mtx);
+}
 
-        if (value.type == NEU_TYPE_PTR) {
-            elem->value.value.ptr.length = value.value.ptr.length;
-            elem->value.value.ptr.type   = value.value.ptr.type;
-            if (elem->value.value.ptr.ptr != NULL) {
-                free(elem->value.value.ptr.ptr);
-            }
-            elem->value.value.ptr.ptr = calloc(1, value.value.ptr.length);
-            memcpy(elem->value.value.ptr.ptr, value.value.ptr.ptr,
-                   value.value.ptr.length);
-        } else if (value.type == NEU_TYPE_CUSTOM) {
-            if (elem->value.type == NEU_TYPE_CUSTOM) {
-                if (elem->value.value.json != NULL) {
-                    json_decref(elem->value.value.json);
-                    elem->value.value.json = NULL;
-                }
-            }
-
-            elem->value.value.json = value.value.json;
-
-        } else if (value.type == NEU_TYPE_ARRAY_STRING) {
-            if (elem->value.type == NEU_TYPE_ARRAY_STRING) {
-                for (int i = 0; i < elem->value.value.strs.length; i++) {
-                    free(elem->value.value.strs.strs[i]);
-                    elem->value.value.strs.strs[i] = NULL;
-                }
-            }
-            elem->value.value.strs.length = value.value.strs.length;
-            for (int i = 0; i < value.value.strs.length; i++) {
-                elem->value.value.strs.strs[i] = value.value.strs.strs[i];
-            }
-
-        } else if (value.type == NEU_TYPE_ERROR) {
-            if (elem->value.type == NEU_TYPE_CUSTOM) {
-                if (elem->value.value.json != NULL) {
-                    json_decref(elem->value.value.json);
-                    elem->value.value.json = NULL;
-                }
-            }
-
-            if (elem->value.type == NEU_TYPE_ARRAY_STRING) {
-                for (int i = 0; i < elem->value.value.strs.length; i++) {
-                    free(elem->value.value.strs.strs[i]);
-                    elem->value.value.strs.strs[i] = NULL;
-                }
-            }
-            elem->value.value = value.value;
-        } else {
-            elem->value.value = value.value;
-        }
-        elem->value.type = value.type;
+void neu_driver_cache_update_batch(neu_driver_cache_t *cache,
+                                   const char *group, int64_t timestamp,
+                                   neu_tag_update_t *updates, int n_update)
+{
+    struct elem *elem = NULL;
+    tkey_t       key  = { 0 };
 
-        memset(elem->metas, 0, sizeof(neu_tag_meta_t) * NEU_TAG_META_SIZE);
-        for (int i = 0; i < n_meta; i++) {
-            memcpy(&elem->metas[i], &metas[i], sizeof(neu_tag_meta_t));
+    pthread_mutex_lock(&cache->mtx);
+    key.group = neu_intern_find(group);
+    for (int i = 0; key.group != NULL && i < n_update; i++) {
+        key.tag = neu_intern_find(updates[i].tag);
+        elem    = key.tag != NULL ? elem_find(cache, &key) : NULL;
+        if (elem != NULL) {
+            elem_update(cache, elem,
+                        updates[i].timestamp > 0 ? updates[i].timestamp
+                                                 : timestamp,
+                        timestamp, updates[i].value, updates[i].metas,
+                        updates[i].n_meta, false);
         }
     }
-
     pthread_mutex_unlock(&cache->mtx);
 }
 
@@ -756,153 +417,73 @@ void neu_driver_cache_update(neu_driver_cache_t *cache, const char *group,
                                    n_meta, false);
 }
 
+void neu_driver_cache_lock(neu_driver_cache_t *cache)
+{
+    pthread_mutex_lock(&cache->mtx);
+}
+
+void neu_driver_cache_unlock(neu_driver_cache_t *cache)
+{
+    pthread_mutex_unlock(&cache->mtx);
+}
+
+// only the metas of the value are written, `metas` and `value` come zeroed
+static void elem_get(const struct elem *elem, neu_driver_cache_value_t *value,
+                     neu_tag_meta_t *metas)
+{
+    value->timestamp       = elem->timestamp;
+    value->cached          = elem->cached;
+    value->value.precision = elem->precision;
+    neu_cvalue_get(&elem->value, &value->value);
+
+    if (elem->n_meta > 0) {
+        memcpy(metas, elem->metas, sizeof(neu_tag_meta_t) * elem->n_meta);
+    }
+    for (int i = 0; i < elem->n_meta; i++) {
+        if (strlen(elem->metas[i].name) > 0) {
+            memcpy(&value->metas[i], &elem->metas[i], sizeof(neu_tag_meta_t));
+        }
+    }
+
+    if (elem->restored) {
+        add_restored_meta(metas);
+        add_restored_meta(value->metas);
+    }
+}
+
 int neu_driver_cache_meta_get(neu_driver_cache_t *cache, const char *group,
                               const char *tag, neu_driver_cache_value_t *value,
                               neu_tag_meta_t *metas, int n_meta)
 {
-    struct elem *elem = NULL;
-    int          ret  = -1;
-    tkey_t       key  = to_key(group, tag);
+    int ret = -1;
 
     pthread_mutex_lock(&cache->mtx);
-    HASH_FIND(hh, cache->table, &key, sizeof(tkey_t), elem);
-
-    if (elem != NULL) {
-        value->timestamp       = elem->timestamp;
-        value->value.type      = elem->value.type;
-        value->value.precision = elem->value.precision;
+    ret = neu_driver_cache_meta_get_locked(cache, group, tag, value, metas,
+                                           n_meta);
+    pthread_mutex_unlock(&cache->mtx);
 
-        assert(n_meta <= NEU_TAG_META_SIZE);
-        memcpy(metas, elem->metas, sizeof(neu_tag_meta_t) * NEU_TAG_META_SIZE);
+    return ret;
+}
 
-        switch (elem->value.type) {
-        case NEU_TYPE_INT8:
-        case NEU_TYPE_UINT8:
-        case NEU_TYPE_BIT:
-            value->value.value.u8 = elem->value.value.u8;
-            break;
-        case NEU_TYPE_INT16:
-        case NEU_TYPE_UINT16:
-        case NEU_TYPE_WORD:
-            value->value.value.u16 = elem->value.value.u16;
-            break;
-        case NEU_TYPE_INT32:
-        case NEU_TYPE_UINT32:
-        case NEU_TYPE_DWORD:
-        case NEU_TYPE_FLOAT:
-        case NEU_TYPE_ERROR:
-            value->value.value.u32 = elem->value.value.u32;
-            break;
-        case NEU_TYPE_INT64:
-        case NEU_TYPE_UINT64:
-        case NEU_TYPE_DOUBLE:
-        case NEU_TYPE_LWORD:
-            value->value.value.u64 = elem->value.value.u64;
-            break;
-        case NEU_TYPE_BOOL:
-            value->value.value.boolean = elem->value.value.boolean;
-            break;
-        case NEU_TYPE_STRING:
-        case NEU_TYPE_TIME:
-        case NEU_TYPE_DATA_AND_TIME:
-        case NEU_TYPE_ARRAY_CHAR:
-            memcpy(value->value.value.str, elem->value.value.str,
-                   sizeof(elem->value.value.str));
-            break;
-        case NEU_TYPE_BYTES:
-            value->value.value.bytes.length = elem->value.value.bytes.length;
-            memcpy(value->value.value.bytes.bytes,
-                   elem->value.value.bytes.bytes,
-                   elem->value.value.bytes.length);
-            break;
-        case NEU_TYPE_ARRAY_BOOL:
-            value->value.value.bools.length = elem->value.value.bools.length;
-            memcpy(value->value.value.bools.bools,
-                   elem->value.value.bools.bools,
-                   elem->value.value.bools.length);
-            break;
-        case NEU_TYPE_ARRAY_INT8:
-            value->value.value.i8s.length = elem->value.value.i8s.length;
-            memcpy(value->value.value.i8s.i8s, elem->value.value.i8s.i8s,
-                   elem->value.value.i8s.length);
-            break;
-        case NEU_TYPE_ARRAY_UINT8:
-            value->value.value.u8s.length = elem->value.value.u8s.length;
-            memcpy(value->value.value.u8s.u8s, elem->value.value.u8s.u8s,
-                   elem->value.value.u8s.length);
-            break;
-        case NEU_TYPE_ARRAY_INT16:
-            value->value.value.i16s.length = elem->value.value.i16s.length;
-            memcpy(value->value.value.i16s.i16s, elem->value.value.i16s.i16s,
-                   elem->value.value.i16s.length * sizeof(int16_t));
-            break;
-        case NEU_TYPE_ARRAY_UINT16:
-            value->value.value.u16s.length = elem->value.value.u16s.length;
-            memcpy(value->value.value.u16s.u16s, elem->value.value.u16s.u16s,
-                   elem->value.value.u16s.length * sizeof(uint16_t));
-            break;
-        case NEU_TYPE_ARRAY_INT32:
-            value->value.value.i32s.length = elem->value.value.i32s.length;
-            memcpy(value->value.value.i32s.i32s, elem->value.value.i32s.i32s,
-                   elem->value.value.i32s.length * sizeof(int32_t));
-            break;
-        case NEU_TYPE_ARRAY_UINT32:
-            value->value.value.u32s.length = elem->value.value.u32s.length;
-            memcpy(value->value.value.u32s.u32s, elem->value.value.u32s.u32s,
-                   elem->value.value.u32s.length * sizeof(uint32_t));
-            break;
-        case NEU_TYPE_ARRAY_INT64:
-            value->value.value.i64s.length = elem->value.value.i64s.length;
-            memcpy(value->value.value.i64s.i64s, elem->value.value.i64s.i64s,
-                   elem->value.value.i64s.length * sizeof(int64_t));
-            break;
-        case NEU_TYPE_ARRAY_UINT64:
-            value->value.value.u64s.length = elem->value.value.u64s.length;
-            memcpy(value->value.value.u64s.u64s, elem->value.value.u64s.u64s,
-                   elem->value.value.u64s.length * sizeof(uint64_t));
-            break;
-        case NEU_TYPE_ARRAY_FLOAT:
-            value->value.value.f32s.length = elem->value.value.f32s.length;
-            memcpy(value->value.value.f32s.f32s, elem->value.value.f32s.f32s,
-                   elem->value.value.f32s.length * sizeof(float));
-            break;
-        case NEU_TYPE_ARRAY_DOUBLE:
-            value->value.value.f64s.length = elem->value.value.f64s.length;
-            memcpy(value->value.value.f64s.f64s, elem->value.value.f64s.f64s,
-                   elem->value.value.f64s.length * sizeof(double));
-            break;
-        case NEU_TYPE_ARRAY_STRING:
-            value->value.value.strs.length = elem->value.value.strs.length;
-            for (int i = 0; i < elem->value.value.strs.length; i++) {
-                value->value.value.strs.strs[i] =
-                    strdup(elem->value.value.strs.strs[i]);
-            }
-            break;
-        case NEU_TYPE_PTR:
-            value->value.value.ptr.length = elem->value.value.ptr.length;
-            value->value.value.ptr.type   = elem->value.value.ptr.type;
-            value->value.value.ptr.ptr =
-                calloc(1, elem->value.value.ptr.length);
-            memcpy(value->value.value.ptr.ptr, elem->value.value.ptr.ptr,
-                   elem->value.value.ptr.length);
-            break;
-        case NEU_TYPE_CUSTOM:
-            value->value.value.json = json_deep_copy(elem->value.value.json);
-            break;
-        }
+int neu_driver_cache_meta_get_locked(neu_driver_cache_t *cache,
+                                     const char *group, const char *tag,
+                                     neu_driver_cache_value_t *value,
+                                     neu_tag_meta_t *metas, int n_meta)
+{
+    struct elem *elem = NULL;
+    int          ret  = -1;
+    tkey_t       key  = { 0 };
 
-        for (int i = 0; i < NEU_TAG_META_SIZE; i++) {
-            if (strlen(elem->metas[i].name) > 0) {
-                memcpy(&value->metas[i], &elem->metas[i],
-                       sizeof(neu_tag_meta_t));
-            }
-        }
+    if (find_key(group, tag, &key)) {
+        elem = elem_find(cache, &key);
+    }
 
+    if (elem != NULL) {
+        assert(n_meta <= NEU_TAG_META_SIZE);
+        elem_get(elem, value, metas);
         ret = 0;
     }
 
-    pthread_mutex_unlock(&cache->mtx);
-
     return ret;
 }
 
@@ -913,141 +494,16 @@ int neu_driver_cache_meta_get_changed(neu_driver_cache_t *cache,
 {
     struct elem *elem = NULL;
     int          ret  = -1;
-    tkey_t       key  = to_key(group, tag);
+    tkey_t       key  = { 0 };
 
     pthread_mutex_lock(&cache->mtx);
-    HASH_FIND(hh, cache->table, &key, sizeof(tkey_t), elem);
+    if (find_key(group, tag, &key)) {
+        elem = elem_find(cache, &key);
+    }
 
     if (elem != NULL && elem->changed) {
-        value->timestamp       = elem->timestamp;
-        value->value.type      = elem->value.type;
-        value->value.precision = elem->value.precision;
-
         assert(n_meta <= NEU_TAG_META_SIZE);
-        memcpy(metas, elem->metas, sizeof(neu_tag_meta_t) * NEU_TAG_META_SIZE);
-
-        switch (elem->value.type) {
-        case NEU_TYPE_INT8:
-        case NEU_TYPE_UINT8:
-        case NEU_TYPE_BIT:
-            value->value.value.u8 = elem->value.value.u8;
-            break;
-        case NEU_TYPE_INT16:
-        case NEU_TYPE_UINT16:
-        case NEU_TYPE_WORD:
-            value->value.value.u16 = elem->value.value.u16;
-            break;
-        case NEU_TYPE_INT32:
-        case NEU_TYPE_UINT32:
-        case NEU_TYPE_FLOAT:
-        case NEU_TYPE_ERROR:
-        case NEU_TYPE_DWORD:
-            value->value.value.u32 = elem->value.value.u32;
-            break;
-        case NEU_TYPE_INT64:
-        case NEU_TYPE_UINT64:
-        case NEU_TYPE_DOUBLE:
-        case NEU_TYPE_LWORD:
-            value->value.value.u64 = elem->value.value.u64;
-            break;
-        case NEU_TYPE_BOOL:
-            value->value.value.boolean = elem->value.value.boolean;
-            break;
-        case NEU_TYPE_STRING:
-        case NEU_TYPE_TIME:
-        case NEU_TYPE_DATA_AND_TIME:
-        case NEU_TYPE_ARRAY_CHAR:
-            memcpy(value->value.value.str, elem->value.value.str,
-                   sizeof(elem->value.value.str));
-            break;
-        case NEU_TYPE_BYTES:
-            value->value.value.bytes.length = elem->value.value.bytes.length;
-            memcpy(value->value.value.bytes.bytes,
-                   elem->value.value.bytes.bytes,
-                   elem->value.value.bytes.length);
-            break;
-        case NEU_TYPE_ARRAY_BOOL:
-            value->value.value.bools.length = elem->value.value.bools.length;
-            memcpy(value->value.value.bools.bools,
-                   elem->value.value.bools.bools,
-                   elem->value.value.bools.length);
-            break;
-        case NEU_TYPE_ARRAY_INT8:
-            value->value.value.i8s.length = elem->value.value.i8s.length;
-            memcpy(value->value.value.i8s.i8s, elem->value.value.i8s.i8s,
-                   elem->value.value.i8s.length);
-            break;
-        case NEU_TYPE_ARRAY_UINT8:
-            value->value.value.u8s.length = elem->value.value.u8s.length;
-            memcpy(value->value.value.u8s.u8s, elem->value.value.u8s.u8s,
-                   elem->value.value.u8s.length);
-            break;
-        case NEU_TYPE_ARRAY_INT16:
-            value->value.value.i16s.length = elem->value.value.i16s.length;
-            memcpy(value->value.value.i16s.i16s, elem->value.value.i16s.i16s,
-                   elem->value.value.i16s.length * sizeof(int16_t));
-            break;
-        case NEU_TYPE_ARRAY_UINT16:
-            value->value.value.u16s.length = elem->value.value.u16s.length;
-            memcpy(value->value.value.u16s.u16s, elem->value.value.u16s.u16s,
-                   elem->value.value.u16s.length * sizeof(uint16_t));
-            break;
-        case NEU_TYPE_ARRAY_INT32:
-            value->value.value.i32s.length = elem->value.value.i32s.length;
-            memcpy(value->value.value.i32s.i32s, elem->value.value.i32s.i32s,
-                   elem->value.value.i32s.length * sizeof(int32_t));
-            break;
-        case NEU_TYPE_ARRAY_UINT32:
-            value->value.value.u32s.length = elem->value.value.u32s.length;
-            memcpy(value->value.value.u32s.u32s, elem->value.value.u32s.u32s,
-                   elem->value.value.u32s.length * sizeof(uint32_t));
-            break;
-        case NEU_TYPE_ARRAY_INT64:
-            value->value.value.i64s.length = elem->value.value.i64s.length;
-            memcpy(value->value.value.i64s.i64s, elem->value.value.i64s.i64s,
-                   elem->value.value.i64s.length * sizeof(int64_t));
-            break;
-        case NEU_TYPE_ARRAY_UINT64:
-            value->value.value.u64s.length = elem->value.value.u64s.length;
-            memcpy(value->value.value.u64s.u64s, elem->value.value.u64s.u64s,
-                   elem->value.value.u64s.length * sizeof(uint64_t));
-            break;
-        case NEU_TYPE_ARRAY_FLOAT:
-            value->value.value.f32s.length = elem->value.value.f32s.length;
-            memcpy(value->value.value.f32s.f32s, elem->value.value.f32s.f32s,
-                   elem->value.value.f32s.length * sizeof(float));
-            break;
-        case NEU_TYPE_ARRAY_DOUBLE:
-            value->value.value.f64s.length = elem->value.value.f64s.length;
-            memcpy(value->value.value.f64s.f64s, elem->value.value.f64s.f64s,
-                   elem->value.value.f64s.length * sizeof(double));
-            break;
-        case NEU_TYPE_ARRAY_STRING:
-            value->value.value.strs.length = elem->value.value.strs.length;
-            for (int i = 0; i < elem->value.value.strs.length; i++) {
-                value->value.value.strs.strs[i] =
-                    strdup(elem->value.value.strs.strs[i]);
-            }
-            break;
-        case NEU_TYPE_PTR:
-            value->value.value.ptr.length = elem->value.value.ptr.length;
-            value->value.value.ptr.type   = elem->value.value.ptr.type;
-            value->value.value.ptr.ptr =
-                calloc(1, elem->value.value.ptr.length);
-            memcpy(value->value.value.ptr.ptr, elem->value.value.ptr.ptr,
-                   elem->value.value.ptr.length);
-            break;
-        case NEU_TYPE_CUSTOM:
-            value->value.value.json = json_deep_copy(elem->value.value.json);
-            break;
-        }
-
-        for (int i = 0; i < NEU_TAG_META_SIZE; i++) {
-            if (strlen(elem->metas[i].name) > 0) {
-                memcpy(&value->metas[i], &elem->metas[i],
-                       sizeof(neu_tag_meta_t));
-            }
-        }
+        elem_get(elem, value, metas);
 
         if (elem->value.type != NEU_TYPE_ERROR) {
             elem->changed = false;
@@ -1064,31 +520,342 @@ void neu_driver_cache_del(neu_driver_cache_t *cache, const char *group,
                           const char *tag)
 {
     struct elem *elem = NULL;
-    tkey_t       key  = to_key(group, tag);
+    tkey_t       key  = { 0 };
 
     pthread_mutex_lock(&cache->mtx);
-    HASH_FIND(hh, cache->table, &key, sizeof(tkey_t), elem);
+    if (find_key(group, tag, &key)) {
+        elem = elem_find(cache, &key);
+    }
 
     if (elem != NULL) {
         HASH_DEL(cache->table, elem);
-        if (elem->value.type == NEU_TYPE_PTR) {
-            if (elem->value.value.ptr.ptr != NULL) {
-                free(elem->value.value.ptr.ptr);
-                elem->value.value.ptr.ptr = NULL;
-            }
-        } else if (elem->value.type == NEU_TYPE_CUSTOM) {
-            if (elem->value.value.json != NULL) {
-                json_decref(elem->value.value.json);
-                elem->value.value.json = NULL;
-            }
-        } else if (elem->value.type == NEU_TYPE_ARRAY_STRING) {
-            for (int i = 0; i < elem->value.value.strs.length; i++) {
-                free(elem->value.value.strs.strs[i]);
-                elem->value.value.strs.strs[i] = NULL;
-            }
+        elem_free(cache, elem);
+        cache->version += 1;
+    }
+
+    pthread_mutex_unlock(&cache->mtx);
+}
+
+// Scalars are stored as the raw 8 byte union, strings without the trailing
+// zeros, and arrays as `length` elements. Values that own heap memory are
+// not snapshotted.
+static int snapshot_decode(neu_type_e type, const uint8_t *data, uint16_t len,
+                           neu_value_u *value)
+{
+    uint8_t *raw   = (uint8_t *) value;
+    size_t   esize = 0;
+
+    memset(value, 0, sizeof(*value));
+
+    switch (type) {
+    case NEU_TYPE_INT8:
+    case NEU_TYPE_UINT8:
+    case NEU_TYPE_INT16:
+    case NEU_TYPE_UINT16:
+    case NEU_TYPE_INT32:
+    case NEU_TYPE_UINT32:
+    case NEU_TYPE_INT64:
+    case NEU_TYPE_UINT64:
+    case NEU_TYPE_FLOAT:
+    case NEU_TYPE_DOUBLE:
+    case NEU_TYPE_BIT:
+    case NEU_TYPE_BOOL:
+    case NEU_TYPE_WORD:
+    case NEU_TYPE_DWORD:
+    case NEU_TYPE_LWORD:
+        if (len != sizeof(uint64_t)) {
+            return -1;
+        }
+        memcpy(raw, data, len);
+        return 0;
+    case NEU_TYPE_STRING:
+    case NEU_TYPE_TIME:
+    case NEU_TYPE_DATA_AND_TIME:
+    case NEU_TYPE_ARRAY_CHAR:
+        if (len >= NEU_VALUE_SIZE) {
+            return -1;
+        }
+        memcpy(raw, data, len);
+        return 0;
+    default:
+        esize = neu_value_array_elem_size(type);
+        if (esize == 0 || len % esize != 0 || len / esize > NEU_VALUE_SIZE) {
+            return -1;
+        }
+        memcpy(raw, data, len);
+        raw[NEU_VALUE_SIZE * esize] = len / esize;
+        return 0;
+    }
+}
+
+static int buf_append(uint8_t **buf, size_t *size, size_t *cap,
+                      const void *data, size_t len)
+{
+    if (*size + len > *cap) {
+        size_t   n_cap = *cap * 2 > *size + len ? *cap * 2 : *size + len;
+        uint8_t *n_buf = realloc(*buf, n_cap);
+        if (n_buf == NULL) {
+            return -1;
+        }
+        *buf = n_buf;
+        *cap = n_cap;
+    }
+
+    memcpy(*buf + *size, data, len);
+    *size += len;
+    return 0;
+}
+
+static size_t record_size(const uint8_t *rec)
+{
+    snapshot_record_t r = { 0 };
+
+    memcpy(&r, rec, sizeof(r));
+    return sizeof(r) + r.group_len + r.tag_len + r.value_len;
+}
+
+int neu_driver_cache_snapshot_save(neu_driver_cache_t *cache, const char *path)
+{
+    snapshot_header_t header        = { .version = SNAPSHOT_VERSION };
+    uint8_t *         buf           = NULL;
+    size_t            size          = 0;
+    size_t            cap           = 0;
+    uint64_t          version       = 0;
+    int               rv            = 0;
+    struct elem *     elem          = NULL;
+    struct elem *     tmp           = NULL;
+    struct restore *  r             = NULL;
+    struct restore *  tmp_r         = NULL;
+    char              tmp_path[256] = { 0 };
+
+    memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic));
+
+    // serialize under the lock, do the file io without it
+    pthread_mutex_lock(&cache->mtx);
+    if (cache->version == cache->saved_version) {
+        pthread_mutex_unlock(&cache->mtx);
+        return 0;
+    }
+    version = cache->version;
+
+    rv = buf_append(&buf, &size, &cap, &header, sizeof(header));
+    HASH_ITER(hh, cache->table, elem, tmp)
+    {
+        snapshot_record_t rec  = { 0 };
+        const void *      data = NULL;
+        size_t            len  = 0;
+
+        if (rv != 0) {
+            break;
         }
-        free(elem);
+        if ((data = neu_cvalue_data(&elem->value, &len)) == NULL) {
+            continue;
+        }
+
+        rec.value_len = len;
+        rec.timestamp = elem->timestamp;
+        rec.type      = elem->value.type;
+        rec.group_len = neu_intern_len(elem->key.group);
+        rec.tag_len   = neu_intern_len(elem->key.tag);
+
+        if (buf_append(&buf, &size, &cap, &rec, sizeof(rec)) != 0 ||
+            buf_append(&buf, &size, &cap, elem->key.group, rec.group_len) !=
+                0 ||
+            buf_append(&buf, &size, &cap, elem->key.tag, rec.tag_len) != 0 ||
+            buf_append(&buf, &size, &cap, data, rec.value_len) != 0) {
+            rv = -1;
+        }
+        header.count += 1;
     }
 
+    // keep records whose tags have not been loaded yet
+    HASH_ITER(hh, cache->restore_table, r, tmp_r)
+    {
+        if (rv != 0) {
+            break;
+        }
+        rv = buf_append(&buf, &size, &cap, r->rec, record_size(r->rec));
+        header.count += 1;
+    }
     pthread_mutex_unlock(&cache->mtx);
+
+    if (rv != 0) {
+        nlog_error("snapshot %s, out of memory", path);
+        free(buf);
+        return -1;
+    }
+    memcpy(buf, &header, sizeof(header));
+
+    snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", path);
+    FILE *fp = fopen(tmp_path, "wb");
+    if (fp == NULL) {
+        nlog_error("snapshot open %s fail, %s", tmp_path, strerror(errno));
+        free(buf);
+        return -1;
+    }
+
+    if (fwrite(buf, 1, size, fp) != size || fflush(fp) != 0 ||
+        fsync(fileno(fp)) != 0) {
+        nlog_error("snapshot write %s fail, %s", tmp_path, strerror(errno));
+        fclose(fp);
+        remove(tmp_path);
+        free(buf);
+        return -1;
+    }
+    fclose(fp);
+    free(buf);
+
+    if (rename(tmp_path, path) != 0) {
+        nlog_error("snapshot rename %s fail, %s", path, strerror(errno));
+        remove(tmp_path);
+        return -1;
+    }
+
+    pthread_mutex_lock(&cache->mtx);
+    cache->saved_version = version;
+    pthread_mutex_unlock(&cache->mtx);
+
+    nlog_debug("snapshot %s, %" PRIu32 " values, %zu bytes", path,
+               header.count, size);
+    return 0;
+}
+
+int neu_driver_cache_snapshot_load(neu_driver_cache_t *cache, const char *path)
+{
+    snapshot_header_t header = { 0 };
+    struct stat       st     = { 0 };
+    struct restore *  table  = NULL;
+    uint8_t *         map    = NULL;
+    size_t            offset = sizeof(header);
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return errno == ENOENT ? 0 : -1;
+    }
+
+    if (fstat(fd, &st) != 0 || (size_t) st.st_size < sizeof(header)) {
+        close(fd);
+        return -1;
+    }
+
+    map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        nlog_error("snapshot mmap %s fail, %s", path, strerror(errno));
+        return -1;
+    }
+
+    memcpy(&header, map, sizeof(header));
+    if (memcmp(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic)) != 0 ||
+        header.version != SNAPSHOT_VERSION) {
+        nlog_warn("snapshot %s, unknown format, ignore", path);
+        munmap(map, st.st_size);
+        return -1;
+    }
+
+    for (uint32_t i = 0; i < header.count; i++) {
+        snapshot_record_t rec                       = { 0 };
+        struct restore *  r                         = NULL;
+        tkey_t            key                       = { 0 };
+        char              group[NEU_GROUP_NAME_LEN] = { 0 };
+        char              tag[NEU_TAG_NAME_LEN]     = { 0 };
+
+        if (offset + sizeof(rec) > (size_t) st.st_size) {
+            break;
+        }
+        memcpy(&rec, map + offset, sizeof(rec));
+        if (offset + record_size(map + offset) > (size_t) st.st_size ||
+            rec.group_len >= NEU_GROUP_NAME_LEN ||
+            rec.tag_len >= NEU_TAG_NAME_LEN) {
+            break;
+        }
+
+        memcpy(group, map + offset + sizeof(rec), rec.group_len);
+        memcpy(tag, map + offset + sizeof(rec) + rec.group_len, rec.tag_len);
+        key.group = neu_intern(group);
+        key.tag   = neu_intern(tag);
+        if (key.group == NULL || key.tag == NULL) {
+            key_release(&key);
+            break;
+        }
+
+        HASH_FIND_BYHASHVALUE(hh, table, &key, sizeof(tkey_t), key_hash(&key),
+                              r);
+        if (r == NULL) {
+            r      = calloc(1, sizeof(struct restore));
+            r->key = key;
+            HASH_ADD_BYHASHVALUE(hh, table, key, sizeof(tkey_t),
+                                 key_hash(&key), r);
+        } else {
+            key_release(&key);
+        }
+        r->rec = map + offset;
+
+        offset += record_size(map + offset);
+    }
+
+    nlog_notice("snapshot %s, restore %u values", path, HASH_COUNT(table));
+
+    pthread_mutex_lock(&cache->mtx);
+    release_snapshot(cache);
+    cache->restore_table = table;
+    cache->snapshot      = map;
+    cache->snapshot_size = st.st_size;
+    if (table == NULL) {
+        release_snapshot(cache);
+    }
+    pthread_mutex_unlock(&cache->mtx);
+
+    return 0;
+}
+
+int neu_driver_cache_restore(neu_driver_cache_t *cache, const char *group,
+                             const char *tag, neu_type_e type)
+{
+    struct restore *  r     = NULL;
+    struct elem *     elem  = NULL;
+    snapshot_record_t rec   = { 0 };
+    neu_dvalue_t      value = { 0 };
+    tkey_t            key   = { 0 };
+    int               ret   = -1;
+
+    pthread_mutex_lock(&cache->mtx);
+    if (find_key(group, tag, &key)) {
+        HASH_FIND_BYHASHVALUE(hh, cache->restore_table, &key, sizeof(tkey_t),
+                              key_hash(&key), r);
+    }
+    if (r == NULL) {
+        pthread_mutex_unlock(&cache->mtx);
+        return -1;
+    }
+
+    HASH_DEL(cache->restore_table, r);
+    elem = elem_find(cache, &key);
+    memcpy(&rec, r->rec, sizeof(rec));
+
+    // a tag that changed type since the snapshot stays not ready, and a
+    // value already read from the device is never overwritten
+    if (elem != NULL && rec.type == type && elem->timestamp == 0 &&
+        elem->value.type == NEU_TYPE_ERROR &&
+        snapshot_decode(rec.type,
+                        r->rec + sizeof(rec) + rec.group_len + rec.tag_len,
+                        rec.value_len, &value.value) == 0) {
+        value.type = rec.type;
+        neu_cvalue_set(cache->slab, &elem->value, &value);
+        elem->timestamp = rec.timestamp;
+        elem->cached    = rec.timestamp;
+        elem->changed   = true;
+        elem->restored  = true;
+        ret             = 0;
+    }
+
+    key_release(&r->key);
+    free(r);
+    if (cache->restore_table == NULL) {
+        release_snapshot(cache);
+    }
+    cache->version += 1;
+    pthread_mutex_unlock(&cache->mtx);
+
+    return ret;
 }
@@ -22,6 +22,7 @@
 
 #include <stdint.h>
 
+#include "tag.h"
 #include "type.h"
 
 typedef struct neu_driver_cache neu_driver_cache_t;
@@ -40,6 +41,9 @@ void neu_driver_cache_update_change(neu_driver_cache_t *cache,
                                     int64_t timestamp, neu_dvalue_t value,
                                     neu_tag_meta_t *metas, int n_meta,
                                     bool change);
+void neu_driver_cache_update_batch(neu_driver_cache_t *cache,
+                                   const char *group, int64_t timestamp,
+                                   neu_tag_update_t *updates, int n_update);
 
 void neu_driver_cache_del(neu_driver_cache_t *cache, const char *group,
                           const char *tag);
@@ -51,7 +55,8 @@ void *neu_driver_cache_get_trace(neu_driver_cache_t *cache, const char *group);
 
 typedef struct {
     neu_dvalue_t   value;
-    int64_t        timestamp;
+    int64_t        timestamp; // of the value, the device time if there is one
+    int64_t        cached;    // when the value was written to the cache
     neu_tag_meta_t metas[NEU_TAG_META_SIZE];
 } neu_driver_cache_value_t;
 
@@ -63,4 +68,25 @@ int neu_driver_cache_meta_get_changed(neu_driver_cache_t *cache,
                                       neu_driver_cache_value_t *value,
                                       neu_tag_meta_t *metas, int n_meta);
 
+// Hold the cache across several neu_driver_cache_meta_get_locked calls, so
+// that they all see the values of the same update.
+void neu_driver_cache_lock(neu_driver_cache_t *cache);
+void neu_driver_cache_unlock(neu_driver_cache_t *cache);
+int  neu_driver_cache_meta_get_locked(neu_driver_cache_t *cache,
+                                      const char *group, const char *tag,
+                                      neu_driver_cache_value_t *value,
+                                      neu_tag_meta_t *metas, int n_meta);
+
+// meta attached to values restored from a snapshot until the first live read
+#define NEU_DRIVER_CACHE_META_RESTORED "restored"
+
+// Write all cached values to `path`, skipped if nothing changed since the
+// last save. The file is replaced atomically.
+int neu_driver_cache_snapshot_save(neu_driver_cache_t *cache, const char *path);
+// Map the snapshot at `path`, its values are applied per tag by
+// neu_driver_cache_restore once the tag is added to the cache.
+int neu_driver_cache_snapshot_load(neu_driver_cache_t *cache, const char *path);
+int neu_driver_cache_restore(neu_driver_cache_t *cache, const char *group,
+                             const char *tag, neu_type_e type);
+
 #endif
@@ -17,6 +17,7 @@
  * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
  **/
 #include <assert.h>
+#include <errno.h>
 #include <float.h>
 #include <math.h>
 #include <netinet/in.h>
@@ -37,11 +38,18 @@
 #include "base/group.h"
 #include "cache.h"
 #include "driver_internal.h"
+#include "driver_registry.h"
 #include "errcodes.h"
+#include "fup_seek.h"
+#include "history.h"
+#include "schedule.h"
 #include "tag.h"
 
 #include "otel/otel_manager.h"
 
+extern size_t tag_history_size;
+extern int    read_overrun_policy;
+
 typedef struct to_be_write_tag {
     bool           single;
     neu_datatag_t *tag;
@@ -66,6 +74,8 @@ typedef struct group {
     neu_event_timer_t *report;
     neu_event_timer_t *read;
     neu_event_timer_t *write;
+    neu_read_slot_t *  read_slot;
+    int64_t            report_phase; // slot phase the report timer follows
 
     UT_array *      apps; // sub_app_t array
     pthread_mutex_t apps_mtx;
@@ -79,11 +89,23 @@ typedef struct group {
 struct neu_adapter_driver {
     neu_adapter_t adapter;
 
-    neu_driver_cache_t *cache;
-    neu_events_t *      driver_events;
+    neu_driver_cache_t *  cache;
+    neu_driver_history_t *history; // NULL when tag history is disabled
+    neu_read_sched_t *    read_sched;
+    neu_fup_seek_t *      fup_seek; // resumed uploads without fup_data_at
+    neu_events_t *        driver_events;
+    neu_event_timer_t *   snapshot;
+
+    // stage latency histograms, NULL if the node has no metrics
+    neu_histogram_t *cache_update;
+    neu_histogram_t *report_build;
 
     size_t        tag_cnt;
     struct group *groups;
+
+    // the driver loop is the only writer of `groups`, direct cache reads
+    // from other threads look groups up under the read lock
+    pthread_rwlock_t groups_mtx;
 };
 
 static void report_to_app(neu_adapter_driver_t *driver, group_t *group,
@@ -115,6 +137,8 @@ static void update_im(neu_adapter_t *adapter, const char *group,
 static void update_with_meta(neu_adapter_t *adapter, const char *group,
                              const char *tag, neu_dvalue_t value,
                              neu_tag_meta_t *metas, int n_meta);
+static void update_batch(neu_adapter_t *adapter, const char *group,
+                         neu_tag_update_t *updates, int n_update);
 static void write_response(neu_adapter_t *adapter, void *r, neu_error error);
 static void directory_response(neu_adapter_t *adapter, void *req, int error,
                                neu_driver_file_info_t *infos, int n_info);
@@ -125,6 +149,8 @@ static void fup_data_response(neu_adapter_t *adapter, void *req, int error,
                               uint8_t *bytes, uint16_t n_bytes, bool more);
 
 static group_t *   find_group(neu_adapter_driver_t *driver, const char *name);
+static int         registry_read(void *ctx, const neu_req_read_group_t *cmd,
+                                 UT_array *tags);
 static void        store_write_tag(group_t *group, to_be_write_tag_t *tag);
 static inline void start_group_timer(neu_adapter_driver_t *driver,
                                      group_t *             grp);
@@ -226,14 +252,35 @@ static void write_response(neu_adapter_t *adapter, void *r, neu_error error)
     }
 }
 
+static int  fup_seek_read(neu_adapter_driver_t *driver,
+                          neu_reqresp_head_t *  req);
+static void fup_seek_replay(neu_adapter_driver_t *driver);
+
 static void fup_data_response(neu_adapter_t *adapter, void *r, int error,
                               uint8_t *bytes, uint16_t n_bytes, bool more)
 {
-    neu_reqresp_head_t *req = (neu_reqresp_head_t *) r;
-    req->type               = NEU_RESP_FUP_DATA;
+    neu_adapter_driver_t *driver = (neu_adapter_driver_t *) adapter;
+    neu_reqresp_head_t *  req    = (neu_reqresp_head_t *) r;
+    neu_req_fup_data_t *  cmd    = (neu_req_fup_data_t *) &req[1];
+    neu_fup_seek_e        seek   = NEU_FUP_SEEK_PASS;
 
     neu_resp_fup_data_t resp = { 0 };
 
+    seek = neu_fup_seek_chunk(driver->fup_seek, req, error, &bytes, &n_bytes,
+                              &more);
+    if (seek == NEU_FUP_SEEK_READ) {
+        error = fup_seek_read(driver, req);
+        if (error == 0) {
+            return;
+        }
+        // the failed read ends the seek
+        seek = neu_fup_seek_chunk(driver->fup_seek, req, error, &bytes,
+                                  &n_bytes, &more);
+    }
+
+    // the request body is still in place behind the header
+    resp.seq   = cmd->seq;
+    req->type  = NEU_RESP_FUP_DATA;
     resp.error = error;
     if (resp.error == 0) {
         resp.more = more;
@@ -243,6 +290,10 @@ static void fup_data_response(neu_adapter_t *adapter, void *r, int error,
     }
 
     adapter->cb_funs.response(adapter, req, &resp);
+
+    if (seek == NEU_FUP_SEEK_DONE) {
+        fup_seek_replay(driver);
+    }
 }
 
 static void fdown_open_response(neu_adapter_t *adapter, void *req, int error)
@@ -307,12 +358,13 @@ static void update_with_meta(neu_adapter_t *adapter, const char *group,
     neu_adapter_driver_t *         driver = (neu_adapter_driver_t *) adapter;
     neu_adapter_update_metric_cb_t update_metric =
         driver->adapter.cb_funs.update_metric;
+    neu_time_pair_t now = neu_time_pair();
 
     if (value.type == NEU_TYPE_ERROR) {
         update_metric(&driver->adapter, NEU_METRIC_GROUP_LAST_ERROR_CODE,
                       value.value.i32, group);
         update_metric(&driver->adapter, NEU_METRIC_GROUP_LAST_ERROR_TS,
-                      global_timestamp, group);
+                      now.real_ms, group);
     }
 
     if (value.type == NEU_TYPE_ERROR && tag == NULL) {
@@ -324,7 +376,7 @@ static void update_with_meta(neu_adapter_t *adapter, const char *group,
             utarray_foreach(tags, neu_datatag_t *, t)
             {
                 neu_driver_cache_update(driver->cache, group, t->name,
-                                        global_timestamp, value, NULL, 0);
+                                        now.real_ms, value, NULL, 0);
                 ++err_count;
             }
             update_metric(&driver->adapter, NEU_METRIC_TAG_READS_TOTAL,
@@ -334,8 +386,16 @@ static void update_with_meta(neu_adapter_t *adapter, const char *group,
             utarray_free(tags);
         }
     } else {
-        neu_driver_cache_update(driver->cache, group, tag, global_timestamp,
-                                value, metas, n_meta);
+        neu_driver_cache_update(driver->cache, group, tag, now.real_ms, value,
+                                metas, n_meta);
+        if (driver->cache_update != NULL) {
+            neu_histogram_record(driver->cache_update,
+                                 neu_time_us() - now.mono_us);
+        }
+        if (driver->history != NULL) {
+            neu_driver_history_add(driver->history, group, tag, now.real_ms,
+                                   &value);
+        }
         update_metric(&driver->adapter, NEU_METRIC_TAG_READS_TOTAL, 1, NULL);
         update_metric(&driver->adapter, NEU_METRIC_TAG_READ_ERRORS_TOTAL,
                       NEU_TYPE_ERROR == value.type, NULL);
@@ -344,7 +404,59 @@ static void update_with_meta(neu_adapter_t *adapter, const char *group,
         "update driver: %s, group: %s, tag: %s, type: %s, timestamp: %" PRId64
         " n_meta: %d",
         driver->adapter.name, group, tag, neu_type_string(value.type),
-        global_timestamp, n_meta);
+        now.real_ms, n_meta);
+}
+
+static void update_batch(neu_adapter_t *adapter, const char *group,
+                         neu_tag_update_t *updates, int n_update)
+{
+    neu_adapter_driver_t *         driver = (neu_adapter_driver_t *) adapter;
+    neu_adapter_update_metric_cb_t update_metric =
+        driver->adapter.cb_funs.update_metric;
+    neu_dvalue_t *  last_error = NULL;
+    uint64_t        n_error    = 0;
+    neu_time_pair_t now        = { 0 };
+
+    if (n_update <= 0) {
+        return;
+    }
+
+    // one reading for the batch, values without a device time share it
+    now = neu_time_pair();
+    neu_driver_cache_update_batch(driver->cache, group, now.real_ms, updates,
+                                  n_update);
+    if (driver->cache_update != NULL) {
+        neu_histogram_record(driver->cache_update, neu_time_us() - now.mono_us);
+    }
+
+    for (int i = 0; i < n_update; i++) {
+        if (updates[i].value.type == NEU_TYPE_ERROR) {
+            last_error = &updates[i].value;
+            n_error += 1;
+        }
+        if (driver->history != NULL) {
+            neu_driver_history_add(driver->history, group, updates[i].tag,
+                                   updates[i].timestamp > 0
+                                       ? updates[i].timestamp
+                                       : now.real_ms,
+                                   &updates[i].value);
+        }
+    }
+
+    if (last_error != NULL) {
+        update_metric(&driver->adapter, NEU_METRIC_GROUP_LAST_ERROR_CODE,
+                      last_error->value.i32, group);
+        update_metric(&driver->adapter, NEU_METRIC_GROUP_LAST_ERROR_TS,
+                      now.real_ms, group);
+    }
+    update_metric(&driver->adapter, NEU_METRIC_TAG_READS_TOTAL, n_update,
+                  NULL);
+    update_metric(&driver->adapter, NEU_METRIC_TAG_READ_ERRORS_TOTAL, n_error,
+                  NULL);
+
+    nlog_debug("update driver: %s, group: %s, tags: %d, errors: %" PRIu64
+               ", timestamp: %" PRId64,
+               driver->adapter.name, group, n_update, n_error, now.real_ms);
 }
 
 static void update_with_trace(neu_adapter_t *adapter, const char *group,
@@ -363,15 +475,19 @@ static void update_im(neu_adapter_t *adapter, const char *group,
                       const char *tag, neu_dvalue_t value,
                       neu_tag_meta_t *metas, int n_meta)
 {
-    neu_adapter_driver_t *driver = (neu_adapter_driver_t *) adapter;
+    neu_adapter_driver_t *driver    = (neu_adapter_driver_t *) adapter;
+    int64_t               timestamp = neu_time_ms();
 
     if (tag == NULL) {
         nlog_warn("update_im tag is null");
         return;
     }
 
-    neu_driver_cache_update_change(driver->cache, group, tag, global_timestamp,
-                                   value, metas, n_meta, true);
+    neu_driver_cache_update_change(driver->cache, group, tag, timestamp, value,
+                                   metas, n_meta, true);
+    if (driver->history != NULL) {
+        neu_driver_history_add(driver->history, group, tag, timestamp, &value);
+    }
     driver->adapter.cb_funs.update_metric(&driver->adapter,
                                           NEU_METRIC_TAG_READS_TOTAL, 1, NULL);
     if (value.type == NEU_TYPE_ERROR) {
@@ -390,7 +506,7 @@ static void update_im(neu_adapter_t *adapter, const char *group,
                    "group: %s, tag: %s, type: %s, "
                    "timestamp: %" PRId64,
                    driver->adapter.name, group, tag,
-                   neu_type_string(value.type), global_timestamp);
+                   neu_type_string(value.type), timestamp);
         return;
     }
 
@@ -398,7 +514,7 @@ static void update_im(neu_adapter_t *adapter, const char *group,
                "group: %s, tag: %s, type: %s, "
                "timestamp: %" PRId64,
                driver->adapter.name, group, tag, neu_type_string(value.type),
-               global_timestamp);
+               timestamp);
 
     neu_reqresp_head_t header = {
         .type = NEU_REQRESP_TRANS_DATA,
@@ -410,7 +526,7 @@ static void update_im(neu_adapter_t *adapter, const char *group,
     data->group  = strdup(group);
     utarray_new(data->tags, neu_resp_tag_value_meta_icd());
 
-    read_report_group(global_timestamp, 0,
+    read_report_group(timestamp, 0,
                       neu_adapter_get_tag_cache_type(&driver->adapter),
                       driver->cache, group, tags, data->tags);
 
@@ -504,6 +620,7 @@ neu_adapter_driver_t *neu_adapter_driver_create()
     neu_adapter_driver_t *driver = calloc(1, sizeof(neu_adapter_driver_t));
 
     driver->cache                                      = neu_driver_cache_new();
+    driver->history                                    = NULL;
     driver->driver_events                              = neu_event_new();
     driver->adapter.cb_funs.driver.update              = update;
     driver->adapter.cb_funs.driver.write_response      = write_response;
@@ -514,30 +631,116 @@ neu_adapter_driver_t *neu_adapter_driver_create()
     driver->adapter.cb_funs.driver.update_im           = update_im;
     driver->adapter.cb_funs.driver.update_with_trace   = update_with_trace;
     driver->adapter.cb_funs.driver.update_with_meta    = update_with_meta;
+    driver->adapter.cb_funs.driver.update_batch        = update_batch;
     driver->adapter.cb_funs.driver.scan_tags_response  = scan_tags_response;
     driver->adapter.cb_funs.driver.test_read_tag_response =
         test_read_tag_response;
 
+    pthread_rwlock_init(&driver->groups_mtx, NULL);
+
+    driver->read_sched = neu_read_sched_new(read_overrun_policy);
+    driver->fup_seek   = neu_fup_seek_new();
+    if (tag_history_size > 0) {
+        driver->history = neu_driver_history_new(tag_history_size);
+        if (driver->history == NULL) {
+            nlog_warn("fail to allocate tag history, history disabled");
+        }
+    }
+
     return driver;
 }
 
 void neu_adapter_driver_destroy(neu_adapter_driver_t *driver)
 {
+    neu_driver_registry_del(driver->adapter.name);
+    pthread_rwlock_destroy(&driver->groups_mtx);
     neu_event_close(driver->driver_events);
+    neu_read_sched_free(driver->read_sched);
+    neu_fup_seek_free(driver->fup_seek);
     neu_driver_cache_destroy(driver->cache);
+    if (driver->history != NULL) {
+        neu_driver_history_destroy(driver->history);
+    }
+}
+
+static inline void snapshot_path(const char *node, char *path, size_t size)
+{
+    snprintf(path, size, "persistence/%s.snapshot", node);
+}
+
+static int snapshot_callback(void *usr_data)
+{
+    neu_adapter_driver_t *driver    = (neu_adapter_driver_t *) usr_data;
+    char                  path[256] = { 0 };
+
+    snapshot_path(driver->adapter.name, path, sizeof(path));
+    neu_driver_cache_snapshot_save(driver->cache, path);
+    return 0;
 }
 
 int neu_adapter_driver_init(neu_adapter_driver_t *driver)
 {
-    (void) driver;
+    char path[256] = { 0 };
+
+    snapshot_path(driver->adapter.name, path, sizeof(path));
+    if (neu_driver_cache_snapshot_load(driver->cache, path) != 0) {
+        nlog_warn("driver: %s, fail to load snapshot %s", driver->adapter.name,
+                  path);
+    }
+
+    neu_event_timer_param_t param = {
+        .second      = NEU_DRIVER_SNAPSHOT_INTERVAL,
+        .millisecond = 0,
+        .usr_data    = (void *) driver,
+        .cb          = snapshot_callback,
+        .type        = NEU_EVENT_TIMER_NOBLOCK,
+    };
+    driver->snapshot = neu_event_add_timer(driver->driver_events, param);
+
+    driver->cache_update = neu_node_metrics_histogram(
+        driver->adapter.metrics, NEU_METRIC_CACHE_UPDATE_US);
+    driver->report_build = neu_node_metrics_histogram(
+        driver->adapter.metrics, NEU_METRIC_REPORT_BUILD_US);
+
+    neu_driver_registry_add(driver->adapter.name, driver, registry_read);
 
     return 0;
 }
 
+void neu_adapter_driver_del_snapshot(const char *node)
+{
+    char path[256] = { 0 };
+
+    snapshot_path(node, path, sizeof(path));
+    remove(path);
+}
+
+void neu_adapter_driver_rename_snapshot(const char *node, const char *new_name)
+{
+    char path[256]     = { 0 };
+    char new_path[256] = { 0 };
+
+    snapshot_path(node, path, sizeof(path));
+    snapshot_path(new_name, new_path, sizeof(new_path));
+    if (rename(path, new_path) != 0 && errno != ENOENT) {
+        nlog_warn("driver: %s, fail to rename snapshot %s to %s, %s", node,
+                  path, new_path, strerror(errno));
+    }
+}
+
 int neu_adapter_driver_uninit(neu_adapter_driver_t *driver)
 {
     group_t *el = NULL, *tmp = NULL;
 
+    // no direct reads past this point
+    neu_driver_registry_del(driver->adapter.name);
+
+    if (driver->snapshot) {
+        neu_event_del_timer(driver->driver_events, driver->snapshot);
+        driver->snapshot = NULL;
+    }
+    snapshot_callback(driver);
+
     HASH_ITER(hh, driver->groups, el, tmp)
     {
         HASH_DEL(driver->groups, el);
@@ -568,9 +771,29 @@ int neu_adapter_driver_uninit(neu_adapter_driver_t *driver)
     return 0;
 }
 
+// report a little after the read of the group, `delay` is to its next read
+static inline void add_report_timer(neu_adapter_driver_t *driver, group_t *grp,
+                                    int64_t delay)
+{
+    uint32_t                interval = neu_group_get_interval(grp->group);
+    neu_event_timer_param_t param    = {
+        .second      = interval / 1000,
+        .millisecond = interval % 1000,
+        .usr_data    = (void *) grp,
+        .cb          = report_callback,
+        .type        = NEU_EVENT_TIMER_NOBLOCK,
+        .delay       = delay + NEU_DRIVER_REPORT_LAG_MS,
+    };
+
+    grp->report_phase =
+        neu_read_sched_phase(driver->read_sched, grp->read_slot);
+    grp->report = neu_adapter_add_timer((neu_adapter_t *) driver, param);
+}
+
 static inline void start_group_timer(neu_adapter_driver_t *driver, group_t *grp)
 {
     uint32_t interval = neu_group_get_interval(grp->group);
+    int64_t  delay    = 0;
 
     neu_event_timer_param_t param = {
         .second      = interval / 1000,
@@ -579,23 +802,21 @@ static inline void start_group_timer(neu_adapter_driver_t *driver, group_t *grp)
         .type        = NEU_EVENT_TIMER_NOBLOCK,
     };
 
-    param.type = driver->adapter.module->timer_type;
-    param.cb   = read_callback;
-    grp->read  = neu_event_add_timer(driver->driver_events, param);
+    // the scheduler spreads the first reads of the groups over the interval
+    grp->read_slot = neu_read_sched_add(driver->read_sched, interval,
+                                        neu_time_us() / 1000, &delay);
 
-    struct timespec t1 = {
-        .tv_sec  = 0,
-        .tv_nsec = 1000 * 1000 * 20,
-    };
-    struct timespec t2 = { 0 };
-    nanosleep(&t1, &t2);
+    param.type  = driver->adapter.module->timer_type;
+    param.cb    = read_callback;
+    param.delay = delay;
+    grp->read   = neu_event_add_timer(driver->driver_events, param);
 
-    param.type  = NEU_EVENT_TIMER_NOBLOCK;
-    param.cb    = report_callback;
-    grp->report = neu_adapter_add_timer((neu_adapter_t *) driver, param);
+    add_report_timer(driver, grp, delay);
 
+    param.type        = NEU_EVENT_TIMER_NOBLOCK;
     param.second      = 0;
     param.millisecond = 3;
+    param.delay       = 0;
     param.cb          = write_callback;
     grp->write        = neu_event_add_timer(driver->driver_events, param);
 }
@@ -618,13 +839,18 @@ void neu_adapter_driver_start_group_timer(neu_adapter_driver_t *driver)
 
 static inline void stop_group_timer(neu_adapter_driver_t *driver, group_t *grp)
 {
+    // the read callback may re-arm the report timer, stop it first
+    if (grp->read) {
+        neu_event_del_timer(driver->driver_events, grp->read);
+        grp->read = NULL;
+    }
     if (grp->report) {
         neu_adapter_del_timer((neu_adapter_t *) driver, grp->report);
         grp->report = NULL;
     }
-    if (grp->read) {
-        neu_event_del_timer(driver->driver_events, grp->read);
-        grp->read = NULL;
+    if (grp->read_slot) {
+        neu_read_sched_del(driver->read_sched, grp->read_slot);
+        grp->read_slot = NULL;
     }
     if (grp->write) {
         neu_event_del_timer(driver->driver_events, grp->write);
@@ -639,6 +865,50 @@ void neu_adapter_driver_stop_group_timer(neu_adapter_driver_t *driver)
     HASH_ITER(hh, driver->groups, el, tmp) { stop_group_timer(driver, el); }
 }
 
+static void read_not_running(UT_array *tags, UT_array *tag_values)
+{
+    utarray_foreach(tags, neu_datatag_t *, tag)
+    {
+        neu_resp_tag_value_meta_t tag_value = { 0 };
+        strcpy(tag_value.tag, tag->name);
+        tag_value.value.type      = NEU_TYPE_ERROR;
+        tag_value.value.value.i32 = NEU_ERR_PLUGIN_NOT_RUNNING;
+
+        utarray_push_back(tag_values, &tag_value);
+    }
+}
+
+static int registry_read(void *ctx, const neu_req_read_group_t *cmd,
+                         UT_array *tag_values)
+{
+    neu_adapter_driver_t *driver = (neu_adapter_driver_t *) ctx;
+    group_t *             g      = NULL;
+
+    pthread_rwlock_rdlock(&driver->groups_mtx);
+    g = find_group(driver, cmd->group);
+    if (g == NULL) {
+        pthread_rwlock_unlock(&driver->groups_mtx);
+        return NEU_ERR_GROUP_NOT_EXIST;
+    }
+
+    UT_array *tags = neu_group_query_read_tag(g->group, cmd->name, cmd->desc,
+                                              cmd->n_tag, cmd->tags);
+
+    if (driver->adapter.state != NEU_NODE_RUNNING_STATE_RUNNING) {
+        read_not_running(tags, tag_values);
+    } else {
+        read_group(global_timestamp,
+                   neu_group_get_interval(g->group) *
+                       NEU_DRIVER_TAG_CACHE_EXPIRE_TIME,
+                   neu_adapter_get_tag_cache_type(&driver->adapter),
+                   driver->cache, cmd->group, tags, tag_values);
+    }
+    pthread_rwlock_unlock(&driver->groups_mtx);
+
+    utarray_free(tags);
+    return NEU_ERR_SUCCESS;
+}
+
 void neu_adapter_driver_read_group(neu_adapter_driver_t *driver,
                                    neu_reqresp_head_t *  req)
 {
@@ -660,15 +930,7 @@ void neu_adapter_driver_read_group(neu_adapter_driver_t *driver,
     utarray_new(resp.tags, neu_resp_tag_value_meta_icd());
 
     if (driver->adapter.state != NEU_NODE_RUNNING_STATE_RUNNING) {
-        utarray_foreach(tags, neu_datatag_t *, tag)
-        {
-            neu_resp_tag_value_meta_t tag_value = { 0 };
-            strcpy(tag_value.tag, tag->name);
-            tag_value.value.type      = NEU_TYPE_ERROR;
-            tag_value.value.value.i32 = NEU_ERR_PLUGIN_NOT_RUNNING;
-
-            utarray_push_back(resp.tags, &tag_value);
-        }
+        read_not_running(tags, resp.tags);
     } else if (cmd->sync) {
         if (NULL == driver->adapter.module->intf_funs->driver.group_sync) {
             // plugin does not support sync read
@@ -715,6 +977,65 @@ void neu_adapter_driver_read_group(neu_adapter_driver_t *driver,
     driver->adapter.cb_funs.response(&driver->adapter, req, &resp);
 }
 
+void neu_adapter_driver_read_history(neu_adapter_driver_t *driver,
+                                     neu_reqresp_head_t *  req)
+{
+    neu_req_read_history_t *cmd   = (neu_req_read_history_t *) &req[1];
+    group_t *               g     = find_group(driver, cmd->group);
+    neu_resp_error_t        error = { 0 };
+
+    if (driver->history == NULL) {
+        error.error = NEU_ERR_HISTORY_DISABLED;
+    } else if (g == NULL) {
+        error.error = NEU_ERR_GROUP_NOT_EXIST;
+    }
+
+    if (error.error != NEU_ERR_SUCCESS) {
+        req->type = NEU_RESP_ERROR;
+        neu_req_read_history_fini(cmd);
+        driver->adapter.cb_funs.response(&driver->adapter, req, &error);
+        return;
+    }
+
+    neu_resp_read_history_t resp = { 0 };
+    UT_array *tags = neu_group_query_read_tag(g->group, NULL, NULL, cmd->n_tag,
+                                              cmd->tags);
+
+    resp.buckets = cmd->buckets;
+    resp.n_tag   = utarray_len(tags);
+    resp.tags    = calloc(resp.n_tag, sizeof(neu_resp_history_tag_t));
+    if (resp.n_tag > 0 && resp.tags == NULL) {
+        resp.n_tag = 0;
+    }
+
+    uint32_t index = 0;
+    utarray_foreach(tags, neu_datatag_t *, tag)
+    {
+        if (index >= resp.n_tag) {
+            break;
+        }
+
+        neu_resp_history_tag_t *t = &resp.tags[index++];
+
+        strcpy(t->tag, tag->name);
+        utarray_new(t->points, neu_history_point_icd());
+        t->error = neu_driver_history_query(driver->history, cmd->group,
+                                            tag->name, cmd->start, cmd->end,
+                                            cmd->buckets, t->points);
+    }
+
+    resp.driver = cmd->driver;
+    resp.group  = cmd->group;
+    cmd->driver = NULL; // ownership moved
+    cmd->group  = NULL; // ownership moved
+
+    utarray_free(tags);
+    neu_req_read_history_fini(cmd);
+
+    req->type = NEU_RESP_READ_HISTORY;
+    driver->adapter.cb_funs.response(&driver->adapter, req, &resp);
+}
+
 void neu_adapter_driver_read_group_paginate(neu_adapter_driver_t *driver,
                                             neu_reqresp_head_t *  req)
 {
@@ -1625,12 +1946,20 @@ int neu_adapter_driver_add_group(neu_adapter_driver_t *driver, const char *name,
                               NEU_METRIC_GROUP_LAST_SEND_MSGS, 0);
         REGISTER_GROUP_METRIC(&driver->adapter, find->name,
                               NEU_METRIC_GROUP_LAST_TIMER_MS, 0);
+        REGISTER_GROUP_METRIC(&driver->adapter, find->name,
+                              NEU_METRIC_GROUP_DEADLINE_MISSES, 0);
+        REGISTER_GROUP_METRIC(&driver->adapter, find->name,
+                              NEU_METRIC_GROUP_OVERRUN_MS, 0);
+        REGISTER_GROUP_METRIC(&driver->adapter, find->name,
+                              NEU_METRIC_GROUP_SKIPPED_READS, 0);
         REGISTER_GROUP_METRIC(&driver->adapter, find->name,
                               NEU_METRIC_GROUP_LAST_ERROR_CODE, 0);
         REGISTER_GROUP_METRIC(&driver->adapter, find->name,
                               NEU_METRIC_GROUP_LAST_ERROR_TS, 0);
 
+        pthread_rwlock_wrlock(&driver->groups_mtx);
         HASH_ADD_STR(driver->groups, name, find);
+        pthread_rwlock_unlock(&driver->groups_mtx);
         ret = NEU_ERR_SUCCESS;
     }
 
@@ -1678,6 +2007,8 @@ int neu_adapter_driver_update_group(neu_adapter_driver_t *driver,
     if (NULL != new_name && 0 != strcmp(name, new_name)) {
         char *new_name_cp1 = strdup(new_name);
         char *new_name_cp2 = strdup(new_name);
+
+        pthread_rwlock_wrlock(&driver->groups_mtx);
         if (new_name_cp1 && new_name_cp2 &&
             0 == neu_group_set_name(find->group, new_name)) {
             HASH_DEL(driver->groups, find);
@@ -1687,12 +2018,17 @@ int neu_adapter_driver_update_group(neu_adapter_driver_t *driver,
             find->grp.group_name = new_name_cp2;
             neu_adapter_metric_update_group_name((neu_adapter_t *) driver, name,
                                                  new_name);
+            if (driver->history != NULL) {
+                neu_driver_history_rename_group(driver->history, name,
+                                                new_name);
+            }
             HASH_ADD_STR(driver->groups, name, find);
         } else {
             free(new_name_cp1);
             free(new_name_cp2);
             ret = NEU_ERR_EINTERNAL;
         }
+        pthread_rwlock_unlock(&driver->groups_mtx);
     }
 
     find->timestamp    = global_timestamp; // trigger group_change
@@ -1714,7 +2050,9 @@ int neu_adapter_driver_del_group(neu_adapter_driver_t *driver, const char *name)
 
     HASH_FIND_STR(driver->groups, name, find);
     if (find != NULL) {
+        pthread_rwlock_wrlock(&driver->groups_mtx);
         HASH_DEL(driver->groups, find);
+        pthread_rwlock_unlock(&driver->groups_mtx);
 
         neu_adapter_driver_try_del_tag(driver, neu_group_tag_size(find->group));
 
@@ -1735,6 +2073,9 @@ int neu_adapter_driver_del_group(neu_adapter_driver_t *driver, const char *name)
         {
             neu_driver_cache_del(driver->cache, name, tag->name);
         }
+        if (driver->history != NULL) {
+            neu_driver_history_del_group(driver->history, name);
+        }
 
         utarray_foreach(find->wt_tags, to_be_write_tag_t *, tag)
         {
@@ -1967,6 +2308,9 @@ int neu_adapter_driver_del_tag(neu_adapter_driver_t *driver, const char *group,
     }
 
     if (ret == NEU_ERR_SUCCESS) {
+        if (driver->history != NULL) {
+            neu_driver_history_del(driver->history, group, tag);
+        }
         neu_adapter_driver_try_del_tag(driver, 1);
         driver->tag_cnt -= 1;
         driver->adapter.cb_funs.update_metric(
@@ -2204,11 +2548,16 @@ static int report_callback(void *usr_data)
         }
     }
 
+    int64_t start = neu_time_us();
     read_report_group(global_timestamp,
                       neu_group_get_interval(group->group) *
                           NEU_DRIVER_TAG_CACHE_EXPIRE_TIME,
                       neu_adapter_get_tag_cache_type(&group->driver->adapter),
                       group->driver->cache, group->name, tags, data->tags);
+    if (group->driver->report_build != NULL) {
+        neu_histogram_record(group->driver->report_build,
+                             neu_time_us() - start);
+    }
 
     if (utarray_len(data->tags) > 0) {
         pthread_mutex_lock(&group->apps_mtx);
@@ -2309,11 +2658,16 @@ static void group_change(void *arg, int64_t timestamp, UT_array *tags,
                          uint32_t interval)
 {
     group_t *group   = (group_t *) arg;
+    bool     keep    = false;
     group->timestamp = timestamp;
     (void) interval;
 
-    if (group->grp.group_free != NULL)
+    if (group->grp.group_change != NULL &&
+        group->grp.group_change(&group->grp, tags) == 0) {
+        keep = true;
+    } else if (group->grp.group_free != NULL) {
         group->grp.group_free(&group->grp);
+    }
 
     utarray_foreach(group->grp.tags, neu_datatag_t *, tag)
     {
@@ -2330,6 +2684,8 @@ static void group_change(void *arg, int64_t timestamp, UT_array *tags,
 
         neu_driver_cache_add(group->driver->cache, group->name, tag->name,
                              value);
+        neu_driver_cache_restore(group->driver->cache, group->name, tag->name,
+                                 tag->type);
     }
 
     neu_plugin_group_t grp = {
@@ -2343,6 +2699,11 @@ static void group_change(void *arg, int64_t timestamp, UT_array *tags,
 
     grp.context = group->grp.context;
     grp.tags    = tags;
+    if (keep) {
+        grp.user_data    = group->grp.user_data;
+        grp.group_free   = group->grp.group_free;
+        grp.group_change = group->grp.group_change;
+    }
     free(group->grp.group_name);
     if (group->grp.tags != NULL) {
         utarray_free(group->grp.tags);
@@ -2439,11 +2800,47 @@ static int write_callback(void *usr_data)
     return 0;
 }
 
+static void read_schedule_next(group_t *group, int64_t start)
+{
+    neu_adapter_driver_t * driver = group->driver;
+    neu_read_sched_stats_t delta  = { 0 };
+    int64_t                end    = neu_time_us() / 1000;
+    int64_t                delay  = neu_read_sched_done(
+        driver->read_sched, group->read_slot, start, end, &delta);
+
+    neu_event_delay_timer(driver->driver_events, group->read, delay);
+
+    // the phases were spread again, keep the report behind the moved reads
+    if (group->report != NULL &&
+        neu_read_sched_phase(driver->read_sched, group->read_slot) !=
+            group->report_phase) {
+        neu_adapter_del_timer((neu_adapter_t *) driver, group->report);
+        add_report_timer(driver, group, delay);
+    }
+
+    if (delta.misses > 0) {
+        nlog_debug("%s-%s read overrun: %" PRIu64 " ms, skipped: %" PRIu64,
+                   driver->adapter.name, group->name, delta.overrun_ms,
+                   delta.skipped);
+        neu_adapter_update_group_metric(&driver->adapter, group->name,
+                                        NEU_METRIC_GROUP_DEADLINE_MISSES, 1);
+        neu_adapter_update_group_metric(&driver->adapter, group->name,
+                                        NEU_METRIC_GROUP_OVERRUN_MS,
+                                        delta.overrun_ms);
+        neu_adapter_update_group_metric(&driver->adapter, group->name,
+                                        NEU_METRIC_GROUP_SKIPPED_READS,
+                                        delta.skipped);
+    }
+}
+
 static int read_callback(void *usr_data)
 {
     group_t *                group = (group_t *) usr_data;
     neu_node_running_state_e state = group->driver->adapter.state;
+    int64_t                  start = neu_time_us() / 1000;
+
     if (state != NEU_NODE_RUNNING_STATE_RUNNING) {
+        read_schedule_next(group, start);
         return 0;
     }
 
@@ -2453,12 +2850,12 @@ static int read_callback(void *usr_data)
     }
 
     if (group->grp.tags != NULL && utarray_len(group->grp.tags) > 0) {
-        int64_t spend = global_timestamp;
+        int64_t spend = neu_time_us();
 
         group->driver->adapter.module->intf_funs->driver.group_timer(
             group->driver->adapter.plugin, &group->grp);
 
-        spend = global_timestamp - spend;
+        spend = (neu_time_us() - spend) / 1000;
         nlog_debug("%s-%s timer: %" PRId64, group->driver->adapter.name,
                    group->name, spend);
 
@@ -2466,9 +2863,24 @@ static int read_callback(void *usr_data)
                                         NEU_METRIC_GROUP_LAST_TIMER_MS, spend);
     }
 
+    read_schedule_next(group, start);
     return 0;
 }
 
+// values read from the cache own their strings and json
+static void expired_value_free(neu_dvalue_t *value)
+{
+    if (value->type == NEU_TYPE_PTR) {
+        free(value->value.ptr.ptr);
+    } else if (value->type == NEU_TYPE_CUSTOM) {
+        json_decref(value->value.json);
+    } else if (value->type == NEU_TYPE_ARRAY_STRING) {
+        for (size_t i = 0; i < value->value.strs.length; ++i) {
+            free(value->value.strs.strs[i]);
+        }
+    }
+}
+
 static void read_report_group(int64_t timestamp, int64_t timeout,
                               neu_tag_cache_type_e cache_type,
                               neu_driver_cache_t *cache, const char *group,
@@ -2499,6 +2911,7 @@ static void read_report_group(int64_t timestamp, int64_t timeout,
             }
         }
         strcpy(tag_value.tag, tag->name);
+        tag_value.timestamp = value.timestamp;
 
         tag_value.datatag.bias = tag->bias;
 
@@ -2574,16 +2987,8 @@ static void read_report_group(int64_t timestamp, int64_t timeout,
         }
 
         if (cache_type != NEU_TAG_CACHE_TYPE_NEVER &&
-            (timestamp - value.timestamp) > timeout && timeout > 0) {
-            if (value.value.type == NEU_TYPE_PTR) {
-                free(value.value.value.ptr.ptr);
-            } else if (value.value.type == NEU_TYPE_CUSTOM) {
-                json_decref(value.value.value.json);
-            } else if (value.value.type == NEU_TYPE_ARRAY_STRING) {
-                for (size_t i = 0; i < value.value.value.strs.length; ++i) {
-                    free(value.value.value.strs.strs[i]);
-                }
-            }
+            (timestamp - value.cached) > timeout && timeout > 0) {
+            expired_value_free(&value.value);
             tag_value.value.type      = NEU_TYPE_ERROR;
             tag_value.value.value.i32 = NEU_ERR_PLUGIN_TAG_VALUE_EXPIRED;
         } else {
@@ -2662,6 +3067,11 @@ static void read_group(int64_t timestamp, int64_t timeout,
                        neu_driver_cache_t *cache, const char *group,
                        UT_array *tags, UT_array *tag_values)
 {
+    unsigned int first = utarray_len(tag_values);
+
+    // values of one group update are never mixed with those of the next,
+    // only copy them under the lock and convert them once it is released
+    neu_driver_cache_lock(cache);
     utarray_foreach(tags, neu_datatag_t *, tag)
     {
         neu_resp_tag_value_meta_t tag_value = { 0 };
@@ -2671,22 +3081,38 @@ static void read_group(int64_t timestamp, int64_t timeout,
 
         tag_value.datatag.bias = tag->bias;
 
-        if (neu_driver_cache_meta_get(cache, group, tag->name, &value,
-                                      tag_value.metas,
-                                      NEU_TAG_META_SIZE) != 0) {
+        if (neu_driver_cache_meta_get_locked(cache, group, tag->name, &value,
+                                             tag_value.metas,
+                                             NEU_TAG_META_SIZE) != 0) {
             tag_value.value.type      = NEU_TYPE_ERROR;
             tag_value.value.value.i32 = NEU_ERR_PLUGIN_TAG_NOT_READY;
-
-            utarray_push_back(tag_values, &tag_value);
-            continue;
+        } else if (cache_type != NEU_TAG_CACHE_TYPE_NEVER &&
+                   (timestamp - value.cached) > timeout) {
+            // the values are stamped with the device time, expiry goes
+            // by the time they were cached
+            expired_value_free(&value.value);
+            tag_value.value.type      = NEU_TYPE_ERROR;
+            tag_value.value.value.i32 = NEU_ERR_PLUGIN_TAG_VALUE_EXPIRED;
+        } else {
+            tag_value.timestamp = value.timestamp;
+            tag_value.value     = value.value;
         }
+        utarray_push_back(tag_values, &tag_value);
+    }
+    neu_driver_cache_unlock(cache);
 
-        if (value.value.type == NEU_TYPE_ERROR) {
-            tag_value.value = value.value;
-            utarray_push_back(tag_values, &tag_value);
+    for (unsigned int i = 0; i < utarray_len(tags); i++) {
+        neu_datatag_t *            tag = utarray_eltptr(tags, i);
+        neu_resp_tag_value_meta_t *tag_value =
+            utarray_eltptr(tag_values, first + i);
+        neu_driver_cache_value_t value = { 0 };
+
+        if (tag_value->value.type == NEU_TYPE_ERROR) {
             continue;
         }
 
+        value.value = tag_value->value;
+
         switch (tag->type) {
         case NEU_TYPE_UINT16:
         case NEU_TYPE_INT16:
@@ -2743,85 +3169,69 @@ static void read_group(int64_t timestamp, int64_t timeout,
             break;
         }
 
-        if (cache_type != NEU_TAG_CACHE_TYPE_NEVER &&
-            (timestamp - value.timestamp) > timeout) {
-            if (value.value.type == NEU_TYPE_PTR) {
-                free(value.value.value.ptr.ptr);
-            } else if (value.value.type == NEU_TYPE_CUSTOM) {
-                json_decref(value.value.value.json);
-            } else if (value.value.type == NEU_TYPE_ARRAY_STRING) {
-                for (size_t i = 0; i < value.value.value.strs.length; ++i) {
-                    free(value.value.value.strs.strs[i]);
-                }
-            }
-            tag_value.value.type      = NEU_TYPE_ERROR;
-            tag_value.value.value.i32 = NEU_ERR_PLUGIN_TAG_VALUE_EXPIRED;
+        if (value.value.type == NEU_TYPE_PTR) {
+            tag_value->value.type             = NEU_TYPE_PTR;
+            tag_value->value.value.ptr.length = value.value.value.ptr.length;
+            tag_value->value.value.ptr.type   = value.value.value.ptr.type;
+            tag_value->value.value.ptr.ptr    = value.value.value.ptr.ptr;
         } else {
-            if (value.value.type == NEU_TYPE_PTR) {
-                tag_value.value.type             = NEU_TYPE_PTR;
-                tag_value.value.value.ptr.length = value.value.value.ptr.length;
-                tag_value.value.value.ptr.type   = value.value.value.ptr.type;
-                tag_value.value.value.ptr.ptr    = value.value.value.ptr.ptr;
-            } else {
-                tag_value.value = value.value;
-            }
-            if (tag->decimal != 0 || tag->bias != 0) {
-                tag_value.value.type = NEU_TYPE_DOUBLE;
-                double decimal       = tag->decimal != 0 ? tag->decimal : 1;
-                double bias          = tag->bias;
-                switch (tag->type) {
-                case NEU_TYPE_INT8:
-                    tag_value.value.value.d64 =
-                        (double) tag_value.value.value.i8 * decimal + bias;
-                    break;
-                case NEU_TYPE_UINT8:
-                    tag_value.value.value.d64 =
-                        (double) tag_value.value.value.u8 * decimal + bias;
-                    break;
-                case NEU_TYPE_INT16:
-                    tag_value.value.value.d64 =
-                        (double) tag_value.value.value.i16 * decimal + bias;
-                    break;
-                case NEU_TYPE_UINT16:
-                    tag_value.value.value.d64 =
-                        (double) tag_value.value.value.u16 * decimal + bias;
-                    break;
-                case NEU_TYPE_INT32:
-                    tag_value.value.value.d64 =
-                        (double) tag_value.value.value.i32 * decimal + bias;
-                    break;
-                case NEU_TYPE_UINT32:
-                    tag_value.value.value.d64 =
-                        (double) tag_value.value.value.u32 * decimal + bias;
-                    break;
-                case NEU_TYPE_INT64:
-                    tag_value.value.value.d64 =
-                        (double) tag_value.value.value.i64 * decimal + bias;
-                    break;
-                case NEU_TYPE_UINT64:
-                    tag_value.value.value.d64 =
-                        (double) tag_value.value.value.u64 * decimal + bias;
-                    break;
-                case NEU_TYPE_FLOAT:
-                    tag_value.value.value.d64 =
-                        (double) tag_value.value.value.f32 * decimal + bias;
-                    break;
-                case NEU_TYPE_DOUBLE:
-                    tag_value.value.value.d64 =
-                        (double) tag_value.value.value.d64 * decimal + bias;
-                    break;
-                default:
-                    tag_value.value.type = tag->type;
-                    break;
-                }
+            tag_value->value = value.value;
+        }
+        if (tag->decimal != 0 || tag->bias != 0) {
+            tag_value->value.type = NEU_TYPE_DOUBLE;
+            double decimal       = tag->decimal != 0 ? tag->decimal : 1;
+            double bias          = tag->bias;
+            switch (tag->type) {
+            case NEU_TYPE_INT8:
+                tag_value->value.value.d64 =
+                    (double) tag_value->value.value.i8 * decimal + bias;
+                break;
+            case NEU_TYPE_UINT8:
+                tag_value->value.value.d64 =
+                    (double) tag_value->value.value.u8 * decimal + bias;
+                break;
+            case NEU_TYPE_INT16:
+                tag_value->value.value.d64 =
+                    (double) tag_value->value.value.i16 * decimal + bias;
+                break;
+            case NEU_TYPE_UINT16:
+                tag_value->value.value.d64 =
+                    (double) tag_value->value.value.u16 * decimal + bias;
+                break;
+            case NEU_TYPE_INT32:
+                tag_value->value.value.d64 =
+                    (double) tag_value->value.value.i32 * decimal + bias;
+                break;
+            case NEU_TYPE_UINT32:
+                tag_value->value.value.d64 =
+                    (double) tag_value->value.value.u32 * decimal + bias;
+                break;
+            case NEU_TYPE_INT64:
+                tag_value->value.value.d64 =
+                    (double) tag_value->value.value.i64 * decimal + bias;
+                break;
+            case NEU_TYPE_UINT64:
+                tag_value->value.value.d64 =
+                    (double) tag_value->value.value.u64 * decimal + bias;
+                break;
+            case NEU_TYPE_FLOAT:
+                tag_value->value.value.d64 =
+                    (double) tag_value->value.value.f32 * decimal + bias;
+                break;
+            case NEU_TYPE_DOUBLE:
+                tag_value->value.value.d64 =
+                    (double) tag_value->value.value.d64 * decimal + bias;
+                break;
+            default:
+                tag_value->value.type = tag->type;
+                break;
             }
+        }
 
-            if (tag->precision == 0 && tag->bias == 0 &&
-                tag->type == NEU_TYPE_DOUBLE) {
-                format_tag_value(&tag_value.value);
-            }
+        if (tag->precision == 0 && tag->bias == 0 &&
+            tag->type == NEU_TYPE_DOUBLE) {
+            format_tag_value(&tag_value->value);
         }
-        utarray_push_back(tag_values, &tag_value);
     }
 }
 
@@ -2928,16 +3338,8 @@ static void read_group_paginate(int64_t timestamp, int64_t timeout,
         }
 
         if (cache_type != NEU_TAG_CACHE_TYPE_NEVER &&
-            (timestamp - value.timestamp) > timeout) {
-            if (value.value.type == NEU_TYPE_PTR) {
-                free(value.value.value.ptr.ptr);
-            } else if (value.value.type == NEU_TYPE_CUSTOM) {
-                json_decref(value.value.value.json);
-            } else if (value.value.type == NEU_TYPE_ARRAY_STRING) {
-                for (size_t i = 0; i < value.value.value.strs.length; ++i) {
-                    free(value.value.value.strs.strs[i]);
-                }
-            }
+            (timestamp - value.cached) > timeout) {
+            expired_value_free(&value.value);
             tag_value.value.type      = NEU_TYPE_ERROR;
             tag_value.value.value.i32 = NEU_ERR_PLUGIN_TAG_VALUE_EXPIRED;
         } else {
@@ -3213,17 +3615,86 @@ int neu_adapter_driver_fdown_open(neu_adapter_driver_t *driver,
         driver->adapter.plugin, (void *) req, node, src_path, dst_path, size);
 }
 
-int neu_adapter_driver_fup_data(neu_adapter_driver_t *driver,
-                                neu_reqresp_head_t *req, const char *path)
+// read the next chunk of the seeking request, see neu_fup_seek_read
+static int fup_seek_read(neu_adapter_driver_t *driver, neu_reqresp_head_t *req)
+{
+    const neu_plugin_intf_funs_t *intf = driver->adapter.module->intf_funs;
+    neu_req_fup_data_t *          cmd  = (neu_req_fup_data_t *) &req[1];
+    int                           rv   = 0;
+
+    if (!neu_fup_seek_read(driver->fup_seek)) {
+        return 0;
+    }
+
+    do {
+        rv = intf->driver.fup_data(driver->adapter.plugin, (void *) req,
+                                   cmd->path);
+    } while (rv == 0 && neu_fup_seek_again(driver->fup_seek));
+
+    return rv;
+}
+
+static int fup_data_dispatch(neu_adapter_driver_t *driver,
+                             neu_reqresp_head_t *req, const char *path,
+                             int64_t offset)
 {
+    const neu_plugin_intf_funs_t *intf = driver->adapter.module->intf_funs;
+
     if (driver->adapter.state != NEU_NODE_RUNNING_STATE_RUNNING) {
         return NEU_ERR_PLUGIN_NOT_RUNNING;
     }
-    if (driver->adapter.module->intf_funs->driver.fup_data == NULL) {
+    if (offset > 0 && intf->driver.fup_data_at != NULL) {
+        return intf->driver.fup_data_at(driver->adapter.plugin, (void *) req,
+                                        path, offset);
+    }
+    if (intf->driver.fup_data == NULL) {
         return NEU_ERR_PLUGIN_NOT_SUPPORT_FUP_DATA;
     }
-    return driver->adapter.module->intf_funs->driver.fup_data(
-        driver->adapter.plugin, (void *) req, path);
+    if (offset > 0) {
+        int rv = 0;
+
+        // read from the start of the file and drop up to the offset
+        neu_fup_seek_start(driver->fup_seek, req, offset);
+        rv = fup_seek_read(driver, req);
+        if (rv != 0) {
+            uint8_t *bytes   = NULL;
+            uint16_t n_bytes = 0;
+            bool     more    = false;
+
+            neu_fup_seek_chunk(driver->fup_seek, req, rv, &bytes, &n_bytes,
+                               &more);
+        }
+        return rv;
+    }
+    return intf->driver.fup_data(driver->adapter.plugin, (void *) req, path);
+}
+
+// requests queued behind a seek, in order, until one seeks again
+static void fup_seek_replay(neu_adapter_driver_t *driver)
+{
+    neu_reqresp_head_t *req = NULL;
+
+    while ((req = neu_fup_seek_next(driver->fup_seek)) != NULL) {
+        neu_req_fup_data_t *cmd = (neu_req_fup_data_t *) &req[1];
+        int rv = fup_data_dispatch(driver, req, cmd->path, cmd->offset);
+
+        if (rv != 0) {
+            fup_data_response(&driver->adapter, req, rv, NULL, 0, false);
+        }
+    }
+}
+
+int neu_adapter_driver_fup_data(neu_adapter_driver_t *driver,
+                                neu_reqresp_head_t *req, const char *path,
+                                int64_t offset)
+{
+    if (driver->adapter.state != NEU_NODE_RUNNING_STATE_RUNNING) {
+        return NEU_ERR_PLUGIN_NOT_RUNNING;
+    }
+    if (neu_fup_seek_defer(driver->fup_seek, req)) {
+        return 0;
+    }
+    return fup_data_dispatch(driver, req, path, offset);
 }
 
 int neu_adapter_driver_fdown_data(neu_adapter_driver_t *driver,
@@ -27,6 +27,8 @@ neu_adapter_driver_t *neu_adapter_driver_create();
 void neu_adapter_driver_destroy(neu_adapter_driver_t *driver);
 int  neu_adapter_driver_init(neu_adapter_driver_t *driver);
 int  neu_adapter_driver_uninit(neu_adapter_driver_t *driver);
+void neu_adapter_driver_del_snapshot(const char *node);
+void neu_adapter_driver_rename_snapshot(const char *node, const char *new_name);
 
 void neu_adapter_driver_start_group_timer(neu_adapter_driver_t *driver);
 void neu_adapter_driver_stop_group_timer(neu_adapter_driver_t *driver);
@@ -37,6 +39,8 @@ void neu_adapter_driver_read_group_paginate(neu_adapter_driver_t *driver,
                                             neu_reqresp_head_t *  req);
 void neu_adapter_driver_test_read_tag(neu_adapter_driver_t *driver,
                                       neu_reqresp_head_t *  req);
+void neu_adapter_driver_read_history(neu_adapter_driver_t *driver,
+                                     neu_reqresp_head_t *  req);
 
 int neu_adapter_driver_write_tag(neu_adapter_driver_t *driver,
                                  neu_reqresp_head_t *  req);
@@ -106,7 +110,8 @@ int neu_adapter_driver_fdown_open(neu_adapter_driver_t *driver,
                                   const char *src_path, const char *dst_path,
                                   int64_t size);
 int neu_adapter_driver_fup_data(neu_adapter_driver_t *driver,
-                                neu_reqresp_head_t *req, const char *path);
+                                neu_reqresp_head_t *req, const char *path,
+                                int64_t offset);
 int neu_adapter_driver_fdown_data(neu_adapter_driver_t *driver,
                                   neu_reqresp_head_t *req, uint8_t *data,
                                   uint16_t len, bool more);
@@ -0,0 +1,180 @@
+/**
+ * NEURON IIoT System for Industry 4.0
+ * Copyright (C) 2020-2024 EMQ Technologies Co., Ltd All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ **/
+
+#include <pthread.h>
+#include <stdlib.h>
+
+#include "utils/utlist.h"
+
+#include "fup_seek.h"
+
+typedef struct deferred {
+    void *           req;
+    struct deferred *prev;
+    struct deferred *next;
+} deferred_t;
+
+struct neu_fup_seek {
+    void *  req;  // the seeking request, NULL if none
+    int64_t skip; // bytes still to drop
+    bool    reading;
+    bool    again;
+
+    bool        replaying;
+    deferred_t *deferred;
+
+    pthread_mutex_t mtx;
+};
+
+neu_fup_seek_t *neu_fup_seek_new()
+{
+    neu_fup_seek_t *seek = calloc(1, sizeof(neu_fup_seek_t));
+
+    if (NULL != seek) {
+        pthread_mutex_init(&seek->mtx, NULL);
+    }
+    return seek;
+}
+
+void neu_fup_seek_free(neu_fup_seek_t *seek)
+{
+    deferred_t *el = NULL, *tmp = NULL;
+
+    if (NULL == seek) {
+        return;
+    }
+
+    DL_FOREACH_SAFE(seek->deferred, el, tmp)
+    {
+        DL_DELETE(seek->deferred, el);
+        free(el);
+    }
+    pthread_mutex_destroy(&seek->mtx);
+    free(seek);
+}
+
+bool neu_fup_seek_defer(neu_fup_seek_t *seek, void *req)
+{
+    deferred_t *el    = NULL;
+    bool        defer = false;
+
+    pthread_mutex_lock(&seek->mtx);
+    defer = NULL != seek->req || seek->replaying || NULL != seek->deferred;
+    if (defer && NULL != (el = calloc(1, sizeof(deferred_t)))) {
+        el->req = req;
+        DL_APPEND(seek->deferred, el);
+    }
+    pthread_mutex_unlock(&seek->mtx);
+
+    // out of memory, let it through rather than lose it
+    return NULL != el;
+}
+
+void neu_fup_seek_start(neu_fup_seek_t *seek, void *req, int64_t offset)
+{
+    pthread_mutex_lock(&seek->mtx);
+    seek->req     = req;
+    seek->skip    = offset;
+    seek->reading = false;
+    seek->again   = false;
+    pthread_mutex_unlock(&seek->mtx);
+}
+
+neu_fup_seek_e neu_fup_seek_chunk(neu_fup_seek_t *seek, void *req, int error,
+                                  uint8_t **bytes, uint16_t *n_bytes,
+                                  bool *more)
+{
+    neu_fup_seek_e ret = NEU_FUP_SEEK_DONE;
+
+    pthread_mutex_lock(&seek->mtx);
+    if (NULL == seek->req || req != seek->req) {
+        pthread_mutex_unlock(&seek->mtx);
+        return NEU_FUP_SEEK_PASS;
+    }
+
+    if (0 == error) {
+        if (*more && *n_bytes <= seek->skip) {
+            seek->skip -= *n_bytes;
+            ret = NEU_FUP_SEEK_READ;
+        } else if (*n_bytes > seek->skip) {
+            *bytes += seek->skip;
+            *n_bytes -= seek->skip;
+        } else {
+            // the offset is at or past the end of the file
+            *n_bytes = 0;
+        }
+    }
+
+    if (NEU_FUP_SEEK_DONE == ret) {
+        seek->req       = NULL;
+        seek->skip      = 0;
+        seek->reading   = false;
+        seek->again     = false;
+        seek->replaying = NULL != seek->deferred;
+    }
+    pthread_mutex_unlock(&seek->mtx);
+
+    return ret;
+}
+
+bool neu_fup_seek_read(neu_fup_seek_t *seek)
+{
+    bool read = false;
+
+    pthread_mutex_lock(&seek->mtx);
+    if (seek->reading) {
+        seek->again = true;
+    } else {
+        seek->reading = true;
+        read          = true;
+    }
+    pthread_mutex_unlock(&seek->mtx);
+
+    return read;
+}
+
+bool neu_fup_seek_again(neu_fup_seek_t *seek)
+{
+    bool again = false;
+
+    pthread_mutex_lock(&seek->mtx);
+    again         = seek->again;
+    seek->again   = false;
+    seek->reading = again;
+    pthread_mutex_unlock(&seek->mtx);
+
+    return again;
+}
+
+void *neu_fup_seek_next(neu_fup_seek_t *seek)
+{
+    deferred_t *el  = NULL;
+    void *      req = NULL;
+
+    pthread_mutex_lock(&seek->mtx);
+    if (NULL == seek->req && NULL != (el = seek->deferred)) {
+        DL_DELETE(seek->deferred, el);
+        req = el->req;
+        free(el);
+    }
+    seek->replaying = NULL != req;
+    pthread_mutex_unlock(&seek->mtx);
+
+    return req;
+}
@@ -0,0 +1,86 @@
+/**
+ * NEURON IIoT System for Industry 4.0
+ * Copyright (C) 2020-2024 EMQ Technologies Co., Ltd All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ **/
+
+#ifndef _NEU_DRIVER_FUP_SEEK_H_
+#define _NEU_DRIVER_FUP_SEEK_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stdint.h>
+
+typedef enum {
+    NEU_FUP_SEEK_PASS = 0, // not the seeking request, answer the chunk as is
+    NEU_FUP_SEEK_READ,     // the chunk is dropped, read the next one
+    NEU_FUP_SEEK_DONE,     // answer the trimmed chunk, then replay the queue
+} neu_fup_seek_e;
+
+/**
+ * Resumed file upload for drivers without fup_data_at.
+ *
+ * A request for an offset is served by reading the file from its start and
+ * dropping chunks up to the offset, the chunk the offset falls into is
+ * trimmed. Requests arriving meanwhile would read in between, they are
+ * queued and replayed in order once the seek is done.
+ *
+ * Thread safe, chunks may be answered from any thread.
+ */
+typedef struct neu_fup_seek neu_fup_seek_t;
+
+neu_fup_seek_t *neu_fup_seek_new();
+void            neu_fup_seek_free(neu_fup_seek_t *seek);
+
+// queue `req` if a seek or a replay is in progress, returns true if queued
+bool neu_fup_seek_defer(neu_fup_seek_t *seek, void *req);
+// `req` seeks to `offset`, there must be no seek in progress
+void neu_fup_seek_start(neu_fup_seek_t *seek, void *req, int64_t offset);
+
+/**
+ * Account a chunk answered for `req`.
+ *
+ * For the seeking request `bytes`, `n_bytes` and `more` are trimmed to what
+ * lies past the offset once it is reached. An error ends the seek.
+ */
+neu_fup_seek_e neu_fup_seek_chunk(neu_fup_seek_t *seek, void *req, int error,
+                                  uint8_t **bytes, uint16_t *n_bytes,
+                                  bool *more);
+
+/**
+ * Read loop of the seeking request.
+ *
+ * Drivers may answer within fup_data. neu_fup_seek_read returns false when a
+ * loop further up the stack is already reading, the read is left to it.
+ * Otherwise the caller reads until neu_fup_seek_again returns false.
+ */
+bool neu_fup_seek_read(neu_fup_seek_t *seek);
+bool neu_fup_seek_again(neu_fup_seek_t *seek);
+
+/**
+ * Next queued request to replay, NULL once the queue is empty or a replayed
+ * request started another seek. New requests stay queued until then.
+ */
+void *neu_fup_seek_next(neu_fup_seek_t *seek);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,540 @@
+/**
+ * NEURON IIoT System for Industry 4.0
+ * Copyright (C) 2020-2024 EMQ Technologies Co., Ltd All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ **/
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "utils/uthash.h"
+#include "utils/utarray.h"
+
+#include "define.h"
+#include "errcodes.h"
+
+#include "history.h"
+
+#define BLOCK_POINTS 64
+#define COLUMN_SIZE 192
+#define VARINT_MAX 10
+#define QUERY_MAX_BUCKETS 10000
+
+typedef enum {
+    KIND_INT,
+    KIND_UINT,
+    KIND_FLOAT,
+    KIND_DOUBLE,
+} value_kind_e;
+
+// Timestamps are zigzag varints of the delta to the previous point,
+// integers are zigzag varints of the delta to the previous value and
+// floating point values are varints of the xor with the previous bits.
+typedef struct {
+    int64_t      first_ts;
+    int64_t      last_ts;
+    uint64_t     last_bits;
+    double       min;
+    double       max;
+    double       sum;
+    value_kind_e kind;
+    uint16_t     n_point;
+    uint16_t     ts_len;
+    uint16_t     val_len;
+    uint8_t      ts[COLUMN_SIZE];
+    uint8_t      val[COLUMN_SIZE];
+} block_t;
+
+typedef struct {
+    char group[NEU_GROUP_NAME_LEN];
+    char tag[NEU_TAG_NAME_LEN];
+} skey_t;
+
+typedef struct {
+    skey_t   key;
+    uint32_t head;  // oldest block
+    uint32_t count; // blocks in use
+    block_t *blocks;
+
+    UT_hash_handle hh;
+} series_t;
+
+struct neu_driver_history {
+    pthread_mutex_t mtx;
+    uint32_t        n_block;
+    series_t *      table;
+};
+
+static inline uint64_t zigzag(int64_t v)
+{
+    return ((uint64_t) v << 1) ^ (uint64_t)(v >> 63);
+}
+
+static inline int64_t unzigzag(uint64_t v)
+{
+    return (int64_t)(v >> 1) ^ -(int64_t)(v & 1);
+}
+
+static inline uint16_t put_varint(uint8_t *buf, uint64_t v)
+{
+    uint16_t n = 0;
+
+    while (v >= 0x80) {
+        buf[n++] = (uint8_t) v | 0x80;
+        v >>= 7;
+    }
+    buf[n++] = (uint8_t) v;
+
+    return n;
+}
+
+static inline uint16_t get_varint(const uint8_t *buf, uint64_t *v)
+{
+    uint16_t n     = 0;
+    int      shift = 0;
+
+    *v = 0;
+    do {
+        *v |= (uint64_t)(buf[n] & 0x7f) << shift;
+        shift += 7;
+    } while (buf[n++] & 0x80);
+
+    return n;
+}
+
+static int to_bits(const neu_dvalue_t *value, value_kind_e *kind,
+                   uint64_t *bits, double *d)
+{
+    switch (value->type) {
+    case NEU_TYPE_INT8:
+        *kind = KIND_INT;
+        *bits = (uint64_t) value->value.i8;
+        *d    = value->value.i8;
+        return 0;
+    case NEU_TYPE_INT16:
+        *kind = KIND_INT;
+        *bits = (uint64_t) value->value.i16;
+        *d    = value->value.i16;
+        return 0;
+    case NEU_TYPE_INT32:
+        *kind = KIND_INT;
+        *bits = (uint64_t) value->value.i32;
+        *d    = value->value.i32;
+        return 0;
+    case NEU_TYPE_INT64:
+        *kind = KIND_INT;
+        *bits = (uint64_t) value->value.i64;
+        *d    = value->value.i64;
+        return 0;
+    case NEU_TYPE_BIT:
+    case NEU_TYPE_UINT8:
+        *kind = KIND_UINT;
+        *bits = value->value.u8;
+        *d    = value->value.u8;
+        return 0;
+    case NEU_TYPE_BOOL:
+        *kind = KIND_UINT;
+        *bits = value->value.boolean;
+        *d    = value->value.boolean;
+        return 0;
+    case NEU_TYPE_UINT16:
+    case NEU_TYPE_WORD:
+        *kind = KIND_UINT;
+        *bits = value->value.u16;
+        *d    = value->value.u16;
+        return 0;
+    case NEU_TYPE_UINT32:
+    case NEU_TYPE_DWORD:
+        *kind = KIND_UINT;
+        *bits = value->value.u32;
+        *d    = value->value.u32;
+        return 0;
+    case NEU_TYPE_UINT64:
+    case NEU_TYPE_LWORD:
+        *kind = KIND_UINT;
+        *bits = value->value.u64;
+        *d    = value->value.u64;
+        return 0;
+    case NEU_TYPE_FLOAT: {
+        uint32_t u32 = 0;
+        memcpy(&u32, &value->value.f32, sizeof(u32));
+        *kind = KIND_FLOAT;
+        *bits = u32;
+        *d    = value->value.f32;
+        return 0;
+    }
+    case NEU_TYPE_DOUBLE:
+        *kind = KIND_DOUBLE;
+        memcpy(bits, &value->value.d64, sizeof(*bits));
+        *d = value->value.d64;
+        return 0;
+    default:
+        return -1;
+    }
+}
+
+static inline double from_bits(value_kind_e kind, uint64_t bits)
+{
+    switch (kind) {
+    case KIND_INT:
+        return (int64_t) bits;
+    case KIND_UINT:
+        return bits;
+    case KIND_FLOAT: {
+        uint32_t u32 = (uint32_t) bits;
+        float    f   = 0;
+        memcpy(&f, &u32, sizeof(f));
+        return f;
+    }
+    case KIND_DOUBLE: {
+        double d = 0;
+        memcpy(&d, &bits, sizeof(d));
+        return d;
+    }
+    }
+
+    return 0;
+}
+
+static inline bool block_full(const block_t *block)
+{
+    return block->n_point >= BLOCK_POINTS ||
+        block->ts_len + VARINT_MAX > COLUMN_SIZE ||
+        block->val_len + VARINT_MAX > COLUMN_SIZE;
+}
+
+static block_t *series_block(neu_driver_history_t *history, series_t *series,
+                             value_kind_e kind, int64_t timestamp)
+{
+    block_t *block = NULL;
+
+    if (series->count > 0) {
+        block = &series->blocks[(series->head + series->count - 1) %
+                                history->n_block];
+        if (!block_full(block) && block->kind == kind) {
+            return block;
+        }
+    }
+
+    if (series->count == history->n_block) {
+        series->head = (series->head + 1) % history->n_block;
+        series->count -= 1;
+    }
+
+    block = &series->blocks[(series->head + series->count) % history->n_block];
+    series->count += 1;
+
+    memset(block, 0, sizeof(*block));
+    block->kind     = kind;
+    block->first_ts = timestamp;
+    block->last_ts  = timestamp;
+
+    return block;
+}
+
+neu_driver_history_t *neu_driver_history_new(size_t size)
+{
+    neu_driver_history_t *history = calloc(1, sizeof(neu_driver_history_t));
+
+    if (history == NULL) {
+        return NULL;
+    }
+
+    history->n_block = size / sizeof(block_t);
+    if (history->n_block < 2) {
+        history->n_block = 2;
+    }
+    pthread_mutex_init(&history->mtx, NULL);
+
+    return history;
+}
+
+static void series_free(series_t *series)
+{
+    free(series->blocks);
+    free(series);
+}
+
+void neu_driver_history_destroy(neu_driver_history_t *history)
+{
+    series_t *series = NULL;
+    series_t *tmp    = NULL;
+
+    pthread_mutex_lock(&history->mtx);
+    HASH_ITER(hh, history->table, series, tmp)
+    {
+        HASH_DEL(history->table, series);
+        series_free(series);
+    }
+    pthread_mutex_unlock(&history->mtx);
+
+    pthread_mutex_destroy(&history->mtx);
+    free(history);
+}
+
+void neu_driver_history_add(neu_driver_history_t *history, const char *group,
+                            const char *tag, int64_t timestamp,
+                            const neu_dvalue_t *value)
+{
+    series_t *   series = NULL;
+    block_t *    block  = NULL;
+    skey_t       key    = { 0 };
+    value_kind_e kind   = KIND_INT;
+    uint64_t     bits   = 0;
+    double       d      = 0;
+
+    if (to_bits(value, &kind, &bits, &d) != 0) {
+        return;
+    }
+
+    strcpy(key.group, group);
+    strcpy(key.tag, tag);
+
+    pthread_mutex_lock(&history->mtx);
+    HASH_FIND(hh, history->table, &key, sizeof(skey_t), series);
+    if (series == NULL) {
+        series = calloc(1, sizeof(series_t));
+        if (series != NULL) {
+            series->blocks = calloc(history->n_block, sizeof(block_t));
+        }
+        if (series == NULL || series->blocks == NULL) {
+            pthread_mutex_unlock(&history->mtx);
+            free(series);
+            return;
+        }
+        series->key = key;
+        HASH_ADD(hh, history->table, key, sizeof(skey_t), series);
+    }
+
+    block = series_block(history, series, kind, timestamp);
+
+    block->ts_len += put_varint(block->ts + block->ts_len,
+                                zigzag(timestamp - block->last_ts));
+    if (kind == KIND_INT || kind == KIND_UINT) {
+        block->val_len +=
+            put_varint(block->val + block->val_len,
+                       zigzag((int64_t)(bits - block->last_bits)));
+    } else {
+        block->val_len +=
+            put_varint(block->val + block->val_len, bits ^ block->last_bits);
+    }
+
+    if (block->n_point == 0 || d < block->min) {
+        block->min = d;
+    }
+    if (block->n_point == 0 || d > block->max) {
+        block->max = d;
+    }
+    block->sum += d;
+    block->n_point += 1;
+    block->last_ts   = timestamp;
+    block->last_bits = bits;
+
+    pthread_mutex_unlock(&history->mtx);
+}
+
+void neu_driver_history_del(neu_driver_history_t *history, const char *group,
+                            const char *tag)
+{
+    series_t *series = NULL;
+    skey_t    key    = { 0 };
+
+    strcpy(key.group, group);
+    strcpy(key.tag, tag);
+
+    pthread_mutex_lock(&history->mtx);
+    HASH_FIND(hh, history->table, &key, sizeof(skey_t), series);
+    if (series != NULL) {
+        HASH_DEL(history->table, series);
+        series_free(series);
+    }
+    pthread_mutex_unlock(&history->mtx);
+}
+
+void neu_driver_history_del_group(neu_driver_history_t *history,
+                                  const char *          group)
+{
+    series_t *series = NULL;
+    series_t *tmp    = NULL;
+
+    pthread_mutex_lock(&history->mtx);
+    HASH_ITER(hh, history->table, series, tmp)
+    {
+        if (strcmp(series->key.group, group) == 0) {
+            HASH_DEL(history->table, series);
+            series_free(series);
+        }
+    }
+    pthread_mutex_unlock(&history->mtx);
+}
+
+void neu_driver_history_rename_group(neu_driver_history_t *history,
+                                     const char *group, const char *new_name)
+{
+    series_t *series = NULL;
+    series_t *tmp    = NULL;
+    series_t *moved  = NULL;
+    series_t *old    = NULL;
+
+    pthread_mutex_lock(&history->mtx);
+    HASH_ITER(hh, history->table, series, tmp)
+    {
+        if (strcmp(series->key.group, group) == 0) {
+            HASH_DEL(history->table, series);
+            HASH_ADD(hh, moved, key, sizeof(skey_t), series);
+        }
+    }
+    HASH_ITER(hh, moved, series, tmp)
+    {
+        HASH_DEL(moved, series);
+        memset(series->key.group, 0, sizeof(series->key.group));
+        strcpy(series->key.group, new_name);
+
+        HASH_FIND(hh, history->table, &series->key, sizeof(skey_t), old);
+        if (old != NULL) {
+            HASH_DEL(history->table, old);
+            series_free(old);
+        }
+        HASH_ADD(hh, history->table, key, sizeof(skey_t), series);
+    }
+    pthread_mutex_unlock(&history->mtx);
+}
+
+// index of the bucket holding `offset` in [0, span), computed in floating
+// point as `offset * buckets` may not fit in 64 bits
+static inline uint32_t bucket_index(int64_t offset, int64_t span,
+                                    uint32_t buckets)
+{
+    uint32_t i = (uint32_t)((double) offset / (double) span * buckets);
+
+    return i < buckets ? i : buckets - 1;
+}
+
+static inline void bucket_merge(neu_history_point_t *bucket, double min,
+                                double max, double sum, uint32_t count)
+{
+    if (bucket->count == 0 || min < bucket->min) {
+        bucket->min = min;
+    }
+    if (bucket->count == 0 || max > bucket->max) {
+        bucket->max = max;
+    }
+    bucket->value += sum;
+    bucket->count += count;
+}
+
+int neu_driver_history_query(neu_driver_history_t *history, const char *group,
+                             const char *tag, int64_t start, int64_t end,
+                             uint32_t buckets, UT_array *points)
+{
+    series_t *           series = NULL;
+    skey_t               key    = { 0 };
+    neu_history_point_t *bucket = NULL;
+    int64_t              span   = end - start + 1;
+
+    if (span <= 0 || buckets > QUERY_MAX_BUCKETS) {
+        return NEU_ERR_PARAM_IS_WRONG;
+    }
+
+    strcpy(key.group, group);
+    strcpy(key.tag, tag);
+
+    if (buckets > 0) {
+        bucket = calloc(buckets, sizeof(neu_history_point_t));
+        if (bucket == NULL) {
+            return NEU_ERR_EINTERNAL;
+        }
+    }
+
+    pthread_mutex_lock(&history->mtx);
+    HASH_FIND(hh, history->table, &key, sizeof(skey_t), series);
+    if (series == NULL) {
+        // no numeric value recorded yet
+        pthread_mutex_unlock(&history->mtx);
+        free(bucket);
+        return 0;
+    }
+
+    for (uint32_t i = 0; i < series->count; i++) {
+        const block_t *block =
+            &series->blocks[(series->head + i) % history->n_block];
+        int64_t  ts     = block->first_ts;
+        uint64_t bits   = 0;
+        uint16_t ts_off = 0;
+        uint16_t v_off  = 0;
+
+        if (block->last_ts < start || block->first_ts > end) {
+            continue;
+        }
+
+        // whole block inside one bucket, use its summary
+        if (buckets > 0 && block->first_ts >= start && block->last_ts <= end &&
+            bucket_index(block->first_ts - start, span, buckets) ==
+                bucket_index(block->last_ts - start, span, buckets)) {
+            bucket_merge(
+                &bucket[bucket_index(block->first_ts - start, span, buckets)],
+                block->min, block->max, block->sum, block->n_point);
+            continue;
+        }
+
+        for (uint16_t k = 0; k < block->n_point; k++) {
+            uint64_t delta = 0;
+            double   d     = 0;
+
+            ts_off += get_varint(block->ts + ts_off, &delta);
+            ts += unzigzag(delta);
+            v_off += get_varint(block->val + v_off, &delta);
+            if (block->kind == KIND_INT || block->kind == KIND_UINT) {
+                bits += (uint64_t) unzigzag(delta);
+            } else {
+                bits ^= delta;
+            }
+
+            if (ts < start || ts > end) {
+                continue;
+            }
+
+            d = from_bits(block->kind, bits);
+            if (buckets > 0) {
+                bucket_merge(&bucket[bucket_index(ts - start, span, buckets)],
+                             d, d, d, 1);
+            } else {
+                neu_history_point_t p = {
+                    .timestamp = ts,
+                    .value     = d,
+                    .min       = d,
+                    .max       = d,
+                    .count     = 1,
+                };
+                utarray_push_back(points, &p);
+            }
+        }
+    }
+    pthread_mutex_unlock(&history->mtx);
+
+    for (uint32_t i = 0; i < buckets; i++) {
+        if (bucket[i].count > 0) {
+            bucket[i].timestamp =
+                start + (int64_t)((double) span / buckets * i);
+            bucket[i].value /= bucket[i].count;
+            utarray_push_back(points, &bucket[i]);
+        }
+    }
+    free(bucket);
+
+    return 0;
+}
@@ -0,0 +1,64 @@
+/**
+ * NEURON IIoT System for Industry 4.0
+ * Copyright (C) 2020-2024 EMQ Technologies Co., Ltd All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ **/
+
+#ifndef _NEU_DRIVER_HISTORY_H_
+#define _NEU_DRIVER_HISTORY_H_
+
+#include <stdint.h>
+
+#include "msg.h"
+#include "type.h"
+
+/**
+ * Fixed-memory, per tag time series of recent numeric values.
+ *
+ * Each tag owns a ring of blocks. A block stores its timestamps and values
+ * in two separate columns, delta encoded as varints, so slowly changing
+ * values take a couple of bytes per point. When the ring is full the oldest
+ * block is dropped.
+ */
+typedef struct neu_driver_history neu_driver_history_t;
+
+// `size` is the memory budget per tag in bytes
+neu_driver_history_t *neu_driver_history_new(size_t size);
+void neu_driver_history_destroy(neu_driver_history_t *history);
+
+// non numeric values are ignored
+void neu_driver_history_add(neu_driver_history_t *history, const char *group,
+                            const char *tag, int64_t timestamp,
+                            const neu_dvalue_t *value);
+void neu_driver_history_del(neu_driver_history_t *history, const char *group,
+                            const char *tag);
+void neu_driver_history_del_group(neu_driver_history_t *history,
+                                  const char *          group);
+// keep the series of `group` under its new name
+void neu_driver_history_rename_group(neu_driver_history_t *history,
+                                     const char *group, const char *new_name);
+
+/**
+ * Append the points of `tag` within [start, end] to `points`
+ * (neu_history_point_t). If `buckets` is not 0, the range is split into
+ * `buckets` equal intervals and one min/max/avg point is produced for every
+ * non empty interval.
+ */
+int neu_driver_history_query(neu_driver_history_t *history, const char *group,
+                             const char *tag, int64_t start, int64_t end,
+                             uint32_t buckets, UT_array *points);
+
+#endif
@@ -0,0 +1,190 @@
+/**
+ * NEURON IIoT System for Industry 4.0
+ * Copyright (C) 2020-2024 EMQ Technologies Co., Ltd All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ **/
+
+#include <pthread.h>
+#include <stdlib.h>
+
+#include "utils/utlist.h"
+
+#include "schedule.h"
+
+struct neu_read_slot {
+    int64_t interval;
+    int64_t phase;
+    int64_t release; // of the current cycle
+    int     catchup; // back to back cycles so far
+
+    neu_read_sched_stats_t stats;
+
+    struct neu_read_slot *prev;
+    struct neu_read_slot *next;
+};
+
+struct neu_read_sched {
+    neu_read_overrun_e policy;
+    neu_read_slot_t *  slots;
+    pthread_mutex_t    mtx;
+};
+
+// first release at or after `t`
+static inline int64_t release_from(const neu_read_slot_t *slot, int64_t t)
+{
+    int64_t r = (t - slot->phase) % slot->interval;
+
+    if (r < 0) {
+        r += slot->interval;
+    }
+    return r == 0 ? t : t - r + slot->interval;
+}
+
+// spread the phases of all slots of `interval` evenly, in order of addition
+static void rebalance(neu_read_sched_t *sched, int64_t interval)
+{
+    neu_read_slot_t *el = NULL;
+    int64_t          n = 0, k = 0;
+
+    DL_FOREACH(sched->slots, el)
+    {
+        n += el->interval == interval;
+    }
+    DL_FOREACH(sched->slots, el)
+    {
+        if (el->interval == interval) {
+            el->phase = k++ * interval / n;
+        }
+    }
+}
+
+neu_read_sched_t *neu_read_sched_new(neu_read_overrun_e policy)
+{
+    neu_read_sched_t *sched = calloc(1, sizeof(neu_read_sched_t));
+
+    sched->policy = policy;
+    pthread_mutex_init(&sched->mtx, NULL);
+    return sched;
+}
+
+void neu_read_sched_free(neu_read_sched_t *sched)
+{
+    neu_read_slot_t *el = NULL, *tmp = NULL;
+
+    DL_FOREACH_SAFE(sched->slots, el, tmp)
+    {
+        DL_DELETE(sched->slots, el);
+        free(el);
+    }
+    pthread_mutex_destroy(&sched->mtx);
+    free(sched);
+}
+
+neu_read_slot_t *neu_read_sched_add(neu_read_sched_t *sched, uint32_t interval,
+                                    int64_t now, int64_t *delay)
+{
+    neu_read_slot_t *slot = calloc(1, sizeof(neu_read_slot_t));
+
+    slot->interval = interval > 0 ? interval : 1;
+
+    pthread_mutex_lock(&sched->mtx);
+    DL_APPEND(sched->slots, slot);
+    rebalance(sched, slot->interval);
+    slot->release = release_from(slot, now + 1);
+    pthread_mutex_unlock(&sched->mtx);
+
+    *delay = slot->release - now;
+    return slot;
+}
+
+void neu_read_sched_del(neu_read_sched_t *sched, neu_read_slot_t *slot)
+{
+    pthread_mutex_lock(&sched->mtx);
+    DL_DELETE(sched->slots, slot);
+    rebalance(sched, slot->interval);
+    pthread_mutex_unlock(&sched->mtx);
+
+    free(slot);
+}
+
+int64_t neu_read_sched_done(neu_read_sched_t *sched, neu_read_slot_t *slot,
+                            int64_t start, int64_t end,
+                            neu_read_sched_stats_t *delta)
+{
+    neu_read_sched_stats_t d        = { 0 };
+    int64_t                deadline = 0;
+    int64_t                next     = 0;
+
+    pthread_mutex_lock(&sched->mtx);
+    deadline   = slot->release + slot->interval;
+    d.cycles   = 1;
+    d.lateness = start - slot->release;
+
+    if (end <= deadline) {
+        // after a rephase the new release may come early, keep at least half
+        // an interval between two releases
+        int64_t from = slot->release + (slot->interval + 1) / 2;
+
+        slot->catchup = 0;
+        next          = release_from(slot, end > from ? end : from);
+    } else {
+        d.misses     = 1;
+        d.overrun_ms = end - deadline;
+
+        if (sched->policy == NEU_READ_OVERRUN_STRETCH) {
+            next = end;
+        } else if (sched->policy == NEU_READ_OVERRUN_CATCHUP &&
+                   slot->catchup < NEU_READ_SCHED_CATCHUP_MAX) {
+            slot->catchup += 1;
+            next = deadline;
+        } else {
+            slot->catchup = 0;
+            next          = release_from(slot, end);
+            d.skipped     = (next - deadline) / slot->interval;
+        }
+    }
+    slot->release = next;
+
+    slot->stats.cycles += d.cycles;
+    slot->stats.misses += d.misses;
+    slot->stats.skipped += d.skipped;
+    slot->stats.overrun_ms += d.overrun_ms;
+    slot->stats.lateness = d.lateness;
+    pthread_mutex_unlock(&sched->mtx);
+
+    if (delta != NULL) {
+        *delta = d;
+    }
+    return next > end ? next - end : 1;
+}
+
+void neu_read_sched_stats(neu_read_sched_t *sched, neu_read_slot_t *slot,
+                          neu_read_sched_stats_t *stats)
+{
+    pthread_mutex_lock(&sched->mtx);
+    *stats = slot->stats;
+    pthread_mutex_unlock(&sched->mtx);
+}
+
+int64_t neu_read_sched_phase(neu_read_sched_t *sched, neu_read_slot_t *slot)
+{
+    int64_t phase = 0;
+
+    pthread_mutex_lock(&sched->mtx);
+    phase = slot->phase;
+    pthread_mutex_unlock(&sched->mtx);
+    return phase;
+}
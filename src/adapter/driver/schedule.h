@@ -0,0 +1,95 @@
+/**
+ * NEURON IIoT System for Industry 4.0
+ * Copyright (C) 2020-2024 EMQ Technologies Co., Ltd All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ **/
+
+#ifndef _NEU_DRIVER_SCHEDULE_H_
+#define _NEU_DRIVER_SCHEDULE_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+
+// back to back cycles the catch-up policy runs before it skips
+#define NEU_READ_SCHED_CATCHUP_MAX 3
+
+// what to do when a read cycle ends past the next release of its group
+typedef enum {
+    // drop the missed releases, wait for the next one in phase
+    NEU_READ_OVERRUN_SKIP = 0,
+    // run the missed releases back to back, up to NEU_READ_SCHED_CATCHUP_MAX
+    NEU_READ_OVERRUN_CATCHUP,
+    // start the next cycle right away, the group drifts back to its phase
+    NEU_READ_OVERRUN_STRETCH,
+} neu_read_overrun_e;
+
+typedef struct {
+    uint64_t cycles;
+    uint64_t misses;     // cycles that ended past their deadline
+    uint64_t skipped;    // releases dropped without a cycle
+    uint64_t overrun_ms; // total time past the deadlines
+    int64_t  lateness;   // start of the last cycle minus its release
+} neu_read_sched_stats_t;
+
+/**
+ * Read scheduler of the groups of one node.
+ *
+ * Groups of the same interval are given evenly spread phases, the releases of
+ * a group are the times t with t % interval == phase, on a monotonic
+ * millisecond clock. The phases are spread again whenever a group comes or
+ * goes, a running group moves to its new phase on its next release at least
+ * half an interval away. The deadline of a cycle is the next release.
+ *
+ * Thread safe.
+ */
+typedef struct neu_read_sched neu_read_sched_t;
+typedef struct neu_read_slot  neu_read_slot_t;
+
+neu_read_sched_t *neu_read_sched_new(neu_read_overrun_e policy);
+void              neu_read_sched_free(neu_read_sched_t *sched);
+
+// `delay` is set to the milliseconds from `now` to the first release
+neu_read_slot_t *neu_read_sched_add(neu_read_sched_t *sched, uint32_t interval,
+                                    int64_t now, int64_t *delay);
+void             neu_read_sched_del(neu_read_sched_t *sched,
+                                    neu_read_slot_t * slot);
+
+/**
+ * Account the cycle of `slot` that ran from `start` to `end` and pick the
+ * next release according to the overrun policy.
+ *
+ * @param[out] delta What this cycle added to the stats of the slot, may be
+ *                   NULL.
+ * @return Milliseconds from `end` to the next release, at least 1.
+ */
+int64_t neu_read_sched_done(neu_read_sched_t *sched, neu_read_slot_t *slot,
+                            int64_t start, int64_t end,
+                            neu_read_sched_stats_t *delta);
+
+void neu_read_sched_stats(neu_read_sched_t *sched, neu_read_slot_t *slot,
+                          neu_read_sched_stats_t *stats);
+
+// current phase of `slot`, changes when groups of its interval come or go
+int64_t neu_read_sched_phase(neu_read_sched_t *sched, neu_read_slot_t *slot);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
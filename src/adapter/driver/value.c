@@ -0,0 +1,447 @@
+/**
+ * NEURON IIoT System for Industry 4.0
+ * Copyright (C) 2020-2024 EMQ Technologies Co., Ltd All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ **/
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "errcodes.h"
+
+#include "value.h"
+
+#define SLAB_PAGE_SIZE (16 * 1024)
+#define SLAB_PAGE_HEADER 16
+#define SLAB_MIN_CHUNK 16
+#define SLAB_N_CLASS 7 // 16 to 1024 bytes
+#define SLAB_MAX_CHUNK (SLAB_MIN_CHUNK << (SLAB_N_CLASS - 1))
+
+struct slab_page {
+    struct slab_page *next;
+};
+
+struct neu_value_slab {
+    void *            free[SLAB_N_CLASS]; // chunks linked through their head
+    struct slab_page *pages;
+    size_t            n_page;
+    uint8_t *         cursor; // unused end of the last page
+    size_t            left;
+    size_t            heap;
+};
+
+static inline int slab_class(size_t size)
+{
+    int cls = 0;
+
+    while (((size_t) SLAB_MIN_CHUNK << cls) < size) {
+        cls++;
+    }
+    return cls;
+}
+
+static inline void slab_push(neu_value_slab_t *slab, int cls, void *chunk)
+{
+    *(void **) chunk = slab->free[cls];
+    slab->free[cls]  = chunk;
+}
+
+static void *slab_alloc(neu_value_slab_t *slab, size_t size)
+{
+    int    cls   = 0;
+    size_t chunk = 0;
+    void * p     = NULL;
+
+    if (size > SLAB_MAX_CHUNK) {
+        p = malloc(size);
+        if (p != NULL) {
+            slab->heap += size;
+        }
+        return p;
+    }
+
+    cls   = slab_class(size);
+    chunk = (size_t) SLAB_MIN_CHUNK << cls;
+    if (slab->free[cls] != NULL) {
+        p               = slab->free[cls];
+        slab->free[cls] = *(void **) p;
+        return p;
+    }
+
+    if (slab->left < chunk) {
+        struct slab_page *page = malloc(SLAB_PAGE_SIZE);
+
+        if (page == NULL) {
+            return NULL;
+        }
+
+        // hand the tail of the current page to the smaller classes
+        while (slab->left >= SLAB_MIN_CHUNK) {
+            int    c = slab_class(slab->left + 1) - 1;
+            size_t n = (size_t) SLAB_MIN_CHUNK << c;
+
+            slab_push(slab, c, slab->cursor);
+            slab->cursor += n;
+            slab->left -= n;
+        }
+
+        page->next   = slab->pages;
+        slab->pages  = page;
+        slab->cursor = (uint8_t *) page + SLAB_PAGE_HEADER;
+        slab->left   = SLAB_PAGE_SIZE - SLAB_PAGE_HEADER;
+        slab->n_page += 1;
+    }
+
+    p = slab->cursor;
+    slab->cursor += chunk;
+    slab->left -= chunk;
+    return p;
+}
+
+static void slab_put(neu_value_slab_t *slab, void *p, size_t size)
+{
+    if (p == NULL) {
+        return;
+    }
+    if (size > SLAB_MAX_CHUNK) {
+        slab->heap -= size;
+        free(p);
+        return;
+    }
+    slab_push(slab, slab_class(size), p);
+}
+
+neu_value_slab_t *neu_value_slab_new()
+{
+    return calloc(1, sizeof(neu_value_slab_t));
+}
+
+void neu_value_slab_free(neu_value_slab_t *slab)
+{
+    struct slab_page *page = slab->pages;
+
+    while (page != NULL) {
+        struct slab_page *next = page->next;
+
+        free(page);
+        page = next;
+    }
+    free(slab);
+}
+
+size_t neu_value_slab_size(const neu_value_slab_t *slab)
+{
+    return slab->n_page * SLAB_PAGE_SIZE + slab->heap;
+}
+
+static size_t scalar_size(neu_type_e type)
+{
+    switch (type) {
+    case NEU_TYPE_INT8:
+    case NEU_TYPE_UINT8:
+    case NEU_TYPE_BIT:
+    case NEU_TYPE_BOOL:
+        return 1;
+    case NEU_TYPE_INT16:
+    case NEU_TYPE_UINT16:
+    case NEU_TYPE_WORD:
+        return 2;
+    case NEU_TYPE_INT32:
+    case NEU_TYPE_UINT32:
+    case NEU_TYPE_DWORD:
+    case NEU_TYPE_FLOAT:
+    case NEU_TYPE_ERROR:
+        return 4;
+    case NEU_TYPE_INT64:
+    case NEU_TYPE_UINT64:
+    case NEU_TYPE_DOUBLE:
+    case NEU_TYPE_LWORD:
+        return 8;
+    default:
+        return 0;
+    }
+}
+
+static inline bool is_string(neu_type_e type)
+{
+    return type == NEU_TYPE_STRING || type == NEU_TYPE_TIME ||
+        type == NEU_TYPE_DATA_AND_TIME || type == NEU_TYPE_ARRAY_CHAR;
+}
+
+size_t neu_value_array_elem_size(neu_type_e type)
+{
+    switch (type) {
+    case NEU_TYPE_BYTES:
+    case NEU_TYPE_ARRAY_BOOL:
+    case NEU_TYPE_ARRAY_INT8:
+    case NEU_TYPE_ARRAY_UINT8:
+        return 1;
+    case NEU_TYPE_ARRAY_INT16:
+    case NEU_TYPE_ARRAY_UINT16:
+        return sizeof(uint16_t);
+    case NEU_TYPE_ARRAY_INT32:
+    case NEU_TYPE_ARRAY_UINT32:
+    case NEU_TYPE_ARRAY_FLOAT:
+        return sizeof(uint32_t);
+    case NEU_TYPE_ARRAY_INT64:
+    case NEU_TYPE_ARRAY_UINT64:
+    case NEU_TYPE_ARRAY_DOUBLE:
+        return sizeof(uint64_t);
+    default:
+        return 0;
+    }
+}
+
+// bytes of the out-of-line payload
+static size_t payload_size(const neu_cvalue_t *cv)
+{
+    if (is_string(cv->type)) {
+        return cv->length + 1;
+    } else if (cv->type == NEU_TYPE_ARRAY_STRING) {
+        return cv->length * sizeof(char *);
+    } else if (cv->type == NEU_TYPE_PTR) {
+        return cv->length;
+    }
+    return cv->length * neu_value_array_elem_size(cv->type);
+}
+
+static inline bool has_payload(neu_type_e type)
+{
+    return is_string(type) || neu_value_array_elem_size(type) > 0 ||
+        type == NEU_TYPE_ARRAY_STRING || type == NEU_TYPE_PTR;
+}
+
+void neu_cvalue_release(neu_value_slab_t *slab, neu_cvalue_t *cv)
+{
+    if (cv->type == NEU_TYPE_ARRAY_STRING) {
+        char **strs = cv->v.data;
+
+        for (int i = 0; i < cv->length; i++) {
+            free(strs[i]);
+        }
+    } else if (cv->type == NEU_TYPE_CUSTOM) {
+        json_decref(cv->v.json);
+    }
+
+    if (has_payload(cv->type)) {
+        slab_put(slab, cv->v.data, payload_size(cv));
+    }
+    memset(cv, 0, sizeof(*cv));
+}
+
+// the payload could not be allocated, keep an error in place of the value
+static inline void set_oom(neu_cvalue_t *cv)
+{
+    memset(cv, 0, sizeof(*cv));
+    cv->type  = NEU_TYPE_ERROR;
+    cv->v.i32 = NEU_ERR_EINTERNAL;
+}
+
+void neu_cvalue_set(neu_value_slab_t *slab, neu_cvalue_t *cv,
+                    const neu_dvalue_t *value)
+{
+    const uint8_t *raw   = (const uint8_t *) &value->value;
+    size_t         size  = scalar_size(value->type);
+    size_t         esize = neu_value_array_elem_size(value->type);
+
+    neu_cvalue_release(slab, cv);
+    cv->type = value->type;
+
+    if (size > 0) {
+        memcpy(&cv->v, raw, size);
+    } else if (is_string(value->type)) {
+        cv->length = strnlen(value->value.str, NEU_VALUE_SIZE - 1);
+        cv->v.data = slab_alloc(slab, cv->length + 1);
+        if (cv->v.data == NULL) {
+            set_oom(cv);
+            return;
+        }
+        memcpy(cv->v.data, value->value.str, cv->length);
+        ((char *) cv->v.data)[cv->length] = '\0';
+    } else if (esize > 0) {
+        cv->length = raw[NEU_VALUE_SIZE * esize];
+        if (cv->length > 0) {
+            cv->v.data = slab_alloc(slab, cv->length * esize);
+            if (cv->v.data == NULL) {
+                set_oom(cv);
+                return;
+            }
+            memcpy(cv->v.data, raw, cv->length * esize);
+        }
+    } else if (value->type == NEU_TYPE_ARRAY_STRING) {
+        cv->length = value->value.strs.length;
+        if (cv->length > 0) {
+            cv->v.data = slab_alloc(slab, cv->length * sizeof(char *));
+            if (cv->v.data == NULL) {
+                for (int i = 0; i < cv->length; i++) {
+                    free(value->value.strs.strs[i]);
+                }
+                set_oom(cv);
+                return;
+            }
+            memcpy(cv->v.data, value->value.strs.strs,
+                   cv->length * sizeof(char *));
+        }
+    } else if (value->type == NEU_TYPE_PTR) {
+        cv->length   = value->value.ptr.length;
+        cv->ptr_type = value->value.ptr.type;
+        if (cv->length > 0) {
+            cv->v.data = slab_alloc(slab, cv->length);
+            if (cv->v.data == NULL) {
+                set_oom(cv);
+                return;
+            }
+            memcpy(cv->v.data, value->value.ptr.ptr, cv->length);
+        }
+    } else if (value->type == NEU_TYPE_CUSTOM) {
+        cv->v.json = value->value.json;
+    } else {
+        memcpy(&cv->v, raw, sizeof(cv->v));
+    }
+}
+
+void neu_cvalue_copy(neu_value_slab_t *slab, neu_cvalue_t *dst,
+                     const neu_cvalue_t *src)
+{
+    *dst = *src;
+
+    if (has_payload(src->type) && src->v.data != NULL) {
+        dst->v.data = slab_alloc(slab, payload_size(src));
+        if (dst->v.data == NULL) {
+            set_oom(dst);
+            return;
+        }
+        memcpy(dst->v.data, src->v.data, payload_size(src));
+    }
+
+    if (src->type == NEU_TYPE_ARRAY_STRING) {
+        char **strs = dst->v.data;
+
+        for (int i = 0; i < dst->length; i++) {
+            strs[i] = strdup(strs[i]);
+        }
+    } else if (src->type == NEU_TYPE_CUSTOM) {
+        json_incref(dst->v.json);
+    }
+}
+
+void neu_cvalue_get(const neu_cvalue_t *cv, neu_dvalue_t *value)
+{
+    uint8_t *raw   = (uint8_t *) &value->value;
+    size_t   esize = neu_value_array_elem_size(cv->type);
+
+    value->type = cv->type;
+
+    if (is_string(cv->type)) {
+        memcpy(value->value.str, cv->v.data, cv->length + 1);
+    } else if (esize > 0) {
+        if (cv->length > 0) {
+            memcpy(raw, cv->v.data, cv->length * esize);
+        }
+        raw[NEU_VALUE_SIZE * esize] = cv->length;
+    } else if (cv->type == NEU_TYPE_ARRAY_STRING) {
+        char **strs = cv->v.data;
+
+        value->value.strs.length = cv->length;
+        for (int i = 0; i < cv->length; i++) {
+            value->value.strs.strs[i] = strdup(strs[i]);
+        }
+    } else if (cv->type == NEU_TYPE_PTR) {
+        value->value.ptr.length = cv->length;
+        value->value.ptr.type   = cv->ptr_type;
+        value->value.ptr.ptr    = calloc(1, cv->length);
+        if (cv->length > 0) {
+            memcpy(value->value.ptr.ptr, cv->v.data, cv->length);
+        }
+    } else if (cv->type == NEU_TYPE_CUSTOM) {
+        value->value.json = json_deep_copy(cv->v.json);
+    } else {
+        memcpy(raw, &cv->v, sizeof(cv->v));
+    }
+}
+
+bool neu_cvalue_equal(const neu_cvalue_t *cv, const neu_dvalue_t *value,
+                      uint8_t precision)
+{
+    const uint8_t *raw   = (const uint8_t *) &value->value;
+    size_t         esize = neu_value_array_elem_size(value->type);
+
+    if (cv->type != value->type) {
+        return false;
+    }
+
+    switch (value->type) {
+    case NEU_TYPE_ERROR:
+        return false;
+    case NEU_TYPE_FLOAT:
+        if (precision == 0) {
+            return cv->v.f32 == value->value.f32;
+        }
+        return fabs(cv->v.f32 - value->value.f32) <= pow(0.1, precision);
+    case NEU_TYPE_DOUBLE:
+        if (precision == 0) {
+            return cv->v.d64 == value->value.d64;
+        }
+        return fabs(cv->v.d64 - value->value.d64) <= pow(0.1, precision);
+    case NEU_TYPE_ARRAY_STRING: {
+        char **strs = cv->v.data;
+
+        if (cv->length != value->value.strs.length) {
+            return false;
+        }
+        for (int i = 0; i < cv->length; i++) {
+            if (strcmp(strs[i], value->value.strs.strs[i]) != 0) {
+                return false;
+            }
+        }
+        return true;
+    }
+    case NEU_TYPE_PTR:
+        return cv->length == value->value.ptr.length &&
+            (cv->length == 0 ||
+             memcmp(cv->v.data, value->value.ptr.ptr, cv->length) == 0);
+    case NEU_TYPE_CUSTOM:
+        return json_equal(cv->v.json, value->value.json) == 1;
+    default:
+        break;
+    }
+
+    if (is_string(value->type)) {
+        return strncmp(cv->v.data, value->value.str, NEU_VALUE_SIZE) == 0;
+    } else if (esize > 0) {
+        return cv->length == raw[NEU_VALUE_SIZE * esize] &&
+            (cv->length == 0 ||
+             memcmp(cv->v.data, raw, cv->length * esize) == 0);
+    }
+    return memcmp(&cv->v, raw, scalar_size(value->type)) == 0;
+}
+
+const void *neu_cvalue_data(const neu_cvalue_t *cv, size_t *len)
+{
+    if (is_string(cv->type)) {
+        *len = cv->length;
+        return cv->v.data;
+    } else if (neu_value_array_elem_size(cv->type) > 0) {
+        // empty arrays have no payload, any pointer will do
+        *len = cv->length * neu_value_array_elem_size(cv->type);
+        return cv->length > 0 ? cv->v.data : (const void *) cv;
+    } else if (scalar_size(cv->type) > 0 && cv->type != NEU_TYPE_ERROR) {
+        *len = sizeof(cv->v);
+        return &cv->v;
+    }
+    return NULL;
+}
@@ -0,0 +1,108 @@
+/**
+ * NEURON IIoT System for Industry 4.0
+ * Copyright (C) 2020-2024 EMQ Technologies Co., Ltd All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ **/
+
+#ifndef _NEU_DRIVER_VALUE_H_
+#define _NEU_DRIVER_VALUE_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "type.h"
+
+/**
+ * Out-of-line storage of compact values.
+ *
+ * Payloads are carved from 16 KB pages in power of two size classes from 16
+ * to 1024 bytes, which covers every string and array of neu_value_u. Larger
+ * payloads, only NEU_TYPE_PTR, go to the heap. Freed chunks are kept for
+ * reuse by the same class until the slab is freed.
+ *
+ * Not thread safe, the owner serializes access.
+ */
+typedef struct neu_value_slab neu_value_slab_t;
+
+neu_value_slab_t *neu_value_slab_new();
+void              neu_value_slab_free(neu_value_slab_t *slab);
+// bytes of pages and heap payloads held by the slab
+size_t neu_value_slab_size(const neu_value_slab_t *slab);
+
+/**
+ * Compact neu_dvalue_t, 16 bytes.
+ *
+ * Scalars and errors live in `v`, laid out as the leading bytes of
+ * neu_value_u. Strings, bytes and arrays live in the slab with `length` in
+ * bytes for strings, bytes and pointers, in elements for arrays. The strings
+ * of NEU_TYPE_ARRAY_STRING and the json of NEU_TYPE_CUSTOM are owned by the
+ * compact value. The precision is left to the owner.
+ */
+typedef struct {
+    uint8_t  type;     // neu_type_e
+    uint8_t  ptr_type; // neu_value_ptr_t type of NEU_TYPE_PTR
+    uint16_t length;
+    union {
+        bool     boolean;
+        int8_t   i8;
+        uint8_t  u8;
+        int16_t  i16;
+        uint16_t u16;
+        int32_t  i32;
+        uint32_t u32;
+        int64_t  i64;
+        uint64_t u64;
+        float    f32;
+        double   d64;
+        void *   data;
+        json_t * json;
+    } v;
+} neu_cvalue_t;
+
+// release what `cv` holds and store `value`, taking over its array strings
+// and json the same way the driver cache always did, a payload that cannot
+// be allocated leaves an error of NEU_ERR_EINTERNAL in `cv`
+void neu_cvalue_set(neu_value_slab_t *slab, neu_cvalue_t *cv,
+                    const neu_dvalue_t *value);
+// deep copy of `src` into an empty `dst`, an error as with neu_cvalue_set
+void neu_cvalue_copy(neu_value_slab_t *slab, neu_cvalue_t *dst,
+                     const neu_cvalue_t *src);
+void neu_cvalue_release(neu_value_slab_t *slab, neu_cvalue_t *cv);
+
+// deep copy of `cv` into `value`, all but the precision
+void neu_cvalue_get(const neu_cvalue_t *cv, neu_dvalue_t *value);
+
+// whether `value` is the same as `cv`, floats within `precision` digits
+bool neu_cvalue_equal(const neu_cvalue_t *cv, const neu_dvalue_t *value,
+                      uint8_t precision);
+
+// element size of the numeric arrays and bytes, 0 for other types, every
+// array struct of neu_value_u is `T elems[NEU_VALUE_SIZE]; uint8_t length;`
+size_t neu_value_array_elem_size(neu_type_e type);
+
+// payload of strings, bytes and numeric arrays, the scalar bytes otherwise
+const void *neu_cvalue_data(const neu_cvalue_t *cv, size_t *len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
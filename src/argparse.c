@@ -30,6 +30,7 @@
 
 #include <zlog.h>
 
+#include "adapter/driver/schedule.h"
 #include "argparse.h"
 #include "persist/persist.h"
 #include "utils/log.h"
@@ -81,6 +82,11 @@ const char *usage_text =
 "    --syslog_host <HOST> syslog server host to which neuron will send logs\n"
 "    --syslog_port <PORT> syslog server port (default 541 if not provided)\n"
 "    --sub_filter_error The subscribe attribute only detects the last read value and does not report any error tags\n"
+"    --tag_history <BYTES> keep up to BYTES of recent values per tag in memory (default 0, disabled)\n"
+"    --read_overrun <POLICY> what to do when a group read outlasts its interval,\n"
+"                           - skip,     drop the missed reads (default)\n"
+"                           - catch-up, run the missed reads back to back\n"
+"                           - stretch,  read again right away\n"
 "\n";
 // clang-format on
 
@@ -135,6 +141,21 @@ static inline size_t parse_restart_policy(const char *s, size_t *out)
     return 0;
 }
 
+static inline int parse_read_overrun(const char *s, int *out)
+{
+    if (0 == strcmp(s, "skip")) {
+        *out = NEU_READ_OVERRUN_SKIP;
+    } else if (0 == strcmp(s, "catch-up")) {
+        *out = NEU_READ_OVERRUN_CATCHUP;
+    } else if (0 == strcmp(s, "stretch")) {
+        *out = NEU_READ_OVERRUN_STRETCH;
+    } else {
+        return -1;
+    }
+
+    return 0;
+}
+
 static inline bool file_exists(const char *const path)
 {
     struct stat buf = { 0 };
@@ -195,6 +216,26 @@ static inline int load_env(neu_cli_args_t *args, char **log_level_out,
             }
         }
 
+        char *tag_history = getenv(NEU_ENV_TAG_HISTORY);
+        if (tag_history != NULL) {
+            char *    end = NULL;
+            uintmax_t n   = strtoumax(tag_history, &end, 0);
+            if ('\0' == *tag_history || '\0' != *end) {
+                printf("neuron %s setting invalid!\n", NEU_ENV_TAG_HISTORY);
+                ret = -1;
+                break;
+            }
+            args->tag_history = n;
+        }
+
+        char *read_overrun = getenv(NEU_ENV_READ_OVERRUN);
+        if (read_overrun != NULL &&
+            parse_read_overrun(read_overrun, &args->read_overrun) != 0) {
+            printf("neuron %s setting invalid!\n", NEU_ENV_READ_OVERRUN);
+            ret = -1;
+            break;
+        }
+
         char *log_level = getenv(NEU_ENV_LOG_LEVEL);
         if (log_level != NULL) {
             if (*log_level_out != NULL) {
@@ -450,6 +491,8 @@ void neu_cli_args_init(neu_cli_args_t *args, int argc, char *argv[])
         { "syslog_host", required_argument, NULL, 'S' },
         { "syslog_port", required_argument, NULL, 'P' },
         { "sub_filter_error", no_argument, NULL, 'f' },
+        { "tag_history", required_argument, NULL, 'H' },
+        { "read_overrun", required_argument, NULL, 'R' },
         { NULL, 0, NULL, 0 },
     };
 
@@ -546,6 +589,27 @@ void neu_cli_args_init(neu_cli_args_t *args, int argc, char *argv[])
         case 'f':
             args->sub_filter_err = true;
             break;
+        case 'H': {
+            char *    end = NULL;
+            uintmax_t n   = strtoumax(optarg, &end, 0);
+            if ('\0' == *optarg || '\0' != *end) {
+                fprintf(stderr, "%s: option '--tag_history' invalid : `%s`\n",
+                        argv[0], optarg);
+                ret = 1;
+                goto quit;
+            }
+            args->tag_history = n;
+            break;
+        }
+        case 'R':
+            if (parse_read_overrun(optarg, &args->read_overrun) != 0) {
+                fprintf(stderr,
+                        "%s: option '--read_overrun' invalid policy: `%s`\n",
+                        argv[0], optarg);
+                ret = 1;
+                goto quit;
+            }
+            break;
         case '?':
         default:
             usage();
@@ -36,6 +36,8 @@
 #define NEU_ENV_SYSLOG_HOST "NEURON_SYSLOG_HOST"
 #define NEU_ENV_SYSLOG_PORT "NEURON_SYSLOG_PORT"
 #define NEU_ENV_SUB_FILTER_ERROR "NEURON_SUB_FILTER_ERROR"
+#define NEU_ENV_TAG_HISTORY "NEURON_TAG_HISTORY"
+#define NEU_ENV_READ_OVERRUN "NEURON_READ_OVERRUN"
 
 #define NEURON_CONFIG_FNAME "./config/neuron.json"
 
@@ -66,6 +68,8 @@ typedef struct {
     char *   syslog_host;
     uint16_t syslog_port;
     bool     sub_filter_err;
+    size_t   tag_history; // bytes of in-memory history per tag, 0 to disable
+    int      read_overrun; // neu_read_overrun_e
 } neu_cli_args_t;
 
 /** Parse command line arguments.
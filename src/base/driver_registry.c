@@ -0,0 +1,131 @@
+/**
+ * NEURON IIoT System for Industry 4.0
+ * Copyright (C) 2020-2022 EMQ Technologies Co., Ltd All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ **/
+
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "define.h"
+#include "driver_registry.h"
+#include "errcodes.h"
+#include "utils/uthash.h"
+
+typedef struct {
+    char                        name[NEU_NODE_NAME_LEN];
+    void *                      ctx;
+    neu_driver_registry_read_fn read;
+
+    UT_hash_handle hh;
+} registry_entry_t;
+
+static pthread_rwlock_t  registry_mtx = PTHREAD_RWLOCK_INITIALIZER;
+static registry_entry_t *registry     = NULL;
+
+int neu_driver_registry_add(const char *node, void *ctx,
+                            neu_driver_registry_read_fn read)
+{
+    registry_entry_t *entry = NULL;
+    int               ret   = NEU_ERR_SUCCESS;
+
+    pthread_rwlock_wrlock(&registry_mtx);
+    HASH_FIND_STR(registry, node, entry);
+    if (entry == NULL) {
+        entry       = calloc(1, sizeof(registry_entry_t));
+        entry->ctx  = ctx;
+        entry->read = read;
+        strncpy(entry->name, node, sizeof(entry->name) - 1);
+        HASH_ADD_STR(registry, name, entry);
+    } else {
+        ret = NEU_ERR_NODE_EXIST;
+    }
+    pthread_rwlock_unlock(&registry_mtx);
+
+    return ret;
+}
+
+void neu_driver_registry_del(const char *node)
+{
+    registry_entry_t *entry = NULL;
+
+    // waits for the reads in progress
+    pthread_rwlock_wrlock(&registry_mtx);
+    HASH_FIND_STR(registry, node, entry);
+    if (entry != NULL) {
+        HASH_DEL(registry, entry);
+        free(entry);
+    }
+    pthread_rwlock_unlock(&registry_mtx);
+}
+
+int neu_driver_registry_rename(const char *node, const char *new_name)
+{
+    registry_entry_t *entry = NULL;
+    registry_entry_t *other = NULL;
+    int               ret   = NEU_ERR_SUCCESS;
+
+    pthread_rwlock_wrlock(&registry_mtx);
+    HASH_FIND_STR(registry, node, entry);
+    HASH_FIND_STR(registry, new_name, other);
+    if (entry == NULL) {
+        ret = NEU_ERR_NODE_NOT_EXIST;
+    } else if (other != NULL) {
+        ret = NEU_ERR_NODE_EXIST;
+    } else {
+        HASH_DEL(registry, entry);
+        memset(entry->name, 0, sizeof(entry->name));
+        strncpy(entry->name, new_name, sizeof(entry->name) - 1);
+        HASH_ADD_STR(registry, name, entry);
+    }
+    pthread_rwlock_unlock(&registry_mtx);
+
+    return ret;
+}
+
+int neu_driver_registry_read(const neu_req_read_group_t *cmd,
+                             neu_resp_read_group_t *     resp)
+{
+    registry_entry_t *entry = NULL;
+    int               ret   = NEU_ERR_SUCCESS;
+
+    if (cmd->sync) {
+        return NEU_ERR_PLUGIN_NOT_SUPPORT_READ_SYNC;
+    }
+
+    utarray_new(resp->tags, neu_resp_tag_value_meta_icd());
+
+    pthread_rwlock_rdlock(&registry_mtx);
+    HASH_FIND_STR(registry, cmd->driver, entry);
+    if (entry == NULL) {
+        ret = NEU_ERR_NODE_NOT_EXIST;
+    } else {
+        ret = entry->read(entry->ctx, cmd, resp->tags);
+    }
+    pthread_rwlock_unlock(&registry_mtx);
+
+    if (ret != NEU_ERR_SUCCESS) {
+        utarray_free(resp->tags);
+        resp->tags = NULL;
+        return ret;
+    }
+
+    resp->driver = strdup(cmd->driver);
+    resp->group  = strdup(cmd->group);
+    return ret;
+}
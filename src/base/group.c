@@ -18,15 +18,16 @@
  **/
 #include <pthread.h>
 #include <string.h>
-#include <sys/time.h>
 
 #include "define.h"
 #include "errcodes.h"
+#include "utils/intern.h"
+#include "utils/time.h"
 
 #include "group.h"
 
 typedef struct tag_elem {
-    char *name;
+    const char *name; // interned, the hash key
 
     neu_datatag_t *tag;
 
@@ -46,6 +47,19 @@ struct neu_group {
 static UT_array *to_array(tag_elem_t *tags);
 static void      update_timestamp(neu_group_t *group);
 
+// called with group->mtx held
+static tag_elem_t *find_tag(neu_group_t *group, const char *name)
+{
+    tag_elem_t *el    = NULL;
+    const char *iname = neu_intern_find(name);
+
+    if (iname != NULL) {
+        HASH_FIND_BYHASHVALUE(hh, group->tags, &iname, sizeof(iname),
+                              neu_intern_hash(iname), el);
+    }
+    return el;
+}
+
 neu_group_t *neu_group_new(const char *name, uint32_t interval)
 {
     neu_group_t *group = calloc(1, sizeof(neu_group_t));
@@ -65,7 +79,7 @@ void neu_group_destroy(neu_group_t *group)
     HASH_ITER(hh, group->tags, el, tmp)
     {
         HASH_DEL(group->tags, el);
-        free(el->name);
+        neu_intern_release(el->name);
         neu_tag_free(el->tag);
         free(el);
     }
@@ -122,17 +136,28 @@ int neu_group_add_tag(neu_group_t *group, const neu_datatag_t *tag)
     tag_elem_t *el = NULL;
 
     pthread_mutex_lock(&group->mtx);
-    HASH_FIND_STR(group->tags, tag->name, el);
+    el = find_tag(group, tag->name);
     if (el != NULL) {
         pthread_mutex_unlock(&group->mtx);
         return NEU_ERR_TAG_NAME_CONFLICT;
     }
 
-    el       = calloc(1, sizeof(tag_elem_t));
-    el->name = strdup(tag->name);
-    el->tag  = neu_tag_dup(tag);
+    el = calloc(1, sizeof(tag_elem_t));
+    if (el == NULL) {
+        pthread_mutex_unlock(&group->mtx);
+        return NEU_ERR_EINTERNAL;
+    }
+
+    el->name = neu_intern(tag->name);
+    if (el->name == NULL) {
+        free(el);
+        pthread_mutex_unlock(&group->mtx);
+        return NEU_ERR_EINTERNAL;
+    }
+    el->tag = neu_tag_dup(tag);
 
-    HASH_ADD_STR(group->tags, name, el);
+    HASH_ADD_BYHASHVALUE(hh, group->tags, name, sizeof(el->name),
+                         neu_intern_hash(el->name), el);
     update_timestamp(group);
     pthread_mutex_unlock(&group->mtx);
 
@@ -145,7 +170,7 @@ int neu_group_update_tag(neu_group_t *group, const neu_datatag_t *tag)
     int         ret = NEU_ERR_TAG_NOT_EXIST;
 
     pthread_mutex_lock(&group->mtx);
-    HASH_FIND_STR(group->tags, tag->name, el);
+    el = find_tag(group, tag->name);
     if (el != NULL) {
         neu_tag_copy(el->tag, tag);
 
@@ -163,10 +188,10 @@ int neu_group_del_tag(neu_group_t *group, const char *tag_name)
     int         ret = NEU_ERR_TAG_NOT_EXIST;
 
     pthread_mutex_lock(&group->mtx);
-    HASH_FIND_STR(group->tags, tag_name, el);
+    el = find_tag(group, tag_name);
     if (el != NULL) {
         HASH_DEL(group->tags, el);
-        free(el->name);
+        neu_intern_release(el->name);
         neu_tag_free(el->tag);
         free(el);
 
@@ -359,7 +384,7 @@ neu_datatag_t *neu_group_find_tag(neu_group_t *group, const char *tag)
     neu_datatag_t *result = NULL;
 
     pthread_mutex_lock(&group->mtx);
-    HASH_FIND_STR(group->tags, tag, find);
+    find = find_tag(group, tag);
     if (find != NULL) {
         result = neu_tag_dup(find->tag);
     }
@@ -386,13 +411,11 @@ bool neu_group_is_change(neu_group_t *group, int64_t timestamp)
     return change;
 }
 
+// only ever compared for equality, the monotonic clock cannot step back onto
+// an earlier version
 static void update_timestamp(neu_group_t *group)
 {
-    struct timeval tv = { 0 };
-
-    gettimeofday(&tv, NULL);
-
-    group->timestamp = (int64_t) tv.tv_sec * 1000 * 1000 + (int64_t) tv.tv_usec;
+    group->timestamp = neu_time_us();
 }
 
 static UT_array *to_array(tag_elem_t *tags)
@@ -303,12 +303,17 @@ int neu_metric_entries_add(neu_metric_entry_t **entries, const char *name,
         return -1;
     }
 
-    if (NEU_METRIC_TYPE_ROLLING_COUNTER == type) {
+    if (neu_metric_type_is_rolling_counter(type)) {
         // only allocate rolling counter for nonzero time span
         if (init > 0 && NULL == (entry->rcnt = neu_rolling_counter_new(init))) {
             free(entry);
             return -1;
         }
+    } else if (neu_metric_type_is_histogram(type)) {
+        if (NULL == (entry->hist = neu_histogram_new())) {
+            free(entry);
+            return -1;
+        }
     } else {
         entry->value = init;
     }
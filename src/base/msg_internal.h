@@ -38,6 +38,8 @@ extern "C" {
     XX(NEU_RESP_READ_GROUP_PAGINATE, neu_resp_read_group_paginate_t) \
     XX(NEU_REQ_TEST_READ_TAG, neu_req_test_read_tag_t)               \
     XX(NEU_RESP_TEST_READ_TAG, neu_resp_test_read_tag_t)             \
+    XX(NEU_REQ_READ_HISTORY, neu_req_read_history_t)                 \
+    XX(NEU_RESP_READ_HISTORY, neu_resp_read_history_t)               \
     XX(NEU_REQ_WRITE_TAG, neu_req_write_tag_t)                       \
     XX(NEU_REQ_WRITE_TAGS, neu_req_write_tags_t)                     \
     XX(NEU_REQ_WRITE_GTAGS, neu_req_write_gtags_t)                   \
@@ -20,11 +20,13 @@
 #include <arpa/inet.h>
 #include <assert.h>
 #include <errno.h>
+#include <poll.h>
 #include <pthread.h>
 #include <stdbool.h>
 #include <stdlib.h>
 #include <string.h>
 #include <sys/time.h>
+#include <time.h>
 
 #include <fcntl.h>
 #include <termios.h>
@@ -33,6 +35,8 @@
 
 #include "connection/neu_connection.h"
 
+#include "serial_bus.h"
+
 #ifndef CMSPAR
 #define CMSPAR 010000000000 /* mark or space (stick) parity */
 #endif
@@ -60,6 +64,15 @@ struct neu_conn {
 
     neu_conn_state_t state;
 
+    neu_serial_bus_t *bus;      // tty client only
+    neu_serial_bus_t *bus_held; // taken by neu_conn_bus_acquire
+
+    // tcp client connect state machine, see neu_conn_link_e
+    neu_conn_link_e link;
+    int64_t         link_deadline; // give up connecting, or retry, at
+    int64_t         link_up;       // when the link was established
+    uint32_t        backoff;       // current backoff delay, millisecond
+
     struct {
         struct tcp_client *clients;
         int                n_client;
@@ -83,9 +96,15 @@ static void conn_tcp_server_stop(neu_conn_t *conn);
 static void conn_connect(neu_conn_t *conn);
 static void conn_disconnect(neu_conn_t *conn);
 
+static void conn_tcp_client_connect(neu_conn_t *conn);
+static void conn_link_reset(neu_conn_t *conn);
+static void conn_fail(neu_conn_t *conn, int err);
+
 static void conn_free_param(neu_conn_t *conn);
 static void conn_init_param(neu_conn_t *conn, neu_conn_param_t *param);
 
+static uint32_t conn_tty_gap_us(neu_conn_t *conn);
+
 neu_conn_t *neu_conn_new(neu_conn_param_t *param, void *data,
                          neu_conn_callback connected,
                          neu_conn_callback disconnected)
@@ -128,6 +147,7 @@ void neu_conn_start(neu_conn_t *conn)
     conn->state.recv_bytes = 0;
     conn->state.send_bytes = 0;
     conn->stop             = false;
+    conn_link_reset(conn);
     pthread_mutex_unlock(&conn->mtx);
 }
 
@@ -141,6 +161,7 @@ neu_conn_t *neu_conn_reconfig(neu_conn_t *conn, neu_conn_param_t *param)
 
     conn_init_param(conn, param);
     conn_tcp_server_listen(conn);
+    conn_link_reset(conn);
 
     conn->state.recv_bytes = 0;
     conn->state.send_bytes = 0;
@@ -168,7 +189,27 @@ void neu_conn_destory(neu_conn_t *conn)
 
 neu_conn_state_t neu_conn_state(neu_conn_t *conn)
 {
-    return conn->state;
+    neu_conn_state_t state = conn->state;
+
+    state.link = neu_conn_link(conn);
+
+    pthread_mutex_lock(&conn->mtx);
+    if (conn->bus != NULL) {
+        state.bus_utilization = neu_serial_bus_utilization(conn->bus);
+    }
+    pthread_mutex_unlock(&conn->mtx);
+
+    return state;
+}
+
+neu_conn_link_e neu_conn_link(neu_conn_t *conn)
+{
+    if (conn->param.type == NEU_CONN_TCP_CLIENT) {
+        return conn->link;
+    }
+
+    return conn->is_connected ? NEU_CONN_LINK_CONNECTED
+                              : NEU_CONN_LINK_DISCONNECTED;
 }
 
 int neu_conn_tcp_server_accept(neu_conn_t *conn)
@@ -383,10 +424,10 @@ ssize_t neu_conn_send(neu_conn_t *conn, uint8_t *buf, ssize_t len)
 
         if (ret == -1) {
             if (errno != EAGAIN) {
-                conn_disconnect(conn);
+                conn_fail(conn, errno);
             } else {
                 if (conn->connection_ok == true) {
-                    conn_disconnect(conn);
+                    conn_fail(conn, errno);
                 }
             }
         }
@@ -458,6 +499,13 @@ ssize_t neu_conn_recv(neu_conn_t *conn, uint8_t *buf, ssize_t len)
         assert(1 == 0);
         break;
     case NEU_CONN_TCP_CLIENT:
+        if (!conn->is_connected) {
+            // still connecting or backing off, nothing to read
+            pthread_mutex_unlock(&conn->mtx);
+            errno = ENOTCONN;
+            return -1;
+        }
+
         if (conn->block) {
             ret = recv(conn->fd, buf, len, MSG_WAITALL);
         } else {
@@ -503,8 +551,10 @@ ssize_t neu_conn_recv(neu_conn_t *conn, uint8_t *buf, ssize_t len)
                 conn->param.log,
                 "tcp conn fd: %d, recv buf len %zd, ret: %zd, errno: %s(%d)",
                 conn->fd, len, ret, strerror(errno), errno);
-            if (ret == 0 || (ret == -1 && errno != EAGAIN)) {
-                conn_disconnect(conn);
+            if (ret == 0) {
+                conn_fail(conn, ECONNRESET);
+            } else if (ret == -1 && errno != EAGAIN) {
+                conn_fail(conn, errno);
             }
         }
     }
@@ -640,8 +690,59 @@ int neu_conn_fd(neu_conn_t *conn)
 void neu_conn_disconnect(neu_conn_t *conn)
 {
     pthread_mutex_lock(&conn->mtx);
-    conn_disconnect(conn);
+    conn_fail(conn, ECONNABORTED);
+    pthread_mutex_unlock(&conn->mtx);
+}
+
+int neu_conn_bus_acquire(neu_conn_t *conn, neu_conn_bus_prio_e prio,
+                         int64_t deadline)
+{
+    neu_serial_bus_t *bus = NULL;
+
+    pthread_mutex_lock(&conn->mtx);
+    if (conn->bus != NULL) {
+        bus = neu_serial_bus_ref(conn->bus);
+    }
+    pthread_mutex_unlock(&conn->mtx);
+
+    if (bus == NULL) {
+        return 0;
+    }
+
+    if (neu_serial_bus_acquire(bus, prio, deadline) != 0) {
+        neu_serial_bus_put(bus);
+        zlog_warn(conn->param.log, "serial bus %s busy past deadline",
+                  conn->param.params.tty_client.device);
+        return -1;
+    }
+
+    pthread_mutex_lock(&conn->mtx);
+    conn->bus_held = bus;
+    if (conn->is_connected && conn->param.type == NEU_CONN_TTY_CLIENT) {
+        tcflush(conn->fd, TCIFLUSH);
+    }
+    pthread_mutex_unlock(&conn->mtx);
+
+    return 0;
+}
+
+void neu_conn_bus_release(neu_conn_t *conn)
+{
+    neu_serial_bus_t *bus = NULL;
+    uint32_t          gap = 0;
+
+    pthread_mutex_lock(&conn->mtx);
+    bus            = conn->bus_held;
+    conn->bus_held = NULL;
+    if (conn->param.type == NEU_CONN_TTY_CLIENT) {
+        gap = conn_tty_gap_us(conn);
+    }
     pthread_mutex_unlock(&conn->mtx);
+
+    if (bus != NULL) {
+        neu_serial_bus_release(bus, gap);
+        neu_serial_bus_put(bus);
+    }
 }
 
 static void conn_free_param(neu_conn_t *conn)
@@ -664,6 +765,8 @@ static void conn_free_param(neu_conn_t *conn)
         break;
     case NEU_CONN_TTY_CLIENT:
         free(conn->param.params.tty_client.device);
+        neu_serial_bus_put(conn->bus);
+        conn->bus = NULL;
         break;
     }
 }
@@ -725,6 +828,7 @@ static void conn_init_param(neu_conn_t *conn, neu_conn_param_t *param)
         conn->param.params.tty_client.timeout =
             param->params.tty_client.timeout;
         conn->block = conn->param.params.tty_client.timeout > 0;
+        conn->bus   = neu_serial_bus_get(conn->param.params.tty_client.device);
         break;
     }
 }
@@ -823,73 +927,9 @@ static void conn_connect(neu_conn_t *conn)
     switch (conn->param.type) {
     case NEU_CONN_TCP_SERVER:
         break;
-    case NEU_CONN_TCP_CLIENT: {
-        if (conn->block) {
-            struct timeval tv = {
-                .tv_sec = conn->param.params.tcp_client.timeout / 1000,
-                .tv_usec =
-                    (conn->param.params.tcp_client.timeout % 1000) * 1000,
-            };
-
-            if (is_ipv4(conn->param.params.tcp_client.ip)) {
-                fd = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
-            } else {
-                fd = socket(AF_INET6, SOCK_STREAM, IPPROTO_TCP);
-            }
-
-            setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
-            setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
-        } else {
-            if (is_ipv4(conn->param.params.tcp_client.ip)) {
-                fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK, IPPROTO_TCP);
-            } else {
-                fd = socket(AF_INET6, SOCK_STREAM | SOCK_NONBLOCK, IPPROTO_TCP);
-            }
-        }
-
-        if (is_ipv4(conn->param.params.tcp_client.ip)) {
-            struct sockaddr_in remote = {
-                .sin_family      = AF_INET,
-                .sin_port        = htons(conn->param.params.tcp_client.port),
-                .sin_addr.s_addr = inet_addr(conn->param.params.tcp_client.ip),
-            };
-
-            ret = connect(fd, (struct sockaddr *) &remote,
-                          sizeof(struct sockaddr_in));
-        } else if (is_ipv6(conn->param.params.tcp_client.ip)) {
-            struct sockaddr_in6 remote_ip6 = { 0 };
-            remote_ip6.sin6_family         = AF_INET6;
-            remote_ip6.sin6_port = htons(conn->param.params.tcp_client.port);
-            inet_pton(AF_INET6, conn->param.params.tcp_client.ip,
-                      &remote_ip6.sin6_addr);
-
-            ret = connect(fd, (struct sockaddr *) &remote_ip6,
-                          sizeof(remote_ip6));
-        } else {
-            zlog_error(conn->param.log, "invalid ip: %s",
-                       conn->param.params.tcp_server.ip);
-            return;
-        }
-
-        if ((conn->block && ret == 0) ||
-            (!conn->block && ret != 0 && errno == EINPROGRESS)) {
-            zlog_notice(conn->param.log, "connect %s:%d success",
-                        conn->param.params.tcp_client.ip,
-                        conn->param.params.tcp_client.port);
-            conn->is_connected = true;
-            conn->fd           = fd;
-        } else {
-            close(fd);
-            zlog_error(conn->param.log, "connect %s:%d error: %s(%d)",
-                       conn->param.params.tcp_client.ip,
-                       conn->param.params.tcp_client.port, strerror(errno),
-                       errno);
-            conn->is_connected = false;
-            return;
-        }
-
+    case NEU_CONN_TCP_CLIENT:
+        conn_tcp_client_connect(conn);
         break;
-    }
     case NEU_CONN_UDP: {
         if (conn->block) {
             struct timeval tv = {
@@ -1228,6 +1268,9 @@ static void conn_disconnect(neu_conn_t *conn)
 {
     conn->is_connected  = false;
     conn->connection_ok = false;
+    if (conn->link != NEU_CONN_LINK_BACKOFF) {
+        conn->link = NEU_CONN_LINK_DISCONNECTED;
+    }
     if (conn->callback_trigger == true) {
         conn->disconnected(conn->data, conn->fd);
         conn->callback_trigger = false;
@@ -1257,6 +1300,232 @@ static void conn_disconnect(neu_conn_t *conn)
     }
 }
 
+static const uint32_t tty_bauds[] = {
+    [NEU_CONN_TTY_BAUD_115200] = 115200, [NEU_CONN_TTY_BAUD_57600] = 57600,
+    [NEU_CONN_TTY_BAUD_38400] = 38400,   [NEU_CONN_TTY_BAUD_19200] = 19200,
+    [NEU_CONN_TTY_BAUD_9600] = 9600,     [NEU_CONN_TTY_BAUD_4800] = 4800,
+    [NEU_CONN_TTY_BAUD_2400] = 2400,     [NEU_CONN_TTY_BAUD_1800] = 1800,
+    [NEU_CONN_TTY_BAUD_1200] = 1200,     [NEU_CONN_TTY_BAUD_600] = 600,
+    [NEU_CONN_TTY_BAUD_300] = 300,       [NEU_CONN_TTY_BAUD_200] = 200,
+    [NEU_CONN_TTY_BAUD_150] = 150,
+};
+
+// 3.5 character times, fixed at 1750us above 19200 baud as modbus rtu does
+static uint32_t conn_tty_gap_us(neu_conn_t *conn)
+{
+    uint32_t baud = 9600;
+    uint32_t bits = 1 + 5 + conn->param.params.tty_client.data;
+
+    if (conn->param.params.tty_client.baud <= NEU_CONN_TTY_BAUD_150) {
+        baud = tty_bauds[conn->param.params.tty_client.baud];
+    }
+    if (baud > 19200) {
+        return 1750;
+    }
+
+    if (conn->param.params.tty_client.parity != NEU_CONN_TTY_PARITY_NONE) {
+        bits += 1;
+    }
+    bits += conn->param.params.tty_client.stop == NEU_CONN_TTY_STOP_2 ? 2 : 1;
+
+    return (uint32_t)((uint64_t) bits * 3500000 / baud);
+}
+
+static int64_t conn_now_ms()
+{
+    struct timespec t = { 0 };
+
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return (int64_t) t.tv_sec * 1000 + t.tv_nsec / 1000000;
+}
+
+static void conn_link_reset(neu_conn_t *conn)
+{
+    if (conn->link == NEU_CONN_LINK_BACKOFF) {
+        conn->link = NEU_CONN_LINK_DISCONNECTED;
+    }
+    conn->backoff = 0;
+}
+
+static void conn_tcp_client_backoff(neu_conn_t *conn, int64_t now, int err)
+{
+    uint32_t delay = 0;
+
+    if (conn->fd > 0) {
+        close(conn->fd);
+        conn->fd = 0;
+    }
+    conn->is_connected = false;
+    conn->state.connect_failures += 1;
+
+    if (conn->backoff == 0) {
+        conn->backoff = NEU_CONN_BACKOFF_MIN;
+    } else if (conn->backoff < NEU_CONN_BACKOFF_MAX / 2) {
+        conn->backoff *= 2;
+    } else {
+        conn->backoff = NEU_CONN_BACKOFF_MAX;
+    }
+
+    // half of the delay plus up to another half as jitter
+    delay = conn->backoff / 2 + random() % (conn->backoff / 2 + 1);
+
+    conn->link          = NEU_CONN_LINK_BACKOFF;
+    conn->link_deadline = now + delay;
+
+    zlog_error(conn->param.log, "connect %s:%d error: %s(%d), retry in %u ms",
+               conn->param.params.tcp_client.ip,
+               conn->param.params.tcp_client.port, strerror(err), err, delay);
+}
+
+static void conn_tcp_client_established(neu_conn_t *conn)
+{
+    if (conn->block) {
+        struct timeval tv = {
+            .tv_sec  = conn->param.params.tcp_client.timeout / 1000,
+            .tv_usec = (conn->param.params.tcp_client.timeout % 1000) * 1000,
+        };
+        int flags = fcntl(conn->fd, F_GETFL, 0);
+
+        fcntl(conn->fd, F_SETFL, flags & ~O_NONBLOCK);
+        setsockopt(conn->fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+        setsockopt(conn->fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+    }
+
+    // the backoff is kept until the link has proven stable, see conn_fail
+    conn->link         = NEU_CONN_LINK_CONNECTED;
+    conn->link_up      = conn_now_ms();
+    conn->is_connected = true;
+
+    zlog_notice(conn->param.log, "connect %s:%d success",
+                conn->param.params.tcp_client.ip,
+                conn->param.params.tcp_client.port);
+}
+
+// a tcp client that loses its link waits out the backoff before reconnecting,
+// so a device that accepts and then drops connections is not hammered
+static void conn_fail(neu_conn_t *conn, int err)
+{
+    neu_conn_link_e link = conn->link;
+    int64_t         now  = 0;
+
+    conn_disconnect(conn);
+    if (conn->param.type != NEU_CONN_TCP_CLIENT || conn->stop ||
+        link == NEU_CONN_LINK_BACKOFF) {
+        return;
+    }
+
+    now = conn_now_ms();
+    if (link == NEU_CONN_LINK_CONNECTED &&
+        now - conn->link_up >= NEU_CONN_BACKOFF_RESET) {
+        conn->backoff = 0;
+    }
+    conn_tcp_client_backoff(conn, now, err);
+}
+
+static void conn_tcp_client_start(neu_conn_t *conn, int64_t now)
+{
+    const char *ip      = conn->param.params.tcp_client.ip;
+    uint16_t    timeout = conn->param.params.tcp_client.timeout;
+    int         ret     = 0;
+
+    if (is_ipv4(ip)) {
+        conn->fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK, IPPROTO_TCP);
+    } else {
+        conn->fd = socket(AF_INET6, SOCK_STREAM | SOCK_NONBLOCK, IPPROTO_TCP);
+    }
+
+    if (conn->fd < 0) {
+        conn_tcp_client_backoff(conn, now, errno);
+        return;
+    }
+
+    if (is_ipv4(ip)) {
+        struct sockaddr_in remote = {
+            .sin_family      = AF_INET,
+            .sin_port        = htons(conn->param.params.tcp_client.port),
+            .sin_addr.s_addr = inet_addr(ip),
+        };
+
+        ret = connect(conn->fd, (struct sockaddr *) &remote,
+                      sizeof(struct sockaddr_in));
+    } else if (is_ipv6(ip)) {
+        struct sockaddr_in6 remote_ip6 = { 0 };
+        remote_ip6.sin6_family         = AF_INET6;
+        remote_ip6.sin6_port = htons(conn->param.params.tcp_client.port);
+        inet_pton(AF_INET6, ip, &remote_ip6.sin6_addr);
+
+        ret = connect(conn->fd, (struct sockaddr *) &remote_ip6,
+                      sizeof(remote_ip6));
+    } else {
+        zlog_error(conn->param.log, "invalid ip: %s", ip);
+        conn_tcp_client_backoff(conn, now, EINVAL);
+        return;
+    }
+
+    if (ret == 0) {
+        conn_tcp_client_established(conn);
+    } else if (errno == EINPROGRESS) {
+        conn->link          = NEU_CONN_LINK_CONNECTING;
+        conn->link_deadline = now +
+            (timeout > 0 ? timeout : NEU_CONN_CONNECT_TIMEOUT);
+    } else {
+        conn_tcp_client_backoff(conn, now, errno);
+    }
+}
+
+static void conn_tcp_client_poll(neu_conn_t *conn, int timeout)
+{
+    struct pollfd pfd = { .fd = conn->fd, .events = POLLOUT };
+    int           err = 0;
+    socklen_t     len = sizeof(err);
+    int           ret = poll(&pfd, 1, timeout);
+
+    if (ret == 0 || (ret < 0 && errno == EINTR)) {
+        int64_t now = conn_now_ms();
+        if (now >= conn->link_deadline) {
+            conn_tcp_client_backoff(conn, now, ETIMEDOUT);
+        }
+        return;
+    }
+
+    if (ret < 0) {
+        err = errno;
+    } else if (getsockopt(conn->fd, SOL_SOCKET, SO_ERROR, &err, &len) != 0) {
+        err = errno;
+    }
+
+    if (err != 0) {
+        conn_tcp_client_backoff(conn, conn_now_ms(), err);
+    } else {
+        conn_tcp_client_established(conn);
+    }
+}
+
+static void conn_tcp_client_connect(neu_conn_t *conn)
+{
+    int64_t now = conn_now_ms();
+
+    switch (conn->link) {
+    case NEU_CONN_LINK_CONNECTED:
+        break;
+    case NEU_CONN_LINK_BACKOFF:
+        if (now < conn->link_deadline) {
+            break;
+        }
+        // fall through
+    case NEU_CONN_LINK_DISCONNECTED:
+        conn_tcp_client_start(conn, now);
+        if (conn->link == NEU_CONN_LINK_CONNECTING) {
+            // peers on the local network are usually done within the grace
+            conn_tcp_client_poll(conn, NEU_CONN_CONNECT_GRACE);
+        }
+        break;
+    case NEU_CONN_LINK_CONNECTING:
+        conn_tcp_client_poll(conn, 0);
+        break;
+    }
+}
+
 static void conn_tcp_server_add_client(neu_conn_t *conn, int fd,
                                        struct sockaddr_in client)
 {
@@ -26,10 +26,12 @@
 #include <unistd.h>
 
 #include <arpa/inet.h>
+#include <linux/filter.h>
+#include <linux/if_packet.h>
 #include <net/ethernet.h>
 #include <net/if.h>
-#include <netpacket/packet.h>
 #include <sys/ioctl.h>
+#include <sys/mman.h>
 
 #include "connection/neu_connection_eth.h"
 #include "event/event.h"
@@ -41,12 +43,23 @@
 #define ETH_P_LLDP 0x88CC
 #endif
 
+// TPACKET_V3 receive ring, 2 MiB per interface
+#define ETH_RING_BLOCK_SIZE (1 << 16)
+#define ETH_RING_BLOCK_NR 32
+#define ETH_RING_FRAME_SIZE 2048
+// retire a partially filled block after this many milliseconds
+#define ETH_RING_BLOCK_TOV 1
+
+// the kernel filter matches source macs up to this many registrations,
+// beyond that only the destination is filtered
+#define ETH_FILTER_MAX_SRC 32
+
 struct neu_conn_eth_sub {
     uint8_t mac[6];
 };
 
 typedef struct {
-    char mac[20];
+    uint64_t mac; // 48-bit source mac, 0 matches any source
 
     neu_conn_eth_msg_callback callback;
 
@@ -73,6 +86,12 @@ typedef struct interface_conn {
 
     callback_elem_t *callbacks;
     pthread_mutex_t  mtx;
+
+    // mapped receive ring, NULL if the kernel lacks TPACKET_V3 and frames
+    // are read with recv()
+    uint8_t *           ring;
+    struct tpacket_req3 ring_req;
+    uint32_t            ring_block;
 } interface_conn_t;
 
 static pthread_mutex_t mtx      = { 0 };
@@ -85,10 +104,13 @@ struct neu_conn_eth {
     void *            ctx;
 };
 
-static int get_mac(neu_conn_eth_t *conn, const char *interface);
-static int init_socket(const char *interface, uint16_t protocol,
-                       uint8_t mac[6]);
-static int uninit_socket(int fd);
+static int  get_mac(neu_conn_eth_t *conn, const char *interface);
+static int  init_socket(const char *interface, uint16_t protocol,
+                        uint8_t mac[6]);
+static int  uninit_socket(int fd);
+static int  init_ring(interface_conn_t *ic);
+static void uninit_ring(interface_conn_t *ic);
+static void update_filter(interface_conn_t *ic);
 
 static int     eth_msg_cb(enum neu_event_io_type type, int fd, void *usr_data);
 static uint8_t pf_dcp_broadcast[ETH_ALEN] = {
@@ -144,6 +166,11 @@ neu_conn_eth_t *neu_conn_eth_init(const char *interface, void *ctx)
 
                 in_conns[i].profinet_fd =
                     init_socket(interface, 0x8892, in_conns[i].mac);
+                update_filter(&in_conns[i]);
+                if (init_ring(&in_conns[i]) != 0) {
+                    nlog_warn("eth conn %s: no TPACKET_V3 ring, use recv",
+                              interface);
+                }
                 // in_conns[i].vlan_fd =
                 // init_socket(interface, 0x8100, in_conns[i].mac);
 
@@ -181,6 +208,7 @@ int neu_conn_eth_uninit(neu_conn_eth_t *conn)
 
         neu_event_close(conn->ic->events);
 
+        uninit_ring(conn->ic);
         uninit_socket(conn->ic->profinet_fd);
         // uninit_socket(conn->ic->vlan_fd);
 
@@ -220,29 +248,34 @@ int neu_conn_eth_check_interface(const char *interface)
     return ret;
 }
 
+static inline uint64_t mac_key(const uint8_t mac[ETH_ALEN])
+{
+    return (uint64_t) mac[0] << 40 | (uint64_t) mac[1] << 32 |
+        (uint64_t) mac[2] << 24 | (uint64_t) mac[3] << 16 |
+        (uint64_t) mac[4] << 8 | (uint64_t) mac[5];
+}
+
 neu_conn_eth_sub_t *neu_conn_eth_register(neu_conn_eth_t *conn, uint8_t xmac[6],
                                           neu_conn_eth_msg_callback callback)
 {
-    char                tmp_mac[20] = { 0 };
-    neu_conn_eth_sub_t *sub         = NULL;
-    callback_elem_t *   elem        = NULL;
-
-    snprintf(tmp_mac, sizeof(tmp_mac), "%X:%X:%X-%X:%X:%X", xmac[0], xmac[1],
-             xmac[2], xmac[3], xmac[4], xmac[5]);
+    uint64_t            key  = mac_key(xmac);
+    neu_conn_eth_sub_t *sub  = NULL;
+    callback_elem_t *   elem = NULL;
 
     pthread_mutex_lock(&conn->ic->mtx);
 
-    HASH_FIND_STR(conn->ic->callbacks, tmp_mac, elem);
+    HASH_FIND(hh, conn->ic->callbacks, &key, sizeof(key), elem);
     if (elem == NULL) {
         elem = calloc(1, sizeof(callback_elem_t));
         sub  = calloc(1, sizeof(neu_conn_eth_sub_t));
 
         elem->callback = callback;
-        memcpy(elem->mac, tmp_mac, sizeof(elem->mac));
+        elem->mac      = key;
 
         memcpy(sub->mac, xmac, ETH_ALEN);
 
-        HASH_ADD_STR(conn->ic->callbacks, mac, elem);
+        HASH_ADD(hh, conn->ic->callbacks, mac, sizeof(elem->mac), elem);
+        update_filter(conn->ic);
     }
 
     pthread_mutex_unlock(&conn->ic->mtx);
@@ -252,18 +285,16 @@ neu_conn_eth_sub_t *neu_conn_eth_register(neu_conn_eth_t *conn, uint8_t xmac[6],
 
 int neu_conn_eth_unregister(neu_conn_eth_t *conn, neu_conn_eth_sub_t *sub)
 {
-    char             tmp_mac[20] = { 0 };
-    callback_elem_t *elem        = NULL;
-
-    snprintf(tmp_mac, sizeof(tmp_mac), "%X:%X:%X-%X:%X:%X", sub->mac[0],
-             sub->mac[1], sub->mac[2], sub->mac[3], sub->mac[4], sub->mac[5]);
+    uint64_t         key  = mac_key(sub->mac);
+    callback_elem_t *elem = NULL;
 
     pthread_mutex_lock(&conn->ic->mtx);
 
-    HASH_FIND_STR(conn->ic->callbacks, tmp_mac, elem);
+    HASH_FIND(hh, conn->ic->callbacks, &key, sizeof(key), elem);
     if (elem != NULL) {
         HASH_DEL(conn->ic->callbacks, elem);
         free(elem);
+        update_filter(conn->ic);
     }
 
     pthread_mutex_unlock(&conn->ic->mtx);
@@ -350,58 +381,242 @@ static int uninit_socket(int fd)
     return 0;
 }
 
-static int eth_msg_cb(enum neu_event_io_type type, int fd, void *usr_data)
+static int init_ring(interface_conn_t *ic)
 {
-    neu_conn_eth_t *conn = (neu_conn_eth_t *) usr_data;
+    struct tpacket_req3 *req     = &ic->ring_req;
+    int                  version = TPACKET_V3;
+    size_t               size    = 0;
 
-    switch (type) {
-    case NEU_EVENT_IO_READ: {
-        callback_elem_t *elem      = NULL;
-        uint8_t          buf[1500] = { 0 };
-        int              ret       = recv(fd, buf, 1500, 0);
+    if (ic->profinet_fd < 0) {
+        return -1;
+    }
+
+    if (setsockopt(ic->profinet_fd, SOL_PACKET, PACKET_VERSION, &version,
+                   sizeof(version)) != 0) {
+        return -1;
+    }
+
+    memset(req, 0, sizeof(*req));
+    req->tp_block_size     = ETH_RING_BLOCK_SIZE;
+    req->tp_block_nr       = ETH_RING_BLOCK_NR;
+    req->tp_frame_size     = ETH_RING_FRAME_SIZE;
+    req->tp_frame_nr       = ETH_RING_BLOCK_SIZE / ETH_RING_FRAME_SIZE *
+        ETH_RING_BLOCK_NR;
+    req->tp_retire_blk_tov = ETH_RING_BLOCK_TOV;
+
+    if (setsockopt(ic->profinet_fd, SOL_PACKET, PACKET_RX_RING, req,
+                   sizeof(*req)) != 0) {
+        return -1;
+    }
+
+    size     = (size_t) req->tp_block_size * req->tp_block_nr;
+    ic->ring = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED,
+                    ic->profinet_fd, 0);
+    if (ic->ring == MAP_FAILED) {
+        ic->ring = NULL;
+        // drop the ring again so that recv() keeps working
+        memset(req, 0, sizeof(*req));
+        setsockopt(ic->profinet_fd, SOL_PACKET, PACKET_RX_RING, req,
+                   sizeof(*req));
+        return -1;
+    }
+
+    ic->ring_block = 0;
+    return 0;
+}
+
+static void uninit_ring(interface_conn_t *ic)
+{
+    if (ic->ring != NULL) {
+        munmap(ic->ring,
+               (size_t) ic->ring_req.tp_block_size * ic->ring_req.tp_block_nr);
+        ic->ring = NULL;
+    }
+}
+
+/*
+ * Classic BPF program dropping in the kernel everything eth_frame_dispatch
+ * would ignore: frames that are not profinet or vlan tagged, not addressed to
+ * the interface or the DCP multicast, and, unless a callback accepts any
+ * source, not sent by a registered mac.
+ */
+static void update_filter(interface_conn_t *ic)
+{
+    struct sock_filter code[11 + 4 * ETH_FILTER_MAX_SRC + 2];
+    struct sock_fprog  prog   = { 0 };
+    callback_elem_t *  elem   = NULL;
+    callback_elem_t *  tmp    = NULL;
+    uint64_t           any    = 0;
+    uint16_t           n_src  = HASH_COUNT(ic->callbacks);
+    uint16_t           accept = 0;
+    uint16_t           drop   = 0;
+    uint16_t           n      = 0;
+    uint64_t           own    = mac_key(ic->mac);
+    uint64_t           dcp    = mac_key(pf_dcp_broadcast);
+
+    if (ic->profinet_fd < 0) {
+        return;
+    }
+
+    HASH_FIND(hh, ic->callbacks, &any, sizeof(any), elem);
+    if (elem != NULL || n_src > ETH_FILTER_MAX_SRC) {
+        n_src = 0;
+    }
+    drop   = n_src > 0 ? 11 + 4 * n_src : 12;
+    accept = n_src > 0 ? drop + 1 : 11;
+
+#define JUMP(k, t, f) \
+    BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, (k), (t) - n - 1, (f) - n - 1)
+
+    code[n] = (struct sock_filter) BPF_STMT(BPF_LD | BPF_H | BPF_ABS, 12);
+    n++;
+    code[n] = (struct sock_filter) JUMP(0x8892, 3, n + 1);
+    n++;
+    code[n] = (struct sock_filter) JUMP(0x8100, 3, drop);
+    n++;
+
+    // dcp multicast, handed to every callback
+    code[n] = (struct sock_filter) BPF_STMT(BPF_LD | BPF_W | BPF_ABS, 2);
+    n++;
+    code[n] = (struct sock_filter) JUMP(dcp & 0xffffffff, n + 1, 7);
+    n++;
+    code[n] = (struct sock_filter) BPF_STMT(BPF_LD | BPF_H | BPF_ABS, 0);
+    n++;
+    code[n] = (struct sock_filter) JUMP(dcp >> 32, accept, 7);
+    n++;
+
+    // unicast to the interface
+    code[n] = (struct sock_filter) BPF_STMT(BPF_LD | BPF_W | BPF_ABS, 2);
+    n++;
+    code[n] = (struct sock_filter) JUMP(own & 0xffffffff, n + 1, drop);
+    n++;
+    code[n] = (struct sock_filter) BPF_STMT(BPF_LD | BPF_H | BPF_ABS, 0);
+    n++;
+    code[n] = (struct sock_filter) JUMP(own >> 32, n + 1, drop);
+    n++;
+
+    if (n_src > 0) {
+        HASH_ITER(hh, ic->callbacks, elem, tmp)
+        {
+            code[n] =
+                (struct sock_filter) BPF_STMT(BPF_LD | BPF_W | BPF_ABS, 8);
+            n++;
+            code[n] =
+                (struct sock_filter) JUMP(elem->mac & 0xffffffff, n + 1, n + 3);
+            n++;
+            code[n] =
+                (struct sock_filter) BPF_STMT(BPF_LD | BPF_H | BPF_ABS, 6);
+            n++;
+            code[n] = (struct sock_filter) JUMP(elem->mac >> 32, accept, n + 1);
+            n++;
+        }
+        code[n++] = (struct sock_filter) BPF_STMT(BPF_RET | BPF_K, 0);
+        code[n++] = (struct sock_filter) BPF_STMT(BPF_RET | BPF_K, 0xffff);
+    } else {
+        code[n++] = (struct sock_filter) BPF_STMT(BPF_RET | BPF_K, 0xffff);
+        code[n++] = (struct sock_filter) BPF_STMT(BPF_RET | BPF_K, 0);
+    }
+
+#undef JUMP
+
+    prog.len    = n;
+    prog.filter = code;
+    if (setsockopt(ic->profinet_fd, SOL_SOCKET, SO_ATTACH_FILTER, &prog,
+                   sizeof(prog)) != 0) {
+        nlog_warn("eth conn %s attach filter error: %s", ic->interface,
+                  strerror(errno));
+    }
+}
 
-        if (ret < ETH_HLEN) {
-            return 0;
+static void eth_frame_dispatch(neu_conn_eth_t *conn, uint8_t *frame,
+                               uint32_t len)
+{
+    struct ethhdr *  ehdr     = (struct ethhdr *) frame;
+    callback_elem_t *elem     = NULL;
+    uint16_t         protocol = 0;
+    uint64_t         key      = 0;
+
+    if (len < ETH_HLEN) {
+        return;
+    }
+
+    protocol = ntohs(ehdr->h_proto);
+    if (protocol != 0x8100 && protocol != 0x8892) {
+        return;
+    }
+
+    if (memcmp(ehdr->h_dest, pf_dcp_broadcast, ETH_ALEN) == 0) {
+        callback_elem_t *tmp = NULL;
+
+        HASH_ITER(hh, conn->ic->callbacks, elem, tmp)
+        {
+            elem->callback(conn, conn->ctx, protocol, len - ETH_HLEN,
+                           frame + ETH_HLEN, ehdr->h_source);
         }
+        return;
+    }
+
+    if (memcmp(ehdr->h_dest, conn->ic->mac, ETH_ALEN) != 0) {
+        return;
+    }
+
+    key = mac_key(ehdr->h_source);
+    HASH_FIND(hh, conn->ic->callbacks, &key, sizeof(key), elem);
+    if (elem == NULL) {
+        key = 0;
+        HASH_FIND(hh, conn->ic->callbacks, &key, sizeof(key), elem);
+    }
+    if (elem != NULL) {
+        elem->callback(conn, conn->ctx, protocol, len - ETH_HLEN,
+                       frame + ETH_HLEN, ehdr->h_source);
+    }
+}
+
+// hand every block released by the kernel to the callbacks, then return it
+static void eth_ring_consume(neu_conn_eth_t *conn)
+{
+    interface_conn_t *ic = conn->ic;
+
+    for (uint32_t n = 0; n < ic->ring_req.tp_block_nr; n++) {
+        struct tpacket_block_desc *bd =
+            (struct tpacket_block_desc *) (ic->ring +
+                                           (size_t) ic->ring_block *
+                                               ic->ring_req.tp_block_size);
+        struct tpacket3_hdr *ph = NULL;
 
-        struct ethhdr *ehdr = (struct ethhdr *) buf;
-        ehdr->h_proto       = ntohs(ehdr->h_proto);
+        if ((__atomic_load_n(&bd->hdr.bh1.block_status, __ATOMIC_ACQUIRE) &
+             TP_STATUS_USER) == 0) {
+            break;
+        }
 
-        if (ehdr->h_proto != 0x8100 && ehdr->h_proto != 0x8892) {
-            return 0;
+        ph = (struct tpacket3_hdr *) ((uint8_t *) bd +
+                                      bd->hdr.bh1.offset_to_first_pkt);
+        for (uint32_t i = 0; i < bd->hdr.bh1.num_pkts; i++) {
+            eth_frame_dispatch(conn, (uint8_t *) ph + ph->tp_mac,
+                               ph->tp_snaplen);
+            ph = (struct tpacket3_hdr *) ((uint8_t *) ph + ph->tp_next_offset);
         }
 
-        if (memcmp(ehdr->h_dest, pf_dcp_broadcast, ETH_ALEN) == 0) {
-            callback_elem_t *tmp = NULL;
+        __atomic_store_n(&bd->hdr.bh1.block_status, TP_STATUS_KERNEL,
+                         __ATOMIC_RELEASE);
+        ic->ring_block = (ic->ring_block + 1) % ic->ring_req.tp_block_nr;
+    }
+}
 
-            HASH_ITER(hh, conn->ic->callbacks, elem, tmp)
-            {
-                elem->callback(conn, conn->ctx, ehdr->h_proto, ret - ETH_HLEN,
-                               buf + ETH_HLEN, ehdr->h_source);
-            }
+static int eth_msg_cb(enum neu_event_io_type type, int fd, void *usr_data)
+{
+    neu_conn_eth_t *conn = (neu_conn_eth_t *) usr_data;
+
+    switch (type) {
+    case NEU_EVENT_IO_READ: {
+        if (conn->ic->ring != NULL) {
+            eth_ring_consume(conn);
         } else {
-            if (memcmp(ehdr->h_dest, conn->ic->mac, ETH_ALEN) != 0) {
-                return 0;
-            }
-            char tmp_mac[20] = { 0 };
-
-            snprintf(tmp_mac, sizeof(tmp_mac), "%X:%X:%X-%X:%X:%X",
-                     ehdr->h_source[0], ehdr->h_source[1], ehdr->h_source[2],
-                     ehdr->h_source[3], ehdr->h_source[4], ehdr->h_source[5]);
-
-            HASH_FIND_STR(conn->ic->callbacks, tmp_mac, elem);
-            if (elem != NULL) {
-                elem->callback(conn, conn->ctx, ehdr->h_proto, ret - ETH_HLEN,
-                               buf + ETH_HLEN, ehdr->h_source);
-            } else {
-                memset(tmp_mac, 0, sizeof(tmp_mac));
-                snprintf(tmp_mac, sizeof(tmp_mac), "0:0:0-0:0:0");
-                HASH_FIND_STR(conn->ic->callbacks, tmp_mac, elem);
-                if (elem != NULL) {
-                    elem->callback(conn, conn->ctx, ehdr->h_proto,
-                                   ret - ETH_HLEN, buf + ETH_HLEN,
-                                   ehdr->h_source);
-                }
+            uint8_t buf[1500] = { 0 };
+            int     ret       = recv(fd, buf, sizeof(buf), 0);
+
+            if (ret > 0) {
+                eth_frame_dispatch(conn, buf, ret);
             }
         }
 
@@ -84,6 +84,7 @@ typedef enum {
         uint8_t *                    payload; \
         uint32_t                     len;     \
         void *                       data;    \
+        int64_t                      ts;      \
     } pub;                                    \
     subscription_t *sub;                      \
     struct {                                  \
@@ -132,6 +133,9 @@ struct neu_mqtt_client_s {
     size_t                          task_count;
     size_t                          task_limit;
     task_t *                        task_free_list;
+    size_t                          inflight;
+    uint64_t                        ack_latency;
+    neu_histogram_t *               ack_hist;
     zlog_category_t *               log;
 };
 
@@ -160,6 +164,7 @@ static void connect_cb(nng_pipe p, nng_pipe_ev ev, void *arg);
 static inline task_t *client_alloc_task(neu_mqtt_client_t *client);
 static inline void    client_free_task(neu_mqtt_client_t *client, task_t *task);
 static inline size_t  client_task_free_list_len(neu_mqtt_client_t *client);
+static inline void    client_pub_done(neu_mqtt_client_t *client, task_t *task);
 static inline void    client_add_subscription(neu_mqtt_client_t *client,
                                               subscription_t *   sub);
 static int            client_send_sub_msg(neu_mqtt_client_t *client,
@@ -354,6 +359,9 @@ static void task_cb(void *arg)
     }
 
     nng_mtx_lock(client->mtx);
+    if (TASK_PUB == task->kind) {
+        client_pub_done(client, task);
+    }
     client_free_task(client, task);
     nng_mtx_unlock(client->mtx);
 }
@@ -787,6 +795,23 @@ static inline void client_free_task(neu_mqtt_client_t *client, task_t *task)
     DL_PREPEND(client->task_free_list, task);
 }
 
+static inline void client_pub_done(neu_mqtt_client_t *client, task_t *task)
+{
+    client->inflight -= 1;
+
+    if (0 == nng_aio_result(task->aio)) {
+        int64_t  now     = neu_time_ms();
+        uint64_t latency = now > task->pub.ts ? now - task->pub.ts : 0;
+        // smoothed the same way as TCP SRTT, gain 1/8
+        client->ack_latency = 0 == client->ack_latency
+            ? latency
+            : (7 * client->ack_latency + latency) / 8;
+        if (NULL != client->ack_hist) {
+            neu_histogram_record(client->ack_hist, latency);
+        }
+    }
+}
+
 static inline size_t client_task_free_list_len(neu_mqtt_client_t *client)
 {
     size_t  count = 0;
@@ -1092,6 +1117,36 @@ bool neu_mqtt_client_is_connected(neu_mqtt_client_t *client)
     return connected;
 }
 
+size_t neu_mqtt_client_get_inflight_msgs_num(neu_mqtt_client_t *client)
+{
+    size_t num = 0;
+
+    nng_mtx_lock(client->mtx);
+    num = client->inflight;
+    nng_mtx_unlock(client->mtx);
+
+    return num;
+}
+
+uint64_t neu_mqtt_client_get_ack_latency(neu_mqtt_client_t *client)
+{
+    uint64_t latency = 0;
+
+    nng_mtx_lock(client->mtx);
+    latency = client->ack_latency;
+    nng_mtx_unlock(client->mtx);
+
+    return latency;
+}
+
+void neu_mqtt_client_set_ack_histogram(neu_mqtt_client_t *client,
+                                       neu_histogram_t *  hist)
+{
+    nng_mtx_lock(client->mtx);
+    client->ack_hist = hist;
+    nng_mtx_unlock(client->mtx);
+}
+
 size_t neu_mqtt_client_get_cached_msgs_num(neu_mqtt_client_t *client)
 {
     size_t num = 0;
@@ -1636,6 +1691,9 @@ int neu_mqtt_client_publish(neu_mqtt_client_t *client, neu_mqtt_qos_e qos,
 
     nng_mtx_lock(client->mtx);
     task = client_alloc_task(client);
+    if (NULL != task) {
+        client->inflight += 1;
+    }
     nng_mtx_unlock(client->mtx);
 
     if (NULL == task) {
@@ -1651,6 +1709,7 @@ int neu_mqtt_client_publish(neu_mqtt_client_t *client, neu_mqtt_qos_e qos,
     task->pub.payload = payload;
     task->pub.len     = len;
     task->pub.data    = data;
+    task->pub.ts      = neu_time_ms();
     nng_aio_set_msg(task->aio, pub_msg);
     nng_send_aio(client->sock, task->aio);
 
@@ -1694,6 +1753,9 @@ int neu_mqtt_client_publish_with_trace(neu_mqtt_client_t *client,
 
     nng_mtx_lock(client->mtx);
     task = client_alloc_task(client);
+    if (NULL != task) {
+        client->inflight += 1;
+    }
     nng_mtx_unlock(client->mtx);
 
     if (NULL == task) {
@@ -1709,6 +1771,7 @@ int neu_mqtt_client_publish_with_trace(neu_mqtt_client_t *client,
     task->pub.payload = payload;
     task->pub.len     = len;
     task->pub.data    = data;
+    task->pub.ts      = neu_time_ms();
     nng_aio_set_msg(task->aio, pub_msg);
     nng_send_aio(client->sock, task->aio);
 
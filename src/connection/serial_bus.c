@@ -0,0 +1,245 @@
+/**
+ * NEURON IIoT System for Industry 4.0
+ * Copyright (C) 2020-2022 EMQ Technologies Co., Ltd All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ **/
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "utils/time.h"
+#include "utils/uthash.h"
+
+#include "serial_bus.h"
+
+struct bus_waiter {
+    int                priority;
+    int64_t            deadline; // neu_time_us(), INT64_MAX for none
+    uint64_t           seq;
+    struct bus_waiter *next;
+};
+
+struct neu_serial_bus {
+    char *device;
+    int   ref;
+
+    pthread_mutex_t    mtx;
+    pthread_cond_t     cond;
+    bool               busy;
+    int64_t            free_at; // end of the inter-frame gap, neu_time_us()
+    struct bus_waiter *waiters;
+    uint64_t           seq;
+
+    int64_t  grant_at;
+    int64_t  window_start;
+    int64_t  window_busy;
+    uint16_t utilization;
+
+    UT_hash_handle hh;
+};
+
+static neu_serial_bus_t *buses     = NULL;
+static pthread_mutex_t   buses_mtx = PTHREAD_MUTEX_INITIALIZER;
+
+neu_serial_bus_t *neu_serial_bus_get(const char *device)
+{
+    neu_serial_bus_t * bus  = NULL;
+    pthread_condattr_t attr = { 0 };
+
+    pthread_mutex_lock(&buses_mtx);
+    HASH_FIND_STR(buses, device, bus);
+    if (bus == NULL) {
+        bus               = calloc(1, sizeof(neu_serial_bus_t));
+        bus->device       = strdup(device);
+        bus->window_start = neu_time_us();
+
+        pthread_mutex_init(&bus->mtx, NULL);
+        pthread_condattr_init(&attr);
+        pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+        pthread_cond_init(&bus->cond, &attr);
+        pthread_condattr_destroy(&attr);
+
+        HASH_ADD_KEYPTR(hh, buses, bus->device, strlen(bus->device), bus);
+    }
+    bus->ref += 1;
+    pthread_mutex_unlock(&buses_mtx);
+
+    return bus;
+}
+
+neu_serial_bus_t *neu_serial_bus_ref(neu_serial_bus_t *bus)
+{
+    pthread_mutex_lock(&buses_mtx);
+    bus->ref += 1;
+    pthread_mutex_unlock(&buses_mtx);
+
+    return bus;
+}
+
+void neu_serial_bus_put(neu_serial_bus_t *bus)
+{
+    pthread_mutex_lock(&buses_mtx);
+    bus->ref -= 1;
+    if (bus->ref > 0) {
+        pthread_mutex_unlock(&buses_mtx);
+        return;
+    }
+    HASH_DEL(buses, bus);
+    pthread_mutex_unlock(&buses_mtx);
+
+    pthread_cond_destroy(&bus->cond);
+    pthread_mutex_destroy(&bus->mtx);
+    free(bus->device);
+    free(bus);
+}
+
+static bool waiter_before(struct bus_waiter *w1, struct bus_waiter *w2)
+{
+    if (w1->priority != w2->priority) {
+        return w1->priority < w2->priority;
+    }
+    if (w1->deadline != w2->deadline) {
+        return w1->deadline < w2->deadline;
+    }
+    return w1->seq < w2->seq;
+}
+
+static struct bus_waiter *bus_next(neu_serial_bus_t *bus)
+{
+    struct bus_waiter *next = bus->waiters;
+
+    for (struct bus_waiter *w = bus->waiters; w != NULL; w = w->next) {
+        if (waiter_before(w, next)) {
+            next = w;
+        }
+    }
+
+    return next;
+}
+
+static void bus_remove(neu_serial_bus_t *bus, struct bus_waiter *waiter)
+{
+    struct bus_waiter **p = &bus->waiters;
+
+    while (*p != waiter) {
+        p = &(*p)->next;
+    }
+    *p = waiter->next;
+}
+
+static void bus_wait(neu_serial_bus_t *bus, int64_t until)
+{
+    struct timespec ts = { 0 };
+
+    if (until == INT64_MAX) {
+        pthread_cond_wait(&bus->cond, &bus->mtx);
+        return;
+    }
+
+    ts.tv_sec  = until / 1000000;
+    ts.tv_nsec = (until % 1000000) * 1000;
+    pthread_cond_timedwait(&bus->cond, &bus->mtx, &ts);
+}
+
+static void bus_window(neu_serial_bus_t *bus, int64_t now)
+{
+    int64_t span = now - bus->window_start;
+
+    if (span < NEU_SERIAL_BUS_WINDOW_US) {
+        return;
+    }
+
+    bus->utilization = bus->window_busy >= span
+        ? 100
+        : (uint16_t)(bus->window_busy * 100 / span);
+    bus->window_start = now;
+    bus->window_busy  = 0;
+}
+
+int neu_serial_bus_acquire(neu_serial_bus_t *bus, int priority,
+                           int64_t deadline)
+{
+    struct bus_waiter waiter = { 0 };
+    int64_t           now    = neu_time_us();
+
+    waiter.priority = priority;
+    waiter.deadline = INT64_MAX;
+    if (deadline > 0) {
+        waiter.deadline = now + (deadline - neu_time_ms()) * 1000;
+    }
+
+    pthread_mutex_lock(&bus->mtx);
+    waiter.seq   = bus->seq++;
+    waiter.next  = bus->waiters;
+    bus->waiters = &waiter;
+
+    while (true) {
+        now = neu_time_us();
+
+        if (now >= waiter.deadline) {
+            bus_remove(bus, &waiter);
+            // the next waiter in line may be this one's successor
+            pthread_cond_broadcast(&bus->cond);
+            pthread_mutex_unlock(&bus->mtx);
+            return -1;
+        }
+
+        if (!bus->busy && bus_next(bus) == &waiter) {
+            if (now >= bus->free_at) {
+                break;
+            }
+            bus_wait(bus,
+                     bus->free_at < waiter.deadline ? bus->free_at
+                                                    : waiter.deadline);
+        } else {
+            bus_wait(bus, waiter.deadline);
+        }
+    }
+
+    bus_remove(bus, &waiter);
+    bus->busy     = true;
+    bus->grant_at = now;
+    pthread_mutex_unlock(&bus->mtx);
+
+    return 0;
+}
+
+void neu_serial_bus_release(neu_serial_bus_t *bus, uint32_t gap_us)
+{
+    int64_t now = neu_time_us();
+
+    pthread_mutex_lock(&bus->mtx);
+    bus->busy    = false;
+    bus->free_at = now + gap_us;
+    bus->window_busy += now - bus->grant_at + gap_us;
+    bus_window(bus, now);
+    pthread_cond_broadcast(&bus->cond);
+    pthread_mutex_unlock(&bus->mtx);
+}
+
+uint16_t neu_serial_bus_utilization(neu_serial_bus_t *bus)
+{
+    uint16_t utilization = 0;
+
+    pthread_mutex_lock(&bus->mtx);
+    bus_window(bus, neu_time_us());
+    utilization = bus->utilization;
+    pthread_mutex_unlock(&bus->mtx);
+
+    return utilization;
+}
@@ -0,0 +1,55 @@
+/**
+ * NEURON IIoT System for Industry 4.0
+ * Copyright (C) 2020-2022 EMQ Technologies Co., Ltd All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ **/
+
+#ifndef _NEU_CONNECTION_SERIAL_BUS_H_
+#define _NEU_CONNECTION_SERIAL_BUS_H_
+
+#include <stdint.h>
+
+// window over which the bus utilization is measured
+#define NEU_SERIAL_BUS_WINDOW_US (10 * 1000 * 1000)
+
+/** Arbiter of one serial device, shared by every tty client connection
+ * opened on it.
+ *
+ * One transaction holds the bus at a time. Waiters are granted by priority,
+ * then by earliest deadline, then in arrival order, and no earlier than the
+ * inter-frame gap given by the previous holder on release.
+ */
+typedef struct neu_serial_bus neu_serial_bus_t;
+
+// get the bus of `device`, created on first use
+neu_serial_bus_t *neu_serial_bus_get(const char *device);
+// take one more reference on `bus`
+neu_serial_bus_t *neu_serial_bus_ref(neu_serial_bus_t *bus);
+void              neu_serial_bus_put(neu_serial_bus_t *bus);
+
+/** Wait for the bus.
+ *
+ * `deadline` is a neu_time_ms() timestamp, 0 for none. Return 0 once the bus
+ * is held, -1 if the deadline passed while waiting.
+ */
+int  neu_serial_bus_acquire(neu_serial_bus_t *bus, int priority,
+                            int64_t deadline);
+void neu_serial_bus_release(neu_serial_bus_t *bus, uint32_t gap_us);
+
+// percent of the last full window the bus was held or in an inter-frame gap
+uint16_t neu_serial_bus_utilization(neu_serial_bus_t *bus);
+
+#endif
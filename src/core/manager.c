@@ -1062,6 +1062,7 @@ static int manager_loop(enum neu_event_io_type type, int fd, void *usr_data)
     case NEU_REQ_GET_NODE_SETTING:
     case NEU_REQ_READ_GROUP:
     case NEU_REQ_READ_GROUP_PAGINATE:
+    case NEU_REQ_READ_HISTORY:
     case NEU_REQ_WRITE_TAG:
     case NEU_REQ_WRITE_TAGS:
     case NEU_REQ_WRITE_GTAGS:
@@ -1112,6 +1113,9 @@ static int manager_loop(enum neu_event_io_type type, int fd, void *usr_data)
             } else if (NEU_REQ_READ_GROUP_PAGINATE == header->type) {
                 neu_req_read_group_paginate_fini(
                     (neu_req_read_group_paginate_t *) &header[1]);
+            } else if (NEU_REQ_READ_HISTORY == header->type) {
+                neu_req_read_history_fini(
+                    (neu_req_read_history_t *) &header[1]);
             } else if (NEU_REQ_WRITE_TAG == header->type) {
                 neu_req_write_tag_fini((neu_req_write_tag_t *) &header[1]);
             } else if (NEU_REQ_WRITE_TAGS == header->type) {
@@ -1360,6 +1364,7 @@ static int manager_loop(enum neu_event_io_type type, int fd, void *usr_data)
     case NEU_RESP_FUP_DATA:
     case NEU_RESP_READ_GROUP:
     case NEU_RESP_READ_GROUP_PAGINATE:
+    case NEU_RESP_READ_HISTORY:
     case NEU_RESP_TEST_READ_TAG:
     case NEU_RESP_PRGFILE_PROCESS:
     case NEU_RESP_SCAN_TAGS:
@@ -440,9 +440,14 @@ static int del_node(neu_manager_t *manager, const char *node)
         utarray_free(apps);
     }
 
+    bool is_driver = neu_adapter_get_type(adapter) == NEU_NA_TYPE_DRIVER;
+
     neu_adapter_uninit(adapter);
     neu_manager_del_node(manager, node);
     manager_storage_del_node(manager, node);
+    if (is_driver) {
+        neu_adapter_driver_del_snapshot(node);
+    }
     return 0;
 }
 
@@ -20,13 +20,15 @@
 
 #include "adapter.h"
 #include "errcodes.h"
+#include "utils/intern.h"
 #include "utils/log.h"
 
 #include "subscribe.h"
 
+// interned names, referenced by the element
 typedef struct sub_elem_key {
-    char driver[NEU_NODE_NAME_LEN];
-    char group[NEU_GROUP_NAME_LEN];
+    const char *driver;
+    const char *group;
 } sub_elem_key_t;
 
 typedef struct sub_elem {
@@ -44,6 +46,45 @@ struct neu_subscribe_mgr {
     sub_elem_t *ss;
 };
 
+static inline unsigned key_hash(const sub_elem_key_t *key)
+{
+    return neu_intern_hash(key->driver) * 31 + neu_intern_hash(key->group);
+}
+
+static sub_elem_t *find_elem(neu_subscribe_mgr_t *mgr, const char *driver,
+                             const char *group)
+{
+    sub_elem_t *   find = NULL;
+    sub_elem_key_t key  = { 0 };
+
+    key.driver = neu_intern_find(driver);
+    key.group  = neu_intern_find(group);
+    if (key.driver != NULL && key.group != NULL) {
+        HASH_FIND_BYHASHVALUE(hh, mgr->ss, &key, sizeof(sub_elem_key_t),
+                              key_hash(&key), find);
+    }
+
+    return find;
+}
+
+static inline void add_elem(neu_subscribe_mgr_t *mgr, sub_elem_t *el)
+{
+    HASH_ADD_BYHASHVALUE(hh, mgr->ss, key, sizeof(sub_elem_key_t),
+                         key_hash(&el->key), el);
+}
+
+static void free_elem(sub_elem_t *el)
+{
+    utarray_foreach(el->apps, neu_app_subscribe_t *, sub_app)
+    {
+        neu_app_subscribe_fini(sub_app);
+    }
+    utarray_free(el->apps);
+    neu_intern_release(el->key.driver);
+    neu_intern_release(el->key.group);
+    free(el);
+}
+
 neu_subscribe_mgr_t *neu_subscribe_manager_create()
 {
     neu_subscribe_mgr_t *mgr = calloc(1, sizeof(neu_subscribe_mgr_t));
@@ -58,12 +99,7 @@ void neu_subscribe_manager_destroy(neu_subscribe_mgr_t *mgr)
     HASH_ITER(hh, mgr->ss, el, tmp)
     {
         HASH_DEL(mgr->ss, el);
-        utarray_foreach(el->apps, neu_app_subscribe_t *, sub_app)
-        {
-            neu_app_subscribe_fini(sub_app);
-        }
-        utarray_free(el->apps);
-        free(el);
+        free_elem(el);
     }
 
     free(mgr);
@@ -72,13 +108,7 @@ void neu_subscribe_manager_destroy(neu_subscribe_mgr_t *mgr)
 UT_array *neu_subscribe_manager_find(neu_subscribe_mgr_t *mgr,
                                      const char *driver, const char *group)
 {
-    sub_elem_t *   find = NULL;
-    sub_elem_key_t key  = { 0 };
-
-    strncpy(key.driver, driver, sizeof(key.driver));
-    strncpy(key.group, group, sizeof(key.group));
-
-    HASH_FIND(hh, mgr->ss, &key, sizeof(sub_elem_key_t), find);
+    sub_elem_t *find = find_elem(mgr, driver, group);
 
     if (find) {
         return utarray_clone(find->apps);
@@ -178,11 +208,8 @@ int neu_subscribe_manager_sub(neu_subscribe_mgr_t *mgr, const char *driver,
                               struct sockaddr_un addr)
 {
     sub_elem_t *        find    = NULL;
-    sub_elem_key_t      key     = { 0 };
     neu_app_subscribe_t app_sub = { 0 };
 
-    strncpy(key.driver, driver, sizeof(key.driver));
-    strncpy(key.group, group, sizeof(key.group));
     strncpy(app_sub.app_name, app, sizeof(app_sub.app_name));
     app_sub.addr = addr;
 
@@ -194,7 +221,7 @@ int neu_subscribe_manager_sub(neu_subscribe_mgr_t *mgr, const char *driver,
         return NEU_ERR_EINTERNAL;
     }
 
-    HASH_FIND(hh, mgr->ss, &key, sizeof(sub_elem_key_t), find);
+    find = find_elem(mgr, driver, group);
 
     if (find) {
         utarray_foreach(find->apps, neu_app_subscribe_t *, sub)
@@ -207,8 +234,14 @@ int neu_subscribe_manager_sub(neu_subscribe_mgr_t *mgr, const char *driver,
     } else {
         find = calloc(1, sizeof(sub_elem_t));
         utarray_new(find->apps, &app_sub_icd);
-        find->key = key;
-        HASH_ADD(hh, mgr->ss, key, sizeof(sub_elem_key_t), find);
+        find->key.driver = neu_intern(driver);
+        find->key.group  = neu_intern(group);
+        if (find->key.driver == NULL || find->key.group == NULL) {
+            neu_app_subscribe_fini(&app_sub);
+            free_elem(find);
+            return NEU_ERR_EINTERNAL;
+        }
+        add_elem(mgr, find);
     }
 
     utarray_push_back(find->apps, &app_sub);
@@ -220,12 +253,7 @@ int neu_subscribe_manager_update_params(neu_subscribe_mgr_t *mgr,
                                         const char *group, const char *params,
                                         const char *static_tags)
 {
-    sub_elem_key_t key = { 0 };
-    strncpy(key.driver, driver, sizeof(key.driver));
-    strncpy(key.group, group, sizeof(key.group));
-
-    sub_elem_t *find = NULL;
-    HASH_FIND(hh, mgr->ss, &key, sizeof(sub_elem_key_t), find);
+    sub_elem_t *find = find_elem(mgr, driver, group);
 
     if (NULL == find) {
         return NEU_ERR_GROUP_NOT_SUBSCRIBE;
@@ -264,13 +292,7 @@ int neu_subscribe_manager_update_params(neu_subscribe_mgr_t *mgr,
 int neu_subscribe_manager_unsub(neu_subscribe_mgr_t *mgr, const char *driver,
                                 const char *app, const char *group)
 {
-    sub_elem_t *   find = NULL;
-    sub_elem_key_t key  = { 0 };
-
-    strncpy(key.driver, driver, sizeof(key.driver));
-    strncpy(key.group, group, sizeof(key.group));
-
-    HASH_FIND(hh, mgr->ss, &key, sizeof(sub_elem_key_t), find);
+    sub_elem_t *find = find_elem(mgr, driver, group);
 
     if (find) {
         utarray_foreach(find->apps, neu_app_subscribe_t *, sub)
@@ -296,12 +318,7 @@ void neu_subscribe_manager_remove(neu_subscribe_mgr_t *mgr, const char *driver,
         if (strcmp(driver, el->key.driver) == 0 &&
             (group == NULL || strcmp(group, el->key.group) == 0)) {
             HASH_DEL(mgr->ss, el);
-            utarray_foreach(el->apps, neu_app_subscribe_t *, sub_app)
-            {
-                neu_app_subscribe_fini(sub_app);
-            }
-            utarray_free(el->apps);
-            free(el);
+            free_elem(el);
         }
     }
 }
@@ -329,16 +346,23 @@ int neu_subscribe_manager_update_driver_name(neu_subscribe_mgr_t *mgr,
                                              const char *         new_name)
 {
     sub_elem_t *el = NULL, *tmp = NULL;
+    const char *name = neu_intern(new_name);
+
+    if (name == NULL) {
+        return NEU_ERR_EINTERNAL;
+    }
 
     HASH_ITER(hh, mgr->ss, el, tmp)
     {
         if (strcmp(driver, el->key.driver) == 0) {
             HASH_DEL(mgr->ss, el);
-            strncpy(el->key.driver, new_name, sizeof(el->key.driver));
-            HASH_ADD(hh, mgr->ss, key, sizeof(sub_elem_key_t), el);
+            neu_intern_release(el->key.driver);
+            el->key.driver = neu_intern_ref(name);
+            add_elem(mgr, el);
         }
     }
 
+    neu_intern_release(name);
     return 0;
 }
 
@@ -347,21 +371,21 @@ int neu_subscribe_manager_update_group_name(neu_subscribe_mgr_t *mgr,
                                             const char *         group,
                                             const char *         new_name)
 {
-    sub_elem_t *   find = NULL;
-    sub_elem_key_t key  = { 0 };
-
-    strncpy(key.driver, driver, sizeof(key.driver));
-    strncpy(key.group, group, sizeof(key.group));
-
-    HASH_FIND(hh, mgr->ss, &key, sizeof(sub_elem_key_t), find);
+    sub_elem_t *find = find_elem(mgr, driver, group);
+    const char *name = NULL;
 
     if (NULL == find) {
         return NEU_ERR_GROUP_NOT_SUBSCRIBE;
     }
 
+    if (NULL == (name = neu_intern(new_name))) {
+        return NEU_ERR_EINTERNAL;
+    }
+
     HASH_DEL(mgr->ss, find);
-    strncpy(find->key.group, new_name, sizeof(find->key.group));
-    HASH_ADD(hh, mgr->ss, key, sizeof(sub_elem_key_t), find);
+    neu_intern_release(find->key.group);
+    find->key.group = name;
+    add_elem(mgr, find);
 
     return 0;
 }
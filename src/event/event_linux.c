@@ -232,7 +232,12 @@ neu_event_timer_t *neu_event_add_timer(neu_events_t *          events,
         .data.ptr = timer_ctx->event_data,
     };
 
-    timerfd_settime(timer_fd, 0, &value, NULL);
+    struct itimerspec first = value;
+    if (timer.delay > 0) {
+        first.it_value.tv_sec  = timer.delay / 1000;
+        first.it_value.tv_nsec = timer.delay % 1000 * 1000 * 1000;
+    }
+    timerfd_settime(timer_fd, 0, &first, NULL);
 
     timer_ctx->event_data->type           = TIMER;
     timer_ctx->event_data->fd             = timer_fd;
@@ -259,6 +264,22 @@ neu_event_timer_t *neu_event_add_timer(neu_events_t *          events,
     return timer_ctx;
 }
 
+int neu_event_delay_timer(neu_events_t *events, neu_event_timer_t *timer,
+                          int64_t millisecond)
+{
+    (void) events;
+
+    // a zero it_value disarms the timer
+    if (millisecond < 1) {
+        millisecond = 1;
+    }
+
+    // blocking timers are re-armed with `value` once the callback returns
+    timer->value.it_value.tv_sec  = millisecond / 1000;
+    timer->value.it_value.tv_nsec = millisecond % 1000 * 1000 * 1000;
+    return timerfd_settime(timer->fd, 0, &timer->value, NULL);
+}
+
 int neu_event_del_timer(neu_events_t *events, neu_event_timer_t *timer)
 {
     zlog_notice(neuron, "del timer: %d from epoll: %d, index: %d", timer->fd,
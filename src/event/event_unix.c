@@ -34,6 +34,8 @@ struct neu_event_timer {
     int                      id;
     void *                   usr_data;
     neu_event_timer_callback timer;
+    int64_t                  period;
+    bool                     once;
 };
 
 struct neu_event_io {
@@ -68,10 +70,22 @@ static void *event_loop(void *arg)
         }
 
         if (event.filter == EVFILT_TIMER) {
-            neu_event_timer_t *ctx = (neu_event_timer_t *) event.udata;
+            neu_event_timer_t *ctx  = (neu_event_timer_t *) event.udata;
+            bool               once = ctx->once;
 
-            ret = ctx->timer(ctx->usr_data);
+            ctx->once = false;
+            ret       = ctx->timer(ctx->usr_data);
             log_debug("timer trigger: %d, ret: %d", ctx->id, ret);
+
+            // a one-shot delay fired and was not re-delayed by the callback,
+            // fall back to the regular period
+            if (once && !ctx->once) {
+                struct kevent ke = { 0 };
+
+                EV_SET(&ke, ctx->id, EVFILT_TIMER, EV_ADD | EV_ENABLE, 0,
+                       ctx->period, ctx);
+                kevent(events->kq, &ke, 1, NULL, 0, NULL);
+            }
         }
 
         pthread_mutex_lock(&events->mtx);
@@ -120,18 +134,39 @@ neu_event_timer_t *neu_event_add_timer(neu_events_t *          events,
     ctx->id       = events->timer_id++;
     ctx->usr_data = timer.usr_data;
     ctx->timer    = timer.cb;
-
-    EV_SET(&ke, ctx->id, EVFILT_TIMER, EV_ADD | EV_ENABLE, 0,
-           timer.second * 1000 + timer.millisecond, ctx);
+    ctx->period   = timer.second * 1000 + timer.millisecond;
+    ctx->once     = timer.delay > 0;
+
+    if (ctx->once) {
+        EV_SET(&ke, ctx->id, EVFILT_TIMER, EV_ADD | EV_ENABLE | EV_ONESHOT, 0,
+               timer.delay, ctx);
+    } else {
+        EV_SET(&ke, ctx->id, EVFILT_TIMER, EV_ADD | EV_ENABLE, 0, ctx->period,
+               ctx);
+    }
 
     ret = kevent(events->kq, &ke, 1, NULL, 0, NULL);
 
-    log_info("add timer, second: %ld, millisecond: %ld, timer: %d in epoll %d, "
-             "ret: %d",
-             timer.second, timer.millisecond, ctx->id, events->kq, ret);
+    log_info("add timer, second: %ld, millisecond: %ld, delay: %ld, timer: %d "
+             "in kqueue %d, ret: %d",
+             timer.second, timer.millisecond, timer.delay, ctx->id, events->kq,
+             ret);
     return ctx;
 }
 
+int neu_event_delay_timer(neu_events_t *events, neu_event_timer_t *timer,
+                          int64_t millisecond)
+{
+    struct kevent ke = { 0 };
+
+    // fire once after `millisecond`, the event loop restores the period
+    timer->once = true;
+    EV_SET(&ke, timer->id, EVFILT_TIMER, EV_ADD | EV_ENABLE | EV_ONESHOT, 0,
+           millisecond < 1 ? 1 : millisecond, timer);
+
+    return kevent(events->kq, &ke, 1, NULL, 0, NULL);
+}
+
 int neu_event_del_timer(neu_events_t *events, neu_event_timer_t *timer)
 {
     struct kevent ke = { 0 };
@@ -27,6 +27,7 @@
 #include <sys/wait.h>
 #include <unistd.h>
 
+#include "adapter/driver/schedule.h"
 #include "core/manager.h"
 #include "utils/log.h"
 #include "utils/time.h"
@@ -35,15 +36,17 @@
 #include "daemon.h"
 #include "version.h"
 
-static bool           exit_flag         = false;
-static neu_manager_t *g_manager         = NULL;
-zlog_category_t *     neuron            = NULL;
-bool                  disable_jwt       = false;
-bool                  sub_filter_err    = false;
-int                   default_log_level = ZLOG_LEVEL_NOTICE;
-char                  host_port[32]     = { 0 };
-char                  g_status[32]      = { 0 };
-static bool           sig_trigger       = false;
+static bool           exit_flag           = false;
+static neu_manager_t *g_manager           = NULL;
+zlog_category_t *     neuron              = NULL;
+bool                  disable_jwt         = false;
+bool                  sub_filter_err      = false;
+size_t                tag_history_size    = 0;
+int                   read_overrun_policy = NEU_READ_OVERRUN_SKIP;
+int                   default_log_level   = ZLOG_LEVEL_NOTICE;
+char                  host_port[32]       = { 0 };
+char                  g_status[32]        = { 0 };
+static bool           sig_trigger         = false;
 
 int64_t global_timestamp = 0;
 
@@ -170,8 +173,10 @@ int main(int argc, char *argv[])
     global_timestamp = neu_time_ms();
     neu_cli_args_init(&args, argc, argv);
 
-    disable_jwt    = args.disable_auth;
-    sub_filter_err = args.sub_filter_err;
+    disable_jwt         = args.disable_auth;
+    sub_filter_err      = args.sub_filter_err;
+    tag_history_size    = args.tag_history;
+    read_overrun_policy = args.read_overrun;
     snprintf(host_port, sizeof(host_port), "http://%s:%d", args.ip, args.port);
 
     if (args.daemonized) {
@@ -199,6 +199,21 @@ int neu_json_decode_driver_fup_open_req(char *                           buf,
             .name = "path",
             .t    = NEU_JSON_STR,
         },
+        {
+            .name      = "window",
+            .t         = NEU_JSON_INT,
+            .attribute = NEU_JSON_ATTRIBUTE_OPTIONAL,
+        },
+        {
+            .name      = "offset",
+            .t         = NEU_JSON_INT,
+            .attribute = NEU_JSON_ATTRIBUTE_OPTIONAL,
+        },
+        {
+            .name      = "binary",
+            .t         = NEU_JSON_BOOL,
+            .attribute = NEU_JSON_ATTRIBUTE_OPTIONAL,
+        },
     };
 
     ret = neu_json_decode_by_json(json_obj, NEU_JSON_ELEM_SIZE(req_elems),
@@ -207,10 +222,24 @@ int neu_json_decode_driver_fup_open_req(char *                           buf,
         return -1;
     }
 
+    // without a window the upload is stop-and-wait
+    if ((req_elems[2].ok &&
+         (req_elems[2].v.val_int < 1 ||
+          req_elems[2].v.val_int > NEU_JSON_FUP_WINDOW_MAX)) ||
+        req_elems[3].v.val_int < 0) {
+        free(req_elems[0].v.val_str);
+        free(req_elems[1].v.val_str);
+        neu_json_decode_free(json_obj);
+        return -1;
+    }
+
     *result = calloc(1, sizeof(neu_json_driver_fup_open_req_t));
 
     (*result)->driver = req_elems[0].v.val_str;
     (*result)->path   = req_elems[1].v.val_str;
+    (*result)->window = req_elems[2].v.val_int;
+    (*result)->offset = req_elems[3].v.val_int;
+    (*result)->binary = req_elems[4].v.val_bool;
 
     neu_json_decode_free(json_obj);
     return ret;
@@ -335,6 +364,11 @@ int neu_json_decode_driver_fup_data_req(char *                           buf,
             .name = "path",
             .t    = NEU_JSON_STR,
         },
+        {
+            .name      = "offset",
+            .t         = NEU_JSON_INT,
+            .attribute = NEU_JSON_ATTRIBUTE_OPTIONAL,
+        },
     };
 
     ret = neu_json_decode_by_json(json_obj, NEU_JSON_ELEM_SIZE(req_elems),
@@ -347,6 +381,7 @@ int neu_json_decode_driver_fup_data_req(char *                           buf,
 
     (*result)->driver = req_elems[0].v.val_str;
     (*result)->path   = req_elems[1].v.val_str;
+    (*result)->offset = req_elems[2].v.val_int;
 
     neu_json_decode_free(json_obj);
     return ret;
@@ -393,10 +428,20 @@ int neu_json_encode_driver_fup_data_resp(void *json_object, void *param)
             .t            = NEU_JSON_OBJECT,
             .v.val_object = array,
         },
+        {
+            .name      = "seq",
+            .t         = NEU_JSON_INT,
+            .v.val_int = resp->seq,
+        },
+        {
+            .name      = "offset",
+            .t         = NEU_JSON_INT,
+            .v.val_int = resp->offset,
+        },
     };
+    int n_elem = NEU_JSON_ELEM_SIZE(resp_elems) - (resp->seq > 0 ? 0 : 2);
 
-    int ret = neu_json_encode_field(json_object, resp_elems,
-                                    NEU_JSON_ELEM_SIZE(resp_elems));
+    int ret = neu_json_encode_field(json_object, resp_elems, n_elem);
     return ret;
 }
 
@@ -416,10 +461,15 @@ int neu_json_encode_driver_fdown_data_resp(void *json_object, void *param)
             .t         = NEU_JSON_STR,
             .v.val_str = resp->src_path,
         },
+        {
+            .name      = "seq",
+            .t         = NEU_JSON_INT,
+            .v.val_int = resp->seq,
+        },
     };
+    int n_elem = NEU_JSON_ELEM_SIZE(resp_elems) - (resp->seq > 0 ? 0 : 1);
 
-    int ret = neu_json_encode_field(json_object, resp_elems,
-                                    NEU_JSON_ELEM_SIZE(resp_elems));
+    int ret = neu_json_encode_field(json_object, resp_elems, n_elem);
     return ret;
 }
 
@@ -446,6 +496,11 @@ int neu_json_decode_driver_fdown_data_req(
             .name = "data",
             .t    = NEU_JSON_ARRAY_UINT8,
         },
+        {
+            .name      = "seq",
+            .t         = NEU_JSON_INT,
+            .attribute = NEU_JSON_ATTRIBUTE_OPTIONAL,
+        },
     };
 
     ret = neu_json_decode_by_json(json_obj, NEU_JSON_ELEM_SIZE(req_elems),
@@ -461,6 +516,7 @@ int neu_json_decode_driver_fdown_data_req(
     (*result)->more     = req_elems[2].v.val_bool;
     (*result)->data     = req_elems[3].v.val_array_uint8.u8s;
     (*result)->len      = req_elems[3].v.val_array_uint8.length;
+    (*result)->seq      = req_elems[4].v.val_int;
 
     neu_json_decode_free(json_obj);
     return ret;
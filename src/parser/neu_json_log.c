@@ -46,6 +46,7 @@ int neu_json_decode_update_log_level_req(
 
     req->node_name = NULL;
     req->core      = true;
+    req->capture   = -1;
 
     neu_json_elem_t req_elems[] = {
         {
@@ -60,6 +61,10 @@ int neu_json_decode_update_log_level_req(
         {
             .name      = "core",
             .attribute = NEU_JSON_ATTRIBUTE_OPTIONAL,
+        },
+        {
+            .name      = "capture",
+            .attribute = NEU_JSON_ATTRIBUTE_OPTIONAL,
         }
     };
 
@@ -76,6 +81,9 @@ int neu_json_decode_update_log_level_req(
     if (req_elems[2].t == NEU_JSON_BOOL) {
         req->core = req_elems[2].v.val_bool;
     }
+    if (req_elems[3].t == NEU_JSON_BOOL) {
+        req->capture = req_elems[3].v.val_bool;
+    }
     *result = req;
     goto decode_exit;
 
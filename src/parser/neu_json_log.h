@@ -37,6 +37,7 @@ typedef struct {
     char *node_name;
     char *log_level;
     bool  core;
+    int   capture; // -1 if not given
 } neu_json_update_log_level_req_t;
 
 typedef struct {
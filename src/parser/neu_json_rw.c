@@ -35,6 +35,50 @@
 
 #include "json/neu_json_rw.h"
 
+static int read_resp_tag_elems(neu_json_read_resp_tag_t *p_tag,
+                               neu_json_elem_t *         tag_elems)
+{
+    int n = 2;
+
+    tag_elems[0].name      = "name";
+    tag_elems[0].t         = NEU_JSON_STR;
+    tag_elems[0].v.val_str = p_tag->name;
+
+    if (p_tag->error != 0) {
+        tag_elems[1].name      = "error";
+        tag_elems[1].t         = NEU_JSON_INT;
+        tag_elems[1].v.val_int = p_tag->error;
+    } else {
+        tag_elems[1].name      = "value";
+        tag_elems[1].t         = p_tag->t;
+        tag_elems[1].v         = p_tag->value;
+        tag_elems[1].precision = p_tag->precision;
+        tag_elems[1].bias      = p_tag->datatag.bias;
+
+        if (p_tag->t == NEU_JSON_FLOAT || p_tag->t == NEU_JSON_DOUBLE) {
+            tag_elems[n].name = "transferPrecision";
+            tag_elems[n].t    = NEU_JSON_INT;
+            tag_elems[n].v.val_int =
+                p_tag->precision > 0 ? p_tag->precision : 1;
+            n += 1;
+        }
+        if (p_tag->timestamp > 0) {
+            tag_elems[n].name      = "timestamp";
+            tag_elems[n].t         = NEU_JSON_INT;
+            tag_elems[n].v.val_int = p_tag->timestamp;
+            n += 1;
+        }
+    }
+
+    for (int k = 0; k < p_tag->n_meta; k++) {
+        tag_elems[n + k].name = p_tag->metas[k].name;
+        tag_elems[n + k].t    = p_tag->metas[k].t;
+        tag_elems[n + k].v    = p_tag->metas[k].value;
+    }
+
+    return n + p_tag->n_meta;
+}
+
 int neu_json_encode_read_resp(void *json_object, void *param)
 {
     int                   ret  = 0;
@@ -43,41 +87,10 @@ int neu_json_encode_read_resp(void *json_object, void *param)
     void *                    tag_array = neu_json_array();
     neu_json_read_resp_tag_t *p_tag     = resp->tags;
     for (int i = 0; i < resp->n_tag; i++) {
-        neu_json_elem_t tag_elems[2 + NEU_TAG_META_SIZE] = { 0 };
-        int             if_precision                     = 0;
+        neu_json_elem_t tag_elems[4 + NEU_TAG_META_SIZE] = { 0 };
 
-        tag_elems[0].name      = "name";
-        tag_elems[0].t         = NEU_JSON_STR;
-        tag_elems[0].v.val_str = p_tag->name;
-
-        if (p_tag->error != 0) {
-            tag_elems[1].name      = "error";
-            tag_elems[1].t         = NEU_JSON_INT;
-            tag_elems[1].v.val_int = p_tag->error;
-        } else {
-            tag_elems[1].name      = "value";
-            tag_elems[1].t         = p_tag->t;
-            tag_elems[1].v         = p_tag->value;
-            tag_elems[1].precision = p_tag->precision;
-            tag_elems[1].bias      = p_tag->datatag.bias;
-
-            if (p_tag->t == NEU_JSON_FLOAT || p_tag->t == NEU_JSON_DOUBLE) {
-                if_precision      = 1;
-                tag_elems[2].name = "transferPrecision";
-                tag_elems[2].t    = NEU_JSON_INT;
-                tag_elems[2].v.val_int =
-                    p_tag->precision > 0 ? p_tag->precision : 1;
-            }
-        }
-
-        for (int k = 0; k < p_tag->n_meta; k++) {
-            tag_elems[if_precision + 2 + k].name = p_tag->metas[k].name;
-            tag_elems[if_precision + 2 + k].t    = p_tag->metas[k].t;
-            tag_elems[if_precision + 2 + k].v    = p_tag->metas[k].value;
-        }
-
-        tag_array = neu_json_encode_array(tag_array, tag_elems,
-                                          2 + if_precision + p_tag->n_meta);
+        int n     = read_resp_tag_elems(p_tag, tag_elems);
+        tag_array = neu_json_encode_array(tag_array, tag_elems, n);
         p_tag++;
     }
 
@@ -92,86 +105,103 @@ int neu_json_encode_read_resp(void *json_object, void *param)
     return ret;
 }
 
-int neu_json_encode_read_paginate_resp(void *json_object, void *param)
+int neu_json_encode_read_resp_tag(void *json_object, void *param)
 {
-    int                            ret = 0;
-    neu_json_read_paginate_resp_t *resp =
-        (neu_json_read_paginate_resp_t *) param;
+    neu_json_read_resp_tag_t *p_tag = (neu_json_read_resp_tag_t *) param;
+    neu_json_elem_t           tag_elems[4 + NEU_TAG_META_SIZE] = { 0 };
 
-    void *                             tag_array = neu_json_array();
-    neu_json_read_paginate_resp_tag_t *p_tag     = resp->tags;
+    int n = read_resp_tag_elems(p_tag, tag_elems);
+    return neu_json_encode_field(json_object, tag_elems, n);
+}
 
-    for (int i = 0; i < resp->n_tag; i++) {
-        neu_json_elem_t tag_elems[10 + NEU_TAG_META_SIZE] = { 0 };
-        int             if_precision                      = 0;
+static int
+read_paginate_resp_tag_elems(neu_json_read_paginate_resp_tag_t *p_tag,
+                             neu_json_elem_t *                  tag_elems)
+{
+    int if_precision = 0;
 
-        tag_elems[0].name      = "name";
-        tag_elems[0].t         = NEU_JSON_STR;
-        tag_elems[0].v.val_str = p_tag->name;
+    tag_elems[0].name      = "name";
+    tag_elems[0].t         = NEU_JSON_STR;
+    tag_elems[0].v.val_str = p_tag->name;
 
-        tag_elems[1].name      = "type";
-        tag_elems[1].t         = NEU_JSON_INT;
-        tag_elems[1].v.val_int = p_tag->datatag.type;
+    tag_elems[1].name      = "type";
+    tag_elems[1].t         = NEU_JSON_INT;
+    tag_elems[1].v.val_int = p_tag->datatag.type;
 
-        tag_elems[2].name      = "address";
-        tag_elems[2].t         = NEU_JSON_STR;
-        tag_elems[2].v.val_str = p_tag->datatag.address;
+    tag_elems[2].name      = "address";
+    tag_elems[2].t         = NEU_JSON_STR;
+    tag_elems[2].v.val_str = p_tag->datatag.address;
 
-        tag_elems[3].name      = "attribute";
-        tag_elems[3].t         = NEU_JSON_INT;
-        tag_elems[3].v.val_int = p_tag->datatag.attribute;
+    tag_elems[3].name      = "attribute";
+    tag_elems[3].t         = NEU_JSON_INT;
+    tag_elems[3].v.val_int = p_tag->datatag.attribute;
 
-        tag_elems[4].name      = "description";
-        tag_elems[4].t         = NEU_JSON_STR;
-        tag_elems[4].v.val_str = p_tag->datatag.description;
+    tag_elems[4].name      = "description";
+    tag_elems[4].t         = NEU_JSON_STR;
+    tag_elems[4].v.val_str = p_tag->datatag.description;
 
-        tag_elems[5].name      = "precision";
-        tag_elems[5].t         = NEU_JSON_INT;
-        tag_elems[5].v.val_int = p_tag->datatag.precision;
+    tag_elems[5].name      = "precision";
+    tag_elems[5].t         = NEU_JSON_INT;
+    tag_elems[5].v.val_int = p_tag->datatag.precision;
 
-        tag_elems[6].name         = "decimal";
-        tag_elems[6].t            = NEU_JSON_DOUBLE;
-        tag_elems[6].v.val_double = p_tag->datatag.decimal;
+    tag_elems[6].name         = "decimal";
+    tag_elems[6].t            = NEU_JSON_DOUBLE;
+    tag_elems[6].v.val_double = p_tag->datatag.decimal;
 
-        tag_elems[7].name         = "bias";
-        tag_elems[7].t            = NEU_JSON_DOUBLE;
-        tag_elems[7].v.val_double = p_tag->datatag.bias;
+    tag_elems[7].name         = "bias";
+    tag_elems[7].t            = NEU_JSON_DOUBLE;
+    tag_elems[7].v.val_double = p_tag->datatag.bias;
 
-        if (p_tag->error != 0) {
-            tag_elems[8].name      = "error";
-            tag_elems[8].t         = NEU_JSON_INT;
-            tag_elems[8].v.val_int = p_tag->error;
-        } else {
-            tag_elems[8].name      = "value";
-            tag_elems[8].t         = p_tag->t;
-            tag_elems[8].v         = p_tag->value;
-            tag_elems[8].precision = p_tag->precision;
-            tag_elems[8].bias      = p_tag->datatag.bias;
-
-            if (p_tag->t == NEU_JSON_FLOAT || p_tag->t == NEU_JSON_DOUBLE) {
-                if_precision      = 1;
-                tag_elems[9].name = "transferPrecision";
-                tag_elems[9].t    = NEU_JSON_INT;
-                tag_elems[9].v.val_int =
-                    p_tag->precision > 0 ? p_tag->precision : 1;
-            }
+    if (p_tag->error != 0) {
+        tag_elems[8].name      = "error";
+        tag_elems[8].t         = NEU_JSON_INT;
+        tag_elems[8].v.val_int = p_tag->error;
+    } else {
+        tag_elems[8].name      = "value";
+        tag_elems[8].t         = p_tag->t;
+        tag_elems[8].v         = p_tag->value;
+        tag_elems[8].precision = p_tag->precision;
+        tag_elems[8].bias      = p_tag->datatag.bias;
+
+        if (p_tag->t == NEU_JSON_FLOAT || p_tag->t == NEU_JSON_DOUBLE) {
+            if_precision      = 1;
+            tag_elems[9].name = "transferPrecision";
+            tag_elems[9].t    = NEU_JSON_INT;
+            tag_elems[9].v.val_int =
+                p_tag->precision > 0 ? p_tag->precision : 1;
         }
+    }
 
-        void *attributes_object = neu_json_encode_new();
-        for (int k = 0; k < p_tag->n_meta; k++) {
-            neu_json_elem_t meta_elem = { 0 };
-            meta_elem.name            = p_tag->metas[k].name;
-            meta_elem.t               = p_tag->metas[k].t;
-            meta_elem.v               = p_tag->metas[k].value;
-            neu_json_encode_field(attributes_object, &meta_elem, 1);
-        }
+    void *attributes_object = neu_json_encode_new();
+    for (int k = 0; k < p_tag->n_meta; k++) {
+        neu_json_elem_t meta_elem = { 0 };
+        meta_elem.name            = p_tag->metas[k].name;
+        meta_elem.t               = p_tag->metas[k].t;
+        meta_elem.v               = p_tag->metas[k].value;
+        neu_json_encode_field(attributes_object, &meta_elem, 1);
+    }
 
-        tag_elems[if_precision + 9].name         = "attributes";
-        tag_elems[if_precision + 9].t            = NEU_JSON_OBJECT;
-        tag_elems[if_precision + 9].v.val_object = attributes_object;
+    tag_elems[if_precision + 9].name         = "attributes";
+    tag_elems[if_precision + 9].t            = NEU_JSON_OBJECT;
+    tag_elems[if_precision + 9].v.val_object = attributes_object;
 
-        tag_array =
-            neu_json_encode_array(tag_array, tag_elems, 10 + if_precision);
+    return 10 + if_precision;
+}
+
+int neu_json_encode_read_paginate_resp(void *json_object, void *param)
+{
+    int                            ret = 0;
+    neu_json_read_paginate_resp_t *resp =
+        (neu_json_read_paginate_resp_t *) param;
+
+    void *                             tag_array = neu_json_array();
+    neu_json_read_paginate_resp_tag_t *p_tag     = resp->tags;
+
+    for (int i = 0; i < resp->n_tag; i++) {
+        neu_json_elem_t tag_elems[11] = { 0 };
+
+        int n     = read_paginate_resp_tag_elems(p_tag, tag_elems);
+        tag_array = neu_json_encode_array(tag_array, tag_elems, n);
 
         free(p_tag->datatag.name);
         free(p_tag->datatag.address);
@@ -180,17 +210,8 @@ int neu_json_encode_read_paginate_resp(void *json_object, void *param)
         p_tag++;
     }
 
-    void *          meta_object  = neu_json_encode_new();
-    neu_json_elem_t meta_elems[] = {
-        { .name      = "currentPage",
-          .t         = NEU_JSON_INT,
-          .v.val_int = resp->meta.current_page },
-        { .name      = "pageSize",
-          .t         = NEU_JSON_INT,
-          .v.val_int = resp->meta.page_size },
-        { .name = "total", .t = NEU_JSON_INT, .v.val_int = resp->meta.total }
-    };
-    neu_json_encode_field(meta_object, meta_elems, 3);
+    void *meta_object = neu_json_encode_new();
+    neu_json_encode_read_meta_resp(meta_object, &resp->meta);
 
     neu_json_elem_t resp_elems[] = {
         { .name = "meta", .t = NEU_JSON_OBJECT, .v.val_object = meta_object },
@@ -201,6 +222,33 @@ int neu_json_encode_read_paginate_resp(void *json_object, void *param)
     return ret;
 }
 
+int neu_json_encode_read_paginate_resp_tag(void *json_object, void *param)
+{
+    neu_json_read_paginate_resp_tag_t *p_tag =
+        (neu_json_read_paginate_resp_tag_t *) param;
+    neu_json_elem_t tag_elems[11] = { 0 };
+
+    int n = read_paginate_resp_tag_elems(p_tag, tag_elems);
+    return neu_json_encode_field(json_object, tag_elems, n);
+}
+
+int neu_json_encode_read_meta_resp(void *json_object, void *param)
+{
+    neu_json_read_meta_resp_t *meta = (neu_json_read_meta_resp_t *) param;
+    neu_json_elem_t            meta_elems[] = {
+        { .name      = "currentPage",
+          .t         = NEU_JSON_INT,
+          .v.val_int = meta->current_page },
+        { .name      = "pageSize",
+          .t         = NEU_JSON_INT,
+          .v.val_int = meta->page_size },
+        { .name = "total", .t = NEU_JSON_INT, .v.val_int = meta->total }
+    };
+
+    return neu_json_encode_field(json_object, meta_elems,
+                                 NEU_JSON_ELEM_SIZE(meta_elems));
+}
+
 int neu_json_encode_test_read_tag_resp(void *json_object, void *param)
 {
     int                       ret       = 0;
@@ -226,14 +274,88 @@ int neu_json_encode_test_read_tag_resp(void *json_object, void *param)
     return ret;
 }
 
+int neu_json_encode_read_history_resp(void *json_object, void *param)
+{
+    int                           ret = 0;
+    neu_json_read_history_resp_t *resp =
+        (neu_json_read_history_resp_t *) param;
+
+    void *                  tag_array = neu_json_array();
+    neu_json_history_tag_t *p_tag     = resp->tags;
+    for (int i = 0; i < resp->n_tag; i++) {
+        neu_json_elem_t tag_elems[2] = { 0 };
+
+        tag_elems[0].name      = "name";
+        tag_elems[0].t         = NEU_JSON_STR;
+        tag_elems[0].v.val_str = p_tag->name;
+
+        if (p_tag->error != 0) {
+            tag_elems[1].name      = "error";
+            tag_elems[1].t         = NEU_JSON_INT;
+            tag_elems[1].v.val_int = p_tag->error;
+        } else {
+            void *point_array = neu_json_array();
+
+            for (int k = 0; k < p_tag->n_point; k++) {
+                neu_json_history_point_t *p = &p_tag->points[k];
+                neu_json_elem_t point_elems[] = {
+                    {
+                        .name      = "timestamp",
+                        .t         = NEU_JSON_INT,
+                        .v.val_int = p->timestamp,
+                    },
+                    {
+                        .name         = "value",
+                        .t            = NEU_JSON_DOUBLE,
+                        .v.val_double = p->value,
+                    },
+                    {
+                        .name         = "min",
+                        .t            = NEU_JSON_DOUBLE,
+                        .v.val_double = p->min,
+                    },
+                    {
+                        .name         = "max",
+                        .t            = NEU_JSON_DOUBLE,
+                        .v.val_double = p->max,
+                    },
+                };
+
+                point_array = neu_json_encode_array(
+                    point_array, point_elems,
+                    resp->downsampled ? NEU_JSON_ELEM_SIZE(point_elems) : 2);
+            }
+
+            tag_elems[1].name         = "points";
+            tag_elems[1].t            = NEU_JSON_OBJECT;
+            tag_elems[1].v.val_object = point_array;
+        }
+
+        tag_array = neu_json_encode_array(tag_array, tag_elems,
+                                          NEU_JSON_ELEM_SIZE(tag_elems));
+        p_tag++;
+    }
+
+    neu_json_elem_t resp_elems[] = { {
+        .name         = "tags",
+        .t            = NEU_JSON_OBJECT,
+        .v.val_object = tag_array,
+    } };
+    ret = neu_json_encode_field(json_object, resp_elems,
+                                NEU_JSON_ELEM_SIZE(resp_elems));
+
+    return ret;
+}
+
 int neu_json_encode_read_resp1(void *json_object, void *param)
 {
     int                   ret  = 0;
     neu_json_read_resp_t *resp = (neu_json_read_resp_t *) param;
 
-    void *values = neu_json_encode_new();
-    void *errors = neu_json_encode_new();
-    void *metas  = neu_json_encode_new();
+    void *values     = neu_json_encode_new();
+    void *errors     = neu_json_encode_new();
+    void *metas      = neu_json_encode_new();
+    void *timestamps = neu_json_encode_new();
 
     neu_json_read_resp_tag_t *p_tag = resp->tags;
     for (int i = 0; i < resp->n_tag; i++) {
@@ -246,6 +368,15 @@ int neu_json_encode_read_resp1(void *json_object, void *param)
             tag_elem.precision = p_tag->precision;
             tag_elem.bias      = p_tag->datatag.bias;
             neu_json_encode_field(values, &tag_elem, 1);
+
+            if (p_tag->timestamp > 0) {
+                neu_json_elem_t ts_elem = {
+                    .name      = p_tag->name,
+                    .t         = NEU_JSON_INT,
+                    .v.val_int = p_tag->timestamp,
+                };
+                neu_json_encode_field(timestamps, &ts_elem, 1);
+            }
         } else {
             tag_elem.name      = p_tag->name;
             tag_elem.t         = NEU_JSON_INT;
@@ -291,6 +422,11 @@ int neu_json_encode_read_resp1(void *json_object, void *param)
             .v.val_object = metas,
 
         },
+        {
+            .name         = "timestamps",
+            .t            = NEU_JSON_OBJECT,
+            .v.val_object = timestamps,
+        },
     };
 
     ret = neu_json_encode_field(json_object, resp_elems,
@@ -306,7 +442,8 @@ int neu_json_encode_read_resp2(void *json_object, void *param)
     void *                    tag_array = neu_json_array();
     neu_json_read_resp_tag_t *p_tag     = resp->tags;
     for (int i = 0; i < resp->n_tag; i++) {
-        neu_json_elem_t tag_elems[2 + NEU_TAG_META_SIZE] = { 0 };
+        neu_json_elem_t tag_elems[3 + NEU_TAG_META_SIZE] = { 0 };
+        int             n                                = 2;
 
         tag_elems[0].name      = "name";
         tag_elems[0].t         = NEU_JSON_STR;
@@ -321,16 +458,23 @@ int neu_json_encode_read_resp2(void *json_object, void *param)
             tag_elems[1].t         = p_tag->t;
             tag_elems[1].v         = p_tag->value;
             tag_elems[1].precision = p_tag->precision;
+
+            if (p_tag->timestamp > 0) {
+                tag_elems[n].name      = "timestamp";
+                tag_elems[n].t         = NEU_JSON_INT;
+                tag_elems[n].v.val_int = p_tag->timestamp;
+                n += 1;
+            }
         }
 
         for (int k = 0; k < p_tag->n_meta; k++) {
-            tag_elems[2 + k].name = p_tag->metas[k].name;
-            tag_elems[2 + k].t    = p_tag->metas[k].t;
-            tag_elems[2 + k].v    = p_tag->metas[k].value;
+            tag_elems[n + k].name = p_tag->metas[k].name;
+            tag_elems[n + k].t    = p_tag->metas[k].t;
+            tag_elems[n + k].v    = p_tag->metas[k].value;
         }
 
         tag_array =
-            neu_json_encode_array(tag_array, tag_elems, 2 + p_tag->n_meta);
+            neu_json_encode_array(tag_array, tag_elems, n + p_tag->n_meta);
         p_tag++;
     }
 
@@ -1077,6 +1221,97 @@ void neu_json_decode_test_read_tag_req_free(neu_json_test_read_tag_req_t *req)
     free(req);
 }
 
+int neu_json_decode_read_history_req(char *                        buf,
+                                     neu_json_read_history_req_t **result)
+{
+    int   ret      = 0;
+    void *json_obj = NULL;
+
+    json_obj = neu_json_decode_new(buf);
+    if (NULL == json_obj) {
+        return -1;
+    }
+
+    neu_json_read_history_req_t *req =
+        calloc(1, sizeof(neu_json_read_history_req_t));
+    if (req == NULL) {
+        neu_json_decode_free(json_obj);
+        return -1;
+    }
+
+    neu_json_elem_t req_elems[] = {
+        {
+            .name = "node",
+            .t    = NEU_JSON_STR,
+        },
+        {
+            .name = "group",
+            .t    = NEU_JSON_STR,
+        },
+        {
+            .name = "start",
+            .t    = NEU_JSON_INT,
+        },
+        {
+            .name = "end",
+            .t    = NEU_JSON_INT,
+        },
+        {
+            .name      = "buckets",
+            .t         = NEU_JSON_INT,
+            .attribute = NEU_JSON_ATTRIBUTE_OPTIONAL,
+        },
+        {
+            .name                   = "tags",
+            .t                      = NEU_JSON_ARRAY_STR,
+            .attribute              = NEU_JSON_ATTRIBUTE_OPTIONAL,
+            .v.val_array_str.length = 0,
+            .v.val_array_str.p_strs = NULL,
+        },
+    };
+
+    ret = neu_json_decode_by_json(json_obj, NEU_JSON_ELEM_SIZE(req_elems),
+                                  req_elems);
+    if (ret != 0) {
+        goto error;
+    }
+
+    req->node    = req_elems[0].v.val_str;
+    req->group   = req_elems[1].v.val_str;
+    req->start   = req_elems[2].v.val_int;
+    req->end     = req_elems[3].v.val_int;
+    req->buckets = req_elems[4].v.val_int;
+    req->n_tags  = req_elems[5].v.val_array_str.length;
+    req->tags    = req_elems[5].v.val_array_str.p_strs;
+
+    *result = req;
+    neu_json_decode_free(json_obj);
+    return ret;
+
+error:
+    free(req_elems[0].v.val_str);
+    free(req_elems[1].v.val_str);
+    free(req);
+    if (json_obj != NULL) {
+        neu_json_decode_free(json_obj);
+    }
+    return ret;
+}
+
+void neu_json_decode_read_history_req_free(neu_json_read_history_req_t *req)
+{
+    free(req->group);
+    free(req->node);
+    if (req->n_tags > 0) {
+        for (int i = 0; i < req->n_tags; i++) {
+            free(req->tags[i]);
+        }
+        free(req->tags);
+    }
+
+    free(req);
+}
+
 int neu_json_encode_read_periodic_resp(void *json_object, void *param)
 {
     int                       ret  = 0;
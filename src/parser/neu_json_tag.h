@@ -105,7 +105,7 @@ int neu_json_decode_add_gtags_req(char *buf, neu_json_add_gtags_req_t **result);
 void neu_json_decode_add_gtags_req_free(neu_json_add_gtags_req_t *req);
 
 typedef struct {
-    uint16_t index;
+    uint32_t index;
     int      error;
 } neu_json_add_gtag_res_t, neu_json_update_gtag_res_t;
 
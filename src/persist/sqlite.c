@@ -23,12 +23,14 @@
 
 #include <dirent.h>
 #include <errno.h>
+#include <pthread.h>
 #include <sys/types.h>
 
 #include <sqlite3.h>
 
 #include "errcodes.h"
 #include "utils/log.h"
+#include "utils/time.h"
 
 #include "sqlite.h"
 
@@ -42,6 +44,121 @@
 
 #define DB_FILE "persistence/sqlite.db"
 
+// commit the pending commands once this many rows are queued
+#define BATCH_ROWS 4096
+// or once the oldest pending command has waited this long
+#define BATCH_WINDOW_MS 200
+// producers block when this many rows are pending
+#define QUEUE_MAX_ROWS (16 * BATCH_ROWS)
+
+typedef enum {
+    SQLITE_CMD_STORE_NODE,
+    SQLITE_CMD_DELETE_NODE,
+    SQLITE_CMD_UPDATE_NODE,
+    SQLITE_CMD_UPDATE_NODE_STATE,
+    SQLITE_CMD_STORE_TAG,
+    SQLITE_CMD_UPDATE_TAG,
+    SQLITE_CMD_UPDATE_TAG_VALUE,
+    SQLITE_CMD_DELETE_TAG,
+    SQLITE_CMD_STORE_SUBSCRIPTION,
+    SQLITE_CMD_UPDATE_SUBSCRIPTION,
+    SQLITE_CMD_DELETE_SUBSCRIPTION,
+    SQLITE_CMD_STORE_GROUP,
+    SQLITE_CMD_UPDATE_GROUP_NAME,
+    SQLITE_CMD_UPDATE_GROUP_INTERVAL,
+    SQLITE_CMD_DELETE_GROUP,
+    SQLITE_CMD_STORE_NODE_SETTING,
+    SQLITE_CMD_DELETE_NODE_SETTING,
+    SQLITE_CMD_STORE_USER,
+    SQLITE_CMD_UPDATE_USER,
+    SQLITE_CMD_DELETE_USER,
+    SQLITE_CMD_MAX,
+} sqlite_cmd_type_e;
+
+// `args` describes how the command arguments bind to the statement
+// parameters in order, `s` takes the next string, `i` the next integer.
+// Tag store/update commands bind the tag fields instead.
+static const struct {
+    const char *sql;
+    const char *args;
+} g_cmd_sql[SQLITE_CMD_MAX] = {
+    [SQLITE_CMD_STORE_NODE] = { "INSERT INTO nodes (name, type, state, "
+                                "plugin_name) VALUES (?, ?, ?, ?)",
+                                "siis" },
+    [SQLITE_CMD_DELETE_NODE]       = { "DELETE FROM nodes WHERE name=?", "s" },
+    [SQLITE_CMD_UPDATE_NODE]       = { "UPDATE nodes SET name=? WHERE name=?",
+                                 "ss" },
+    [SQLITE_CMD_UPDATE_NODE_STATE] = { "UPDATE nodes SET state=? WHERE name=?",
+                                       "is" },
+    [SQLITE_CMD_STORE_TAG] = { "INSERT INTO tags ("
+                               " driver_name, group_name, name, address,"
+                               " attribute, precision, type, decimal, bias,"
+                               " description, value, format"
+                               ") VALUES (?1, ?2, ?3, ?4, ?5, ?6, ?7, ?8, ?9,"
+                               " ?10, ?11, ?12)",
+                               NULL },
+    [SQLITE_CMD_UPDATE_TAG] = { "UPDATE tags SET"
+                                " address=?4, attribute=?5, precision=?6,"
+                                " type=?7, decimal=?8, bias=?9,"
+                                " description=?10, value='' "
+                                "WHERE driver_name=?1 AND group_name=?2 AND"
+                                " name=?3",
+                                NULL },
+    [SQLITE_CMD_UPDATE_TAG_VALUE] = { "UPDATE tags SET value='' WHERE "
+                                      "driver_name=? AND group_name=? AND "
+                                      "name=?",
+                                      "sss" },
+    [SQLITE_CMD_DELETE_TAG]       = { "DELETE FROM tags WHERE driver_name=? "
+                                "AND group_name=? AND name=?",
+                                "sss" },
+    [SQLITE_CMD_STORE_SUBSCRIPTION] = { "INSERT INTO subscriptions (app_name, "
+                                        "driver_name, group_name, params, "
+                                        "static_tags) VALUES (?, ?, ?, ?, ?)",
+                                        "sssss" },
+    [SQLITE_CMD_UPDATE_SUBSCRIPTION] = { "UPDATE subscriptions SET params=?, "
+                                         "static_tags=? WHERE app_name=? AND "
+                                         "driver_name=? AND group_name=?",
+                                         "sssss" },
+    [SQLITE_CMD_DELETE_SUBSCRIPTION] = { "DELETE FROM subscriptions WHERE "
+                                         "app_name=? AND driver_name=? AND "
+                                         "group_name=?",
+                                         "sss" },
+    [SQLITE_CMD_STORE_GROUP] = { "INSERT INTO groups (driver_name, name, "
+                                 "interval, context) VALUES (?, ?, ?, ?)",
+                                 "ssis" },
+    [SQLITE_CMD_UPDATE_GROUP_NAME] = { "UPDATE groups SET name=? WHERE "
+                                       "driver_name=? AND name=?",
+                                       "sss" },
+    [SQLITE_CMD_UPDATE_GROUP_INTERVAL] = { "UPDATE groups SET interval=? "
+                                           "WHERE driver_name=? AND name=?",
+                                           "iss" },
+    [SQLITE_CMD_DELETE_GROUP] = { "DELETE FROM groups WHERE driver_name=? AND "
+                                  "name=?",
+                                  "ss" },
+    [SQLITE_CMD_STORE_NODE_SETTING] = { "INSERT OR REPLACE INTO settings "
+                                        "(node_name, setting) VALUES (?, ?)",
+                                        "ss" },
+    [SQLITE_CMD_DELETE_NODE_SETTING] = { "DELETE FROM settings WHERE "
+                                         "node_name=?",
+                                         "s" },
+    [SQLITE_CMD_STORE_USER]  = { "INSERT INTO users (name, password) VALUES "
+                                "(?, ?)",
+                                "ss" },
+    [SQLITE_CMD_UPDATE_USER] = { "UPDATE users SET password=? WHERE name=?",
+                                 "ss" },
+    [SQLITE_CMD_DELETE_USER] = { "DELETE FROM users WHERE name=?", "s" },
+};
+
+struct sqlite_cmd {
+    sqlite_cmd_type_e type;
+    char *            str[5];
+    int64_t           num[2];
+    neu_datatag_t *   tags;
+    size_t            n_tags;
+    int *             result; // set for synchronous commands
+    sqlite_cmd_t *    next;
+};
+
 static inline bool ends_with(const char *str, const char *suffix)
 {
     size_t m = strlen(str);
@@ -408,6 +525,428 @@ static inline int open_db(const char *schema_dir, sqlite3 **db_p)
     return 0;
 }
 
+static inline int open_write_db(sqlite3 **db_p)
+{
+    sqlite3 *db = NULL;
+    int      rv = sqlite3_open(DB_FILE, &db);
+    if (SQLITE_OK != rv) {
+        nlog_fatal("db `%s` fail: %s", DB_FILE, sqlite3_errstr(rv));
+        return -1;
+    }
+    sqlite3_busy_timeout(db, 100 * 1000);
+
+    rv = sqlite3_exec(db, "PRAGMA foreign_keys=ON", NULL, NULL, NULL);
+    if (rv != SQLITE_OK) {
+        nlog_fatal("db foreign key support fail: %s", sqlite3_errmsg(db));
+        sqlite3_close(db);
+        return -1;
+    }
+
+    *db_p = db;
+    return 0;
+}
+
+static sqlite_cmd_t *sqlite_cmd_new(sqlite_cmd_type_e type)
+{
+    sqlite_cmd_t *cmd = calloc(1, sizeof(*cmd));
+    if (NULL == cmd) {
+        nlog_error("malloc fail");
+        return NULL;
+    }
+    cmd->type = type;
+    return cmd;
+}
+
+static void sqlite_cmd_free(sqlite_cmd_t *cmd)
+{
+    for (size_t i = 0; i < sizeof(cmd->str) / sizeof(cmd->str[0]); ++i) {
+        free(cmd->str[i]);
+    }
+    for (size_t i = 0; i < cmd->n_tags; ++i) {
+        neu_tag_fini(&cmd->tags[i]);
+    }
+    free(cmd->tags);
+    free(cmd);
+}
+
+// create a command with string arguments, NULL stays NULL
+static sqlite_cmd_t *str_cmd(sqlite_cmd_type_e type, int n, ...)
+{
+    sqlite_cmd_t *cmd = sqlite_cmd_new(type);
+    if (NULL == cmd) {
+        return NULL;
+    }
+
+    va_list args;
+    va_start(args, n);
+    for (int i = 0; i < n; ++i) {
+        const char *str = va_arg(args, const char *);
+        if (NULL != str && NULL == (cmd->str[i] = strdup(str))) {
+            nlog_error("strdup fail");
+            sqlite_cmd_free(cmd);
+            cmd = NULL;
+            break;
+        }
+    }
+    va_end(args);
+
+    return cmd;
+}
+
+static sqlite_cmd_t *tag_cmd(sqlite_cmd_type_e type, const char *driver_name,
+                             const char *         group_name,
+                             const neu_datatag_t *tags, size_t n)
+{
+    sqlite_cmd_t *cmd = str_cmd(type, 2, driver_name, group_name);
+    if (NULL == cmd) {
+        return NULL;
+    }
+
+    cmd->tags = calloc(n, sizeof(*tags));
+    if (NULL == cmd->tags) {
+        nlog_error("malloc fail");
+        sqlite_cmd_free(cmd);
+        return NULL;
+    }
+
+    for (size_t i = 0; i < n; ++i) {
+        neu_tag_copy(&cmd->tags[i], &tags[i]);
+    }
+    cmd->n_tags = n;
+
+    return cmd;
+}
+
+static inline size_t sqlite_cmd_rows(const sqlite_cmd_t *cmd)
+{
+    return cmd->n_tags > 0 ? cmd->n_tags : 1;
+}
+
+// should be called with the queue lock held
+static void wait_done(neu_sqlite_persister_t *persister, uint64_t seq)
+{
+    if (persister->seq_flush < seq) {
+        persister->seq_flush = seq;
+        pthread_cond_signal(&persister->cond);
+    }
+    while (persister->seq_done < seq) {
+        pthread_cond_wait(&persister->done_cond, &persister->mtx);
+    }
+}
+
+/**
+ * Queue a command for the persistence thread, takes ownership of `cmd`.
+ *
+ * @param sync  wait until the command is committed and return its result.
+ */
+static int sqlite_cmd_submit(neu_sqlite_persister_t *persister,
+                             sqlite_cmd_t *cmd, bool sync)
+{
+    int rv = 0;
+
+    if (sync) {
+        cmd->result = &rv;
+    }
+
+    pthread_mutex_lock(&persister->mtx);
+
+    // back pressure on bulk producers
+    while (persister->n_rows >= QUEUE_MAX_ROWS && !persister->stop) {
+        pthread_cond_wait(&persister->done_cond, &persister->mtx);
+    }
+
+    if (NULL == persister->tail) {
+        persister->head = cmd;
+    } else {
+        persister->tail->next = cmd;
+    }
+    persister->tail = cmd;
+    persister->n_rows += sqlite_cmd_rows(cmd);
+    uint64_t seq = ++persister->seq_queued;
+    pthread_cond_signal(&persister->cond);
+
+    if (sync) {
+        wait_done(persister, seq);
+    }
+
+    pthread_mutex_unlock(&persister->mtx);
+    return rv;
+}
+
+/*
+ * Configuration changes are submitted with `sync` so that their callers get
+ * the result of the write, concurrent ones still share a transaction. Only
+ * node states and tag values are written behind.
+ */
+static inline int persist_cmd(neu_persister_t *self, sqlite_cmd_t *cmd,
+                              bool sync)
+{
+    if (NULL == cmd) {
+        return NEU_ERR_EINTERNAL;
+    }
+    return sqlite_cmd_submit((neu_sqlite_persister_t *) self, cmd, sync);
+}
+
+static sqlite3_stmt *get_stmt(neu_sqlite_persister_t *persister,
+                              sqlite_cmd_type_e       type)
+{
+    sqlite3_stmt *stmt = persister->stmts[type];
+    if (NULL == stmt) {
+        const char *query = g_cmd_sql[type].sql;
+        if (SQLITE_OK !=
+            sqlite3_prepare_v2(persister->wdb, query, -1, &stmt, NULL)) {
+            nlog_error("prepare `%s` fail: %s", query,
+                       sqlite3_errmsg(persister->wdb));
+            return NULL;
+        }
+        persister->stmts[type] = stmt;
+    }
+    return stmt;
+}
+
+static int bind_args(sqlite3 *db, sqlite3_stmt *stmt, const sqlite_cmd_t *cmd)
+{
+    const char *args  = g_cmd_sql[cmd->type].args;
+    int         i_str = 0, i_num = 0;
+
+    for (int i = 0; args[i]; ++i) {
+        int rv = 's' == args[i]
+            ? sqlite3_bind_text(stmt, i + 1, cmd->str[i_str++], -1, NULL)
+            : sqlite3_bind_int64(stmt, i + 1, cmd->num[i_num++]);
+        if (SQLITE_OK != rv) {
+            nlog_error("bind `%s` arg %d fail: %s", g_cmd_sql[cmd->type].sql,
+                       i + 1, sqlite3_errmsg(db));
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+static int bind_tag(sqlite3 *db, sqlite3_stmt *stmt, const neu_datatag_t *tag,
+                    bool store)
+{
+    int rv = SQLITE_OK;
+
+    if (SQLITE_OK != (rv = sqlite3_bind_text(stmt, 3, tag->name, -1, NULL)) ||
+        SQLITE_OK !=
+            (rv = sqlite3_bind_text(stmt, 4, tag->address, -1, NULL)) ||
+        SQLITE_OK != (rv = sqlite3_bind_int(stmt, 5, tag->attribute)) ||
+        SQLITE_OK != (rv = sqlite3_bind_int(stmt, 6, tag->precision)) ||
+        SQLITE_OK != (rv = sqlite3_bind_int(stmt, 7, tag->type)) ||
+        SQLITE_OK != (rv = sqlite3_bind_double(stmt, 8, tag->decimal)) ||
+        SQLITE_OK != (rv = sqlite3_bind_double(stmt, 9, tag->bias)) ||
+        SQLITE_OK !=
+            (rv = sqlite3_bind_text(stmt, 10, tag->description, -1, NULL))) {
+        nlog_error("bind tag `%s` fail: %s", tag->name, sqlite3_errmsg(db));
+        return -1;
+    }
+
+    if (store) {
+        char format_buf[128] = { 0 };
+        if (tag->n_format > 0) {
+            neu_tag_format_str(tag, format_buf, sizeof(format_buf));
+        }
+
+        if (SQLITE_OK != sqlite3_bind_null(stmt, 11) ||
+            SQLITE_OK !=
+                sqlite3_bind_text(stmt, 12, format_buf, -1, SQLITE_TRANSIENT)) {
+            nlog_error("bind tag `%s` fail: %s", tag->name, sqlite3_errmsg(db));
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+static inline int step_stmt(sqlite3 *db, sqlite3_stmt *stmt)
+{
+    int rv = 0;
+    if (SQLITE_DONE != sqlite3_step(stmt)) {
+        nlog_error("query `%s` fail: %s", sqlite3_sql(stmt),
+                   sqlite3_errmsg(db));
+        rv = NEU_ERR_EINTERNAL;
+    }
+    sqlite3_reset(stmt);
+    return rv;
+}
+
+static int exec_cmd(neu_sqlite_persister_t *persister, const sqlite_cmd_t *cmd)
+{
+    sqlite3 *     db   = persister->wdb;
+    sqlite3_stmt *stmt = get_stmt(persister, cmd->type);
+    int           rv   = 0;
+
+    if (NULL == stmt) {
+        return NEU_ERR_EINTERNAL;
+    }
+
+    if (SQLITE_CMD_STORE_TAG == cmd->type ||
+        SQLITE_CMD_UPDATE_TAG == cmd->type) {
+        bool store = SQLITE_CMD_STORE_TAG == cmd->type;
+
+        if (SQLITE_OK != sqlite3_bind_text(stmt, 1, cmd->str[0], -1, NULL) ||
+            SQLITE_OK != sqlite3_bind_text(stmt, 2, cmd->str[1], -1, NULL)) {
+            nlog_error("bind driver:%s group:%s fail: %s", cmd->str[0],
+                       cmd->str[1], sqlite3_errmsg(db));
+            rv = NEU_ERR_EINTERNAL;
+        }
+
+        for (size_t i = 0; 0 == rv && i < cmd->n_tags; ++i) {
+            if (0 != bind_tag(db, stmt, &cmd->tags[i], store)) {
+                rv = NEU_ERR_EINTERNAL;
+            } else {
+                rv = step_stmt(db, stmt);
+            }
+        }
+    } else if (0 != bind_args(db, stmt, cmd)) {
+        rv = NEU_ERR_EINTERNAL;
+    } else {
+        rv = step_stmt(db, stmt);
+    }
+
+    sqlite3_clear_bindings(stmt);
+    return rv;
+}
+
+/**
+ * Execute a batch of commands in one transaction.
+ *
+ * Every command runs in its own savepoint, a failing command is rolled back
+ * as a whole and reported individually, unless the failure makes SQLite
+ * roll back the whole transaction.
+ *
+ * @return number of commands in the batch.
+ */
+static uint64_t exec_batch(neu_sqlite_persister_t *persister,
+                           sqlite_cmd_t *          batch)
+{
+    sqlite3 *db     = persister->wdb;
+    uint64_t n_cmds = 0;
+    size_t   n_tags = 0;
+    int64_t  start  = neu_time_ms();
+
+    bool txn = SQLITE_OK == sqlite3_exec(db, "BEGIN", NULL, NULL, NULL);
+    if (!txn) {
+        nlog_error("begin transaction fail: %s", sqlite3_errmsg(db));
+    }
+
+    for (sqlite_cmd_t *cmd = batch; NULL != cmd; cmd = cmd->next) {
+        // outside of a transaction the savepoint is one on its own
+        bool sp =
+            SQLITE_OK == sqlite3_exec(db, "SAVEPOINT cmd", NULL, NULL, NULL);
+        if (!sp) {
+            nlog_error("savepoint fail: %s", sqlite3_errmsg(db));
+        }
+
+        int rv = exec_cmd(persister, cmd);
+        if (sp && 0 != rv && !sqlite3_get_autocommit(db)) {
+            sqlite3_exec(db, "ROLLBACK TO cmd", NULL, NULL, NULL);
+        }
+        if (sp && !sqlite3_get_autocommit(db) &&
+            SQLITE_OK != sqlite3_exec(db, "RELEASE cmd", NULL, NULL, NULL)) {
+            nlog_error("release savepoint fail: %s", sqlite3_errmsg(db));
+            rv = NEU_ERR_EINTERNAL;
+        }
+
+        if (cmd->result) {
+            *cmd->result = rv;
+        }
+        if (txn && 0 != rv && sqlite3_get_autocommit(db)) {
+            nlog_error("transaction rolled back by sqlite");
+            txn = false;
+            for (sqlite_cmd_t *c = batch; c != cmd; c = c->next) {
+                if (c->result) {
+                    *c->result = NEU_ERR_EINTERNAL;
+                }
+            }
+        }
+        n_tags += cmd->n_tags;
+        ++n_cmds;
+    }
+
+    if (txn && SQLITE_OK != sqlite3_exec(db, "COMMIT", NULL, NULL, NULL)) {
+        nlog_error("commit transaction fail: %s", sqlite3_errmsg(db));
+        sqlite3_exec(db, "ROLLBACK", NULL, NULL, NULL);
+        for (sqlite_cmd_t *cmd = batch; NULL != cmd; cmd = cmd->next) {
+            if (cmd->result) {
+                *cmd->result = NEU_ERR_EINTERNAL;
+            }
+        }
+    }
+
+    while (NULL != batch) {
+        sqlite_cmd_t *next = batch->next;
+        sqlite_cmd_free(batch);
+        batch = next;
+    }
+
+    int64_t elapsed = neu_time_ms() - start;
+    if (n_tags > 0) {
+        nlog_debug("persist %" PRIu64 " commands, %zu tags in %" PRId64
+                   " ms, %.0f tags/s",
+                   n_cmds, n_tags, elapsed,
+                   n_tags * 1000.0 / (elapsed > 0 ? elapsed : 1));
+    } else {
+        nlog_debug("persist %" PRIu64 " commands in %" PRId64 " ms", n_cmds,
+                   elapsed);
+    }
+
+    return n_cmds;
+}
+
+static void *sqlite_persist_thread(void *arg)
+{
+    neu_sqlite_persister_t *persister = arg;
+
+    pthread_mutex_lock(&persister->mtx);
+    while (true) {
+        while (NULL == persister->head && !persister->stop) {
+            pthread_cond_wait(&persister->cond, &persister->mtx);
+        }
+
+        if (NULL == persister->head) {
+            break;
+        }
+
+        // coalesce commands into one transaction until the batch is large
+        // enough, the batch window elapses or someone waits for a flush
+        struct timespec deadline = { 0 };
+        clock_gettime(CLOCK_REALTIME, &deadline);
+        deadline.tv_sec += BATCH_WINDOW_MS / 1000;
+        deadline.tv_nsec += (BATCH_WINDOW_MS % 1000) * 1000000;
+        if (deadline.tv_nsec >= 1000000000) {
+            deadline.tv_sec += 1;
+            deadline.tv_nsec -= 1000000000;
+        }
+
+        while (persister->n_rows < BATCH_ROWS &&
+               persister->seq_flush <= persister->seq_done &&
+               !persister->stop) {
+            if (ETIMEDOUT ==
+                pthread_cond_timedwait(&persister->cond, &persister->mtx,
+                                       &deadline)) {
+                break;
+            }
+        }
+
+        sqlite_cmd_t *batch = persister->head;
+        persister->head     = NULL;
+        persister->tail     = NULL;
+        persister->n_rows   = 0;
+        pthread_mutex_unlock(&persister->mtx);
+
+        uint64_t n = exec_batch(persister, batch);
+
+        pthread_mutex_lock(&persister->mtx);
+        persister->seq_done += n;
+        pthread_cond_broadcast(&persister->done_cond);
+    }
+    pthread_mutex_unlock(&persister->mtx);
+
+    return NULL;
+}
+
 static struct neu_persister_vtbl_s g_sqlite_persister_vtbl = {
     .destroy             = neu_sqlite_persister_destroy,
     .native_handle       = neu_sqlite_persister_native_handle,
@@ -454,6 +993,38 @@ neu_persister_t *neu_sqlite_persister_create(const char *schema_dir)
         return NULL;
     }
 
+    if (0 != open_write_db(&persister->wdb)) {
+        sqlite3_close(persister->db);
+        free(persister);
+        return NULL;
+    }
+
+    persister->stmts = calloc(SQLITE_CMD_MAX, sizeof(sqlite3_stmt *));
+    if (NULL == persister->stmts) {
+        sqlite3_close(persister->wdb);
+        sqlite3_close(persister->db);
+        free(persister);
+        return NULL;
+    }
+
+    pthread_mutex_init(&persister->mtx, NULL);
+    pthread_cond_init(&persister->cond, NULL);
+    pthread_cond_init(&persister->done_cond, NULL);
+
+    if (0 !=
+        pthread_create(&persister->tid, NULL, sqlite_persist_thread,
+                       persister)) {
+        nlog_fatal("create persistence thread fail");
+        pthread_cond_destroy(&persister->done_cond);
+        pthread_cond_destroy(&persister->cond);
+        pthread_mutex_destroy(&persister->mtx);
+        free(persister->stmts);
+        sqlite3_close(persister->wdb);
+        sqlite3_close(persister->db);
+        free(persister);
+        return NULL;
+    }
+
     return (neu_persister_t *) persister;
 }
 
@@ -462,10 +1033,37 @@ void *neu_sqlite_persister_native_handle(neu_persister_t *self)
     return ((neu_sqlite_persister_t *) self)->db;
 }
 
+int neu_sqlite_persister_flush(neu_persister_t *self)
+{
+    neu_sqlite_persister_t *persister = (neu_sqlite_persister_t *) self;
+
+    pthread_mutex_lock(&persister->mtx);
+    wait_done(persister, persister->seq_queued);
+    pthread_mutex_unlock(&persister->mtx);
+
+    return 0;
+}
+
 void neu_sqlite_persister_destroy(neu_persister_t *self)
 {
     neu_sqlite_persister_t *persister = (neu_sqlite_persister_t *) self;
     if (persister) {
+        // the persistence thread drains the queue before exiting
+        pthread_mutex_lock(&persister->mtx);
+        persister->stop = true;
+        pthread_cond_signal(&persister->cond);
+        pthread_mutex_unlock(&persister->mtx);
+        pthread_join(persister->tid, NULL);
+
+        for (int i = 0; i < SQLITE_CMD_MAX; ++i) {
+            sqlite3_finalize(persister->stmts[i]);
+        }
+        free(persister->stmts);
+
+        pthread_cond_destroy(&persister->done_cond);
+        pthread_cond_destroy(&persister->cond);
+        pthread_mutex_destroy(&persister->mtx);
+        sqlite3_close(persister->wdb);
         sqlite3_close(persister->db);
         free(persister);
     }
@@ -474,12 +1072,13 @@ void neu_sqlite_persister_destroy(neu_persister_t *self)
 int neu_sqlite_persister_store_node(neu_persister_t *        self,
                                     neu_persist_node_info_t *info)
 {
-    int rv = 0;
-    rv     = execute_sql(((neu_sqlite_persister_t *) self)->db,
-                     "INSERT INTO nodes (name, type, state, plugin_name) "
-                     "VALUES (%Q, %i, %i, %Q)",
-                     info->name, info->type, info->state, info->plugin_name);
-    return rv;
+    sqlite_cmd_t *cmd =
+        str_cmd(SQLITE_CMD_STORE_NODE, 2, info->name, info->plugin_name);
+    if (NULL != cmd) {
+        cmd->num[0] = info->type;
+        cmd->num[1] = info->state;
+    }
+    return persist_cmd(self, cmd, true);
 }
 
 static UT_icd node_info_icd = {
@@ -493,6 +1092,8 @@ int neu_sqlite_persister_load_nodes(neu_persister_t *self,
                                     UT_array **      node_infos)
 {
     neu_sqlite_persister_t *persister = (neu_sqlite_persister_t *) self;
+    // pending changes must be visible to the read connection
+    neu_sqlite_persister_flush(self);
 
     int           rv    = 0;
     sqlite3_stmt *stmt  = NULL;
@@ -546,26 +1147,27 @@ int neu_sqlite_persister_delete_node(neu_persister_t *self,
 {
     // rely on foreign key constraints to remove settings, groups, tags and
     // subscriptions
-    int rv = execute_sql(((neu_sqlite_persister_t *) self)->db,
-                         "DELETE FROM nodes WHERE name=%Q;", node_name);
-    return rv;
+    return persist_cmd(self, str_cmd(SQLITE_CMD_DELETE_NODE, 1, node_name),
+                       true);
 }
 
 int neu_sqlite_persister_update_node(neu_persister_t *self,
                                      const char *     node_name,
                                      const char *     new_name)
 {
-    return execute_sql(((neu_sqlite_persister_t *) self)->db,
-                       "UPDATE nodes SET name=%Q WHERE name=%Q;", new_name,
-                       node_name);
+    return persist_cmd(
+        self, str_cmd(SQLITE_CMD_UPDATE_NODE, 2, new_name, node_name), true);
 }
 
 int neu_sqlite_persister_update_node_state(neu_persister_t *self,
                                            const char *node_name, int state)
 {
-    return execute_sql(((neu_sqlite_persister_t *) self)->db,
-                       "UPDATE nodes SET state=%i WHERE name=%Q;", state,
-                       node_name);
+    sqlite_cmd_t *cmd = str_cmd(SQLITE_CMD_UPDATE_NODE_STATE, 1, node_name);
+    if (NULL != cmd) {
+        cmd->num[0] = state;
+    }
+    // runtime state, not configuration, a failed write is only logged
+    return persist_cmd(self, cmd, false);
 }
 
 int neu_sqlite_persister_store_tag(neu_persister_t *    self,
@@ -573,105 +1175,9 @@ int neu_sqlite_persister_store_tag(neu_persister_t *    self,
                                    const char *         group_name,
                                    const neu_datatag_t *tag)
 {
-    char format_buf[128] = { 0 };
-    if (tag->n_format > 0) {
-        neu_tag_format_str(tag, format_buf, sizeof(format_buf));
-    }
-
-    int rv = execute_sql(
-        ((neu_sqlite_persister_t *) self)->db,
-        "INSERT INTO tags ("
-        " driver_name, group_name, name, address, attribute,"
-        " precision, type, decimal, bias, description, value, format"
-        ") VALUES (%Q, %Q, %Q, %Q, %i, %i, %i, %lf, %lf, %Q, %Q, %Q)",
-        driver_name, group_name, tag->name, tag->address, tag->attribute,
-        tag->precision, tag->type, tag->decimal, tag->bias, tag->description,
-        "", format_buf);
-
-    return rv;
-}
-
-static int put_tags(sqlite3 *db, const char *query, sqlite3_stmt *stmt,
-                    const neu_datatag_t *tags, size_t n)
-{
-    for (size_t i = 0; i < n; ++i) {
-        const neu_datatag_t *tag             = &tags[i];
-        char                 format_buf[128] = { 0 };
-
-        if (tag->n_format > 0) {
-            neu_tag_format_str(tag, format_buf, sizeof(format_buf));
-        }
-
-        sqlite3_reset(stmt);
-
-        if (SQLITE_OK != sqlite3_bind_text(stmt, 3, tag->name, -1, NULL)) {
-            nlog_error("bind `%s` with name=`%s` fail: %s", query, tag->name,
-                       sqlite3_errmsg(db));
-            return -1;
-        }
-
-        if (SQLITE_OK != sqlite3_bind_text(stmt, 4, tag->address, -1, NULL)) {
-            nlog_error("bind `%s` with address=`%s` fail: %s", query,
-                       tag->address, sqlite3_errmsg(db));
-            return -1;
-        }
-
-        if (SQLITE_OK != sqlite3_bind_int(stmt, 5, tag->attribute)) {
-            nlog_error("bind `%s` with attribute=`%i` fail: %s", query,
-                       tag->attribute, sqlite3_errmsg(db));
-            return -1;
-        }
-
-        if (SQLITE_OK != sqlite3_bind_int(stmt, 6, tag->precision)) {
-            nlog_error("bind `%s` with precision=`%i` fail: %s", query,
-                       tag->precision, sqlite3_errmsg(db));
-            return -1;
-        }
-
-        if (SQLITE_OK != sqlite3_bind_int(stmt, 7, tag->type)) {
-            nlog_error("bind `%s` with type=`%i` fail: %s", query, tag->type,
-                       sqlite3_errmsg(db));
-            return -1;
-        }
-
-        if (SQLITE_OK != sqlite3_bind_double(stmt, 8, tag->decimal)) {
-            nlog_error("bind `%s` with decimal=`%f` fail: %s", query,
-                       tag->decimal, sqlite3_errmsg(db));
-            return -1;
-        }
-
-        if (SQLITE_OK != sqlite3_bind_double(stmt, 9, tag->bias)) {
-            nlog_error("bind `%s` with bias=`%f` fail: %s", query, tag->bias,
-                       sqlite3_errmsg(db));
-            return -1;
-        }
-
-        if (SQLITE_OK !=
-            sqlite3_bind_text(stmt, 10, tag->description, -1, NULL)) {
-            nlog_error("bind `%s` with description=`%s` fail: %s", query,
-                       tag->description, sqlite3_errmsg(db));
-            return -1;
-        }
-
-        if (SQLITE_OK != sqlite3_bind_null(stmt, 11)) {
-            nlog_error("bind `%s` with value=null fail: %s", query,
-                       sqlite3_errmsg(db));
-            return -1;
-        }
-
-        if (SQLITE_OK != sqlite3_bind_text(stmt, 12, format_buf, -1, NULL)) {
-            nlog_error("bind `%s` with format=`%s` fail: %s", query, format_buf,
-                       sqlite3_errmsg(db));
-            return -1;
-        }
-
-        if (SQLITE_DONE != sqlite3_step(stmt)) {
-            nlog_error("sqlite3_step fail: %s", sqlite3_errmsg(db));
-            return -1;
-        }
-    }
-
-    return 0;
+    return persist_cmd(
+        self, tag_cmd(SQLITE_CMD_STORE_TAG, driver_name, group_name, tag, 1),
+        true);
 }
 
 int neu_sqlite_persister_store_tags(neu_persister_t *    self,
@@ -679,57 +1185,9 @@ int neu_sqlite_persister_store_tags(neu_persister_t *    self,
                                     const char *         group_name,
                                     const neu_datatag_t *tags, size_t n)
 {
-    neu_sqlite_persister_t *persister = (neu_sqlite_persister_t *) self;
-
-    sqlite3_stmt *stmt = NULL;
-    const char *  query =
-        "INSERT INTO tags ("
-        " driver_name, group_name, name, address, attribute,"
-        " precision, type, decimal, bias, description, value, format"
-        ") VALUES (?1, ?2, ?3, ?4, ?5, ?6, ?7, ?8, ?9, ?10, ?11, ?12)";
-
-    if (SQLITE_OK != sqlite3_exec(persister->db, "BEGIN", NULL, NULL, NULL)) {
-        nlog_error("begin transaction fail: %s", sqlite3_errmsg(persister->db));
-        return NEU_ERR_EINTERNAL;
-    }
-
-    if (SQLITE_OK !=
-        sqlite3_prepare_v2(persister->db, query, -1, &stmt, NULL)) {
-        nlog_error("prepare `%s` fail: %s", query,
-                   sqlite3_errmsg(persister->db));
-        goto error;
-    }
-
-    if (SQLITE_OK != sqlite3_bind_text(stmt, 1, driver_name, -1, NULL)) {
-        nlog_error("bind `%s` with driver_name=`%s` fail: %s", query,
-                   driver_name, sqlite3_errmsg(persister->db));
-        goto error;
-    }
-
-    if (SQLITE_OK != sqlite3_bind_text(stmt, 2, group_name, -1, NULL)) {
-        nlog_error("bind `%s` with group_name=`%s` fail: %s", query, group_name,
-                   sqlite3_errmsg(persister->db));
-        goto error;
-    }
-
-    if (0 != put_tags(persister->db, query, stmt, tags, n)) {
-        goto error;
-    }
-
-    if (SQLITE_OK != sqlite3_exec(persister->db, "COMMIT", NULL, NULL, NULL)) {
-        nlog_error("commit transaction fail: %s",
-                   sqlite3_errmsg(persister->db));
-        goto error;
-    }
-
-    sqlite3_finalize(stmt);
-    return 0;
-
-error:
-    nlog_warn("rollback transaction");
-    sqlite3_exec(persister->db, "ROLLBACK", NULL, NULL, NULL);
-    sqlite3_finalize(stmt);
-    return NEU_ERR_EINTERNAL;
+    return persist_cmd(
+        self, tag_cmd(SQLITE_CMD_STORE_TAG, driver_name, group_name, tags, n),
+        true);
 }
 
 static int collect_tag_info(sqlite3_stmt *stmt, UT_array **tags)
@@ -768,6 +1226,8 @@ int neu_sqlite_persister_load_tags(neu_persister_t *self,
                                    const char *group_name, UT_array **tags)
 {
     neu_sqlite_persister_t *persister = (neu_sqlite_persister_t *) self;
+    // pending changes must be visible to the read connection
+    neu_sqlite_persister_flush(self);
 
     sqlite3_stmt *stmt  = NULL;
     const char *  query = "SELECT name, address, attribute, precision, type, "
@@ -815,15 +1275,9 @@ int neu_sqlite_persister_update_tag(neu_persister_t *    self,
                                     const char *         group_name,
                                     const neu_datatag_t *tag)
 {
-    int rv = execute_sql(((neu_sqlite_persister_t *) self)->db,
-                         "UPDATE tags SET"
-                         " address=%Q, attribute=%i, precision=%i, type=%i,"
-                         " decimal=%lf, bias=%lf, description=%Q, value=%Q "
-                         "WHERE driver_name=%Q AND group_name=%Q AND name=%Q",
-                         tag->address, tag->attribute, tag->precision,
-                         tag->type, tag->decimal, tag->bias, tag->description,
-                         "", driver_name, group_name, tag->name);
-    return rv;
+    return persist_cmd(
+        self, tag_cmd(SQLITE_CMD_UPDATE_TAG, driver_name, group_name, tag, 1),
+        true);
 }
 
 int neu_sqlite_persister_update_tag_value(neu_persister_t *    self,
@@ -831,11 +1285,11 @@ int neu_sqlite_persister_update_tag_value(neu_persister_t *    self,
                                           const char *         group_name,
                                           const neu_datatag_t *tag)
 {
-    int rv = execute_sql(((neu_sqlite_persister_t *) self)->db,
-                         "UPDATE tags SET value=%Q "
-                         "WHERE driver_name=%Q AND group_name=%Q AND name=%Q",
-                         "", driver_name, group_name, tag->name);
-    return rv;
+    // written behind, a failed write is only logged
+    return persist_cmd(self,
+                       str_cmd(SQLITE_CMD_UPDATE_TAG_VALUE, 3, driver_name,
+                               group_name, tag->name),
+                       false);
 }
 
 int neu_sqlite_persister_delete_tag(neu_persister_t *self,
@@ -843,32 +1297,30 @@ int neu_sqlite_persister_delete_tag(neu_persister_t *self,
                                     const char *     group_name,
                                     const char *     tag_name)
 {
-    int rv = execute_sql(
-        ((neu_sqlite_persister_t *) self)->db,
-        "DELETE FROM tags WHERE driver_name=%Q AND group_name=%Q AND name=%Q",
-        driver_name, group_name, tag_name);
-    return rv;
+    return persist_cmd(self,
+                       str_cmd(SQLITE_CMD_DELETE_TAG, 3, driver_name,
+                               group_name, tag_name),
+                       true);
 }
 
 int neu_sqlite_persister_store_subscription(
     neu_persister_t *self, const char *app_name, const char *driver_name,
     const char *group_name, const char *params, const char *static_tags)
 {
-    return execute_sql(((neu_sqlite_persister_t *) self)->db,
-                       "INSERT INTO subscriptions (app_name, driver_name, "
-                       "group_name, params, static_tags) "
-                       "VALUES (%Q, %Q, %Q, %Q, %Q)",
-                       app_name, driver_name, group_name, params, static_tags);
+    return persist_cmd(self,
+                       str_cmd(SQLITE_CMD_STORE_SUBSCRIPTION, 5, app_name,
+                               driver_name, group_name, params, static_tags),
+                       true);
 }
 
 int neu_sqlite_persister_update_subscription(
     neu_persister_t *self, const char *app_name, const char *driver_name,
     const char *group_name, const char *params, const char *static_tags)
 {
-    return execute_sql(((neu_sqlite_persister_t *) self)->db,
-                       "UPDATE subscriptions SET params=%Q, static_tags=%Q "
-                       "WHERE app_name=%Q AND driver_name=%Q AND group_name=%Q",
-                       params, static_tags, app_name, driver_name, group_name);
+    return persist_cmd(self,
+                       str_cmd(SQLITE_CMD_UPDATE_SUBSCRIPTION, 5, params,
+                               static_tags, app_name, driver_name, group_name),
+                       true);
 }
 
 static UT_icd subscription_info_icd = {
@@ -883,6 +1335,8 @@ int neu_sqlite_persister_load_subscriptions(neu_persister_t *self,
                                             UT_array **      subscription_infos)
 {
     neu_sqlite_persister_t *persister = (neu_sqlite_persister_t *) self;
+    // pending changes must be visible to the read connection
+    neu_sqlite_persister_flush(self);
 
     sqlite3_stmt *stmt  = NULL;
     const char *  query = "SELECT driver_name, group_name, params, static_tags "
@@ -963,10 +1417,10 @@ int neu_sqlite_persister_delete_subscription(neu_persister_t *self,
                                              const char *     driver_name,
                                              const char *     group_name)
 {
-    return execute_sql(((neu_sqlite_persister_t *) self)->db,
-                       "DELETE FROM subscriptions WHERE app_name=%Q AND "
-                       "driver_name=%Q AND group_name=%Q",
-                       app_name, driver_name, group_name);
+    return persist_cmd(self,
+                       str_cmd(SQLITE_CMD_DELETE_SUBSCRIPTION, 3, app_name,
+                               driver_name, group_name),
+                       true);
 }
 
 int neu_sqlite_persister_store_group(neu_persister_t *         self,
@@ -974,11 +1428,12 @@ int neu_sqlite_persister_store_group(neu_persister_t *         self,
                                      neu_persist_group_info_t *group_info,
                                      const char *              context)
 {
-    return execute_sql(((neu_sqlite_persister_t *) self)->db,
-                       "INSERT INTO groups (driver_name, name, interval, "
-                       "context) VALUES (%Q, %Q, %u, %Q)",
-                       driver_name, group_info->name,
-                       (unsigned) group_info->interval, context);
+    sqlite_cmd_t *cmd = str_cmd(SQLITE_CMD_STORE_GROUP, 3, driver_name,
+                                group_info->name, context);
+    if (NULL != cmd) {
+        cmd->num[0] = group_info->interval;
+    }
+    return persist_cmd(self, cmd, true);
 }
 
 int neu_sqlite_persister_update_group(neu_persister_t *         self,
@@ -986,28 +1441,27 @@ int neu_sqlite_persister_update_group(neu_persister_t *         self,
                                       const char *              group_name,
                                       neu_persist_group_info_t *group_info)
 {
-    neu_sqlite_persister_t *persister = (neu_sqlite_persister_t *) self;
-
     int  ret             = -1;
     bool update_name     = (0 != strcmp(group_name, group_info->name));
     bool update_interval = (NEU_GROUP_INTERVAL_LIMIT <= group_info->interval);
 
-    if (update_name && update_interval) {
-        ret = execute_sql(persister->db,
-                          "UPDATE groups SET name=%Q, interval=%i "
-                          "WHERE driver_name=%Q AND name=%Q",
-                          group_info->name, group_info->interval, driver_name,
-                          group_name);
-    } else if (update_name) {
-        ret = execute_sql(persister->db,
-                          "UPDATE groups SET name=%Q "
-                          "WHERE driver_name=%Q AND name=%Q",
-                          group_info->name, driver_name, group_name);
-    } else if (update_interval) {
-        ret = execute_sql(persister->db,
-                          "UPDATE groups SET interval=%i "
-                          "WHERE driver_name=%Q AND name=%Q",
-                          group_info->interval, driver_name, group_name);
+    if (update_name) {
+        ret = persist_cmd(self,
+                          str_cmd(SQLITE_CMD_UPDATE_GROUP_NAME, 3,
+                                  group_info->name, driver_name, group_name),
+                          true);
+        if (0 != ret) {
+            return ret;
+        }
+    }
+
+    if (update_interval) {
+        sqlite_cmd_t *cmd = str_cmd(SQLITE_CMD_UPDATE_GROUP_INTERVAL, 2,
+                                    driver_name, group_info->name);
+        if (NULL != cmd) {
+            cmd->num[0] = group_info->interval;
+        }
+        ret = persist_cmd(self, cmd, true);
     }
 
     return ret;
@@ -1055,6 +1509,8 @@ int neu_sqlite_persister_load_groups(neu_persister_t *self,
                                      UT_array **      group_infos)
 {
     neu_sqlite_persister_t *persister = (neu_sqlite_persister_t *) self;
+    // pending changes must be visible to the read connection
+    neu_sqlite_persister_flush(self);
 
     sqlite3_stmt *stmt = NULL;
     const char *  query =
@@ -1094,20 +1550,18 @@ int neu_sqlite_persister_delete_group(neu_persister_t *self,
                                       const char *     group_name)
 {
     // rely on foreign key constraints to delete tags and subscriptions
-    int rv = execute_sql(((neu_sqlite_persister_t *) self)->db,
-                         "DELETE FROM groups WHERE driver_name=%Q AND name=%Q",
-                         driver_name, group_name);
-    return rv;
+    return persist_cmd(
+        self, str_cmd(SQLITE_CMD_DELETE_GROUP, 2, driver_name, group_name),
+        true);
 }
 
 int neu_sqlite_persister_store_node_setting(neu_persister_t *self,
                                             const char *     node_name,
                                             const char *     setting)
 {
-    return execute_sql(
-        ((neu_sqlite_persister_t *) self)->db,
-        "INSERT OR REPLACE INTO settings (node_name, setting) VALUES (%Q, %Q)",
-        node_name, setting);
+    return persist_cmd(
+        self, str_cmd(SQLITE_CMD_STORE_NODE_SETTING, 2, node_name, setting),
+        true);
 }
 
 int neu_sqlite_persister_load_node_setting(neu_persister_t *  self,
@@ -1115,6 +1569,8 @@ int neu_sqlite_persister_load_node_setting(neu_persister_t *  self,
                                            const char **const setting)
 {
     neu_sqlite_persister_t *persister = (neu_sqlite_persister_t *) self;
+    // pending changes must be visible to the read connection
+    neu_sqlite_persister_flush(self);
 
     int           rv    = 0;
     sqlite3_stmt *stmt  = NULL;
@@ -1158,8 +1614,8 @@ end:
 int neu_sqlite_persister_delete_node_setting(neu_persister_t *self,
                                              const char *     node_name)
 {
-    return execute_sql(((neu_sqlite_persister_t *) self)->db,
-                       "DELETE FROM settings WHERE node_name=%Q", node_name);
+    return persist_cmd(
+        self, str_cmd(SQLITE_CMD_DELETE_NODE_SETTING, 1, node_name), true);
 }
 
 static UT_icd user_info_icd = {
@@ -1200,6 +1656,8 @@ int neu_sqlite_persister_load_users(neu_persister_t *self,
                                     UT_array **      user_infos)
 {
     neu_sqlite_persister_t *persister = (neu_sqlite_persister_t *) self;
+    // pending changes must be visible to the read connection
+    neu_sqlite_persister_flush(self);
 
     sqlite3_stmt *stmt  = NULL;
     const char *  query = "SELECT name, password FROM users";
@@ -1230,23 +1688,24 @@ error:
 int neu_sqlite_persister_store_user(neu_persister_t *              self,
                                     const neu_persist_user_info_t *user)
 {
-    return execute_sql(((neu_sqlite_persister_t *) self)->db,
-                       "INSERT INTO users (name, password) VALUES (%Q, %Q)",
-                       user->name, user->hash);
+    // user changes are rare and must be visible to the next login
+    return persist_cmd(
+        self, str_cmd(SQLITE_CMD_STORE_USER, 2, user->name, user->hash), true);
 }
 
 int neu_sqlite_persister_update_user(neu_persister_t *              self,
                                      const neu_persist_user_info_t *user)
 {
-    return execute_sql(((neu_sqlite_persister_t *) self)->db,
-                       "UPDATE users SET password=%Q WHERE name=%Q", user->hash,
-                       user->name);
+    return persist_cmd(
+        self, str_cmd(SQLITE_CMD_UPDATE_USER, 2, user->hash, user->name), true);
 }
 
 int neu_sqlite_persister_load_user(neu_persister_t *self, const char *user_name,
                                    neu_persist_user_info_t **user_p)
 {
     neu_sqlite_persister_t *persister = (neu_sqlite_persister_t *) self;
+    // pending changes must be visible to the read connection
+    neu_sqlite_persister_flush(self);
 
     neu_persist_user_info_t *user  = NULL;
     sqlite3_stmt *           stmt  = NULL;
@@ -1304,6 +1763,6 @@ error:
 int neu_sqlite_persister_delete_user(neu_persister_t *self,
                                      const char *     user_name)
 {
-    return execute_sql(((neu_sqlite_persister_t *) self)->db,
-                       "DELETE FROM users WHERE name=%Q", user_name);
+    return persist_cmd(self, str_cmd(SQLITE_CMD_DELETE_USER, 1, user_name),
+                       true);
 }
@@ -24,17 +24,37 @@
 extern "C" {
 #endif
 
+#include <pthread.h>
+
 #include "persist/persist_impl.h"
 
+typedef struct sqlite_cmd sqlite_cmd_t;
+
 typedef struct {
     struct neu_persister_vtbl_s *vtbl;
-    sqlite3 *                    db;
+    sqlite3 *                    db; // read connection
+
+    // write-behind queue, drained by the persistence thread
+    sqlite3 *       wdb; // write connection, owned by the persistence thread
+    sqlite3_stmt ** stmts;
+    pthread_t       tid;
+    pthread_mutex_t mtx;
+    pthread_cond_t  cond;
+    pthread_cond_t  done_cond;
+    sqlite_cmd_t *  head;
+    sqlite_cmd_t *  tail;
+    size_t          n_rows;     // number of rows pending in the queue
+    uint64_t        seq_queued; // sequence number of the last queued command
+    uint64_t        seq_done;   // sequence number of the last finished command
+    uint64_t        seq_flush;  // flush barrier requested by callers
+    bool            stop;
 } neu_sqlite_persister_t;
 
 neu_persister_t *neu_sqlite_persister_create(const char *schema_dir);
 
 void  neu_sqlite_persister_destroy(neu_persister_t *self);
 void *neu_sqlite_persister_native_handle(neu_persister_t *self);
+int   neu_sqlite_persister_flush(neu_persister_t *self);
 
 int neu_sqlite_persister_store_node(neu_persister_t *        self,
                                     neu_persist_node_info_t *info);
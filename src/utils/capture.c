@@ -0,0 +1,400 @@
+/**
+ * NEURON IIoT System for Industry 4.0
+ * Copyright (C) 2020-2022 EMQ Technologies Co., Ltd All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ **/
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "define.h"
+#include "utils/capture.h"
+#include "utils/log.h"
+#include "utils/time.h"
+#include "utils/uthash.h"
+
+#define ALIGN(n, a) (((n) + (a) -1) & ~((a) -1))
+
+#define PCAPNG_SHB 0x0A0D0D0A
+#define PCAPNG_IDB 0x00000001
+#define PCAPNG_EPB 0x00000006
+#define PCAPNG_MAGIC 0x1A2B3C4D
+#define PCAPNG_LINKTYPE_USER0 147
+#define PCAPNG_OPT_COMMENT 1
+#define PCAPNG_OPT_EPB_FLAGS 2
+#define PCAPNG_FLAG_INBOUND 1
+#define PCAPNG_FLAG_OUTBOUND 2
+
+enum record_type {
+    RECORD_FRAME,
+    RECORD_CLOSE,
+    RECORD_PAD, // rest of the ring up to the end is unused
+};
+
+struct record {
+    int64_t  timestamp; // microseconds since epoch
+    uint32_t size;      // whole record, multiple of 8
+    uint8_t  type;
+    uint8_t  dir;
+    uint16_t n_byte;
+    uint16_t node_len;
+    // followed by the node name and the frame
+};
+
+// single producer, the owning thread, and single consumer, the flusher
+struct ring {
+    uint8_t  buf[NEU_CAPTURE_RING_SIZE];
+    uint64_t head __attribute__((aligned(64)));
+    uint64_t tail __attribute__((aligned(64)));
+    uint64_t dropped;
+    bool     dead; // the owning thread exited
+
+    struct ring *next;
+};
+
+struct capture_file {
+    char           node[NEU_NODE_NAME_LEN];
+    FILE *         fp;
+    UT_hash_handle hh;
+};
+
+// a node closed in some ring, applied once all rings are drained
+struct capture_close {
+    char           node[NEU_NODE_NAME_LEN];
+    UT_hash_handle hh;
+};
+
+static pthread_once_t  capture_once = PTHREAD_ONCE_INIT;
+static pthread_key_t   ring_key;
+static pthread_mutex_t rings_mtx = PTHREAD_MUTEX_INITIALIZER;
+static struct ring *   rings     = NULL;
+static uint64_t        dropped   = 0; // of rings already freed
+
+static pthread_mutex_t       flush_mtx = PTHREAD_MUTEX_INITIALIZER;
+static struct capture_file * files     = NULL;
+static struct capture_close *closes    = NULL;
+
+static __thread struct ring *local_ring = NULL;
+
+static void *capture_thread(void *arg)
+{
+    uint64_t reported = 0;
+
+    (void) arg;
+    while (true) {
+        neu_msleep(NEU_CAPTURE_FLUSH_MS);
+        neu_capture_flush();
+
+        uint64_t n = neu_capture_dropped();
+        if (n > reported) {
+            nlog_warn("protocol capture dropped %" PRIu64 " frames", n);
+            reported = n;
+        }
+    }
+
+    return NULL;
+}
+
+static void ring_exit(void *arg)
+{
+    struct ring *ring = (struct ring *) arg;
+
+    __atomic_store_n(&ring->dead, true, __ATOMIC_RELEASE);
+}
+
+static void capture_init(void)
+{
+    pthread_t tid;
+
+    pthread_key_create(&ring_key, ring_exit);
+    pthread_create(&tid, NULL, capture_thread, NULL);
+    pthread_detach(tid);
+}
+
+static struct ring *ring_get(void)
+{
+    if (local_ring == NULL) {
+        pthread_once(&capture_once, capture_init);
+
+        local_ring = calloc(1, sizeof(struct ring));
+        pthread_setspecific(ring_key, local_ring);
+
+        pthread_mutex_lock(&rings_mtx);
+        local_ring->next = rings;
+        rings            = local_ring;
+        pthread_mutex_unlock(&rings_mtx);
+    }
+
+    return local_ring;
+}
+
+static void ring_put(struct ring *ring, enum record_type type,
+                     neu_capture_dir_e dir, const char *node,
+                     const uint8_t *bytes, uint16_t n_byte)
+{
+    uint16_t       node_len = strnlen(node, NEU_NODE_NAME_LEN - 1);
+    uint64_t       head     = ring->head;
+    uint64_t       tail     = __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+    uint32_t       offset   = head & (NEU_CAPTURE_RING_SIZE - 1);
+    uint32_t       pad      = 0;
+    uint32_t       size     = 0;
+    struct record *rec      = NULL;
+
+    size = ALIGN(sizeof(struct record) + node_len + n_byte, 8);
+
+    // records never wrap around the end of the ring
+    if (offset + size > NEU_CAPTURE_RING_SIZE) {
+        pad = NEU_CAPTURE_RING_SIZE - offset;
+    }
+    if (head + pad + size - tail > NEU_CAPTURE_RING_SIZE) {
+        __atomic_add_fetch(&ring->dropped, 1, __ATOMIC_RELAXED);
+        return;
+    }
+
+    if (pad >= sizeof(struct record)) {
+        rec       = (struct record *) &ring->buf[offset];
+        rec->size = pad;
+        rec->type = RECORD_PAD;
+    }
+    head += pad;
+    offset = head & (NEU_CAPTURE_RING_SIZE - 1);
+
+    rec            = (struct record *) &ring->buf[offset];
+    rec->timestamp = neu_time_ns() / 1000;
+    rec->size      = size;
+    rec->type      = type;
+    rec->dir       = dir;
+    rec->n_byte    = n_byte;
+    rec->node_len  = node_len;
+    memcpy(&rec[1], node, node_len);
+    if (n_byte > 0) {
+        memcpy((uint8_t *) &rec[1] + node_len, bytes, n_byte);
+    }
+
+    __atomic_store_n(&ring->head, head + size, __ATOMIC_RELEASE);
+}
+
+void neu_capture_frame(const char *node, neu_capture_dir_e dir,
+                       const uint8_t *bytes, uint16_t n_byte)
+{
+    ring_put(ring_get(), RECORD_FRAME, dir, node, bytes, n_byte);
+}
+
+void neu_capture_close(const char *node)
+{
+    ring_put(ring_get(), RECORD_CLOSE, NEU_CAPTURE_SEND, node, NULL, 0);
+}
+
+static void write_u32(FILE *fp, uint32_t v)
+{
+    fwrite(&v, sizeof(v), 1, fp);
+}
+
+static void write_padded(FILE *fp, const void *data, uint32_t len)
+{
+    static const uint8_t zero[4] = { 0 };
+
+    fwrite(data, 1, len, fp);
+    fwrite(zero, 1, ALIGN(len, 4) - len, fp);
+}
+
+static void write_header(FILE *fp)
+{
+    int64_t section_len = -1;
+
+    write_u32(fp, PCAPNG_SHB);
+    write_u32(fp, 28);
+    write_u32(fp, PCAPNG_MAGIC);
+    write_u32(fp, 1); // version 1.0
+    fwrite(&section_len, sizeof(section_len), 1, fp);
+    write_u32(fp, 28);
+
+    write_u32(fp, PCAPNG_IDB);
+    write_u32(fp, 20);
+    write_u32(fp, PCAPNG_LINKTYPE_USER0); // and 16 reserved bits
+    write_u32(fp, 0);                     // no snap length
+    write_u32(fp, 20);
+}
+
+static void write_frame(FILE *fp, const struct record *rec)
+{
+    const char *   node  = (const char *) &rec[1];
+    const uint8_t *bytes = (const uint8_t *) node + rec->node_len;
+    uint32_t       total = 28 + ALIGN(rec->n_byte, 4) + 4 +
+        ALIGN(rec->node_len, 4) + 8 + 4 + 4;
+
+    write_u32(fp, PCAPNG_EPB);
+    write_u32(fp, total);
+    write_u32(fp, 0); // interface
+    write_u32(fp, (uint64_t) rec->timestamp >> 32);
+    write_u32(fp, (uint64_t) rec->timestamp & 0xFFFFFFFF);
+    write_u32(fp, rec->n_byte);
+    write_u32(fp, rec->n_byte);
+    write_padded(fp, bytes, rec->n_byte);
+
+    write_u32(fp, PCAPNG_OPT_COMMENT | (uint32_t) rec->node_len << 16);
+    write_padded(fp, node, rec->node_len);
+    write_u32(fp, PCAPNG_OPT_EPB_FLAGS | 4 << 16);
+    write_u32(fp, rec->dir == NEU_CAPTURE_RECV ? PCAPNG_FLAG_INBOUND
+                                               : PCAPNG_FLAG_OUTBOUND);
+    write_u32(fp, 0); // end of options
+
+    write_u32(fp, total);
+}
+
+static void close_add(const struct record *rec)
+{
+    struct capture_close *close                   = NULL;
+    char                  node[NEU_NODE_NAME_LEN] = { 0 };
+
+    memcpy(node, &rec[1], rec->node_len);
+    HASH_FIND_STR(closes, node, close);
+    if (close == NULL) {
+        close = calloc(1, sizeof(struct capture_close));
+        strcpy(close->node, node);
+        HASH_ADD_STR(closes, node, close);
+    }
+}
+
+static struct capture_file *file_find(const struct record *rec, bool open)
+{
+    struct capture_file *file                       = NULL;
+    char                 node[NEU_NODE_NAME_LEN]    = { 0 };
+    char                 path[NEU_NODE_NAME_LEN + 32] = { 0 };
+
+    memcpy(node, &rec[1], rec->node_len);
+    HASH_FIND_STR(files, node, file);
+    if (file != NULL || !open) {
+        return file;
+    }
+
+    snprintf(path, sizeof(path), "%s/%s.pcapng", NEU_CAPTURE_DIR, node);
+    FILE *fp = fopen(path, "ab");
+    if (fp == NULL) {
+        nlog_error("open capture file %s fail", path);
+        return NULL;
+    }
+
+    file     = calloc(1, sizeof(struct capture_file));
+    file->fp = fp;
+    strcpy(file->node, node);
+    HASH_ADD_STR(files, node, file);
+
+    // every open starts a new section, appending to an older capture
+    write_header(fp);
+    nlog_notice("start protocol capture to %s", path);
+    return file;
+}
+
+static void ring_drain(struct ring *ring, uint64_t head)
+{
+    uint64_t tail = ring->tail;
+
+    while (tail < head) {
+        uint32_t             offset = tail & (NEU_CAPTURE_RING_SIZE - 1);
+        struct record *      rec    = (struct record *) &ring->buf[offset];
+        struct capture_file *file   = NULL;
+
+        if (NEU_CAPTURE_RING_SIZE - offset < sizeof(struct record)) {
+            tail += NEU_CAPTURE_RING_SIZE - offset;
+            continue;
+        }
+
+        switch (rec->type) {
+        case RECORD_FRAME:
+            file = file_find(rec, true);
+            if (file != NULL) {
+                write_frame(file->fp, rec);
+            }
+            break;
+        case RECORD_CLOSE:
+            // frames of the node may still sit in other rings, and may even
+            // be the first ones to open the file
+            close_add(rec);
+            break;
+        default:
+            break;
+        }
+
+        tail += rec->size;
+    }
+
+    __atomic_store_n(&ring->tail, tail, __ATOMIC_RELEASE);
+}
+
+void neu_capture_flush(void)
+{
+    struct ring **        p     = NULL;
+    struct capture_file * file  = NULL, *tmp = NULL;
+    struct capture_close *close = NULL, *ctmp = NULL;
+
+    pthread_mutex_lock(&flush_mtx);
+    pthread_mutex_lock(&rings_mtx);
+
+    p = &rings;
+    while (*p != NULL) {
+        struct ring *ring = *p;
+        // read before head, so that a dead ring is drained completely
+        bool     dead = __atomic_load_n(&ring->dead, __ATOMIC_ACQUIRE);
+        uint64_t head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+
+        ring_drain(ring, head);
+
+        if (dead) {
+            *p = ring->next;
+            dropped += ring->dropped;
+            free(ring);
+        } else {
+            p = &ring->next;
+        }
+    }
+
+    pthread_mutex_unlock(&rings_mtx);
+
+    HASH_ITER(hh, closes, close, ctmp)
+    {
+        HASH_FIND_STR(files, close->node, file);
+        if (file != NULL) {
+            HASH_DEL(files, file);
+            fclose(file->fp);
+            free(file);
+        }
+        HASH_DEL(closes, close);
+        free(close);
+    }
+
+    HASH_ITER(hh, files, file, tmp)
+    {
+        fflush(file->fp);
+    }
+    pthread_mutex_unlock(&flush_mtx);
+}
+
+uint64_t neu_capture_dropped(void)
+{
+    uint64_t n = 0;
+
+    pthread_mutex_lock(&rings_mtx);
+    n = dropped;
+    for (struct ring *ring = rings; ring != NULL; ring = ring->next) {
+        n += __atomic_load_n(&ring->dropped, __ATOMIC_RELAXED);
+    }
+    pthread_mutex_unlock(&rings_mtx);
+
+    return n;
+}
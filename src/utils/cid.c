@@ -18,179 +18,206 @@
  **/
 
 #include <jansson.h>
-#include <libxml/parser.h>
-#include <libxml/tree.h>
+#include <libxml/xmlreader.h>
 
 #include "define.h"
 #include "utils/cid.h"
 #include "utils/log.h"
+#include "utils/uthash.h"
 #include "json/json.h"
 
-static int parse_ied(xmlNode *xml_ied, cid_ied_t *ied);
-static int parse_template(xmlNode *xml_template, cid_template_t *template);
-static int parse_ldevice(xmlNode *xml_server, cid_access_point_t *ap);
-static int parse_lnode(xmlNode *xml_ldevice, cid_ldevice_t *ldev);
-static int parse_dataset(xmlNode *xml_dataset, cid_ln_t *ln);
-static int parse_report(xmlNode *xml_report, cid_ln_t *ln);
-static int parse_doi(xmlNode *xml_doi, cid_ln_t *ln);
+#define CID_DA_TYPES_MAX 32
 
-static void fill_fcda_type(cid_t *cid);
-static void fill_doi_ctls(cid_t *cid);
+typedef struct cid_tm_index {
+    const char *       id;
+    cid_tm_lno_type_t *lnotype;
+    cid_tm_do_type_t * dotype;
+    cid_tm_da_type_t * datype;
+    UT_hash_handle     hh;
+} cid_tm_index_t;
+
+// position in the second pass over the file, IED by IED
+typedef struct {
+    xmlTextReaderPtr reader;
+    cid_template_t * template;
+    int              ret; // of the last read, 1 while there are nodes left
+
+    char ied_name[NEU_CID_IED_NAME_LEN];
+    char ap_name[NEU_CID_ACCESS_POINT_NAME_LEN];
+    bool ap_seen;     // only the first AccessPoint of an IED is used
+    bool server_seen; // and its first Server
+    int  n_server;
+} cid_stream_t;
+
+struct neu_cid_reader {
+    cid_stream_t       stream;
+    cid_template_t     cid_template;
+    neu_req_add_gtag_t pending; // groups of the current LDevice
+    int                next;    // first pending group not handed out
+    bool               failed;
+};
+
+static int  stream_open(cid_stream_t *stream, const char *path,
+                        cid_template_t *template);
+static int  stream_next(cid_stream_t *stream, cid_ldevice_t *ldev);
+static void ldevice_free(cid_ldevice_t *ldev);
+static void ldevice_to_groups(const char *ied_name, const char *ap_name,
+                              cid_ldevice_t *ld, neu_req_add_gtag_t *cmd);
 
 int neu_cid_parse(const char *path, cid_t *cid)
 {
+    cid_stream_t  stream   = { 0 };
+    cid_ldevice_t ldev     = { 0 };
+    int           n_server = 0;
+    int           ret      = 0;
+
     memset(cid, 0, sizeof(cid_t));
-    xmlDoc *doc = xmlReadFile(path, NULL, 0);
-    if (doc == NULL) {
-        nlog_warn("Failed to read icd file %s", path);
-        return -1;
-    }
-    xmlNode *root = xmlDocGetRootElement(doc);
-    if (root == NULL || strcmp((const char *) root->name, "SCL") != 0) {
-        nlog_warn("Failed to get root element(SCL)");
-        xmlFreeDoc(doc);
+    if (stream_open(&stream, path, &cid->cid_template) != 0) {
+        neu_cid_free(cid);
         return -1;
     }
 
-    xmlNode *find             = root->children;
-    bool     ied_parsed       = false;
-    bool     templates_parsed = false;
-    while (find != NULL) {
-        if (find->type == XML_ELEMENT_NODE &&
-            strcmp((const char *) find->name, "DataTypeTemplates") == 0) {
-            int ret = parse_template(find, &cid->cid_template);
-            if (ret == 0) {
-                templates_parsed = true;
-            }
-        }
+    while ((ret = stream_next(&stream, &ldev)) == 1) {
+        cid_ied_t *ied = &cid->ied;
 
-        find = find->next;
-    }
-    xmlNode *find_ied = root->children;
-    while (find_ied != NULL) {
-        if (find_ied->type == XML_ELEMENT_NODE &&
-            strcmp((const char *) find_ied->name, "IED") == 0) {
-            int ret = parse_ied(find_ied, &cid->ied);
-            if (ret == 0) {
-                ied_parsed = true;
-            }
+        if (stream.n_server != n_server) {
+            n_server = stream.n_server;
+            ied->n_access_points += 1;
+            ied->access_points =
+                realloc(ied->access_points,
+                        ied->n_access_points * sizeof(cid_access_point_t));
+            cid_access_point_t *ap =
+                &ied->access_points[ied->n_access_points - 1];
+            memset(ap, 0, sizeof(cid_access_point_t));
+            strcpy(ap->name, stream.ap_name);
         }
 
-        find_ied = find_ied->next;
+        cid_access_point_t *ap = &ied->access_points[ied->n_access_points - 1];
+        ap->n_ldevices += 1;
+        ap->ldevices =
+            realloc(ap->ldevices, ap->n_ldevices * sizeof(cid_ldevice_t));
+        ap->ldevices[ap->n_ldevices - 1] = ldev;
     }
+    strcpy(cid->ied.name, stream.ied_name);
+    xmlFreeTextReader(stream.reader);
 
-    if (ied_parsed && templates_parsed) {
-        xmlFreeDoc(doc);
-        fill_fcda_type(cid);
-        fill_doi_ctls(cid);
-        return 0;
-    } else {
+    if (ret != 0) {
         neu_cid_free(cid);
-        nlog_warn("Failed to parse IED or DataTypeTemplates, %d, %d",
-                  ied_parsed, templates_parsed);
-        xmlFreeDoc(doc);
         return -1;
     }
+
+    return 0;
 }
 
-void neu_cid_free(cid_t *cid)
+static void template_free(cid_template_t *template)
 {
-    for (int i = 0; i < cid->cid_template.n_lnotypes; i++) {
-        free(cid->cid_template.lnotypes[i].dos);
-    }
-    for (int i = 0; i < cid->cid_template.n_dotypes; i++) {
-        free(cid->cid_template.dotypes[i].das);
-        if (cid->cid_template.dotypes[i].n_sdos > 0) {
-            free(cid->cid_template.dotypes[i].sdos);
-        }
+    cid_tm_index_t *entry = NULL, *tmp = NULL;
+
+    HASH_ITER(hh, template->index, entry, tmp)
+    {
+        HASH_DEL(template->index, entry);
+        free(entry);
     }
-    for (int i = 0; i < cid->cid_template.n_datypes; i++) {
-        free(cid->cid_template.datypes[i].bdas);
+
+    for (int i = 0; i < template->n_lnotypes; i++) {
+        free(template->lnotypes[i].dos);
     }
-    if (cid->cid_template.n_lnotypes > 0) {
-        free(cid->cid_template.lnotypes);
+    for (int i = 0; i < template->n_dotypes; i++) {
+        free(template->dotypes[i].das);
+        free(template->dotypes[i].sdos);
     }
-    if (cid->cid_template.n_dotypes > 0) {
-        free(cid->cid_template.dotypes);
+    for (int i = 0; i < template->n_datypes; i++) {
+        free(template->datypes[i].bdas);
     }
-    if (cid->cid_template.n_datypes > 0) {
-        free(cid->cid_template.datypes);
+    free(template->lnotypes);
+    free(template->dotypes);
+    free(template->datypes);
+    memset(template, 0, sizeof(cid_template_t));
+}
+
+static void ldevice_free(cid_ldevice_t *ldev)
+{
+    for (int i = 0; i < ldev->n_lns; i++) {
+        cid_ln_t *ln = &ldev->lns[i];
+
+        for (int j = 0; j < ln->n_datasets; j++) {
+            free(ln->datasets[j].fcdas);
+        }
+        for (int j = 0; j < ln->n_dois; j++) {
+            free(ln->dois[j].dais);
+            free(ln->dois[j].ctls);
+        }
+        free(ln->datasets);
+        free(ln->dois);
+        free(ln->reports);
     }
+    free(ldev->lns);
+    memset(ldev, 0, sizeof(cid_ldevice_t));
+}
+
+void neu_cid_free(cid_t *cid)
+{
+    template_free(&cid->cid_template);
 
     for (int i = 0; i < cid->ied.n_access_points; i++) {
         for (int j = 0; j < cid->ied.access_points[i].n_ldevices; j++) {
-            for (int k = 0; k < cid->ied.access_points[i].ldevices[j].n_lns;
-                 k++) {
-                for (int l = 0; l <
-                     cid->ied.access_points[i].ldevices[j].lns[k].n_datasets;
-                     l++) {
-                    if (cid->ied.access_points[i]
-                            .ldevices[j]
-                            .lns[k]
-                            .datasets[l]
-                            .n_fcda > 0) {
-                        free(cid->ied.access_points[i]
-                                 .ldevices[j]
-                                 .lns[k]
-                                 .datasets[l]
-                                 .fcdas);
-                    }
-                }
-                if (cid->ied.access_points[i].ldevices[j].lns[k].n_datasets >
-                    0) {
-                    free(cid->ied.access_points[i].ldevices[j].lns[k].datasets);
-                }
+            ldevice_free(&cid->ied.access_points[i].ldevices[j]);
+        }
+        free(cid->ied.access_points[i].ldevices);
+    }
+    free(cid->ied.access_points);
+    cid->ied.access_points   = NULL;
+    cid->ied.n_access_points = 0;
+}
 
-                for (int l = 0;
-                     l < cid->ied.access_points[i].ldevices[j].lns[k].n_dois;
-                     l++) {
-                    if (cid->ied.access_points[i]
-                            .ldevices[j]
-                            .lns[k]
-                            .dois[l]
-                            .n_dais > 0) {
-                        free(cid->ied.access_points[i]
-                                 .ldevices[j]
-                                 .lns[k]
-                                 .dois[l]
-                                 .dais);
-                    }
-                    if (cid->ied.access_points[i]
-                            .ldevices[j]
-                            .lns[k]
-                            .dois[l]
-                            .n_ctls > 0) {
-                        free(cid->ied.access_points[i]
-                                 .ldevices[j]
-                                 .lns[k]
-                                 .dois[l]
-                                 .ctls);
-                    }
-                }
-                if (cid->ied.access_points[i].ldevices[j].lns[k].n_dois > 0) {
-                    free(cid->ied.access_points[i].ldevices[j].lns[k].dois);
-                }
-                if (cid->ied.access_points[i].ldevices[j].lns[k].n_reports >
-                    0) {
-                    free(cid->ied.access_points[i].ldevices[j].lns[k].reports);
-                }
-            }
+/// **************** Template lookup **************** ///
+static cid_tm_index_t *index_entry(cid_template_t *template, const char *id)
+{
+    cid_tm_index_t *entry = NULL;
+
+    HASH_FIND_STR(template->index, id, entry);
+    if (entry == NULL) {
+        entry     = calloc(1, sizeof(cid_tm_index_t));
+        entry->id = id;
+        HASH_ADD_KEYPTR(hh, template->index, entry->id, strlen(entry->id),
+                        entry);
+    }
 
-            if (cid->ied.access_points[i].ldevices[j].n_lns > 0) {
-                free(cid->ied.access_points[i].ldevices[j].lns);
-            }
-        }
+    return entry;
+}
 
-        if (cid->ied.access_points[i].n_ldevices > 0) {
-            free(cid->ied.access_points[i].ldevices);
+// the first type of each kind wins on duplicate ids, as with a linear search
+static void index_template(cid_template_t *template)
+{
+    for (int i = 0; i < template->n_lnotypes; i++) {
+        cid_tm_index_t *entry =
+            index_entry(template, template->lnotypes[i].id);
+        if (entry->lnotype == NULL) {
+            entry->lnotype = &template->lnotypes[i];
         }
     }
-
-    if (cid->ied.n_access_points > 0) {
-        free(cid->ied.access_points);
+    for (int i = 0; i < template->n_dotypes; i++) {
+        cid_tm_index_t *entry = index_entry(template, template->dotypes[i].id);
+        if (entry->dotype == NULL) {
+            entry->dotype = &template->dotypes[i];
+        }
+    }
+    for (int i = 0; i < template->n_datypes; i++) {
+        cid_tm_index_t *entry = index_entry(template, template->datypes[i].id);
+        if (entry->datype == NULL) {
+            entry->datype = &template->datypes[i];
+        }
     }
 }
 
+static cid_tm_index_t *find_type(cid_template_t *template, const char *id)
+{
+    cid_tm_index_t *entry = NULL;
+
+    HASH_FIND_STR(template->index, id, entry);
+    return entry;
+}
+
 static const char *find_type_id(cid_ldevice_t *ldev, const char *prefix,
                                 const char *ln_class, const char *ln_inst)
 {
@@ -207,19 +234,13 @@ static const char *find_type_id(cid_ldevice_t *ldev, const char *prefix,
 static cid_tm_do_type_t *find_do_type(cid_template_t *template,
                                       const char *type_id, const char *do_name)
 {
-    cid_tm_lno_type_t *lno      = NULL;
+    cid_tm_index_t *   entry    = find_type(template, type_id);
+    cid_tm_lno_type_t *lno      = entry != NULL ? entry->lnotype : NULL;
     cid_tm_do_type_t * dotype   = NULL;
     char *             ref_type = NULL;
 
     char *do_name_end = strchr(do_name, '.');
 
-    for (int i = 0; i < template->n_lnotypes; i++) {
-        if (strcmp(template->lnotypes[i].id, type_id) == 0) {
-            lno = &template->lnotypes[i];
-            break;
-        }
-    }
-
     if (lno != NULL) {
         for (int i = 0; i < lno->n_dos; i++) {
             if (do_name_end != NULL) {
@@ -240,12 +261,8 @@ static cid_tm_do_type_t *find_do_type(cid_template_t *template,
     }
 
     if (ref_type != NULL) {
-        for (int i = 0; i < template->n_dotypes; i++) {
-            if (strcmp(template->dotypes[i].id, ref_type) == 0) {
-                dotype = &template->dotypes[i];
-                break;
-            }
-        }
+        entry  = find_type(template, ref_type);
+        dotype = entry != NULL ? entry->dotype : NULL;
     } else {
         nlog_warn("Failed to find ref type %s, %s", type_id, do_name);
     }
@@ -253,12 +270,9 @@ static cid_tm_do_type_t *find_do_type(cid_template_t *template,
     if (dotype != NULL && do_name_end != NULL) {
         for (int i = 0; i < dotype->n_sdos; i++) {
             if (strcmp(dotype->sdos[i].name, do_name_end + 1) == 0) {
-                ref_type = dotype->sdos[i].ref_type;
-                for (int j = 0; j < template->n_dotypes; j++) {
-                    if (strcmp(template->dotypes[j].id, ref_type) == 0) {
-                        dotype = &template->dotypes[j];
-                        break;
-                    }
+                entry = find_type(template, dotype->sdos[i].ref_type);
+                if (entry != NULL && entry->dotype != NULL) {
+                    dotype = entry->dotype;
                 }
                 break;
             }
@@ -274,31 +288,32 @@ typedef struct {
 } da_basic_type_t;
 
 static int find_da_basic_type(cid_template_t *template, const char *datype_id,
-                              const char *seg_name, da_basic_type_t *da_types)
+                              const char *seg_name, da_basic_type_t *da_types,
+                              int max)
 {
-    char name[NEU_CID_LEN64] = { 0 };
-    int  index               = 0;
-    for (int i = 0; i < template->n_datypes; i++) {
-        if (strcmp(template->datypes[i].id, datype_id) == 0) {
-            for (int j = 0; j < template->datypes[i].n_bdas; j++) {
-                if (strlen(seg_name) > 0) {
-                    snprintf(name, sizeof(name), "%s.%s", seg_name,
-                             template->datypes[i].bdas[j].name);
-                } else {
-                    snprintf(name, sizeof(name), "%s",
-                             template->datypes[i].bdas[j].name);
-                }
-                if (template->datypes[i].bdas[j].btype == Struct) {
-                    index += find_da_basic_type(
-                        template, template->datypes[i].bdas[j].ref_type, name,
-                        da_types + index);
-                } else {
-                    strcpy(da_types[index].all_name, name);
-                    da_types[index].btype = template->datypes[i].bdas[j].btype;
-                    index += 1;
-                }
-            }
-            break;
+    char              name[NEU_CID_LEN64] = { 0 };
+    int               index               = 0;
+    cid_tm_index_t *  entry  = find_type(template, datype_id);
+    cid_tm_da_type_t *datype = entry != NULL ? entry->datype : NULL;
+
+    if (datype == NULL) {
+        return 0;
+    }
+
+    for (int j = 0; j < datype->n_bdas && index < max; j++) {
+        if (strlen(seg_name) > 0) {
+            snprintf(name, sizeof(name), "%s.%s", seg_name,
+                     datype->bdas[j].name);
+        } else {
+            snprintf(name, sizeof(name), "%s", datype->bdas[j].name);
+        }
+        if (datype->bdas[j].btype == Struct) {
+            index += find_da_basic_type(template, datype->bdas[j].ref_type,
+                                        name, da_types + index, max - index);
+        } else {
+            strcpy(da_types[index].all_name, name);
+            da_types[index].btype = datype->bdas[j].btype;
+            index += 1;
         }
     }
 
@@ -331,9 +346,10 @@ static int find_basic_type(cid_template_t *template, const char *type_id,
             continue;
         }
 
-        da_basic_type_t da_types[32] = { 0 };
-        int n_da_types = find_da_basic_type(template, dotype->das[i].ref_type,
-                                            dotype->das[i].name, da_types);
+        da_basic_type_t da_types[CID_DA_TYPES_MAX] = { 0 };
+        int             n_da_types                 = find_da_basic_type(
+            template, dotype->das[i].ref_type, dotype->das[i].name, da_types,
+            CID_DA_TYPES_MAX);
         for (int j = 0; j < n_da_types; j++) {
             if (strlen(da_name) > 0) {
                 if (strcmp(da_types[j].all_name, da_name) == 0) {
@@ -390,32 +406,6 @@ static void update_dataset(cid_dataset_t *dataset, cid_ldevice_t *ldev,
     }
 }
 
-static void fill_fcda_type(cid_t *cid)
-{
-    for (int i = 0; i < cid->ied.n_access_points; i++) {
-        for (int j = 0; j < cid->ied.access_points[i].n_ldevices; j++) {
-            cid_ldevice_t *ldev = &cid->ied.access_points[i].ldevices[j];
-            for (int k = 0; k < cid->ied.access_points[i].ldevices[j].n_lns;
-                 k++) {
-                if (cid->ied.access_points[i].ldevices[j].lns[k].n_datasets >
-                    0) {
-                    for (int l = 0; l < cid->ied.access_points[i]
-                                            .ldevices[j]
-                                            .lns[k]
-                                            .n_datasets;
-                         l++) {
-                        update_dataset(&cid->ied.access_points[i]
-                                            .ldevices[j]
-                                            .lns[k]
-                                            .datasets[l],
-                                       ldev, &cid->cid_template);
-                    }
-                }
-            }
-        }
-    }
-}
-
 static void update_doi(const char *ref_type, cid_doi_t *dois, int n_dois,
                        cid_template_t *template)
 {
@@ -445,9 +435,10 @@ static void update_doi(const char *ref_type, cid_doi_t *dois, int n_dois,
                 }
             }
 
-            da_basic_type_t da_types[32] = { 0 };
-            int             n_da_types   = find_da_basic_type(
-                template, tm_do->das[k].ref_type, tm_do->das[k].name, da_types);
+            da_basic_type_t da_types[CID_DA_TYPES_MAX] = { 0 };
+            int             n_da_types                 = find_da_basic_type(
+                template, tm_do->das[k].ref_type, tm_do->das[k].name, da_types,
+                CID_DA_TYPES_MAX);
 
             if (da->fc == SP || da->fc == SG) {
                 for (int j = 0; j < n_da_types; j++) {
@@ -474,7 +465,12 @@ static void update_doi(const char *ref_type, cid_doi_t *dois, int n_dois,
                 ctl->fc    = da->fc;
                 strcpy(ctl->da_name, da->name);
                 ctl->n_co_types = n_da_types;
-                for (int j = 0; j < n_da_types; j++) {
+                if (n_da_types > (int) (sizeof(ctl->co_types) /
+                                        sizeof(ctl->co_types[0]))) {
+                    ctl->n_co_types =
+                        sizeof(ctl->co_types) / sizeof(ctl->co_types[0]);
+                }
+                for (int j = 0; j < ctl->n_co_types; j++) {
                     ctl->co_types[j] = da_types[j].btype;
                 }
             }
@@ -482,287 +478,132 @@ static void update_doi(const char *ref_type, cid_doi_t *dois, int n_dois,
     }
 }
 
-static void fill_doi_ctls(cid_t *cid)
+// fill in the basic types of an LDevice, its LNs only refer to each other
+static void resolve_ldevice(cid_ldevice_t *ldev, cid_template_t *template)
 {
-    for (int i = 0; i < cid->ied.n_access_points; i++) {
-        for (int j = 0; j < cid->ied.access_points[i].n_ldevices; j++) {
-            for (int k = 0; k < cid->ied.access_points[i].ldevices[j].n_lns;
-                 k++) {
-                update_doi(cid->ied.access_points[i].ldevices[j].lns[k].lntype,
-                           cid->ied.access_points[i].ldevices[j].lns[k].dois,
-                           cid->ied.access_points[i].ldevices[j].lns[k].n_dois,
-                           &cid->cid_template);
-            }
+    for (int i = 0; i < ldev->n_lns; i++) {
+        cid_ln_t *ln = &ldev->lns[i];
+
+        for (int j = 0; j < ln->n_datasets; j++) {
+            update_dataset(&ln->datasets[j], ldev, template);
         }
+        update_doi(ln->lntype, ln->dois, ln->n_dois, template);
     }
 }
 
-static int parse_ied(xmlNode *xml_ied, cid_ied_t *ied)
+/// **************** Reading **************** ///
+static bool is_element(xmlTextReaderPtr reader, const char *name)
 {
-    int   ret      = -1;
-    char *ied_name = (char *) xmlGetProp(xml_ied, (const xmlChar *) "name");
-    if (strlen(ied_name) >= NEU_CID_IED_NAME_LEN) {
-        xmlFree(ied_name);
-        nlog_warn("IED name is too long");
-        return -1;
-    } else {
-        strcpy(ied->name, ied_name);
-        xmlFree(ied_name);
-    }
-    xmlNode *access_point = xml_ied->children;
-    while (access_point != NULL) {
-        if (access_point->type == XML_ELEMENT_NODE &&
-            strcmp((const char *) access_point->name, "AccessPoint") == 0) {
-            char *name =
-                (char *) xmlGetProp(access_point, (const xmlChar *) "name");
-            ied->n_access_points += 1;
-            ied->access_points =
-                realloc(ied->access_points,
-                        ied->n_access_points * sizeof(cid_access_point_t));
-            cid_access_point_t *ap =
-                &ied->access_points[ied->n_access_points - 1];
-            memset(ap, 0, sizeof(cid_access_point_t));
+    return strcmp((const char *) xmlTextReaderConstLocalName(reader), name) ==
+        0;
+}
 
-            if (name != NULL) {
-                strcpy(ap->name, name);
-                xmlFree(name);
-            }
+static char *get_attr(xmlTextReaderPtr reader, const char *name)
+{
+    return (char *) xmlTextReaderGetAttribute(reader, (const xmlChar *) name);
+}
 
-            xmlNode *server = access_point->children;
-            while (server != NULL) {
-                if (server->type == XML_ELEMENT_NODE &&
-                    strcmp((const char *) server->name, "Server") == 0) {
-                    ret = parse_ldevice(server, ap);
-                    break;
-                }
+static bool copy_attr(xmlTextReaderPtr reader, const char *name, char *buf,
+                      size_t size)
+{
+    char *value = get_attr(reader, name);
 
-                server = server->next;
-            }
-            break;
-        }
-        access_point = access_point->next;
+    if (value == NULL) {
+        return false;
     }
+    strncpy(buf, value, size - 1);
+    xmlFree(value);
+    return true;
+}
 
-    return ret;
+static int line(xmlTextReaderPtr reader)
+{
+    return xmlTextReaderGetParserLineNumber(reader);
 }
 
-static int parse_ldevice(xmlNode *xml_server, cid_access_point_t *ap)
+// move to the next child element of the element at `depth`, returns 1 on a
+// child, 0 once past the end of the element and -1 on a parse error
+static int next_child(xmlTextReaderPtr reader, int depth)
 {
-    ap->ldevices     = NULL;
-    ap->n_ldevices   = 0;
-    xmlNode *ldevice = xml_server->children;
+    int ret = 0;
 
-    while (ldevice != NULL) {
-        if (ldevice->type != XML_ELEMENT_NODE) {
-            ldevice = ldevice->next;
-            continue;
+    while ((ret = xmlTextReaderRead(reader)) == 1) {
+        int d = xmlTextReaderDepth(reader);
+
+        if (d <= depth) {
+            return 0;
         }
-        if (strcmp((const char *) ldevice->name, "LDevice") == 0) {
-            ap->n_ldevices += 1;
-            ap->ldevices =
-                realloc(ap->ldevices, ap->n_ldevices * sizeof(cid_ldevice_t));
-            cid_ldevice_t *ldev = &ap->ldevices[ap->n_ldevices - 1];
-            memset(ldev, 0, sizeof(cid_ldevice_t));
-            char *inst = (char *) xmlGetProp(ldevice, (const xmlChar *) "inst");
-            if (inst != NULL) {
-                strcpy(ldev->inst, inst);
-                xmlFree(inst);
-            }
-            int ret = parse_lnode(ldevice, ldev);
-            if (ret != 0) {
-                return ret;
-            }
+        if (d == depth + 1 &&
+            xmlTextReaderNodeType(reader) == XML_READER_TYPE_ELEMENT) {
+            return 1;
         }
-
-        ldevice = ldevice->next;
     }
 
-    return 0;
+    return ret;
 }
 
-static int parse_lnode(xmlNode *xml_ldevice, cid_ldevice_t *ldev)
+static void parse_dataset(xmlTextReaderPtr reader, cid_ln_t *ln)
 {
-    xmlNode *lnode = xml_ldevice->children;
-    while (lnode != NULL) {
-        if (lnode->type == XML_ELEMENT_NODE &&
-            strncmp((const char *) lnode->name, "LN", 2) == 0) {
-            char *ln_class =
-                (char *) xmlGetProp(lnode, (const xmlChar *) "lnClass");
-            char *ln_type =
-                (char *) xmlGetProp(lnode, (const xmlChar *) "lnType");
-            char *ln_prefix =
-                (char *) xmlGetProp(lnode, (const xmlChar *) "prefix");
-            char *ln_inst =
-                (char *) xmlGetProp(lnode, (const xmlChar *) "inst");
-
-            ldev->n_lns += 1;
-            ldev->lns    = realloc(ldev->lns, ldev->n_lns * sizeof(cid_ln_t));
-            cid_ln_t *ln = &ldev->lns[ldev->n_lns - 1];
-            memset(ln, 0, sizeof(cid_ln_t));
-
-            if (ln_class != NULL) {
-                strncpy(ln->lnclass, ln_class, sizeof(ln->lnclass) - 1);
-                xmlFree(ln_class);
-            }
-            if (ln_type != NULL) {
-                strncpy(ln->lntype, ln_type, sizeof(ln->lntype) - 1);
-                xmlFree(ln_type);
-            }
-            if (ln_prefix != NULL) {
-                strncpy(ln->lnprefix, ln_prefix, sizeof(ln->lnprefix) - 1);
-                xmlFree(ln_prefix);
-            }
-            if (ln_inst != NULL) {
-                strncpy(ln->lninst, ln_inst, sizeof(ln->lninst) - 1);
-                xmlFree(ln_inst);
-            }
-
-            xmlNode *child = lnode->children;
-            while (child != NULL) {
-                if (child->type != XML_ELEMENT_NODE) {
-                    child = child->next;
-                    continue;
-                }
-
-                if (strcmp((const char *) child->name, "DataSet") == 0) {
-                    int ret = parse_dataset(child, ln);
-                    if (ret != 0) {
-                        return ret;
-                    }
-                }
-                if (strcmp((const char *) child->name, "ReportControl") == 0) {
-                    int ret = parse_report(child, ln);
-                    if (ret != 0) {
-                        return ret;
-                    }
-                }
-                if (strcmp((const char *) child->name, "DOI") == 0) {
-                    int ret = parse_doi(child, ln);
-                    if (ret != 0) {
-                        return ret;
-                    }
-                }
-
-                child = child->next;
-            }
-        }
+    int   depth        = xmlTextReaderDepth(reader);
+    bool  empty        = xmlTextReaderIsEmptyElement(reader);
+    char *dataset_name = get_attr(reader, "name");
 
-        lnode = lnode->next;
+    if (dataset_name == NULL) {
+        return;
     }
 
-    return 0;
-}
+    ln->n_datasets += 1;
+    ln->datasets =
+        realloc(ln->datasets, ln->n_datasets * sizeof(cid_dataset_t));
+    cid_dataset_t *dataset = &ln->datasets[ln->n_datasets - 1];
+    memset(dataset, 0, sizeof(cid_dataset_t));
 
-static int parse_dataset(xmlNode *xml_dataset, cid_ln_t *ln)
-{
-    char *dataset_name =
-        (char *) xmlGetProp(xml_dataset, (const xmlChar *) "name");
-    if (dataset_name != NULL) {
-        ln->n_datasets += 1;
-        ln->datasets =
-            realloc(ln->datasets, ln->n_datasets * sizeof(cid_dataset_t));
-        cid_dataset_t *dataset = &ln->datasets[ln->n_datasets - 1];
-        memset(dataset, 0, sizeof(cid_dataset_t));
-
-        strncpy(dataset->name, dataset_name, sizeof(dataset->name) - 1);
-        xmlFree(dataset_name);
-
-        xmlNode *xfcda = xml_dataset->children;
-        while (xfcda != NULL) {
-            if (xfcda->type != XML_ELEMENT_NODE) {
-                xfcda = xfcda->next;
-                continue;
-            }
+    strncpy(dataset->name, dataset_name, sizeof(dataset->name) - 1);
+    xmlFree(dataset_name);
 
-            if (strcmp((const char *) xfcda->name, "FCDA") == 0) {
-                char *da_name =
-                    (char *) xmlGetProp(xfcda, (const xmlChar *) "daName");
-                char *do_name =
-                    (char *) xmlGetProp(xfcda, (const xmlChar *) "doName");
-                char *fc = (char *) xmlGetProp(xfcda, (const xmlChar *) "fc");
-                char *ln_inst =
-                    (char *) xmlGetProp(xfcda, (const xmlChar *) "lnInst");
-                char *ln_class =
-                    (char *) xmlGetProp(xfcda, (const xmlChar *) "lnClass");
-                char *ld_inst =
-                    (char *) xmlGetProp(xfcda, (const xmlChar *) "ldInst");
-                char *prefix =
-                    (char *) xmlGetProp(xfcda, (const xmlChar *) "prefix");
-
-                dataset->n_fcda += 1;
-                dataset->fcdas   = realloc(dataset->fcdas,
-                                         dataset->n_fcda * sizeof(cid_fcda_t));
-                cid_fcda_t *fcda = &dataset->fcdas[dataset->n_fcda - 1];
-                memset(fcda, 0, sizeof(cid_fcda_t));
-
-                if (da_name != NULL) {
-                    strncpy(fcda->da_name, da_name, sizeof(fcda->da_name) - 1);
-                    xmlFree(da_name);
-                }
-                if (do_name != NULL) {
-                    strncpy(fcda->do_name, do_name, sizeof(fcda->do_name) - 1);
-                    xmlFree(do_name);
-                }
-                if (ln_class != NULL) {
-                    strncpy(fcda->lnclass, ln_class, sizeof(fcda->lnclass) - 1);
-                    xmlFree(ln_class);
-                }
-                if (prefix != NULL) {
-                    strncpy(fcda->prefix, prefix, sizeof(fcda->prefix) - 1);
-                    xmlFree(prefix);
-                }
-                if (ln_inst != NULL) {
-                    strncpy(fcda->lninst, ln_inst, sizeof(fcda->lninst) - 1);
-                    xmlFree(ln_inst);
-                }
-                if (ld_inst != NULL) {
-                    strncpy(fcda->ldinst, ld_inst, sizeof(fcda->ldinst) - 1);
-                    xmlFree(ld_inst);
-                }
-                fcda->fc = F_UNKNOWN;
-                if (fc != NULL) {
-                    fcda->fc = decode_fc((const char *) fc);
-                    xmlFree(fc);
-                }
-                if (fcda->fc == F_UNKNOWN) {
-                    nlog_warn("Unknown FC %d", (int) xfcda->line);
-                }
-            }
+    while (!empty && next_child(reader, depth) == 1) {
+        if (!is_element(reader, "FCDA")) {
+            continue;
+        }
 
-            xfcda = xfcda->next;
+        dataset->n_fcda += 1;
+        dataset->fcdas =
+            realloc(dataset->fcdas, dataset->n_fcda * sizeof(cid_fcda_t));
+        cid_fcda_t *fcda = &dataset->fcdas[dataset->n_fcda - 1];
+        memset(fcda, 0, sizeof(cid_fcda_t));
+
+        copy_attr(reader, "daName", fcda->da_name, sizeof(fcda->da_name));
+        copy_attr(reader, "doName", fcda->do_name, sizeof(fcda->do_name));
+        copy_attr(reader, "lnClass", fcda->lnclass, sizeof(fcda->lnclass));
+        copy_attr(reader, "prefix", fcda->prefix, sizeof(fcda->prefix));
+        copy_attr(reader, "lnInst", fcda->lninst, sizeof(fcda->lninst));
+        copy_attr(reader, "ldInst", fcda->ldinst, sizeof(fcda->ldinst));
+
+        char *fc = get_attr(reader, "fc");
+        fcda->fc = F_UNKNOWN;
+        if (fc != NULL) {
+            fcda->fc = decode_fc((const char *) fc);
+            xmlFree(fc);
+        }
+        if (fcda->fc == F_UNKNOWN) {
+            nlog_warn("Unknown FC %d", line(reader));
         }
     }
-    return 0;
 }
 
-static int parse_report(xmlNode *xml_report, cid_ln_t *ln)
+static void parse_report(xmlTextReaderPtr reader, cid_ln_t *ln)
 {
-    char *report_name =
-        (char *) xmlGetProp(xml_report, (const xmlChar *) "name");
-    char *report_id =
-        (char *) xmlGetProp(xml_report, (const xmlChar *) "rptID");
-    char *dataset = (char *) xmlGetProp(xml_report, (const xmlChar *) "datSet");
-    char *buffered =
-        (char *) xmlGetProp(xml_report, (const xmlChar *) "buffered");
-    char *intg_pd = (char *) xmlGetProp(xml_report, (const xmlChar *) "intgPd");
+    char *buffered = get_attr(reader, "buffered");
+    char *intg_pd  = get_attr(reader, "intgPd");
 
     ln->n_reports += 1;
     ln->reports = realloc(ln->reports, ln->n_reports * sizeof(cid_report_t));
     cid_report_t *report = &ln->reports[ln->n_reports - 1];
     memset(report, 0, sizeof(cid_report_t));
 
-    if (report_name != NULL) {
-        strncpy(report->name, report_name, sizeof(report->name) - 1);
-        xmlFree(report_name);
-    }
-    if (report_id != NULL) {
-        strncpy(report->id, report_id, sizeof(report->id) - 1);
-        xmlFree(report_id);
-    }
-    if (dataset != NULL) {
-        strncpy(report->dataset, dataset, sizeof(report->dataset) - 1);
-        xmlFree(dataset);
-    }
+    copy_attr(reader, "name", report->name, sizeof(report->name));
+    copy_attr(reader, "rptID", report->id, sizeof(report->id));
+    copy_attr(reader, "datSet", report->dataset, sizeof(report->dataset));
     if (buffered != NULL) {
         if (strcmp(buffered, "true") == 0) {
             report->buffered = true;
@@ -780,337 +621,570 @@ static int parse_report(xmlNode *xml_report, cid_ln_t *ln)
         }
         xmlFree(intg_pd);
     }
+}
 
-    return 0;
+static void add_dai(xmlTextReaderPtr reader, cid_doi_t *doi,
+                    const char *sdi_name)
+{
+    char *dai_name = get_attr(reader, "name");
+
+    if (dai_name == NULL) {
+        return;
+    }
+
+    doi->n_dais += 1;
+    doi->dais      = realloc(doi->dais, doi->n_dais * sizeof(cid_dai_t));
+    cid_dai_t *dai = &doi->dais[doi->n_dais - 1];
+    memset(dai, 0, sizeof(cid_dai_t));
+
+    strncpy(dai->name, dai_name, sizeof(dai->name) - 1);
+    if (sdi_name != NULL) {
+        strncpy(dai->sdi_name, sdi_name, sizeof(dai->sdi_name) - 1);
+    }
+    xmlFree(dai_name);
 }
 
-static int parse_doi(xmlNode *xml_doi, cid_ln_t *ln)
+static void parse_doi(xmlTextReaderPtr reader, cid_ln_t *ln)
 {
-    char *name = (char *) xmlGetProp(xml_doi, (const xmlChar *) "name");
-    if (name != NULL) {
-        ln->n_dois += 1;
-        ln->dois       = realloc(ln->dois, ln->n_dois * sizeof(cid_doi_t));
-        cid_doi_t *doi = &ln->dois[ln->n_dois - 1];
-        memset(doi, 0, sizeof(cid_doi_t));
+    int   depth = xmlTextReaderDepth(reader);
+    bool  empty = xmlTextReaderIsEmptyElement(reader);
+    char *name  = get_attr(reader, "name");
 
-        strncpy(doi->name, name, sizeof(doi->name) - 1);
-        xmlFree(name);
+    if (name == NULL) {
+        return;
+    }
+
+    ln->n_dois += 1;
+    ln->dois       = realloc(ln->dois, ln->n_dois * sizeof(cid_doi_t));
+    cid_doi_t *doi = &ln->dois[ln->n_dois - 1];
+    memset(doi, 0, sizeof(cid_doi_t));
+
+    strncpy(doi->name, name, sizeof(doi->name) - 1);
+    xmlFree(name);
 
-        xmlNode *child = xml_doi->children;
-        while (child != NULL) {
-            if (child->type != XML_ELEMENT_NODE) {
-                child = child->next;
+    while (!empty && next_child(reader, depth) == 1) {
+        if (is_element(reader, "DAI")) {
+            add_dai(reader, doi, NULL);
+        } else if (is_element(reader, "SDI") &&
+                   !xmlTextReaderIsEmptyElement(reader)) {
+            int   sdi_depth = xmlTextReaderDepth(reader);
+            char *sdi_name  = get_attr(reader, "name");
+
+            if (sdi_name == NULL) {
                 continue;
             }
-            if (strcmp((const char *) child->name, "DAI") == 0) {
-                char *dai_name =
-                    (char *) xmlGetProp(child, (const xmlChar *) "name");
-                if (dai_name != NULL) {
-                    doi->n_dais += 1;
-                    doi->dais =
-                        realloc(doi->dais, doi->n_dais * sizeof(cid_dai_t));
-                    cid_dai_t *dai = &doi->dais[doi->n_dais - 1];
-                    memset(dai, 0, sizeof(cid_dai_t));
-
-                    strncpy(dai->name, dai_name, sizeof(dai->name) - 1);
-                    xmlFree(dai_name);
+            while (next_child(reader, sdi_depth) == 1) {
+                if (is_element(reader, "DAI")) {
+                    add_dai(reader, doi, sdi_name);
                 }
             }
+            xmlFree(sdi_name);
+        }
+    }
+}
 
-            if (strcmp((const char *) child->name, "SDI") == 0) {
-                char *sdi_name =
-                    (char *) xmlGetProp(child, (const xmlChar *) "name");
-                if (sdi_name != NULL) {
-                    xmlNode *dai = child->children;
-                    while (dai != NULL) {
-                        if (dai->type != XML_ELEMENT_NODE) {
-                            dai = dai->next;
-                            continue;
-                        }
+static void parse_lnode(xmlTextReaderPtr reader, cid_ldevice_t *ldev)
+{
+    int  depth = xmlTextReaderDepth(reader);
+    bool empty = xmlTextReaderIsEmptyElement(reader);
+
+    ldev->n_lns += 1;
+    ldev->lns    = realloc(ldev->lns, ldev->n_lns * sizeof(cid_ln_t));
+    cid_ln_t *ln = &ldev->lns[ldev->n_lns - 1];
+    memset(ln, 0, sizeof(cid_ln_t));
+
+    copy_attr(reader, "lnClass", ln->lnclass, sizeof(ln->lnclass));
+    copy_attr(reader, "lnType", ln->lntype, sizeof(ln->lntype));
+    copy_attr(reader, "prefix", ln->lnprefix, sizeof(ln->lnprefix));
+    copy_attr(reader, "inst", ln->lninst, sizeof(ln->lninst));
+
+    while (!empty && next_child(reader, depth) == 1) {
+        if (is_element(reader, "DataSet")) {
+            parse_dataset(reader, ln);
+        } else if (is_element(reader, "ReportControl")) {
+            parse_report(reader, ln);
+        } else if (is_element(reader, "DOI")) {
+            parse_doi(reader, ln);
+        }
+    }
+}
 
-                        if (strcmp((const char *) dai->name, "DAI") == 0) {
-                            char *dai_name = (char *) xmlGetProp(
-                                dai, (const xmlChar *) "name");
-                            if (dai_name != NULL) {
-                                doi->n_dais += 1;
-                                doi->dais = realloc(
-                                    doi->dais, doi->n_dais * sizeof(cid_dai_t));
-                                cid_dai_t *t_dai = &doi->dais[doi->n_dais - 1];
-                                memset(t_dai, 0, sizeof(cid_dai_t));
-
-                                strncpy(t_dai->name, dai_name,
-                                        sizeof(t_dai->name) - 1);
-                                strncpy(t_dai->sdi_name, sdi_name,
-                                        sizeof(t_dai->sdi_name) - 1);
-                                xmlFree(dai_name);
-                            }
-                        }
+static void parse_ldevice(xmlTextReaderPtr reader, cid_ldevice_t *ldev)
+{
+    int  depth = xmlTextReaderDepth(reader);
+    bool empty = xmlTextReaderIsEmptyElement(reader);
 
-                        dai = dai->next;
-                    }
-                    xmlFree(sdi_name);
-                }
+    memset(ldev, 0, sizeof(cid_ldevice_t));
+    copy_attr(reader, "inst", ldev->inst, sizeof(ldev->inst));
+
+    while (!empty && next_child(reader, depth) == 1) {
+        const char *name = (const char *) xmlTextReaderConstLocalName(reader);
+
+        if (strncmp(name, "LN", 2) == 0) {
+            parse_lnode(reader, ldev);
+        }
+    }
+}
+
+static void parse_lnotype(xmlTextReaderPtr reader, cid_template_t *template)
+{
+    int   depth    = xmlTextReaderDepth(reader);
+    bool  empty    = xmlTextReaderIsEmptyElement(reader);
+    char *id       = get_attr(reader, "id");
+    char *ln_class = get_attr(reader, "lnClass");
+
+    if (id != NULL && ln_class != NULL) {
+        template->n_lnotypes += 1;
+        template->lnotypes =
+            realloc(template->lnotypes,
+                    template->n_lnotypes * sizeof(cid_tm_lno_type_t));
+        cid_tm_lno_type_t *tm_lno =
+            &template->lnotypes[template->n_lnotypes - 1];
+        memset(tm_lno, 0, sizeof(cid_tm_lno_type_t));
+
+        strncpy(tm_lno->id, id, sizeof(tm_lno->id) - 1);
+        strncpy(tm_lno->ln_class, ln_class, sizeof(tm_lno->ln_class) - 1);
+
+        while (!empty && next_child(reader, depth) == 1) {
+            char *name     = get_attr(reader, "name");
+            char *ref_type = get_attr(reader, "type");
+
+            if (name != NULL && ref_type != NULL) {
+                tm_lno->n_dos += 1;
+                tm_lno->dos = realloc(tm_lno->dos,
+                                      tm_lno->n_dos * sizeof(cid_tm_lno_do_t));
+                cid_tm_lno_do_t *tm_do = &tm_lno->dos[tm_lno->n_dos - 1];
+                memset(tm_do, 0, sizeof(cid_tm_lno_do_t));
+
+                strncpy(tm_do->name, name, sizeof(tm_do->name) - 1);
+                strncpy(tm_do->ref_type, ref_type, sizeof(tm_do->ref_type) - 1);
             }
 
-            child = child->next;
+            if (name != NULL) {
+                xmlFree(name);
+            }
+            if (ref_type != NULL) {
+                xmlFree(ref_type);
+            }
         }
     }
-    return 0;
+
+    if (id != NULL) {
+        xmlFree(id);
+    }
+    if (ln_class != NULL) {
+        xmlFree(ln_class);
+    }
 }
 
-static int parse_template(xmlNode *xml_template, cid_template_t *template)
+static void parse_do_da(xmlTextReaderPtr reader, cid_tm_do_type_t *tm_do)
 {
-    template->lnotypes   = NULL;
-    template->n_lnotypes = 0;
-    template->dotypes    = NULL;
-    template->n_dotypes  = 0;
-    template->datypes    = NULL;
-    template->n_datypes  = 0;
-
-    xmlNode *child = xml_template->children;
-
-    while (child != NULL) {
-        if (child->type != XML_ELEMENT_NODE) {
-            child = child->next;
-            continue;
+    char *btype    = get_attr(reader, "bType");
+    char *fc       = get_attr(reader, "fc");
+    char *name     = get_attr(reader, "name");
+    char *ref_type = get_attr(reader, "type");
+
+    if (btype != NULL && fc != NULL && name != NULL) {
+        tm_do->n_das += 1;
+        tm_do->das = realloc(tm_do->das, tm_do->n_das * sizeof(cid_tm_do_da_t));
+        cid_tm_do_da_t *tm_da = &tm_do->das[tm_do->n_das - 1];
+        memset(tm_da, 0, sizeof(cid_tm_do_da_t));
+
+        strncpy(tm_da->name, name, sizeof(tm_da->name) - 1);
+        if (ref_type != NULL) {
+            strncpy(tm_da->ref_type, ref_type, sizeof(tm_da->ref_type) - 1);
         }
-        if (strcmp((const char *) child->name, "LNodeType") == 0) {
-            char *id = (char *) xmlGetProp(child, (const xmlChar *) "id");
-            char *ln_class =
-                (char *) xmlGetProp(child, (const xmlChar *) "lnClass");
-            if (id != NULL && ln_class != NULL) {
-                template->n_lnotypes += 1;
-                template->lnotypes =
-                    realloc(template->lnotypes,
-                            template->n_lnotypes * sizeof(cid_tm_lno_type_t));
-                cid_tm_lno_type_t *tm_lno =
-                    &template->lnotypes[template->n_lnotypes - 1];
-                memset(tm_lno, 0, sizeof(cid_tm_lno_type_t));
-
-                strcpy(tm_lno->id, id);
-                strcpy(tm_lno->ln_class, ln_class);
-
-                xmlNode *xdo = child->children;
-                while (xdo != NULL) {
-                    if (xdo->type != XML_ELEMENT_NODE) {
-                        xdo = xdo->next;
-                        continue;
-                    }
-                    char *name =
-                        (char *) xmlGetProp(xdo, (const xmlChar *) "name");
-                    char *ref_type =
-                        (char *) xmlGetProp(xdo, (const xmlChar *) "type");
-
-                    if (name != NULL && ref_type != NULL) {
-                        tm_lno->n_dos += 1;
-                        tm_lno->dos =
-                            realloc(tm_lno->dos,
-                                    tm_lno->n_dos * sizeof(cid_tm_lno_do_t));
-                        cid_tm_lno_do_t *tm_do =
-                            &tm_lno->dos[tm_lno->n_dos - 1];
-                        memset(tm_do, 0, sizeof(cid_tm_lno_do_t));
-
-                        strcpy(tm_do->name, name);
-                        strcpy(tm_do->ref_type, ref_type);
-                    }
+        tm_da->btype = decode_basictype((const char *) btype);
+        tm_da->fc    = decode_fc((const char *) fc);
+        if (tm_da->btype == T_UNKNOWN) {
+            nlog_warn("Unknown btype %s, %d", btype, line(reader));
+        }
+        if (tm_da->fc == F_UNKNOWN) {
+            nlog_warn("Unknown fc %s, %d", fc, line(reader));
+        }
+    }
 
-                    if (name != NULL) {
-                        xmlFree(name);
-                    }
-                    if (ref_type != NULL) {
-                        xmlFree(ref_type);
-                    }
+    if (btype != NULL) {
+        xmlFree(btype);
+    }
+    if (fc != NULL) {
+        xmlFree(fc);
+    }
+    if (name != NULL) {
+        xmlFree(name);
+    }
+    if (ref_type != NULL) {
+        xmlFree(ref_type);
+    }
+}
 
-                    xdo = xdo->next;
+static void parse_dotype(xmlTextReaderPtr reader, cid_template_t *template)
+{
+    int   depth = xmlTextReaderDepth(reader);
+    bool  empty = xmlTextReaderIsEmptyElement(reader);
+    char *id    = get_attr(reader, "id");
+
+    if (id != NULL && strlen(id) < NEU_CID_ID_LEN) {
+        template->n_dotypes += 1;
+        template->dotypes =
+            realloc(template->dotypes,
+                    template->n_dotypes * sizeof(cid_tm_do_type_t));
+        cid_tm_do_type_t *tm_do = &template->dotypes[template->n_dotypes - 1];
+        memset(tm_do, 0, sizeof(cid_tm_do_type_t));
+
+        strcpy(tm_do->id, id);
+        while (!empty && next_child(reader, depth) == 1) {
+            if (is_element(reader, "SDO")) {
+                char *sdo_name     = get_attr(reader, "name");
+                char *sdo_ref_type = get_attr(reader, "type");
+
+                if (sdo_name != NULL && sdo_ref_type != NULL) {
+                    tm_do->n_sdos += 1;
+                    tm_do->sdos = realloc(tm_do->sdos,
+                                          tm_do->n_sdos * sizeof(cid_tm_sdo_t));
+                    cid_tm_sdo_t *tm_sdo = &tm_do->sdos[tm_do->n_sdos - 1];
+                    memset(tm_sdo, 0, sizeof(cid_tm_sdo_t));
+
+                    strncpy(tm_sdo->name, sdo_name, sizeof(tm_sdo->name) - 1);
+                    strncpy(tm_sdo->ref_type, sdo_ref_type,
+                            sizeof(tm_sdo->ref_type) - 1);
                 }
-            }
 
-            if (id != NULL) {
-                xmlFree(id);
-            }
-            if (ln_class != NULL) {
-                xmlFree(ln_class);
+                if (sdo_name != NULL) {
+                    xmlFree(sdo_name);
+                }
+                if (sdo_ref_type != NULL) {
+                    xmlFree(sdo_ref_type);
+                }
+            } else if (is_element(reader, "DA")) {
+                parse_do_da(reader, tm_do);
             }
         }
+    }
 
-        if (strcmp((const char *) child->name, "DOType") == 0) {
-            char *id = (char *) xmlGetProp(child, (const xmlChar *) "id");
-            if (id != NULL && strlen(id) < NEU_CID_ID_LEN) {
-                template->n_dotypes += 1;
-                template->dotypes =
-                    realloc(template->dotypes,
-                            template->n_dotypes * sizeof(cid_tm_do_type_t));
-                cid_tm_do_type_t *tm_do =
-                    &template->dotypes[template->n_dotypes - 1];
-                memset(tm_do, 0, sizeof(cid_tm_do_type_t));
-
-                strcpy(tm_do->id, id);
-                xmlNode *da = child->children;
-                while (da != NULL) {
-                    if (da->type != XML_ELEMENT_NODE) {
-                        da = da->next;
-                        continue;
-                    }
+    if (id != NULL) {
+        xmlFree(id);
+    }
+}
 
-                    if (strcmp((const char *) da->name, "SDO") == 0) {
-                        char *sdo_name =
-                            (char *) xmlGetProp(da, (const xmlChar *) "name");
-                        char *sdo_ref_type =
-                            (char *) xmlGetProp(da, (const xmlChar *) "type");
-                        if (sdo_name != NULL && sdo_ref_type != NULL) {
-                            tm_do->n_sdos += 1;
-                            tm_do->sdos =
-                                realloc(tm_do->sdos,
-                                        tm_do->n_sdos * sizeof(cid_tm_sdo_t));
-                            cid_tm_sdo_t *tm_sdo =
-                                &tm_do->sdos[tm_do->n_sdos - 1];
-                            memset(tm_sdo, 0, sizeof(cid_tm_sdo_t));
-
-                            strcpy(tm_sdo->name, sdo_name);
-                            strcpy(tm_sdo->ref_type, sdo_ref_type);
-                        }
+static void parse_datype(xmlTextReaderPtr reader, cid_template_t *template)
+{
+    int   depth = xmlTextReaderDepth(reader);
+    bool  empty = xmlTextReaderIsEmptyElement(reader);
+    char *id    = get_attr(reader, "id");
+
+    if (id != NULL && strlen(id) < NEU_CID_ID_LEN) {
+        template->n_datypes += 1;
+        template->datypes =
+            realloc(template->datypes,
+                    template->n_datypes * sizeof(cid_tm_da_type_t));
+        cid_tm_da_type_t *tm_dat = &template->datypes[template->n_datypes - 1];
+        memset(tm_dat, 0, sizeof(cid_tm_da_type_t));
+
+        strcpy(tm_dat->id, id);
+        while (!empty && next_child(reader, depth) == 1) {
+            char *btype    = get_attr(reader, "bType");
+            char *name     = get_attr(reader, "name");
+            char *ref_type = get_attr(reader, "type");
+
+            if (btype != NULL && name != NULL) {
+                tm_dat->n_bdas += 1;
+                tm_dat->bdas =
+                    realloc(tm_dat->bdas,
+                            tm_dat->n_bdas * sizeof(cid_tm_bda_type_t));
+                cid_tm_bda_type_t *tm_bda = &tm_dat->bdas[tm_dat->n_bdas - 1];
+                memset(tm_bda, 0, sizeof(cid_tm_bda_type_t));
+
+                strncpy(tm_bda->name, name, sizeof(tm_bda->name) - 1);
+                if (ref_type != NULL) {
+                    strncpy(tm_bda->ref_type, ref_type,
+                            sizeof(tm_bda->ref_type) - 1);
+                }
+                tm_bda->btype = decode_basictype((const char *) btype);
+                if (tm_bda->btype == T_UNKNOWN) {
+                    nlog_warn("Unknown btype %s, %d", btype, line(reader));
+                }
+            }
 
-                        if (sdo_name != NULL) {
-                            xmlFree(sdo_name);
-                        }
-                        if (sdo_ref_type != NULL) {
-                            xmlFree(sdo_ref_type);
-                        }
-                    }
+            if (btype != NULL) {
+                xmlFree(btype);
+            }
+            if (name != NULL) {
+                xmlFree(name);
+            }
+            if (ref_type != NULL) {
+                xmlFree(ref_type);
+            }
+        }
+    } else {
+        nlog_warn("skip, DAType id is null or too long %d", line(reader));
+    }
 
-                    if (strcmp((const char *) da->name, "DA") == 0) {
-                        char *btype =
-                            (char *) xmlGetProp(da, (const xmlChar *) "bType");
-                        char *fc =
-                            (char *) xmlGetProp(da, (const xmlChar *) "fc");
-                        char *name =
-                            (char *) xmlGetProp(da, (const xmlChar *) "name");
-                        char *ref_type =
-                            (char *) xmlGetProp(da, (const xmlChar *) "type");
-
-                        if (btype != NULL && fc != NULL && name != NULL) {
-                            tm_do->n_das += 1;
-                            tm_do->das =
-                                realloc(tm_do->das,
-                                        tm_do->n_das * sizeof(cid_tm_do_da_t));
-                            cid_tm_do_da_t *tm_da =
-                                &tm_do->das[tm_do->n_das - 1];
-                            memset(tm_da, 0, sizeof(cid_tm_do_da_t));
-
-                            strcpy(tm_da->name, name);
-                            if (ref_type != NULL) {
-                                strcpy(tm_da->ref_type, ref_type);
-                            }
-                            tm_da->btype = T_UNKNOWN;
-                            tm_da->btype =
-                                decode_basictype((const char *) btype);
-                            tm_da->fc = F_UNKNOWN;
-                            tm_da->fc = decode_fc((const char *) fc);
-                            if (tm_da->btype == T_UNKNOWN) {
-                                nlog_warn("Unknown btype %s, %d", btype,
-                                          (int) da->line);
-                            }
-                            if (tm_da->fc == F_UNKNOWN) {
-                                nlog_warn("Unknown fc %s, %d", fc,
-                                          (int) da->line);
-                            }
-                        }
+    if (id != NULL) {
+        xmlFree(id);
+    }
+}
 
-                        if (btype != NULL) {
-                            xmlFree(btype);
-                        }
-                        if (fc != NULL) {
-                            xmlFree(fc);
-                        }
-                        if (name != NULL) {
-                            xmlFree(name);
-                        }
-                        if (ref_type != NULL) {
-                            xmlFree(ref_type);
-                        }
-                    }
+static void parse_template(xmlTextReaderPtr reader, cid_template_t *template)
+{
+    int  depth = xmlTextReaderDepth(reader);
+    bool empty = xmlTextReaderIsEmptyElement(reader);
+
+    while (!empty && next_child(reader, depth) == 1) {
+        if (is_element(reader, "LNodeType")) {
+            parse_lnotype(reader, template);
+        } else if (is_element(reader, "DOType")) {
+            parse_dotype(reader, template);
+        } else if (is_element(reader, "DAType")) {
+            parse_datype(reader, template);
+        }
+    }
+}
 
-                    da = da->next;
-                }
-            }
+// first pass, only the DataTypeTemplates are parsed, the rest is skipped
+static int parse_templates(const char *path, cid_template_t *template)
+{
+    xmlTextReaderPtr reader = xmlReaderForFile(path, NULL, 0);
+    bool             parsed = false;
+    int              ret    = 0;
 
-            if (id != NULL) {
-                xmlFree(id);
+    if (reader == NULL) {
+        nlog_warn("Failed to read icd file %s", path);
+        return -1;
+    }
+
+    ret = xmlTextReaderRead(reader);
+    while (ret == 1) {
+        if (xmlTextReaderNodeType(reader) != XML_READER_TYPE_ELEMENT) {
+            ret = xmlTextReaderRead(reader);
+        } else if (xmlTextReaderDepth(reader) == 0) {
+            if (!is_element(reader, "SCL")) {
+                nlog_warn("Failed to get root element(SCL)");
+                ret = -1;
+                break;
             }
+            ret = xmlTextReaderRead(reader);
+        } else if (is_element(reader, "DataTypeTemplates")) {
+            parse_template(reader, template);
+            parsed = true;
+            ret    = xmlTextReaderRead(reader);
+        } else {
+            ret = xmlTextReaderNext(reader);
         }
+    }
+    xmlFreeTextReader(reader);
 
-        if (strcmp((const char *) child->name, "DAType") == 0) {
-            char *id = (char *) xmlGetProp(child, (const xmlChar *) "id");
-            if (id != NULL && strlen(id) < NEU_CID_ID_LEN) {
-                template->n_datypes += 1;
-                template->datypes =
-                    realloc(template->datypes,
-                            template->n_datypes * sizeof(cid_tm_da_type_t));
-                cid_tm_da_type_t *tm_dat =
-                    &template->datypes[template->n_datypes - 1];
-                memset(tm_dat, 0, sizeof(cid_tm_da_type_t));
-
-                strcpy(tm_dat->id, id);
-                xmlNode *bda = child->children;
-                while (bda != NULL) {
-                    if (bda->type != XML_ELEMENT_NODE) {
-                        bda = bda->next;
-                        continue;
-                    }
-                    char *btype =
-                        (char *) xmlGetProp(bda, (const xmlChar *) "bType");
-                    char *name =
-                        (char *) xmlGetProp(bda, (const xmlChar *) "name");
-                    char *ref_type =
-                        (char *) xmlGetProp(bda, (const xmlChar *) "type");
-
-                    if (btype != NULL && name != NULL) {
-                        tm_dat->n_bdas += 1;
-                        tm_dat->bdas =
-                            realloc(tm_dat->bdas,
-                                    tm_dat->n_bdas * sizeof(cid_tm_bda_type_t));
-                        cid_tm_bda_type_t *tm_bda =
-                            &tm_dat->bdas[tm_dat->n_bdas - 1];
-                        memset(tm_bda, 0, sizeof(cid_tm_bda_type_t));
-                        strcpy(tm_bda->name, name);
-                        if (ref_type != NULL) {
-                            strcpy(tm_bda->ref_type, ref_type);
-                        }
-                        tm_bda->btype = T_UNKNOWN;
-                        tm_bda->btype = decode_basictype((const char *) btype);
-                        if (tm_bda->btype == T_UNKNOWN) {
-                            nlog_warn("Unknown btype %s, %d", btype,
-                                      (int) bda->line);
-                        }
-                    }
+    if (ret != 0 || !parsed) {
+        nlog_warn("Failed to parse DataTypeTemplates of %s, %d", path, ret);
+        return -1;
+    }
 
-                    if (btype != NULL) {
-                        xmlFree(btype);
-                    }
-                    if (name != NULL) {
-                        xmlFree(name);
-                    }
-                    if (ref_type != NULL) {
-                        xmlFree(ref_type);
-                    }
+    index_template(template);
+    return 0;
+}
 
-                    bda = bda->next;
-                }
+static int stream_open(cid_stream_t *stream, const char *path,
+                       cid_template_t *template)
+{
+    memset(stream, 0, sizeof(cid_stream_t));
+
+    if (parse_templates(path, template) != 0) {
+        return -1;
+    }
+
+    stream->reader = xmlReaderForFile(path, NULL, 0);
+    if (stream->reader == NULL) {
+        nlog_warn("Failed to read icd file %s", path);
+        return -1;
+    }
+    stream->template = template;
+    stream->ret      = xmlTextReaderRead(stream->reader);
+    return 0;
+}
+
+// second pass, read up to the next LDevice of the first Server of the first
+// AccessPoint of an IED, returns 1 with `ldev` parsed and resolved, 0 at the
+// end of the file and -1 on error
+static int stream_next(cid_stream_t *stream, cid_ldevice_t *ldev)
+{
+    xmlTextReaderPtr reader = stream->reader;
+
+    while (stream->ret == 1) {
+        int depth = xmlTextReaderDepth(reader);
+
+        if (xmlTextReaderNodeType(reader) != XML_READER_TYPE_ELEMENT) {
+            stream->ret = xmlTextReaderRead(reader);
+            continue;
+        }
+
+        if (depth == 0) {
+            stream->ret = xmlTextReaderRead(reader);
+        } else if (depth == 1 && is_element(reader, "IED")) {
+            char *name = get_attr(reader, "name");
+
+            stream->ap_seen = false;
+            if (name != NULL && strlen(name) < NEU_CID_IED_NAME_LEN) {
+                strcpy(stream->ied_name, name);
+                stream->ret = xmlTextReaderRead(reader);
             } else {
-                nlog_warn("skip, DAType id is null or too long %d",
-                          (int) child->line);
+                nlog_warn("IED name is too long");
+                stream->ret = xmlTextReaderNext(reader);
             }
-            if (id != NULL) {
-                xmlFree(id);
+            if (name != NULL) {
+                xmlFree(name);
             }
+        } else if (depth == 2 && !stream->ap_seen &&
+                   is_element(reader, "AccessPoint")) {
+            stream->ap_seen     = true;
+            stream->server_seen = false;
+            memset(stream->ap_name, 0, sizeof(stream->ap_name));
+            copy_attr(reader, "name", stream->ap_name,
+                      sizeof(stream->ap_name));
+            stream->ret = xmlTextReaderRead(reader);
+        } else if (depth == 3 && !stream->server_seen &&
+                   is_element(reader, "Server")) {
+            stream->server_seen = true;
+            stream->n_server += 1;
+            stream->ret = xmlTextReaderRead(reader);
+        } else if (depth == 4 && is_element(reader, "LDevice")) {
+            parse_ldevice(reader, ldev);
+            resolve_ldevice(ldev, stream->template);
+            stream->ret = xmlTextReaderRead(reader);
+            return 1;
+        } else {
+            stream->ret = xmlTextReaderNext(reader);
         }
+    }
+
+    if (stream->ret != 0) {
+        nlog_warn("Failed to parse IED, %d", stream->ret);
+        return -1;
+    }
+    if (stream->n_server == 0) {
+        nlog_warn("Failed to parse IED, no Server");
+        return -1;
+    }
+
+    return 0;
+}
+
+neu_cid_reader_t *neu_cid_reader_open(const char *path)
+{
+    neu_cid_reader_t *reader = calloc(1, sizeof(neu_cid_reader_t));
+
+    if (reader == NULL) {
+        return NULL;
+    }
+
+    if (stream_open(&reader->stream, path, &reader->cid_template) != 0) {
+        template_free(&reader->cid_template);
+        free(reader);
+        return NULL;
+    }
+
+    return reader;
+}
 
-        child = child->next;
+// Move the first `n` tags of `group` into `part`. The rest is sent with the
+// next request under the same group name, with its own copy of the context.
+static int group_split(neu_gdatatag_t *group, int n, neu_gdatatag_t *part)
+{
+    cid_dataset_info_t *ctx  = NULL;
+    neu_datatag_t *     tags = calloc(n, sizeof(neu_datatag_t));
+
+    if (NULL != group->context) {
+        ctx = malloc(sizeof(cid_dataset_info_t));
+    }
+    if (NULL == tags || (NULL != group->context && NULL == ctx)) {
+        free(tags);
+        free(ctx);
+        return -1;
     }
 
+    if (NULL != ctx) {
+        memcpy(ctx, group->context, sizeof(cid_dataset_info_t));
+    }
+    memcpy(tags, group->tags, n * sizeof(neu_datatag_t));
+    memmove(group->tags, group->tags + n,
+            (group->n_tag - n) * sizeof(neu_datatag_t));
+
+    *part          = *group;
+    part->n_tag    = n;
+    part->tags     = tags;
+    group->context = ctx;
+
+    group->n_tag -= n;
     return 0;
 }
 
+int neu_cid_reader_next(neu_cid_reader_t *reader, const char *driver,
+                        int max_tags, neu_req_add_gtag_t *cmd)
+{
+    int n_tag = 0;
+
+    memset(cmd, 0, sizeof(neu_req_add_gtag_t));
+    strncpy(cmd->driver, driver, sizeof(cmd->driver) - 1);
+    if (reader->failed) {
+        return -1;
+    }
+
+    while (n_tag < max_tags) {
+        if (reader->next == reader->pending.n_group) {
+            cid_ldevice_t ldev = { 0 };
+            int           ret  = stream_next(&reader->stream, &ldev);
+
+            neu_req_add_gtag_fini(&reader->pending);
+            reader->next = 0;
+            if (ret < 0) {
+                // hand out what is already converted, fail on the next call
+                reader->failed = true;
+                return cmd->n_group > 0 ? cmd->n_group : -1;
+            }
+            if (ret == 0) {
+                break;
+            }
+
+            ldevice_to_groups(reader->stream.ied_name, reader->stream.ap_name,
+                              &ldev, &reader->pending);
+            ldevice_free(&ldev);
+            continue;
+        }
+
+        neu_gdatatag_t *group  = &reader->pending.groups[reader->next];
+        int             room   = max_tags - n_tag;
+        neu_gdatatag_t *groups = realloc(
+            cmd->groups, (cmd->n_group + 1) * sizeof(neu_gdatatag_t));
+        if (NULL == groups) {
+            reader->failed = true;
+            return cmd->n_group > 0 ? cmd->n_group : -1;
+        }
+        cmd->groups = groups;
+
+        if (group->n_tag <= room) {
+            cmd->groups[cmd->n_group++] = *group;
+            n_tag += group->n_tag;
+            memset(group, 0, sizeof(neu_gdatatag_t));
+            reader->next += 1;
+        } else if (group_split(group, room, &cmd->groups[cmd->n_group]) == 0) {
+            cmd->n_group += 1;
+            n_tag += room;
+        } else {
+            reader->failed = true;
+            return cmd->n_group > 0 ? cmd->n_group : -1;
+        }
+    }
+
+    return cmd->n_group;
+}
+
+void neu_cid_reader_close(neu_cid_reader_t *reader)
+{
+    neu_req_add_gtag_fini(&reader->pending);
+    xmlFreeTextReader(reader->stream.reader);
+    template_free(&reader->cid_template);
+    free(reader);
+}
+
 char *neu_cid_info_to_string(cid_dataset_info_t *info)
 {
     neu_json_elem_t elems[] = {
@@ -1229,20 +1303,71 @@ cid_dataset_info_t *neu_cid_info_from_string(const char *str)
     }
 }
 
+static neu_type_e btype_to_type(cid_basictype_e btype)
+{
+    switch (btype & 0x7f) {
+    case BOOLEAN:
+        return NEU_TYPE_BOOL;
+    case INT8:
+        return NEU_TYPE_INT8;
+    case INT16:
+        return NEU_TYPE_INT16;
+    case INT24:
+    case INT32:
+        return NEU_TYPE_INT32;
+    case INT128:
+        return NEU_TYPE_INT64;
+    case INT8U:
+        return NEU_TYPE_UINT8;
+    case INT16U:
+        return NEU_TYPE_UINT16;
+    case INT24U:
+    case INT32U:
+        return NEU_TYPE_UINT32;
+    case FLOAT32:
+        return NEU_TYPE_FLOAT;
+    case FLOAT64:
+        return NEU_TYPE_DOUBLE;
+    case Enum:
+        return NEU_TYPE_UINT8;
+    case Dbpos: // TODO
+        return NEU_TYPE_UINT8;
+    case Tcmd:
+        return NEU_TYPE_UINT8;
+    case Quality:
+        return NEU_TYPE_UINT16;
+    case Timestamp:
+        return NEU_TYPE_UINT64;
+    case VisString32:
+    case VisString64:
+    case VisString255:
+        return NEU_TYPE_STRING;
+    case Octet64: // TODO
+        return NEU_TYPE_UINT64;
+    case Struct: // TODO
+        return NEU_TYPE_UINT8;
+    case EntryTime: // TODO
+        return NEU_TYPE_INT64;
+    case Unicode255: // TODO
+        return NEU_TYPE_STRING;
+    case Check: // TODO
+        return NEU_TYPE_UINT8;
+    default:
+        return NEU_TYPE_UINT8;
+    }
+}
+
 static void ld_ctrl_do_to_group(const char *ied_name, const char *ap_name,
                                 cid_ldevice_t *ld, neu_req_add_gtag_t *cmd)
 {
-    bool exist_ctl = false;
+    int n_ctl = 0;
     for (int i = 0; i < ld->n_lns; i++) {
         for (int k = 0; k < ld->lns[i].n_dois; k++) {
-            if (ld->lns[i].dois[k].n_ctls > 0) {
-                exist_ctl = true;
-                break;
-            }
+            n_ctl += ld->lns[i].dois[k].n_ctls;
         }
     }
 
-    if (!exist_ctl) {
+    if (n_ctl == 0) {
         return;
     }
 
@@ -1261,13 +1386,16 @@ static void ld_ctrl_do_to_group(const char *ied_name, const char *ap_name,
     snprintf(group->group, NEU_GROUP_NAME_LEN, "%s/%s$Control", ap_name,
              ld->inst);
     group->interval = 10000;
+    group->tags     = calloc(n_ctl, sizeof(neu_datatag_t));
 
     for (int i = 0; i < ld->n_lns; i++) {
         for (int j = 0; j < ld->lns[i].n_dois; j++) {
             for (int k = 0; k < ld->lns[i].dois[j].n_ctls; k++) {
                 cid_doi_ctl_t *ctl = &ld->lns[i].dois[j].ctls[k];
-                char           ln_name[NEU_CID_LEN32] = { 0 };
-                int            offset                 = 0;
+                char           ln_name[NEU_CID_LEN32]       = { 0 };
+                char           name[NEU_TAG_NAME_LEN]       = { 0 };
+                char           address[NEU_TAG_ADDRESS_LEN] = { 0 };
+                int            offset                       = 0;
 
                 if (strlen(ld->lns[i].lnprefix) > 0) {
                     offset += snprintf(ln_name, NEU_CID_LEN32 - offset, "%s",
@@ -1280,21 +1408,11 @@ static void ld_ctrl_do_to_group(const char *ied_name, const char *ap_name,
                                        "%s", ld->lns[i].lninst);
                 }
 
-                group->n_tag += 1;
-                group->tags =
-                    realloc(group->tags, group->n_tag * sizeof(neu_datatag_t));
-                neu_datatag_t *tag = &group->tags[group->n_tag - 1];
-                memset(tag, 0, sizeof(neu_datatag_t));
+                neu_datatag_t *tag = &group->tags[group->n_tag++];
 
-                tag->name = calloc(1, NEU_TAG_NAME_LEN);
-                snprintf(tag->name, NEU_TAG_NAME_LEN, "%s$%s$%s", ln_name,
+                snprintf(name, sizeof(name), "%s$%s$%s", ln_name,
                          ld->lns[i].dois[j].name, ctl->da_name);
-                tag->attribute   = NEU_ATTRIBUTE_WRITE;
-                tag->address     = calloc(1, NEU_TAG_ADDRESS_LEN);
-                tag->description = calloc(1, NEU_TAG_DESCRIPTION_LEN);
-                snprintf(tag->description, NEU_TAG_DESCRIPTION_LEN, "%s",
-                         fc_to_str(ctl->fc));
-                snprintf(tag->address, NEU_TAG_ADDRESS_LEN, "%s%s/%s$%s$%s$%s",
+                snprintf(address, sizeof(address), "%s%s/%s$%s$%s$%s",
                          ied_name, ld->inst, ln_name, fc_to_str(ctl->fc),
                          ld->lns[i].dois[j].name, ctl->da_name);
                 if (ctl->fc == CO) {
@@ -1303,95 +1421,20 @@ static void ld_ctrl_do_to_group(const char *ied_name, const char *ap_name,
                         tag->format[l] = ctl->co_types[l];
                     }
                 } else {
-                    for (size_t index = 0; index < strlen(tag->address);
-                         index++) {
-                        if (tag->address[index] == '.') {
-                            tag->address[index] = '$';
+                    for (char *c = address; *c != '\0'; c++) {
+                        if (*c == '.') {
+                            *c = '$';
                         }
                     }
                     tag->n_format  = 1;
                     tag->format[0] = ctl->btype;
                 }
-                switch (ctl->btype & 0x7f) {
-                case BOOLEAN:
-                    tag->type = NEU_TYPE_BOOL;
-                    break;
-                case INT8:
-                    tag->type = NEU_TYPE_INT8;
-                    break;
-                case INT16:
-                    tag->type = NEU_TYPE_INT16;
-                    break;
-                case INT24:
-                    tag->type = NEU_TYPE_INT32;
-                    break;
-                case INT32:
-                    tag->type = NEU_TYPE_INT32;
-                    break;
-                case INT128:
-                    tag->type = NEU_TYPE_INT64;
-                    break;
-                case INT8U:
-                    tag->type = NEU_TYPE_UINT8;
-                    break;
-                case INT16U:
-                    tag->type = NEU_TYPE_UINT16;
-                    break;
-                case INT24U:
-                    tag->type = NEU_TYPE_UINT32;
-                    break;
-                case INT32U:
-                    tag->type = NEU_TYPE_UINT32;
-                    break;
-                case FLOAT32:
-                    tag->type = NEU_TYPE_FLOAT;
-                    break;
-                case FLOAT64:
-                    tag->type = NEU_TYPE_DOUBLE;
-                    break;
-                case Enum:
-                    tag->type = NEU_TYPE_UINT8;
-                    break;
-                case Dbpos: // TODO
-                    tag->type = NEU_TYPE_UINT8;
-                    break;
-                case Tcmd:
-                    tag->type = NEU_TYPE_UINT8;
-                    break;
-                case Quality:
-                    tag->type = NEU_TYPE_UINT16;
-                    break;
-                case Timestamp:
-                    tag->type = NEU_TYPE_UINT64;
-                    break;
-                case VisString32:
-                    tag->type = NEU_TYPE_STRING;
-                    break;
-                case VisString64:
-                    tag->type = NEU_TYPE_STRING;
-                    break;
-                case VisString255:
-                    tag->type = NEU_TYPE_STRING;
-                    break;
-                case Octet64: // TODO
-                    tag->type = NEU_TYPE_UINT64;
-                    break;
-                case Struct: // TODO
-                    tag->type = NEU_TYPE_UINT8;
-                    break;
-                case EntryTime: // TODO
-                    tag->type = NEU_TYPE_INT64;
-                    break;
-                case Unicode255: // TODO
-                    tag->type = NEU_TYPE_STRING;
-                    break;
-                case Check: // TODO
-                    tag->type = NEU_TYPE_UINT8;
-                    break;
-                case T_UNKNOWN:
-                    tag->type = NEU_TYPE_UINT8;
-                    break;
-                }
+
+                tag->name        = strdup(name);
+                tag->address     = strdup(address);
+                tag->description = strdup(fc_to_str(ctl->fc));
+                tag->attribute   = NEU_ATTRIBUTE_WRITE;
+                tag->type        = btype_to_type(ctl->btype);
             }
         }
     }
@@ -1439,127 +1482,36 @@ static void ln_dataset_to_group(const char *ied_name, const char *ap_name,
                     calloc(1, ln->datasets[j].n_fcda * sizeof(neu_datatag_t));
 
                 for (int k = 0; k < ln->datasets[j].n_fcda; k++) {
-                    neu_datatag_t *tag = &group->tags[k];
-
-                    tag->name = calloc(1, NEU_TAG_NAME_LEN);
-                    if (strlen(ln->datasets[j].fcdas[k].da_name) > 0) {
-                        snprintf(tag->name, NEU_TAG_NAME_LEN, "%s%s%s.%s.%s",
-                                 ln->datasets[j].fcdas[k].prefix,
-                                 ln->datasets[j].fcdas[k].lnclass,
-                                 ln->datasets[j].fcdas[k].lninst,
-                                 ln->datasets[j].fcdas[k].do_name,
-                                 ln->datasets[j].fcdas[k].da_name);
+                    const cid_fcda_t *fcda = &ln->datasets[j].fcdas[k];
+                    neu_datatag_t *   tag  = &group->tags[k];
+                    char              name[NEU_TAG_NAME_LEN]       = { 0 };
+                    char              address[NEU_TAG_ADDRESS_LEN] = { 0 };
+
+                    if (strlen(fcda->da_name) > 0) {
+                        snprintf(name, sizeof(name), "%s%s%s.%s.%s",
+                                 fcda->prefix, fcda->lnclass, fcda->lninst,
+                                 fcda->do_name, fcda->da_name);
+                        snprintf(address, sizeof(address), "%s/%s$%s$%s$%s",
+                                 ld_inst, fcda->lnclass, fc_to_str(fcda->fc),
+                                 fcda->do_name, fcda->da_name);
                     } else {
-                        snprintf(tag->name, NEU_TAG_NAME_LEN, "%s%s%s.%s",
-                                 ln->datasets[j].fcdas[k].prefix,
-                                 ln->datasets[j].fcdas[k].lnclass,
-                                 ln->datasets[j].fcdas[k].lninst,
-                                 ln->datasets[j].fcdas[k].do_name);
+                        snprintf(name, sizeof(name), "%s%s%s.%s",
+                                 fcda->prefix, fcda->lnclass, fcda->lninst,
+                                 fcda->do_name);
+                        snprintf(address, sizeof(address), "%s/%s$%s$%s",
+                                 ld_inst, fcda->lnclass, fc_to_str(fcda->fc),
+                                 fcda->do_name);
                     }
+
+                    tag->name        = strdup(name);
+                    tag->address     = strdup(address);
+                    tag->description = strdup(fc_to_str(fcda->fc));
                     tag->attribute   = NEU_ATTRIBUTE_READ;
-                    tag->address     = calloc(1, NEU_TAG_ADDRESS_LEN);
-                    tag->description = calloc(1, NEU_TAG_DESCRIPTION_LEN);
-                    snprintf(tag->description, NEU_TAG_DESCRIPTION_LEN, "%s",
-                             fc_to_str(ln->datasets[j].fcdas[k].fc));
-                    if (strlen(ln->datasets[j].fcdas[k].da_name) > 0) {
-                        snprintf(tag->address, NEU_TAG_ADDRESS_LEN,
-                                 "%s/%s$%s$%s$%s", ld_inst,
-                                 ln->datasets[j].fcdas[k].lnclass,
-                                 fc_to_str(ln->datasets[j].fcdas[k].fc),
-                                 ln->datasets[j].fcdas[k].do_name,
-                                 ln->datasets[j].fcdas[k].da_name);
-                    } else {
-                        snprintf(tag->address, NEU_TAG_ADDRESS_LEN,
-                                 "%s/%s$%s$%s", ld_inst,
-                                 ln->datasets[j].fcdas[k].lnclass,
-                                 fc_to_str(ln->datasets[j].fcdas[k].fc),
-                                 ln->datasets[j].fcdas[k].do_name);
-                    }
-                    switch (ln->datasets[j].fcdas[k].btypes[0] & 0x7f) {
-                    case BOOLEAN:
-                        tag->type = NEU_TYPE_BOOL;
-                        break;
-                    case INT8:
-                        tag->type = NEU_TYPE_INT8;
-                        break;
-                    case INT16:
-                        tag->type = NEU_TYPE_INT16;
-                        break;
-                    case INT24:
-                        tag->type = NEU_TYPE_INT32;
-                        break;
-                    case INT32:
-                        tag->type = NEU_TYPE_INT32;
-                        break;
-                    case INT128:
-                        tag->type = NEU_TYPE_INT64;
-                        break;
-                    case INT8U:
-                        tag->type = NEU_TYPE_UINT8;
-                        break;
-                    case INT16U:
-                        tag->type = NEU_TYPE_UINT16;
-                        break;
-                    case INT24U:
-                        tag->type = NEU_TYPE_UINT32;
-                        break;
-                    case INT32U:
-                        tag->type = NEU_TYPE_UINT32;
-                        break;
-                    case FLOAT32:
-                        tag->type = NEU_TYPE_FLOAT;
-                        break;
-                    case FLOAT64:
-                        tag->type = NEU_TYPE_DOUBLE;
-                        break;
-                    case Enum:
-                        tag->type = NEU_TYPE_UINT8;
-                        break;
-                    case Dbpos: // TODO
-                        tag->type = NEU_TYPE_UINT8;
-                        break;
-                    case Tcmd:
-                        tag->type = NEU_TYPE_UINT8;
-                        break;
-                    case Quality:
-                        tag->type = NEU_TYPE_UINT16;
-                        break;
-                    case Timestamp:
-                        tag->type = NEU_TYPE_UINT64;
-                        break;
-                    case VisString32:
-                        tag->type = NEU_TYPE_STRING;
-                        break;
-                    case VisString64:
-                        tag->type = NEU_TYPE_STRING;
-                        break;
-                    case VisString255:
-                        tag->type = NEU_TYPE_STRING;
-                        break;
-                    case Octet64: // TODO
-                        tag->type = NEU_TYPE_UINT64;
-                        break;
-                    case Struct: // TODO
-                        tag->type = NEU_TYPE_UINT8;
-                        break;
-                    case EntryTime: // TODO
-                        tag->type = NEU_TYPE_INT64;
-                        break;
-                    case Unicode255: // TODO
-                        tag->type = NEU_TYPE_STRING;
-                        break;
-                    case Check: // TODO
-                        tag->type = NEU_TYPE_UINT8;
-                        break;
-                    case T_UNKNOWN:
-                        tag->type = NEU_TYPE_UINT8;
-                        break;
-                    }
+                    tag->type        = btype_to_type(fcda->btypes[0]);
 
-                    tag->n_format = ln->datasets[j].fcdas[k].n_btypes;
-                    for (int l = 0; l < ln->datasets[j].fcdas[k].n_btypes;
-                         l++) {
-                        tag->format[l] = ln->datasets[j].fcdas[k].btypes[l];
+                    tag->n_format = fcda->n_btypes;
+                    for (int l = 0; l < fcda->n_btypes; l++) {
+                        tag->format[l] = fcda->btypes[l];
                     }
                 }
 
@@ -1569,6 +1521,15 @@ static void ln_dataset_to_group(const char *ied_name, const char *ap_name,
     }
 }
 
+static void ldevice_to_groups(const char *ied_name, const char *ap_name,
+                              cid_ldevice_t *ld, neu_req_add_gtag_t *cmd)
+{
+    ld_ctrl_do_to_group(ied_name, ap_name, ld, cmd);
+    for (int i = 0; i < ld->n_lns; i++) {
+        ln_dataset_to_group(ied_name, ap_name, ld->inst, &ld->lns[i], cmd);
+    }
+}
+
 void neu_cid_to_msg(char *driver, cid_t *cid, neu_req_add_gtag_t *cmd)
 {
     strcpy(cmd->driver, driver);
@@ -1577,15 +1538,8 @@ void neu_cid_to_msg(char *driver, cid_t *cid, neu_req_add_gtag_t *cmd)
 
     for (int i = 0; i < cid->ied.n_access_points; i++) {
         for (int j = 0; j < cid->ied.access_points[i].n_ldevices; j++) {
-            ld_ctrl_do_to_group(cid->ied.name, cid->ied.access_points[i].name,
-                                &cid->ied.access_points[i].ldevices[j], cmd);
-            for (int k = 0; k < cid->ied.access_points[i].ldevices[j].n_lns;
-                 k++) {
-                ln_dataset_to_group(
-                    cid->ied.name, cid->ied.access_points[i].name,
-                    cid->ied.access_points[i].ldevices[j].inst,
-                    &cid->ied.access_points[i].ldevices[j].lns[k], cmd);
-            }
+            ldevice_to_groups(cid->ied.name, cid->ied.access_points[i].name,
+                              &cid->ied.access_points[i].ldevices[j], cmd);
         }
     }
-}
\ No newline at end of file
+}
@@ -17,9 +17,14 @@
  * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
  **/
 
+#if defined(__GNUC__) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE
+#endif
+
 #include <assert.h>
 #include <errno.h>
 #include <inttypes.h>
+#include <pthread.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -33,6 +38,7 @@
 #include "otel/otel_manager.h"
 #include "utils/http.h"
 #include "utils/log.h"
+#include "utils/utlist.h"
 
 static int response(nng_aio *aio, char *content, enum nng_http_status status)
 {
@@ -510,4 +516,360 @@ int neu_http_post_otel_trace(uint8_t *data, int len)
     nng_http_conn_close(conn);
     nng_aio_free(aio);
     return status;
-}
\ No newline at end of file
+}
+
+// size of one chunk of a streamed response body
+#define HTTP_STREAM_CHUNK_SIZE (16 * 1024)
+// room for the chunk size line in front of the data
+#define HTTP_STREAM_CHUNK_HEAD 16
+// how long to wait for the peer to accept a chunk
+#define HTTP_STREAM_TIMEOUT 5000
+// chunks buffered for the peer, the writer waits for room beyond that
+#define HTTP_STREAM_WINDOW 4
+
+typedef struct stream_chunk {
+    struct stream_chunk *next;
+    size_t               off; // start of the data to send
+    size_t               len;
+    char                 data[HTTP_STREAM_CHUNK_HEAD + HTTP_STREAM_CHUNK_SIZE +
+                              2];
+} stream_chunk_t;
+
+struct neu_http_stream {
+    nng_http_conn * conn;
+    nng_aio *       aio;
+    pthread_mutex_t mtx;
+    pthread_cond_t  cond; // a chunk was written, or the stream broke
+
+    // chunks waiting for the peer, the head one is being written
+    stream_chunk_t *queue;
+    size_t          n_queued;
+    bool            sending;
+    bool            closing;
+    bool            broken;
+
+    // chunk being filled by the writer
+    stream_chunk_t *cur;
+
+    struct neu_http_stream *next; // in the free list
+};
+
+// Streams are finished from the write callback of their own aio, which can
+// not free that aio, so they are kept for reuse instead.
+static pthread_mutex_t    free_streams_mtx = PTHREAD_MUTEX_INITIALIZER;
+static neu_http_stream_t *free_streams     = NULL;
+
+static void stream_write_cb(void *arg);
+
+static neu_http_stream_t *stream_get()
+{
+    neu_http_stream_t *stream = NULL;
+
+    pthread_mutex_lock(&free_streams_mtx);
+    if (NULL != free_streams) {
+        stream = free_streams;
+        LL_DELETE(free_streams, stream);
+    }
+    pthread_mutex_unlock(&free_streams_mtx);
+
+    if (NULL != stream) {
+        return stream;
+    }
+
+    stream = calloc(1, sizeof(*stream));
+    if (NULL == stream) {
+        return NULL;
+    }
+
+    if (0 != nng_aio_alloc(&stream->aio, stream_write_cb, stream)) {
+        free(stream);
+        return NULL;
+    }
+    nng_aio_set_timeout(stream->aio, HTTP_STREAM_TIMEOUT);
+    pthread_mutex_init(&stream->mtx, NULL);
+    pthread_cond_init(&stream->cond, NULL);
+
+    return stream;
+}
+
+static void stream_put(neu_http_stream_t *stream)
+{
+    stream_chunk_t *chunk = NULL, *tmp = NULL;
+
+    LL_FOREACH_SAFE(stream->queue, chunk, tmp)
+    {
+        LL_DELETE(stream->queue, chunk);
+        free(chunk);
+    }
+    free(stream->cur);
+
+    stream->conn     = NULL;
+    stream->cur      = NULL;
+    stream->n_queued = 0;
+    stream->sending  = false;
+    stream->closing  = false;
+    stream->broken   = false;
+
+    pthread_mutex_lock(&free_streams_mtx);
+    LL_PREPEND(free_streams, stream);
+    pthread_mutex_unlock(&free_streams_mtx);
+}
+
+// Start writing the head chunk unless a write is in flight, called with
+// `stream->mtx` held. Returns true if a write should be issued.
+static bool stream_kick(neu_http_stream_t *stream)
+{
+    if (stream->sending || stream->broken || NULL == stream->queue) {
+        return false;
+    }
+
+    nng_iov iov = {
+        .iov_buf = stream->queue->data + stream->queue->off,
+        .iov_len = stream->queue->len,
+    };
+    nng_aio_set_iov(stream->aio, 1, &iov);
+    stream->sending = true;
+    return true;
+}
+
+static void stream_finish(neu_http_stream_t *stream)
+{
+    nng_http_conn_close(stream->conn);
+    stream_put(stream);
+}
+
+static void stream_write_cb(void *arg)
+{
+    neu_http_stream_t *stream = arg;
+    stream_chunk_t *   chunk  = NULL;
+    int                rv     = nng_aio_result(stream->aio);
+    bool               send   = false;
+    bool               done   = false;
+
+    pthread_mutex_lock(&stream->mtx);
+    chunk = stream->queue;
+    LL_DELETE(stream->queue, chunk);
+    stream->n_queued -= 1;
+    free(chunk);
+    stream->sending = false;
+
+    if (0 != rv && !stream->broken) {
+        nlog_warn("http stream write fail: %s", nng_strerror(rv));
+        stream->broken = true;
+    }
+
+    send = stream_kick(stream);
+    done = !send && stream->closing;
+    pthread_cond_signal(&stream->cond);
+    pthread_mutex_unlock(&stream->mtx);
+
+    if (send) {
+        nng_http_conn_write_all(stream->conn, stream->aio);
+    } else if (done) {
+        stream_finish(stream);
+    }
+}
+
+// Queue `chunk` for writing, taking ownership of it. Waits while the window
+// is full, a write is then in flight and completes within its timeout.
+static int stream_send(neu_http_stream_t *stream, stream_chunk_t *chunk)
+{
+    bool send = false;
+
+    pthread_mutex_lock(&stream->mtx);
+    while (!stream->broken && stream->n_queued >= HTTP_STREAM_WINDOW) {
+        pthread_cond_wait(&stream->cond, &stream->mtx);
+    }
+    if (stream->broken) {
+        pthread_mutex_unlock(&stream->mtx);
+        free(chunk);
+        return -1;
+    }
+
+    LL_APPEND(stream->queue, chunk);
+    stream->n_queued += 1;
+    send = stream_kick(stream);
+    pthread_mutex_unlock(&stream->mtx);
+
+    if (send) {
+        nng_http_conn_write_all(stream->conn, stream->aio);
+    }
+    return 0;
+}
+
+static int stream_send_str(neu_http_stream_t *stream, const char *str)
+{
+    size_t          len   = strlen(str);
+    stream_chunk_t *chunk = NULL;
+
+    if (len > sizeof(chunk->data)) {
+        return -1;
+    }
+
+    chunk = calloc(1, sizeof(*chunk));
+    if (NULL == chunk) {
+        return -1;
+    }
+    memcpy(chunk->data, str, len);
+    chunk->len = len;
+
+    return stream_send(stream, chunk);
+}
+
+static int stream_flush(neu_http_stream_t *stream)
+{
+    stream_chunk_t *chunk = stream->cur;
+    char            size[HTTP_STREAM_CHUNK_HEAD];
+    int             n = 0;
+
+    if (NULL == chunk || 0 == chunk->len) {
+        return 0;
+    }
+
+    // the size line goes right in front of the data
+    n = snprintf(size, sizeof(size), "%zx\r\n", chunk->len);
+    chunk->off = HTTP_STREAM_CHUNK_HEAD - n;
+    memcpy(chunk->data + chunk->off, size, n);
+    memcpy(chunk->data + HTTP_STREAM_CHUNK_HEAD + chunk->len, "\r\n", 2);
+    chunk->len += n + 2;
+
+    stream->cur = NULL;
+    return stream_send(stream, chunk);
+}
+
+neu_http_stream_t *neu_http_stream_open(nng_aio *aio, const char *content_type)
+{
+    nng_http_req *     nng_req = nng_aio_get_input(aio, 0);
+    nng_http_conn *    conn    = nng_aio_get_input(aio, 2);
+    neu_http_stream_t *stream  = NULL;
+    char               head[256];
+
+    if (NULL == conn) {
+        return NULL;
+    }
+
+    stream = stream_get();
+    if (NULL == stream) {
+        return NULL;
+    }
+
+    if (0 != nng_http_hijack(conn)) {
+        stream_put(stream);
+        return NULL;
+    }
+
+    nlog_notice("<%p> %s %s [%d] chunked", aio,
+                nng_http_req_get_method(nng_req), nng_http_req_get_uri(nng_req),
+                NNG_HTTP_STATUS_OK);
+
+    // the connection belongs to us from now on, let the server drop its
+    // bookkeeping for this request
+    stream->conn = conn;
+    nng_aio_set_output(aio, 0, NULL);
+    nng_aio_finish(aio, 0);
+
+    snprintf(head, sizeof(head),
+             "HTTP/1.1 200 OK\r\n"
+             "Content-Type: %s\r\n"
+             "Access-Control-Allow-Origin: *\r\n"
+             "Access-Control-Allow-Methods: "
+             "POST,GET,PUT,DELETE,OPTIONS\r\n"
+             "Access-Control-Allow-Headers: *\r\n"
+             "Transfer-Encoding: chunked\r\n"
+             "Connection: close\r\n\r\n",
+             content_type);
+    stream_send_str(stream, head);
+
+    return stream;
+}
+
+static bool stream_broken(neu_http_stream_t *stream)
+{
+    bool broken = false;
+
+    pthread_mutex_lock(&stream->mtx);
+    broken = stream->broken;
+    pthread_mutex_unlock(&stream->mtx);
+    return broken;
+}
+
+int neu_http_stream_write(neu_http_stream_t *stream, const char *data,
+                          size_t len)
+{
+    if (stream_broken(stream)) {
+        return -1;
+    }
+
+    while (len > 0) {
+        if (NULL == stream->cur) {
+            stream->cur = calloc(1, sizeof(*stream->cur));
+            if (NULL == stream->cur) {
+                return -1;
+            }
+        }
+
+        stream_chunk_t *chunk = stream->cur;
+        size_t          n     = HTTP_STREAM_CHUNK_SIZE - chunk->len;
+        if (n > len) {
+            n = len;
+        }
+
+        memcpy(chunk->data + HTTP_STREAM_CHUNK_HEAD + chunk->len, data, n);
+        chunk->len += n;
+        data += n;
+        len -= n;
+
+        if (chunk->len == HTTP_STREAM_CHUNK_SIZE && 0 != stream_flush(stream)) {
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+int neu_http_stream_puts(neu_http_stream_t *stream, const char *str)
+{
+    return neu_http_stream_write(stream, str, strlen(str));
+}
+
+static ssize_t stream_cookie_write(void *cookie, const char *buf, size_t size)
+{
+    if (0 != neu_http_stream_write(cookie, buf, size)) {
+        errno = EIO;
+        return -1;
+    }
+    return size;
+}
+
+FILE *neu_http_stream_fopen(neu_http_stream_t *stream)
+{
+    cookie_io_functions_t io = {
+        .write = stream_cookie_write,
+    };
+
+    return fopencookie(stream, "w", io);
+}
+
+void neu_http_stream_close(neu_http_stream_t *stream)
+{
+    bool done = false;
+
+    if (NULL == stream) {
+        return;
+    }
+
+    if (0 == stream_flush(stream)) {
+        stream_send_str(stream, "0\r\n\r\n");
+    }
+
+    // the last write callback finishes the stream, or do it now if the
+    // queue is already drained
+    pthread_mutex_lock(&stream->mtx);
+    stream->closing = true;
+    done            = !stream->sending;
+    pthread_mutex_unlock(&stream->mtx);
+
+    if (done) {
+        stream_finish(stream);
+    }
+}
@@ -0,0 +1,185 @@
+/**
+ * NEURON IIoT System for Industry 4.0
+ * Copyright (C) 2020-2024 EMQ Technologies Co., Ltd All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ **/
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "utils/intern.h"
+#include "utils/uthash.h"
+
+#define INTERN_SHARDS 32
+
+typedef struct {
+    uint32_t       hash;
+    uint32_t       ref; // under the shard lock
+    size_t         len;
+    UT_hash_handle hh;
+    char           str[];
+} entry_t;
+
+typedef struct {
+    pthread_mutex_t mtx;
+    entry_t *       table;
+} shard_t;
+
+static shard_t        shards[INTERN_SHARDS];
+static pthread_once_t shards_once = PTHREAD_ONCE_INIT;
+
+static void shards_init()
+{
+    for (int i = 0; i < INTERN_SHARDS; i++) {
+        pthread_mutex_init(&shards[i].mtx, NULL);
+    }
+}
+
+// FNV-1a, with the murmur3 finalizer, multiplication alone leaves the low
+// bits depending on the low bits of the characters only
+static inline uint32_t str_hash(const char *str, size_t *len)
+{
+    uint32_t    hash = 2166136261u;
+    const char *p    = str;
+
+    for (; *p != '\0'; p++) {
+        hash = (hash ^ (uint8_t) *p) * 16777619u;
+    }
+    *len = p - str;
+
+    hash ^= hash >> 16;
+    hash *= 0x85ebca6bu;
+    hash ^= hash >> 13;
+    hash *= 0xc2b2ae35u;
+    hash ^= hash >> 16;
+    return hash;
+}
+
+static inline entry_t *to_entry(const char *istr)
+{
+    return (entry_t *) (istr - offsetof(entry_t, str));
+}
+
+// the low bits pick the bucket within the shard, shard on the high bits
+static inline shard_t *to_shard(uint32_t hash)
+{
+    pthread_once(&shards_once, shards_init);
+    return &shards[(hash >> 16) % INTERN_SHARDS];
+}
+
+const char *neu_intern(const char *str)
+{
+    size_t   len   = 0;
+    uint32_t hash  = str_hash(str, &len);
+    shard_t *shard = to_shard(hash);
+    entry_t *e     = NULL;
+
+    pthread_mutex_lock(&shard->mtx);
+    HASH_FIND_BYHASHVALUE(hh, shard->table, str, len, hash, e);
+    if (e == NULL) {
+        e = malloc(sizeof(entry_t) + len + 1);
+        if (e == NULL) {
+            pthread_mutex_unlock(&shard->mtx);
+            return NULL;
+        }
+        memset(e, 0, sizeof(entry_t));
+        memcpy(e->str, str, len + 1);
+        e->hash = hash;
+        e->len  = len;
+        HASH_ADD_KEYPTR_BYHASHVALUE(hh, shard->table, e->str, len, hash, e);
+    }
+    e->ref += 1;
+    pthread_mutex_unlock(&shard->mtx);
+
+    return e->str;
+}
+
+const char *neu_intern_find(const char *str)
+{
+    size_t   len   = 0;
+    uint32_t hash  = str_hash(str, &len);
+    shard_t *shard = to_shard(hash);
+    entry_t *e     = NULL;
+
+    pthread_mutex_lock(&shard->mtx);
+    HASH_FIND_BYHASHVALUE(hh, shard->table, str, len, hash, e);
+    pthread_mutex_unlock(&shard->mtx);
+
+    return e != NULL ? e->str : NULL;
+}
+
+const char *neu_intern_ref(const char *istr)
+{
+    entry_t *e     = to_entry(istr);
+    shard_t *shard = to_shard(e->hash);
+
+    pthread_mutex_lock(&shard->mtx);
+    e->ref += 1;
+    pthread_mutex_unlock(&shard->mtx);
+
+    return istr;
+}
+
+void neu_intern_release(const char *istr)
+{
+    entry_t *e     = NULL;
+    shard_t *shard = NULL;
+
+    if (istr == NULL) {
+        return;
+    }
+
+    e     = to_entry(istr);
+    shard = to_shard(e->hash);
+
+    pthread_mutex_lock(&shard->mtx);
+    e->ref -= 1;
+    if (e->ref == 0) {
+        HASH_DEL(shard->table, e);
+    } else {
+        e = NULL;
+    }
+    pthread_mutex_unlock(&shard->mtx);
+
+    free(e);
+}
+
+uint32_t neu_intern_hash(const char *istr)
+{
+    return to_entry(istr)->hash;
+}
+
+size_t neu_intern_len(const char *istr)
+{
+    return to_entry(istr)->len;
+}
+
+size_t neu_intern_count()
+{
+    size_t count = 0;
+
+    pthread_once(&shards_once, shards_init);
+    for (int i = 0; i < INTERN_SHARDS; i++) {
+        shard_t *shard = &shards[i];
+
+        pthread_mutex_lock(&shard->mtx);
+        count += HASH_COUNT(shard->table);
+        pthread_mutex_unlock(&shard->mtx);
+    }
+
+    return count;
+}
@@ -0,0 +1,266 @@
+/**
+ * NEURON IIoT System for Industry 4.0
+ * Copyright (C) 2020-2022 EMQ Technologies Co., Ltd All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ **/
+
+/*
+ * Loopback app used by neuron-bench. It consumes the data reported by every
+ * subscribed group and publishes throughput and device-to-app latency, i.e.
+ * the age of each tag value since it entered the driver cache, as node
+ * metrics. Latency statistics are reset whenever the node is started.
+ */
+
+#include <dlfcn.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <neuron.h>
+
+#include "errcodes.h"
+
+#define BENCH_LATENCY_BUCKETS 10000
+#define BENCH_UPDATE_INTERVAL 1000
+
+#define BENCH_METRIC_TRANS_DATA "bench_trans_data_total"
+#define BENCH_METRIC_TRANS_DATA_TYPE NEU_METRIC_TYPE_COUNTER
+#define BENCH_METRIC_TRANS_DATA_HELP "Number of trans data messages received"
+#define BENCH_METRIC_TAGS "bench_tags_total"
+#define BENCH_METRIC_TAGS_TYPE NEU_METRIC_TYPE_COUNTER
+#define BENCH_METRIC_TAGS_HELP "Number of tag values received"
+#define BENCH_METRIC_TAG_ERRORS "bench_tag_errors_total"
+#define BENCH_METRIC_TAG_ERRORS_TYPE NEU_METRIC_TYPE_COUNTER
+#define BENCH_METRIC_TAG_ERRORS_HELP "Number of tag values carrying an error"
+#define BENCH_METRIC_LATENCY_P50 "bench_latency_p50_ms"
+#define BENCH_METRIC_LATENCY_P50_TYPE NEU_METRIC_TYPE_GAUAGE
+#define BENCH_METRIC_LATENCY_P50_HELP "Median device to app latency"
+#define BENCH_METRIC_LATENCY_P99 "bench_latency_p99_ms"
+#define BENCH_METRIC_LATENCY_P99_TYPE NEU_METRIC_TYPE_GAUAGE
+#define BENCH_METRIC_LATENCY_P99_HELP "99th percentile device to app latency"
+#define BENCH_METRIC_LATENCY_P999 "bench_latency_p999_ms"
+#define BENCH_METRIC_LATENCY_P999_TYPE NEU_METRIC_TYPE_GAUAGE
+#define BENCH_METRIC_LATENCY_P999_HELP "99.9th percentile device to app latency"
+#define BENCH_METRIC_LATENCY_MAX "bench_latency_max_ms"
+#define BENCH_METRIC_LATENCY_MAX_TYPE NEU_METRIC_TYPE_GAUAGE
+#define BENCH_METRIC_LATENCY_MAX_HELP "Maximum device to app latency"
+#define BENCH_METRIC_ALLOCS "bench_allocs_total"
+#define BENCH_METRIC_ALLOCS_TYPE NEU_METRIC_TYPE_GAUAGE
+#define BENCH_METRIC_ALLOCS_HELP \
+    "Heap allocations since process start, needs the alloc count preload"
+
+// provided by libneuron-bench-alloc.so when it is preloaded
+typedef uint64_t (*bench_alloc_count_fn)(void);
+
+struct neu_plugin {
+    neu_plugin_common_t common;
+
+    bool                 started;
+    int64_t              last_update;
+    uint64_t             latency_max;
+    uint64_t             latency_n;
+    uint64_t             latency[BENCH_LATENCY_BUCKETS + 1];
+    bench_alloc_count_fn alloc_count;
+};
+
+static neu_plugin_t *bench_open(void)
+{
+    neu_plugin_t *plugin = calloc(1, sizeof(neu_plugin_t));
+
+    neu_plugin_common_init(&plugin->common);
+
+    return plugin;
+}
+
+static int bench_close(neu_plugin_t *plugin)
+{
+    free(plugin);
+
+    return 0;
+}
+
+static int bench_init(neu_plugin_t *plugin, bool load)
+{
+    (void) load;
+
+    plugin->alloc_count =
+        (bench_alloc_count_fn) dlsym(RTLD_DEFAULT, "neu_bench_alloc_count");
+
+    NEU_PLUGIN_REGISTER_METRIC(plugin, BENCH_METRIC_TRANS_DATA, 0);
+    NEU_PLUGIN_REGISTER_METRIC(plugin, BENCH_METRIC_TAGS, 0);
+    NEU_PLUGIN_REGISTER_METRIC(plugin, BENCH_METRIC_TAG_ERRORS, 0);
+    NEU_PLUGIN_REGISTER_METRIC(plugin, BENCH_METRIC_LATENCY_P50, 0);
+    NEU_PLUGIN_REGISTER_METRIC(plugin, BENCH_METRIC_LATENCY_P99, 0);
+    NEU_PLUGIN_REGISTER_METRIC(plugin, BENCH_METRIC_LATENCY_P999, 0);
+    NEU_PLUGIN_REGISTER_METRIC(plugin, BENCH_METRIC_LATENCY_MAX, 0);
+    if (plugin->alloc_count != NULL) {
+        NEU_PLUGIN_REGISTER_METRIC(plugin, BENCH_METRIC_ALLOCS, 0);
+    }
+
+    plog_notice(plugin, "bench app initialized, alloc count: %s",
+                plugin->alloc_count != NULL ? "on" : "off");
+    return 0;
+}
+
+static int bench_uninit(neu_plugin_t *plugin)
+{
+    (void) plugin;
+    return 0;
+}
+
+static int bench_start(neu_plugin_t *plugin)
+{
+    plugin->latency_max = 0;
+    plugin->latency_n   = 0;
+    memset(plugin->latency, 0, sizeof(plugin->latency));
+    plugin->last_update = neu_time_ms();
+    plugin->started     = true;
+
+    return 0;
+}
+
+static int bench_stop(neu_plugin_t *plugin)
+{
+    plugin->started = false;
+    return 0;
+}
+
+static int bench_config(neu_plugin_t *plugin, const char *config)
+{
+    (void) plugin;
+    (void) config;
+    return 0;
+}
+
+static uint64_t latency_percentile(neu_plugin_t *plugin, double p)
+{
+    uint64_t rank = (uint64_t)(p * plugin->latency_n);
+    uint64_t seen = 0;
+
+    for (int i = 0; i <= BENCH_LATENCY_BUCKETS; i++) {
+        seen += plugin->latency[i];
+        if (seen > rank) {
+            return i;
+        }
+    }
+
+    return plugin->latency_max;
+}
+
+static void update_latency_metrics(neu_plugin_t *plugin)
+{
+    if (plugin->latency_n == 0) {
+        return;
+    }
+
+    NEU_PLUGIN_UPDATE_METRIC(plugin, BENCH_METRIC_LATENCY_P50,
+                             latency_percentile(plugin, 0.5), NULL);
+    NEU_PLUGIN_UPDATE_METRIC(plugin, BENCH_METRIC_LATENCY_P99,
+                             latency_percentile(plugin, 0.99), NULL);
+    NEU_PLUGIN_UPDATE_METRIC(plugin, BENCH_METRIC_LATENCY_P999,
+                             latency_percentile(plugin, 0.999), NULL);
+    NEU_PLUGIN_UPDATE_METRIC(plugin, BENCH_METRIC_LATENCY_MAX,
+                             plugin->latency_max, NULL);
+    if (plugin->alloc_count != NULL) {
+        NEU_PLUGIN_UPDATE_METRIC(plugin, BENCH_METRIC_ALLOCS,
+                                 plugin->alloc_count(), NULL);
+    }
+}
+
+static void handle_trans_data(neu_plugin_t *             plugin,
+                              neu_reqresp_trans_data_t *trans_data)
+{
+    int64_t  now    = neu_time_ms();
+    uint64_t errors = 0;
+
+    utarray_foreach(trans_data->tags, neu_resp_tag_value_meta_t *, tag)
+    {
+        uint64_t latency = 0;
+
+        if (tag->value.type == NEU_TYPE_ERROR || tag->timestamp <= 0) {
+            errors += 1;
+            continue;
+        }
+
+        latency = now > tag->timestamp ? (uint64_t)(now - tag->timestamp) : 0;
+        if (latency > plugin->latency_max) {
+            plugin->latency_max = latency;
+        }
+        plugin->latency[latency < BENCH_LATENCY_BUCKETS
+                            ? latency
+                            : BENCH_LATENCY_BUCKETS] += 1;
+        plugin->latency_n += 1;
+    }
+
+    NEU_PLUGIN_UPDATE_METRIC(plugin, BENCH_METRIC_TRANS_DATA, 1, NULL);
+    NEU_PLUGIN_UPDATE_METRIC(plugin, BENCH_METRIC_TAGS,
+                             utarray_len(trans_data->tags), NULL);
+    if (errors > 0) {
+        NEU_PLUGIN_UPDATE_METRIC(plugin, BENCH_METRIC_TAG_ERRORS, errors,
+                                 NULL);
+    }
+
+    if (now - plugin->last_update >= BENCH_UPDATE_INTERVAL) {
+        plugin->last_update = now;
+        update_latency_metrics(plugin);
+    }
+}
+
+static int bench_request(neu_plugin_t *plugin, neu_reqresp_head_t *head,
+                         void *data)
+{
+    switch (head->type) {
+    case NEU_REQRESP_TRANS_DATA:
+        if (plugin->started) {
+            handle_trans_data(plugin, (neu_reqresp_trans_data_t *) data);
+        }
+        break;
+    case NEU_REQ_SUBSCRIBE_GROUP:
+    case NEU_REQ_UPDATE_SUBSCRIBE_GROUP: {
+        neu_req_subscribe_t *sub = (neu_req_subscribe_t *) data;
+        free(sub->params);
+        free(sub->static_tags);
+        break;
+    }
+    default:
+        break;
+    }
+
+    return 0;
+}
+
+static const neu_plugin_intf_funs_t plugin_intf_funs = {
+    .open    = bench_open,
+    .close   = bench_close,
+    .init    = bench_init,
+    .uninit  = bench_uninit,
+    .start   = bench_start,
+    .stop    = bench_stop,
+    .setting = bench_config,
+    .request = bench_request,
+};
+
+const neu_plugin_module_t neu_plugin_module = {
+    .version         = NEURON_PLUGIN_VER_1_0,
+    .schema          = "bench",
+    .module_name     = "Bench",
+    .module_descr    = "Loopback app recording device to app latency",
+    .module_descr_zh = "Loopback app recording device to app latency",
+    .intf_funs       = &plugin_intf_funs,
+    .kind            = NEU_PLUGIN_KIND_CUSTOM,
+    .type            = NEU_NA_TYPE_APP,
+    .display         = true,
+    .single          = false,
+};
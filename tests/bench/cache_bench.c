@@ -0,0 +1,108 @@
+/**
+ * NEURON IIoT System for Industry 4.0
+ * Copyright (C) 2020-2024 EMQ Technologies Co., Ltd All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ **/
+
+/*
+ * Driver cache memory benchmark, resident memory per cached tag:
+ *
+ *   neuron-cache-bench [n_tags] [str_every]
+ *
+ * Adds `n_tags` tags, 1000000 by default, in groups of 1000 and updates each
+ * once with a float, every `str_every`th one with a 16 character string
+ * instead, 10 by default. The inline size is what a cache entry holding
+ * neu_dvalue_t and the full meta array directly would take.
+ */
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "adapter/driver/cache.h"
+#include "utils/log.h"
+#include "utils/time.h"
+
+#define BENCH_TAG_PER_GROUP 1000
+
+zlog_category_t *neuron         = NULL;
+bool             sub_filter_err = false;
+
+static long rss_kb()
+{
+    long  size = 0, pages = 0;
+    FILE *fp   = fopen("/proc/self/statm", "r");
+
+    if (fp != NULL) {
+        if (fscanf(fp, "%ld %ld", &size, &pages) != 2) {
+            pages = 0;
+        }
+        fclose(fp);
+    }
+    return pages * (sysconf(_SC_PAGESIZE) / 1024);
+}
+
+int main(int argc, char *argv[])
+{
+    int                 n_tags    = argc > 1 ? atoi(argv[1]) : 1000000;
+    int                 str_every = argc > 2 ? atoi(argv[2]) : 10;
+    neu_driver_cache_t *cache     = NULL;
+    long                base      = 0;
+    int64_t             start     = 0;
+    char                group[32] = { 0 };
+    char                tag[32]   = { 0 };
+
+    if (n_tags <= 0 || str_every <= 0) {
+        fprintf(stderr, "usage: %s [n_tags] [str_every]\n", argv[0]);
+        return 1;
+    }
+
+    base  = rss_kb();
+    start = neu_time_ms();
+    cache = neu_driver_cache_new();
+
+    for (int i = 0; i < n_tags; i++) {
+        neu_dvalue_t value = { 0 };
+
+        snprintf(group, sizeof(group), "group%d", i / BENCH_TAG_PER_GROUP);
+        snprintf(tag, sizeof(tag), "tag%d", i);
+
+        if (i % str_every == 0) {
+            value.type = NEU_TYPE_STRING;
+            snprintf(value.value.str, sizeof(value.value.str),
+                     "value-%010d", i);
+        } else {
+            value.type      = NEU_TYPE_FLOAT;
+            value.value.f32 = i * 0.5f;
+        }
+
+        neu_driver_cache_add(cache, group, tag, value);
+        neu_driver_cache_update(cache, group, tag, neu_time_ms(), value, NULL,
+                                0);
+    }
+
+    long used = rss_kb() - base;
+    printf("tags %d time %" PRId64 " ms, rss %ld KB, %.1f bytes per tag\n",
+           n_tags, neu_time_ms() - start, used, used * 1024.0 / n_tags);
+    printf("inline size %zu bytes per tag\n",
+           2 * sizeof(neu_dvalue_t) +
+               NEU_TAG_META_SIZE * sizeof(neu_tag_meta_t));
+
+    neu_driver_cache_destroy(cache);
+    return 0;
+}
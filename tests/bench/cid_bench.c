@@ -0,0 +1,251 @@
+/**
+ * NEURON IIoT System for Industry 4.0
+ * Copyright (C) 2020-2022 EMQ Technologies Co., Ltd All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ **/
+
+/*
+ * CID import benchmark, time and peak RSS of converting a synthetic CID file
+ * into tag groups:
+ *
+ *   neuron-cid-bench [n_da] [batch]
+ *
+ * The file holds `n_da` data attributes, 100000 by default, spread over
+ * datasets of 1000 FCDAs, with the DataTypeTemplates after the IED. Each mode
+ * runs in its own child process so that peak RSS is not shared:
+ *
+ *   parse    neu_cid_parse and neu_cid_to_msg, all groups at once
+ *   stream   neu_cid_reader_next, `batch` tags at a time, 5000 by default
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "utils/cid.h"
+#include "utils/log.h"
+#include "utils/time.h"
+
+#define BENCH_FCDA_PER_DATASET 1000
+#define BENCH_DATASET_PER_LD 10
+#define BENCH_GGIO_PER_LD 100
+#define BENCH_DO_PER_GGIO 10
+
+zlog_category_t *neuron = NULL;
+
+static void write_template(FILE *fp)
+{
+    fprintf(fp, "  <DataTypeTemplates>\n");
+    fprintf(fp, "    <LNodeType id=\"LLN0_T\" lnClass=\"LLN0\">\n");
+    fprintf(fp, "      <DO name=\"Mod\" type=\"INC_T\"/>\n");
+    fprintf(fp, "    </LNodeType>\n");
+    fprintf(fp, "    <LNodeType id=\"GGIO_T\" lnClass=\"GGIO\">\n");
+    for (int i = 1; i <= BENCH_DO_PER_GGIO; i++) {
+        fprintf(fp, "      <DO name=\"AnIn%d\" type=\"MV_T\"/>\n", i);
+    }
+    fprintf(fp, "      <DO name=\"SPCSO1\" type=\"SPC_T\"/>\n");
+    fprintf(fp, "    </LNodeType>\n");
+    fprintf(fp, "    <DOType id=\"INC_T\" cdc=\"INC\">\n");
+    fprintf(fp, "      <DA name=\"stVal\" bType=\"INT32\" fc=\"ST\"/>\n");
+    fprintf(fp, "    </DOType>\n");
+    fprintf(fp, "    <DOType id=\"MV_T\" cdc=\"MV\">\n");
+    fprintf(fp, "      <DA name=\"mag\" bType=\"Struct\" type=\"AV_T\" "
+                "fc=\"MX\"/>\n");
+    fprintf(fp, "      <DA name=\"q\" bType=\"Quality\" fc=\"MX\"/>\n");
+    fprintf(fp, "      <DA name=\"t\" bType=\"Timestamp\" fc=\"MX\"/>\n");
+    fprintf(fp, "    </DOType>\n");
+    fprintf(fp, "    <DOType id=\"SPC_T\" cdc=\"SPC\">\n");
+    fprintf(fp, "      <DA name=\"Oper\" bType=\"Struct\" type=\"OPER_T\" "
+                "fc=\"CO\"/>\n");
+    fprintf(fp, "      <DA name=\"stVal\" bType=\"BOOLEAN\" fc=\"ST\"/>\n");
+    fprintf(fp, "    </DOType>\n");
+    fprintf(fp, "    <DAType id=\"AV_T\">\n");
+    fprintf(fp, "      <BDA name=\"f\" bType=\"FLOAT32\"/>\n");
+    fprintf(fp, "    </DAType>\n");
+    fprintf(fp, "    <DAType id=\"OPER_T\">\n");
+    fprintf(fp, "      <BDA name=\"ctlVal\" bType=\"BOOLEAN\"/>\n");
+    fprintf(fp, "      <BDA name=\"T\" bType=\"Timestamp\"/>\n");
+    fprintf(fp, "      <BDA name=\"Test\" bType=\"BOOLEAN\"/>\n");
+    fprintf(fp, "      <BDA name=\"Check\" bType=\"Check\"/>\n");
+    fprintf(fp, "    </DAType>\n");
+    fprintf(fp, "  </DataTypeTemplates>\n");
+}
+
+static void write_ldevice(FILE *fp, int ld, int n_dataset)
+{
+    fprintf(fp, "        <LDevice inst=\"LD%d\">\n", ld);
+    fprintf(fp, "          <LN0 lnClass=\"LLN0\" lnType=\"LLN0_T\" "
+                "inst=\"\">\n");
+    for (int d = 0; d < n_dataset; d++) {
+        fprintf(fp, "            <DataSet name=\"ds%d\">\n", d);
+        for (int f = 0; f < BENCH_FCDA_PER_DATASET; f++) {
+            int n  = d * BENCH_FCDA_PER_DATASET + f;
+            int ln = n / BENCH_DO_PER_GGIO % BENCH_GGIO_PER_LD + 1;
+            int da = n % BENCH_DO_PER_GGIO + 1;
+
+            fprintf(fp,
+                    "              <FCDA ldInst=\"LD%d\" lnClass=\"GGIO\" "
+                    "lnInst=\"%d\" doName=\"AnIn%d\" daName=\"mag.f\" "
+                    "fc=\"MX\"/>\n",
+                    ld, ln, da);
+        }
+        fprintf(fp, "            </DataSet>\n");
+        fprintf(fp,
+                "            <ReportControl name=\"rpt%d\" rptID=\"rpt%d\" "
+                "datSet=\"ds%d\" intgPd=\"1000\" buffered=\"true\"/>\n",
+                d, d, d);
+    }
+    fprintf(fp, "          </LN0>\n");
+    for (int i = 1; i <= BENCH_GGIO_PER_LD; i++) {
+        fprintf(fp,
+                "          <LN lnClass=\"GGIO\" lnType=\"GGIO_T\" "
+                "inst=\"%d\">\n",
+                i);
+        fprintf(fp, "            <DOI name=\"SPCSO1\"/>\n");
+        fprintf(fp, "          </LN>\n");
+    }
+    fprintf(fp, "        </LDevice>\n");
+}
+
+static int write_cid(const char *path, int n_da)
+{
+    FILE *fp        = fopen(path, "w");
+    int   n_dataset = (n_da + BENCH_FCDA_PER_DATASET - 1) /
+        BENCH_FCDA_PER_DATASET;
+
+    if (fp == NULL) {
+        return -1;
+    }
+
+    fprintf(fp, "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n");
+    fprintf(fp, "<SCL xmlns=\"http://www.iec.ch/61850/2003/SCL\">\n");
+    fprintf(fp, "  <Header id=\"bench\"/>\n");
+    fprintf(fp, "  <IED name=\"BENCH\">\n");
+    fprintf(fp, "    <AccessPoint name=\"S1\">\n");
+    fprintf(fp, "      <Server>\n");
+    for (int ld = 0; n_dataset > 0; ld++) {
+        int n = n_dataset < BENCH_DATASET_PER_LD ? n_dataset
+                                                 : BENCH_DATASET_PER_LD;
+        write_ldevice(fp, ld, n);
+        n_dataset -= n;
+    }
+    fprintf(fp, "      </Server>\n");
+    fprintf(fp, "    </AccessPoint>\n");
+    fprintf(fp, "  </IED>\n");
+    write_template(fp);
+    fprintf(fp, "</SCL>\n");
+
+    fclose(fp);
+    return 0;
+}
+
+static int count_tags(neu_req_add_gtag_t *cmd)
+{
+    int n_tag = 0;
+
+    for (int i = 0; i < cmd->n_group; i++) {
+        n_tag += cmd->groups[i].n_tag;
+    }
+    return n_tag;
+}
+
+static int run_parse(const char *path, int *n_group)
+{
+    cid_t              cid = { 0 };
+    neu_req_add_gtag_t cmd = { 0 };
+    int                n_tag;
+
+    if (neu_cid_parse(path, &cid) != 0) {
+        return -1;
+    }
+    neu_cid_to_msg("bench", &cid, &cmd);
+    *n_group = cmd.n_group;
+    n_tag    = count_tags(&cmd);
+
+    neu_req_add_gtag_fini(&cmd);
+    neu_cid_free(&cid);
+    return n_tag;
+}
+
+static int run_stream(const char *path, int batch, int *n_group)
+{
+    neu_cid_reader_t * reader = neu_cid_reader_open(path);
+    neu_req_add_gtag_t cmd    = { 0 };
+    int                n_tag  = 0;
+    int                ret    = 0;
+
+    if (reader == NULL) {
+        return -1;
+    }
+    while ((ret = neu_cid_reader_next(reader, "bench", batch, &cmd)) > 0) {
+        *n_group += cmd.n_group;
+        n_tag += count_tags(&cmd);
+        neu_req_add_gtag_fini(&cmd);
+    }
+    neu_cid_reader_close(reader);
+
+    return ret < 0 ? -1 : n_tag;
+}
+
+static void run(const char *mode, const char *path, int batch)
+{
+    pid_t pid = fork();
+
+    if (pid == 0) {
+        struct rusage usage   = { 0 };
+        int64_t       start   = neu_time_ms();
+        int           n_group = 0;
+        int           n_tag   = strcmp(mode, "parse") == 0
+                      ? run_parse(path, &n_group)
+                      : run_stream(path, batch, &n_group);
+
+        getrusage(RUSAGE_SELF, &usage);
+        printf("%-8s groups %6d tags %8d time %6" PRId64 " ms, "
+               "peak rss %8ld KB\n",
+               mode, n_group, n_tag, neu_time_ms() - start, usage.ru_maxrss);
+        exit(n_tag < 0 ? 1 : 0);
+    }
+
+    waitpid(pid, NULL, 0);
+}
+
+int main(int argc, char *argv[])
+{
+    int  n_da  = argc > 1 ? atoi(argv[1]) : 100000;
+    int  batch = argc > 2 ? atoi(argv[2]) : 5000;
+    char path[] = "/tmp/neuron-cid-bench-XXXXXX";
+    int  fd     = mkstemp(path);
+
+    if (fd < 0 || n_da <= 0 || batch <= 0) {
+        fprintf(stderr, "usage: %s [n_da] [batch]\n", argv[0]);
+        return 1;
+    }
+    close(fd);
+
+    if (write_cid(path, n_da) != 0) {
+        fprintf(stderr, "write %s fail\n", path);
+        return 1;
+    }
+
+    run("parse", path, batch);
+    run("stream", path, batch);
+
+    unlink(path);
+    return 0;
+}
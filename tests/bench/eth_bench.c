@@ -0,0 +1,190 @@
+/**
+ * NEURON IIoT System for Industry 4.0
+ * Copyright (C) 2020-2022 EMQ Technologies Co., Ltd All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ **/
+
+/*
+ * Receive throughput benchmark of neu_conn_eth over a veth pair, needs
+ * CAP_NET_RAW:
+ *
+ *   ip link add veth0 type veth peer name veth1
+ *   ip link set veth0 up && ip link set veth1 up
+ *   neuron-eth-bench veth0 veth1 10
+ *
+ * A sender thread floods veth1 with profinet frames addressed to veth0, half
+ * of them from a registered source mac and half from an unknown one that the
+ * socket filter has to drop. Frames delivered to the callback are counted and
+ * reported once per second.
+ */
+
+#include <arpa/inet.h>
+#include <net/ethernet.h>
+#include <net/if.h>
+#include <netpacket/packet.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "connection/neu_connection_eth.h"
+#include "utils/log.h"
+
+#define BENCH_FRAME_SIZE 64
+
+zlog_category_t *neuron = NULL;
+
+static uint8_t  known_mac[ETH_ALEN]   = { 0x02, 0x00, 0x00, 0x00, 0x00, 0x01 };
+static uint8_t  unknown_mac[ETH_ALEN] = { 0x02, 0x00, 0x00, 0x00, 0x00, 0x02 };
+static uint64_t sent                  = 0;
+static uint64_t received              = 0;
+static uint64_t leaked                = 0;
+static bool     running               = true;
+
+struct sender {
+    int     fd;
+    uint8_t dst[ETH_ALEN];
+};
+
+static void on_frame(neu_conn_eth_t *conn, void *ctx, uint16_t protocol,
+                     uint16_t n_byte, uint8_t *bytes, uint8_t src_mac[6])
+{
+    (void) conn;
+    (void) ctx;
+    (void) protocol;
+    (void) n_byte;
+    (void) bytes;
+
+    if (memcmp(src_mac, known_mac, ETH_ALEN) == 0) {
+        __atomic_add_fetch(&received, 1, __ATOMIC_RELAXED);
+    } else {
+        __atomic_add_fetch(&leaked, 1, __ATOMIC_RELAXED);
+    }
+}
+
+static int open_sender(const char *interface)
+{
+    struct sockaddr_ll sll = { 0 };
+    int                fd  = socket(PF_PACKET, SOCK_RAW, htons(0x8892));
+
+    if (fd < 0) {
+        return -1;
+    }
+
+    sll.sll_family   = AF_PACKET;
+    sll.sll_ifindex  = if_nametoindex(interface);
+    sll.sll_protocol = htons(0x8892);
+    if (sll.sll_ifindex == 0 ||
+        bind(fd, (struct sockaddr *) &sll, sizeof(sll)) != 0) {
+        close(fd);
+        return -1;
+    }
+
+    return fd;
+}
+
+static void *send_loop(void *arg)
+{
+    struct sender *sender                  = (struct sender *) arg;
+    uint8_t        frame[BENCH_FRAME_SIZE] = { 0 };
+    struct ethhdr *ehdr                    = (struct ethhdr *) frame;
+    uint64_t       seq                     = 0;
+
+    memcpy(ehdr->h_dest, sender->dst, ETH_ALEN);
+    ehdr->h_proto = htons(0x8892);
+
+    while (__atomic_load_n(&running, __ATOMIC_RELAXED)) {
+        memcpy(ehdr->h_source, seq % 2 == 0 ? known_mac : unknown_mac,
+               ETH_ALEN);
+        memcpy(frame + ETH_HLEN, &seq, sizeof(seq));
+        if (send(sender->fd, frame, sizeof(frame), 0) == sizeof(frame)) {
+            seq += 1;
+            if (seq % 2 == 0) {
+                __atomic_add_fetch(&sent, 1, __ATOMIC_RELAXED);
+            }
+        }
+    }
+
+    return NULL;
+}
+
+int main(int argc, char *argv[])
+{
+    neu_conn_eth_t *    conn     = NULL;
+    neu_conn_eth_sub_t *sub      = NULL;
+    struct sender       sender   = { 0 };
+    pthread_t           tid      = { 0 };
+    int                 duration = 10;
+    uint64_t            last_rx  = 0;
+    uint64_t            last_tx  = 0;
+
+    if (argc < 3) {
+        fprintf(stderr, "usage: %s <rx interface> <tx interface> [seconds]\n",
+                argv[0]);
+        return 1;
+    }
+    if (argc > 3) {
+        duration = atoi(argv[3]);
+    }
+
+    if (neu_conn_eth_check_interface(argv[1]) != 0) {
+        fprintf(stderr, "invalid interface %s\n", argv[1]);
+        return 1;
+    }
+
+    sender.fd = open_sender(argv[2]);
+    if (sender.fd < 0) {
+        fprintf(stderr, "open %s failed\n", argv[2]);
+        return 1;
+    }
+
+    conn = neu_conn_eth_init(argv[1], NULL);
+    sub  = neu_conn_eth_register(conn, known_mac, on_frame);
+    neu_conn_eth_get_mac(conn, sender.dst);
+
+    pthread_create(&tid, NULL, send_loop, &sender);
+
+    for (int i = 0; i < duration; i++) {
+        uint64_t rx = 0;
+        uint64_t tx = 0;
+
+        sleep(1);
+        rx = __atomic_load_n(&received, __ATOMIC_RELAXED);
+        tx = __atomic_load_n(&sent, __ATOMIC_RELAXED);
+        printf("sent %lu frames/s, received %lu frames/s\n",
+               (unsigned long) (tx - last_tx), (unsigned long) (rx - last_rx));
+        last_rx = rx;
+        last_tx = tx;
+    }
+
+    __atomic_store_n(&running, false, __ATOMIC_RELAXED);
+    pthread_join(tid, NULL);
+    // let the last ring block retire
+    usleep(100 * 1000);
+
+    printf("total sent %lu, received %lu (%.1f frames/s), leaked %lu\n",
+           (unsigned long) sent, (unsigned long) received,
+           (double) received / duration, (unsigned long) leaked);
+
+    neu_conn_eth_unregister(conn, sub);
+    neu_conn_eth_uninit(conn);
+    close(sender.fd);
+
+    return received > 0 && leaked == 0 ? 0 : 1;
+}
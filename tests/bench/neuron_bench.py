@@ -0,0 +1,327 @@
+#!/usr/bin/env python3
+#
+# End-to-end pipeline benchmark: modbus_load_simulator -> Modbus TCP drivers
+# -> driver cache -> group report -> bench loopback app.
+#
+# Every scenario starts a fresh neuron and simulator, builds N drivers x M
+# groups x K tags through the REST API, subscribes all groups to the bench
+# app and samples the run. Results are written as JSON so they can be
+# compared across commits.
+#
+#   python3 tests/bench/neuron_bench.py --build-dir build \
+#       --scenario tests/bench/scenarios/default.json --output bench.json
+
+import argparse
+import base64
+import glob
+import json
+import os
+import re
+import shutil
+import subprocess
+import sys
+import time
+from datetime import datetime, timezone
+
+import requests
+
+BASE_URL = "http://127.0.0.1:7000"
+BENCH_APP = "bench"
+PLUGIN_MODBUS_TCP = "Modbus TCP"
+NEU_CTL_START = 0
+NEU_CTL_STOP = 1
+NEU_TYPE_UINT16 = 4
+NEU_TAG_ATTRIBUTE_READ = 1
+
+DEFAULT_SCENARIO = {
+    "name": "default",
+    "drivers": 1,
+    "groups": 1,
+    "tags": 100,
+    "interval": 100,
+    "warmup": 5,
+    "duration": 30,
+    "port": 60502,
+    "simulator": {},
+}
+
+
+def api(method, path, body=None):
+    response = requests.request(method, BASE_URL + path, json=body)
+    if response.status_code != 200:
+        raise RuntimeError(f"{method} {path}: {response.status_code} "
+                           f"{response.text}")
+    return response
+
+
+def wait_http(timeout=10):
+    deadline = time.time() + timeout
+    while time.time() < deadline:
+        try:
+            requests.post(BASE_URL + "/api/v2/ping", timeout=1)
+            return
+        except requests.exceptions.ConnectionError:
+            time.sleep(0.2)
+    raise RuntimeError("neuron http api is not up")
+
+
+def start_simulator(build_dir, scenario):
+    sim = scenario["simulator"]
+    registers = min(65536, max(10000, scenario["groups"] * scenario["tags"]))
+    args = ["./modbus_load_simulator",
+            "--port", str(scenario["port"]),
+            "--ports", str(scenario["drivers"]),
+            "--slaves", str(sim.get("slaves", 1)),
+            "--registers", str(registers),
+            "--threads", str(sim.get("threads", 2)),
+            "--rtt", str(sim.get("rtt", 0)),
+            "--rtt_spread", str(sim.get("rtt_spread", 0)),
+            "--jitter", str(sim.get("jitter", 0)),
+            "--drop", str(sim.get("drop", 0)),
+            "--exception", str(sim.get("exception", 0)),
+            "--inflight", str(sim.get("inflight", 1)),
+            "--wave", sim.get("wave", "sine"),
+            "--stats", "0"]
+    process = subprocess.Popen(args, cwd=os.path.join(build_dir, "simulator"),
+                               stdout=subprocess.DEVNULL)
+    time.sleep(0.5)
+    if process.poll() is not None:
+        raise RuntimeError("modbus_load_simulator exited: " + " ".join(args))
+    return process
+
+
+def clear_persistence(build_dir):
+    # only ever the persistence directory of a neuron build tree
+    if not os.path.isfile(os.path.join(build_dir, "neuron")):
+        raise RuntimeError(f"{build_dir} is not a neuron build directory")
+    persistence = os.path.realpath(os.path.join(build_dir, "persistence"))
+    for path in glob.glob(os.path.join(persistence, "*")):
+        if os.path.isdir(path) and not os.path.islink(path):
+            shutil.rmtree(path)
+        else:
+            os.remove(path)
+
+
+def start_neuron(build_dir, alloc_count):
+    clear_persistence(build_dir)
+    env = dict(os.environ)
+    if alloc_count:
+        env["LD_PRELOAD"] = os.path.abspath(
+            os.path.join(build_dir, "tests/plugins/libneuron-bench-alloc.so"))
+    process = subprocess.Popen(["./neuron", "--disable_auth"], cwd=build_dir,
+                               env=env, stderr=subprocess.DEVNULL)
+    wait_http()
+    return process
+
+
+def stop(process):
+    if process is not None and process.poll() is None:
+        process.terminate()
+        process.wait()
+
+
+def load_bench_plugin(build_dir):
+    def b64(path):
+        with open(os.path.join(build_dir, path), "rb") as f:
+            return str(base64.b64encode(f.read()), encoding="utf-8")
+
+    api("POST", "/api/v2/plugin", {
+        "library": "libplugin-bench.so",
+        "so_file": b64("tests/plugins/libplugin-bench.so"),
+        "schema_file": b64("tests/plugins/schema/bench.json"),
+    })
+
+
+def setup_pipeline(scenario):
+    groups = []
+    for d in range(scenario["drivers"]):
+        driver = f"bench-drv-{d}"
+        api("POST", "/api/v2/node", {"name": driver,
+                                     "plugin": PLUGIN_MODBUS_TCP})
+        api("POST", "/api/v2/node/setting", {"node": driver, "params": {
+            "connection_mode": 0, "transport_mode": 0, "interval": 0,
+            "host": "127.0.0.1", "port": scenario["port"] + d,
+            "timeout": 3000, "max_retries": 2, "retry_interval": 1}})
+
+        gtags = []
+        for g in range(scenario["groups"]):
+            base = g * scenario["tags"]
+            slave = g % scenario["simulator"].get("slaves", 1) + 1
+            gtags.append({
+                "group": f"group-{g}",
+                "interval": scenario["interval"],
+                "tags": [{"name": f"tag-{t}",
+                          "address": f"{slave}!3{base + t + 1:05d}",
+                          "attribute": NEU_TAG_ATTRIBUTE_READ,
+                          "type": NEU_TYPE_UINT16}
+                         for t in range(scenario["tags"])],
+            })
+            groups.append({"driver": driver, "group": f"group-{g}"})
+        api("POST", "/api/v2/gtags", {"node": driver, "groups": gtags})
+
+    api("POST", "/api/v2/node", {"name": BENCH_APP, "plugin": "Bench"})
+    api("POST", "/api/v2/node/setting", {"node": BENCH_APP, "params": {}})
+    api("POST", "/api/v2/subscribes", {"app": BENCH_APP, "groups": groups})
+
+
+def bench_metrics():
+    text = api("GET", f"/api/v2/metrics?category=app&node={BENCH_APP}").text
+    metrics = {}
+    for name, value in re.findall(r'^(bench_\w+)\{node="[^"]*"\} (\d+)$',
+                                  text, re.M):
+        metrics[name] = int(value)
+    return metrics
+
+
+def proc_cpu_ms(pid):
+    with open(f"/proc/{pid}/stat") as f:
+        fields = f.read().rsplit(")", 1)[1].split()
+    ticks = int(fields[11]) + int(fields[12])
+    return ticks * 1000 / os.sysconf("SC_CLK_TCK")
+
+
+def proc_rss_kb(pid):
+    rss, hwm = 0, 0
+    with open(f"/proc/{pid}/status") as f:
+        for line in f:
+            if line.startswith("VmRSS:"):
+                rss = int(line.split()[1])
+            elif line.startswith("VmHWM:"):
+                hwm = int(line.split()[1])
+    return rss, hwm
+
+
+def run_scenario(build_dir, scenario, alloc_count):
+    simulator, neuron = None, None
+    try:
+        simulator = start_simulator(build_dir, scenario)
+        neuron = start_neuron(build_dir, alloc_count)
+        load_bench_plugin(build_dir)
+        setup_pipeline(scenario)
+
+        time.sleep(scenario["warmup"])
+        # restarting the app resets its latency histogram
+        api("POST", "/api/v2/node/ctl", {"node": BENCH_APP,
+                                         "cmd": NEU_CTL_STOP})
+        api("POST", "/api/v2/node/ctl", {"node": BENCH_APP,
+                                         "cmd": NEU_CTL_START})
+
+        start_metrics = bench_metrics()
+        start_cpu = proc_cpu_ms(neuron.pid)
+        start_time = time.time()
+        rss_max = 0
+        while time.time() - start_time < scenario["duration"]:
+            time.sleep(1)
+            rss_max = max(rss_max, proc_rss_kb(neuron.pid)[0])
+        # latency gauges refresh once per second inside the app
+        time.sleep(1.1)
+        elapsed = time.time() - start_time
+        cpu_ms = proc_cpu_ms(neuron.pid) - start_cpu
+        end_metrics = bench_metrics()
+        rss, hwm = proc_rss_kb(neuron.pid)
+
+        def delta(name):
+            return end_metrics.get(name, 0) - start_metrics.get(name, 0)
+
+        tags = delta("bench_tags_total")
+        result = {
+            "name": scenario["name"],
+            "drivers": scenario["drivers"],
+            "groups": scenario["groups"],
+            "tags": scenario["tags"],
+            "interval_ms": scenario["interval"],
+            "duration_s": round(elapsed, 3),
+            "messages": delta("bench_trans_data_total"),
+            "tag_values": tags,
+            "tag_errors": delta("bench_tag_errors_total"),
+            "tags_per_s": round(tags / elapsed, 1),
+            "latency_ms": {
+                "p50": end_metrics.get("bench_latency_p50_ms"),
+                "p99": end_metrics.get("bench_latency_p99_ms"),
+                "p999": end_metrics.get("bench_latency_p999_ms"),
+                "max": end_metrics.get("bench_latency_max_ms"),
+            },
+            "cpu_ms": round(cpu_ms, 1),
+            "cpu_ms_per_1k_tags": round(cpu_ms * 1000 / tags, 3)
+            if tags > 0 else None,
+            "rss_kb": rss,
+            "rss_max_kb": max(rss_max, rss),
+            "rss_hwm_kb": hwm,
+        }
+        if "bench_allocs_total" in end_metrics:
+            allocs = delta("bench_allocs_total")
+            result["allocs"] = allocs
+            result["allocs_per_1k_tags"] = round(allocs * 1000 / tags, 1) \
+                if tags > 0 else None
+        return result
+    finally:
+        stop(neuron)
+        stop(simulator)
+
+
+def load_scenarios(paths):
+    scenarios = []
+    for path in paths:
+        with open(path) as f:
+            data = json.load(f)
+        for item in data if isinstance(data, list) else [data]:
+            scenario = dict(DEFAULT_SCENARIO)
+            scenario.update(item)
+            if scenario["groups"] * scenario["tags"] > 65535:
+                raise ValueError(f"{scenario['name']}: groups x tags of a "
+                                 "driver must fit in 65535 registers")
+            scenarios.append(scenario)
+    return scenarios
+
+
+def git_commit():
+    try:
+        return subprocess.check_output(
+            ["git", "rev-parse", "HEAD"], stderr=subprocess.DEVNULL,
+            cwd=os.path.dirname(os.path.abspath(__file__))).decode().strip()
+    except (subprocess.CalledProcessError, OSError):
+        return None
+
+
+def main():
+    parser = argparse.ArgumentParser(description="neuron pipeline benchmark")
+    parser.add_argument("--build-dir", default="build")
+    parser.add_argument("--scenario", action="append", default=[],
+                        help="scenario json file, may be repeated")
+    parser.add_argument("--only", help="run only the named scenario")
+    parser.add_argument("--duration", type=int,
+                        help="override the duration of every scenario")
+    parser.add_argument("--no-alloc-count", action="store_true",
+                        help="do not preload the allocation counter")
+    parser.add_argument("--output", help="write the report to this file")
+    args = parser.parse_args()
+
+    if not args.scenario:
+        args.scenario = [os.path.join(os.path.dirname(__file__),
+                                      "scenarios", "default.json")]
+
+    report = {
+        "commit": git_commit(),
+        "date": datetime.now(timezone.utc).isoformat(timespec="seconds"),
+        "results": [],
+    }
+    for scenario in load_scenarios(args.scenario):
+        if args.only and scenario["name"] != args.only:
+            continue
+        if args.duration:
+            scenario["duration"] = args.duration
+        print(f"running {scenario['name']}: {scenario['drivers']} drivers x "
+              f"{scenario['groups']} groups x {scenario['tags']} tags",
+              file=sys.stderr)
+        report["results"].append(
+            run_scenario(args.build_dir, scenario, not args.no_alloc_count))
+
+    text = json.dumps(report, indent=4)
+    if args.output:
+        with open(args.output, "w") as f:
+            f.write(text + "\n")
+    print(text)
+
+
+if __name__ == "__main__":
+    main()
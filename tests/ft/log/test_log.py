@@ -126,6 +126,18 @@ class TestLog:
         response = api.get_nodes_state(node='')
         assert 200 == response.status_code
         assert "notice" == response.json()['neuron_core']
+
+    @description(given="node exists", when="toggle protocol capture", then="change success")
+    def test_change_node_protocol_capture(self):
+        response = api.change_log_level(json={"node": 'modbus-tcp-1', "level": 'info', "core": False, "capture": True})
+        assert 0 == response.json()['error']
+
+        response = api.change_log_level(json={"node": 'modbus-tcp-1', "level": 'info', "core": False, "capture": False})
+        assert 0 == response.json()['error']
+
+        response = api.get_nodes_state('modbus-tcp-1')
+        assert 200 == response.status_code
+        assert "info" == response.json()['log_level']
     
     @description(given="neuron started", when="get log list", then="success")
     def test_get_log_list(self):
@@ -117,6 +117,15 @@ class TestMetrics:
             "last_60s_disconnections": (0, {}),
             "last_600s_disconnections": (0, {}),
             "last_1800s_disconnections": (0, {}),
+            "queue_wait_us": (0, {}),
+            "queue_wait_us_sum": (0, {}),
+            "queue_wait_us_count": (0, {}),
+            "encode_us": (0, {}),
+            "encode_us_sum": (0, {}),
+            "encode_us_count": (0, {}),
+            "publish_ack_ms": (0, {}),
+            "publish_ack_ms_sum": (0, {}),
+            "publish_ack_ms_count": (0, {}),
         }
 
         assert_metrics(resp.content.decode('utf-8'), expected_metrics)
@@ -139,6 +148,18 @@ class TestMetrics:
             "link_state": (0, {}),
             "running_state": (1, {}),
             "last_rtt_ms": (9999, {}),
+            "read_rtt_ms": (0, {}),
+            "read_rtt_ms_sum": (0, {}),
+            "read_rtt_ms_count": (0, {}),
+            "cache_update_us": (0, {}),
+            "cache_update_us_sum": (0, {}),
+            "cache_update_us_count": (0, {}),
+            "report_build_us": (0, {}),
+            "report_build_us_sum": (0, {}),
+            "report_build_us_count": (0, {}),
+            "read_plan_build_us": (0, {}),
+            "read_plan_build_us_sum": (0, {}),
+            "read_plan_build_us_count": (0, {}),
             "send_bytes": (0, {}),
             "recv_bytes": (0, {}),
             "tag_reads_total": (0, {}),
@@ -0,0 +1,197 @@
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <sys/stat.h>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+extern "C" {
+#include "utils/capture.h"
+#include "utils/log.h"
+}
+
+zlog_category_t *neuron = NULL;
+
+struct pcapng_frame {
+    std::string          comment;
+    uint32_t             flags;
+    std::vector<uint8_t> bytes;
+};
+
+static uint32_t u32(const std::vector<uint8_t> &buf, size_t off)
+{
+    uint32_t v = 0;
+    memcpy(&v, &buf[off], sizeof(v));
+    return v;
+}
+
+// enhanced packet blocks of every section of the file
+static std::vector<pcapng_frame> read_pcapng(const char *path, int *n_section)
+{
+    std::vector<pcapng_frame> frames;
+    std::vector<uint8_t>      buf;
+    FILE *                    fp = fopen(path, "rb");
+    uint8_t                   chunk[4096];
+    size_t                    n = 0;
+
+    *n_section = 0;
+    if (fp == NULL) {
+        return frames;
+    }
+    while ((n = fread(chunk, 1, sizeof(chunk), fp)) > 0) {
+        buf.insert(buf.end(), chunk, chunk + n);
+    }
+    fclose(fp);
+
+    for (size_t off = 0; off + 12 <= buf.size();) {
+        uint32_t type  = u32(buf, off);
+        uint32_t total = u32(buf, off + 4);
+
+        EXPECT_EQ(0u, total % 4);
+        EXPECT_EQ(total, u32(buf, off + total - 4));
+        if (type == 0x0A0D0D0A) {
+            EXPECT_EQ(0x1A2B3C4Du, u32(buf, off + 8));
+            *n_section += 1;
+        } else if (type == 6) {
+            pcapng_frame f;
+            uint32_t     len = u32(buf, off + 20);
+            size_t       opt = off + 28 + ((len + 3) & ~3u);
+
+            f.bytes.assign(&buf[off + 28], &buf[off + 28 + len]);
+            while (u32(buf, opt) != 0) {
+                uint16_t code = u32(buf, opt) & 0xFFFF;
+                uint16_t olen = u32(buf, opt) >> 16;
+
+                if (code == 1) {
+                    f.comment.assign((const char *) &buf[opt + 4], olen);
+                } else if (code == 2) {
+                    f.flags = u32(buf, opt + 4);
+                }
+                opt += 4 + ((olen + 3) & ~3u);
+            }
+            frames.push_back(f);
+        }
+        off += total;
+    }
+
+    return frames;
+}
+
+TEST(test_capture, frames_should_be_written_as_pcapng)
+{
+    uint8_t send[] = { 0x01, 0x03, 0x00, 0x00, 0x00, 0x0A, 0xC5, 0xCD };
+    uint8_t recv[] = { 0x01, 0x83, 0x02 };
+    int     n_section = 0;
+
+    mkdir(NEU_CAPTURE_DIR, 0755);
+    remove(NEU_CAPTURE_DIR "/capture-node.pcapng");
+
+    neu_capture_frame("capture-node", NEU_CAPTURE_SEND, send, sizeof(send));
+    neu_capture_frame("capture-node", NEU_CAPTURE_RECV, recv, sizeof(recv));
+    neu_capture_close("capture-node");
+    neu_capture_flush();
+
+    std::vector<pcapng_frame> frames =
+        read_pcapng(NEU_CAPTURE_DIR "/capture-node.pcapng", &n_section);
+    ASSERT_EQ(2u, frames.size());
+    EXPECT_EQ(1, n_section);
+    EXPECT_EQ("capture-node", frames[0].comment);
+    EXPECT_EQ(2u, frames[0].flags);
+    EXPECT_EQ(std::vector<uint8_t>(send, send + sizeof(send)),
+              frames[0].bytes);
+    EXPECT_EQ(1u, frames[1].flags);
+    EXPECT_EQ(std::vector<uint8_t>(recv, recv + sizeof(recv)),
+              frames[1].bytes);
+
+    // reopening appends a new section
+    neu_capture_frame("capture-node", NEU_CAPTURE_SEND, send, sizeof(send));
+    neu_capture_close("capture-node");
+    neu_capture_flush();
+    frames = read_pcapng(NEU_CAPTURE_DIR "/capture-node.pcapng", &n_section);
+    EXPECT_EQ(3u, frames.size());
+    EXPECT_EQ(2, n_section);
+
+    remove(NEU_CAPTURE_DIR "/capture-node.pcapng");
+}
+
+TEST(test_capture, rings_should_wrap_and_keep_order_per_thread)
+{
+    int n_section = 0;
+
+    mkdir(NEU_CAPTURE_DIR, 0755);
+    remove(NEU_CAPTURE_DIR "/capture-a.pcapng");
+    remove(NEU_CAPTURE_DIR "/capture-b.pcapng");
+
+    // more than a ring worth of frames from each thread, flushed on the way
+    auto producer = [](const char *node) {
+        uint8_t frame[250];
+
+        for (uint32_t i = 0; i < 4000; i++) {
+            memset(frame, 0, sizeof(frame));
+            memcpy(frame, &i, sizeof(i));
+            neu_capture_frame(node, NEU_CAPTURE_SEND, frame, 1 + i % 250);
+            if (i % 500 == 0) {
+                neu_capture_flush();
+            }
+        }
+    };
+    std::thread a(producer, "capture-a");
+    std::thread b(producer, "capture-b");
+    a.join();
+    b.join();
+
+    neu_capture_close("capture-a");
+    neu_capture_close("capture-b");
+    neu_capture_flush();
+    EXPECT_EQ(0u, neu_capture_dropped());
+
+    for (const char *path :
+         { NEU_CAPTURE_DIR "/capture-a.pcapng",
+           NEU_CAPTURE_DIR "/capture-b.pcapng" }) {
+        std::vector<pcapng_frame> frames = read_pcapng(path, &n_section);
+
+        ASSERT_EQ(4000u, frames.size());
+        for (uint32_t i = 0; i < frames.size(); i++) {
+            uint32_t seq = 0;
+
+            ASSERT_EQ(1 + i % 250, frames[i].bytes.size());
+            memcpy(&seq, frames[i].bytes.data(),
+                   std::min<size_t>(sizeof(seq), frames[i].bytes.size()));
+            if (frames[i].bytes.size() >= sizeof(seq)) {
+                EXPECT_EQ(i, seq);
+            }
+        }
+        remove(path);
+    }
+}
+
+TEST(test_capture, close_should_wait_for_frames_of_other_rings)
+{
+    uint8_t frame[] = { 0x01, 0x03 };
+    int     n_section = 0;
+
+    mkdir(NEU_CAPTURE_DIR, 0755);
+    remove(NEU_CAPTURE_DIR "/capture-c.pcapng");
+
+    // the close sits in a newer ring, drained before the frame opens the file
+    neu_capture_frame("capture-c", NEU_CAPTURE_SEND, frame, sizeof(frame));
+    std::thread closer([]() { neu_capture_close("capture-c"); });
+    closer.join();
+    neu_capture_flush();
+
+    std::vector<pcapng_frame> frames =
+        read_pcapng(NEU_CAPTURE_DIR "/capture-c.pcapng", &n_section);
+    EXPECT_EQ(1u, frames.size());
+
+    // the file was closed, capturing again starts a new section
+    neu_capture_frame("capture-c", NEU_CAPTURE_SEND, frame, sizeof(frame));
+    neu_capture_close("capture-c");
+    neu_capture_flush();
+    frames = read_pcapng(NEU_CAPTURE_DIR "/capture-c.pcapng", &n_section);
+    EXPECT_EQ(2u, frames.size());
+    EXPECT_EQ(2, n_section);
+
+    remove(NEU_CAPTURE_DIR "/capture-c.pcapng");
+}
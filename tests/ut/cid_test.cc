@@ -1,3 +1,7 @@
+#include <cstdio>
+#include <string>
+#include <vector>
+
 #include <gtest/gtest.h>
 
 #include "neuron.h"
@@ -88,6 +92,171 @@ TEST(cid_from_string, cid)
     free(info);
 }
 
+static const char *stream_cid =
+    "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+    "<SCL xmlns=\"http://www.iec.ch/61850/2003/SCL\">\n"
+    " <IED name=\"IED1\">\n"
+    "  <AccessPoint name=\"S1\"><Server>\n"
+    "   <LDevice inst=\"LD0\">\n"
+    "    <LN0 lnClass=\"LLN0\" lnType=\"LLN0_T\" inst=\"\">\n"
+    "     <DataSet name=\"ds1\">\n"
+    "      <FCDA ldInst=\"LD0\" lnClass=\"GGIO\" lnInst=\"1\" "
+    "doName=\"AnIn1\" daName=\"mag.f\" fc=\"MX\"/>\n"
+    "      <FCDA ldInst=\"LD0\" lnClass=\"GGIO\" lnInst=\"1\" "
+    "doName=\"AnIn1\" fc=\"MX\"/>\n"
+    "     </DataSet>\n"
+    "     <ReportControl name=\"r1\" rptID=\"id1\" datSet=\"ds1\" "
+    "intgPd=\"1000\" buffered=\"true\"/>\n"
+    "    </LN0>\n"
+    "    <LN lnClass=\"GGIO\" lnType=\"GGIO_T\" inst=\"1\">\n"
+    "     <DOI name=\"SPCSO1\"/>\n"
+    "    </LN>\n"
+    "   </LDevice>\n"
+    "   <LDevice inst=\"LD1\">\n"
+    "    <LN lnClass=\"GGIO\" lnType=\"GGIO_T\" inst=\"2\">\n"
+    "     <DataSet name=\"ds2\">\n"
+    "      <FCDA ldInst=\"LD1\" lnClass=\"GGIO\" lnInst=\"2\" "
+    "doName=\"AnIn1\" daName=\"q\" fc=\"MX\"/>\n"
+    "     </DataSet>\n"
+    "     <ReportControl name=\"r2\" rptID=\"id2\" datSet=\"ds2\"/>\n"
+    "    </LN>\n"
+    "   </LDevice>\n"
+    "  </Server></AccessPoint>\n"
+    " </IED>\n"
+    " <DataTypeTemplates>\n"
+    "  <LNodeType id=\"LLN0_T\" lnClass=\"LLN0\"/>\n"
+    "  <LNodeType id=\"GGIO_T\" lnClass=\"GGIO\">\n"
+    "   <DO name=\"AnIn1\" type=\"MV_T\"/>\n"
+    "   <DO name=\"SPCSO1\" type=\"SPC_T\"/>\n"
+    "  </LNodeType>\n"
+    "  <DOType id=\"MV_T\" cdc=\"MV\">\n"
+    "   <DA name=\"mag\" bType=\"Struct\" type=\"AV_T\" fc=\"MX\"/>\n"
+    "   <DA name=\"q\" bType=\"Quality\" fc=\"MX\"/>\n"
+    "  </DOType>\n"
+    "  <DOType id=\"SPC_T\" cdc=\"SPC\">\n"
+    "   <DA name=\"Oper\" bType=\"Struct\" type=\"OPER_T\" fc=\"CO\"/>\n"
+    "  </DOType>\n"
+    "  <DAType id=\"AV_T\"><BDA name=\"f\" bType=\"FLOAT32\"/></DAType>\n"
+    "  <DAType id=\"OPER_T\">\n"
+    "   <BDA name=\"ctlVal\" bType=\"BOOLEAN\"/>\n"
+    "   <BDA name=\"T\" bType=\"Timestamp\"/>\n"
+    "  </DAType>\n"
+    " </DataTypeTemplates>\n"
+    "</SCL>\n";
+
+static void write_file(const char *path, const char *content, size_t len)
+{
+    FILE *fp = fopen(path, "w");
+    ASSERT_NE(nullptr, fp);
+    fwrite(content, 1, len, fp);
+    fclose(fp);
+}
+
+// a group continued from the previous batch is merged into its first part
+static void append_groups(neu_req_add_gtag_t *      cmd,
+                          std::vector<std::string> &out, std::string &last)
+{
+    for (int i = 0; i < cmd->n_group; i++) {
+        std::string g;
+
+        if (last != cmd->groups[i].group || out.empty()) {
+            out.push_back(std::string(cmd->groups[i].group) + " " +
+                          std::to_string(cmd->groups[i].interval));
+            last = cmd->groups[i].group;
+        }
+        for (int j = 0; j < cmd->groups[i].n_tag; j++) {
+            neu_datatag_t *tag = &cmd->groups[i].tags[j];
+
+            g += std::string(" ") + tag->name + "|" + tag->address + "|" +
+                tag->description + "|" + std::to_string(tag->type);
+            for (int k = 0; k < tag->n_format; k++) {
+                g += "," + std::to_string(tag->format[k]);
+            }
+        }
+        out.back() += g;
+    }
+}
+
+static std::vector<std::string> group_strings(neu_req_add_gtag_t *cmd)
+{
+    std::vector<std::string> out;
+    std::string              last;
+
+    append_groups(cmd, out, last);
+    return out;
+}
+
+TEST(cid_reader, batches_should_match_parse)
+{
+    const char *path = "./cid_stream_test.cid";
+    write_file(path, stream_cid, strlen(stream_cid));
+
+    cid_t              cid = { 0 };
+    neu_req_add_gtag_t all = { 0 };
+    ASSERT_EQ(0, neu_cid_parse(path, &cid));
+    neu_cid_to_msg((char *) "driver", &cid, &all);
+    neu_cid_free(&cid);
+
+    std::vector<std::string> expect = group_strings(&all);
+    ASSERT_EQ(3u, expect.size());
+    EXPECT_EQ(0u, expect[0].find("S1/LD0$Control 10000 GGIO1$SPCSO1$Oper|"));
+    EXPECT_EQ(0u, expect[1].find("S1/LD0$LLN0$ds1 1000 GGIO1.AnIn1.mag.f|"));
+    EXPECT_EQ(0u, expect[2].find("S1/LD1$GGIO$ds2 10000 GGIO2.AnIn1.q|"));
+
+    int n_tag = 0;
+    for (int i = 0; i < all.n_group; i++) {
+        n_tag += all.groups[i].n_tag;
+    }
+    neu_req_add_gtag_fini(&all);
+
+    // groups larger than a batch are split, every batch but the last is full
+    for (int max_tags : { 1, 2, 1000 }) {
+        neu_cid_reader_t *       reader = neu_cid_reader_open(path);
+        neu_req_add_gtag_t       cmd    = { 0 };
+        std::vector<std::string> groups;
+        std::string              last;
+        int                      n_batch = 0;
+        int                      ret     = 0;
+
+        ASSERT_NE(nullptr, reader);
+        while ((ret = neu_cid_reader_next(reader, "driver", max_tags, &cmd)) >
+               0) {
+            int batch_tags = 0;
+
+            EXPECT_STREQ("driver", cmd.driver);
+            EXPECT_EQ(ret, cmd.n_group);
+            for (int i = 0; i < cmd.n_group; i++) {
+                batch_tags += cmd.groups[i].n_tag;
+                // each part carries the group settings for the adapter
+                EXPECT_NE(nullptr, cmd.groups[i].context);
+            }
+            EXPECT_LE(batch_tags, max_tags);
+            append_groups(&cmd, groups, last);
+            neu_req_add_gtag_fini(&cmd);
+            n_batch += 1;
+        }
+        EXPECT_EQ(0, ret);
+        EXPECT_EQ(expect, groups);
+        EXPECT_EQ((n_tag + max_tags - 1) / max_tags, n_batch);
+        neu_cid_reader_close(reader);
+    }
+
+    remove(path);
+}
+
+TEST(cid_reader, truncated_file_should_fail)
+{
+    const char *path = "./cid_stream_test.cid";
+    write_file(path, stream_cid, strlen(stream_cid) / 2);
+
+    cid_t cid = { 0 };
+    EXPECT_EQ(-1, neu_cid_parse(path, &cid));
+    EXPECT_EQ(nullptr, neu_cid_reader_open(path));
+    EXPECT_EQ(nullptr, neu_cid_reader_open("./no_such_file.cid"));
+
+    remove(path);
+}
+
 int main(int argc, char **argv)
 {
     zlog_init("./config/dev.conf");
@@ -0,0 +1,180 @@
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <gtest/gtest.h>
+
+extern "C" {
+// neu_connection.h expects zlog to be declared
+#include "utils/log.h"
+
+#include "connection/neu_connection.h"
+}
+
+zlog_category_t *neuron = NULL;
+
+// loopback listener, a port with no listener refuses connects
+static int listener(uint16_t *port, bool listening, int backlog)
+{
+    struct sockaddr_in addr = {};
+    socklen_t          len  = sizeof(addr);
+    int                fd   = socket(AF_INET, SOCK_STREAM, 0);
+
+    addr.sin_family      = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    EXPECT_EQ(0, bind(fd, (struct sockaddr *) &addr, sizeof(addr)));
+    EXPECT_EQ(0, getsockname(fd, (struct sockaddr *) &addr, &len));
+    if (listening) {
+        EXPECT_EQ(0, listen(fd, backlog));
+    }
+
+    *port = ntohs(addr.sin_port);
+    return fd;
+}
+
+static void on_link(void *ctx, int fd)
+{
+    (void) ctx;
+    (void) fd;
+}
+
+static neu_conn_t *tcp_client(uint16_t port, uint16_t timeout)
+{
+    neu_conn_param_t param = {};
+
+    param.type                      = NEU_CONN_TCP_CLIENT;
+    param.params.tcp_client.ip      = (char *) "127.0.0.1";
+    param.params.tcp_client.port    = port;
+    param.params.tcp_client.timeout = timeout;
+    return neu_conn_new(&param, NULL, on_link, on_link);
+}
+
+static void sleep_ms(int ms)
+{
+    usleep(ms * 1000);
+}
+
+TEST(test_conn_link, refused_connect_should_back_off_and_double)
+{
+    uint16_t    port = 0;
+    int         fd   = listener(&port, false, 0);
+    neu_conn_t *conn = tcp_client(port, 1000);
+
+    neu_conn_connect(conn);
+    EXPECT_EQ(NEU_CONN_LINK_BACKOFF, neu_conn_link(conn));
+    EXPECT_EQ(1u, neu_conn_state(conn).connect_failures);
+
+    // nothing is tried again within the backoff
+    neu_conn_connect(conn);
+    EXPECT_EQ(1u, neu_conn_state(conn).connect_failures);
+
+    // first delay is at most NEU_CONN_BACKOFF_MIN
+    sleep_ms(NEU_CONN_BACKOFF_MIN + 20);
+    neu_conn_connect(conn);
+    EXPECT_EQ(NEU_CONN_LINK_BACKOFF, neu_conn_link(conn));
+    EXPECT_EQ(2u, neu_conn_state(conn).connect_failures);
+
+    // second delay is at least NEU_CONN_BACKOFF_MIN
+    sleep_ms(NEU_CONN_BACKOFF_MIN - 50);
+    neu_conn_connect(conn);
+    EXPECT_EQ(2u, neu_conn_state(conn).connect_failures);
+
+    neu_conn_destory(conn);
+    close(fd);
+}
+
+TEST(test_conn_link, dropped_link_should_keep_backing_off)
+{
+    uint16_t    port = 0;
+    int         fd   = listener(&port, true, 4);
+    neu_conn_t *conn = tcp_client(port, 1000);
+    uint8_t     buf[4];
+
+    neu_conn_connect(conn);
+    ASSERT_EQ(NEU_CONN_LINK_CONNECTED, neu_conn_link(conn));
+
+    // accept then close
+    close(accept(fd, NULL, NULL));
+    EXPECT_EQ(0, neu_conn_recv(conn, buf, sizeof(buf)));
+    EXPECT_EQ(NEU_CONN_LINK_BACKOFF, neu_conn_link(conn));
+    EXPECT_EQ(1u, neu_conn_state(conn).connect_failures);
+
+    // the drop is not retried right away
+    neu_conn_connect(conn);
+    EXPECT_EQ(NEU_CONN_LINK_BACKOFF, neu_conn_link(conn));
+
+    sleep_ms(NEU_CONN_BACKOFF_MIN + 20);
+    neu_conn_connect(conn);
+    ASSERT_EQ(NEU_CONN_LINK_CONNECTED, neu_conn_link(conn));
+
+    // a short lived link does not clear the backoff, so the delay doubles
+    close(accept(fd, NULL, NULL));
+    EXPECT_EQ(0, neu_conn_recv(conn, buf, sizeof(buf)));
+    EXPECT_EQ(NEU_CONN_LINK_BACKOFF, neu_conn_link(conn));
+    EXPECT_EQ(2u, neu_conn_state(conn).connect_failures);
+
+    sleep_ms(NEU_CONN_BACKOFF_MIN - 50);
+    neu_conn_connect(conn);
+    EXPECT_EQ(NEU_CONN_LINK_BACKOFF, neu_conn_link(conn));
+
+    neu_conn_destory(conn);
+    close(fd);
+}
+
+TEST(test_conn_link, disconnect_should_back_off)
+{
+    uint16_t    port = 0;
+    int         fd   = listener(&port, true, 4);
+    neu_conn_t *conn = tcp_client(port, 1000);
+
+    neu_conn_connect(conn);
+    ASSERT_EQ(NEU_CONN_LINK_CONNECTED, neu_conn_link(conn));
+
+    neu_conn_disconnect(conn);
+    EXPECT_EQ(NEU_CONN_LINK_BACKOFF, neu_conn_link(conn));
+    EXPECT_FALSE(neu_conn_is_connected(conn));
+
+    // stop and start clears the backoff
+    neu_conn_stop(conn);
+    neu_conn_start(conn);
+    EXPECT_EQ(NEU_CONN_LINK_DISCONNECTED, neu_conn_link(conn));
+    neu_conn_connect(conn);
+    EXPECT_EQ(NEU_CONN_LINK_CONNECTED, neu_conn_link(conn));
+
+    neu_conn_destory(conn);
+    close(fd);
+}
+
+TEST(test_conn_link, unanswered_connect_should_time_out)
+{
+    uint16_t port = 0;
+    int      fd   = listener(&port, true, 0);
+    int      fill = socket(AF_INET, SOCK_STREAM, 0);
+
+    // fill the accept queue, further handshakes are left unanswered
+    struct sockaddr_in addr = {};
+    addr.sin_family         = AF_INET;
+    addr.sin_port           = htons(port);
+    addr.sin_addr.s_addr    = htonl(INADDR_LOOPBACK);
+    ASSERT_EQ(0, connect(fill, (struct sockaddr *) &addr, sizeof(addr)));
+
+    neu_conn_t *conn = tcp_client(port, 100);
+
+    neu_conn_connect(conn);
+    EXPECT_EQ(NEU_CONN_LINK_CONNECTING, neu_conn_link(conn));
+    EXPECT_EQ(0u, neu_conn_state(conn).connect_failures);
+
+    sleep_ms(50);
+    neu_conn_connect(conn);
+    EXPECT_EQ(NEU_CONN_LINK_CONNECTING, neu_conn_link(conn));
+
+    sleep_ms(100);
+    neu_conn_connect(conn);
+    EXPECT_EQ(NEU_CONN_LINK_BACKOFF, neu_conn_link(conn));
+    EXPECT_EQ(1u, neu_conn_state(conn).connect_failures);
+
+    neu_conn_destory(conn);
+    close(fill);
+    close(fd);
+}
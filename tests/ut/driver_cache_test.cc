@@ -0,0 +1,341 @@
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <string>
+
+#include <gtest/gtest.h>
+
+extern "C" {
+#include "adapter/driver/cache.h"
+#include "utils/log.h"
+}
+
+zlog_category_t *neuron         = NULL;
+bool             sub_filter_err = false;
+
+TEST(driver_cache, batch_should_keep_device_timestamps)
+{
+    neu_driver_cache_t *     cache      = neu_driver_cache_new();
+    neu_driver_cache_value_t value      = {};
+    neu_tag_meta_t           metas[1]   = {};
+    neu_tag_update_t         updates[2] = {};
+    neu_dvalue_t             init       = {};
+
+    init.type = NEU_TYPE_INT32;
+    neu_driver_cache_add(cache, "grp", "tag-1", init);
+    neu_driver_cache_add(cache, "grp", "tag-2", init);
+
+    updates[0].tag             = "tag-1";
+    updates[0].value.type      = NEU_TYPE_INT32;
+    updates[0].value.value.i32 = 1;
+    updates[1].tag             = "tag-2";
+    updates[1].value.type      = NEU_TYPE_INT32;
+    updates[1].value.value.i32 = 2;
+    updates[1].timestamp       = 1700000000123;
+    neu_driver_cache_update_batch(cache, "grp", 1700000001000, updates, 2);
+
+    ASSERT_EQ(0, neu_driver_cache_meta_get(cache, "grp", "tag-1", &value,
+                                           metas, 1));
+    EXPECT_EQ(1700000001000, value.timestamp);
+    EXPECT_EQ(1700000001000, value.cached);
+    EXPECT_EQ(1, value.value.value.i32);
+
+    ASSERT_EQ(0, neu_driver_cache_meta_get(cache, "grp", "tag-2", &value,
+                                           metas, 1));
+    EXPECT_EQ(1700000000123, value.timestamp);
+    // expiry goes by the time the value was cached, not the device time
+    EXPECT_EQ(1700000001000, value.cached);
+    EXPECT_EQ(2, value.value.value.i32);
+
+    neu_driver_cache_destroy(cache);
+}
+
+#define SNAPSHOT_PATH "driver_cache_test.snapshot"
+
+// every type with a payload the snapshot keeps, near its limits
+static neu_dvalue_t sample(neu_type_e type)
+{
+    neu_dvalue_t v = {};
+
+    v.type = type;
+    switch (type) {
+    case NEU_TYPE_INT8:
+        v.value.i8 = INT8_MIN;
+        break;
+    case NEU_TYPE_UINT8:
+        v.value.u8 = UINT8_MAX;
+        break;
+    case NEU_TYPE_INT16:
+        v.value.i16 = INT16_MIN;
+        break;
+    case NEU_TYPE_UINT16:
+    case NEU_TYPE_WORD:
+        v.value.u16 = UINT16_MAX;
+        break;
+    case NEU_TYPE_INT32:
+        v.value.i32 = INT32_MIN;
+        break;
+    case NEU_TYPE_UINT32:
+    case NEU_TYPE_DWORD:
+        v.value.u32 = UINT32_MAX;
+        break;
+    case NEU_TYPE_INT64:
+        v.value.i64 = INT64_MIN;
+        break;
+    case NEU_TYPE_UINT64:
+    case NEU_TYPE_LWORD:
+        v.value.u64 = UINT64_MAX;
+        break;
+    case NEU_TYPE_FLOAT:
+        v.value.f32 = -1.5e-30f;
+        break;
+    case NEU_TYPE_DOUBLE:
+        v.value.d64 = 2.5e300;
+        break;
+    case NEU_TYPE_BIT:
+        v.value.u8 = 1;
+        break;
+    case NEU_TYPE_BOOL:
+        v.value.boolean = true;
+        break;
+    case NEU_TYPE_STRING:
+    case NEU_TYPE_TIME:
+    case NEU_TYPE_DATA_AND_TIME:
+    case NEU_TYPE_ARRAY_CHAR:
+        strcpy(v.value.str, neu_type_string(type));
+        break;
+    case NEU_TYPE_BYTES:
+        for (int i = 0; i < NEU_VALUE_SIZE; i++) {
+            v.value.bytes.bytes[i] = 0xff - i;
+        }
+        v.value.bytes.length = NEU_VALUE_SIZE;
+        break;
+    case NEU_TYPE_ARRAY_BOOL:
+        v.value.bools.bools[0] = true;
+        v.value.bools.bools[2] = true;
+        v.value.bools.length   = 3;
+        break;
+    case NEU_TYPE_ARRAY_INT8:
+        v.value.i8s.i8s[0] = INT8_MIN;
+        v.value.i8s.i8s[1] = INT8_MAX;
+        v.value.i8s.length = 2;
+        break;
+    case NEU_TYPE_ARRAY_UINT8:
+        v.value.u8s.u8s[0] = UINT8_MAX;
+        v.value.u8s.length = 1;
+        break;
+    case NEU_TYPE_ARRAY_INT16:
+        v.value.i16s.i16s[0] = INT16_MIN;
+        v.value.i16s.i16s[1] = INT16_MAX;
+        v.value.i16s.length  = 2;
+        break;
+    case NEU_TYPE_ARRAY_UINT16:
+        v.value.u16s.u16s[0] = UINT16_MAX;
+        v.value.u16s.length  = 1;
+        break;
+    case NEU_TYPE_ARRAY_INT32:
+        v.value.i32s.i32s[0] = INT32_MIN;
+        v.value.i32s.i32s[1] = INT32_MAX;
+        v.value.i32s.length  = 2;
+        break;
+    case NEU_TYPE_ARRAY_UINT32:
+        v.value.u32s.u32s[0] = UINT32_MAX;
+        v.value.u32s.length  = 1;
+        break;
+    case NEU_TYPE_ARRAY_INT64:
+        v.value.i64s.i64s[0] = INT64_MIN;
+        v.value.i64s.i64s[1] = INT64_MAX;
+        v.value.i64s.length  = 2;
+        break;
+    case NEU_TYPE_ARRAY_UINT64:
+        for (int i = 0; i < NEU_VALUE_SIZE; i++) {
+            v.value.u64s.u64s[i] = UINT64_MAX - i;
+        }
+        v.value.u64s.length = NEU_VALUE_SIZE;
+        break;
+    case NEU_TYPE_ARRAY_FLOAT:
+        v.value.f32s.f32s[0] = -0.25f;
+        v.value.f32s.length  = 1;
+        break;
+    case NEU_TYPE_ARRAY_DOUBLE:
+        v.value.f64s.f64s[0] = 1e-300;
+        v.value.f64s.f64s[1] = -1e300;
+        v.value.f64s.length  = 2;
+        break;
+    default:
+        break;
+    }
+    return v;
+}
+
+static const neu_type_e snapshot_types[] = {
+    NEU_TYPE_INT8,          NEU_TYPE_UINT8,         NEU_TYPE_INT16,
+    NEU_TYPE_UINT16,        NEU_TYPE_INT32,         NEU_TYPE_UINT32,
+    NEU_TYPE_INT64,         NEU_TYPE_UINT64,        NEU_TYPE_FLOAT,
+    NEU_TYPE_DOUBLE,        NEU_TYPE_BIT,           NEU_TYPE_BOOL,
+    NEU_TYPE_STRING,        NEU_TYPE_BYTES,         NEU_TYPE_WORD,
+    NEU_TYPE_DWORD,         NEU_TYPE_LWORD,         NEU_TYPE_TIME,
+    NEU_TYPE_DATA_AND_TIME, NEU_TYPE_ARRAY_CHAR,    NEU_TYPE_ARRAY_INT8,
+    NEU_TYPE_ARRAY_UINT8,   NEU_TYPE_ARRAY_INT16,   NEU_TYPE_ARRAY_UINT16,
+    NEU_TYPE_ARRAY_INT32,   NEU_TYPE_ARRAY_UINT32,  NEU_TYPE_ARRAY_INT64,
+    NEU_TYPE_ARRAY_UINT64,  NEU_TYPE_ARRAY_FLOAT,   NEU_TYPE_ARRAY_DOUBLE,
+    NEU_TYPE_ARRAY_BOOL,
+};
+
+// tags are added not ready, as the adapter does before restoring them
+static void add_tag(neu_driver_cache_t *cache, const char *tag)
+{
+    neu_dvalue_t init = {};
+
+    init.type      = NEU_TYPE_ERROR;
+    init.value.i32 = 1;
+    neu_driver_cache_add(cache, "grp", tag, init);
+}
+
+static void save_tags(const char *tags[], const neu_dvalue_t values[],
+                      size_t n)
+{
+    neu_driver_cache_t *cache = neu_driver_cache_new();
+
+    remove(SNAPSHOT_PATH);
+    for (size_t i = 0; i < n; i++) {
+        add_tag(cache, tags[i]);
+        neu_driver_cache_update(cache, "grp", tags[i], 1700000000000 + i,
+                                values[i], NULL, 0);
+    }
+    ASSERT_EQ(0, neu_driver_cache_snapshot_save(cache, SNAPSHOT_PATH));
+    neu_driver_cache_destroy(cache);
+}
+
+static std::string read_file(const char *path)
+{
+    std::ifstream in(path, std::ios::binary);
+    return std::string(std::istreambuf_iterator<char>(in),
+                       std::istreambuf_iterator<char>());
+}
+
+static void write_file(const char *path, const std::string &data)
+{
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out.write(data.data(), data.size());
+}
+
+TEST(driver_cache, snapshot_should_restore_every_type)
+{
+    const size_t n = sizeof(snapshot_types) / sizeof(snapshot_types[0]);
+    std::string  names[n];
+    const char * tags[n];
+    neu_dvalue_t values[n];
+
+    for (size_t i = 0; i < n; i++) {
+        names[i]  = "tag-" + std::to_string(snapshot_types[i]);
+        tags[i]   = names[i].c_str();
+        values[i] = sample(snapshot_types[i]);
+    }
+    save_tags(tags, values, n);
+
+    neu_driver_cache_t *cache = neu_driver_cache_new();
+    ASSERT_EQ(0, neu_driver_cache_snapshot_load(cache, SNAPSHOT_PATH));
+    for (size_t i = 0; i < n; i++) {
+        neu_driver_cache_value_t value                    = {};
+        neu_tag_meta_t           metas[NEU_TAG_META_SIZE] = {};
+
+        SCOPED_TRACE(tags[i]);
+        add_tag(cache, tags[i]);
+        ASSERT_EQ(0,
+                  neu_driver_cache_restore(cache, "grp", tags[i],
+                                           snapshot_types[i]));
+        ASSERT_EQ(0,
+                  neu_driver_cache_meta_get(cache, "grp", tags[i], &value,
+                                            metas, NEU_TAG_META_SIZE));
+        EXPECT_EQ(snapshot_types[i], value.value.type);
+        EXPECT_EQ(0,
+                  memcmp(&values[i].value, &value.value.value,
+                         sizeof(neu_value_u)));
+        EXPECT_EQ(1700000000000 + (int64_t) i, value.timestamp);
+        EXPECT_STREQ(NEU_DRIVER_CACHE_META_RESTORED, metas[0].name);
+    }
+
+    neu_driver_cache_destroy(cache);
+    remove(SNAPSHOT_PATH);
+}
+
+TEST(driver_cache, snapshot_should_skip_changed_type)
+{
+    const char * tags[1]   = { "tag" };
+    neu_dvalue_t values[1] = { sample(NEU_TYPE_INT32) };
+
+    save_tags(tags, values, 1);
+
+    neu_driver_cache_t *     cache                    = neu_driver_cache_new();
+    neu_driver_cache_value_t value                    = {};
+    neu_tag_meta_t           metas[NEU_TAG_META_SIZE] = {};
+
+    ASSERT_EQ(0, neu_driver_cache_snapshot_load(cache, SNAPSHOT_PATH));
+    add_tag(cache, "tag");
+    EXPECT_EQ(-1, neu_driver_cache_restore(cache, "grp", "tag",
+                                           NEU_TYPE_INT64));
+    ASSERT_EQ(0, neu_driver_cache_meta_get(cache, "grp", "tag", &value,
+                                           metas, NEU_TAG_META_SIZE));
+    EXPECT_EQ(NEU_TYPE_ERROR, value.value.type);
+
+    neu_driver_cache_destroy(cache);
+    remove(SNAPSHOT_PATH);
+}
+
+TEST(driver_cache, snapshot_should_reject_bad_header)
+{
+    const char * tags[1]   = { "tag" };
+    neu_dvalue_t values[1] = { sample(NEU_TYPE_INT32) };
+
+    save_tags(tags, values, 1);
+    const std::string good = read_file(SNAPSHOT_PATH);
+
+    // magic at 0, format version at 8
+    std::string bad_magic   = good;
+    std::string bad_version = good;
+    bad_magic[0] ^= 0xff;
+    bad_version[8] += 1;
+
+    const std::string files[] = { bad_magic, bad_version,
+                                  good.substr(0, 15), "" };
+    for (const std::string &data : files) {
+        neu_driver_cache_t *cache = neu_driver_cache_new();
+
+        write_file(SNAPSHOT_PATH, data);
+        EXPECT_EQ(-1, neu_driver_cache_snapshot_load(cache, SNAPSHOT_PATH));
+        add_tag(cache, "tag");
+        EXPECT_EQ(-1, neu_driver_cache_restore(cache, "grp", "tag",
+                                               NEU_TYPE_INT32));
+        neu_driver_cache_destroy(cache);
+    }
+
+    remove(SNAPSHOT_PATH);
+}
+
+TEST(driver_cache, truncated_snapshot_should_keep_whole_records)
+{
+    const char * tags[2]   = { "tag-1", "tag-2" };
+    neu_dvalue_t values[2] = { sample(NEU_TYPE_INT32),
+                               sample(NEU_TYPE_STRING) };
+
+    save_tags(tags, values, 2);
+    std::string data = read_file(SNAPSHOT_PATH);
+
+    // records are written in insertion order, cut into the last one
+    data.resize(data.size() - 1);
+    write_file(SNAPSHOT_PATH, data);
+
+    neu_driver_cache_t *cache = neu_driver_cache_new();
+    ASSERT_EQ(0, neu_driver_cache_snapshot_load(cache, SNAPSHOT_PATH));
+    add_tag(cache, "tag-1");
+    add_tag(cache, "tag-2");
+    EXPECT_EQ(0, neu_driver_cache_restore(cache, "grp", "tag-1",
+                                          NEU_TYPE_INT32));
+    EXPECT_EQ(-1, neu_driver_cache_restore(cache, "grp", "tag-2",
+                                           NEU_TYPE_STRING));
+
+    neu_driver_cache_destroy(cache);
+    remove(SNAPSHOT_PATH);
+}
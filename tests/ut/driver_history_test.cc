@@ -0,0 +1,256 @@
+#include <cfloat>
+#include <cstring>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+extern "C" {
+#include "adapter/driver/history.h"
+#include "utils/log.h"
+}
+
+zlog_category_t *neuron = NULL;
+
+static std::vector<neu_history_point_t>
+query(neu_driver_history_t *history, int64_t start, int64_t end,
+      uint32_t buckets)
+{
+    std::vector<neu_history_point_t> result;
+    UT_array *                       points = NULL;
+
+    utarray_new(points, neu_history_point_icd());
+    EXPECT_EQ(0,
+              neu_driver_history_query(history, "grp", "tag", start, end,
+                                       buckets, points));
+    utarray_foreach(points, neu_history_point_t *, p)
+    {
+        result.push_back(*p);
+    }
+    utarray_free(points);
+    return result;
+}
+
+static void add_i64(neu_driver_history_t *history, int64_t ts, int64_t v)
+{
+    neu_dvalue_t value = {};
+
+    value.type      = NEU_TYPE_INT64;
+    value.value.i64 = v;
+    neu_driver_history_add(history, "grp", "tag", ts, &value);
+}
+
+TEST(driver_history, int_deltas_should_round_trip_at_varint_limits)
+{
+    neu_driver_history_t *history = neu_driver_history_new(1 << 16);
+    // one and two byte varint edges, then deltas that overflow int64, each
+    // extreme is followed by small values that only decode if it did
+    const int64_t values[] = {
+        0,         63,        64,        -64,       -65,       8191,
+        8192,      -1,        INT64_MAX, INT64_MIN, 1,         INT64_MIN,
+        INT64_MAX, -2,        0,
+    };
+    const size_t n = sizeof(values) / sizeof(values[0]);
+
+    for (size_t i = 0; i < n; i++) {
+        add_i64(history, 1000 + i, values[i]);
+    }
+
+    std::vector<neu_history_point_t> points = query(history, 0, 10000, 0);
+    ASSERT_EQ(n, points.size());
+    for (size_t i = 0; i < n; i++) {
+        EXPECT_EQ(1000 + (int64_t) i, points[i].timestamp);
+        EXPECT_EQ((double) values[i], points[i].value);
+    }
+
+    neu_driver_history_destroy(history);
+}
+
+TEST(driver_history, uint64_extremes_should_round_trip)
+{
+    neu_driver_history_t *history  = neu_driver_history_new(1 << 16);
+    const uint64_t        values[] = { UINT64_MAX, 0, 1, UINT64_MAX, 3 };
+    neu_dvalue_t          value    = {};
+
+    value.type = NEU_TYPE_UINT64;
+    for (size_t i = 0; i < 5; i++) {
+        value.value.u64 = values[i];
+        neu_driver_history_add(history, "grp", "tag", 1000 + i, &value);
+    }
+
+    std::vector<neu_history_point_t> points = query(history, 0, 10000, 0);
+    ASSERT_EQ(5u, points.size());
+    for (size_t i = 0; i < 5; i++) {
+        EXPECT_EQ((double) values[i], points[i].value);
+    }
+
+    neu_driver_history_destroy(history);
+}
+
+TEST(driver_history, timestamp_deltas_should_round_trip_both_ways)
+{
+    neu_driver_history_t *history = neu_driver_history_new(1 << 16);
+    // out of order points give negative deltas, the jumps need the full
+    // 64 bits once zigzag encoded
+    const int64_t ts[] = { 5000, 4999, 5063, 4935, INT64_MAX / 2, 1,
+                           INT64_MAX / 2 - 1 };
+    const size_t  n    = sizeof(ts) / sizeof(ts[0]);
+
+    for (size_t i = 0; i < n; i++) {
+        add_i64(history, ts[i], i);
+    }
+
+    std::vector<neu_history_point_t> points =
+        query(history, 0, INT64_MAX / 2, 0);
+    ASSERT_EQ(n, points.size());
+    for (size_t i = 0; i < n; i++) {
+        EXPECT_EQ(ts[i], points[i].timestamp);
+        EXPECT_EQ((double) i, points[i].value);
+    }
+
+    neu_driver_history_destroy(history);
+}
+
+TEST(driver_history, float_bits_should_round_trip)
+{
+    neu_driver_history_t *history  = neu_driver_history_new(1 << 16);
+    const double          values[] = {
+        0.0, -0.0, DBL_MAX, -DBL_MAX, DBL_MIN, 1.5, -1.5, DBL_TRUE_MIN,
+    };
+    const size_t          n        = sizeof(values) / sizeof(values[0]);
+    neu_dvalue_t          value    = {};
+
+    value.type = NEU_TYPE_DOUBLE;
+    for (size_t i = 0; i < n; i++) {
+        value.value.d64 = values[i];
+        neu_driver_history_add(history, "grp", "tag", 1000 + i, &value);
+    }
+
+    std::vector<neu_history_point_t> points = query(history, 0, 10000, 0);
+    ASSERT_EQ(n, points.size());
+    for (size_t i = 0; i < n; i++) {
+        // compare the bits, -0.0 == 0.0
+        EXPECT_EQ(0, memcmp(&values[i], &points[i].value, sizeof(double)));
+    }
+
+    neu_driver_history_destroy(history);
+}
+
+TEST(driver_history, full_ring_should_drop_oldest_block)
+{
+    // the smallest budget still keeps two blocks of 64 points
+    neu_driver_history_t *history = neu_driver_history_new(0);
+
+    // wrap the ring a few times
+    for (int64_t i = 0; i < 64 * 5; i++) {
+        add_i64(history, i, i * 3);
+    }
+
+    std::vector<neu_history_point_t> points = query(history, 0, 10000, 0);
+    ASSERT_EQ(128u, points.size());
+    for (size_t i = 0; i < points.size(); i++) {
+        EXPECT_EQ(64 * 3 + (int64_t) i, points[i].timestamp);
+        EXPECT_EQ((double) (64 * 3 + i) * 3, points[i].value);
+    }
+
+    // a new kind starts a new block, which drops another one
+    neu_dvalue_t value = {};
+    value.type         = NEU_TYPE_FLOAT;
+    value.value.f32    = 0.5;
+    neu_driver_history_add(history, "grp", "tag", 1000, &value);
+
+    points = query(history, 0, 10000, 0);
+    ASSERT_EQ(65u, points.size());
+    EXPECT_EQ(64 * 4, points[0].timestamp);
+    EXPECT_EQ(1000, points[64].timestamp);
+    EXPECT_EQ(0.5, points[64].value);
+
+    neu_driver_history_destroy(history);
+}
+
+TEST(driver_history, buckets_should_aggregate_min_max_avg)
+{
+    neu_driver_history_t *history = neu_driver_history_new(1 << 16);
+
+    // blocks of 64 points, some buckets split them and some hold them whole
+    for (int64_t i = 0; i < 256; i++) {
+        add_i64(history, i, i % 2 == 0 ? i : -i);
+    }
+
+    // 10 buckets over 256 ms, point k falls in bucket k * 10 / 256
+    std::vector<neu_history_point_t> want(10);
+    for (int64_t k = 0; k < 256; k++) {
+        neu_history_point_t *b = &want[k * 10 / 256];
+        double               v = k % 2 == 0 ? k : -k;
+
+        if (b->count == 0) {
+            b->min = v;
+            b->max = v;
+        }
+        b->min = v < b->min ? v : b->min;
+        b->max = v > b->max ? v : b->max;
+        b->value += v;
+        b->count += 1;
+    }
+
+    std::vector<neu_history_point_t> points = query(history, 0, 255, 10);
+    ASSERT_EQ(10u, points.size());
+    for (size_t i = 0; i < points.size(); i++) {
+        SCOPED_TRACE(i);
+        // a bucket is stamped with its start, not its first point
+        EXPECT_EQ((int64_t)(25.6 * i), points[i].timestamp);
+        EXPECT_EQ(want[i].count, points[i].count);
+        EXPECT_EQ(want[i].min, points[i].min);
+        EXPECT_EQ(want[i].max, points[i].max);
+        EXPECT_DOUBLE_EQ(want[i].value / want[i].count, points[i].value);
+    }
+
+    // one bucket per block, taken from the block summaries
+    points = query(history, 0, 255, 4);
+    ASSERT_EQ(4u, points.size());
+    for (size_t i = 0; i < 4; i++) {
+        EXPECT_EQ(64 * (int64_t) i, points[i].timestamp);
+        EXPECT_EQ(64u, points[i].count);
+        EXPECT_EQ(-(64.0 * i + 63), points[i].min);
+        EXPECT_EQ(64.0 * i + 62, points[i].max);
+        EXPECT_DOUBLE_EQ(-0.5, points[i].value);
+    }
+
+    // empty buckets are left out
+    points = query(history, 128, 1127, 10);
+    ASSERT_EQ(2u, points.size());
+    EXPECT_EQ(128, points[0].timestamp);
+    EXPECT_EQ(100u, points[0].count);
+    EXPECT_EQ(228, points[1].timestamp);
+    EXPECT_EQ(28u, points[1].count);
+
+    // min and max of a bucket start from its first point, not from zero
+    neu_driver_history_del(history, "grp", "tag");
+    add_i64(history, 0, 5);
+    add_i64(history, 1, 7);
+    points = query(history, 0, 1, 1);
+    ASSERT_EQ(1u, points.size());
+    EXPECT_EQ(5, points[0].min);
+    EXPECT_EQ(7, points[0].max);
+    EXPECT_EQ(6, points[0].value);
+
+    neu_driver_history_destroy(history);
+}
+
+TEST(driver_history, bad_range_should_fail)
+{
+    neu_driver_history_t *history = neu_driver_history_new(1 << 16);
+    UT_array *            points  = NULL;
+
+    utarray_new(points, neu_history_point_icd());
+    add_i64(history, 10, 1);
+    EXPECT_NE(0,
+              neu_driver_history_query(history, "grp", "tag", 10, 9, 0,
+                                       points));
+    EXPECT_NE(0,
+              neu_driver_history_query(history, "grp", "tag", 0, 10, 100000,
+                                       points));
+    EXPECT_EQ(0u, utarray_len(points));
+
+    utarray_free(points);
+    neu_driver_history_destroy(history);
+}
@@ -0,0 +1,104 @@
+#include <atomic>
+#include <thread>
+
+#include <gtest/gtest.h>
+
+extern "C" {
+#include "driver_registry.h"
+#include "utils/log.h"
+#include "utils/time.h"
+}
+
+zlog_category_t *neuron = NULL;
+
+struct fake_driver {
+    const char *     group;
+    int              delay_ms;
+    std::atomic<int> reading;
+};
+
+static int fake_read(void *ctx, const neu_req_read_group_t *cmd, UT_array *tags)
+{
+    fake_driver *             driver = (fake_driver *) ctx;
+    neu_resp_tag_value_meta_t value  = {};
+
+    if (strcmp(cmd->group, driver->group) != 0) {
+        return NEU_ERR_GROUP_NOT_EXIST;
+    }
+
+    driver->reading++;
+    neu_msleep(driver->delay_ms);
+    strcpy(value.tag, "tag1");
+    value.value.type      = NEU_TYPE_INT32;
+    value.value.value.i32 = 42;
+    utarray_push_back(tags, &value);
+    driver->reading--;
+
+    return NEU_ERR_SUCCESS;
+}
+
+static int read_group(const char *node, const char *group, bool sync,
+                      neu_resp_read_group_t *resp)
+{
+    neu_req_read_group_t cmd = {};
+
+    cmd.driver = (char *) node;
+    cmd.group  = (char *) group;
+    cmd.sync   = sync;
+    return neu_driver_registry_read(&cmd, resp);
+}
+
+TEST(test_driver_registry, read_should_be_served_by_the_node)
+{
+    fake_driver           driver = { "grp", 0, { 0 } };
+    neu_resp_read_group_t resp   = {};
+
+    ASSERT_EQ(0, neu_driver_registry_add("node1", &driver, fake_read));
+    EXPECT_EQ(NEU_ERR_NODE_EXIST,
+              neu_driver_registry_add("node1", &driver, fake_read));
+
+    ASSERT_EQ(0, read_group("node1", "grp", false, &resp));
+    ASSERT_EQ(1u, utarray_len(resp.tags));
+    EXPECT_STREQ("node1", resp.driver);
+    EXPECT_STREQ("grp", resp.group);
+    EXPECT_EQ(42,
+              ((neu_resp_tag_value_meta_t *) utarray_front(resp.tags))
+                  ->value.value.i32);
+    neu_resp_read_free(&resp);
+
+    EXPECT_EQ(NEU_ERR_GROUP_NOT_EXIST,
+              read_group("node1", "other", false, &resp));
+    EXPECT_EQ(NEU_ERR_NODE_NOT_EXIST, read_group("node2", "grp", false, &resp));
+    EXPECT_EQ(NEU_ERR_PLUGIN_NOT_SUPPORT_READ_SYNC,
+              read_group("node1", "grp", true, &resp));
+
+    ASSERT_EQ(0, neu_driver_registry_rename("node1", "node2"));
+    EXPECT_EQ(NEU_ERR_NODE_NOT_EXIST, read_group("node1", "grp", false, &resp));
+    ASSERT_EQ(0, read_group("node2", "grp", false, &resp));
+    neu_resp_read_free(&resp);
+
+    neu_driver_registry_del("node2");
+    EXPECT_EQ(NEU_ERR_NODE_NOT_EXIST, read_group("node2", "grp", false, &resp));
+}
+
+TEST(test_driver_registry, del_should_wait_for_reads_in_progress)
+{
+    fake_driver driver = { "grp", 100, { 0 } };
+
+    ASSERT_EQ(0, neu_driver_registry_add("node1", &driver, fake_read));
+
+    std::thread reader([]() {
+        neu_resp_read_group_t resp = {};
+
+        EXPECT_EQ(0, read_group("node1", "grp", false, &resp));
+        neu_resp_read_free(&resp);
+    });
+    while (driver.reading.load() == 0) {
+        std::this_thread::yield();
+    }
+
+    neu_driver_registry_del("node1");
+    // the driver may be freed now
+    EXPECT_EQ(0, driver.reading.load());
+    reader.join();
+}
@@ -0,0 +1,161 @@
+#include <cstring>
+
+#include <gtest/gtest.h>
+
+extern "C" {
+#include "adapter/driver/value.h"
+}
+
+TEST(driver_value, scalar_should_round_trip)
+{
+    neu_value_slab_t *slab = neu_value_slab_new();
+    neu_cvalue_t      cv   = { 0 };
+    neu_dvalue_t      in   = {};
+    neu_dvalue_t      out  = {};
+
+    EXPECT_EQ(16u, sizeof(neu_cvalue_t));
+
+    in.type      = NEU_TYPE_INT16;
+    in.value.i16 = -1234;
+    neu_cvalue_set(slab, &cv, &in);
+    neu_cvalue_get(&cv, &out);
+    EXPECT_EQ(NEU_TYPE_INT16, out.type);
+    EXPECT_EQ(-1234, out.value.i16);
+    EXPECT_TRUE(neu_cvalue_equal(&cv, &in, 0));
+
+    in.value.i16 = 1234;
+    EXPECT_FALSE(neu_cvalue_equal(&cv, &in, 0));
+
+    // no payload for scalars
+    EXPECT_EQ(0u, neu_value_slab_size(slab));
+
+    neu_cvalue_release(slab, &cv);
+    neu_value_slab_free(slab);
+}
+
+TEST(driver_value, float_should_compare_with_precision)
+{
+    neu_value_slab_t *slab = neu_value_slab_new();
+    neu_cvalue_t      cv   = { 0 };
+    neu_dvalue_t      in   = {};
+
+    in.type      = NEU_TYPE_DOUBLE;
+    in.value.d64 = 1.2345;
+    neu_cvalue_set(slab, &cv, &in);
+
+    in.value.d64 = 1.2346;
+    EXPECT_FALSE(neu_cvalue_equal(&cv, &in, 0));
+    EXPECT_TRUE(neu_cvalue_equal(&cv, &in, 2));
+
+    in.type = NEU_TYPE_ERROR;
+    EXPECT_FALSE(neu_cvalue_equal(&cv, &in, 2));
+
+    neu_cvalue_release(slab, &cv);
+    neu_value_slab_free(slab);
+}
+
+TEST(driver_value, string_and_array_should_live_in_slab)
+{
+    neu_value_slab_t *slab = neu_value_slab_new();
+    neu_cvalue_t      cv   = { 0 };
+    neu_dvalue_t      in   = {};
+    neu_dvalue_t      out  = {};
+    size_t            len  = 0;
+    const void *      data = NULL;
+
+    in.type = NEU_TYPE_STRING;
+    strcpy(in.value.str, "hello");
+    neu_cvalue_set(slab, &cv, &in);
+    EXPECT_EQ(5, cv.length);
+    EXPECT_GT(neu_value_slab_size(slab), 0u);
+
+    neu_cvalue_get(&cv, &out);
+    EXPECT_STREQ("hello", out.value.str);
+    EXPECT_TRUE(neu_cvalue_equal(&cv, &in, 0));
+    data = neu_cvalue_data(&cv, &len);
+    EXPECT_EQ(5u, len);
+    EXPECT_EQ(0, memcmp("hello", data, len));
+
+    // same size class, the chunk is reused
+    void *chunk = cv.v.data;
+    strcpy(in.value.str, "world");
+    neu_cvalue_set(slab, &cv, &in);
+    EXPECT_EQ(chunk, cv.v.data);
+
+    memset(&in, 0, sizeof(in));
+    memset(&out, 0, sizeof(out));
+    in.type               = NEU_TYPE_ARRAY_UINT32;
+    in.value.u32s.length  = 3;
+    in.value.u32s.u32s[0] = 1;
+    in.value.u32s.u32s[1] = 2;
+    in.value.u32s.u32s[2] = 3;
+    neu_cvalue_set(slab, &cv, &in);
+    EXPECT_EQ(3, cv.length);
+
+    neu_cvalue_get(&cv, &out);
+    EXPECT_EQ(3, out.value.u32s.length);
+    EXPECT_EQ(3u, out.value.u32s.u32s[2]);
+    EXPECT_TRUE(neu_cvalue_equal(&cv, &in, 0));
+
+    in.value.u32s.length = 2;
+    EXPECT_FALSE(neu_cvalue_equal(&cv, &in, 0));
+
+    neu_cvalue_release(slab, &cv);
+    neu_value_slab_free(slab);
+}
+
+TEST(driver_value, owned_values_should_be_copied_deeply)
+{
+    neu_value_slab_t *slab = neu_value_slab_new();
+    neu_cvalue_t      cv   = { 0 };
+    neu_cvalue_t      old  = { 0 };
+    neu_dvalue_t      in   = {};
+    neu_dvalue_t      out  = {};
+
+    // the strings are taken over
+    in.type               = NEU_TYPE_ARRAY_STRING;
+    in.value.strs.length  = 2;
+    in.value.strs.strs[0] = strdup("a");
+    in.value.strs.strs[1] = strdup("bc");
+    neu_cvalue_set(slab, &cv, &in);
+    neu_cvalue_copy(slab, &old, &cv);
+    EXPECT_TRUE(neu_cvalue_equal(&old, &in, 0));
+    neu_cvalue_release(slab, &old);
+
+    neu_cvalue_get(&cv, &out);
+    EXPECT_STREQ("bc", out.value.strs.strs[1]);
+    EXPECT_NE(in.value.strs.strs[1], out.value.strs.strs[1]);
+    free(out.value.strs.strs[0]);
+    free(out.value.strs.strs[1]);
+
+    // pointers larger than the biggest class go to the heap
+    uint8_t buf[2000] = { 0 };
+    memset(&in, 0, sizeof(in));
+    in.type             = NEU_TYPE_PTR;
+    in.value.ptr.type   = NEU_TYPE_BYTES;
+    in.value.ptr.length = sizeof(buf);
+    in.value.ptr.ptr    = buf;
+    size_t size         = neu_value_slab_size(slab);
+    neu_cvalue_set(slab, &cv, &in);
+    EXPECT_EQ(size + sizeof(buf), neu_value_slab_size(slab));
+    EXPECT_TRUE(neu_cvalue_equal(&cv, &in, 0));
+    EXPECT_EQ(NULL, neu_cvalue_data(&cv, &size));
+
+    neu_cvalue_get(&cv, &out);
+    EXPECT_EQ(sizeof(buf), out.value.ptr.length);
+    EXPECT_NE(buf, out.value.ptr.ptr);
+    free(out.value.ptr.ptr);
+
+    // json is shared by reference
+    memset(&in, 0, sizeof(in));
+    in.type       = NEU_TYPE_CUSTOM;
+    in.value.json = json_pack("{si}", "a", 1);
+    neu_cvalue_set(slab, &cv, &in);
+    neu_cvalue_copy(slab, &old, &cv);
+    EXPECT_EQ(2u, in.value.json->refcount);
+    neu_cvalue_release(slab, &old);
+    EXPECT_EQ(1u, in.value.json->refcount);
+
+    neu_cvalue_release(slab, &cv);
+    neu_value_slab_free(slab);
+}
@@ -0,0 +1,153 @@
+#include <gtest/gtest.h>
+
+extern "C" {
+#include "adapter/driver/fup_seek.h"
+}
+
+// requests are only compared, never dereferenced
+static void *req(uintptr_t i)
+{
+    return (void *) (0x1000 + i * 0x10);
+}
+
+class fup_seek : public ::testing::Test {
+  protected:
+    void SetUp() override
+    {
+        for (int i = 0; i < (int) sizeof(file); i++) {
+            file[i] = i;
+        }
+        seek = neu_fup_seek_new();
+        ASSERT_NE(nullptr, seek);
+    }
+
+    void TearDown() override { neu_fup_seek_free(seek); }
+
+    // answer chunk `n` of the file, `size` bytes each
+    neu_fup_seek_e chunk(void *r, int n, uint16_t size)
+    {
+        int64_t start = (int64_t) n * size;
+
+        bytes   = &file[start < len ? start : len];
+        n_bytes = start + size < len ? size : (start < len ? len - start : 0);
+        more    = start + size < len;
+        return neu_fup_seek_chunk(seek, r, 0, &bytes, &n_bytes, &more);
+    }
+
+    neu_fup_seek_t *seek = NULL;
+    uint8_t         file[100];
+    int64_t         len = sizeof(file);
+
+    uint8_t *bytes   = NULL;
+    uint16_t n_bytes = 0;
+    bool     more    = false;
+};
+
+TEST_F(fup_seek, chunks_before_offset_should_be_dropped)
+{
+    neu_fup_seek_start(seek, req(1), 40);
+
+    EXPECT_EQ(NEU_FUP_SEEK_READ, chunk(req(1), 0, 16));
+    EXPECT_EQ(NEU_FUP_SEEK_READ, chunk(req(1), 1, 16));
+    EXPECT_EQ(NEU_FUP_SEEK_DONE, chunk(req(1), 2, 16));
+    EXPECT_EQ(8, n_bytes);
+    EXPECT_EQ(40, bytes[0]);
+    EXPECT_TRUE(more);
+
+    // the following chunks follow on
+    EXPECT_EQ(NEU_FUP_SEEK_PASS, chunk(req(1), 3, 16));
+    EXPECT_EQ(16, n_bytes);
+}
+
+TEST_F(fup_seek, offset_on_chunk_boundary_should_keep_whole_chunk)
+{
+    neu_fup_seek_start(seek, req(1), 32);
+
+    EXPECT_EQ(NEU_FUP_SEEK_READ, chunk(req(1), 0, 16));
+    EXPECT_EQ(NEU_FUP_SEEK_READ, chunk(req(1), 1, 16));
+    EXPECT_EQ(NEU_FUP_SEEK_DONE, chunk(req(1), 2, 16));
+    EXPECT_EQ(16, n_bytes);
+    EXPECT_EQ(32, bytes[0]);
+}
+
+TEST_F(fup_seek, offset_past_end_should_answer_empty_last_chunk)
+{
+    neu_fup_seek_start(seek, req(1), 500);
+
+    for (int i = 0; i < 6; i++) {
+        EXPECT_EQ(NEU_FUP_SEEK_READ, chunk(req(1), i, 16));
+    }
+    EXPECT_EQ(NEU_FUP_SEEK_DONE, chunk(req(1), 6, 16));
+    EXPECT_EQ(0, n_bytes);
+    EXPECT_FALSE(more);
+}
+
+TEST_F(fup_seek, error_should_end_the_seek)
+{
+    neu_fup_seek_start(seek, req(1), 40);
+
+    EXPECT_EQ(NEU_FUP_SEEK_READ, chunk(req(1), 0, 16));
+    EXPECT_EQ(NEU_FUP_SEEK_DONE,
+              neu_fup_seek_chunk(seek, req(1), -1, &bytes, &n_bytes, &more));
+    EXPECT_EQ(NEU_FUP_SEEK_PASS, chunk(req(1), 1, 16));
+}
+
+TEST_F(fup_seek, requests_during_seek_should_replay_in_order)
+{
+    EXPECT_FALSE(neu_fup_seek_defer(seek, req(1)));
+    neu_fup_seek_start(seek, req(1), 20);
+
+    EXPECT_TRUE(neu_fup_seek_defer(seek, req(2)));
+    EXPECT_TRUE(neu_fup_seek_defer(seek, req(3)));
+    EXPECT_EQ(NEU_FUP_SEEK_PASS, chunk(req(2), 0, 16));
+    EXPECT_EQ(nullptr, neu_fup_seek_next(seek));
+
+    EXPECT_EQ(NEU_FUP_SEEK_READ, chunk(req(1), 0, 16));
+    EXPECT_EQ(NEU_FUP_SEEK_DONE, chunk(req(1), 1, 16));
+
+    // still queued behind the replay
+    EXPECT_TRUE(neu_fup_seek_defer(seek, req(4)));
+
+    EXPECT_EQ(req(2), neu_fup_seek_next(seek));
+    EXPECT_EQ(req(3), neu_fup_seek_next(seek));
+    EXPECT_EQ(req(4), neu_fup_seek_next(seek));
+    EXPECT_EQ(nullptr, neu_fup_seek_next(seek));
+
+    EXPECT_FALSE(neu_fup_seek_defer(seek, req(5)));
+}
+
+TEST_F(fup_seek, replay_should_stop_at_next_seek)
+{
+    neu_fup_seek_start(seek, req(1), 20);
+    EXPECT_TRUE(neu_fup_seek_defer(seek, req(2)));
+    EXPECT_TRUE(neu_fup_seek_defer(seek, req(3)));
+    EXPECT_EQ(NEU_FUP_SEEK_READ, chunk(req(1), 0, 16));
+    EXPECT_EQ(NEU_FUP_SEEK_DONE, chunk(req(1), 1, 16));
+
+    // the replayed request seeks too
+    EXPECT_EQ(req(2), neu_fup_seek_next(seek));
+    neu_fup_seek_start(seek, req(2), 10);
+    EXPECT_EQ(nullptr, neu_fup_seek_next(seek));
+    EXPECT_TRUE(neu_fup_seek_defer(seek, req(4)));
+
+    EXPECT_EQ(NEU_FUP_SEEK_DONE, chunk(req(2), 0, 16));
+    EXPECT_EQ(6, n_bytes);
+    EXPECT_EQ(req(3), neu_fup_seek_next(seek));
+    EXPECT_EQ(req(4), neu_fup_seek_next(seek));
+    EXPECT_EQ(nullptr, neu_fup_seek_next(seek));
+}
+
+TEST_F(fup_seek, nested_read_should_be_left_to_outer_loop)
+{
+    neu_fup_seek_start(seek, req(1), 40);
+
+    EXPECT_TRUE(neu_fup_seek_read(seek));
+    // a chunk answered within the read asks for the next one
+    EXPECT_FALSE(neu_fup_seek_read(seek));
+    EXPECT_TRUE(neu_fup_seek_again(seek));
+    EXPECT_FALSE(neu_fup_seek_again(seek));
+
+    // answered later, from another thread
+    EXPECT_TRUE(neu_fup_seek_read(seek));
+    EXPECT_FALSE(neu_fup_seek_again(seek));
+}
@@ -0,0 +1,61 @@
+#include <gtest/gtest.h>
+
+#include "utils/histogram.h"
+#include "utils/log.h"
+
+zlog_category_t *neuron = NULL;
+TEST(HistogramTest, neu_histogram_index)
+{
+    // small values are exact
+    for (uint64_t v = 0; v < 2 * NEU_HISTOGRAM_SUB_COUNT; ++v) {
+        EXPECT_EQ(v, neu_histogram_index(v));
+        EXPECT_EQ(v, neu_histogram_bucket_upper(neu_histogram_index(v)));
+    }
+
+    // every value falls into the bucket right above the previous one
+    for (uint64_t v = 1; v < (1 << 20); ++v) {
+        unsigned i = neu_histogram_index(v);
+        EXPECT_LE(v, neu_histogram_bucket_upper(i));
+        EXPECT_GT(v, neu_histogram_bucket_upper(i - 1));
+    }
+
+    // huge values are clamped to the last bucket
+    EXPECT_EQ(NEU_HISTOGRAM_BUCKETS - 1, neu_histogram_index(UINT64_MAX));
+}
+
+TEST(HistogramTest, neu_histogram_quantile)
+{
+    neu_histogram_t *hist = neu_histogram_new();
+    EXPECT_NE(nullptr, hist);
+
+    EXPECT_EQ(0, neu_histogram_quantile(hist, 0.5));
+
+    for (uint64_t v = 1; v <= 1000; ++v) {
+        neu_histogram_record(hist, v);
+    }
+    EXPECT_EQ(1000, neu_histogram_count(hist));
+    EXPECT_EQ(500500, neu_histogram_sum(hist));
+
+    // relative error is bounded by the bucket width
+    uint64_t p50 = neu_histogram_quantile(hist, 0.5);
+    EXPECT_GE(p50, 500);
+    EXPECT_LE(p50, 500 + 500 / NEU_HISTOGRAM_SUB_COUNT);
+    uint64_t p99 = neu_histogram_quantile(hist, 0.99);
+    EXPECT_GE(p99, 990);
+    EXPECT_LE(p99, 1000);
+    EXPECT_EQ(1000, neu_histogram_quantile(hist, 1));
+
+    neu_histogram_reset(hist);
+    EXPECT_EQ(0, neu_histogram_count(hist));
+    EXPECT_EQ(0, neu_histogram_quantile(hist, 0.99));
+
+    neu_histogram_free(hist);
+}
+
+int main(int argc, char **argv)
+{
+    zlog_init("./config/dev.conf");
+    neuron = zlog_get_category("neuron");
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
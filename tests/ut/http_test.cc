@@ -1,3 +1,10 @@
+#include <arpa/inet.h>
+#include <atomic>
+#include <string>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+
 #include <gtest/gtest.h>
 
 #include "adapter.h"
@@ -123,6 +130,122 @@ TEST(HTTPTest, http_get_param_str)
     nng_url_free(url);
 }
 
+#define STREAM_TEST_URL "http://127.0.0.1:17690"
+#define STREAM_TEST_PORT 17690
+#define STREAM_TEST_TOTAL (32 * 1024 * 1024)
+#define STREAM_TEST_BLOCK 1024
+
+static std::atomic<size_t> stream_written(0);
+static std::thread         stream_writer;
+
+static void stream_test_handler(nng_aio *aio)
+{
+    neu_http_stream_t *stream = neu_http_stream_open(aio, "text/plain");
+    ASSERT_NE(nullptr, stream);
+
+    stream_writer = std::thread([stream]() {
+        char block[STREAM_TEST_BLOCK];
+
+        for (size_t off = 0; off < STREAM_TEST_TOTAL; off += sizeof(block)) {
+            for (size_t i = 0; i < sizeof(block); i++) {
+                block[i] = (char) ((off + i) % 251);
+            }
+            if (0 != neu_http_stream_write(stream, block, sizeof(block))) {
+                break;
+            }
+            stream_written += sizeof(block);
+        }
+        neu_http_stream_close(stream);
+    });
+}
+
+// the chunked body of a response read until the peer closed
+static bool stream_test_body(const std::string &resp, std::string &body)
+{
+    size_t pos = resp.find("\r\n\r\n");
+
+    if (std::string::npos == pos) {
+        return false;
+    }
+
+    for (pos += 4; pos < resp.size();) {
+        size_t eol = resp.find("\r\n", pos);
+        size_t len = 0;
+
+        if (std::string::npos == eol) {
+            return false;
+        }
+        len = strtoul(resp.substr(pos, eol - pos).c_str(), NULL, 16);
+        if (0 == len) {
+            return true;
+        }
+        body.append(resp, eol + 2, len);
+        pos = eol + 2 + len + 2;
+    }
+    return false;
+}
+
+TEST(HTTPTest, http_stream_slow_reader)
+{
+    nng_url *         url     = NULL;
+    nng_http_server * server  = NULL;
+    nng_http_handler *handler = NULL;
+
+    ASSERT_EQ(0, nng_url_parse(&url, STREAM_TEST_URL));
+    ASSERT_EQ(0, nng_http_server_hold(&server, url));
+    ASSERT_EQ(0, nng_http_handler_alloc(&handler, "/stream",
+                                        stream_test_handler));
+    ASSERT_EQ(0, nng_http_server_add_handler(server, handler));
+    ASSERT_EQ(0, nng_http_server_start(server));
+
+    int                fd     = socket(AF_INET, SOCK_STREAM, 0);
+    int                rcvbuf = 4096;
+    struct sockaddr_in addr   = {};
+
+    // keep the kernel from soaking up the body for the reader
+    setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof(rcvbuf));
+    addr.sin_family      = AF_INET;
+    addr.sin_port        = htons(STREAM_TEST_PORT);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    ASSERT_EQ(0, connect(fd, (struct sockaddr *) &addr, sizeof(addr)));
+
+    const char *req = "GET /stream HTTP/1.1\r\nHost: localhost\r\n\r\n";
+    ASSERT_EQ((ssize_t) strlen(req), write(fd, req, strlen(req)));
+
+    // the reader stalls, the writer must be held back by the window
+    // instead of queueing the whole body
+    usleep(500 * 1000);
+    EXPECT_LT(stream_written.load(), (size_t) STREAM_TEST_TOTAL / 2);
+
+    std::string resp;
+    char        buf[4096];
+    ssize_t     n = 0;
+    while ((n = read(fd, buf, sizeof(buf))) > 0) {
+        resp.append(buf, n);
+        if (resp.size() < 64 * 1024) {
+            // keep reading slowly for a while
+            usleep(1000);
+        }
+    }
+    close(fd);
+    stream_writer.join();
+
+    std::string body;
+    EXPECT_TRUE(stream_test_body(resp, body));
+    EXPECT_EQ((size_t) STREAM_TEST_TOTAL, stream_written.load());
+    ASSERT_EQ((size_t) STREAM_TEST_TOTAL, body.size());
+    for (size_t i = 0; i < body.size(); i++) {
+        if ((char) (i % 251) != body[i]) {
+            ADD_FAILURE() << "body differs at " << i;
+            break;
+        }
+    }
+
+    nng_http_server_stop(server);
+    nng_http_server_release(server);
+    nng_url_free(url);
+}
+
 int main(int argc, char **argv)
 {
     zlog_init("./config/dev.conf");
@@ -0,0 +1,96 @@
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "utils/intern.h"
+
+TEST(intern, equal_strings_should_share_pointer)
+{
+    size_t      count = neu_intern_count();
+    char        buf[] = "group-1";
+    const char *a     = neu_intern("group-1");
+    const char *b     = neu_intern(buf);
+
+    EXPECT_EQ(a, b);
+    EXPECT_NE(buf, b);
+    EXPECT_STREQ("group-1", a);
+    EXPECT_EQ(strlen("group-1"), neu_intern_len(a));
+    EXPECT_EQ(count + 1, neu_intern_count());
+
+    const char *c = neu_intern("group-2");
+    EXPECT_NE(a, c);
+    EXPECT_NE(neu_intern_hash(a), neu_intern_hash(c));
+    EXPECT_EQ(count + 2, neu_intern_count());
+
+    neu_intern_release(a);
+    neu_intern_release(b);
+    neu_intern_release(c);
+    EXPECT_EQ(count, neu_intern_count());
+}
+
+TEST(intern, string_should_live_while_referenced)
+{
+    const char *a = neu_intern("tag-1");
+
+    EXPECT_EQ(a, neu_intern_find("tag-1"));
+    EXPECT_EQ(a, neu_intern_ref(a));
+
+    neu_intern_release(a);
+    EXPECT_EQ(a, neu_intern_find("tag-1"));
+
+    neu_intern_release(a);
+    EXPECT_EQ(NULL, neu_intern_find("tag-1"));
+
+    // find does not intern
+    EXPECT_EQ(NULL, neu_intern_find("tag-2"));
+    neu_intern_release(NULL);
+
+    const char *empty = neu_intern("");
+    EXPECT_EQ(0u, neu_intern_len(empty));
+    EXPECT_EQ(empty, neu_intern_find(""));
+    neu_intern_release(empty);
+}
+
+TEST(intern, concurrent_intern_should_agree)
+{
+    const int                n_thread = 8;
+    const int                n_name   = 1000;
+    size_t                   count    = neu_intern_count();
+    std::vector<std::thread> threads;
+    std::vector<std::vector<const char *>> names(n_thread);
+
+    for (int t = 0; t < n_thread; t++) {
+        threads.emplace_back([t, &names]() {
+            char name[32] = { 0 };
+
+            for (int i = 0; i < n_name; i++) {
+                snprintf(name, sizeof(name), "tag-%d", i);
+                names[t].push_back(neu_intern(name));
+            }
+        });
+    }
+    for (auto &th : threads) {
+        th.join();
+    }
+
+    EXPECT_EQ(count + n_name, neu_intern_count());
+    for (int t = 1; t < n_thread; t++) {
+        EXPECT_EQ(names[0], names[t]);
+    }
+
+    threads.clear();
+    for (int t = 0; t < n_thread; t++) {
+        threads.emplace_back([t, &names]() {
+            for (const char *name : names[t]) {
+                neu_intern_release(name);
+            }
+        });
+    }
+    for (auto &th : threads) {
+        th.join();
+    }
+
+    EXPECT_EQ(count, neu_intern_count());
+}
@@ -4,6 +4,7 @@
 
 #include "utils/log.h"
 
+#include "json/neu_json_driver.h"
 #include "parser/neu_json_system.h"
 
 zlog_category_t *neuron = NULL;
@@ -342,6 +343,41 @@ TEST(JsonTest, System_ctl)
     free(req);
 }
 
+TEST(JsonTest, Fup_open_window)
+{
+    neu_json_driver_fup_open_req_t *req = NULL;
+
+    EXPECT_EQ(0,
+              neu_json_decode_driver_fup_open_req(
+                  (char *) "{\"node\": \"d\", \"path\": \"/a\"}", &req));
+    EXPECT_EQ(0, req->window);
+    neu_json_decode_driver_fup_open_req_free(req);
+
+    EXPECT_EQ(0,
+              neu_json_decode_driver_fup_open_req(
+                  (char *) "{\"node\": \"d\", \"path\": \"/a\", "
+                           "\"window\": 64, \"offset\": 10}",
+                  &req));
+    EXPECT_EQ(64, req->window);
+    EXPECT_EQ(10, req->offset);
+    neu_json_decode_driver_fup_open_req_free(req);
+
+    // out of range windows would be truncated to uint16_t
+    const char *bad[] = {
+        "{\"node\": \"d\", \"path\": \"/a\", \"window\": 0}",
+        "{\"node\": \"d\", \"path\": \"/a\", \"window\": -1}",
+        "{\"node\": \"d\", \"path\": \"/a\", \"window\": 65}",
+        "{\"node\": \"d\", \"path\": \"/a\", \"window\": 65537}",
+        "{\"node\": \"d\", \"path\": \"/a\", \"offset\": -5}",
+    };
+    for (const char *buf : bad) {
+        req = NULL;
+        EXPECT_EQ(-1, neu_json_decode_driver_fup_open_req((char *) buf, &req))
+            << buf;
+        EXPECT_EQ(nullptr, req);
+    }
+}
+
 int main(int argc, char **argv)
 {
     zlog_init("./config/dev.conf");
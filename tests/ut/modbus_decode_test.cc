@@ -0,0 +1,175 @@
+#include <cstdlib>
+#include <cstring>
+#include <gtest/gtest.h>
+#include <neuron.h>
+extern "C" {
+#include "modbus_decode.h"
+}
+
+zlog_category_t *neuron = NULL;
+
+static const neu_type_e numeric_types[] = {
+    NEU_TYPE_UINT16, NEU_TYPE_INT16,  NEU_TYPE_FLOAT,
+    NEU_TYPE_INT32,  NEU_TYPE_UINT32, NEU_TYPE_DOUBLE,
+    NEU_TYPE_INT64,  NEU_TYPE_UINT64,
+};
+
+static const modbus_endianess endianess_list[] = {
+    MODBUS_ABCD,
+    MODBUS_BADC,
+    MODBUS_DCBA,
+    MODBUS_CDAB,
+};
+
+static uint16_t type_registers(neu_type_e type)
+{
+    switch (type) {
+    case NEU_TYPE_UINT16:
+    case NEU_TYPE_INT16:
+        return 1;
+    case NEU_TYPE_FLOAT:
+    case NEU_TYPE_INT32:
+    case NEU_TYPE_UINT32:
+        return 2;
+    default:
+        return 4;
+    }
+}
+
+// a dense 125 register command of mixed tags starting at register 100
+struct decode_cmd {
+    modbus_point_t    points[125];
+    modbus_read_cmd_t cmd;
+
+    decode_cmd(unsigned seed, modbus_area_e area)
+    {
+        uint16_t address = 100;
+        int      n       = 0;
+
+        memset(points, 0, sizeof(points));
+        memset(&cmd, 0, sizeof(cmd));
+        utarray_new(cmd.tags, &ut_ptr_icd);
+        srand(seed);
+
+        while (n < 125) {
+            modbus_point_t *p = &points[n++];
+
+            p->slave_id      = 1;
+            p->area          = area;
+            p->type          = numeric_types[rand() % 8];
+            p->n_register    = type_registers(p->type);
+            p->start_address = address;
+            p->option.value32.is_default = rand() % 2;
+            if (address + p->n_register > 100 + 125) {
+                break;
+            }
+            snprintf(p->name, sizeof(p->name), "tag%d", n);
+            utarray_push_back(cmd.tags, &p);
+            // overlapping tags are allowed
+            address += rand() % 3 == 0 ? 1 : p->n_register;
+        }
+
+        cmd.slave_id      = 1;
+        cmd.area          = area;
+        cmd.start_address = 100;
+        cmd.n_register    = 125;
+    }
+
+    ~decode_cmd() { utarray_free(cmd.tags); }
+};
+
+static void random_bytes(uint8_t *bytes, int n)
+{
+    for (int i = 0; i < n; i++) {
+        bytes[i] = rand();
+    }
+}
+
+static void expect_golden(modbus_decode_plan_t *plan, decode_cmd &dc,
+                          modbus_endianess endianess, const uint8_t *bytes,
+                          uint16_t n_byte)
+{
+    utarray_foreach(dc.cmd.tags, modbus_point_t **, p_tag)
+    {
+        unsigned    i     = utarray_eltidx(dc.cmd.tags, p_tag);
+        neu_value_u value = {};
+
+        ASSERT_TRUE(plan->ops[i].shuffle);
+        modbus_decode_point(*p_tag, dc.cmd.start_address, endianess, bytes,
+                            n_byte, &value);
+        EXPECT_EQ(value.u64, plan->values[i])
+            << "tag " << i << " type " << (*p_tag)->type << " endianess "
+            << endianess;
+    }
+}
+
+TEST(test_modbus_decode, block_should_match_scalar_decode)
+{
+    uint8_t bytes[250];
+
+    for (unsigned seed = 1; seed <= 20; seed++) {
+        decode_cmd dc(seed, MODBUS_AREA_HOLD_REGISTER);
+
+        for (modbus_endianess e : endianess_list) {
+            modbus_decode_plan_t *plan = modbus_decode_plan_new(&dc.cmd, e);
+
+            random_bytes(bytes, sizeof(bytes));
+            modbus_decode_block(plan, bytes, sizeof(bytes));
+            expect_golden(plan, dc, e, bytes, sizeof(bytes));
+
+            memset(plan->values, 0xff, plan->n_op * sizeof(uint64_t));
+            modbus_decode_block_scalar(plan, bytes, sizeof(bytes));
+            expect_golden(plan, dc, e, bytes, sizeof(bytes));
+
+            modbus_decode_plan_free(plan);
+        }
+    }
+}
+
+TEST(test_modbus_decode, short_response_should_match_scalar_decode)
+{
+    decode_cmd            dc(7, MODBUS_AREA_INPUT_REGISTER);
+    modbus_decode_plan_t *plan = modbus_decode_plan_new(&dc.cmd, MODBUS_CDAB);
+    uint8_t               bytes[250];
+
+    random_bytes(bytes, sizeof(bytes));
+    for (uint16_t n_byte = 0; n_byte <= sizeof(bytes); n_byte += 7) {
+        modbus_decode_block(plan, bytes, n_byte);
+        expect_golden(plan, dc, MODBUS_CDAB, bytes, n_byte);
+    }
+
+    modbus_decode_plan_free(plan);
+}
+
+TEST(test_modbus_decode, non_numeric_tags_should_not_shuffle)
+{
+    modbus_point_t    points[3] = {};
+    modbus_read_cmd_t cmd       = {};
+
+    utarray_new(cmd.tags, &ut_ptr_icd);
+    cmd.start_address = 0;
+    cmd.n_register    = 10;
+
+    points[0].area       = MODBUS_AREA_HOLD_REGISTER;
+    points[0].type       = NEU_TYPE_BIT;
+    points[0].n_register = 1;
+    points[1].area       = MODBUS_AREA_HOLD_REGISTER;
+    points[1].type       = NEU_TYPE_STRING;
+    points[1].n_register = 4;
+    points[2].area       = MODBUS_AREA_COIL;
+    points[2].type       = NEU_TYPE_BIT;
+    points[2].n_register = 1;
+    for (int i = 0; i < 3; i++) {
+        modbus_point_t *p = &points[i];
+        utarray_push_back(cmd.tags, &p);
+    }
+
+    modbus_decode_plan_t *plan = modbus_decode_plan_new(&cmd, MODBUS_ABCD);
+    EXPECT_EQ(3, plan->n_op);
+    for (int i = 0; i < 3; i++) {
+        EXPECT_FALSE(plan->ops[i].shuffle);
+    }
+
+    modbus_decode_plan_free(plan);
+    utarray_free(cmd.tags);
+}
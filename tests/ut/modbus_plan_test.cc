@@ -0,0 +1,261 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <gtest/gtest.h>
+#include <neuron.h>
+extern "C" {
+#include "modbus_decode.h"
+#include "modbus_plan.h"
+}
+
+zlog_category_t *neuron = NULL;
+
+static UT_icd tag_icd = { sizeof(neu_datatag_t), NULL, NULL, NULL };
+
+static void push_tag(UT_array *tags, const char *name, const char *address,
+                     neu_type_e      type,
+                     neu_attribute_e attribute = NEU_ATTRIBUTE_READ)
+{
+    neu_datatag_t tag = {};
+
+    tag.name      = (char *) name;
+    tag.address   = (char *) address;
+    tag.type      = type;
+    tag.attribute = attribute;
+    utarray_push_back(tags, &tag);
+}
+
+// tags are described by name and address strings kept alive by the test
+struct tag_set {
+    char       names[4096][16];
+    char       addresses[4096][32];
+    neu_type_e types[4096];
+    int        attributes[4096];
+    bool       used[4096];
+
+    tag_set() { memset(used, 0, sizeof(used)); }
+
+    void set(int i, int slave, char area, int address, neu_type_e type)
+    {
+        snprintf(names[i], sizeof(names[i]), "tag%d", i);
+        snprintf(addresses[i], sizeof(addresses[i]), "%d!%c%05d", slave, area,
+                 address);
+        types[i]      = type;
+        attributes[i] = NEU_ATTRIBUTE_READ;
+        used[i]       = true;
+    }
+
+    UT_array *tags()
+    {
+        UT_array *tags = NULL;
+
+        utarray_new(tags, &tag_icd);
+        for (int i = 0; i < 4096; i++) {
+            if (used[i]) {
+                push_tag(tags, names[i], addresses[i], types[i],
+                         (neu_attribute_e) attributes[i]);
+            }
+        }
+        return tags;
+    }
+};
+
+static void random_tag(tag_set &set, int i)
+{
+    static const neu_type_e types[] = { NEU_TYPE_UINT16, NEU_TYPE_FLOAT,
+                                        NEU_TYPE_DOUBLE };
+    static const char       areas[] = { '0', '1', '3', '4' };
+    char                    area    = areas[rand() % 4];
+    neu_type_e              type    = types[rand() % 3];
+
+    if (area == '0' || area == '1') {
+        type = NEU_TYPE_BIT;
+    }
+
+    set.set(i, 1 + rand() % 2, area, 1 + rand() % 3000, type);
+}
+
+static std::string describe(modbus_read_cmd_sort_t *cs)
+{
+    std::string s;
+
+    for (uint16_t i = 0; i < cs->n_cmd; i++) {
+        modbus_read_cmd_t *cmd = &cs->cmd[i];
+        char               buf[64];
+
+        snprintf(buf, sizeof(buf), "%u/%u/%u+%u:", cmd->slave_id, cmd->area,
+                 cmd->start_address, cmd->n_register);
+        s += buf;
+        utarray_foreach(cmd->tags, modbus_point_t **, p)
+        {
+            s += (*p)->name;
+            s += ",";
+        }
+        s += "\n";
+    }
+
+    return s;
+}
+
+static void expect_same_as_full_build(modbus_plan_t *plan, UT_array *tags)
+{
+    modbus_plan_t *full = modbus_plan_new(250, MODBUS_ABCD, base_1);
+
+    modbus_plan_update(full, tags);
+    EXPECT_EQ(describe(modbus_plan_cmds(full)),
+              describe(modbus_plan_cmds(plan)));
+    modbus_plan_free(full);
+}
+
+TEST(test_modbus_plan, commands_should_cover_contiguous_points)
+{
+    UT_array *     tags = NULL;
+    modbus_plan_t *plan = modbus_plan_new(250, MODBUS_ABCD, base_1);
+
+    utarray_new(tags, &tag_icd);
+    push_tag(tags, "a", "1!400001", NEU_TYPE_UINT16);
+    push_tag(tags, "b", "1!400002", NEU_TYPE_FLOAT);
+    push_tag(tags, "c", "1!400010", NEU_TYPE_UINT16);
+    push_tag(tags, "d", "2!400001", NEU_TYPE_UINT16);
+    push_tag(tags, "e", "1!000001", NEU_TYPE_BIT);
+    push_tag(tags, "f", "bad", NEU_TYPE_UINT16);
+
+    EXPECT_EQ(1, modbus_plan_update(plan, tags));
+    EXPECT_EQ("1/0/0+1:e,\n"
+              "1/4/0+3:a,b,\n"
+              "1/4/9+1:c,\n"
+              "2/4/0+1:d,\n",
+              describe(modbus_plan_cmds(plan)));
+
+    utarray_free(tags);
+    modbus_plan_free(plan);
+}
+
+TEST(test_modbus_plan, commands_should_respect_max_byte)
+{
+    tag_set *      set  = new tag_set();
+    modbus_plan_t *plan = modbus_plan_new(250, MODBUS_ABCD, base_1);
+
+    for (int i = 0; i < 300; i++) {
+        set->set(i, 1, '4', i + 1, NEU_TYPE_UINT16);
+    }
+
+    UT_array *tags = set->tags();
+    modbus_plan_update(plan, tags);
+
+    modbus_read_cmd_sort_t *cs = modbus_plan_cmds(plan);
+    ASSERT_EQ(3, cs->n_cmd);
+    EXPECT_EQ(124, cs->cmd[0].n_register);
+    EXPECT_EQ(124, cs->cmd[1].start_address);
+    EXPECT_EQ(248, cs->cmd[2].start_address);
+    EXPECT_EQ(52, cs->cmd[2].n_register);
+
+    utarray_free(tags);
+    modbus_plan_free(plan);
+    delete set;
+}
+
+TEST(test_modbus_plan, change_should_keep_unaffected_commands)
+{
+    tag_set *      set  = new tag_set();
+    modbus_plan_t *plan = modbus_plan_new(250, MODBUS_ABCD, base_1);
+
+    // two blocks of 10 registers far apart
+    for (int i = 0; i < 10; i++) {
+        set->set(i, 1, '4', i + 1, NEU_TYPE_UINT16);
+        set->set(100 + i, 1, '4', 1000 + i, NEU_TYPE_UINT16);
+    }
+
+    UT_array *tags = set->tags();
+    modbus_plan_update(plan, tags);
+    utarray_free(tags);
+
+    modbus_read_cmd_sort_t *cs = modbus_plan_cmds(plan);
+    ASSERT_EQ(2, cs->n_cmd);
+    struct modbus_decode_plan *kept = cs->cmd[1].plan;
+
+    // grow the first block by one register
+    set->set(10, 1, '4', 11, NEU_TYPE_UINT16);
+    tags = set->tags();
+    modbus_plan_update(plan, tags);
+
+    ASSERT_EQ(2, cs->n_cmd);
+    EXPECT_EQ(11, cs->cmd[0].n_register);
+    EXPECT_EQ(kept, cs->cmd[1].plan);
+    expect_same_as_full_build(plan, tags);
+    utarray_free(tags);
+
+    // retype a tag of the first block
+    set->types[3] = NEU_TYPE_INT16;
+    tags          = set->tags();
+    modbus_plan_update(plan, tags);
+    EXPECT_EQ(kept, cs->cmd[1].plan);
+    expect_same_as_full_build(plan, tags);
+    utarray_free(tags);
+
+    modbus_plan_free(plan);
+    delete set;
+}
+
+TEST(test_modbus_plan, attribute_change_should_replan)
+{
+    tag_set *      set  = new tag_set();
+    modbus_plan_t *plan = modbus_plan_new(250, MODBUS_ABCD, base_1);
+
+    set->set(0, 1, '3', 1, NEU_TYPE_UINT16);
+    set->set(1, 1, '3', 2, NEU_TYPE_UINT16);
+
+    UT_array *tags = set->tags();
+    EXPECT_EQ(0, modbus_plan_update(plan, tags));
+    utarray_free(tags);
+
+    modbus_read_cmd_sort_t *cs = modbus_plan_cmds(plan);
+    ASSERT_EQ(1, cs->n_cmd);
+    EXPECT_EQ(2, cs->cmd[0].n_register);
+
+    // input registers can not be written, the tag must drop out
+    set->attributes[1] = NEU_ATTRIBUTE_READ | NEU_ATTRIBUTE_WRITE;
+    tags               = set->tags();
+    EXPECT_EQ(1, modbus_plan_update(plan, tags));
+    utarray_free(tags);
+
+    cs = modbus_plan_cmds(plan);
+    ASSERT_EQ(1, cs->n_cmd);
+    EXPECT_EQ(1, cs->cmd[0].n_register);
+
+    modbus_plan_free(plan);
+    delete set;
+}
+
+TEST(test_modbus_plan, incremental_should_match_full_build)
+{
+    tag_set *      set  = new tag_set();
+    modbus_plan_t *plan = modbus_plan_new(250, MODBUS_ABCD, base_1);
+
+    srand(1);
+    for (int i = 0; i < 2000; i++) {
+        random_tag(*set, i);
+    }
+
+    for (int round = 0; round < 50; round++) {
+        UT_array *tags = set->tags();
+
+        modbus_plan_update(plan, tags);
+        expect_same_as_full_build(plan, tags);
+        utarray_free(tags);
+
+        // add, move and delete a few tags
+        for (int k = 0; k < 20; k++) {
+            int i = rand() % 4096;
+
+            if (set->used[i] && rand() % 2 == 0) {
+                set->used[i] = false;
+            } else {
+                random_tag(*set, i);
+            }
+        }
+    }
+
+    modbus_plan_free(plan);
+    delete set;
+}
@@ -0,0 +1,219 @@
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <gtest/gtest.h>
+
+extern "C" {
+#include "modbus_pool.h"
+}
+
+// slots are socket pairs, a slot answers a command by writing its index to
+// the peer end unless it is mute
+struct pool_peer {
+    int      fds[MODBUS_POOL_MAX][2];
+    bool     mute[MODBUS_POOL_MAX];
+    bool     send_fail;
+    int      sent[MODBUS_POOL_MAX];
+    int      fails[MODBUS_POOL_MAX];
+    int      done;
+    int      done_ok;
+    uint16_t done_slot[16];
+};
+
+static bool peer_ready(void *ctx, int s)
+{
+    (void) ctx;
+    (void) s;
+    return true;
+}
+
+static bool peer_wanted(void *ctx, uint16_t cmd)
+{
+    (void) ctx;
+    (void) cmd;
+    return true;
+}
+
+static int peer_send(void *ctx, int s, uint16_t cmd)
+{
+    pool_peer *peer = (pool_peer *) ctx;
+
+    if (peer->send_fail) {
+        return -1;
+    }
+    peer->sent[s] += 1;
+    if (!peer->mute[s]) {
+        EXPECT_EQ(2, write(peer->fds[s][1], &cmd, sizeof(cmd)));
+    }
+    return 1;
+}
+
+static int peer_fd(void *ctx, int s)
+{
+    return ((pool_peer *) ctx)->fds[s][0];
+}
+
+static int peer_recv(void *ctx, int s, uint16_t cmd)
+{
+    pool_peer *peer = (pool_peer *) ctx;
+    uint16_t   got  = 0;
+
+    if (read(peer->fds[s][0], &got, sizeof(got)) != sizeof(got)) {
+        return -1;
+    }
+    return got == cmd ? 1 : -2;
+}
+
+static void peer_health(void *ctx, int s, bool ok, int64_t now)
+{
+    (void) now;
+    ((pool_peer *) ctx)->fails[s] += !ok;
+}
+
+static void peer_done(void *ctx, int s, uint16_t cmd, int ret, int ret_buf,
+                      int64_t send_tms)
+{
+    pool_peer *peer = (pool_peer *) ctx;
+
+    (void) send_tms;
+    peer->done += 1;
+    peer->done_ok += ret > 0 && ret_buf > 0;
+    peer->done_slot[cmd] = s;
+}
+
+static modbus_pool_io_t peer_io(pool_peer *peer)
+{
+    modbus_pool_io_t io = {};
+
+    io.ctx    = peer;
+    io.ready  = peer_ready;
+    io.wanted = peer_wanted;
+    io.send   = peer_send;
+    io.fd     = peer_fd;
+    io.recv   = peer_recv;
+    io.health = peer_health;
+    io.done   = peer_done;
+    return io;
+}
+
+TEST(modbus_pool, init_should_clamp_connections)
+{
+    modbus_pool_t pool;
+
+    modbus_pool_init(&pool, 0);
+    EXPECT_EQ(1, pool.n_conn);
+
+    modbus_pool_init(&pool, MODBUS_POOL_MAX + 1);
+    EXPECT_EQ(MODBUS_POOL_MAX, pool.n_conn);
+    EXPECT_EQ(MODBUS_POOL_MAX, modbus_pool_n_usable(&pool, 0));
+    for (int i = 0; i < MODBUS_POOL_MAX; i++) {
+        EXPECT_EQ(-1, pool.conns[i].cmd);
+    }
+}
+
+TEST(modbus_pool, failing_connection_should_leave_rotation)
+{
+    modbus_pool_t pool;
+    int64_t       now = 1000;
+
+    modbus_pool_init(&pool, 3);
+    for (int n = 1; n < MODBUS_POOL_FAILURES; n++) {
+        EXPECT_FALSE(modbus_pool_fail(&pool, 1, now));
+        EXPECT_TRUE(modbus_pool_usable(&pool, 1, now));
+    }
+    EXPECT_TRUE(modbus_pool_fail(&pool, 1, now));
+    EXPECT_FALSE(modbus_pool_usable(&pool, 1, now));
+    EXPECT_EQ(2, modbus_pool_n_usable(&pool, now));
+
+    // back for a trial exchange after the backoff, it doubles on a failure
+    now += MODBUS_POOL_BACKOFF_MIN_MS;
+    EXPECT_TRUE(modbus_pool_usable(&pool, 1, now));
+    EXPECT_TRUE(modbus_pool_fail(&pool, 1, now));
+    EXPECT_FALSE(modbus_pool_usable(&pool, 1, now));
+    EXPECT_EQ(2 * MODBUS_POOL_BACKOFF_MIN_MS, pool.conns[1].backoff);
+
+    now += 2 * MODBUS_POOL_BACKOFF_MIN_MS;
+    EXPECT_TRUE(modbus_pool_usable(&pool, 1, now));
+    EXPECT_TRUE(modbus_pool_ok(&pool, 1));
+    EXPECT_EQ(0, pool.conns[1].failures);
+    EXPECT_EQ(0, pool.conns[1].backoff);
+    EXPECT_FALSE(modbus_pool_ok(&pool, 1));
+    EXPECT_EQ(3, modbus_pool_n_usable(&pool, now));
+}
+
+TEST(modbus_pool, backoff_should_be_capped)
+{
+    modbus_pool_t pool;
+    int64_t       now = 0;
+
+    modbus_pool_init(&pool, 2);
+    for (int n = 0; n < 64; n++) {
+        modbus_pool_fail(&pool, 1, now);
+        now = pool.conns[1].retry_tms;
+    }
+    EXPECT_EQ(MODBUS_POOL_BACKOFF_MAX_MS, pool.conns[1].backoff);
+}
+
+TEST(modbus_pool, primary_connection_should_stay_in_rotation)
+{
+    modbus_pool_t pool;
+
+    modbus_pool_init(&pool, 2);
+    for (int n = 0; n < 2 * MODBUS_POOL_FAILURES; n++) {
+        EXPECT_FALSE(modbus_pool_fail(&pool, 0, 0));
+    }
+    EXPECT_TRUE(modbus_pool_usable(&pool, 0, 0));
+    EXPECT_EQ(0, pool.conns[0].backoff);
+    EXPECT_FALSE(modbus_pool_ok(&pool, 0));
+}
+
+TEST(modbus_pool, read_should_not_wait_for_a_silent_slot)
+{
+    modbus_pool_t    pool;
+    pool_peer        peer = {};
+    modbus_pool_io_t io   = peer_io(&peer);
+    int64_t          start = 0;
+
+    modbus_pool_init(&pool, 2);
+    for (int s = 0; s < 2; s++) {
+        ASSERT_EQ(0, socketpair(AF_UNIX, SOCK_STREAM, 0, peer.fds[s]));
+    }
+    peer.mute[1] = true;
+
+    // slot 0 keeps reading while slot 1 waits for its timeout, which then
+    // sends its command again on slot 0
+    start = neu_time_ms();
+    EXPECT_EQ(0, modbus_pool_read(&pool, 16, 1, 200, &io));
+    EXPECT_LT(neu_time_ms() - start, 400);
+
+    EXPECT_EQ(16, peer.done);
+    EXPECT_EQ(16, peer.done_ok);
+    EXPECT_EQ(16, peer.sent[0]);
+    EXPECT_EQ(1, peer.sent[1]);
+    EXPECT_EQ(0, peer.fails[0]);
+    EXPECT_EQ(1, peer.fails[1]);
+    for (int i = 0; i < 16; i++) {
+        EXPECT_EQ(0, peer.done_slot[i]);
+        EXPECT_EQ(-1, pool.conns[i % 2].cmd);
+    }
+
+    for (int s = 0; s < 2; s++) {
+        close(peer.fds[s][0]);
+        close(peer.fds[s][1]);
+    }
+}
+
+TEST(modbus_pool, read_should_give_up_after_max_retries)
+{
+    modbus_pool_t    pool;
+    pool_peer        peer = {};
+    modbus_pool_io_t io   = peer_io(&peer);
+
+    modbus_pool_init(&pool, 1);
+    peer.send_fail = true;
+
+    EXPECT_EQ(0, modbus_pool_read(&pool, 4, 2, 200, &io));
+    EXPECT_EQ(4, peer.done);
+    EXPECT_EQ(0, peer.done_ok);
+    EXPECT_EQ(4 * 3, peer.fails[0]);
+}
@@ -0,0 +1,175 @@
+#include <cstdint>
+#include <cstring>
+#include <gtest/gtest.h>
+#include <neuron.h>
+extern "C" {
+#include "modbus.h"
+#include "modbus_req.h"
+#include "modbus_stack.h"
+}
+
+zlog_category_t *neuron           = NULL;
+int64_t          global_timestamp = 0;
+
+// count heap allocations while `counting` is set
+static bool     counting = false;
+static uint64_t n_alloc  = 0;
+
+extern "C" {
+extern void *__libc_malloc(size_t size);
+extern void *__libc_calloc(size_t n, size_t size);
+extern void *__libc_realloc(void *ptr, size_t size);
+
+void *malloc(size_t size)
+{
+    n_alloc += counting;
+    return __libc_malloc(size);
+}
+
+void *calloc(size_t n, size_t size)
+{
+    n_alloc += counting;
+    return __libc_calloc(n, size);
+}
+
+void *realloc(void *ptr, size_t size)
+{
+    n_alloc += counting;
+    return __libc_realloc(ptr, size);
+}
+
+int modbus_value_handle_test(neu_plugin_t *plugin, void *req,
+                             modbus_point_t *point, uint16_t n_byte,
+                             uint8_t *bytes)
+{
+    (void) plugin;
+    (void) req;
+    (void) point;
+    (void) n_byte;
+    (void) bytes;
+    return 0;
+}
+}
+
+// loopback holding the response a device would give to the last request
+static uint8_t  wire[MODBUS_MAX_ADU] = { 0 };
+static uint16_t wire_len             = 0;
+static uint64_t n_value              = 0;
+
+static int device_send(void *ctx, uint16_t n_byte, uint8_t *bytes)
+{
+    struct modbus_header * req_header = (struct modbus_header *) bytes;
+    struct modbus_code *   req_code   = (struct modbus_code *) (req_header + 1);
+    struct modbus_address *address =
+        (struct modbus_address *) (req_code + 1);
+    struct modbus_header * header     = (struct modbus_header *) wire;
+    struct modbus_code *   code       = (struct modbus_code *) (header + 1);
+    struct modbus_data *   data       = (struct modbus_data *) (code + 1);
+    uint16_t               n_reg      = ntohs(address->n_reg);
+
+    (void) ctx;
+
+    header->seq      = req_header->seq;
+    header->protocol = 0;
+    header->len      = htons(sizeof(*code) + sizeof(*data) + n_reg * 2);
+    *code            = *req_code;
+    data->n_byte     = n_reg * 2;
+    for (uint16_t i = 0; i < n_reg; i++) {
+        data->byte[i * 2]     = 0;
+        data->byte[i * 2 + 1] = i;
+    }
+    wire_len = sizeof(*header) + ntohs(header->len);
+
+    return n_byte;
+}
+
+static int device_value(void *ctx, uint8_t slave_id, uint16_t n_byte,
+                        uint8_t *bytes, int error, void *trace)
+{
+    (void) ctx;
+    (void) slave_id;
+    (void) bytes;
+    (void) trace;
+
+    if (error == 0 && n_byte > 0) {
+        n_value += 1;
+    }
+    return 0;
+}
+
+// one request/response round trip the way modbus_group_timer does it
+static int poll_once(modbus_stack_t *stack, uint16_t n_reg)
+{
+    neu_protocol_unpack_buf_t pbuf          = { 0 };
+    uint16_t                  response_size = 0;
+    uint8_t *                 recv_buf      = NULL;
+    int                       ret           = 0;
+
+    if (modbus_stack_read(stack, 1, MODBUS_AREA_HOLD_REGISTER, 0, n_reg,
+                          &response_size, false) <= 0) {
+        return -1;
+    }
+
+    recv_buf = modbus_stack_recv_buf_get(stack, response_size);
+    memcpy(recv_buf, wire, wire_len);
+    neu_protocol_unpack_buf_init(&pbuf, recv_buf, wire_len);
+    ret = modbus_stack_recv(stack, 1, &pbuf);
+    modbus_stack_recv_buf_put(stack, recv_buf);
+
+    return ret;
+}
+
+TEST(test_modbus_stack, poll_cycle_should_not_allocate)
+{
+    neu_plugin_t    plugin = {};
+    modbus_stack_t *stack  = modbus_stack_create(
+        &plugin, MODBUS_PROTOCOL_TCP, device_send, device_value, NULL);
+
+    // warm up thread local pack buffers
+    EXPECT_GT(poll_once(stack, 125), 0);
+
+    n_alloc  = 0;
+    n_value  = 0;
+    counting = true;
+    for (int i = 0; i < 1000; i++) {
+        poll_once(stack, 1 + i % 125);
+    }
+    counting = false;
+
+    EXPECT_EQ(1000, n_value);
+    EXPECT_EQ(0, n_alloc);
+
+    modbus_stack_destroy(stack);
+}
+
+TEST(test_buf_pool, should_reuse_buffers)
+{
+    neu_buf_pool_t *pool = neu_buf_pool_new(2, 16);
+    uint8_t *       b1   = neu_buf_pool_get(pool, 16);
+    uint8_t *       b2   = neu_buf_pool_get(pool, 8);
+    uint8_t *       b3   = NULL;
+
+    EXPECT_NE(b1, b2);
+
+    // exhausted and oversized requests fall back to the heap
+    n_alloc  = 0;
+    counting = true;
+    b3       = neu_buf_pool_get(pool, 16);
+    neu_buf_pool_put(pool, b3);
+    b3 = neu_buf_pool_get(pool, 64);
+    neu_buf_pool_put(pool, b3);
+    counting = false;
+    EXPECT_EQ(2, n_alloc);
+
+    neu_buf_pool_put(pool, b1);
+    n_alloc  = 0;
+    counting = true;
+    b3       = neu_buf_pool_get(pool, 16);
+    counting = false;
+    EXPECT_EQ(b1, b3);
+    EXPECT_EQ(0, n_alloc);
+
+    neu_buf_pool_put(pool, b2);
+    neu_buf_pool_put(pool, b3);
+    neu_buf_pool_free(pool);
+}
@@ -0,0 +1,162 @@
+#include <arpa/inet.h>
+#include <cstring>
+
+#include <gtest/gtest.h>
+
+extern "C" {
+#include "mqtt/file_transfer.h"
+}
+
+static neu_resp_fup_data_t chunk(uint32_t seq, uint16_t len, bool more)
+{
+    neu_resp_fup_data_t data = { 0 };
+
+    data.seq  = seq;
+    data.len  = len;
+    data.more = more;
+    return data;
+}
+
+TEST(test_mqtt_file_transfer, window_should_bound_outstanding_requests)
+{
+    mqtt_fup_t *       tbl    = NULL;
+    neu_req_fup_data_t cmd    = { 0 };
+    int64_t            offset = 0;
+
+    mqtt_fup_t *fup =
+        mqtt_fup_add(&tbl, "u1", "driver", "/a.bin", 3, 100, false);
+    ASSERT_NE(nullptr, fup);
+    EXPECT_EQ(nullptr, mqtt_fup_add(&tbl, "u1", "driver", "/a.bin", 3, 0, 0));
+    EXPECT_EQ(fup, mqtt_fup_find(&tbl, "u1"));
+
+    // nothing is asked before the driver opens the file
+    EXPECT_EQ(-1, mqtt_fup_next(fup, &cmd));
+    mqtt_fup_open(fup, 0);
+
+    for (uint32_t i = 1; i <= 3; i++) {
+        ASSERT_EQ(0, mqtt_fup_next(fup, &cmd));
+        EXPECT_EQ(i, cmd.seq);
+        EXPECT_STREQ("driver", cmd.driver);
+        EXPECT_STREQ("/a.bin", cmd.path);
+        // only the first request seeks to the resume offset
+        EXPECT_EQ(1 == i ? 100 : 0, cmd.offset);
+    }
+    EXPECT_EQ(-1, mqtt_fup_next(fup, &cmd));
+
+    neu_resp_fup_data_t data = chunk(1, 10, true);
+    ASSERT_EQ(0, mqtt_fup_recv(fup, &data, &offset));
+    EXPECT_EQ(100, offset);
+    ASSERT_EQ(0, mqtt_fup_next(fup, &cmd));
+    EXPECT_EQ(4u, cmd.seq);
+
+    data = chunk(2, 5, false);
+    ASSERT_EQ(0, mqtt_fup_recv(fup, &data, &offset));
+    EXPECT_EQ(110, offset);
+    EXPECT_FALSE(mqtt_fup_done(fup));
+    // the end is known, no more requests
+    EXPECT_EQ(-1, mqtt_fup_next(fup, &cmd));
+
+    // requests past the end are dropped
+    data = chunk(3, 0, false);
+    EXPECT_EQ(-1, mqtt_fup_recv(fup, &data, &offset));
+    data = chunk(4, 0, false);
+    EXPECT_EQ(-1, mqtt_fup_recv(fup, &data, &offset));
+    EXPECT_TRUE(mqtt_fup_done(fup));
+    EXPECT_EQ(15u, fup->n_byte);
+    EXPECT_EQ(1500u, mqtt_fup_rate(fup, 10));
+
+    mqtt_fup_free(&tbl);
+    EXPECT_EQ(nullptr, tbl);
+}
+
+TEST(test_mqtt_file_transfer, error_should_end_transfer)
+{
+    mqtt_fup_t *       tbl    = NULL;
+    neu_req_fup_data_t cmd    = { 0 };
+    int64_t            offset = 0;
+    mqtt_fup_t *fup = mqtt_fup_add(&tbl, "u2", "driver", "/b", 2, 0, false);
+
+    mqtt_fup_open(fup, 0);
+    ASSERT_EQ(0, mqtt_fup_next(fup, &cmd));
+    ASSERT_EQ(0, mqtt_fup_next(fup, &cmd));
+
+    neu_resp_fup_data_t data = chunk(1, 0, false);
+    data.error               = 1;
+    ASSERT_EQ(0, mqtt_fup_recv(fup, &data, &offset));
+    EXPECT_EQ(0, offset);
+    EXPECT_EQ(-1, mqtt_fup_next(fup, &cmd));
+    EXPECT_FALSE(mqtt_fup_done(fup));
+
+    data = chunk(2, 8, true);
+    EXPECT_EQ(-1, mqtt_fup_recv(fup, &data, &offset));
+    EXPECT_TRUE(mqtt_fup_done(fup));
+    EXPECT_EQ(0u, fup->n_byte);
+
+    mqtt_fup_del(&tbl, fup);
+    EXPECT_EQ(nullptr, tbl);
+}
+
+TEST(test_mqtt_file_transfer, frame_should_carry_metadata)
+{
+    mqtt_fup_t *tbl     = NULL;
+    uint8_t     bytes[] = { 0xde, 0xad, 0xbe, 0xef };
+    size_t      len     = 0;
+    uint32_t    v       = 0;
+    mqtt_fup_t *fup = mqtt_fup_add(&tbl, "uuid", "driver", "/c", 1, 0, true);
+
+    neu_resp_fup_data_t data = chunk(7, sizeof(bytes), true);
+    data.data                = bytes;
+
+    uint8_t *frame = mqtt_fup_frame(fup, &data, 0x100000002LL, &len);
+    ASSERT_NE(nullptr, frame);
+    ASSERT_EQ(MQTT_FUP_FRAME_HEADER_LEN + 4 + sizeof(bytes), len);
+    EXPECT_EQ(0, memcmp(frame, MQTT_FUP_FRAME_MAGIC, 4));
+    EXPECT_EQ(MQTT_FUP_FRAME_VERSION, frame[4]);
+    EXPECT_EQ(MQTT_FUP_FRAME_MORE, frame[5]);
+    EXPECT_EQ(4, frame[6] << 8 | frame[7]);
+    memcpy(&v, &frame[8], 4);
+    EXPECT_EQ(7u, ntohl(v));
+    memcpy(&v, &frame[12], 4);
+    EXPECT_EQ(1u, ntohl(v));
+    memcpy(&v, &frame[16], 4);
+    EXPECT_EQ(2u, ntohl(v));
+    EXPECT_EQ(0, memcmp(&frame[MQTT_FUP_FRAME_HEADER_LEN], "uuid", 4));
+    EXPECT_EQ(0, memcmp(&frame[MQTT_FUP_FRAME_HEADER_LEN + 4], bytes, 4));
+
+    free(frame);
+    mqtt_fup_free(&tbl);
+}
+
+TEST(test_mqtt_file_transfer, out_of_order_chunk_should_end_transfer)
+{
+    mqtt_fup_t *       tbl    = NULL;
+    neu_req_fup_data_t cmd    = { 0 };
+    int64_t            offset = 0;
+    mqtt_fup_t *fup = mqtt_fup_add(&tbl, "u3", "driver", "/c", 3, 0, false);
+
+    mqtt_fup_open(fup, 0);
+    for (int i = 0; i < 3; i++) {
+        ASSERT_EQ(0, mqtt_fup_next(fup, &cmd));
+    }
+
+    neu_resp_fup_data_t data = chunk(1, 10, true);
+    ASSERT_EQ(0, mqtt_fup_recv(fup, &data, &offset));
+
+    // chunk 3 overtakes chunk 2, its offset would be wrong
+    data = chunk(3, 10, true);
+    ASSERT_EQ(0, mqtt_fup_recv(fup, &data, &offset));
+    EXPECT_EQ(2u, data.seq);
+    EXPECT_EQ(NEU_ERR_PLUGIN_PACKET_OUT_OF_ORDER, data.error);
+    EXPECT_FALSE(data.more);
+    EXPECT_EQ(0, data.len);
+    EXPECT_EQ(10, offset);
+    EXPECT_EQ(-1, mqtt_fup_next(fup, &cmd));
+
+    // the late chunk is dropped
+    data = chunk(2, 10, true);
+    EXPECT_EQ(-1, mqtt_fup_recv(fup, &data, &offset));
+    EXPECT_TRUE(mqtt_fup_done(fup));
+    EXPECT_EQ(10u, fup->n_byte);
+
+    mqtt_fup_free(&tbl);
+}
@@ -0,0 +1,77 @@
+#include <set>
+#include <string>
+
+#include <gtest/gtest.h>
+
+extern "C" {
+#include "mqtt/mqtt_plugin.h"
+}
+
+zlog_category_t *neuron = NULL;
+
+// the clients are only compared, never dereferenced
+static neu_mqtt_client_t *fake_client(uintptr_t i)
+{
+    return (neu_mqtt_client_t *) (0x1000 + i * 0x10);
+}
+
+static void set_connections(neu_plugin_t *plugin, size_t n)
+{
+    plugin->client       = fake_client(0);
+    plugin->n_pub_client = n - 1;
+    for (size_t i = 1; i < n; i++) {
+        plugin->pub_clients[i - 1] = fake_client(i);
+    }
+}
+
+TEST(test_mqtt_route, single_connection_should_publish_on_primary)
+{
+    neu_plugin_t plugin = {};
+
+    set_connections(&plugin, 1);
+    EXPECT_EQ(fake_client(0), mqtt_plugin_client_of(&plugin, "/neuron/a"));
+    EXPECT_EQ(fake_client(0), mqtt_plugin_client_of(&plugin, "/neuron/b"));
+}
+
+TEST(test_mqtt_route, connection_index_should_map_to_client)
+{
+    neu_plugin_t plugin = {};
+
+    set_connections(&plugin, MQTT_CONNECTIONS_MAX);
+    for (size_t i = 0; i < MQTT_CONNECTIONS_MAX; i++) {
+        EXPECT_EQ(fake_client(i), mqtt_plugin_client_at(&plugin, i));
+    }
+}
+
+TEST(test_mqtt_route, same_topic_should_stay_on_one_connection)
+{
+    neu_plugin_t plugin = {};
+
+    set_connections(&plugin, 4);
+    for (int i = 0; i < 64; i++) {
+        std::string        topic = "/neuron/upload/" + std::to_string(i);
+        neu_mqtt_client_t *client =
+            mqtt_plugin_client_of(&plugin, topic.c_str());
+
+        for (int k = 0; k < 8; k++) {
+            EXPECT_EQ(client, mqtt_plugin_client_of(&plugin, topic.c_str()));
+        }
+    }
+}
+
+TEST(test_mqtt_route, topics_should_spread_across_connections)
+{
+    neu_plugin_t                  plugin = {};
+    std::set<neu_mqtt_client_t *> used;
+
+    set_connections(&plugin, 4);
+    for (int i = 0; i < 256; i++) {
+        std::string topic = "/neuron/upload/" + std::to_string(i);
+        used.insert(mqtt_plugin_client_of(&plugin, topic.c_str()));
+    }
+
+    EXPECT_EQ(4u, used.size());
+    for (size_t i = 0; i < 4; i++) {
+        EXPECT_EQ(1u, used.count(fake_client(i)));
+    }
+}
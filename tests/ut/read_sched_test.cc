@@ -0,0 +1,137 @@
+#include <gtest/gtest.h>
+
+extern "C" {
+#include "adapter/driver/schedule.h"
+}
+
+TEST(read_sched, groups_should_be_staggered_over_interval)
+{
+    neu_read_sched_t *sched    = neu_read_sched_new(NEU_READ_OVERRUN_SKIP);
+    neu_read_slot_t * slots[4] = { 0 };
+    int64_t           delay    = 0;
+    int64_t           release[4];
+
+    // added back to back, as on node start
+    for (int i = 0; i < 4; i++) {
+        slots[i] = neu_read_sched_add(sched, 1000, 10000, &delay);
+        EXPECT_GT(delay, 0);
+        EXPECT_LE(delay, 1000);
+    }
+
+    // one quick cycle each, the earlier groups move to their new phases
+    for (int round = 0; round < 2; round++) {
+        for (int i = 0; i < 4; i++) {
+            int64_t now = 10000 + round * 1000;
+            int64_t end = now + 1000 + 5;
+
+            release[i] = end + neu_read_sched_done(sched, slots[i], now, end,
+                                                   NULL);
+        }
+    }
+    for (int i = 0; i < 4; i++) {
+        EXPECT_EQ(i * 250, release[i] % 1000);
+    }
+
+    neu_read_slot_t *other = neu_read_sched_add(sched, 500, 0, &delay);
+    neu_read_sched_del(sched, slots[3]);
+    neu_read_sched_del(sched, other);
+
+    neu_read_sched_free(sched);
+}
+
+TEST(read_sched, rephase_should_keep_half_interval)
+{
+    neu_read_sched_t *sched = neu_read_sched_new(NEU_READ_OVERRUN_SKIP);
+    int64_t           delay = 0;
+    neu_read_slot_t * b     = neu_read_sched_add(sched, 1000, 0, &delay);
+    neu_read_slot_t * a     = neu_read_sched_add(sched, 1000, 0, &delay);
+
+    EXPECT_EQ(500, delay);
+
+    // a moves from phase 500 to 333
+    EXPECT_EQ(500, neu_read_sched_phase(sched, a));
+    neu_read_slot_t *c = neu_read_sched_add(sched, 1000, 0, &delay);
+    EXPECT_EQ(666, delay);
+    EXPECT_EQ(333, neu_read_sched_phase(sched, a));
+    EXPECT_EQ(823, neu_read_sched_done(sched, a, 500, 510, NULL));
+
+    // and back to 500, not at 1500 right after the read at 1333
+    neu_read_sched_del(sched, c);
+    EXPECT_EQ(500, neu_read_sched_phase(sched, a));
+    EXPECT_EQ(1157, neu_read_sched_done(sched, a, 1333, 1343, NULL));
+
+    neu_read_sched_del(sched, b);
+    neu_read_sched_free(sched);
+}
+
+TEST(read_sched, skip_should_drop_missed_releases)
+{
+    neu_read_sched_t *     sched = neu_read_sched_new(NEU_READ_OVERRUN_SKIP);
+    neu_read_sched_stats_t delta = { 0 };
+    neu_read_sched_stats_t stats = { 0 };
+    int64_t                delay = 0;
+    neu_read_slot_t *      slot  = neu_read_sched_add(sched, 100, 0, &delay);
+
+    // released at 100, deadline at 200, ends at 350
+    EXPECT_EQ(50, neu_read_sched_done(sched, slot, 100, 350, &delta));
+    EXPECT_EQ(1u, delta.misses);
+    EXPECT_EQ(150u, delta.overrun_ms);
+    EXPECT_EQ(2u, delta.skipped);
+
+    // back in phase
+    EXPECT_EQ(90, neu_read_sched_done(sched, slot, 400, 410, &delta));
+    EXPECT_EQ(0u, delta.misses);
+    EXPECT_EQ(0, delta.lateness);
+
+    neu_read_sched_stats(sched, slot, &stats);
+    EXPECT_EQ(2u, stats.cycles);
+    EXPECT_EQ(1u, stats.misses);
+    EXPECT_EQ(150u, stats.overrun_ms);
+    EXPECT_EQ(2u, stats.skipped);
+
+    neu_read_sched_free(sched);
+}
+
+TEST(read_sched, catchup_should_be_bounded)
+{
+    neu_read_sched_t *     sched = neu_read_sched_new(NEU_READ_OVERRUN_CATCHUP);
+    neu_read_sched_stats_t delta = { 0 };
+    int64_t                delay = 0;
+    int64_t                now   = 100;
+    neu_read_slot_t *      slot  = neu_read_sched_add(sched, 100, 0, &delay);
+
+    // every cycle takes 150 ms, the missed releases run right away
+    for (int i = 0; i < NEU_READ_SCHED_CATCHUP_MAX; i++) {
+        EXPECT_EQ(1, neu_read_sched_done(sched, slot, now, now + 150, &delta));
+        EXPECT_EQ(0u, delta.skipped);
+        EXPECT_EQ(i * 50, delta.lateness);
+        now += 150;
+    }
+
+    // then it gives up and skips to the next release in phase
+    EXPECT_EQ(30, neu_read_sched_done(sched, slot, now, now + 120, &delta));
+    EXPECT_EQ(1u, delta.misses);
+    EXPECT_EQ(2u, delta.skipped);
+
+    neu_read_sched_free(sched);
+}
+
+TEST(read_sched, stretch_should_restart_then_return_to_phase)
+{
+    neu_read_sched_t *     sched = neu_read_sched_new(NEU_READ_OVERRUN_STRETCH);
+    neu_read_sched_stats_t delta = { 0 };
+    int64_t                delay = 0;
+    neu_read_slot_t *      slot  = neu_read_sched_add(sched, 100, 0, &delay);
+
+    EXPECT_EQ(1, neu_read_sched_done(sched, slot, 100, 230, &delta));
+    EXPECT_EQ(1u, delta.misses);
+    EXPECT_EQ(30u, delta.overrun_ms);
+    EXPECT_EQ(0u, delta.skipped);
+
+    // the stretched cycle is on time, the next one is back at phase 0
+    EXPECT_EQ(70, neu_read_sched_done(sched, slot, 230, 330, &delta));
+    EXPECT_EQ(0u, delta.misses);
+    EXPECT_EQ(0, delta.lateness);
+
+    neu_read_sched_free(sched);
+}
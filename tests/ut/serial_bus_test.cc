@@ -0,0 +1,104 @@
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+extern "C" {
+#include "connection/serial_bus.h"
+#include "utils/log.h"
+#include "utils/time.h"
+}
+
+zlog_category_t *neuron = NULL;
+
+TEST(test_serial_bus, same_device_should_share_bus)
+{
+    neu_serial_bus_t *b1 = neu_serial_bus_get("/dev/ttyS0");
+    neu_serial_bus_t *b2 = neu_serial_bus_get("/dev/ttyS0");
+    neu_serial_bus_t *b3 = neu_serial_bus_get("/dev/ttyS1");
+
+    EXPECT_EQ(b1, b2);
+    EXPECT_NE(b1, b3);
+
+    neu_serial_bus_put(b1);
+    neu_serial_bus_put(b2);
+    neu_serial_bus_put(b3);
+}
+
+TEST(test_serial_bus, waiters_should_be_granted_by_priority_and_deadline)
+{
+    neu_serial_bus_t *       bus = neu_serial_bus_get("/dev/ttyS0");
+    std::vector<int>         order;
+    std::atomic<int>         waiting(0);
+    std::vector<std::thread> threads;
+    int64_t                  now = neu_time_ms();
+
+    ASSERT_EQ(0, neu_serial_bus_acquire(bus, 1, 0));
+
+    // id, priority, deadline
+    int waiters[][3] = {
+        { 0, 1, 0 },
+        { 1, 1, 5000 },
+        { 2, 0, 0 },
+        { 3, 1, 1000 },
+    };
+    for (auto &w : waiters) {
+        threads.emplace_back([&, w]() {
+            int64_t deadline = w[2] > 0 ? now + w[2] : 0;
+
+            waiting++;
+            EXPECT_EQ(0, neu_serial_bus_acquire(bus, w[1], deadline));
+            order.push_back(w[0]);
+            neu_serial_bus_release(bus, 0);
+        });
+        // keep arrival order deterministic
+        while (waiting.load() < (int) threads.size()) {
+            std::this_thread::yield();
+        }
+        neu_msleep(20);
+    }
+
+    neu_serial_bus_release(bus, 0);
+    for (auto &t : threads) {
+        t.join();
+    }
+
+    EXPECT_EQ(std::vector<int>({ 2, 3, 1, 0 }), order);
+    neu_serial_bus_put(bus);
+}
+
+TEST(test_serial_bus, deadline_should_expire_while_waiting)
+{
+    neu_serial_bus_t *bus = neu_serial_bus_get("/dev/ttyS0");
+
+    ASSERT_EQ(0, neu_serial_bus_acquire(bus, 1, 0));
+
+    std::thread t([bus]() {
+        int64_t start = neu_time_ms();
+
+        EXPECT_EQ(-1, neu_serial_bus_acquire(bus, 1, start + 50));
+        EXPECT_GE(neu_time_ms() - start, 45);
+    });
+    t.join();
+
+    neu_serial_bus_release(bus, 0);
+    EXPECT_EQ(0, neu_serial_bus_acquire(bus, 1, neu_time_ms() + 50));
+    neu_serial_bus_release(bus, 0);
+    neu_serial_bus_put(bus);
+}
+
+TEST(test_serial_bus, grant_should_wait_for_inter_frame_gap)
+{
+    neu_serial_bus_t *bus = neu_serial_bus_get("/dev/ttyS0");
+
+    ASSERT_EQ(0, neu_serial_bus_acquire(bus, 1, 0));
+    neu_serial_bus_release(bus, 30000);
+
+    int64_t start = neu_time_us();
+    ASSERT_EQ(0, neu_serial_bus_acquire(bus, 1, 0));
+    EXPECT_GE(neu_time_us() - start, 25000);
+    neu_serial_bus_release(bus, 0);
+
+    neu_serial_bus_put(bus);
+}
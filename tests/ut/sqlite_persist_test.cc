@@ -0,0 +1,145 @@
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+extern "C" {
+#include "persist/sqlite.h"
+#include "utils/log.h"
+}
+
+zlog_category_t *neuron = NULL;
+
+// the schemas are copied next to the test, the database is created there
+#define SCHEMA_DIR "persistence"
+
+class sqlite_persist : public ::testing::Test {
+  protected:
+    void SetUp() override
+    {
+        remove("persistence/sqlite.db");
+        remove("persistence/sqlite.db-wal");
+        remove("persistence/sqlite.db-shm");
+
+        persister = neu_sqlite_persister_create(SCHEMA_DIR);
+        ASSERT_NE(nullptr, persister);
+
+        neu_persist_node_info_t  node  = {};
+        neu_persist_group_info_t group = {};
+
+        node.name        = (char *) "modbus";
+        node.type        = 1;
+        node.state       = 1;
+        node.plugin_name = (char *) "Modbus TCP";
+        ASSERT_EQ(0, neu_sqlite_persister_store_node(persister, &node));
+
+        group.name     = (char *) "grp";
+        group.interval = 1000;
+        ASSERT_EQ(0,
+                  neu_sqlite_persister_store_group(persister, "modbus", &group,
+                                                   NULL));
+    }
+
+    void TearDown() override { neu_sqlite_persister_destroy(persister); }
+
+    size_t n_tags()
+    {
+        UT_array *tags = NULL;
+        size_t    n    = 0;
+
+        EXPECT_EQ(0,
+                  neu_sqlite_persister_load_tags(persister, "modbus", "grp",
+                                                 &tags));
+        if (tags != NULL) {
+            n = utarray_len(tags);
+            utarray_free(tags);
+        }
+        return n;
+    }
+
+    int node_state()
+    {
+        sqlite3 *     db    = (sqlite3 *) neu_sqlite_persister_native_handle(
+            persister);
+        sqlite3_stmt *stmt  = NULL;
+        int           state = -1;
+
+        sqlite3_prepare_v2(db, "SELECT state FROM nodes WHERE name='modbus'",
+                           -1, &stmt, NULL);
+        if (SQLITE_ROW == sqlite3_step(stmt)) {
+            state = sqlite3_column_int(stmt, 0);
+        }
+        sqlite3_finalize(stmt);
+        return state;
+    }
+
+    neu_persister_t *persister = NULL;
+};
+
+static std::vector<neu_datatag_t> make_tags(size_t                    n,
+                                            std::vector<std::string> &names)
+{
+    std::vector<neu_datatag_t> tags(n);
+
+    names.resize(n);
+    for (size_t i = 0; i < n; i++) {
+        names[i]            = "tag" + std::to_string(i);
+        tags[i]             = {};
+        tags[i].name        = (char *) names[i].c_str();
+        tags[i].address     = (char *) "1!400001";
+        tags[i].attribute   = NEU_ATTRIBUTE_READ;
+        tags[i].type        = NEU_TYPE_INT16;
+        tags[i].description = (char *) "";
+    }
+    return tags;
+}
+
+TEST_F(sqlite_persist, queued_commands_should_apply_in_order_on_flush)
+{
+    // node states are written behind
+    for (int state = 2; state <= 4; state++) {
+        EXPECT_EQ(0,
+                  neu_sqlite_persister_update_node_state(persister, "modbus",
+                                                         state));
+    }
+
+    EXPECT_EQ(0, neu_sqlite_persister_flush(persister));
+    EXPECT_EQ(4, node_state());
+}
+
+TEST_F(sqlite_persist, large_store_should_flush_in_batches)
+{
+    std::vector<std::string>   names;
+    std::vector<neu_datatag_t> tags = make_tags(10000, names);
+
+    EXPECT_EQ(0,
+              neu_sqlite_persister_store_tags(persister, "modbus", "grp",
+                                              tags.data(), tags.size()));
+    EXPECT_EQ(tags.size(), n_tags());
+}
+
+TEST_F(sqlite_persist, failed_multi_tag_store_should_write_nothing)
+{
+    std::vector<std::string>   names;
+    std::vector<neu_datatag_t> tags = make_tags(3, names);
+
+    // queued in the same batch as the failing store below
+    EXPECT_EQ(0,
+              neu_sqlite_persister_update_node_state(persister, "modbus", 2));
+
+    // out of the bias range of the schema, after two good tags
+    tags[2].bias = 5000;
+    EXPECT_NE(0,
+              neu_sqlite_persister_store_tags(persister, "modbus", "grp",
+                                              tags.data(), tags.size()));
+    EXPECT_EQ(0u, n_tags());
+    EXPECT_EQ(2, node_state());
+
+    // the same request goes through once fixed
+    tags[2].bias = 0;
+    EXPECT_EQ(0,
+              neu_sqlite_persister_store_tags(persister, "modbus", "grp",
+                                              tags.data(), tags.size()));
+    EXPECT_EQ(3u, n_tags());
+}
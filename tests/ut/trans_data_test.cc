@@ -0,0 +1,148 @@
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+extern "C" {
+#include "msg.h"
+#include "utils/log.h"
+}
+
+zlog_category_t *neuron = NULL;
+
+static std::atomic<int> n_encode(0);
+
+static int encode(neu_reqresp_trans_data_t *data, void *arg, char **bytes)
+{
+    n_encode++;
+    *bytes = strdup((std::string(data->group) + "/" + (const char *) arg)
+                        .c_str());
+    return 0;
+}
+
+static neu_reqresp_trans_data_t *new_trans_data(uint16_t n_app)
+{
+    neu_reqresp_trans_data_t *data =
+        (neu_reqresp_trans_data_t *) calloc(1, sizeof(*data));
+
+    data->driver     = strdup("driver");
+    data->group      = strdup("group");
+    data->ctx        = (neu_reqresp_trans_data_ctx_t *) calloc(
+        1, sizeof(neu_reqresp_trans_data_ctx_t));
+    data->ctx->index = n_app;
+    pthread_mutex_init(&data->ctx->mtx, NULL);
+    utarray_new(data->tags, neu_resp_tag_value_meta_icd());
+
+    return data;
+}
+
+TEST(test_trans_data, apps_with_the_same_key_should_share_one_encoding)
+{
+    const int                 n_app = 8;
+    neu_reqresp_trans_data_t *data  = new_trans_data(n_app);
+    std::vector<std::thread>  apps;
+
+    n_encode = 0;
+    for (int i = 0; i < n_app; i++) {
+        apps.emplace_back([data, i]() {
+            // every app holds its own copy, like a message does
+            neu_reqresp_trans_data_t copy  = *data;
+            const char *             key   = i % 2 == 0 ? "even" : "odd";
+            const char *             bytes = NULL;
+
+            EXPECT_EQ(0,
+                      neu_trans_data_encode(&copy, key, encode, (void *) key,
+                                            &bytes));
+            EXPECT_EQ(std::string("group/") + key, bytes);
+            neu_trans_data_free(&copy);
+        });
+    }
+    for (auto &t : apps) {
+        t.join();
+    }
+
+    EXPECT_EQ(2, n_encode.load());
+    free(data);
+}
+
+static int encode_fail(neu_reqresp_trans_data_t *data, void *arg, char **bytes)
+{
+    (void) data;
+    (void) arg;
+    n_encode++;
+    *bytes = NULL;
+    return NEU_ERR_EINTERNAL;
+}
+
+TEST(test_trans_data, failed_encoding_should_be_shared_too)
+{
+    neu_reqresp_trans_data_t *data  = new_trans_data(2);
+    const char *              bytes = "";
+
+    n_encode = 0;
+    EXPECT_EQ(NEU_ERR_EINTERNAL,
+              neu_trans_data_encode(data, "key", encode_fail, NULL, &bytes));
+    EXPECT_EQ(NULL, bytes);
+    EXPECT_EQ(NEU_ERR_EINTERNAL,
+              neu_trans_data_encode(data, "key", encode_fail, NULL, &bytes));
+    EXPECT_EQ(1, n_encode.load());
+
+    neu_trans_data_free(data);
+    neu_trans_data_free(data);
+    free(data);
+}
+
+static std::atomic<bool> started(false);
+static std::atomic<bool> release(false);
+
+static int encode_slow(neu_reqresp_trans_data_t *data, void *arg, char **bytes)
+{
+    started = true;
+    while (!release) {
+        std::this_thread::yield();
+    }
+    return encode(data, arg, bytes);
+}
+
+TEST(test_trans_data, same_key_should_wait_other_keys_should_not)
+{
+    neu_reqresp_trans_data_t *data = new_trans_data(3);
+    std::atomic<int>          n_done(0);
+
+    n_encode = 0;
+    started  = false;
+    release  = false;
+
+    auto app = [data, &n_done](const char *key, neu_trans_data_encode_fn fn) {
+        const char *bytes = NULL;
+
+        EXPECT_EQ(0, neu_trans_data_encode(data, key, fn, (void *) key, &bytes));
+        EXPECT_EQ(std::string("group/") + key, bytes);
+        n_done++;
+    };
+
+    std::thread first(app, "slow", encode_slow);
+    while (!started) {
+        std::this_thread::yield();
+    }
+
+    // the second app on the key waits, an app on another key goes through
+    std::thread second(app, "slow", encode_slow);
+    std::thread other(app, "fast", encode);
+    other.join();
+    EXPECT_EQ(1, n_done.load());
+    EXPECT_EQ(1, n_encode.load());
+
+    release = true;
+    first.join();
+    second.join();
+    EXPECT_EQ(3, n_done.load());
+    EXPECT_EQ(2, n_encode.load());
+
+    neu_trans_data_free(data);
+    neu_trans_data_free(data);
+    neu_trans_data_free(data);
+    free(data);
+}